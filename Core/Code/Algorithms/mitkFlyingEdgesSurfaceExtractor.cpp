@@ -0,0 +1,596 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkFlyingEdgesSurfaceExtractor.h"
+
+#include <mitkLogMacros.h>
+
+#include <vtkCellArray.h>
+#include <vtkDataArray.h>
+#include <vtkIdTypeArray.h>
+#include <vtkImageData.h>
+#include <vtkMarchingCubesTriangleCases.h>
+#include <vtkPointData.h>
+#include <vtkPoints.h>
+
+#include <itkMultiThreader.h>
+
+#include <algorithm>
+#include <vector>
+
+namespace
+{
+
+// corners of a cell in the order of the vtkMarchingCubes case table
+const int CellCorners[8][3] = { {0,0,0}, {1,0,0}, {1,1,0}, {0,1,0}, {0,0,1}, {1,0,1}, {1,1,1}, {0,1,1} };
+
+// edges of a cell as used by the case table, the first corner always has the lower index
+const int CellEdges[12][2] = { {0,1}, {1,2}, {3,2}, {0,3}, {4,5}, {5,6}, {7,6}, {4,7}, {0,4}, {1,5}, {3,7}, {2,6} };
+const int EdgeDirections[12] = { 0, 1, 0, 1, 0, 1, 0, 1, 2, 2, 2, 2 };
+
+/// Part of [0,count) that is processed by one thread
+void GetThreadRange( const itk::MultiThreader::ThreadInfoStruct* threadInfo, vtkIdType count, vtkIdType& begin, vtkIdType& end )
+{
+  begin = count * threadInfo->ThreadID / threadInfo->NumberOfThreads;
+  end = count * (threadInfo->ThreadID + 1) / threadInfo->NumberOfThreads;
+}
+
+/// Point ids of one image row, -1 where there is no point
+struct RowPointIds
+{
+  std::vector<vtkIdType> m_Voxel;
+  std::vector<vtkIdType> m_Edge[3];
+
+  void Resize( int size )
+  {
+    m_Voxel.resize( size );
+    for (int direction = 0; direction < 3; ++direction)
+    {
+      m_Edge[direction].resize( size );
+    }
+  }
+};
+
+template < typename TScalar >
+class FlyingEdgesAlgorithm
+{
+  public:
+
+    FlyingEdgesAlgorithm( const TScalar* scalars, int numberOfComponents, const int dimensions[3], const double spacing[3], double threshold )
+      : m_Scalars(scalars),
+        m_NumberOfComponents(numberOfComponents),
+        m_Threshold(threshold),
+        m_Points(NULL),
+        m_Cells(NULL)
+    {
+      for (int d = 0; d < 3; ++d)
+      {
+        m_Dimensions[d] = dimensions[d];
+        m_Spacing[d] = spacing[d];
+      }
+    }
+
+    vtkSmartPointer<vtkPolyData> Execute( int numberOfThreads )
+    {
+      const vtkIdType numberOfRows = static_cast<vtkIdType>(m_Dimensions[1]) * m_Dimensions[2];
+      m_RowPointOffsets.assign( numberOfRows + 1, 0 );
+      m_RowTriangleOffsets.assign( numberOfRows + 1, 0 );
+
+      itk::MultiThreader::Pointer threader = itk::MultiThreader::New();
+      threader->SetNumberOfThreads( std::max( 1, std::min( numberOfThreads, m_Dimensions[2] ) ) );
+
+      // 1. count the points and triangles of every row, stored at the position of the following row
+      threader->SetSingleMethod( CountThread, this );
+      threader->SingleMethodExecute();
+
+      // 2. the first id of every row follows from the counts of all rows before
+      for (vtkIdType row = 0; row < numberOfRows; ++row)
+      {
+        m_RowPointOffsets[row + 1] += m_RowPointOffsets[row];
+        m_RowTriangleOffsets[row + 1] += m_RowTriangleOffsets[row];
+      }
+      const vtkIdType numberOfPoints = m_RowPointOffsets[numberOfRows];
+      const vtkIdType numberOfTriangles = m_RowTriangleOffsets[numberOfRows];
+
+      vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
+      points->SetDataTypeToFloat();
+      points->SetNumberOfPoints( numberOfPoints );
+      m_Points = static_cast<float*>( points->GetVoidPointer(0) );
+
+      vtkSmartPointer<vtkIdTypeArray> cells = vtkSmartPointer<vtkIdTypeArray>::New();
+      cells->SetNumberOfValues( 4 * numberOfTriangles );
+      m_Cells = cells->GetPointer(0);
+
+      // 3. every thread writes its points and triangles to their final positions
+      threader->SetSingleMethod( GenerateThread, this );
+      threader->SingleMethodExecute();
+
+      vtkSmartPointer<vtkCellArray> polys = vtkSmartPointer<vtkCellArray>::New();
+      polys->SetCells( numberOfTriangles, cells );
+
+      vtkSmartPointer<vtkPolyData> polyData = vtkSmartPointer<vtkPolyData>::New();
+      polyData->SetPoints( points );
+      polyData->SetPolys( polys );
+      return polyData;
+    }
+
+  private:
+
+    static ITK_THREAD_RETURN_TYPE CountThread( void* pInfoStruct )
+    {
+      itk::MultiThreader::ThreadInfoStruct* threadInfo = static_cast<itk::MultiThreader::ThreadInfoStruct*>(pInfoStruct);
+      FlyingEdgesAlgorithm* self = static_cast<FlyingEdgesAlgorithm*>(threadInfo->UserData);
+
+      vtkIdType begin, end;
+      GetThreadRange( threadInfo, self->m_Dimensions[2], begin, end );
+      for (int k = static_cast<int>(begin); k < end; ++k)
+      {
+        for (int j = 0; j < self->m_Dimensions[1]; ++j)
+        {
+          const vtkIdType row = self->GetRowIndex(j, k);
+          self->m_RowPointOffsets[row + 1] = self->ProcessRow( j, k, 0, NULL, false );
+          if ( j + 1 < self->m_Dimensions[1] && k + 1 < self->m_Dimensions[2] )
+          {
+            self->m_RowTriangleOffsets[row + 1] = self->ProcessCellRow( j, k, NULL, NULL );
+          }
+        }
+      }
+
+      return ITK_THREAD_RETURN_VALUE;
+    }
+
+    static ITK_THREAD_RETURN_TYPE GenerateThread( void* pInfoStruct )
+    {
+      itk::MultiThreader::ThreadInfoStruct* threadInfo = static_cast<itk::MultiThreader::ThreadInfoStruct*>(pInfoStruct);
+      FlyingEdgesAlgorithm* self = static_cast<FlyingEdgesAlgorithm*>(threadInfo->UserData);
+
+      // rows (j,k), (j+1,k), (j,k+1) and (j+1,k+1) that contain the points of a row of cells
+      RowPointIds rows[4];
+      for (int i = 0; i < 4; ++i)
+      {
+        rows[i].Resize( self->m_Dimensions[0] );
+      }
+
+      vtkIdType begin, end;
+      GetThreadRange( threadInfo, self->m_Dimensions[2], begin, end );
+      for (int k = static_cast<int>(begin); k < end; ++k)
+      {
+        if ( k + 1 == self->m_Dimensions[2] )
+        {
+          // no cells above the last slice, its points are still needed by the cells below
+          for (int j = 0; j < self->m_Dimensions[1]; ++j)
+          {
+            self->ProcessRow( j, k, self->m_RowPointOffsets[self->GetRowIndex(j, k)], NULL, true );
+          }
+          continue;
+        }
+
+        // points of slice k+1 are written by the thread that owns it, here only their ids are needed
+        self->ProcessRow( 0, k, self->m_RowPointOffsets[self->GetRowIndex(0, k)], &rows[0], true );
+        self->ProcessRow( 0, k + 1, self->m_RowPointOffsets[self->GetRowIndex(0, k + 1)], &rows[2], false );
+        for (int j = 0; j + 1 < self->m_Dimensions[1]; ++j)
+        {
+          self->ProcessRow( j + 1, k, self->m_RowPointOffsets[self->GetRowIndex(j + 1, k)], &rows[1], true );
+          self->ProcessRow( j + 1, k + 1, self->m_RowPointOffsets[self->GetRowIndex(j + 1, k + 1)], &rows[3], false );
+
+          self->ProcessCellRow( j, k, rows, self->m_Cells + 4 * self->m_RowTriangleOffsets[self->GetRowIndex(j, k)] );
+
+          std::swap( rows[0], rows[1] );
+          std::swap( rows[2], rows[3] );
+        }
+      }
+
+      return ITK_THREAD_RETURN_VALUE;
+    }
+
+    vtkIdType GetRowIndex( int j, int k ) const
+    {
+      return static_cast<vtkIdType>(k) * m_Dimensions[1] + j;
+    }
+
+    double GetValue( int i, int j, int k ) const
+    {
+      return static_cast<double>( m_Scalars[ (this->GetRowIndex(j, k) * m_Dimensions[0] + i) * m_NumberOfComponents ] );
+    }
+
+    bool HasNeighborBelowThreshold( int i, int j, int k ) const
+    {
+      for (int direction = 0; direction < 3; ++direction)
+      {
+        for (int step = -1; step <= 1; step += 2)
+        {
+          int neighbor[3] = { i, j, k };
+          neighbor[direction] += step;
+          if ( neighbor[direction] >= 0 && neighbor[direction] < m_Dimensions[direction] &&
+               this->GetValue( neighbor[0], neighbor[1], neighbor[2] ) < m_Threshold )
+          {
+            return true;
+          }
+        }
+      }
+      return false;
+    }
+
+    /**
+      Assigns ids to the points of row (j,k), starting with id. A voxel owns the edges to its neighbors
+      in positive x, y and z direction. Points are only written if writePoints is set.
+      \return the id following the last point of the row
+    */
+    vtkIdType ProcessRow( int j, int k, vtkIdType id, RowPointIds* ids, bool writePoints )
+    {
+      for (int i = 0; i < m_Dimensions[0]; ++i)
+      {
+        const double value = this->GetValue(i, j, k);
+
+        vtkIdType voxelId(-1);
+        if ( value == m_Threshold && this->HasNeighborBelowThreshold(i, j, k) )
+        {
+          voxelId = id++;
+          if (writePoints)
+          {
+            float* point = m_Points + 3 * voxelId;
+            point[0] = i * m_Spacing[0];
+            point[1] = j * m_Spacing[1];
+            point[2] = k * m_Spacing[2];
+          }
+        }
+        if (ids)
+        {
+          ids->m_Voxel[i] = voxelId;
+        }
+
+        for (int direction = 0; direction < 3; ++direction)
+        {
+          vtkIdType edgeId(-1);
+          int next[3] = { i, j, k };
+          ++next[direction];
+          if ( next[direction] < m_Dimensions[direction] )
+          {
+            const double nextValue = this->GetValue( next[0], next[1], next[2] );
+            if ( (value >= m_Threshold) != (nextValue >= m_Threshold) && value != m_Threshold && nextValue != m_Threshold )
+            {
+              edgeId = id++;
+              if (writePoints)
+              {
+                // same interpolation as vtkMarchingCubes
+                const double t = (m_Threshold - value) / (nextValue - value);
+                float* point = m_Points + 3 * edgeId;
+                point[0] = i * m_Spacing[0];
+                point[1] = j * m_Spacing[1];
+                point[2] = k * m_Spacing[2];
+                point[direction] += t * m_Spacing[direction];
+              }
+            }
+          }
+          if (ids)
+          {
+            ids->m_Edge[direction][i] = edgeId;
+          }
+        }
+      }
+      return id;
+    }
+
+    /**
+      Creates the triangles of the cells between rows (j,k) and (j+1,k+1) and writes them to cells,
+      if cells is not NULL.
+      \return the number of triangles
+    */
+    vtkIdType ProcessCellRow( int j, int k, const RowPointIds* rows, vtkIdType* cells ) const
+    {
+      vtkMarchingCubesTriangleCases* triangleCases = vtkMarchingCubesTriangleCases::GetCases();
+
+      vtkIdType numberOfTriangles(0);
+      double values[8];
+      for (int i = 0; i + 1 < m_Dimensions[0]; ++i)
+      {
+        int caseIndex(0);
+        for (int corner = 0; corner < 8; ++corner)
+        {
+          values[corner] = this->GetValue( i + CellCorners[corner][0], j + CellCorners[corner][1], k + CellCorners[corner][2] );
+          if ( values[corner] >= m_Threshold )
+          {
+            caseIndex |= 1 << corner;
+          }
+        }
+        if ( caseIndex == 0 || caseIndex == 255 )
+        {
+          continue;
+        }
+
+        for (const int* edge = triangleCases[caseIndex].edges; edge[0] > -1; edge += 3)
+        {
+          int keys[3];
+          for (int p = 0; p < 3; ++p)
+          {
+            keys[p] = this->GetPointKey( values, edge[p] );
+          }
+
+          // like vtkMarchingCubes, skip triangles with two points on the same voxel
+          if ( keys[0] == keys[1] || keys[0] == keys[2] || keys[1] == keys[2] )
+          {
+            continue;
+          }
+
+          if (cells)
+          {
+            *cells++ = 3;
+            for (int p = 0; p < 3; ++p)
+            {
+              *cells++ = this->GetPointId( rows, i, keys[p] );
+            }
+          }
+          ++numberOfTriangles;
+        }
+      }
+      return numberOfTriangles;
+    }
+
+    /// Identifies the point on an edge of a cell: the corner (0-7) if it lies on a voxel, 8 + edge otherwise
+    int GetPointKey( const double values[8], int edge ) const
+    {
+      if ( values[CellEdges[edge][0]] == m_Threshold ) return CellEdges[edge][0];
+      if ( values[CellEdges[edge][1]] == m_Threshold ) return CellEdges[edge][1];
+      return 8 + edge;
+    }
+
+    vtkIdType GetPointId( const RowPointIds* rows, int i, int key ) const
+    {
+      if ( key < 8 )
+      {
+        const int* corner = CellCorners[key];
+        return rows[corner[1] + 2 * corner[2]].m_Voxel[i + corner[0]];
+      }
+
+      const int edge = key - 8;
+      const int* corner = CellCorners[ CellEdges[edge][0] ];
+      return rows[corner[1] + 2 * corner[2]].m_Edge[ EdgeDirections[edge] ][i + corner[0]];
+    }
+
+    const TScalar* m_Scalars;
+    int m_NumberOfComponents;
+    int m_Dimensions[3];
+    double m_Spacing[3];
+    double m_Threshold;
+
+    std::vector<vtkIdType> m_RowPointOffsets;
+    std::vector<vtkIdType> m_RowTriangleOffsets;
+
+    float* m_Points;
+    vtkIdType* m_Cells;
+};
+
+template < typename TScalar >
+vtkSmartPointer<vtkPolyData> ExtractSurfaceTemplate( const TScalar* scalars, int numberOfComponents, const int dimensions[3],
+                                                     const double spacing[3], double threshold, int numberOfThreads )
+{
+  FlyingEdgesAlgorithm<TScalar> algorithm( scalars, numberOfComponents, dimensions, spacing, threshold );
+  return algorithm.Execute( numberOfThreads );
+}
+
+/**
+  Moves all points at the same time, so each thread only reads the old positions and writes its own part of the new ones.
+*/
+class LaplacianSmoother
+{
+  public:
+
+    LaplacianSmoother( vtkIdType numberOfPoints, vtkCellArray* polys )
+      : m_NumberOfPoints(numberOfPoints),
+        m_NeighborOffsets(numberOfPoints + 1, 0),
+        m_NumberOfNeighbors(numberOfPoints, 0),
+        m_Fixed(numberOfPoints, 0),
+        m_RelaxationFactor(0),
+        m_Source(NULL),
+        m_Target(NULL)
+    {
+      // every edge of a polygon adds its points to each other's neighbors
+      vtkIdType numberOfCellPoints;
+      vtkIdType* cellPoints;
+      for (polys->InitTraversal(); polys->GetNextCell(numberOfCellPoints, cellPoints); )
+      {
+        for (vtkIdType p = 0; p < numberOfCellPoints; ++p)
+        {
+          ++m_NeighborOffsets[ cellPoints[p] + 1 ];
+          ++m_NeighborOffsets[ cellPoints[(p + 1) % numberOfCellPoints] + 1 ];
+        }
+      }
+      for (vtkIdType point = 0; point < numberOfPoints; ++point)
+      {
+        m_NeighborOffsets[point + 1] += m_NeighborOffsets[point];
+      }
+
+      m_Neighbors.resize( m_NeighborOffsets[numberOfPoints] );
+      std::vector<vtkIdType> position( m_NeighborOffsets.begin(), m_NeighborOffsets.end() - 1 );
+      for (polys->InitTraversal(); polys->GetNextCell(numberOfCellPoints, cellPoints); )
+      {
+        for (vtkIdType p = 0; p < numberOfCellPoints; ++p)
+        {
+          vtkIdType first = cellPoints[p];
+          vtkIdType second = cellPoints[(p + 1) % numberOfCellPoints];
+          m_Neighbors[ position[first]++ ] = second;
+          m_Neighbors[ position[second]++ ] = first;
+        }
+      }
+    }
+
+    void Smooth( float* points, int numberOfIterations, double relaxationFactor, int numberOfThreads )
+    {
+      itk::MultiThreader::Pointer threader = itk::MultiThreader::New();
+      threader->SetNumberOfThreads( std::max<vtkIdType>( 1, std::min<vtkIdType>( numberOfThreads, m_NumberOfPoints ) ) );
+      threader->SetSingleMethod( PrepareThread, this );
+      threader->SingleMethodExecute();
+
+      std::vector<float> buffer( points, points + 3 * m_NumberOfPoints );
+      m_RelaxationFactor = relaxationFactor;
+      m_Source = points;
+      m_Target = buffer.empty() ? NULL : &buffer[0];
+
+      threader->SetSingleMethod( SmoothThread, this );
+      for (int iteration = 0; iteration < numberOfIterations; ++iteration)
+      {
+        threader->SingleMethodExecute();
+        std::swap( m_Source, m_Target );
+      }
+
+      if ( m_Source != points )
+      {
+        std::copy( buffer.begin(), buffer.end(), points );
+      }
+    }
+
+  private:
+
+    /// Removes duplicate neighbors, points on edges that do not belong to exactly two polygons are fixed
+    static ITK_THREAD_RETURN_TYPE PrepareThread( void* pInfoStruct )
+    {
+      itk::MultiThreader::ThreadInfoStruct* threadInfo = static_cast<itk::MultiThreader::ThreadInfoStruct*>(pInfoStruct);
+      LaplacianSmoother* self = static_cast<LaplacianSmoother*>(threadInfo->UserData);
+
+      vtkIdType begin, end;
+      GetThreadRange( threadInfo, self->m_NumberOfPoints, begin, end );
+      for (vtkIdType point = begin; point < end; ++point)
+      {
+        std::vector<vtkIdType>::iterator first = self->m_Neighbors.begin() + self->m_NeighborOffsets[point];
+        std::vector<vtkIdType>::iterator last = self->m_Neighbors.begin() + self->m_NeighborOffsets[point + 1];
+        std::sort( first, last );
+
+        std::vector<vtkIdType>::iterator unique = first;
+        for (std::vector<vtkIdType>::iterator neighbor = first; neighbor != last; )
+        {
+          std::vector<vtkIdType>::iterator next = std::upper_bound( neighbor, last, *neighbor );
+          if ( next - neighbor != 2 )
+          {
+            self->m_Fixed[point] = 1;
+          }
+          *unique++ = *neighbor;
+          neighbor = next;
+        }
+        self->m_NumberOfNeighbors[point] = unique - first;
+      }
+
+      return ITK_THREAD_RETURN_VALUE;
+    }
+
+    static ITK_THREAD_RETURN_TYPE SmoothThread( void* pInfoStruct )
+    {
+      itk::MultiThreader::ThreadInfoStruct* threadInfo = static_cast<itk::MultiThreader::ThreadInfoStruct*>(pInfoStruct);
+      LaplacianSmoother* self = static_cast<LaplacianSmoother*>(threadInfo->UserData);
+
+      vtkIdType begin, end;
+      GetThreadRange( threadInfo, self->m_NumberOfPoints, begin, end );
+      for (vtkIdType point = begin; point < end; ++point)
+      {
+        const float* source = self->m_Source + 3 * point;
+        float* target = self->m_Target + 3 * point;
+
+        const vtkIdType numberOfNeighbors = self->m_NumberOfNeighbors[point];
+        if ( self->m_Fixed[point] || numberOfNeighbors == 0 )
+        {
+          std::copy( source, source + 3, target );
+          continue;
+        }
+
+        double mean[3] = { 0, 0, 0 };
+        const vtkIdType* neighbor = &self->m_Neighbors[ self->m_NeighborOffsets[point] ];
+        for (vtkIdType n = 0; n < numberOfNeighbors; ++n, ++neighbor)
+        {
+          const float* neighborPoint = self->m_Source + 3 * (*neighbor);
+          mean[0] += neighborPoint[0];
+          mean[1] += neighborPoint[1];
+          mean[2] += neighborPoint[2];
+        }
+
+        for (int d = 0; d < 3; ++d)
+        {
+          target[d] = source[d] + self->m_RelaxationFactor * ( mean[d] / numberOfNeighbors - source[d] );
+        }
+      }
+
+      return ITK_THREAD_RETURN_VALUE;
+    }
+
+    vtkIdType m_NumberOfPoints;
+
+    std::vector<vtkIdType> m_NeighborOffsets;
+    std::vector<vtkIdType> m_Neighbors;
+    std::vector<vtkIdType> m_NumberOfNeighbors;
+    std::vector<char> m_Fixed;
+
+    double m_RelaxationFactor;
+    float* m_Source;
+    float* m_Target;
+};
+
+}
+
+vtkSmartPointer<vtkPolyData> mitk::FlyingEdgesSurfaceExtractor::ExtractSurface( vtkImageData* image, double threshold, int numberOfThreads )
+{
+  int dimensions[3] = { 0, 0, 0 };
+  double spacing[3] = { 1, 1, 1 };
+  vtkDataArray* scalars = NULL;
+  if (image)
+  {
+    image->GetDimensions( dimensions );
+    image->GetSpacing( spacing );
+    scalars = image->GetPointData()->GetScalars();
+  }
+
+  // like vtkMarchingCubes, there is nothing to extract without any cells
+  if ( !scalars || dimensions[0] < 2 || dimensions[1] < 2 || dimensions[2] < 2 )
+  {
+    return vtkSmartPointer<vtkPolyData>::New();
+  }
+
+  vtkSmartPointer<vtkPolyData> polyData;
+  switch ( scalars->GetDataType() )
+  {
+    vtkTemplateMacro(
+      polyData = ExtractSurfaceTemplate( static_cast<VTK_TT*>( scalars->GetVoidPointer(0) ), scalars->GetNumberOfComponents(),
+                                         dimensions, spacing, threshold, numberOfThreads )
+      );
+    default:
+      MITK_ERROR << "Cannot extract a surface from images of scalar type " << scalars->GetDataTypeAsString();
+      polyData = vtkSmartPointer<vtkPolyData>::New();
+  }
+  return polyData;
+}
+
+void mitk::FlyingEdgesSurfaceExtractor::SmoothSurface( vtkPolyData* polyData, int numberOfIterations, double relaxationFactor, int numberOfThreads )
+{
+  if ( !polyData || !polyData->GetPoints() || !polyData->GetPolys() || numberOfIterations < 1 )
+  {
+    return;
+  }
+
+  vtkPoints* points = polyData->GetPoints();
+  if ( points->GetDataType() != VTK_FLOAT )
+  {
+    vtkSmartPointer<vtkPoints> floatPoints = vtkSmartPointer<vtkPoints>::New();
+    floatPoints->SetDataTypeToFloat();
+    floatPoints->SetNumberOfPoints( points->GetNumberOfPoints() );
+    for (vtkIdType point = 0; point < points->GetNumberOfPoints(); ++point)
+    {
+      floatPoints->SetPoint( point, points->GetPoint(point) );
+    }
+    polyData->SetPoints( floatPoints );
+    points = floatPoints;
+  }
+
+  LaplacianSmoother smoother( points->GetNumberOfPoints(), polyData->GetPolys() );
+  smoother.Smooth( static_cast<float*>( points->GetVoidPointer(0) ), numberOfIterations, relaxationFactor, numberOfThreads );
+  points->Modified();
+}
@@ -0,0 +1,71 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#ifndef mitkFlyingEdgesSurfaceExtractor_h_Included
+#define mitkFlyingEdgesSurfaceExtractor_h_Included
+
+#include <MitkExports.h>
+
+#include <vtkSmartPointer.h>
+#include <vtkPolyData.h>
+
+class vtkImageData;
+
+namespace mitk
+{
+
+/**
+  \brief Multithreaded iso-surface extraction and Laplacian smoothing.
+
+  Used by ImageToSurfaceFilter if ImageToSurfaceFilter::ParallelFlyingEdges is selected.
+
+  ExtractSurface() creates the same triangles as vtkMarchingCubes, using the same case table. In the spirit of
+  the flying edges algorithm, the image is processed in slabs of slices in two passes: the first pass counts the
+  points and triangles of every image row, the second one writes them to their final positions, which are known
+  from the counts of all rows before. Points are identified by the voxel edge they are located on, so no point
+  locator is needed and the result does not depend on the number of threads. Points that lie exactly on a voxel
+  (if the voxel value equals the threshold) are shared by all edges of this voxel. The points are at the positions
+  of the vtkMarchingCubes points, but they are numbered in a different order. vtkSmoothPolyDataFilter and the
+  decimation filters depend on this order, so smoothed or decimated surfaces differ from the marching cubes ones.
+
+  SmoothSurface() is a Laplacian smoothing with the parameters of vtkSmoothPolyDataFilter, but it is not equivalent
+  to it. Points on boundary or non-manifold edges are fixed, all others are moved towards the mean of their
+  neighbors. All points are moved at the same time from the positions of the previous iteration (Jacobi style),
+  so the points can be distributed to several threads. vtkSmoothPolyDataFilter moves one point after the other and
+  already uses the new positions of the points before it, so the smoothed surfaces are similar, but not equal.
+  ImageToSurfaceFilter uses vtkSmoothPolyDataFilter unless ImageToSurfaceFilter::SetParallelSmoothing(true) is set.
+*/
+class MITK_CORE_EXPORT FlyingEdgesSurfaceExtractor
+{
+  public:
+
+    /**
+      \brief Extracts the iso-surface of the first scalar component of image at threshold.
+
+      Points are given in index coordinates multiplied by the spacing of the image, i.e. the origin of the image
+      is ignored (like vtkMarchingCubes behind a vtkImageChangeInformation that moves the origin to 0).
+    */
+    static vtkSmartPointer<vtkPolyData> ExtractSurface( vtkImageData* image, double threshold, int numberOfThreads );
+
+    /**
+      \brief Jacobi style Laplacian smoothing of the triangles of polyData, the points are changed in place.
+    */
+    static void SmoothSurface( vtkPolyData* polyData, int numberOfIterations, double relaxationFactor, int numberOfThreads );
+};
+
+} // namespace
+
+#endif
@@ -16,6 +16,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 #include <mitkImageToSurfaceFilter.h>
 #include "mitkException.h"
+#include "mitkFlyingEdgesSurfaceExtractor.h"
 #include <vtkImageData.h>
 #include <vtkDecimatePro.h>
 #include <vtkImageChangeInformation.h>
@@ -36,7 +37,9 @@ mitk::ImageToSurfaceFilter::ImageToSurfaceFilter():
   m_Threshold(1.0),
   m_TargetReduction(0.95f),
   m_SmoothIteration(50),
-  m_SmoothRelaxation(0.1)
+  m_SmoothRelaxation(0.1),
+  m_SurfaceExtraction(MarchingCubes),
+  m_ParallelSmoothing(false)
 {
 }
 
@@ -46,23 +49,38 @@ mitk::ImageToSurfaceFilter::~ImageToSurfaceFilter()
 
 void mitk::ImageToSurfaceFilter::CreateSurface(int time, vtkImageData *vtkimage, mitk::Surface * surface, const ScalarType threshold)
 {
-  vtkImageChangeInformation *indexCoordinatesImageFilter = vtkImageChangeInformation::New();
-  indexCoordinatesImageFilter->SetInput(vtkimage);
-  indexCoordinatesImageFilter->SetOutputOrigin(0.0,0.0,0.0);
-
-  //MarchingCube -->create Surface
-  vtkMarchingCubes *skinExtractor = vtkMarchingCubes::New();
-  skinExtractor->ComputeScalarsOff();
-  skinExtractor->SetInput(indexCoordinatesImageFilter->GetOutput());//RC++
-  indexCoordinatesImageFilter->Delete();
-  skinExtractor->SetValue(0, threshold);
-
   vtkPolyData *polydata;
-  polydata = skinExtractor->GetOutput();
-  polydata->Register(NULL);//RC++
-  skinExtractor->Delete();
 
-  if (m_Smooth)
+  if (m_SurfaceExtraction == ParallelFlyingEdges)
+  {
+    // points are created in index coordinates multiplied by spacing, as with vtkMarchingCubes below
+    vtkSmartPointer<vtkPolyData> extractedSurface = FlyingEdgesSurfaceExtractor::ExtractSurface(vtkimage, threshold, this->GetNumberOfThreads());
+    polydata = extractedSurface;
+    polydata->Register(NULL);//RC++
+  }
+  else
+  {
+    vtkImageChangeInformation *indexCoordinatesImageFilter = vtkImageChangeInformation::New();
+    indexCoordinatesImageFilter->SetInput(vtkimage);
+    indexCoordinatesImageFilter->SetOutputOrigin(0.0,0.0,0.0);
+
+    //MarchingCube -->create Surface
+    vtkMarchingCubes *skinExtractor = vtkMarchingCubes::New();
+    skinExtractor->ComputeScalarsOff();
+    skinExtractor->SetInput(indexCoordinatesImageFilter->GetOutput());//RC++
+    indexCoordinatesImageFilter->Delete();
+    skinExtractor->SetValue(0, threshold);
+
+    polydata = skinExtractor->GetOutput();
+    polydata->Register(NULL);//RC++
+    skinExtractor->Delete();
+  }
+
+  if (m_Smooth && m_SurfaceExtraction == ParallelFlyingEdges && m_ParallelSmoothing)
+  {
+    FlyingEdgesSurfaceExtractor::SmoothSurface(polydata, m_SmoothIteration, m_SmoothRelaxation, this->GetNumberOfThreads());
+  }
+  else if (m_Smooth)
   {
     vtkSmoothPolyDataFilter *smoother = vtkSmoothPolyDataFilter::New();
     //read poly1 (poly1 can be the original polygon, or the decimated polygon)
@@ -61,6 +61,12 @@ namespace mitk {
     */
       enum DecimationType {NoDecimation,DecimatePro,QuadricDecimation};
 
+      /*
+    * Algorithm that creates the surface: the single threaded vtkMarchingCubes or the multithreaded
+    * FlyingEdgesSurfaceExtractor, which creates the same triangles.
+    */
+      enum SurfaceExtractionType {MarchingCubes,ParallelFlyingEdges};
+
       mitkClassMacro(ImageToSurfaceFilter, SurfaceSource);
       itkNewMacro(Self);
 
@@ -165,6 +171,27 @@ namespace mitk {
        */
       itkGetConstMacro(TargetReduction, float);
 
+      /**
+       * Select the algorithm that creates the surface, default is MarchingCubes. ParallelFlyingEdges uses
+       * GetNumberOfThreads() threads for surface extraction. Its points are numbered differently than the
+       * marching cubes points, so smoothing and decimation do not give exactly the marching cubes result.
+       * */
+      itkSetMacro(SurfaceExtraction, SurfaceExtractionType);
+
+      /**
+       * Returns the algorithm that creates the surface
+       */
+      itkGetConstMacro(SurfaceExtraction, SurfaceExtractionType);
+
+      /**
+       * With ParallelFlyingEdges, smooth by FlyingEdgesSurfaceExtractor::SmoothSurface() on GetNumberOfThreads()
+       * threads instead of vtkSmoothPolyDataFilter. Its result is similar, but not equal to the one of
+       * vtkSmoothPolyDataFilter, see FlyingEdgesSurfaceExtractor. Default is false.
+       * */
+      itkSetMacro(ParallelSmoothing, bool);
+      itkBooleanMacro(ParallelSmoothing);
+      itkGetConstMacro(ParallelSmoothing, bool);
+
       /**
        * Transforms a point by a 4x4 matrix
        */
@@ -233,6 +260,16 @@ namespace mitk {
     * */
       float m_SmoothRelaxation;
 
+    /**
+    * Algorithm that creates the surface, default is "MarchingCubes". See also SetSurfaceExtraction (SurfaceExtractionType _arg)
+    * */
+      SurfaceExtractionType m_SurfaceExtraction;
+
+      /**
+    * Smooth with FlyingEdgesSurfaceExtractor instead of vtkSmoothPolyDataFilter if m_SurfaceExtraction is ParallelFlyingEdges, default is "false". See also SetParallelSmoothing (bool _arg)
+    */
+      bool m_ParallelSmoothing;
+
   };
 
 } // namespace mitk
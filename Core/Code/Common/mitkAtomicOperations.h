@@ -0,0 +1,95 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#ifndef MITK_ATOMICOPERATIONS_H_DEFINED
+#define MITK_ATOMICOPERATIONS_H_DEFINED
+
+#ifdef _WIN32
+  #ifndef WIN32_LEAN_AND_MEAN
+    #define WIN32_LEAN_AND_MEAN
+  #endif
+  #ifndef NOMINMAX
+    #define NOMINMAX
+  #endif
+  #include <windows.h>
+#endif
+
+namespace mitk
+{
+
+/**
+  \brief Atomic operations on a long for the lock-free queues and buffers of MITK (see e.g. LoggingBackend).
+
+  All operations are full memory barriers: AtomicLoad() orders the accesses after it, AtomicStore() the ones
+  before and after it.
+*/
+typedef long AtomicType;
+
+#ifdef _WIN32
+
+/// stores desired in value if value equals expected, returns the previous value
+inline AtomicType AtomicCompareAndSwap(volatile AtomicType* value, AtomicType expected, AtomicType desired)
+{
+  return InterlockedCompareExchange(value, desired, expected);
+}
+
+inline void AtomicIncrement(volatile AtomicType* value)
+{
+  InterlockedIncrement(value);
+}
+
+inline void MemoryFence()
+{
+  MemoryBarrier();
+}
+
+#else
+
+/// stores desired in value if value equals expected, returns the previous value
+inline AtomicType AtomicCompareAndSwap(volatile AtomicType* value, AtomicType expected, AtomicType desired)
+{
+  return __sync_val_compare_and_swap(value, expected, desired);
+}
+
+inline void AtomicIncrement(volatile AtomicType* value)
+{
+  __sync_add_and_fetch(value, 1);
+}
+
+inline void MemoryFence()
+{
+  __sync_synchronize();
+}
+
+#endif
+
+inline AtomicType AtomicLoad(const volatile AtomicType* value)
+{
+  AtomicType result = *value;
+  MemoryFence();
+  return result;
+}
+
+inline void AtomicStore(volatile AtomicType* value, AtomicType newValue)
+{
+  MemoryFence();
+  *value = newValue;
+  MemoryFence();
+}
+
+}
+
+#endif
@@ -18,9 +18,11 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "mitkLimitedLinearUndo.h"
 #include <mitkRenderingManager.h>
 
+#include <algorithm>
+
 mitk::LimitedLinearUndo::LimitedLinearUndo()
+: m_MaximumMemorySize(0)
 {
-  // nothing to do
 }
 
 mitk::LimitedLinearUndo::~LimitedLinearUndo()
@@ -54,11 +56,56 @@ bool mitk::LimitedLinearUndo::SetOperationEvent(UndoStackItem* stackItem)
 
   m_UndoList.push_back(operationEvent);
 
+  this->LimitMemorySize();
+
   InvokeEvent( UndoNotEmptyEvent() );
 
   return true;
 }
 
+void mitk::LimitedLinearUndo::SetMaximumMemorySize(unsigned long size)
+{
+  m_MaximumMemorySize = size;
+  this->LimitMemorySize();
+}
+
+unsigned long mitk::LimitedLinearUndo::GetMaximumMemorySize() const
+{
+  return m_MaximumMemorySize;
+}
+
+unsigned long mitk::LimitedLinearUndo::GetMemorySize() const
+{
+  unsigned long size(0);
+  for ( UndoContainer::const_iterator iter = m_UndoList.begin(); iter != m_UndoList.end(); ++iter )
+    size += (*iter)->GetMemorySize();
+  for ( UndoContainer::const_iterator iter = m_RedoList.begin(); iter != m_RedoList.end(); ++iter )
+    size += (*iter)->GetMemorySize();
+  return size;
+}
+
+void mitk::LimitedLinearUndo::LimitMemorySize()
+{
+  if (m_MaximumMemorySize == 0 || m_UndoList.empty()) return;
+
+  unsigned long size = this->GetMemorySize();
+  int newestObjectEventId = m_UndoList.back()->GetObjectEventId();
+
+  // oldest items are at the front, never delete the most recent step
+  UndoContainer::iterator end = m_UndoList.begin();
+  while ( size > m_MaximumMemorySize && end != m_UndoList.end() && (*end)->GetObjectEventId() != newestObjectEventId )
+  {
+    int objectEventId = (*end)->GetObjectEventId();
+    while ( end != m_UndoList.end() && (*end)->GetObjectEventId() == objectEventId )
+    {
+      size -= std::min( size, (*end)->GetMemorySize() );
+      delete *end;
+      ++end;
+    }
+  }
+  m_UndoList.erase( m_UndoList.begin(), end );
+}
+
 bool mitk::LimitedLinearUndo::Undo(bool fine)
 {
   if (fine)
@@ -36,6 +36,10 @@ namespace mitk {
 //##
 //## Derived from UndoModel AND itk::Object. Invokes ITK-events to signal listening
 //## GUI elements, whether each of the stacks is empty or not (to enable/disable button, ...)
+//##
+//## The memory used by both stacks can be limited with SetMaximumMemorySize(). When a new
+//## item exceeds the limit, the oldest undo steps are deleted. The most recent step is
+//## always kept.
 class MITK_CORE_EXPORT LimitedLinearUndo : public UndoModel
 {
 public:
@@ -102,6 +106,17 @@ public:
   //## corresponding to the given values; if nothing found, then returns NULL
   virtual OperationEvent* GetLastOfType(OperationActor* destination, OperationType opType);
 
+  //##Documentation
+  //## @brief Limits the memory of undo and redo stack to size bytes, 0 (default) means no limit
+  //##
+  //## Deletes the oldest undo steps if the stacks already exceed the new limit.
+  void SetMaximumMemorySize(unsigned long size);
+  unsigned long GetMaximumMemorySize() const;
+
+  //##Documentation
+  //## @brief Current memory of undo and redo stack in bytes, see UndoStackItem::GetMemorySize()
+  unsigned long GetMemorySize() const;
+
 protected:
   //##Documentation
   //## Constructor
@@ -115,10 +130,16 @@ protected:
   //## elements in the list and to clear the list
   void ClearList(UndoContainer* list);
 
+  //## @brief Deletes the oldest undo steps (all items of an ObjectEventId at once)
+  //## until the stacks fit into the maximum memory size
+  void LimitMemorySize();
+
   UndoContainer m_UndoList;
 
   UndoContainer m_RedoList;
 
+  unsigned long m_MaximumMemorySize;
+
 private:
   int FirstObjectEventIdOfCurrentGroup(UndoContainer& stack);
 
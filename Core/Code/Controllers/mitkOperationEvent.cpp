@@ -98,6 +98,11 @@ void mitk::UndoStackItem::ReverseAndExecute()
   ReverseOperations();
 }
 
+unsigned long mitk::UndoStackItem::GetMemorySize() const
+{
+  return 0;
+}
+
 // ******************** mitk::OperationEvent ********************
 
 mitk::Operation* mitk::OperationEvent::GetOperation()
@@ -173,3 +178,13 @@ bool mitk::OperationEvent::IsValid()
 {
   return !m_Invalid;
 }
+
+unsigned long mitk::OperationEvent::GetMemorySize() const
+{
+  unsigned long size(0);
+  if (m_Operation)
+    size += m_Operation->GetMemorySize();
+  if (m_UndoOperation)
+    size += m_UndoOperation->GetMemorySize();
+  return size;
+}
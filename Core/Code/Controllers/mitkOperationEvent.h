@@ -84,6 +84,10 @@ class MITK_CORE_EXPORT UndoStackItem
     virtual void ReverseOperations();
     virtual void ReverseAndExecute();
 
+    //##Documentation
+    //## @brief Approximate number of bytes held by this item, see Operation::GetMemorySize()
+    virtual unsigned long GetMemorySize() const;
+
     //##Documentation
     //## @brief Sets the current ObjectEventId to be incremended when ExecuteIncrement is called
     //## For example if a button click generates operations the ObjectEventId has to be incremented to be able to undo the operations.
@@ -177,6 +181,9 @@ public:
   //## and false if it already has been deleted
   virtual bool IsValid();
 
+  //## @brief Sum of the memory sizes of both operations
+  virtual unsigned long GetMemorySize() const;
+
 protected:
 
   void OnObjectDeleted();
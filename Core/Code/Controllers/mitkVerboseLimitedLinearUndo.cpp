@@ -39,6 +39,8 @@ bool mitk::VerboseLimitedLinearUndo::SetOperationEvent(UndoStackItem* undoStackI
 
   m_UndoList.push_back(undoStackItem);
 
+  this->LimitMemorySize();
+
   InvokeEvent( UndoNotEmptyEvent() );
 
   return true;
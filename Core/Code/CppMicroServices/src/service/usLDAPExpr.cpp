@@ -288,6 +288,27 @@ bool LDAPExpr::IsSimple(const StringList& keywords, LocalCache& cache,
   return false;
 }
 
+void LDAPExpr::GetRequiredAttributeValues(AttributeValueList& attributeValues) const
+{
+  if (d->m_operator == EQ)
+  {
+    if (d->m_attrValue.find_first_of(WILDCARD) == std::string::npos)
+    {
+      attributeValues.push_back(std::make_pair(ToLower(d->m_attrName), d->m_attrValue));
+    }
+  }
+  else if (d->m_operator == AND)
+  {
+    for (std::size_t i = 0; i < d->m_args.size(); i++)
+    {
+      if (d->m_args[i].d->m_operator == EQ)
+      {
+        d->m_args[i].GetRequiredAttributeValues(attributeValues);
+      }
+    }
+  }
+}
+
 bool LDAPExpr::IsNull() const
 {
   return !d;
@@ -56,6 +56,7 @@ public:
   typedef std::vector<std::string> StringList;
   typedef std::vector<StringList> LocalCache;
   typedef US_UNORDERED_SET_TYPE<std::string> ObjectClassSet;
+  typedef std::vector<std::pair<std::string, std::string> > AttributeValueList;
 
 
   /**
@@ -109,6 +110,17 @@ public:
     LocalCache& cache,
     bool matchCase) const;
 
+  /**
+   * Get the attribute-value pairs which have to be matched for this
+   * expression to be true. These are the equality comparisons without
+   * wildcards of a single <code>(<it>name</it>=<it>value</it>)</code>
+   * expression or of the direct operands of an <code>(& EXPR+ )</code>
+   * expression. The attribute names are converted to lower case.
+   *
+   * \param attributeValues The pairs will be added to attributeValues.
+   */
+  void GetRequiredAttributeValues(AttributeValueList& attributeValues) const;
+
   /**
    * Returns <code>true</code> if this instance is invalid, i.e. it was
    * constructed using LDAPExpr().
@@ -21,8 +21,12 @@
 
 #include <usConfig.h>
 
+#include <algorithm>
+#include <cctype>
 #include <iterator>
 #include <stdexcept>
+#include <typeinfo>
+#include <vector>
 
 #ifdef US_ENABLE_SERVICE_FACTORY_SUPPORT
 #include US_BASECLASS_HEADER
@@ -40,6 +44,9 @@ US_BEGIN_NAMESPACE
 
 typedef MutexLock<ServiceRegistry::MutexType> MutexLocker;
 
+// parsed filters are dropped when the cache grows beyond this size
+static const std::size_t MAX_FILTER_CACHE_SIZE = 256;
+
 
 ServiceProperties ServiceRegistry::CreateServiceProperties(const ServiceProperties& in,
                                                            const std::list<std::string>& classes,
@@ -60,6 +67,7 @@ ServiceProperties ServiceRegistry::CreateServiceProperties(const ServiceProperti
 
 ServiceRegistry::ServiceRegistry(CoreModuleContext* coreCtx)
   : core(coreCtx)
+  , snapshot(new Snapshot())
 {
 
 }
@@ -71,9 +79,15 @@ ServiceRegistry::~ServiceRegistry()
 
 void ServiceRegistry::Clear()
 {
-  services.clear();
-  serviceRegistrations.clear();
-  classServices.clear();
+  {
+    MutexLocker lock(mutex);
+    services.clear();
+    SetSnapshot(SharedDataPointer<Snapshot>(new Snapshot()));
+  }
+  {
+    MutexLocker lock(filterCacheMutex);
+    filterCache.clear();
+  }
   core = 0;
 }
 
@@ -116,15 +130,20 @@ ServiceRegistration ServiceRegistry::RegisterService(ModulePrivate* module,
   {
     MutexLocker lock(mutex);
     services.insert(std::make_pair(res, classes));
-    serviceRegistrations.push_back(res);
+
+    // copy on write, lookups may still use the current snapshot
+    SharedDataPointer<Snapshot> newSnapshot = GetSnapshot();
+    newSnapshot->serviceRegistrations.push_back(res);
     for (std::list<std::string>::const_iterator i = classes.begin();
          i != classes.end(); ++i)
     {
-      std::list<ServiceRegistration>& s = classServices[*i];
+      std::list<ServiceRegistration>& s = newSnapshot->classServices[*i];
       std::list<ServiceRegistration>::iterator ip =
           std::lower_bound(s.begin(), s.end(), res);
       s.insert(ip, res);
     }
+    AddToPropertyIndex(*newSnapshot, res);
+    SetSnapshot(newSnapshot);
   }
 
   ServiceReference r = res.GetReference();
@@ -139,13 +158,27 @@ void ServiceRegistry::UpdateServiceRegistrationOrder(const ServiceRegistration&
                                                      const std::list<std::string>& classes)
 {
   MutexLocker lock(mutex);
+  SharedDataPointer<Snapshot> newSnapshot = GetSnapshot();
   for (std::list<std::string>::const_iterator i = classes.begin();
        i != classes.end(); ++i)
   {
-    std::list<ServiceRegistration>& s = classServices[*i];
+    std::list<ServiceRegistration>& s = newSnapshot->classServices[*i];
     s.erase(std::remove(s.begin(), s.end(), sr), s.end());
     s.insert(std::lower_bound(s.begin(), s.end(), sr), sr);
   }
+  // the lists of the index are ordered by ranking, too
+  RemoveFromPropertyIndex(*newSnapshot, sr);
+  AddToPropertyIndex(*newSnapshot, sr);
+  SetSnapshot(newSnapshot);
+}
+
+void ServiceRegistry::UpdateServiceRegistrationProperties(const ServiceRegistration& sr)
+{
+  MutexLocker lock(mutex);
+  SharedDataPointer<Snapshot> newSnapshot = GetSnapshot();
+  RemoveFromPropertyIndex(*newSnapshot, sr);
+  AddToPropertyIndex(*newSnapshot, sr);
+  SetSnapshot(newSnapshot);
 }
 
 bool ServiceRegistry::CheckServiceClass(US_BASECLASS_NAME* , const std::string& ) const
@@ -158,9 +191,9 @@ bool ServiceRegistry::CheckServiceClass(US_BASECLASS_NAME* , const std::string&
 void ServiceRegistry::Get(const std::string& clazz,
                           std::list<ServiceRegistration>& serviceRegs) const
 {
-  MutexLocker lock(mutex);
-  MapClassServices::const_iterator i = classServices.find(clazz);
-  if (i != classServices.end())
+  const SharedDataPointer<Snapshot> currentSnapshot = GetSnapshot();
+  MapClassServices::const_iterator i = currentSnapshot->classServices.find(clazz);
+  if (i != currentSnapshot->classServices.end())
   {
     serviceRegs = i->second;
   }
@@ -168,11 +201,10 @@ void ServiceRegistry::Get(const std::string& clazz,
 
 ServiceReference ServiceRegistry::Get(ModulePrivate* module, const std::string& clazz) const
 {
-  MutexLocker lock(mutex);
   try
   {
     std::list<ServiceReference> srs;
-    Get_unlocked(clazz, "", module, srs);
+    Get(clazz, "", module, srs);
     US_DEBUG << "get service ref " << clazz << " for module "
              << module->info.name << " = " << srs.size() << " refs";
 
@@ -188,84 +220,101 @@ ServiceReference ServiceRegistry::Get(ModulePrivate* module, const std::string&
 }
 
 void ServiceRegistry::Get(const std::string& clazz, const std::string& filter,
-                          ModulePrivate* module, std::list<ServiceReference>& res) const
-{
-  MutexLocker lock(mutex);
-  Get_unlocked(clazz, filter, module, res);
-}
-
-void ServiceRegistry::Get_unlocked(const std::string& clazz, const std::string& filter,
                           ModulePrivate* /*module*/, std::list<ServiceReference>& res) const
 {
+  // no lock is held while the filter is evaluated
+  const SharedDataPointer<Snapshot> currentSnapshot = GetSnapshot();
+
   std::list<ServiceRegistration>::const_iterator s;
   std::list<ServiceRegistration>::const_iterator send;
   std::list<ServiceRegistration> v;
+  std::size_t candidates = 0;
   LDAPExpr ldap;
+  if (!filter.empty())
+  {
+    ldap = GetLDAPExpr(filter);
+  }
+
   if (clazz.empty())
   {
-    if (!filter.empty())
+    LDAPExpr::ObjectClassSet matched;
+    if (!ldap.IsNull() && ldap.GetMatchedObjectClasses(matched))
     {
-      ldap = LDAPExpr(filter);
-      LDAPExpr::ObjectClassSet matched;
-      if (ldap.GetMatchedObjectClasses(matched))
+      v.clear();
+      for(LDAPExpr::ObjectClassSet::const_iterator className = matched.begin();
+          className != matched.end(); ++className)
       {
-        v.clear();
-        for(LDAPExpr::ObjectClassSet::const_iterator className = matched.begin();
-            className != matched.end(); ++className)
-        {
-          MapClassServices::const_iterator i = classServices.find(*className);
-          if (i != classServices.end())
-          {
-            std::copy(i->second.begin(), i->second.end(), std::back_inserter(v));
-          }
-        }
-        if (!v.empty())
+        MapClassServices::const_iterator i = currentSnapshot->classServices.find(*className);
+        if (i != currentSnapshot->classServices.end())
         {
-          s = v.begin();
-          send = v.end();
-        }
-        else
-        {
-          return;
+          std::copy(i->second.begin(), i->second.end(), std::back_inserter(v));
         }
       }
+      if (!v.empty())
+      {
+        s = v.begin();
+        send = v.end();
+        candidates = v.size();
+      }
       else
       {
-        s = serviceRegistrations.begin();
-        send = serviceRegistrations.end();
+        return;
       }
     }
     else
     {
-      s = serviceRegistrations.begin();
-      send = serviceRegistrations.end();
+      s = currentSnapshot->serviceRegistrations.begin();
+      send = currentSnapshot->serviceRegistrations.end();
+      candidates = currentSnapshot->serviceRegistrations.size();
     }
   }
   else
   {
-    MapClassServices::const_iterator it = classServices.find(clazz);
-    if (it != classServices.end())
+    MapClassServices::const_iterator it = currentSnapshot->classServices.find(clazz);
+    if (it != currentSnapshot->classServices.end())
     {
       s = it->second.begin();
       send = it->second.end();
+      candidates = it->second.size();
     }
     else
     {
       return;
     }
-    if (!filter.empty())
+  }
+
+  // equality conditions on indexed properties may give fewer services to check
+  bool checkClass = false;
+  if (!ldap.IsNull())
+  {
+    const std::list<ServiceRegistration>* indexed = GetIndexedCandidates(*currentSnapshot, ldap);
+    if (indexed != 0 && indexed->size() < candidates)
     {
-      ldap = LDAPExpr(filter);
+      s = indexed->begin();
+      send = indexed->end();
+      checkClass = !clazz.empty();
     }
   }
 
   for (; s != send; ++s)
   {
-    ServiceReference sri = s->GetReference();
+    if (checkClass)
+    {
+      ServiceProperties::const_iterator classes = s->d->properties.find(ServiceConstants::OBJECTCLASS());
+      if (classes == s->d->properties.end())
+      {
+        continue;
+      }
+      const std::list<std::string>& classList = ref_any_cast<std::list<std::string> >(classes->second);
+      if (std::find(classList.begin(), classList.end(), clazz) == classList.end())
+      {
+        continue;
+      }
+    }
 
-    if (filter.empty() || ldap.Evaluate(s->d->properties, false))
+    if (ldap.IsNull() || ldap.Evaluate(s->d->properties, false))
     {
-      res.push_back(sri);
+      res.push_back(s->GetReference());
     }
   }
 }
@@ -277,29 +326,33 @@ void ServiceRegistry::RemoveServiceRegistration(const ServiceRegistration& sr)
   const std::list<std::string>& classes = ref_any_cast<std::list<std::string> >(
         sr.d->properties[ServiceConstants::OBJECTCLASS()]);
   services.erase(sr);
-  serviceRegistrations.remove(sr);
+
+  SharedDataPointer<Snapshot> newSnapshot = GetSnapshot();
+  newSnapshot->serviceRegistrations.remove(sr);
   for (std::list<std::string>::const_iterator i = classes.begin();
        i != classes.end(); ++i)
   {
-    std::list<ServiceRegistration>& s = classServices[*i];
+    std::list<ServiceRegistration>& s = newSnapshot->classServices[*i];
     if (s.size() > 1)
     {
       s.erase(std::remove(s.begin(), s.end(), sr), s.end());
     }
     else
     {
-      classServices.erase(*i);
+      newSnapshot->classServices.erase(*i);
     }
   }
+  RemoveFromPropertyIndex(*newSnapshot, sr);
+  SetSnapshot(newSnapshot);
 }
 
 void ServiceRegistry::GetRegisteredByModule(ModulePrivate* p,
                                             std::list<ServiceRegistration>& res) const
 {
-  MutexLocker lock(mutex);
+  const SharedDataPointer<Snapshot> currentSnapshot = GetSnapshot();
 
-  for (std::list<ServiceRegistration>::const_iterator i = serviceRegistrations.begin();
-       i != serviceRegistrations.end(); ++i)
+  for (std::list<ServiceRegistration>::const_iterator i = currentSnapshot->serviceRegistrations.begin();
+       i != currentSnapshot->serviceRegistrations.end(); ++i)
   {
     if (i->d->module == p)
     {
@@ -311,10 +364,10 @@ void ServiceRegistry::GetRegisteredByModule(ModulePrivate* p,
 void ServiceRegistry::GetUsedByModule(Module* p,
                                       std::list<ServiceRegistration>& res) const
 {
-  MutexLocker lock(mutex);
+  const SharedDataPointer<Snapshot> currentSnapshot = GetSnapshot();
 
-  for (std::list<ServiceRegistration>::const_iterator i = serviceRegistrations.begin();
-       i != serviceRegistrations.end(); ++i)
+  for (std::list<ServiceRegistration>::const_iterator i = currentSnapshot->serviceRegistrations.begin();
+       i != currentSnapshot->serviceRegistrations.end(); ++i)
   {
     if (i->d->IsUsedByModule(p))
     {
@@ -323,5 +376,165 @@ void ServiceRegistry::GetUsedByModule(Module* p,
   }
 }
 
+SharedDataPointer<ServiceRegistry::Snapshot> ServiceRegistry::GetSnapshot() const
+{
+  MutexLocker lock(snapshotMutex);
+  return snapshot;
+}
+
+void ServiceRegistry::SetSnapshot(const SharedDataPointer<Snapshot>& newSnapshot)
+{
+  SharedDataPointer<Snapshot> oldSnapshot;
+  {
+    MutexLocker lock(snapshotMutex);
+    oldSnapshot = snapshot;
+    snapshot = newSnapshot;
+  }
+  // the old snapshot is deleted here (if unused), outside of the lock
+}
+
+LDAPExpr ServiceRegistry::GetLDAPExpr(const std::string& filter) const
+{
+  {
+    MutexLocker lock(filterCacheMutex);
+    MapFilterCache::const_iterator i = filterCache.find(filter);
+    if (i != filterCache.end())
+    {
+      return i->second;
+    }
+  }
+
+  LDAPExpr ldap(filter);
+
+  MutexLocker lock(filterCacheMutex);
+  if (filterCache.size() >= MAX_FILTER_CACHE_SIZE)
+  {
+    filterCache.clear();
+  }
+  filterCache.insert(std::make_pair(filter, ldap));
+  return ldap;
+}
+
+void ServiceRegistry::AddToPropertyIndex(Snapshot& snapshot, const ServiceRegistration& sr)
+{
+  const ServiceProperties& props = sr.d->properties;
+  for (ServiceProperties::const_iterator prop = props.begin(); prop != props.end(); ++prop)
+  {
+    std::string key(prop->first.c_str());
+    std::transform(key.begin(), key.end(), key.begin(), ::tolower);
+    if (key == ServiceConstants::OBJECTCLASS())
+    {
+      // already indexed in classServices
+      continue;
+    }
+
+    // like LDAPExpr::Compare(), string lists match if one of their elements matches
+    std::vector<std::string> values;
+    const Any& value = prop->second;
+    if (value.Type() == typeid(std::string))
+    {
+      values.push_back(ref_any_cast<std::string>(value));
+    }
+    else if (value.Type() == typeid(std::vector<std::string>))
+    {
+      values = ref_any_cast<std::vector<std::string> >(value);
+    }
+    else if (value.Type() == typeid(std::list<std::string>))
+    {
+      const std::list<std::string>& list = ref_any_cast<std::list<std::string> >(value);
+      values.assign(list.begin(), list.end());
+    }
+    else
+    {
+      snapshot.propertyIndices[key].otherValues.push_back(sr);
+      continue;
+    }
+
+    PropertyIndex& index = snapshot.propertyIndices[key];
+    for (std::vector<std::string>::const_iterator i = values.begin(); i != values.end(); ++i)
+    {
+      std::list<ServiceRegistration>& s = index.values[*i];
+      if (std::find(s.begin(), s.end(), sr) == s.end())
+      {
+        s.insert(std::lower_bound(s.begin(), s.end(), sr), sr);
+      }
+    }
+  }
+}
+
+void ServiceRegistry::RemoveFromPropertyIndex(Snapshot& snapshot, const ServiceRegistration& sr)
+{
+  MapPropertyIndices::iterator index = snapshot.propertyIndices.begin();
+  while (index != snapshot.propertyIndices.end())
+  {
+    MapClassServices::iterator value = index->second.values.begin();
+    while (value != index->second.values.end())
+    {
+      value->second.remove(sr);
+      if (value->second.empty())
+      {
+        index->second.values.erase(value++);
+      }
+      else
+      {
+        ++value;
+      }
+    }
+    index->second.otherValues.remove(sr);
+
+    if (index->second.values.empty() && index->second.otherValues.empty())
+    {
+      snapshot.propertyIndices.erase(index++);
+    }
+    else
+    {
+      ++index;
+    }
+  }
+}
+
+const std::list<ServiceRegistration>* ServiceRegistry::GetIndexedCandidates(const Snapshot& snapshot,
+                                                                            const LDAPExpr& ldap)
+{
+  static const std::list<ServiceRegistration> noServices;
+
+  LDAPExpr::AttributeValueList attributeValues;
+  ldap.GetRequiredAttributeValues(attributeValues);
+
+  const std::list<ServiceRegistration>* shortest = 0;
+  for (LDAPExpr::AttributeValueList::const_iterator i = attributeValues.begin();
+       i != attributeValues.end(); ++i)
+  {
+    if (i->first == ServiceConstants::OBJECTCLASS())
+    {
+      // not part of the property index, see AddToPropertyIndex()
+      continue;
+    }
+
+    MapPropertyIndices::const_iterator index = snapshot.propertyIndices.find(i->first);
+    if (index == snapshot.propertyIndices.end())
+    {
+      // no service has this property
+      return &noServices;
+    }
+    if (!index->second.otherValues.empty())
+    {
+      // values of other types are compared after conversion, which the index cannot do
+      continue;
+    }
+
+    MapClassServices::const_iterator value = index->second.values.find(i->second);
+    if (value == index->second.values.end())
+    {
+      return &noServices;
+    }
+    if (shortest == 0 || value->second.size() < shortest->size())
+    {
+      shortest = &value->second;
+    }
+  }
+  return shortest;
+}
+
 US_END_NAMESPACE
 
@@ -27,8 +27,10 @@
 
 #include "usServiceRegistration.h"
 #include "usServiceProperties.h"
+#include "usLDAPExpr_p.h"
 
 #include "usThreads_p.h"
+#include "usSharedData.h"
 
 US_BEGIN_NAMESPACE
 
@@ -65,20 +67,55 @@ public:
   typedef US_UNORDERED_MAP_TYPE<std::string, std::list<ServiceRegistration> > MapClassServices;
 
   /**
-   * All registered services in the current framework.
-   * Mapping of registered service to class names under which
-   * the service is registerd.
+   * Registered services with a property, indexed by the values of
+   * the property.
    */
-  MapServiceClasses services;
+  struct PropertyIndex
+  {
+    /**
+     * Mapping of string values (or elements of string lists) to the
+     * services with this value, ordered like the lists in classServices.
+     */
+    MapClassServices values;
+
+    /**
+     * Services with a value of another type, for which the property
+     * cannot be looked up in the index.
+     */
+    std::list<ServiceRegistration> otherValues;
+  };
+
+  typedef US_UNORDERED_MAP_TYPE<std::string, PropertyIndex> MapPropertyIndices;
 
-  std::list<ServiceRegistration> serviceRegistrations;
+  /**
+   * The registered services at one point in time. Lookups work on a
+   * snapshot without holding the registry mutex, a modification of
+   * the registry copies the current snapshot and replaces it.
+   */
+  struct Snapshot : public SharedData
+  {
+    std::list<ServiceRegistration> serviceRegistrations;
+
+    /**
+     * Mapping of classname to registered service.
+     * The List of registered services are ordered with the highest
+     * ranked service first.
+     */
+    MapClassServices classServices;
+
+    /**
+     * Mapping of lower case property keys to the services with
+     * this property.
+     */
+    MapPropertyIndices propertyIndices;
+  };
 
   /**
-   * Mapping of classname to registered service.
-   * The List of registered services are ordered with the highest
-   * ranked service first.
+   * All registered services in the current framework.
+   * Mapping of registered service to class names under which
+   * the service is registerd.
    */
-  MapClassServices classServices;
+  MapServiceClasses services;
 
   CoreModuleContext* core;
 
@@ -118,6 +155,13 @@ public:
   void UpdateServiceRegistrationOrder(const ServiceRegistration& sr,
                                       const std::list<std::string>& classes);
 
+  /**
+   * Service properties changed, update the property index.
+   *
+   * @param serviceRegistration The ServiceRegistrationPrivate object.
+   */
+  void UpdateServiceRegistrationProperties(const ServiceRegistration& sr);
+
   /**
    * Checks that a given service object is an instance of the given
    * class name.
@@ -182,8 +226,45 @@ public:
 
 private:
 
-  void Get_unlocked(const std::string& clazz, const std::string& filter,
-                    ModulePrivate* module, std::list<ServiceReference>& serviceRefs) const;
+  /**
+   * Returns the current snapshot, which stays valid (and unchanged)
+   * as long as the returned pointer exists.
+   */
+  SharedDataPointer<Snapshot> GetSnapshot() const;
+
+  /**
+   * Replaces the current snapshot. Must be called with the registry
+   * mutex locked.
+   */
+  void SetSnapshot(const SharedDataPointer<Snapshot>& newSnapshot);
+
+  /**
+   * Returns the parsed filter, parsing it only if it was not used
+   * recently.
+   *
+   * @exception std::invalid_argument If the filter is not valid.
+   */
+  LDAPExpr GetLDAPExpr(const std::string& filter) const;
+
+  static void AddToPropertyIndex(Snapshot& snapshot, const ServiceRegistration& sr);
+
+  static void RemoveFromPropertyIndex(Snapshot& snapshot, const ServiceRegistration& sr);
+
+  /**
+   * Returns the shortest list of services from the property index
+   * that contains all services matching ldap, or 0 if the index
+   * cannot be used for ldap.
+   */
+  static const std::list<ServiceRegistration>* GetIndexedCandidates(const Snapshot& snapshot,
+                                                                   const LDAPExpr& ldap);
+
+  mutable MutexType snapshotMutex;
+  SharedDataPointer<Snapshot> snapshot;
+
+  typedef US_UNORDERED_MAP_TYPE<std::string, LDAPExpr> MapFilterCache;
+
+  mutable MutexType filterCacheMutex;
+  mutable MapFilterCache filterCache;
 
   // purposely not implemented
   ServiceRegistry(const ServiceRegistry&);
@@ -125,6 +125,92 @@ int TestServicePropertiesUpdate()
   return EXIT_SUCCESS;
 }
 
+int TestFilteredServiceLookup()
+{
+  struct TestServiceA : public US_BASECLASS_NAME, public ITestServiceA
+  {
+  };
+
+  ModuleContext* context = GetModuleContext();
+
+  TestServiceA s1;
+  ServiceProperties props1;
+  props1["name"] = std::string("first");
+  std::list<std::string> tags;
+  tags.push_back("red");
+  tags.push_back("green");
+  props1["tags"] = tags;
+  ServiceRegistration reg1 = context->RegisterService<ITestServiceA>(&s1, props1);
+
+  TestServiceA s2;
+  ServiceProperties props2;
+  props2["name"] = std::string("second");
+  props2["tags"] = std::string("red");
+  ServiceRegistration reg2 = context->RegisterService<ITestServiceA>(&s2, props2);
+
+  // a value of another type, the index cannot be used for this key
+  TestServiceA s3;
+  ServiceProperties props3;
+  props3["tags"] = 5;
+  ServiceRegistration reg3 = context->RegisterService<ITestServiceA>(&s3, props3);
+
+  std::list<ServiceReference> refs = context->GetServiceReferences<ITestServiceA>("(name=first)");
+  US_TEST_CONDITION_REQUIRED(refs.size() == 1 && refs.front() == reg1.GetReference(), "Testing lookup of string property")
+
+  refs = context->GetServiceReferences("", "(&(objectclass=" + std::string(us_service_interface_iid<ITestServiceA*>()) + ")(NAME=second))");
+  US_TEST_CONDITION_REQUIRED(refs.size() == 1 && refs.front() == reg2.GetReference(), "Testing lookup with object class")
+
+  refs = context->GetServiceReferences<ITestServiceA>("(name=third)");
+  US_TEST_CONDITION_REQUIRED(refs.empty(), "Testing lookup of unknown value")
+
+  refs = context->GetServiceReferences<ITestServiceA>("(unknown=first)");
+  US_TEST_CONDITION_REQUIRED(refs.empty(), "Testing lookup of unknown property")
+
+  refs = context->GetServiceReferences<ITestServiceA>("(&(name=first)(tags=green))");
+  US_TEST_CONDITION_REQUIRED(refs.size() == 1, "Testing lookup of string list element")
+
+  refs = context->GetServiceReferences<ITestServiceA>("(tags=red)");
+  US_TEST_CONDITION_REQUIRED(refs.size() == 2, "Testing lookup of property with mixed types")
+
+  refs = context->GetServiceReferences<ITestServiceA>("(tags=5)");
+  US_TEST_CONDITION_REQUIRED(refs.size() == 1 && refs.front() == reg3.GetReference(), "Testing lookup of int property")
+
+  refs = context->GetServiceReferences<ITestServiceA>("(name=f*)");
+  US_TEST_CONDITION_REQUIRED(refs.size() == 1, "Testing lookup with wildcard")
+
+  // the same filter again, now taken from the cache
+  refs = context->GetServiceReferences<ITestServiceA>("(name=first)");
+  US_TEST_CONDITION_REQUIRED(refs.size() == 1, "Testing lookup with cached filter")
+
+  props1["name"] = std::string("renamed");
+  reg1.SetProperties(props1);
+  refs = context->GetServiceReferences<ITestServiceA>("(name=first)");
+  US_TEST_CONDITION_REQUIRED(refs.empty(), "Testing lookup of old value after property update")
+  refs = context->GetServiceReferences<ITestServiceA>("(name=renamed)");
+  US_TEST_CONDITION_REQUIRED(refs.size() == 1 && refs.front() == reg1.GetReference(), "Testing lookup of new value after property update")
+
+  reg2.Unregister();
+  refs = context->GetServiceReferences<ITestServiceA>("(name=second)");
+  US_TEST_CONDITION_REQUIRED(refs.empty(), "Testing lookup after unregistration")
+
+  bool invalidFilterThrows = false;
+  try
+  {
+    context->GetServiceReferences<ITestServiceA>("(name=first");
+  }
+  catch (const std::invalid_argument&)
+  {
+    invalidFilterThrows = true;
+  }
+  US_TEST_CONDITION_REQUIRED(invalidFilterThrows, "Testing invalid filter")
+
+  reg1.Unregister();
+  reg3.Unregister();
+  US_TEST_CONDITION_REQUIRED(context->GetServiceReferences<ITestServiceA>().empty(), "Testing service count")
+
+  return EXIT_SUCCESS;
+}
+
 
 int usServiceRegistryTest(int /*argc*/, char* /*argv*/[])
 {
@@ -132,6 +218,7 @@ int usServiceRegistryTest(int /*argc*/, char* /*argv*/[])
 
   US_TEST_CONDITION(TestMultipleServiceRegistrations() == EXIT_SUCCESS, "Testing service registrations: ")
   US_TEST_CONDITION(TestServicePropertiesUpdate() == EXIT_SUCCESS, "Testing service property update: ")
+  US_TEST_CONDITION(TestFilteredServiceLookup() == EXIT_SUCCESS, "Testing filtered service lookup: ")
 
   US_TEST_END()
 }
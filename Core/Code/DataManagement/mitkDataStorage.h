@@ -101,7 +101,8 @@ namespace mitk {
     //## (see definition of NodePredicateBase for details).
     //## The method returns a set of SmartPointers to the DataNodes that fulfill the
     //## conditions. A set of all objects can be retrieved with the GetAll() method;
-    SetOfObjects::ConstPointer GetSubset(const NodePredicateBase* condition) const;
+    //## Subclasses may override this method to answer common queries from an index.
+    virtual SetOfObjects::ConstPointer GetSubset(const NodePredicateBase* condition) const;
 
     //##Documentation
     //## @brief returns a set of source objects for a given node that meet the given condition(s).
@@ -366,7 +367,7 @@ namespace mitk {
     //##
     //## The node is hidden behind the caller parameter, which has to be casted first.
     //## If the cast succeeds the ChangedNodeEvent is emitted with this node.
-    void OnNodeModifiedOrDeleted( const itk::Object *caller, const itk::EventObject &event );
+    virtual void OnNodeModifiedOrDeleted( const itk::Object *caller, const itk::EventObject &event );
 
     //##Documentation
     //## @brief  Adds a Modified-Listener to the given Node.
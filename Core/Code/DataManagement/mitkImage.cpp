@@ -34,6 +34,8 @@ m_Dimension(0), m_Dimensions(NULL), m_ImageDescriptor(NULL), m_OffsetTable(NULL)
    m_Dimensions = new unsigned int[MAX_IMAGE_DIMENSIONS];
    FILL_C_ARRAY( m_Dimensions, MAX_IMAGE_DIMENSIONS, 0u);
 
+   m_AccessorReleased = itk::ConditionVariable::New();
+
    m_Initialized = false;
 }
 
@@ -43,6 +45,8 @@ m_ImageDescriptor(NULL), m_OffsetTable(NULL), m_CompleteData(NULL), m_ImageStati
   m_Dimensions = new unsigned int[MAX_IMAGE_DIMENSIONS];
   FILL_C_ARRAY( m_Dimensions, MAX_IMAGE_DIMENSIONS, 0u);
 
+  m_AccessorReleased = itk::ConditionVariable::New();
+
   this->Initialize( other.GetPixelType(), other.GetDimension(), other.GetDimensions());
 
   //Since the above called "Initialize" method doesn't take the geometry into account we need to set it
@@ -674,6 +678,41 @@ bool mitk::Image::SetImportChannel(void *data, int n, ImportMemoryManagementType
   return true;
 }
 
+bool mitk::Image::SetMemoryMappedChannel(MemoryMappedFile* mappedFile, int n)
+{
+  if(IsValidChannel(n)==false) return false;
+  if(mappedFile==NULL) return false;
+
+  const size_t ptypeSize = this->m_ImageDescriptor->GetChannelTypeById(n).GetSize();
+  if(mappedFile->GetSize() < m_OffsetTable[4]*(ptypeSize))
+  {
+    MITK_ERROR << "Memory mapped file " << mappedFile->GetFileName() << " is too small for channel " << n;
+    return false;
+  }
+
+  bool wasSet = IsChannelSet(n);
+
+  // sub-items of a previous channel still reference its data
+  for(unsigned int t=0;t<m_Dimensions[3];++t)
+  {
+    for(unsigned int s=0;s<m_Dimensions[2];++s)
+      m_Slices[GetSliceIndex(s,t,n)]=NULL;
+    m_Volumes[GetVolumeIndex(t,n)]=NULL;
+  }
+
+  ImageDataItemPointer ch=new ImageDataItem(this->m_ImageDescriptor, mappedFile);
+  ch->SetComplete(true);
+  m_Channels[n]=ch;
+  this->m_ImageDescriptor->GetChannelDescriptor(n).SetData( ch->GetData() );
+
+  if(wasSet)
+  {
+    //we have changed the data: call Modified()!
+    Modified();
+  }
+  return true;
+}
+
 void mitk::Image::Initialize()
 {
   ImageDataItemPointerArray::iterator it, end;
@@ -1017,6 +1056,21 @@ void mitk::Image::ComputeOffsetTable()
     m_OffsetTable[i+1] = num;
 }
 
+mitk::ImageAccessorStatistics mitk::Image::GetAccessorStatistics() const
+{
+  m_ReadWriteLock.Lock();
+  ImageAccessorStatistics statistics = m_AccessorStatistics;
+  m_ReadWriteLock.Unlock();
+  return statistics;
+}
+
+void mitk::Image::ResetAccessorStatistics()
+{
+  m_ReadWriteLock.Lock();
+  m_AccessorStatistics = ImageAccessorStatistics();
+  m_ReadWriteLock.Unlock();
+}
+
 bool mitk::Image::IsValidTimeStep(int t) const
 {
   return ( ( m_Dimension >= 4 && t <= (int)m_Dimensions[3] && t > 0 ) || (t == 0) );
@@ -28,6 +28,8 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "mitkImageAccessorBase.h"
 #include "mitkImageVtkAccessor.h"
 
+#include <itkConditionVariable.h>
+
 #ifndef __itkHistogram_h
 #include <itkHistogram.h>
 #endif
@@ -226,6 +228,17 @@ public:
   //## @sa SetPicChannel
   virtual bool SetImportChannel(void *data, int n = 0, ImportMemoryManagementType importMemoryManagement = CopyMemory );
 
+  //##Documentation
+  //## @brief Use the memory mapped file @a mappedFile as data of channel @a n.
+  //##
+  //## The image data is not loaded into memory: pages of the file are read when
+  //## they are accessed for the first time, e.g. by GetVolumeData(), GetSliceData()
+  //## or an ImageReadAccessor. Writing to the image is possible, but modifications
+  //## are kept in memory and never written back to the file. The layout and byte
+  //## order of the mapped data have to match the pixel type and dimensions of the image.
+  //## @sa MemoryMappedFile
+  virtual bool SetMemoryMappedChannel(MemoryMappedFile* mappedFile, int n = 0);
+
   //##Documentation
   //## initialize new (or re-initialize) image information
   //## @warning Initialize() by pic assumes a plane, evenly spaced geometry starting at (0,0,0).
@@ -565,6 +578,16 @@ public:
     return m_ImageStatistics;
   }
 
+  /**
+    \brief Returns a snapshot of the counters that describe how image accessors of this image competed for access.
+
+    Useful to find out whether concurrent filters are serialized by the ImageReadAccessor/ImageWriteAccessor locking.
+    */
+  ImageAccessorStatistics GetAccessorStatistics() const;
+
+  /** \brief Sets all counters returned by GetAccessorStatistics() to zero. */
+  void ResetAccessorStatistics();
+
 protected:
 
   int GetSliceIndex(int s = 0, int t = 0, int n = 0) const;
@@ -622,8 +645,15 @@ private:
   /** Stores all existing ImageVtkAccessors */
   std::vector<ImageAccessorBase*> m_VtkReaders;
 
-  /** A mutex, which needs to be locked to manage m_Readers and m_Writers */
-  itk::SimpleFastMutexLock m_ReadWriteLock;
+  /** Stores all ImageWriteAccessors that wait for conflicting accessors to be released */
+  std::vector<ImageAccessorBase*> m_WaitingWriters;
+
+  /** A mutex, which needs to be locked to manage m_Readers, m_Writers and m_WaitingWriters */
+  mutable itk::SimpleMutexLock m_ReadWriteLock;
+  /** Signalled whenever an ImageReadAccessor or ImageWriteAccessor is released */
+  itk::ConditionVariable::Pointer m_AccessorReleased;
+  /** Counts granted, waiting and rejected accesses, guarded by m_ReadWriteLock */
+  ImageAccessorStatistics m_AccessorStatistics;
   /** A mutex, which needs to be locked to manage m_VtkReaders */
   itk::SimpleFastMutexLock m_VtkReadersLock;
 
@@ -17,6 +17,10 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "mitkImageAccessorBase.h"
 #include "mitkImage.h"
 
+#include <itksys/SystemTools.hxx>
+
+#include <algorithm>
+
 mitk::ImageAccessorBase::ThreadIDType mitk::ImageAccessorBase::CurrentThreadHandle()
 {
   #ifdef ITK_USE_SPROC
@@ -40,19 +44,23 @@ bool mitk::ImageAccessorBase::CompareThreadHandles(mitk::ImageAccessorBase::Thre
   mitk::ImageAccessorBase::ImageAccessorBase(
       ImagePointer iP,
       ImageDataItem* imageDataItem,
-      int OptionFlags
+      int OptionFlags,
+      const itk::ImageRegion<4>* subRegion
     ) :
     m_Image(iP),
     // imageDataItem(iDI),
     m_SubRegion(NULL),
     m_Options(OptionFlags),
-    m_CoherentMemory(false)
+    m_CoherentMemory(false),
+    m_ItemBegin(NULL),
+    m_PixelSize(0)
     {
       m_Thread = CurrentThreadHandle();
 
-      // Initialize WaitLock
-      m_WaitLock = new ImageAccessorWaitLock();
-      m_WaitLock->m_WaiterCount = 0;
+      if(subRegion)
+      {
+        m_SubRegion = new itk::ImageRegion<4>(*subRegion);
+      }
 
       // Check validity of ImageAccessor
 
@@ -78,90 +86,272 @@ bool mitk::ImageAccessorBase::CompareThreadHandles(mitk::ImageAccessorBase::Thre
 
       // Investigate 4 cases of possible image parts/regions
 
-      // Case 1: No ImageDataItem and no Subregion => Whole Image is accessed
-      if(imageDataItem == NULL && m_SubRegion == NULL)
+      // Case 1 and 3: No ImageDataItem => first image channel is accessed
+      if(imageDataItem == NULL)
       {
-        m_CoherentMemory = true;
-
         // Organize first image channel
         imageDataItem = m_Image->GetChannelData();
+      }
 
-        // Set memory area
-        m_AddressBegin = imageDataItem->m_Data;
-        m_AddressEnd   = (unsigned char*) m_AddressBegin + imageDataItem->m_Size;
+      m_ItemBegin = imageDataItem->m_Data;
+      m_PixelSize = imageDataItem->GetPixelType().GetSize();
+      for(unsigned int i = 0; i < 4; ++i)
+      {
+        m_ItemDimensions[i] = std::max(imageDataItem->GetDimension(i), 1);
       }
 
-      // Case 2: ImageDataItem but no Subregion
-      if(imageDataItem && m_SubRegion == NULL)
+      // Case 1 and 2: No Subregion => whole ImageDataItem is accessed
+      if(m_SubRegion == NULL)
       {
         m_CoherentMemory = true;
 
         // Set memory area
         m_AddressBegin = imageDataItem->m_Data;
         m_AddressEnd   = (unsigned char*) m_AddressBegin + imageDataItem->m_Size;
+        return;
+      }
+
+      // Case 3 and 4: SubRegion of the ImageDataItem
+      itk::ImageRegion<4> itemRegion;
+      itk::Size<4> itemSize;
+      for(unsigned int i = 0; i < 4; ++i)
+      {
+        itemSize[i] = m_ItemDimensions[i];
       }
+      itemRegion.SetSize(itemSize);
 
-      // Case 3: No ImageDataItem but a SubRegion
-      if(imageDataItem == NULL && m_SubRegion)
+      if(m_SubRegion->GetNumberOfPixels() == 0 || !itemRegion.IsInside(*m_SubRegion))
       {
-          mitkThrow() << "Invalid ImageAccessor: The use of a SubRegion is not supported (yet).";
+        delete m_SubRegion;
+        m_SubRegion = NULL;
+        mitkThrow() << "Invalid ImageAccessor: The SubRegion " << *subRegion << " does not lie inside of the accessed image part.";
       }
 
-      // Case 4: ImageDataItem and SubRegion
-      if(imageDataItem == NULL && m_SubRegion)
+      // Memory span from the first to behind the last pixel of the SubRegion
+      itk::Index<4> first = m_SubRegion->GetIndex();
+      itk::Index<4> last = m_SubRegion->GetUpperIndex();
+      size_t firstOffset = 0;
+      size_t lastOffset = 0;
+      for(int i = 3; i >= 0; --i)
       {
-          mitkThrow() << "Invalid ImageAccessor: The use of a SubRegion is not supported (yet).";
+        firstOffset = firstOffset * m_ItemDimensions[i] + first[i];
+        lastOffset  = lastOffset  * m_ItemDimensions[i] + last[i];
       }
 
+      m_AddressBegin = (unsigned char*) m_ItemBegin + firstOffset * m_PixelSize;
+      m_AddressEnd   = (unsigned char*) m_ItemBegin + (lastOffset + 1) * m_PixelSize;
+
+      // Only a SubRegion that consists of whole lines, slices or volumes is represented by one coherent memory block
+      m_CoherentMemory = (lastOffset - firstOffset + 1 == m_SubRegion->GetNumberOfPixels());
+    }
+
+  itk::ImageRegion<4> mitk::ImageAccessorBase::GetRegionRelativeTo(const void* origin) const
+  {
+    unsigned int imageDimensions[4];
+    for(unsigned int i = 0; i < 4; ++i)
+    {
+      imageDimensions[i] = std::max(m_Image->GetDimension(i), 1u);
+    }
+
+    // ImageDataItems always start at a line, slice or volume of the image,
+    // so the offset of the item can be decomposed into an image index.
+    size_t offset = ((const unsigned char*) m_ItemBegin - (const unsigned char*) origin) / m_PixelSize;
+    itk::Index<4> itemIndex;
+    for(unsigned int i = 0; i < 4; ++i)
+    {
+      itemIndex[i] = offset % imageDimensions[i];
+      offset /= imageDimensions[i];
+    }
+
+    itk::ImageRegion<4> region;
+    if(m_SubRegion)
+    {
+      region = *m_SubRegion;
+    }
+    else
+    {
+      itk::Size<4> size;
+      for(unsigned int i = 0; i < 4; ++i)
+      {
+        size[i] = m_ItemDimensions[i];
+      }
+      region.SetSize(size);
     }
 
+    itk::Index<4> index = region.GetIndex();
+    for(unsigned int i = 0; i < 4; ++i)
+    {
+      index[i] += itemIndex[i];
+    }
+    region.SetIndex(index);
 
+    return region;
+  }
 
   /** \brief Computes if there is an Overlap of the image part between this instantiation and another ImageAccessor object
-    * \throws mitk::Exception if memory area is incoherent (not supported yet)
     */
   bool mitk::ImageAccessorBase::Overlap(const ImageAccessorBase* iAB)
   {
-    if(m_CoherentMemory)
+    // Disjoint memory areas never overlap
+    if(iAB->m_AddressEnd <= m_AddressBegin || m_AddressEnd <= iAB->m_AddressBegin)
+    {
+      return false;
+    }
+
+    if(m_SubRegion == NULL && iAB->m_SubRegion == NULL)
+    {
+      return true;
+    }
+
+    // Pixel-wise comparison is only possible within the same channel
+    if(m_Image.IsNull() || m_PixelSize != iAB->m_PixelSize)
+    {
+      return true;
+    }
+
+    const void* origin = std::min(m_ItemBegin, iAB->m_ItemBegin);
+    itk::ImageRegion<4> region = GetRegionRelativeTo(origin);
+    itk::ImageRegion<4> otherRegion = iAB->GetRegionRelativeTo(origin);
+
+    return region.Crop(otherRegion);
+  }
+
+  mitk::ImageAccessorBase* mitk::ImageAccessorBase::FindConflictingAccessor(bool writeAccess)
+  {
+    std::vector<ImageAccessorBase*>::iterator it;
+
+    // Write accesses exclude every other overlapping access
+    for(it = m_Image->m_Writers.begin(); it != m_Image->m_Writers.end(); ++it)
     {
-      if((iAB->m_AddressBegin >= m_AddressBegin && iAB->m_AddressBegin <  m_AddressEnd) ||
-         (iAB->m_AddressEnd   >  m_AddressBegin && iAB->m_AddressEnd   <= m_AddressEnd))
+      if(*it != this && Overlap(*it))
       {
-        return true;
+        return *it;
       }
-      if((m_AddressBegin >= iAB->m_AddressBegin && m_AddressBegin <  iAB->m_AddressEnd) ||
-         (m_AddressEnd   >  iAB->m_AddressBegin && m_AddressEnd   <= iAB->m_AddressEnd))
+    }
+
+    if(writeAccess)
+    {
+      for(it = m_Image->m_Readers.begin(); it != m_Image->m_Readers.end(); ++it)
       {
-        return true;
+        if(Overlap(*it))
+        {
+          return *it;
+        }
       }
+      return NULL;
+    }
 
+    // Read accesses yield to waiting write accesses. A thread which already holds an accessor of
+    // this image must not wait for a writer, since the writer might wait for that very accessor.
+    ThreadIDType id = CurrentThreadHandle();
+    for(it = m_Image->m_Readers.begin(); it != m_Image->m_Readers.end(); ++it)
+    {
+      if(CompareThreadHandles(id, (*it)->m_Thread))
+      {
+        return NULL;
+      }
     }
-    else {
-      m_Image->m_ReadWriteLock.Unlock();
-      mitkThrow() << "ImageAccessor: incoherent memory area is not supported yet";
+    for(it = m_Image->m_Writers.begin(); it != m_Image->m_Writers.end(); ++it)
+    {
+      if(CompareThreadHandles(id, (*it)->m_Thread))
+      {
+        return NULL;
+      }
+    }
+    for(it = m_Image->m_WaitingWriters.begin(); it != m_Image->m_WaitingWriters.end(); ++it)
+    {
+      if(Overlap(*it))
+      {
+        return *it;
+      }
     }
 
-    return false;
+    return NULL;
   }
 
-  /** \brief Uses the WaitLock to wait for another ImageAccessor*/
-  void mitk::ImageAccessorBase::WaitForReleaseOf(ImageAccessorWaitLock* wL) {
-    wL->m_Mutex.Lock();
+  void mitk::ImageAccessorBase::OrganizeAccess(bool writeAccess)
+  {
+    m_Image->m_ReadWriteLock.Lock();
 
-    // Decrement
-    wL->m_WaiterCount -= 1;
+    bool waited = false;
+    double waitStart = 0.0;
 
-    // If there are no more waiting ImageAccessors, delete the Mutex
-    // (Der Letzte macht das Licht aus!)
-    if(wL->m_WaiterCount <= 0)
+    while(ImageAccessorBase* conflict = FindConflictingAccessor(writeAccess))
     {
-      wL->m_Mutex.Unlock();
-      delete wL;
+      if(m_Options & ExceptionIfLocked)
+      {
+        ++m_Image->m_AccessorStatistics.RejectedAccesses;
+        m_Image->m_ReadWriteLock.Unlock();
+        mitkThrowException(mitk::MemoryIsLockedException) << "The image part being ordered by the ImageAccessor is already in use and locked";
+      }
+
+      if(!waited)
+      {
+        // Conflicts with accessors of the own thread can only be detected before waiting,
+        // afterwards the own thread cannot have acquired new accessors.
+        PreventRecursiveMutexLock(conflict);
+
+        waited = true;
+        waitStart = itksys::SystemTools::GetTime();
+        if(writeAccess)
+        {
+          m_Image->m_WaitingWriters.push_back(this);
+        }
+      }
+
+      // Releases m_ReadWriteLock while waiting, conflicts are checked again after each release
+      m_Image->m_AccessorReleased->Wait(&m_Image->m_ReadWriteLock);
+    }
+
+    if(waited)
+    {
+      double waitTime = itksys::SystemTools::GetTime() - waitStart;
+      if(writeAccess)
+      {
+        std::vector<ImageAccessorBase*>& waiting = m_Image->m_WaitingWriters;
+        waiting.erase(std::find(waiting.begin(), waiting.end(), this));
+        ++m_Image->m_AccessorStatistics.WaitingWriteAccesses;
+        m_Image->m_AccessorStatistics.WriteWaitTime += waitTime;
+
+        // Readers might have been held back by this writer only
+        m_Image->m_AccessorReleased->Broadcast();
+      }
+      else
+      {
+        ++m_Image->m_AccessorStatistics.WaitingReadAccesses;
+        m_Image->m_AccessorStatistics.ReadWaitTime += waitTime;
+      }
+    }
+
+    if(writeAccess)
+    {
+      m_Image->m_Writers.push_back(this);
+      ++m_Image->m_AccessorStatistics.WriteAccesses;
     }
     else
     {
-      wL->m_Mutex.Unlock();
+      m_Image->m_Readers.push_back(this);
+      ++m_Image->m_AccessorStatistics.ReadAccesses;
     }
+
+    m_Image->m_ReadWriteLock.Unlock();
+  }
+
+  void mitk::ImageAccessorBase::ReleaseAccess(bool writeAccess)
+  {
+    m_Image->m_ReadWriteLock.Lock();
+
+    std::vector<ImageAccessorBase*>& accessors = writeAccess ? m_Image->m_Writers : m_Image->m_Readers;
+    std::vector<ImageAccessorBase*>::iterator it = std::find(accessors.begin(), accessors.end(), this);
+    if(it != accessors.end())
+    {
+      accessors.erase(it);
+    }
+
+    // Wake up all waiting accessors, each of them checks again for conflicts
+    m_Image->m_AccessorReleased->Broadcast();
+
+    m_Image->m_ReadWriteLock.Unlock();
   }
 
   void mitk::ImageAccessorBase::PreventRecursiveMutexLock(mitk::ImageAccessorBase* iAB)
@@ -19,7 +19,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 #include <itkIndex.h>
 #include <itkImageRegion.h>
-#include <itkSimpleFastMutexLock.h>
+#include <itkSimpleMutexLock.h>
 #include <itkSmartPointer.h>
 #include <itkMultiThreader.h>
 
@@ -35,13 +35,30 @@ namespace mitk {
 class Image;
 typedef itk::SmartPointer<mitk::Image> ImagePointer;
 
-/** \brief This struct allows to make ImageAccessors wait for this particular ImageAccessor object*/
-struct ImageAccessorWaitLock {
-  /** \brief Holds the number of ImageAccessors, which are waiting until the represented ImageAccessor is released. */
-  unsigned int m_WaiterCount;
+/** \brief Counters that show how often image accessors of an image had to wait for each other.
+  * \sa Image::GetAccessorStatistics()
+  */
+struct ImageAccessorStatistics {
+  ImageAccessorStatistics()
+    : ReadAccesses(0), WriteAccesses(0), WaitingReadAccesses(0), WaitingWriteAccesses(0),
+      ReadWaitTime(0.0), WriteWaitTime(0.0), RejectedAccesses(0)
+  {
+  }
 
-  /** \brief A mutex that allows other ImageAccessors to wait for the represented ImageAccessor. */
-  itk::SimpleFastMutexLock m_Mutex;
+  /** \brief Number of granted read accesses */
+  unsigned long ReadAccesses;
+  /** \brief Number of granted write accesses */
+  unsigned long WriteAccesses;
+  /** \brief Number of read accesses that had to wait for a conflicting write access */
+  unsigned long WaitingReadAccesses;
+  /** \brief Number of write accesses that had to wait for a conflicting read or write access */
+  unsigned long WaitingWriteAccesses;
+  /** \brief Accumulated time in seconds that read accesses spent waiting */
+  double ReadWaitTime;
+  /** \brief Accumulated time in seconds that write accesses spent waiting */
+  double WriteWaitTime;
+  /** \brief Number of accesses that threw a MemoryIsLockedException because of mitk::ImageAccessorBase::ExceptionIfLocked */
+  unsigned long RejectedAccesses;
 };
 
 // Defs to assure dead lock prevention only in case of possible thread handling.
@@ -77,6 +94,7 @@ public:
 
   virtual ~ImageAccessorBase()
   {
+    delete m_SubRegion;
   }
 
 protected:
@@ -94,11 +112,15 @@ typedef DWORD ThreadIDType;
 typedef pthread_t ThreadIDType;
 #endif
 
-  /** \brief Checks validity of given parameters from inheriting classes and stores those parameters in member variables. */
+  /** \brief Checks validity of given parameters from inheriting classes and stores those parameters in member variables.
+    * \param subRegion restricts the access to a region of the ImageDataItem (in index coordinates of the ImageDataItem, always 4D)
+    * \throws mitk::Exception if subRegion does not lie inside of the ImageDataItem
+    */
   ImageAccessorBase(
       ImagePointer iP,
       ImageDataItem* iDI = NULL,
-      int OptionFlags = DefaultBehavior
+      int OptionFlags = DefaultBehavior,
+      const itk::ImageRegion<4>* subRegion = NULL
     );
 
   /** ImageAccessor has access to the image it belongs to. */
@@ -121,22 +143,35 @@ typedef pthread_t ThreadIDType;
   /** Defines if the accessed image part lies coherently in memory */
   bool m_CoherentMemory;
 
-  /** \brief Pointer to a WaitLock struct, that allows other ImageAccessors to wait for this ImageAccessor */
-  ImageAccessorWaitLock* m_WaitLock;
+  /** Points to the beginning of the accessed ImageDataItem, which is m_AddressBegin unless a SubRegion is accessed. */
+  void* m_ItemBegin;
 
-  /** \brief Increments m_WaiterCount. A call of this method is prohibited unless the Mutex m_ReadWriteLock in the mitk::Image class is Locked. */
-  inline void Increment()
-  {
-    m_WaitLock->m_WaiterCount += 1;
-  }
+  /** Dimensions of the accessed ImageDataItem, unused dimensions are 1. */
+  unsigned int m_ItemDimensions[4];
+
+  /** Size of a pixel of the accessed ImageDataItem in bytes. */
+  size_t m_PixelSize;
 
   /** \brief Computes if there is an Overlap of the image part between this instantiation and another ImageAccessor object
-    * \throws mitk::Exception if memory area is incoherent (not supported yet)
+    *
+    * Accessors of disjoint memory never overlap. Otherwise, if one of them is restricted to a SubRegion,
+    * the regions of both accessors are compared pixel-wise, so that accessors of different parts of the
+    * same volume do not block each other.
     */
   bool Overlap(const ImageAccessorBase* iAB);
 
-  /** \brief Uses the WaitLock to wait for another ImageAccessor*/
-  void WaitForReleaseOf(ImageAccessorWaitLock* wL);
+  /** \brief Registers this accessor at the image as reader or writer.
+    *
+    * Read accesses are shared, write accesses are exclusive with respect to overlapping accessors. If a
+    * conflicting accessor exists, the calling thread waits until it is released or, if ExceptionIfLocked
+    * is set, a MemoryIsLockedException is thrown. New read accesses also wait for overlapping write
+    * accesses that are already waiting, so that writers are not starved by a constant stream of readers.
+    * \throws mitk::MemoryIsLockedException
+    */
+  void OrganizeAccess(bool writeAccess);
+
+  /** \brief Unregisters this accessor from the image and wakes up waiting accessors. */
+  void ReleaseAccess(bool writeAccess);
 
   ThreadIDType m_Thread;
 
@@ -146,6 +181,12 @@ typedef pthread_t ThreadIDType;
 
 private:
 
+  /** \brief Returns the accessed region in index coordinates of an image whose data starts at origin. */
+  itk::ImageRegion<4> GetRegionRelativeTo(const void* origin) const;
+
+  /** \brief Returns an accessor that prevents this accessor from being granted, or NULL. m_ReadWriteLock of the image must be locked. */
+  ImageAccessorBase* FindConflictingAccessor(bool writeAccess);
+
   /** \brief System dependend thread method, to prevent recursive mutex access */
   ThreadIDType CurrentThreadHandle();
   /** \brief System dependend thread method, to prevent recursive mutex access */
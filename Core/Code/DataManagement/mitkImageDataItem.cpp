@@ -17,6 +17,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 #include "mitkImageDataItem.h"
 #include "mitkMemoryUtilities.h"
+#include "mitkException.h"
 #include <vtkImageData.h>
 #include <vtkPointData.h>
 
@@ -101,6 +102,32 @@ mitk::ImageDataItem::ImageDataItem(const mitk::ImageDescriptor::Pointer desc, vo
 
 }
 
+mitk::ImageDataItem::ImageDataItem(const mitk::ImageDescriptor::Pointer desc, MemoryMappedFile* mappedFile)
+  : m_Data(NULL), m_ManageMemory(false), m_VtkImageData(NULL), m_Offset(0), m_IsComplete(false), m_Size(0),
+    m_MappedFile(mappedFile)
+{
+  m_PixelType = new mitk::PixelType(desc->GetChannelDescriptor(0).GetPixelType());
+
+  // compute size
+  const unsigned int *dimensions = desc->GetDimensions();
+
+  m_Dimension = desc->GetNumberOfDimensions();
+  for( unsigned int i=0; i<m_Dimension; i++)
+    m_Dimensions[i] = dimensions[i];
+
+  this->ComputeItemSize(m_Dimensions, m_Dimension );
+
+  if(m_MappedFile.IsNull() || m_MappedFile->GetSize() < m_Size)
+    mitkThrow() << "ImageDataItem: memory mapped file is too small for the image data";
+
+  // the mapping is released by m_MappedFile, so the memory is not managed by this item
+  m_Data = static_cast<unsigned char*>(m_MappedFile->GetData());
+
+  m_ReferenceCountLock.Lock();
+  m_ReferenceCount = 0;
+  m_ReferenceCountLock.Unlock();
+}
+
 mitk::ImageDataItem::ImageDataItem(const mitk::PixelType& type, unsigned int dimension, unsigned int *dimensions, void *data, bool manageMemory) :
   m_Data((unsigned char*)data), m_ManageMemory(manageMemory), m_VtkImageData(NULL), m_Offset(0), m_IsComplete(false), m_Size(0),
   m_Parent(NULL)
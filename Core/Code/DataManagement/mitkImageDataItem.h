@@ -23,6 +23,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 //#include <mitkIpPic.h>
 //#include "mitkPixelType.h"
 #include "mitkImageDescriptor.h"
+#include "mitkMemoryMappedFile.h"
 //#include "mitkImageVtkAccessor.h"
 
 class vtkImageData;
@@ -79,6 +80,13 @@ namespace mitk {
 
     ImageDataItem(const ImageDataItem &other);
 
+    //##Documentation
+    //## @brief Creates an item whose data is the memory mapped file @a mappedFile
+    //##
+    //## The item keeps a reference to the mapping, so it stays valid as long as the item
+    //## or any of its sub-items (volumes, slices) exist.
+    ImageDataItem(const mitk::ImageDescriptor::Pointer desc, MemoryMappedFile* mappedFile);
+
    /**
    \deprecatedSince{2012_09} Please use image accessors instead: See Doxygen/Related-Pages/Concepts/Image. This method can be replaced by ImageWriteAccessor::GetData() or ImageReadAccessor::GetData() */
     DEPRECATED(void* GetData() const)
@@ -142,6 +150,13 @@ namespace mitk {
 
     virtual void ConstructVtkImageData(ImagePointer) const;
 
+    //##Documentation
+    //## @brief Returns true, if the data of this item (or of its parent) is a memory mapped file
+    bool IsMemoryMapped() const
+    {
+      return m_MappedFile.IsNotNull() || (m_Parent.IsNotNull() && m_Parent->IsMemoryMapped());
+    }
+
     unsigned long GetSize() const
     {
       return m_Size;
@@ -167,6 +182,7 @@ namespace mitk {
     void ComputeItemSize( const unsigned int* dimensions, unsigned int dimension);
 
     ImageDataItem::ConstPointer m_Parent;
+    MemoryMappedFile::Pointer m_MappedFile;
 
     unsigned int m_Dimension;
 
@@ -54,10 +54,33 @@ public:
       ) :
     ImageAccessorBase(iP,iDI,OptionFlags)
   {
-    OrganizeReadAccess();
+    OrganizeAccess(false);
   }
 
-  /** \brief Gives const access to the data. */
+  /** \brief Orders read access for a region of a slice, volume or 4D-Image
+     *  Only write accesses that overlap with subRegion block this access.
+     *  \param Image::Pointer specifies the associated Image
+     *  \param subRegion specifies the accessed region in index coordinates of the image part
+     *  \param ImageDataItem* specifies the allocated image part
+     *  \param OptionFlags properties from mitk::ImageAccessorBase::Options can be chosen and assembled with bitwise unification.
+     *  \throws mitk::Exception if subRegion does not lie inside of the image part
+     *  \throws mitk::MemoryIsLockedException if requested image area is exclusively locked and mitk::ImageAccessorBase::ExceptionIfLocked is set in OptionFlags
+     */
+  ImageReadAccessor(
+      ImagePointer iP,
+      const itk::ImageRegion<4>& subRegion,
+      ImageDataItem* iDI = NULL,
+      int OptionFlags = ImageAccessorBase::DefaultBehavior
+      ) :
+    ImageAccessorBase(iP,iDI,OptionFlags,&subRegion)
+  {
+    OrganizeAccess(false);
+  }
+
+  /** \brief Gives const access to the data.
+    * For a SubRegion, this points to its first pixel; pixels outside of the
+    * SubRegion may lie between m_AddressBegin and m_AddressEnd unless the memory is coherent.
+    */
   inline const void * GetData()
   {
     return m_AddressBegin;
@@ -67,88 +90,13 @@ public:
   virtual ~ImageReadAccessor()
   {
     // Future work: In case of non-coherent memory, copied area needs to be deleted
-
-    m_Image->m_ReadWriteLock.Lock();
-
-    // delete self from list of ImageReadAccessors in Image
-    std::vector<ImageAccessorBase*>::iterator it = std::find(m_Image->m_Readers.begin(),m_Image->m_Readers.end(),this);
-    m_Image->m_Readers.erase(it);
-
-    // delete lock, if there are no waiting ImageAccessors
-    if(m_WaitLock->m_WaiterCount <= 0)
-    {
-      m_WaitLock->m_Mutex.Unlock();
-      delete m_WaitLock;
-    }
-    else
-    {
-      m_WaitLock->m_Mutex.Unlock();
-    }
-
-    m_Image->m_ReadWriteLock.Unlock();
+    ReleaseAccess(false);
   }
 
 protected:
 
   // protected members
 
-private:
-
-  /** \brief manages a consistent read access and locks the ordered image part */
-  void OrganizeReadAccess()
-  {
-    m_Image->m_ReadWriteLock.Lock();
-
-    // Check, if there is any Write-Access going on
-    if(m_Image->m_Writers.size() > 0)
-    {
-      // Check for every WriteAccessors, if the Region of this ImageAccessors overlaps
-      // make sure this iterator is not used, when m_ReadWriteLock is Unlocked!
-      std::vector<ImageAccessorBase*>::iterator it = m_Image->m_Writers.begin();
-
-      for(; it!=m_Image->m_Writers.end(); ++it)
-      {
-        ImageAccessorBase* w = *it;
-        if( Overlap(w) )
-        {
-          // An Overlap was detected. There are two possibilities to deal with this situation:
-          // Throw an exception or wait for the WriteAccessor w until it is released and start again with the request afterwards.
-          if(!(m_Options & ExceptionIfLocked))
-          {
-            PreventRecursiveMutexLock(w);
-
-            // WAIT
-            w->Increment();
-            m_Image->m_ReadWriteLock.Unlock();
-            ImageAccessorBase::WaitForReleaseOf(w->m_WaitLock);
-
-            //after waiting for the WriteAccessor w, start this method again
-            OrganizeReadAccess();
-            return;
-          }
-          else
-          {
-            // THROW EXCEPTION
-            m_Image->m_ReadWriteLock.Unlock();
-            mitkThrowException(mitk::MemoryIsLockedException) << "The image part being ordered by the ImageAccessor is already in use and locked";
-            return;
-          }
-        } // if
-      } // for
-    } // if
-
-    // Now, we know, that there is no conflict with a Write-Access
-    // Lock the Mutex in ImageAccessorBase, to make sure that every other ImageAccessor has to wait if it locks the mutex
-    m_WaitLock->m_Mutex.Lock();
-
-    // insert self into readers list in Image
-    m_Image->m_Readers.push_back(this);
-
-    //printf("ReadAccess %d %d\n",(int) m_Image->m_Readers.size(),(int) m_Image->m_Writers.size());
-    //fflush(0);
-    m_Image->m_ReadWriteLock.Unlock();
-  }
-
 };
 
 }
@@ -19,7 +19,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 //#include "mitkImageTimeSelector.h"
 
 mitk::ImageStatisticsHolder::ImageStatisticsHolder( mitk::Image* image)
-  : m_Image(image)/*, m_TimeSelectorForExtremaObject(NULL)*/
+  : m_Image(image)/*, m_TimeSelectorForExtremaObject(NULL)*/, m_ComputeAllTimeStepsAtOnce(false)
 {
   m_CountOfMinValuedVoxels.resize(1, 0);
   m_CountOfMaxValuedVoxels.resize(1, 0);
@@ -193,6 +193,232 @@ void mitk::_ComputeExtremaInItkImage( const ItkImageType* itkImage, mitk::ImageS
   //MITK_DEBUG <<"extrema "<<itk::NumericTraits<TPixel>::NonpositiveMin()<<" "<<mitkImage->m_ScalarMin<<" "<<mitkImage->m_Scalar2ndMin<<" "<<mitkImage->m_Scalar2ndMax<<" "<<mitkImage->m_ScalarMax<<" "<<itk::NumericTraits<TPixel>::max();
 }
 
+namespace
+{
+  // extrema of a part of the image buffer, already converted to ScalarType
+  struct ExtremaPartialResult
+  {
+    ExtremaPartialResult()
+      : Min(itk::NumericTraits<mitk::ScalarType>::max()), SecondMin(itk::NumericTraits<mitk::ScalarType>::max()),
+        Max(itk::NumericTraits<mitk::ScalarType>::NonpositiveMin()), SecondMax(itk::NumericTraits<mitk::ScalarType>::NonpositiveMin()),
+        CountOfMin(0), CountOfMax(0)
+    {
+    }
+
+    mitk::ScalarType Min;
+    mitk::ScalarType SecondMin;
+    mitk::ScalarType Max;
+    mitk::ScalarType SecondMax;
+    unsigned int CountOfMin;
+    unsigned int CountOfMax;
+  };
+
+  struct ExtremaThreadStruct
+  {
+    const void* Data;
+    int ComponentType;
+    size_t VoxelsPerTimeStep;
+    unsigned int NumberOfTimeSteps;
+    unsigned int NumberOfChunks;
+    // NumberOfChunks results per time step
+    std::vector<ExtremaPartialResult> Results;
+  };
+
+  // Two passes over [begin, end): the first one finds min/max, the second one counts them and finds
+  // the second smallest/largest values. Both loops are free of data dependent branches so that the
+  // compiler can vectorize them.
+  template <typename TPixel>
+  void ComputeExtremaInRange(const TPixel* begin, const TPixel* end, ExtremaPartialResult& result)
+  {
+    if (begin == end)
+      return;
+
+    // every comparison with NaN is false, so NaN voxels neither replace the seeds nor are counted, like in
+    // _ComputeExtremaInItkImage(); a range of NaN voxels only yields counts of 0 and is skipped by MergeExtrema()
+    TPixel minValue = itk::NumericTraits<TPixel>::max();
+    TPixel maxValue = itk::NumericTraits<TPixel>::NonpositiveMin();
+    for (const TPixel* p = begin; p != end; ++p)
+    {
+      const TPixel value = *p;
+      minValue = value < minValue ? value : minValue;
+      maxValue = value > maxValue ? value : maxValue;
+    }
+
+    // as long as min != max, max is a valid candidate for the second smallest value and vice versa
+    TPixel secondMinValue = maxValue;
+    TPixel secondMaxValue = minValue;
+    unsigned int countOfMin = 0;
+    unsigned int countOfMax = 0;
+    for (const TPixel* p = begin; p != end; ++p)
+    {
+      const TPixel value = *p;
+      countOfMin += (value == minValue);
+      countOfMax += (value == maxValue);
+      const TPixel aboveMin = value > minValue ? value : maxValue;
+      const TPixel belowMax = value < maxValue ? value : minValue;
+      secondMinValue = aboveMin < secondMinValue ? aboveMin : secondMinValue;
+      secondMaxValue = belowMax > secondMaxValue ? belowMax : secondMaxValue;
+    }
+
+    if (countOfMin == 0)
+      return;
+
+    result.Min = minValue;
+    result.Max = maxValue;
+    result.CountOfMin = countOfMin;
+    result.CountOfMax = countOfMax;
+    if (minValue != maxValue)
+    {
+      result.SecondMin = secondMinValue;
+      result.SecondMax = secondMaxValue;
+    }
+  }
+
+  // merges the partial result of another part of the same time step into result
+  void MergeExtrema(ExtremaPartialResult& result, const ExtremaPartialResult& other)
+  {
+    if (other.CountOfMin == 0)
+      return;
+
+    if (other.Min < result.Min)
+    {
+      result.SecondMin = std::min(result.Min, other.SecondMin);
+      result.Min = other.Min;
+      result.CountOfMin = other.CountOfMin;
+    }
+    else if (other.Min == result.Min)
+    {
+      result.SecondMin = std::min(result.SecondMin, other.SecondMin);
+      result.CountOfMin += other.CountOfMin;
+    }
+    else
+    {
+      result.SecondMin = std::min(result.SecondMin, other.Min);
+    }
+
+    if (other.Max > result.Max)
+    {
+      result.SecondMax = std::max(result.Max, other.SecondMax);
+      result.Max = other.Max;
+      result.CountOfMax = other.CountOfMax;
+    }
+    else if (other.Max == result.Max)
+    {
+      result.SecondMax = std::max(result.SecondMax, other.SecondMax);
+      result.CountOfMax += other.CountOfMax;
+    }
+    else
+    {
+      result.SecondMax = std::max(result.SecondMax, other.Max);
+    }
+  }
+
+  template <typename TPixel>
+  void ComputeExtremaOfChunk(ExtremaThreadStruct* str, unsigned int chunk)
+  {
+    const size_t chunkBegin = str->VoxelsPerTimeStep * chunk / str->NumberOfChunks;
+    const size_t chunkEnd = str->VoxelsPerTimeStep * (chunk + 1) / str->NumberOfChunks;
+    for (unsigned int t = 0; t < str->NumberOfTimeSteps; ++t)
+    {
+      const TPixel* timeStepBegin = static_cast<const TPixel*>(str->Data) + t * str->VoxelsPerTimeStep;
+      ComputeExtremaInRange(timeStepBegin + chunkBegin, timeStepBegin + chunkEnd, str->Results[t * str->NumberOfChunks + chunk]);
+    }
+  }
+
+  ITK_THREAD_RETURN_TYPE ExtremaThreaderCallback(void* arg)
+  {
+    itk::MultiThreader::ThreadInfoStruct* info = static_cast<itk::MultiThreader::ThreadInfoStruct*>(arg);
+    ExtremaThreadStruct* str = static_cast<ExtremaThreadStruct*>(info->UserData);
+    const unsigned int chunk = info->ThreadID;
+    if (chunk >= str->NumberOfChunks)
+      return ITK_THREAD_RETURN_VALUE;
+
+    switch (str->ComponentType)
+    {
+    case itk::ImageIOBase::CHAR:   ComputeExtremaOfChunk<char>(str, chunk); break;
+    case itk::ImageIOBase::UCHAR:  ComputeExtremaOfChunk<unsigned char>(str, chunk); break;
+    case itk::ImageIOBase::SHORT:  ComputeExtremaOfChunk<short>(str, chunk); break;
+    case itk::ImageIOBase::USHORT: ComputeExtremaOfChunk<unsigned short>(str, chunk); break;
+    case itk::ImageIOBase::INT:    ComputeExtremaOfChunk<int>(str, chunk); break;
+    case itk::ImageIOBase::UINT:   ComputeExtremaOfChunk<unsigned int>(str, chunk); break;
+    case itk::ImageIOBase::LONG:   ComputeExtremaOfChunk<long>(str, chunk); break;
+    case itk::ImageIOBase::ULONG:  ComputeExtremaOfChunk<unsigned long>(str, chunk); break;
+    case itk::ImageIOBase::FLOAT:  ComputeExtremaOfChunk<float>(str, chunk); break;
+    case itk::ImageIOBase::DOUBLE: ComputeExtremaOfChunk<double>(str, chunk); break;
+    default: break;
+    }
+    return ITK_THREAD_RETURN_VALUE;
+  }
+
+  bool IsSupportedExtremaComponentType(int componentType)
+  {
+    switch (componentType)
+    {
+    case itk::ImageIOBase::CHAR:
+    case itk::ImageIOBase::UCHAR:
+    case itk::ImageIOBase::SHORT:
+    case itk::ImageIOBase::USHORT:
+    case itk::ImageIOBase::INT:
+    case itk::ImageIOBase::UINT:
+    case itk::ImageIOBase::LONG:
+    case itk::ImageIOBase::ULONG:
+    case itk::ImageIOBase::FLOAT:
+    case itk::ImageIOBase::DOUBLE:
+      return true;
+    default:
+      return false;
+    }
+  }
+}
+
+bool mitk::ImageStatisticsHolder::ComputeExtremaInBuffer(const void* data, unsigned int firstTimeStep, unsigned int numberOfTimeSteps)
+{
+  const mitk::PixelType pType = m_Image->GetPixelType(0);
+  if (data == NULL || pType.GetNumberOfComponents() != 1 || !IsSupportedExtremaComponentType(pType.GetComponentType()))
+    return false;
+
+  ExtremaThreadStruct str;
+  str.Data = data;
+  str.ComponentType = pType.GetComponentType();
+  str.VoxelsPerTimeStep = static_cast<size_t>(m_Image->GetDimension(0)) * m_Image->GetDimension(1) * m_Image->GetDimension(2);
+  str.NumberOfTimeSteps = numberOfTimeSteps;
+
+  // do not bother starting threads for small images
+  const size_t minimumVoxelsPerChunk = 1 << 16;
+  itk::MultiThreader::Pointer threader = itk::MultiThreader::New();
+  const size_t maximumNumberOfChunks = std::max<size_t>(1, str.VoxelsPerTimeStep / minimumVoxelsPerChunk);
+  str.NumberOfChunks = static_cast<unsigned int>(std::min<size_t>(threader->GetNumberOfThreads(), maximumNumberOfChunks));
+  str.Results.resize(str.NumberOfTimeSteps * str.NumberOfChunks);
+
+  threader->SetNumberOfThreads(str.NumberOfChunks);
+  threader->SetSingleMethod(ExtremaThreaderCallback, &str);
+  threader->SingleMethodExecute();
+
+  Expand(firstTimeStep + numberOfTimeSteps); // make sure we have initialized all arrays
+  for (unsigned int i = 0; i < numberOfTimeSteps; ++i)
+  {
+    ExtremaPartialResult result;
+    for (unsigned int chunk = 0; chunk < str.NumberOfChunks; ++chunk)
+      MergeExtrema(result, str.Results[i * str.NumberOfChunks + chunk]);
+
+    //// guard for wrong 2dMin/Max on single constant value images
+    if (result.Max == result.Min)
+    {
+      result.SecondMax = result.SecondMin = result.Max;
+    }
+
+    const unsigned int t = firstTimeStep + i;
+    m_ScalarMin[t] = result.Min;
+    m_Scalar2ndMin[t] = result.SecondMin;
+    m_ScalarMax[t] = result.Max;
+    m_Scalar2ndMax[t] = result.SecondMax;
+    m_CountOfMinValuedVoxels[t] = result.CountOfMin;
+    m_CountOfMaxValuedVoxels[t] = result.CountOfMax;
+  }
+  m_LastRecomputeTimeStamp.Modified();
+  return true;
+}
+
 void mitk::ImageStatisticsHolder::ComputeImageStatistics(int t)
 {
   // timestep valid?
@@ -211,7 +437,21 @@ void mitk::ImageStatisticsHolder::ComputeImageStatistics(int t)
   const mitk::PixelType pType = m_Image->GetPixelType(0);
   if(pType.GetNumberOfComponents() == 1)
   {
-    // recompute
+    // recompute directly on the image buffer, if possible
+    if(m_ComputeAllTimeStepsAtOnce && m_Image->GetTimeSteps() > 1)
+    {
+      mitk::ImageReadAccessor accessor(m_Image);
+      if(this->ComputeExtremaInBuffer(accessor.GetData(), 0, m_Image->GetTimeSteps()))
+        return;
+    }
+    else if(m_Image->IsVolumeSet(t))
+    {
+      mitk::ImageReadAccessor accessor(m_Image, m_Image->GetVolumeData(t));
+      if(this->ComputeExtremaInBuffer(accessor.GetData(), t, 1))
+        return;
+    }
+
+    // recompute via ITK for unsupported pixel types or data that still has to be generated
     mitk::ImageTimeSelector::Pointer timeSelector = this->GetTimeSelector();
     if(timeSelector.IsNotNull())
     {
@@ -129,6 +129,22 @@ public:
 
     bool IsValidTimeStep( int t) const;
 
+    //##Documentation
+    //## \brief Compute the extrema of all time steps at once when the extrema of one time step are requested
+    //##
+    //## The image buffer is then traversed in a single multithreaded pass instead of one pass per
+    //## time step, which is faster for 4D images whose time steps are all displayed anyway.
+    //## Default is false.
+    void SetComputeAllTimeStepsAtOnce(bool allTimeSteps)
+    {
+      m_ComputeAllTimeStepsAtOnce = allTimeSteps;
+    }
+
+    bool GetComputeAllTimeStepsAtOnce() const
+    {
+      return m_ComputeAllTimeStepsAtOnce;
+    }
+
     template < typename ItkImageType >
       friend void _ComputeExtremaInItkImage( const ItkImageType* itkImage, mitk::ImageStatisticsHolder* statisticsHolder, int t);
 
@@ -142,6 +158,14 @@ protected:
 
       ImageTimeSelector::Pointer GetTimeSelector();
 
+      //##Documentation
+      //## \brief Computes the extrema of consecutive time steps directly on the image buffer
+      //##
+      //## data has to point to the first voxel of time step firstTimeStep. The voxels of each time step
+      //## are split into one chunk per thread, the partial results of the chunks are merged afterwards.
+      //## Returns false if the pixel type is not supported, in this case nothing is computed.
+      virtual bool ComputeExtremaInBuffer(const void* data, unsigned int firstTimeStep, unsigned int numberOfTimeSteps);
+
       mitk::Image* m_Image;
 
       mutable itk::Object::Pointer m_HistogramGeneratorObject;
@@ -156,6 +180,8 @@ protected:
 
       itk::TimeStamp m_LastRecomputeTimeStamp;
 
+      bool m_ComputeAllTimeStepsAtOnce;
+
 };
 
 } //end namespace
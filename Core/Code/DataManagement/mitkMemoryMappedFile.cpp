@@ -0,0 +1,111 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkMemoryMappedFile.h"
+#include "mitkException.h"
+
+#include <itksys/SystemTools.hxx>
+
+#if _MSC_VER || __MINGW32__
+  #include <windows.h>
+#else
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <fcntl.h>
+  #include <unistd.h>
+#endif
+
+
+size_t mitk::MemoryMappedFile::GetFileSize(const std::string& fileName)
+{
+  if (!itksys::SystemTools::FileExists(fileName.c_str(), true))
+    return 0;
+  return static_cast<size_t>(itksys::SystemTools::FileLength(fileName.c_str()));
+}
+
+
+mitk::MemoryMappedFile::MemoryMappedFile(const std::string& fileName, size_t offset, size_t length)
+  : m_FileName(fileName), m_MappingBegin(NULL), m_MappingSize(0), m_Data(NULL), m_Size(length)
+#if _MSC_VER || __MINGW32__
+  , m_FileHandle(NULL), m_MappingHandle(NULL)
+#endif
+{
+  if (length == 0)
+    mitkThrow() << "Cannot map an empty region of file " << fileName;
+
+  if (GetFileSize(fileName) < offset + length)
+    mitkThrow() << "File " << fileName << " is too small to map " << length << " bytes at offset " << offset;
+
+#if _MSC_VER || __MINGW32__
+  SYSTEM_INFO systemInfo;
+  GetSystemInfo(&systemInfo);
+  const size_t alignedOffset = offset - (offset % systemInfo.dwAllocationGranularity);
+  m_MappingSize = length + (offset - alignedOffset);
+
+  HANDLE file = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, NULL);
+  if (file == INVALID_HANDLE_VALUE)
+    mitkThrow() << "Could not open file " << fileName << " for memory mapping";
+  m_FileHandle = file;
+
+  HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+  if (mapping == NULL)
+  {
+    CloseHandle(file);
+    mitkThrow() << "Could not create file mapping for " << fileName;
+  }
+  m_MappingHandle = mapping;
+
+  const unsigned long long alignedOffset64 = alignedOffset;
+  m_MappingBegin = MapViewOfFile(mapping, FILE_MAP_COPY,
+    static_cast<DWORD>(alignedOffset64 >> 32), static_cast<DWORD>(alignedOffset64 & 0xFFFFFFFF), m_MappingSize);
+  if (m_MappingBegin == NULL)
+  {
+    CloseHandle(mapping);
+    CloseHandle(file);
+    mitkThrow() << "Could not map " << length << " bytes of file " << fileName;
+  }
+#else
+  const size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  const size_t alignedOffset = offset - (offset % pageSize);
+  m_MappingSize = length + (offset - alignedOffset);
+
+  int file = open(fileName.c_str(), O_RDONLY);
+  if (file < 0)
+    mitkThrow() << "Could not open file " << fileName << " for memory mapping";
+
+  // a private mapping may be written to, modified pages are copied and never written back
+  void* mapping = mmap(NULL, m_MappingSize, PROT_READ | PROT_WRITE, MAP_PRIVATE, file, static_cast<off_t>(alignedOffset));
+  // the mapping stays valid after the file descriptor has been closed
+  close(file);
+  if (mapping == MAP_FAILED)
+    mitkThrow() << "Could not map " << length << " bytes of file " << fileName;
+  m_MappingBegin = mapping;
+#endif
+
+  m_Data = static_cast<unsigned char*>(m_MappingBegin) + (offset - alignedOffset);
+}
+
+
+mitk::MemoryMappedFile::~MemoryMappedFile()
+{
+#if _MSC_VER || __MINGW32__
+  UnmapViewOfFile(m_MappingBegin);
+  CloseHandle(static_cast<HANDLE>(m_MappingHandle));
+  CloseHandle(static_cast<HANDLE>(m_FileHandle));
+#else
+  munmap(m_MappingBegin, m_MappingSize);
+#endif
+}
@@ -0,0 +1,95 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#ifndef MITKMEMORYMAPPEDFILE_H_HEADER_INCLUDED
+#define MITKMEMORYMAPPEDFILE_H_HEADER_INCLUDED
+
+#include <MitkExports.h>
+#include "mitkCommon.h"
+
+#include <itkLightObject.h>
+
+namespace mitk
+{
+  //##Documentation
+  //## @brief Maps a part of a file into the address space of the process
+  //##
+  //## The mapping is private (copy-on-write): pages are read from the file when they
+  //## are touched for the first time and modifications are never written back to the file.
+  //## Only modified pages occupy memory of their own, untouched pages can be discarded by the
+  //## operating system at any time. This allows to work on files that are larger than the
+  //## physical memory.
+  //##
+  //## Used by ImageDataItem as an out-of-core backing store, see Image::SetMemoryMappedChannel().
+  //##
+  //## @ingroup Data
+  class MITK_CORE_EXPORT MemoryMappedFile : public itk::LightObject
+  {
+  public:
+    mitkClassMacro(MemoryMappedFile, itk::LightObject);
+
+    //##Documentation
+    //## @brief Maps @a length bytes of file @a fileName, starting at byte @a offset
+    //##
+    //## @throws mitk::Exception if the file cannot be opened, is too small or cannot be mapped
+    mitkNewMacro3Param(MemoryMappedFile, const std::string&, size_t, size_t);
+
+    //##Documentation
+    //## @brief Returns the address of the byte at @a offset in the file
+    void* GetData() const
+    {
+      return m_Data;
+    }
+
+    //##Documentation
+    //## @brief Returns the number of mapped bytes
+    size_t GetSize() const
+    {
+      return m_Size;
+    }
+
+    const std::string& GetFileName() const
+    {
+      return m_FileName;
+    }
+
+    //##Documentation
+    //## @brief Returns the size of the file @a fileName in bytes, or 0 if it cannot be accessed
+    static size_t GetFileSize(const std::string& fileName);
+
+  protected:
+    MemoryMappedFile(const std::string& fileName, size_t offset, size_t length);
+    virtual ~MemoryMappedFile();
+
+  private:
+    // not implemented
+    MemoryMappedFile(const MemoryMappedFile&);
+    MemoryMappedFile& operator=(const MemoryMappedFile&);
+
+    std::string m_FileName;
+    // m_Data lies within the mapping, which has to start at a multiple of the allocation granularity
+    void* m_MappingBegin;
+    size_t m_MappingSize;
+    void* m_Data;
+    size_t m_Size;
+#if _MSC_VER || __MINGW32__
+    void* m_FileHandle;
+    void* m_MappingHandle;
+#endif
+  };
+} // namespace mitk
+
+#endif /* MITKMEMORYMAPPEDFILE_H_HEADER_INCLUDED */
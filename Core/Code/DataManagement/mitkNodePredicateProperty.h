@@ -46,6 +46,20 @@ namespace mitk {
       //## @brief Checks, if the nodes contains a property that is equal to m_ValidProperty
       virtual bool CheckNode(const mitk::DataNode* node) const;
 
+      //##Documentation
+      //## @brief Returns the name of the property that is checked
+      const std::string& GetValidPropertyName() const
+      {
+        return m_ValidPropertyName;
+      }
+
+      //##Documentation
+      //## @brief Returns the property value that is checked for, or NULL if only existence is checked
+      const mitk::BaseProperty* GetValidProperty() const
+      {
+        return m_ValidProperty.GetPointer();
+      }
+
     protected:
       //##Documentation
       //## @brief Constructor to check for a named property
@@ -28,6 +28,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 mitk::StandaloneDataStorage::StandaloneDataStorage()
 : mitk::DataStorage()
 {
+  m_PropertyIndex["name"];
 }
 
 
@@ -87,6 +88,9 @@ void mitk::StandaloneDataStorage::Add(mitk::DataNode* node, const mitk::DataStor
       deob->InsertElement(deob->Size(), node); // node is derived from parent. Insert it into the parents list of derived objects
     }
 
+    /* make node available for indexed queries */
+    this->IndexNode(node);
+
     // register for ITK changed events
     this->AddListeners(node);
   }
@@ -122,6 +126,7 @@ void mitk::StandaloneDataStorage::Remove(const mitk::DataNode* node)
     /* remove node from both relation adjacency lists */
     this->RemoveFromRelation(node, m_SourceNodes);
     this->RemoveFromRelation(node, m_DerivedNodes);
+    this->UnindexNode(node);
   }
 }
 
@@ -168,6 +173,128 @@ mitk::DataStorage::SetOfObjects::ConstPointer mitk::StandaloneDataStorage::GetAl
 }
 
 
+mitk::DataStorage::SetOfObjects::ConstPointer mitk::StandaloneDataStorage::GetSubset(const NodePredicateBase* condition) const
+{
+  const mitk::NodePredicateProperty* propertyCondition = dynamic_cast<const mitk::NodePredicateProperty*>(condition);
+  if ((propertyCondition == NULL) || (propertyCondition->GetValidProperty() == NULL))
+    return Superclass::GetSubset(condition);
+
+  /* collect candidates from the index. The index is keyed by the string representation of
+     the property value, so candidates are checked against the predicate afterwards */
+  std::vector<mitk::DataNode::Pointer> candidates;
+  bool indexed = false;
+  {
+    itk::MutexLockHolder<itk::SimpleFastMutexLock> locked(m_Mutex);
+    PropertyIndex::const_iterator keyIt = m_PropertyIndex.find(propertyCondition->GetValidPropertyName());
+    if (keyIt != m_PropertyIndex.end())
+    {
+      indexed = true;
+      PropertyValueIndex::const_iterator valueIt = keyIt->second.find(propertyCondition->GetValidProperty()->GetValueAsString());
+      if (valueIt != keyIt->second.end())
+        for (NodeSet::const_iterator nodeIt = valueIt->second.begin(); nodeIt != valueIt->second.end(); ++nodeIt)
+          candidates.push_back(const_cast<mitk::DataNode*>(*nodeIt));
+    }
+  }
+  if (!indexed)
+    return Superclass::GetSubset(condition);
+
+  mitk::DataStorage::SetOfObjects::Pointer resultset = mitk::DataStorage::SetOfObjects::New();
+  for (std::vector<mitk::DataNode::Pointer>::const_iterator it = candidates.begin(); it != candidates.end(); ++it)
+    if (condition->CheckNode(*it) == true)
+      resultset->InsertElement(resultset->Size(), *it);
+
+  return SetOfObjects::ConstPointer(resultset);
+}
+
+
+void mitk::StandaloneDataStorage::AddIndexedPropertyKey(const std::string& propertyKey)
+{
+  itk::MutexLockHolder<itk::SimpleFastMutexLock> locked(m_Mutex);
+  if (m_PropertyIndex.find(propertyKey) != m_PropertyIndex.end())
+    return;
+
+  m_PropertyIndex[propertyKey];
+  for (AdjacencyList::const_iterator it = m_SourceNodes.begin(); it != m_SourceNodes.end(); ++it)
+    if (it->first.IsNotNull())
+      this->IndexNodeProperty(it->first, propertyKey);
+}
+
+
+void mitk::StandaloneDataStorage::RemoveIndexedPropertyKey(const std::string& propertyKey)
+{
+  itk::MutexLockHolder<itk::SimpleFastMutexLock> locked(m_Mutex);
+  m_PropertyIndex.erase(propertyKey);
+  for (IndexedValuesMap::iterator it = m_IndexedValues.begin(); it != m_IndexedValues.end(); ++it)
+    it->second.erase(propertyKey);
+}
+
+
+bool mitk::StandaloneDataStorage::IsIndexedPropertyKey(const std::string& propertyKey) const
+{
+  itk::MutexLockHolder<itk::SimpleFastMutexLock> locked(m_Mutex);
+  return (m_PropertyIndex.find(propertyKey) != m_PropertyIndex.end());
+}
+
+
+void mitk::StandaloneDataStorage::IndexNode(const mitk::DataNode* node)
+{
+  this->UnindexNode(node);
+  for (PropertyIndex::const_iterator keyIt = m_PropertyIndex.begin(); keyIt != m_PropertyIndex.end(); ++keyIt)
+    this->IndexNodeProperty(node, keyIt->first);
+}
+
+
+void mitk::StandaloneDataStorage::UnindexNode(const mitk::DataNode* node)
+{
+  IndexedValuesMap::iterator nodeIt = m_IndexedValues.find(node);
+  if (nodeIt == m_IndexedValues.end())
+    return;
+
+  for (std::map<std::string, std::string>::const_iterator valueIt = nodeIt->second.begin(); valueIt != nodeIt->second.end(); ++valueIt)
+  {
+    PropertyIndex::iterator keyIt = m_PropertyIndex.find(valueIt->first);
+    if (keyIt == m_PropertyIndex.end())
+      continue;
+    PropertyValueIndex::iterator nodesIt = keyIt->second.find(valueIt->second);
+    if (nodesIt == keyIt->second.end())
+      continue;
+    nodesIt->second.erase(node);
+    if (nodesIt->second.empty())
+      keyIt->second.erase(nodesIt);
+  }
+  m_IndexedValues.erase(nodeIt);
+}
+
+
+void mitk::StandaloneDataStorage::IndexNodeProperty(const mitk::DataNode* node, const std::string& propertyKey)
+{
+  mitk::BaseProperty* property = node->GetPropertyList()->GetProperty(propertyKey);
+  if (property == NULL)
+    return;
+
+  std::string value = property->GetValueAsString();
+  m_PropertyIndex[propertyKey][value].insert(node);
+  m_IndexedValues[node][propertyKey] = value;
+}
+
+
+void mitk::StandaloneDataStorage::OnNodeModifiedOrDeleted(const itk::Object* caller, const itk::EventObject& event)
+{
+  const mitk::DataNode* node = dynamic_cast<const mitk::DataNode*>(caller);
+  if (node != NULL)
+  {
+    itk::MutexLockHolder<itk::SimpleFastMutexLock> locked(m_Mutex);
+    // do not touch m_SourceNodes with a node that is being deleted, the smart pointer
+    // created for the lookup would delete it a second time
+    if ((dynamic_cast<const itk::ModifiedEvent*>(&event) != NULL) && (m_SourceNodes.find(node) != m_SourceNodes.end()))
+      this->IndexNode(node);
+    else
+      this->UnindexNode(node);
+  }
+  Superclass::OnNodeModifiedOrDeleted(caller, event);
+}
+
+
 mitk::DataStorage::SetOfObjects::ConstPointer mitk::StandaloneDataStorage::GetRelations(const mitk::DataNode* node, const AdjacencyList& relation, const NodePredicateBase* condition, bool onlyDirectlyRelated) const
 {
   if (node == NULL)
@@ -22,6 +22,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "mitkMessage.h"
 #include "itkVectorContainer.h"
 #include <map>
+#include <set>
 
 namespace mitk {
 
@@ -88,6 +89,33 @@ namespace mitk {
     //##
     SetOfObjects::ConstPointer GetAll() const;
 
+    //##Documentation
+    //## @brief returns a set of data objects that meet the given condition(s)
+    //##
+    //## If condition is a NodePredicateProperty that checks for the value of an
+    //## indexed property key (see AddIndexedPropertyKey()), the result is taken
+    //## from the property index instead of filtering all nodes. Otherwise, the
+    //## behaviour is identical to DataStorage::GetSubset().
+    virtual SetOfObjects::ConstPointer GetSubset(const NodePredicateBase* condition) const;
+
+    //##Documentation
+    //## @brief Adds a property key to the set of keys whose values are indexed
+    //##
+    //## The "name" property is indexed by default. The index is built for all
+    //## nodes that are already stored and kept current on Add(), Remove() and
+    //## on every ModifiedEvent of a stored node. Note that changing the value of
+    //## a property object in place does not modify the node; call
+    //## DataNode::Modified() afterwards or use DataNode::SetProperty().
+    void AddIndexedPropertyKey(const std::string& propertyKey);
+
+    //##Documentation
+    //## @brief Removes a property key from the property index
+    void RemoveIndexedPropertyKey(const std::string& propertyKey);
+
+    //##Documentation
+    //## @brief Checks if the values of a property key are indexed
+    bool IsIndexedPropertyKey(const std::string& propertyKey) const;
+
     /*ITK Mutex */
     mutable itk::SimpleFastMutexLock m_Mutex;
 
@@ -97,6 +125,22 @@ namespace mitk {
     //## @brief noncyclical directed graph data structure to store the nodes with their relation
     typedef std::map<mitk::DataNode::ConstPointer, SetOfObjects::ConstPointer> AdjacencyList;
 
+    //##Documentation
+    //## @brief set of nodes, ordered in the same way as the keys of AdjacencyList
+    typedef std::set<const mitk::DataNode*> NodeSet;
+
+    //##Documentation
+    //## @brief maps the string representation of a property value to the nodes having that value
+    typedef std::map<std::string, NodeSet> PropertyValueIndex;
+
+    //##Documentation
+    //## @brief maps an indexed property key to the index of its values
+    typedef std::map<std::string, PropertyValueIndex> PropertyIndex;
+
+    //##Documentation
+    //## @brief maps a node to the values (by property key) under which it is currently indexed
+    typedef std::map<const mitk::DataNode*, std::map<std::string, std::string> > IndexedValuesMap;
+
     //##Documentation
     //## @brief Standard Constructor for ::New() instantiation
     StandaloneDataStorage();
@@ -116,6 +160,22 @@ namespace mitk {
     //## @brief deletes all references to a node in a given relation (used in Remove() and TreeListener)
     void RemoveFromRelation(const mitk::DataNode* node, AdjacencyList& relation);
 
+    //##Documentation
+    //## @brief Keeps the property index of the caller current and forwards the event to DataStorage
+    virtual void OnNodeModifiedOrDeleted(const itk::Object* caller, const itk::EventObject& event);
+
+    //##Documentation
+    //## @brief (re-)inserts node into the property index for all indexed keys. m_Mutex must be locked.
+    void IndexNode(const mitk::DataNode* node);
+
+    //##Documentation
+    //## @brief removes all property index entries of node. m_Mutex must be locked.
+    void UnindexNode(const mitk::DataNode* node);
+
+    //##Documentation
+    //## @brief inserts node into the index of propertyKey, if node has such a property. m_Mutex must be locked.
+    void IndexNodeProperty(const mitk::DataNode* node, const std::string& propertyKey);
+
     //##Documentation
     //## @brief Prints the contents of the StandaloneDataStorage to os. Do not call directly, call ->Print() instead
     virtual void PrintSelf(std::ostream& os, itk::Indent indent) const;
@@ -126,6 +186,12 @@ namespace mitk {
     //##Documentation
     //## @brief Nodes are stored in reverse relation for easier traversal in the opposite direction of the relation
     AdjacencyList m_DerivedNodes;
+    //##Documentation
+    //## @brief Secondary index of nodes by the values of the registered property keys
+    PropertyIndex m_PropertyIndex;
+    //##Documentation
+    //## @brief Reverse lookup of m_PropertyIndex, used to remove outdated entries
+    IndexedValuesMap m_IndexedValues;
   };
 } // namespace mitk
 #endif /* MITKSTANDALONEDATASTORAGE_H_HEADER_INCLUDED_ */
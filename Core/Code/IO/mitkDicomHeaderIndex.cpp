@@ -0,0 +1,312 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkDicomHeaderIndex.h"
+
+#include <mitkLogMacros.h>
+
+#include <itksys/SystemTools.hxx>
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+
+namespace mitk
+{
+
+static const char* const IndexFileHeader = "MITK DICOM header index 1";
+
+static std::string TagToString(const gdcm::Tag& tag)
+{
+  char buffer[9];
+  sprintf( buffer, "%04x%04x", tag.GetGroup(), tag.GetElement() );
+  return std::string( buffer );
+}
+
+static bool StringToTag(const std::string& value, gdcm::Tag& tag)
+{
+  if ( value.size() != 8 ) return false;
+
+  char* end = NULL;
+  unsigned long number = strtoul( value.c_str(), &end, 16 );
+  if ( end != value.c_str() + value.size() ) return false;
+
+  tag = gdcm::Tag( static_cast<uint16_t>( number >> 16 ), static_cast<uint16_t>( number & 0xffff ) );
+  return true;
+}
+
+static void SplitLine(const std::string& line, char separator, std::vector<std::string>& fields)
+{
+  fields.clear();
+  std::string::size_type start = 0;
+  std::string::size_type pos;
+  while ( ( pos = line.find( separator, start ) ) != std::string::npos )
+  {
+    fields.push_back( line.substr( start, pos - start ) );
+    start = pos + 1;
+  }
+  fields.push_back( line.substr( start ) );
+}
+
+DicomHeaderIndex::DicomHeaderIndex()
+:m_Modified(false)
+{
+}
+
+std::string DicomHeaderIndex::Escape(const std::string& value)
+{
+  // tabs separate fields and newlines entries, everything else is written as is
+  std::string result;
+  result.reserve( value.size() );
+  for ( std::string::const_iterator iter = value.begin(); iter != value.end(); ++iter )
+  {
+    switch ( *iter )
+    {
+      case '%':  result += "%25"; break;
+      case '\t': result += "%09"; break;
+      case '\n': result += "%0A"; break;
+      case '\r': result += "%0D"; break;
+      default:   result += *iter;
+    }
+  }
+  return result;
+}
+
+std::string DicomHeaderIndex::Unescape(const std::string& value)
+{
+  std::string result;
+  result.reserve( value.size() );
+  for ( std::string::size_type i = 0; i < value.size(); ++i )
+  {
+    if ( value[i] == '%' && i + 2 < value.size() )
+    {
+      result += static_cast<char>( strtol( value.substr( i + 1, 2 ).c_str(), NULL, 16 ) );
+      i += 2;
+    }
+    else
+    {
+      result += value[i];
+    }
+  }
+  return result;
+}
+
+bool DicomHeaderIndex::Load(const std::string& filename)
+{
+  m_Entries.clear();
+  m_Modified = false;
+
+  std::ifstream stream( filename.c_str(), std::ios::in | std::ios::binary );
+  if ( !stream.good() )
+  {
+    return false;
+  }
+
+  std::string line;
+  if ( !std::getline( stream, line ) || line != IndexFileHeader )
+  {
+    MITK_WARN << "Ignoring DICOM header index " << filename << " because of its unknown format.";
+    return false;
+  }
+
+  std::vector<std::string> fields;
+  std::vector<std::string> tags;
+  while ( std::getline( stream, line ) )
+  {
+    // path, modification time, size, DICOM flag, scanned tags, then tag=value pairs
+    SplitLine( line, '\t', fields );
+    if ( fields.size() < 5 )
+    {
+      continue;
+    }
+
+    Entry entry;
+    entry.m_ModifiedTime = strtol( fields[1].c_str(), NULL, 10 );
+    entry.m_FileSize = strtoul( fields[2].c_str(), NULL, 10 );
+    entry.m_IsDicom = fields[3] == "1";
+
+    bool valid = true;
+    gdcm::Tag tag;
+    if ( !fields[4].empty() )
+    {
+      SplitLine( fields[4], ',', tags );
+      for ( std::vector<std::string>::const_iterator tagIter = tags.begin(); tagIter != tags.end(); ++tagIter )
+      {
+        valid = valid && StringToTag( *tagIter, tag );
+        entry.m_ScannedTags.insert( tag );
+      }
+    }
+
+    for ( std::vector<std::string>::size_type i = 5; i < fields.size() && valid; ++i )
+    {
+      std::string::size_type separator = fields[i].find( '=' );
+      valid = separator != std::string::npos && StringToTag( fields[i].substr( 0, separator ), tag );
+      if ( valid )
+      {
+        entry.m_Values[tag] = Unescape( fields[i].substr( separator + 1 ) );
+      }
+    }
+
+    if ( valid )
+    {
+      m_Entries[ Unescape( fields[0] ) ] = entry;
+    }
+  }
+
+  return true;
+}
+
+bool DicomHeaderIndex::Save(const std::string& filename)
+{
+  const std::string temporaryFilename = filename + ".tmp";
+
+  {
+    std::ofstream stream( temporaryFilename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc );
+    if ( !stream.good() )
+    {
+      MITK_WARN << "Could not write DICOM header index " << temporaryFilename;
+      return false;
+    }
+
+    stream << IndexFileHeader << "\n";
+    for ( EntryMap::const_iterator entryIter = m_Entries.begin(); entryIter != m_Entries.end(); ++entryIter )
+    {
+      const Entry& entry = entryIter->second;
+      stream << Escape( entryIter->first ) << '\t'
+             << entry.m_ModifiedTime << '\t'
+             << entry.m_FileSize << '\t'
+             << ( entry.m_IsDicom ? "1" : "0" ) << '\t';
+
+      for ( std::set<gdcm::Tag>::const_iterator tagIter = entry.m_ScannedTags.begin();
+            tagIter != entry.m_ScannedTags.end();
+            ++tagIter )
+      {
+        if ( tagIter != entry.m_ScannedTags.begin() ) stream << ',';
+        stream << TagToString( *tagIter );
+      }
+
+      for ( TagValueMap::const_iterator valueIter = entry.m_Values.begin(); valueIter != entry.m_Values.end(); ++valueIter )
+      {
+        stream << '\t' << TagToString( valueIter->first ) << '=' << Escape( valueIter->second );
+      }
+      stream << '\n';
+    }
+
+    if ( !stream.good() )
+    {
+      MITK_WARN << "Could not write DICOM header index " << temporaryFilename;
+      return false;
+    }
+  }
+
+  // replace the old index only by a completely written one
+  itksys::SystemTools::RemoveFile( filename.c_str() );
+  if ( !itksys::SystemTools::RenameFile( temporaryFilename.c_str(), filename.c_str() ) )
+  {
+    MITK_WARN << "Could not replace DICOM header index " << filename;
+    return false;
+  }
+
+  m_Modified = false;
+  return true;
+}
+
+bool DicomHeaderIndex::Lookup(const std::string& file, const TagList& tags, bool& isDicom, TagValueMap& values) const
+{
+  EntryMap::const_iterator entryIter = m_Entries.find( file );
+  if ( entryIter == m_Entries.end() )
+  {
+    return false;
+  }
+
+  const Entry& entry = entryIter->second;
+  if ( entry.m_ModifiedTime != itksys::SystemTools::ModifiedTime( file.c_str() ) ||
+       entry.m_FileSize != itksys::SystemTools::FileLength( file.c_str() ) )
+  {
+    return false;
+  }
+
+  isDicom = entry.m_IsDicom;
+  values.clear();
+  if ( !isDicom )
+  {
+    return true;
+  }
+
+  for ( TagList::const_iterator tagIter = tags.begin(); tagIter != tags.end(); ++tagIter )
+  {
+    if ( entry.m_ScannedTags.find( *tagIter ) == entry.m_ScannedTags.end() )
+    {
+      return false;
+    }
+
+    TagValueMap::const_iterator valueIter = entry.m_Values.find( *tagIter );
+    if ( valueIter != entry.m_Values.end() )
+    {
+      values.insert( *valueIter );
+    }
+  }
+
+  return true;
+}
+
+void DicomHeaderIndex::Update(const std::string& file, const TagList& tags, bool isDicom, const TagValueMap& values)
+{
+  const long modifiedTime = itksys::SystemTools::ModifiedTime( file.c_str() );
+  const unsigned long fileSize = itksys::SystemTools::FileLength( file.c_str() );
+
+  Entry& entry = m_Entries[file];
+  if ( entry.m_ModifiedTime != modifiedTime || entry.m_FileSize != fileSize || entry.m_IsDicom != isDicom )
+  {
+    // values from an older version of the file are worthless
+    entry.m_ScannedTags.clear();
+    entry.m_Values.clear();
+  }
+
+  entry.m_ModifiedTime = modifiedTime;
+  entry.m_FileSize = fileSize;
+  entry.m_IsDicom = isDicom;
+
+  for ( TagList::const_iterator tagIter = tags.begin(); tagIter != tags.end(); ++tagIter )
+  {
+    entry.m_ScannedTags.insert( *tagIter );
+    entry.m_Values.erase( *tagIter );
+  }
+  for ( TagValueMap::const_iterator valueIter = values.begin(); valueIter != values.end(); ++valueIter )
+  {
+    entry.m_Values[ valueIter->first ] = valueIter->second;
+  }
+
+  m_Modified = true;
+}
+
+bool DicomHeaderIndex::IsModified() const
+{
+  return m_Modified;
+}
+
+unsigned int DicomHeaderIndex::GetNumberOfEntries() const
+{
+  return static_cast<unsigned int>( m_Entries.size() );
+}
+
+void DicomHeaderIndex::Clear()
+{
+  m_Modified = m_Modified || !m_Entries.empty();
+  m_Entries.clear();
+}
+
+} // end namespace mitk
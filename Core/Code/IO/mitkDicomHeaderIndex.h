@@ -0,0 +1,129 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#ifndef mitkDicomHeaderIndex_h
+#define mitkDicomHeaderIndex_h
+
+#include <MitkExports.h>
+
+#ifdef NOMINMAX
+#  define DEF_NOMINMAX
+#  undef NOMINMAX
+#endif
+
+#include <gdcmTag.h>
+
+#ifdef DEF_NOMINMAX
+#  ifndef NOMINMAX
+#    define NOMINMAX
+#  endif
+#  undef DEF_NOMINMAX
+#endif
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace mitk
+{
+
+/**
+ \brief Persistent index of DICOM tag values, keyed by file path.
+
+ DicomSeriesReader scans the same set of DICOM tags of every file each time a
+ directory is opened. This index remembers the scanned values together with
+ the modification time and size of each file, so that unchanged files do not
+ have to be parsed again. Files that could not be parsed as DICOM are
+ remembered as well.
+
+ An entry is only used if the file's modification time and size still match
+ and all requested tags have been scanned before. The index is stored as a
+ plain text file, see Load() and Save().
+*/
+class MITK_CORE_EXPORT DicomHeaderIndex
+{
+public:
+
+  typedef std::vector<gdcm::Tag> TagList;
+  typedef std::map<gdcm::Tag, std::string> TagValueMap;
+
+  DicomHeaderIndex();
+
+  /**
+   \brief Replace the current content by the index stored in filename.
+
+   Returns false if the file does not exist or has an unknown format. The index is empty then.
+  */
+  bool Load(const std::string& filename);
+
+  /**
+   \brief Write the index to filename.
+
+   The index is written to a temporary file first, which then replaces filename.
+  */
+  bool Save(const std::string& filename);
+
+  /**
+   \brief Look up the cached values of tags for file.
+
+   \param isDicom set to false if file is known to be no readable DICOM file
+   \param values the values of all tags that exist in the file
+   \return false if file is unknown, has changed since it was indexed, or was not scanned for all tags
+  */
+  bool Lookup(const std::string& file, const TagList& tags, bool& isDicom, TagValueMap& values) const;
+
+  /**
+   \brief Store the result of scanning file for tags.
+
+   Values of other tags remain known as long as the file did not change.
+  */
+  void Update(const std::string& file, const TagList& tags, bool isDicom, const TagValueMap& values);
+
+  /**
+   \brief Whether Update() changed the index since the last Load() or Save().
+  */
+  bool IsModified() const;
+
+  unsigned int GetNumberOfEntries() const;
+
+  void Clear();
+
+protected:
+
+  struct Entry
+  {
+    Entry() : m_ModifiedTime(0), m_FileSize(0), m_IsDicom(false) {}
+
+    long m_ModifiedTime;
+    unsigned long m_FileSize;
+    bool m_IsDicom;
+    std::set<gdcm::Tag> m_ScannedTags;
+    TagValueMap m_Values;
+  };
+
+  typedef std::map<std::string, Entry> EntryMap;
+
+  static std::string Escape(const std::string& value);
+  static std::string Unescape(const std::string& value);
+
+  EntryMap m_Entries;
+  bool m_Modified;
+};
+
+}
+
+#endif /* mitkDicomHeaderIndex_h */
@@ -18,6 +18,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 //#define MBILOG_ENABLE_DEBUG
 
 #include <mitkDicomSeriesReader.h>
+#include "mitkDicomHeaderIndex.h"
 
 #include <itkGDCMSeriesFileNames.h>
 
@@ -32,6 +33,8 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 #include "mitkProperties.h"
 
+#include <algorithm>
+
 namespace mitk
 {
 
@@ -1223,6 +1226,392 @@ DicomSeriesReader::AnalyzeFileForITKImageSeriesReaderSpacingAssumption(
   return result;
 }
 
+/// header index shared by all scans, guarded by s_HeaderIndexMutex
+static std::string s_HeaderIndexFileName;
+static std::string s_LoadedHeaderIndexFileName;
+static DicomHeaderIndex s_HeaderIndex;
+static itk::SimpleFastMutexLock s_HeaderIndexMutex;
+
+void
+DicomSeriesReader::SetHeaderIndexFileName(const std::string& filename)
+{
+  s_HeaderIndexMutex.Lock();
+  s_HeaderIndexFileName = filename;
+  s_HeaderIndexMutex.Unlock();
+}
+
+std::string
+DicomSeriesReader::GetHeaderIndexFileName()
+{
+  s_HeaderIndexMutex.Lock();
+  std::string filename = s_HeaderIndexFileName;
+  s_HeaderIndexMutex.Unlock();
+  return filename;
+}
+
+DicomSeriesReader::ParallelScanner::ParallelScanner()
+{
+}
+
+DicomSeriesReader::ParallelScanner::~ParallelScanner()
+{
+  for ( std::vector<gdcm::Scanner*>::iterator iter = m_Scanners.begin(); iter != m_Scanners.end(); ++iter )
+  {
+    delete *iter;
+  }
+}
+
+void
+DicomSeriesReader::ParallelScanner::AddTag( const gdcm::Tag& tag )
+{
+  m_Tags.push_back( tag );
+}
+
+ITK_THREAD_RETURN_TYPE
+DicomSeriesReader::ParallelScanner::ScanThread( void* pInfoStruct )
+{
+  itk::MultiThreader::ThreadInfoStruct* pInfo = static_cast<itk::MultiThreader::ThreadInfoStruct*>( pInfoStruct );
+  ThreadData* data = static_cast<ThreadData*>( pInfo->UserData );
+
+  // contiguous chunks, files of a directory tend to be neighbors on disk
+  const size_t numberOfFiles = data->filenames->size();
+  const size_t first = numberOfFiles * pInfo->ThreadID / pInfo->NumberOfThreads;
+  const size_t last = numberOfFiles * (pInfo->ThreadID + 1) / pInfo->NumberOfThreads;
+
+  // results stay 0 if scanning throws, Scan() then reports the failure like a failed gdcm::Scanner
+  try
+  {
+    StringContainer chunk( data->filenames->begin() + first, data->filenames->begin() + last );
+    data->results[ pInfo->ThreadID ] = data->scanner->m_Scanners[ pInfo->ThreadID ]->Scan( chunk ) ? 1 : 0;
+  }
+  catch ( std::exception& e )
+  {
+    MITK_WARN << "Scanning DICOM files failed: " << e.what();
+  }
+  catch ( ... )
+  {
+    MITK_WARN << "Scanning DICOM files failed with an unknown error";
+  }
+
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+bool
+DicomSeriesReader::ParallelScanner::LookupHeaderIndex( const StringContainer& filenames, StringContainer& filesToScan )
+{
+  s_HeaderIndexMutex.Lock();
+  if ( s_HeaderIndexFileName.empty() )
+  {
+    s_HeaderIndexMutex.Unlock();
+    return false;
+  }
+
+  if ( s_LoadedHeaderIndexFileName != s_HeaderIndexFileName )
+  {
+    s_HeaderIndex.Load( s_HeaderIndexFileName );
+    s_LoadedHeaderIndexFileName = s_HeaderIndexFileName;
+  }
+
+  bool isDicom(false);
+  DicomHeaderIndex::TagValueMap values;
+  for ( StringContainer::const_iterator fileIter = filenames.begin(); fileIter != filenames.end(); ++fileIter )
+  {
+    if ( !s_HeaderIndex.Lookup( *fileIter, m_Tags, isDicom, values ) )
+    {
+      filesToScan.push_back( *fileIter );
+      continue;
+    }
+
+    // like gdcm::Scanner, list only files that could be read
+    if ( !isDicom ) continue;
+
+    const char* filename = m_IndexedStrings.insert( *fileIter ).first->c_str();
+    gdcm::Scanner::TagToValue& mapping = m_Mappings[ filename ];
+    for ( DicomHeaderIndex::TagValueMap::const_iterator valueIter = values.begin(); valueIter != values.end(); ++valueIter )
+    {
+      mapping[ valueIter->first ] = m_IndexedStrings.insert( valueIter->second ).first->c_str();
+    }
+  }
+
+  MITK_DEBUG << "DICOM header index knows " << filenames.size() - filesToScan.size() << " of " << filenames.size() << " files";
+
+  s_HeaderIndexMutex.Unlock();
+  return true;
+}
+
+void
+DicomSeriesReader::ParallelScanner::UpdateHeaderIndex( const StringContainer& scannedFiles )
+{
+  s_HeaderIndexMutex.Lock();
+
+  // the index file name could have been changed while scanning
+  if ( s_LoadedHeaderIndexFileName == s_HeaderIndexFileName && !s_HeaderIndexFileName.empty() )
+  {
+    DicomHeaderIndex::TagValueMap values;
+    for ( StringContainer::const_iterator fileIter = scannedFiles.begin(); fileIter != scannedFiles.end(); ++fileIter )
+    {
+      values.clear();
+      gdcm::Scanner::MappingType::const_iterator mappingIter = m_Mappings.find( fileIter->c_str() );
+      const bool isDicom = mappingIter != m_Mappings.end();
+      if ( isDicom )
+      {
+        for ( gdcm::Scanner::TagToValue::const_iterator tagIter = mappingIter->second.begin();
+              tagIter != mappingIter->second.end();
+              ++tagIter )
+        {
+          if ( tagIter->second )
+          {
+            values[ tagIter->first ] = tagIter->second;
+          }
+        }
+      }
+
+      s_HeaderIndex.Update( *fileIter, m_Tags, isDicom, values );
+    }
+
+    if ( s_HeaderIndex.IsModified() )
+    {
+      s_HeaderIndex.Save( s_HeaderIndexFileName );
+    }
+  }
+
+  s_HeaderIndexMutex.Unlock();
+}
+
+bool
+DicomSeriesReader::ParallelScanner::Scan( const StringContainer& allFilenames )
+{
+  StringContainer filesToScan;
+  const bool useHeaderIndex = LookupHeaderIndex( allFilenames, filesToScan );
+  const StringContainer& filenames = useHeaderIndex ? filesToScan : allFilenames;
+
+  if ( filenames.empty() )
+  {
+    return true;
+  }
+
+  // scanning a file is dominated by I/O latency, but very small chunks are not worth a thread
+  const unsigned int minimumFilesPerThread = 16;
+  unsigned int numberOfThreads = std::min<unsigned int>( itk::MultiThreader::GetGlobalDefaultNumberOfThreads(),
+                                                         filenames.size() / minimumFilesPerThread );
+  numberOfThreads = std::max( numberOfThreads, 1u );
+
+  for ( unsigned int t = 0; t < numberOfThreads; ++t )
+  {
+    gdcm::Scanner* scanner = new gdcm::Scanner;
+    for ( std::vector<gdcm::Tag>::const_iterator tagIter = m_Tags.begin(); tagIter != m_Tags.end(); ++tagIter )
+    {
+      scanner->AddTag( *tagIter );
+    }
+    m_Scanners.push_back( scanner );
+  }
+
+  ThreadData data;
+  data.scanner = this;
+  data.filenames = &filenames;
+  data.results.resize( numberOfThreads, 0 );
+
+  if ( numberOfThreads == 1 )
+  {
+    data.results[0] = m_Scanners.back()->Scan( filenames ) ? 1 : 0;
+  }
+  else
+  {
+    itk::MultiThreader::Pointer threader = itk::MultiThreader::New();
+    threader->SetNumberOfThreads( numberOfThreads );
+    threader->SetSingleMethod( ScanThread, &data );
+    threader->SingleMethodExecute();
+  }
+
+  bool success = true;
+  for ( unsigned int t = 0; t < numberOfThreads; ++t )
+  {
+    success = success && data.results[t];
+    m_Mappings.insert( m_Scanners[t]->GetMappings().begin(), m_Scanners[t]->GetMappings().end() );
+  }
+
+  if ( useHeaderIndex && success )
+  {
+    UpdateHeaderIndex( filenames );
+  }
+
+  return success;
+}
+
+const gdcm::Scanner::MappingType&
+DicomSeriesReader::ParallelScanner::GetMappings() const
+{
+  return m_Mappings;
+}
+
+const char*
+DicomSeriesReader::ParallelScanner::GetValue( const char* filename, const gdcm::Tag& tag ) const
+{
+  gdcm::Scanner::MappingType::const_iterator fileIter = m_Mappings.find( filename );
+  if ( fileIter == m_Mappings.end() )
+  {
+    return NULL;
+  }
+
+  gdcm::Scanner::TagToValue::const_iterator tagIter = fileIter->second.find( tag );
+  if ( tagIter == fileIter->second.end() )
+  {
+    return NULL;
+  }
+
+  return tagIter->second;
+}
+
+gdcm::Scanner::ConstIterator
+DicomSeriesReader::ParallelScanner::Begin() const
+{
+  return m_Mappings.begin();
+}
+
+gdcm::Scanner::ConstIterator
+DicomSeriesReader::ParallelScanner::End() const
+{
+  return m_Mappings.end();
+}
+
+struct DicomSeriesReader::SliceReadThreadData
+{
+  const StringContainer* filenames;
+  unsigned char* buffer;
+  unsigned int columns;
+  unsigned int rows;
+  size_t bytesPerPixel;
+  const std::type_info* componentType;
+  unsigned int numberOfComponents;
+  CallbackCommand* command;
+
+  itk::SimpleFastMutexLock mutex;
+  unsigned int slicesRead;
+  bool failed;
+};
+
+ITK_THREAD_RETURN_TYPE
+DicomSeriesReader::ReadSlicesThread( void* pInfoStruct )
+{
+  itk::MultiThreader::ThreadInfoStruct* pInfo = static_cast<itk::MultiThreader::ThreadInfoStruct*>( pInfoStruct );
+  SliceReadThreadData* data = static_cast<SliceReadThreadData*>( pInfo->UserData );
+
+  const size_t numberOfSlices = data->filenames->size();
+  const size_t first = numberOfSlices * pInfo->ThreadID / pInfo->NumberOfThreads;
+  const size_t last = numberOfSlices * (pInfo->ThreadID + 1) / pInfo->NumberOfThreads;
+  const size_t sliceSize = static_cast<size_t>( data->columns ) * data->rows * data->bytesPerPixel;
+
+  DcmIoType::Pointer io = DcmIoType::New();
+
+  try
+  {
+    for ( size_t slice = first; slice < last; ++slice )
+    {
+      data->mutex.Lock();
+      bool failed = data->failed;
+      data->mutex.Unlock();
+      if ( failed )
+      {
+        break;
+      }
+
+      io->SetFileName( (*data->filenames)[slice] );
+      io->ReadImageInformation();
+
+      // anything that itk::ImageFileReader would have to convert is left to the sequential reader
+      bool compatible = io->GetComponentTypeInfo() == *data->componentType
+                     && io->GetNumberOfComponents() == data->numberOfComponents
+                     && io->GetDimensions(0) == data->columns
+                     && io->GetDimensions(1) == data->rows
+                     && ( io->GetNumberOfDimensions() < 3 || io->GetDimensions(2) == 1 );
+      if ( !compatible )
+      {
+        MITK_DEBUG << "Cannot decode " << (*data->filenames)[slice] << " in parallel, falling back to itk::ImageSeriesReader";
+        data->mutex.Lock();
+        data->failed = true;
+        data->mutex.Unlock();
+        break;
+      }
+
+      io->Read( data->buffer + slice * sliceSize );
+
+      data->mutex.Lock();
+      float progress = static_cast<float>( ++data->slicesRead ) / numberOfSlices;
+      data->mutex.Unlock();
+
+      // only one thread talks to the callback, which usually updates a GUI
+      if ( pInfo->ThreadID == 0 && data->command )
+      {
+        data->command->ReportProgress( progress );
+      }
+    }
+  }
+  // nothing may escape the thread function, the caller falls back to itk::ImageSeriesReader instead
+  catch ( itk::ExceptionObject& e )
+  {
+    MITK_WARN << "Decoding DICOM slice failed: " << e.GetDescription();
+    data->mutex.Lock();
+    data->failed = true;
+    data->mutex.Unlock();
+  }
+  catch ( std::exception& e )
+  {
+    MITK_WARN << "Decoding DICOM slice failed: " << e.what();
+    data->mutex.Lock();
+    data->failed = true;
+    data->mutex.Unlock();
+  }
+  catch ( ... )
+  {
+    MITK_WARN << "Decoding DICOM slice failed with an unknown error";
+    data->mutex.Lock();
+    data->failed = true;
+    data->mutex.Unlock();
+  }
+
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+bool
+DicomSeriesReader::ReadDICOMSlicesInParallel( const StringContainer& filenames,
+                                              unsigned char* buffer,
+                                              unsigned int columns,
+                                              unsigned int rows,
+                                              size_t bytesPerPixel,
+                                              const std::type_info& componentType,
+                                              unsigned int numberOfComponents,
+                                              CallbackCommand* command )
+{
+  if ( filenames.empty() || buffer == NULL )
+  {
+    return false;
+  }
+
+  SliceReadThreadData data;
+  data.filenames = &filenames;
+  data.buffer = buffer;
+  data.columns = columns;
+  data.rows = rows;
+  data.bytesPerPixel = bytesPerPixel;
+  data.componentType = &componentType;
+  data.numberOfComponents = numberOfComponents;
+  data.command = command;
+  data.slicesRead = 0;
+  data.failed = false;
+
+  itk::MultiThreader::Pointer threader = itk::MultiThreader::New();
+  threader->SetNumberOfThreads( std::min<unsigned int>( itk::MultiThreader::GetGlobalDefaultNumberOfThreads(), filenames.size() ) );
+  threader->SetSingleMethod( ReadSlicesThread, &data );
+  threader->SingleMethodExecute();
+
+  if ( !data.failed && command )
+  {
+    command->ReportProgress( 1.0 );
+  }
+
+  return !data.failed;
+}
+
 DicomSeriesReader::FileNamesGrouping
 DicomSeriesReader::GetSeries(const StringContainer& files, bool groupImagesWithGantryTilt, const StringContainer &restrictions)
 {
@@ -1249,7 +1638,7 @@ DicomSeriesReader::GetSeries(const StringContainer& files, bool sortTo3DPlust, b
   //         attributes (they cannot possibly form a 3D block)
 
   // scan for relevant tags in dicom files
-  gdcm::Scanner scanner;
+  ParallelScanner scanner;
   const gdcm::Tag tagSOPClassUID(0x0008, 0x0016); // SOP class UID
     scanner.AddTag( tagSOPClassUID );
 
@@ -24,6 +24,8 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 #include <itkImageSeriesReader.h>
 #include <itkCommand.h>
+#include <itkMultiThreader.h>
+#include <itkSimpleFastMutexLock.h>
 
 #ifdef NOMINMAX
 #  define DEF_NOMINMAX
@@ -42,6 +44,9 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <gdcmDataSet.h>
 #include <gdcmScanner.h>
 
+#include <set>
+#include <typeinfo>
+
 namespace mitk
 {
 
@@ -458,6 +463,18 @@ public:
   bool
   IsDicom(const std::string &filename);
 
+  /**
+   \brief Use a persistent DICOM header index (see DicomHeaderIndex) stored in filename.
+
+   When set, GetSeries() and LoadDicomSeries() parse only files that are new or
+   changed since they were indexed and take the tag values of all other files from
+   the index. The index is loaded on first use and saved after each scan that added
+   new information. An empty filename (the default) disables the index.
+  */
+  static void SetHeaderIndexFileName(const std::string& filename);
+
+  static std::string GetHeaderIndexFileName();
+
   /**
    \brief see other GetSeries().
 
@@ -856,6 +873,14 @@ protected:
       (*this->m_Callback)(static_cast<itk::ProcessObject*>(caller)->GetProgress());
     }
 
+    /**
+      \brief Report progress that is not tracked by an itk::ProcessObject.
+    */
+    void ReportProgress(float progress)
+    {
+      (*this->m_Callback)(progress);
+    }
+
   protected:
 
     UpdateCallBackMethod m_Callback;
@@ -863,10 +888,110 @@ protected:
 
   static void FixSpacingInformation( Image* image, const ImageBlockDescriptor& imageBlockDescriptor );
 
+  /**
+    \brief Scans DICOM tags of many files using several gdcm::Scanner instances in parallel.
+
+    Offers the part of the gdcm::Scanner interface that is used by DicomSeriesReader.
+    Files are split into contiguous chunks, one per thread, and the results of all
+    scanners are merged into a single mapping afterwards. The merged mapping points
+    to strings owned by the individual scanners, so it is only valid while the
+    ParallelScanner exists.
+
+    If a header index file is set (see SetHeaderIndexFileName()), files that are
+    known to the index are not scanned at all.
+  */
+  class ParallelScanner
+  {
+  public:
+    ParallelScanner();
+    ~ParallelScanner();
+
+    void AddTag( const gdcm::Tag& tag );
+
+    /**
+      \brief Scan all files. Returns false if any of the scanners failed.
+    */
+    bool Scan( const StringContainer& filenames );
+
+    const gdcm::Scanner::MappingType& GetMappings() const;
+
+    /**
+      \brief Value of tag in filename, NULL if the tag was not found.
+    */
+    const char* GetValue( const char* filename, const gdcm::Tag& tag ) const;
+
+    gdcm::Scanner::ConstIterator Begin() const;
+    gdcm::Scanner::ConstIterator End() const;
+
+  protected:
+    struct ThreadData
+    {
+      ParallelScanner* scanner;
+      const StringContainer* filenames;
+      std::vector<int> results;
+    };
+
+    static ITK_THREAD_RETURN_TYPE ScanThread( void* pInfoStruct );
+
+    /**
+      \brief Fill m_Mappings from the header index, returns false if no index is used.
+      \param filesToScan receives all files that are not (completely) known to the index
+    */
+    bool LookupHeaderIndex( const StringContainer& filenames, StringContainer& filesToScan );
+
+    void UpdateHeaderIndex( const StringContainer& scannedFiles );
+
+    std::vector<gdcm::Tag> m_Tags;
+    std::vector<gdcm::Scanner*> m_Scanners;
+    gdcm::Scanner::MappingType m_Mappings;
+
+    /// file names and values taken from the header index, m_Mappings points to them
+    std::set<std::string> m_IndexedStrings;
+
+  private:
+    ParallelScanner(const ParallelScanner&); // not implemented
+    void operator=(const ParallelScanner&); // not implemented
+  };
+
   /**
    \brief Scan for slice image information
   */
-  static void ScanForSliceInformation( const StringContainer &filenames, gdcm::Scanner& scanner );
+  static void ScanForSliceInformation( const StringContainer &filenames, ParallelScanner& scanner );
+
+  /**
+    \brief Decode the pixel data of files into buffer, one slice after the other, using several threads.
+
+    Every thread uses its own itk::GDCMImageIO. Slices are decoded exactly like
+    itk::ImageFileReader does if no pixel conversion is needed. If any file does not
+    match the expected component type, number of components or slice size, false
+    is returned and the caller has to fall back to itk::ImageSeriesReader.
+
+    \param buffer must provide space for filenames.size() slices of columns * rows pixels
+    \param command can be used for progress reporting
+  */
+  static bool ReadDICOMSlicesInParallel( const StringContainer& filenames,
+                                         unsigned char* buffer,
+                                         unsigned int columns,
+                                         unsigned int rows,
+                                         size_t bytesPerPixel,
+                                         const std::type_info& componentType,
+                                         unsigned int numberOfComponents,
+                                         CallbackCommand* command );
+
+  struct SliceReadThreadData;
+
+  static ITK_THREAD_RETURN_TYPE ReadSlicesThread( void* pInfoStruct );
+
+  /**
+    \brief Decode the slices of one 3D block directly into a new volume of an initialized image.
+
+    The image has to be initialized with the geometry of the block already.
+    \return false if the slices could not be decoded in parallel, image is unchanged in this case.
+  */
+  template <typename PixelType>
+  static
+  bool
+  LoadDICOMVolumeInParallel( const StringContainer& filenames, Image* image, unsigned int timeStep, CallbackCommand* command );
 
   /**
    \brief Performs actual loading of a series and creates an image having the specified pixel type.
@@ -25,6 +25,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <itkResampleImageFilter.h>
 #include <itkAffineTransform.h>
 #include <itkLinearInterpolateImageFunction.h>
+#include <itkDefaultConvertPixelTraits.h>
 
 #include <limits>
 
@@ -69,7 +70,7 @@ void DicomSeriesReader::LoadDicom(const StringContainer &filenames, DataNode &no
     {
       /* default case: assume "normal" image blocks, possibly 3D+t */
       bool canLoadAs4D(true);
-      gdcm::Scanner scanner;
+      ParallelScanner scanner;
       ScanForSliceInformation(filenames, scanner);
 
       // need non-const access for map
@@ -154,21 +155,35 @@ void DicomSeriesReader::LoadDicom(const StringContainer &filenames, DataNode &no
 
         unsigned int act_volume = 1u;
 
+        // without tilt correction, slices can be decoded in parallel directly into the volumes of image
+        bool loadInParallel = !correctTilt && imageBlocks.front().size() > 1;
+
         if (preLoadedImageBlock.IsNull())
         {
           reader->SetFileNames(imageBlocks.front());
 
-          reader->Update();
-
-          typename ImageType::Pointer readVolume = reader->GetOutput();
-          // if we detected that the images are from a tilted gantry acquisition, we need to push some pixels into the right position
-          if (correctTilt)
+          if (loadInParallel)
           {
-            readVolume = InPlaceFixUpTiltedGeometry( reader->GetOutput(), tiltInfo );
+            // geometry as determined by ITK, reads only the headers of the first and last file
+            reader->UpdateOutputInformation();
+            image->InitializeByItk( reader->GetOutput(), 1, volume_count);
+            loadInParallel = LoadDICOMVolumeInParallel<PixelType>( imageBlocks.front(), image, 0u, command );
           }
 
-          image->InitializeByItk( readVolume.GetPointer(), 1, volume_count);
-          image->SetImportVolume( readVolume->GetBufferPointer(), 0u);
+          if (!loadInParallel)
+          {
+            reader->Update();
+
+            typename ImageType::Pointer readVolume = reader->GetOutput();
+            // if we detected that the images are from a tilted gantry acquisition, we need to push some pixels into the right position
+            if (correctTilt)
+            {
+              readVolume = InPlaceFixUpTiltedGeometry( reader->GetOutput(), tiltInfo );
+            }
+
+            image->InitializeByItk( readVolume.GetPointer(), 1, volume_count);
+            image->SetImportVolume( readVolume->GetBufferPointer(), 0u);
+          }
 
           FixSpacingInformation( image, imageBlockDescriptor );
         }
@@ -179,7 +194,7 @@ void DicomSeriesReader::LoadDicom(const StringContainer &filenames, DataNode &no
           reader->SetFileNames(fakeList); // only ONE first filename to get MetaDataDictionary
         }
 
-        gdcm::Scanner scanner;
+        ParallelScanner scanner;
         ScanForSliceInformation(filenames, scanner);
         CopyMetaDataToImageProperties( imageBlocks, scanner.GetMappings(), io, imageBlockDescriptor, image);
 
@@ -196,6 +211,12 @@ void DicomSeriesReader::LoadDicom(const StringContainer &filenames, DataNode &no
         {
           for (std::list<StringContainer>::iterator df_it = ++imageBlocks.begin(); df_it != imageBlocks.end(); ++df_it)
           {
+            if ( loadInParallel && LoadDICOMVolumeInParallel<PixelType>( *df_it, image, act_volume, command ) )
+            {
+              ++act_volume;
+              continue;
+            }
+
             reader->SetFileNames(*df_it);
             reader->Update();
             typename ImageType::Pointer readVolume = reader->GetOutput();
@@ -269,17 +290,30 @@ Image::Pointer DicomSeriesReader::LoadDICOMByITK( const StringContainer& filenam
   if (preLoadedImageBlock.IsNull())
   {
     reader->SetFileNames(filenames);
-    reader->Update();
-    typename ImageType::Pointer readVolume = reader->GetOutput();
 
-    // if we detected that the images are from a tilted gantry acquisition, we need to push some pixels into the right position
-    if (correctTilt)
+    bool loadedInParallel = false;
+    if ( !correctTilt && filenames.size() > 1 )
     {
-      readVolume = InPlaceFixUpTiltedGeometry( reader->GetOutput(), tiltInfo );
+      // geometry as determined by ITK, reads only the headers of the first and last file
+      reader->UpdateOutputInformation();
+      image->InitializeByItk( reader->GetOutput() );
+      loadedInParallel = LoadDICOMVolumeInParallel<PixelType>( filenames, image, 0u, command );
     }
 
-    image->InitializeByItk(readVolume.GetPointer());
-    image->SetImportVolume(readVolume->GetBufferPointer());
+    if ( !loadedInParallel )
+    {
+      reader->Update();
+      typename ImageType::Pointer readVolume = reader->GetOutput();
+
+      // if we detected that the images are from a tilted gantry acquisition, we need to push some pixels into the right position
+      if (correctTilt)
+      {
+        readVolume = InPlaceFixUpTiltedGeometry( reader->GetOutput(), tiltInfo );
+      }
+
+      image->InitializeByItk(readVolume.GetPointer());
+      image->SetImportVolume(readVolume->GetBufferPointer());
+    }
   }
   else
   {
@@ -301,8 +335,37 @@ Image::Pointer DicomSeriesReader::LoadDICOMByITK( const StringContainer& filenam
   return image;
 }
 
+template <typename PixelType>
+bool
+DicomSeriesReader::LoadDICOMVolumeInParallel( const StringContainer& filenames, Image* image, unsigned int timeStep, CallbackCommand* command )
+{
+  typedef itk::DefaultConvertPixelTraits<PixelType> ConvertPixelTraits;
+
+  if ( image->GetDimension() < 3 || image->GetDimension(2) != filenames.size() )
+  {
+    return false;
+  }
+
+  const unsigned int columns = image->GetDimension(0);
+  const unsigned int rows = image->GetDimension(1);
+  const size_t volumeSize = static_cast<size_t>( columns ) * rows * filenames.size() * sizeof(PixelType);
+
+  // the image takes over this buffer, no copy of the decoded volume is needed
+  unsigned char* buffer = new unsigned char[volumeSize];
+  if ( !ReadDICOMSlicesInParallel( filenames, buffer, columns, rows, sizeof(PixelType),
+                                   typeid(typename ConvertPixelTraits::ComponentType),
+                                   ConvertPixelTraits::GetNumberOfComponents(), command ) )
+  {
+    delete [] buffer;
+    return false;
+  }
+
+  image->SetImportVolume( buffer, timeStep, 0, Image::ManageMemory );
+  return true;
+}
+
 void
-DicomSeriesReader::ScanForSliceInformation(const StringContainer &filenames, gdcm::Scanner& scanner)
+DicomSeriesReader::ScanForSliceInformation(const StringContainer &filenames, ParallelScanner& scanner)
 {
   const gdcm::Tag tagImagePositionPatient(0x0020,0x0032); //Image position (Patient)
   scanner.AddTag(tagImagePositionPatient);
@@ -18,6 +18,8 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "mitkItkImageFileReader.h"
 #include "mitkConfig.h"
 #include "mitkException.h"
+#include "mitkMemoryMappedFile.h"
+#include "mitkMemoryUtilities.h"
 
 #include <itkImageFileReader.h>
 #include <itksys/SystemTools.hxx>
@@ -27,6 +29,9 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <itkImageFileReader.h>
 #include <itkImageIOFactory.h>
 #include <itkImageIORegion.h>
+#include <itkByteSwapper.h>
+
+#include <fstream>
 //#include <itkImageSeriesReader.h>
 //#include <itkDICOMImageIO2.h>
 //#include <itkDICOMSeriesFileNames.h>
@@ -128,11 +133,38 @@ void mitk::ItkImageFileReader::GenerateData()
 
   MITK_INFO << "ioRegion: " << ioRegion << std::endl;
   imageIO->SetIORegion( ioRegion );
-  void* buffer = new unsigned char[imageIO->GetImageSizeInBytes()];
-  imageIO->Read( buffer );
 
   image->Initialize( MakePixelType(imageIO), ndim, dimensions );
-  image->SetImportChannel( buffer, 0, Image::ManageMemory );
+
+  // map the data instead of reading it, if possible
+  bool mapped = false;
+  std::string dataFileName;
+  size_t dataOffset = 0;
+  if ( ( m_UseMemoryMapping || imageIO->GetImageSizeInBytes() > MemoryUtilities::GetTotalSizeOfPhysicalRam() / 2 )
+    && GetUncompressedDataLocation( imageIO, m_FileName, dataFileName, dataOffset ) )
+  {
+    try
+    {
+      MemoryMappedFile::Pointer mappedFile = MemoryMappedFile::New( dataFileName, dataOffset, imageIO->GetImageSizeInBytes() );
+      mapped = image->SetMemoryMappedChannel( mappedFile, 0 );
+    }
+    catch ( mitk::Exception& e )
+    {
+      MITK_WARN << "Could not map image data, reading it instead: " << e.GetDescription();
+    }
+  }
+
+  if ( mapped )
+  {
+    MITK_INFO << "mapped image data of " << dataFileName << " at offset " << dataOffset << std::endl;
+  }
+  else
+  {
+    void* buffer = new unsigned char[imageIO->GetImageSizeInBytes()];
+    imageIO->Read( buffer );
+    image->SetImportChannel( buffer, 0, Image::ManageMemory );
+    buffer = NULL;
+  }
 
   // access direction of itk::Image and include spacing
   mitk::Matrix3D matrix;
@@ -155,7 +187,6 @@ void mitk::ItkImageFileReader::GenerateData()
   // re-initialize TimeSlicedGeometry
   image->GetTimeSlicedGeometry()->InitializeEvenlyTimed(slicedGeometry, image->GetDimension(3));
 
-  buffer = NULL;
   MITK_INFO << "number of image components: "<< image->GetPixelType().GetNumberOfComponents() << std::endl;
 //  mitk::DataNode::Pointer node = this->GetOutput();
 //  node->SetData( image );
@@ -178,6 +209,138 @@ void mitk::ItkImageFileReader::GenerateData()
 }
 
 
+bool mitk::ItkImageFileReader::GetUncompressedDataLocation(const itk::ImageIOBase* imageIO, const std::string& fileName, std::string& dataFileName, size_t& dataOffset)
+{
+  // interleaved vector data may be permuted by the ImageIO, so only scalar images are mapped
+  if ( imageIO->GetNumberOfComponents() != 1 )
+    return false;
+
+  const std::string extension = itksys::SystemTools::LowerCase( itksys::SystemTools::GetFilenameLastExtension( fileName ) );
+  const bool isNrrd = ( extension == ".nrrd" || extension == ".nhdr" );
+  const bool isMetaImage = ( extension == ".mhd" || extension == ".mha" );
+  if ( !isNrrd && !isMetaImage )
+    return false;
+
+  std::ifstream header( fileName.c_str(), std::ios::in | std::ios::binary );
+  if ( !header.good() )
+    return false;
+
+  std::string encoding = isNrrd ? "" : "false"; // NRRD requires the encoding field, MetaImage defaults to uncompressed
+  std::string endian;
+  std::string dataFile;
+  long long byteSkip = 0;
+  long long headerSize = 0;
+  bool lineSkip = false;
+  bool attachedDataFound = false;
+
+  std::string line;
+  while ( std::getline( header, line ) )
+  {
+    if ( !line.empty() && line[line.size()-1] == '\r' )
+      line.erase( line.size()-1 );
+
+    if ( isNrrd )
+    {
+      // the header of attached data ends with an empty line
+      if ( line.empty() )
+      {
+        attachedDataFound = true;
+        break;
+      }
+      if ( line[0] == '#' || line.compare( 0, 4, "NRRD" ) == 0 )
+        continue;
+    }
+
+    std::string::size_type separator = line.find( isNrrd ? ":" : "=" );
+    if ( separator == std::string::npos )
+      continue;
+    std::string key = itksys::SystemTools::LowerCase( itksys::SystemTools::TrimWhitespace( line.substr( 0, separator ) ) );
+    std::string value = line.substr( separator + 1 );
+    if ( isNrrd && !value.empty() && value[0] == '=' ) // key/value pairs use ":=" in NRRD
+      continue;
+    value = itksys::SystemTools::TrimWhitespace( value );
+
+    if ( isNrrd )
+    {
+      if ( key == "encoding" ) encoding = itksys::SystemTools::LowerCase( value );
+      else if ( key == "endian" ) endian = itksys::SystemTools::LowerCase( value );
+      else if ( key == "data file" || key == "datafile" ) dataFile = value;
+      else if ( key == "byte skip" || key == "byteskip" ) byteSkip = atoll( value.c_str() );
+      else if ( key == "line skip" || key == "lineskip" ) lineSkip = ( atoll( value.c_str() ) != 0 );
+    }
+    else
+    {
+      if ( key == "compresseddata" ) encoding = itksys::SystemTools::LowerCase( value );
+      else if ( key == "binarydatabyteordermsb" || key == "elementbyteordermsb" ) endian = ( itksys::SystemTools::LowerCase( value ) == "true" ) ? "big" : "little";
+      else if ( key == "headersize" ) headerSize = atoll( value.c_str() );
+      else if ( key == "elementdatafile" )
+      {
+        // this is the last field of a MetaImage header
+        dataFile = value;
+        attachedDataFound = true;
+        break;
+      }
+    }
+  }
+
+  if ( isNrrd ? ( encoding != "raw" ) : ( encoding != "false" ) )
+    return false;
+  if ( lineSkip )
+    return false;
+
+  if ( imageIO->GetComponentSize() > 1 && !endian.empty() )
+  {
+    const bool systemIsBigEndian = itk::ByteSwapper<int>::SystemIsBigEndian();
+    if ( ( endian == "big" ) != systemIsBigEndian )
+      return false;
+  }
+
+  // a list of files or a file name pattern cannot be mapped as a single block
+  if ( dataFile.find( ' ' ) != std::string::npos || dataFile == "LIST" || ( isNrrd && dataFile == "LOCAL" ) )
+    return false;
+
+  const size_t imageSizeInBytes = imageIO->GetImageSizeInBytes();
+  if ( ( isNrrd && dataFile.empty() ) || ( isMetaImage && dataFile == "LOCAL" ) )
+  {
+    if ( !attachedDataFound )
+      return false;
+    dataFileName = fileName;
+    dataOffset = static_cast<size_t>( header.tellg() );
+  }
+  else if ( !dataFile.empty() )
+  {
+    dataFileName = dataFile;
+    if ( !itksys::SystemTools::FileIsFullPath( dataFileName.c_str() ) )
+      dataFileName = itksys::SystemTools::GetFilenamePath( fileName ) + "/" + dataFileName;
+    dataOffset = 0;
+  }
+  else
+  {
+    return false;
+  }
+
+  // -1 means that the data is located at the end of the file
+  const long long skip = isNrrd ? byteSkip : headerSize;
+  if ( skip == -1 )
+  {
+    const size_t fileSize = MemoryMappedFile::GetFileSize( dataFileName );
+    if ( fileSize < imageSizeInBytes )
+      return false;
+    dataOffset = fileSize - imageSizeInBytes;
+  }
+  else if ( skip > 0 )
+  {
+    dataOffset += static_cast<size_t>( skip );
+  }
+  else if ( skip < 0 )
+  {
+    return false;
+  }
+
+  return true;
+}
+
+
 bool mitk::ItkImageFileReader::CanReadFile(const std::string filename, const std::string filePrefix, const std::string filePattern)
 {
   // First check the extension
@@ -196,7 +359,7 @@ bool mitk::ItkImageFileReader::CanReadFile(const std::string filename, const std
 }
 
 mitk::ItkImageFileReader::ItkImageFileReader()
-    : m_FileName(""), m_FilePrefix(""), m_FilePattern("")
+    : m_FileName(""), m_FilePrefix(""), m_FilePattern(""), m_UseMemoryMapping(false)
 {
 }
 
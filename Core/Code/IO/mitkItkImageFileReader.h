@@ -22,6 +22,8 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "mitkFileReader.h"
 #include "mitkImageSource.h"
 
+#include <itkImageIOBase.h>
+
 namespace mitk {
 //##Documentation
 //## @brief Reader to read file formats supported by itk
@@ -43,10 +45,29 @@ public:
     itkSetStringMacro(FilePattern);
     itkGetStringMacro(FilePattern);
 
+    //##Documentation
+    //## @brief Map uncompressed image data into memory instead of reading it
+    //##
+    //## Supported for scalar images stored as uncompressed NRRD (.nrrd, .nhdr) or
+    //## MetaImage (.mhd, .mha) files in the byte order of this machine. The data is read
+    //## on demand when it is accessed, see Image::SetMemoryMappedChannel(). For other files
+    //## the data is read as usual. Memory mapping is also used without this option if the
+    //## image data is larger than half of the physical memory.
+    itkSetMacro(UseMemoryMapping, bool);
+    itkGetMacro(UseMemoryMapping, bool);
+    itkBooleanMacro(UseMemoryMapping);
+
     static bool CanReadFile(const std::string filename, const std::string filePrefix, const std::string filePattern);
 
 protected:
 
+    //##Documentation
+    //## @brief Determines the file and offset of the image data in @a fileName
+    //##
+    //## Returns false if the data cannot be memory mapped, e.g. because it is compressed,
+    //## split into several files or stored in a different byte order.
+    static bool GetUncompressedDataLocation(const itk::ImageIOBase* imageIO, const std::string& fileName, std::string& dataFileName, size_t& dataOffset);
+
     virtual void GenerateData();
 
     ItkImageFileReader();
@@ -59,6 +80,8 @@ protected:
 
     std::string m_FilePattern;
 
+    bool m_UseMemoryMapping;
+
 };
 
 } // namespace mitk
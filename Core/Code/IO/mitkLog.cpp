@@ -16,12 +16,22 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 #include "mitkLog.h"
 #include "mitkLogMacros.h"
+#include "mitkAtomicOperations.h"
 
 #include "itkSimpleFastMutexLock.h"
 #include <itkOutputWindow.h>
+#include <itkMultiThreader.h>
+#include <itkConditionVariable.h>
 
 #include <iostream>
 #include <fstream>
+#include <cstdlib>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
 
 static itk::SimpleFastMutexLock logMutex;
 static mitk::LoggingBackend *mitkLogBackend = 0;
@@ -30,6 +40,359 @@ static std::string logFileName = "";
 static std::stringstream *outputWindow = 0;
 static bool logOutputWindow = false;
 
+namespace
+{
+
+// positions wrap around, so they are compared and advanced as unsigned numbers
+inline mitk::AtomicType Advance(mitk::AtomicType position, unsigned long steps)
+{
+  return static_cast<mitk::AtomicType>(static_cast<unsigned long>(position) + steps);
+}
+
+inline mitk::AtomicType Distance(mitk::AtomicType position, mitk::AtomicType otherPosition)
+{
+  return static_cast<mitk::AtomicType>(static_cast<unsigned long>(position) - static_cast<unsigned long>(otherPosition));
+}
+
+}
+
+namespace mitk
+{
+
+/**
+  \brief Bounded queue of log messages, written by a background thread.
+
+  Logging threads only copy their message into a preallocated slot of a ring buffer. Slots are claimed by a
+  compare-and-swap on the write position, a sequence number per slot tells the writer thread when a message is
+  complete, so no lock is taken while the writer thread is busy. The strings of the slots keep their capacity,
+  which avoids allocations once the buffers have grown to the usual message length.
+
+  If the ring is full because messages are logged faster than they can be written (e.g. in hot loops), new messages
+  are dropped and counted instead of blocking the logging thread. The number of dropped messages is reported in the
+  log. Fatal messages are never dropped and written before the logging call returns.
+
+  Stop() ends the writer thread (on LoggingBackend::Unregister() and at exit, before static objects like the log file
+  are destroyed). Messages that are logged afterwards are written by the logging thread itself, see
+  WriteSynchronously(). Any thread that writes messages holds logMutex, so messages are never written concurrently.
+*/
+class LoggingQueue
+{
+  public:
+
+    LoggingQueue(LoggingBackend* backend)
+      : m_Backend(backend),
+        m_Slots(new Slot[Capacity]),
+        m_EnqueuePosition(0),
+        m_DequeuePosition(0),
+        m_DroppedMessages(0),
+        m_ReportedDroppedMessages(0),
+        m_WriterWaiting(0),
+        m_WriterStarted(0),
+        m_Stopped(0),
+        m_Stop(false),
+        m_MessageAvailable(itk::ConditionVariable::New()),
+        m_QueueDrained(itk::ConditionVariable::New()),
+        m_MultiThreader(itk::MultiThreader::New())
+    {
+      for (unsigned int i = 0; i < Capacity; ++i)
+      {
+        m_Slots[i].m_Sequence = i;
+      }
+      m_ThreadID = m_MultiThreader->SpawnThread( ThreadStartWriting, this );
+    }
+
+    ~LoggingQueue()
+    {
+      Stop();
+      delete[] m_Slots;
+    }
+
+    /// writes all queued messages and stops the writer thread, later messages have to be written synchronously
+    void Stop()
+    {
+      m_Mutex.Lock();
+      bool running = !m_Stop;
+      m_Stop = true;
+      m_MessageAvailable->Signal();
+      m_QueueDrained->Broadcast();
+      m_Mutex.Unlock();
+
+      if (!running)
+      {
+        return;
+      }
+
+      // the writer thread cannot wait for itself, e.g. if exit() is called while it writes a fatal message
+      if (!IsWriterThread())
+      {
+        m_MultiThreader->TerminateThread( m_ThreadID );
+      }
+      AtomicStore(&m_Stopped, 1);
+
+      // messages that were completed while the writer thread was stopping
+      WriteAvailableMessages();
+    }
+
+    bool IsStopped() const
+    {
+      return AtomicLoad(&m_Stopped) != 0;
+    }
+
+    bool IsWriterThread() const
+    {
+      if (!AtomicLoad(&m_WriterStarted))
+      {
+        return false;
+      }
+    #ifdef _WIN32
+      return GetCurrentThreadId() == m_WriterThread;
+    #else
+      return pthread_equal( pthread_self(), m_WriterThread ) != 0;
+    #endif
+    }
+
+    /// writes the queued messages that are complete, used by the writer thread and after Stop()
+    void WriteAvailableMessages()
+    {
+      logMutex.Lock();
+      WriteQueuedMessages();
+      logMutex.Unlock();
+    }
+
+    /// writes the queued messages and then l in the calling thread
+    void WriteSynchronously(const mbilog::LogMessage& l, int threadID)
+    {
+      logMutex.Lock();
+      WriteQueuedMessages();
+      m_Backend->WriteMessage( l, threadID );
+      logMutex.Unlock();
+    }
+
+    /// returns false if the message was dropped because the queue is full
+    bool Enqueue(const mbilog::LogMessage& l, int threadID)
+    {
+      AtomicType position = AtomicLoad(&m_EnqueuePosition);
+      while (true)
+      {
+        Slot& slot = m_Slots[ Index(position) ];
+        AtomicType difference = Distance( AtomicLoad(&slot.m_Sequence), position );
+        if (difference == 0)
+        {
+          AtomicType previous = AtomicCompareAndSwap( &m_EnqueuePosition, position, Advance(position, 1) );
+          if (previous == position)
+          {
+            slot.m_Level = l.level;
+            slot.m_FilePath = l.filePath;
+            slot.m_LineNumber = l.lineNumber;
+            slot.m_FunctionName = l.functionName;
+            slot.m_ModuleName = l.moduleName;
+            slot.m_Category.assign( l.category.data(), l.category.size() );
+            slot.m_Message.assign( l.message.data(), l.message.size() );
+            slot.m_ThreadID = threadID;
+            AtomicStore( &slot.m_Sequence, Advance(position, 1) );
+            break;
+          }
+          position = previous;
+        }
+        else if (difference < 0)
+        {
+          // the writer thread has not yet written the message that was put into this slot one round before
+          AtomicIncrement(&m_DroppedMessages);
+          return false;
+        }
+        else
+        {
+          position = AtomicLoad(&m_EnqueuePosition);
+        }
+      }
+
+      // the writer thread sets this flag before it checks the queue a last time, see WriteMessages()
+      if (AtomicLoad(&m_WriterWaiting))
+      {
+        m_Mutex.Lock();
+        m_MessageAvailable->Signal();
+        m_Mutex.Unlock();
+      }
+      return true;
+    }
+
+    /// blocks until all messages that were queued before are written
+    void Flush()
+    {
+      if (IsWriterThread())
+      {
+        return; // would wait for itself
+      }
+
+      AtomicType target = AtomicLoad(&m_EnqueuePosition);
+
+      m_Mutex.Lock();
+      while (!m_Stop && Distance( target, AtomicLoad(&m_DequeuePosition) ) > 0)
+      {
+        m_QueueDrained->Wait( &m_Mutex );
+      }
+      m_Mutex.Unlock();
+    }
+
+    unsigned long GetNumberOfDroppedMessages() const
+    {
+      return static_cast<unsigned long>( AtomicLoad(&m_DroppedMessages) );
+    }
+
+  private:
+
+    /// power of two, so positions can be mapped to slots by masking
+    static const unsigned int Capacity = 8192;
+
+    struct Slot
+    {
+      volatile AtomicType m_Sequence;
+      int m_Level;
+      const char* m_FilePath;
+      int m_LineNumber;
+      const char* m_FunctionName;
+      const char* m_ModuleName;
+      std::string m_Category;
+      std::string m_Message;
+      int m_ThreadID;
+    };
+
+    static unsigned int Index(AtomicType position)
+    {
+      return static_cast<unsigned int>( static_cast<unsigned long>(position) & (Capacity - 1) );
+    }
+
+    static ITK_THREAD_RETURN_TYPE ThreadStartWriting(void* arg)
+    {
+      itk::MultiThreader::ThreadInfoStruct* threadInfo = static_cast<itk::MultiThreader::ThreadInfoStruct*>(arg);
+      static_cast<LoggingQueue*>(threadInfo->UserData)->WriteMessages();
+      return ITK_THREAD_RETURN_VALUE;
+    }
+
+    bool IsMessageAvailable() const
+    {
+      const Slot& slot = m_Slots[ Index(m_DequeuePosition) ];
+      return AtomicLoad(&slot.m_Sequence) == Advance(m_DequeuePosition, 1);
+    }
+
+    void WriteMessages()
+    {
+    #ifdef _WIN32
+      m_WriterThread = GetCurrentThreadId();
+    #else
+      m_WriterThread = pthread_self();
+    #endif
+      AtomicStore(&m_WriterStarted, 1);
+
+      while (true)
+      {
+        WriteAvailableMessages();
+
+        m_Mutex.Lock();
+        m_QueueDrained->Broadcast();
+
+        // a message that is completed after this flag is set signals m_MessageAvailable, a message that
+        // was completed before is seen by IsMessageAvailable()
+        AtomicStore(&m_WriterWaiting, 1);
+        while (!m_Stop && !IsMessageAvailable())
+        {
+          m_MessageAvailable->Wait( &m_Mutex );
+        }
+        AtomicStore(&m_WriterWaiting, 0);
+
+        bool stop = m_Stop && !IsMessageAvailable();
+        m_Mutex.Unlock();
+
+        if (stop)
+        {
+          return;
+        }
+      }
+    }
+
+    /// logMutex has to be held
+    void WriteQueuedMessages()
+    {
+      while (IsMessageAvailable())
+      {
+        WriteNextMessage();
+      }
+      ReportDroppedMessages();
+    }
+
+    void WriteNextMessage()
+    {
+      Slot& slot = m_Slots[ Index(m_DequeuePosition) ];
+
+      mbilog::LogMessage l( slot.m_Level, slot.m_FilePath, slot.m_LineNumber, slot.m_FunctionName );
+      l.moduleName = slot.m_ModuleName;
+
+      // swap instead of copy, the slot gets its buffers back afterwards
+      l.category.swap( slot.m_Category );
+      l.message.swap( slot.m_Message );
+      m_Backend->WriteMessage( l, slot.m_ThreadID );
+      l.category.swap( slot.m_Category );
+      l.message.swap( slot.m_Message );
+
+      AtomicStore( &slot.m_Sequence, Advance(m_DequeuePosition, Capacity) );
+      AtomicStore( &m_DequeuePosition, Advance(m_DequeuePosition, 1) );
+    }
+
+    void ReportDroppedMessages()
+    {
+      AtomicType dropped = AtomicLoad(&m_DroppedMessages);
+      if (dropped != m_ReportedDroppedMessages)
+      {
+        std::stringstream message;
+        message << Distance(dropped, m_ReportedDroppedMessages)
+                << " log messages were dropped because they were emitted faster than they could be written";
+        m_ReportedDroppedMessages = dropped;
+
+        mbilog::LogMessage l( mbilog::Warn, __FILE__, __LINE__, __FUNCTION__ );
+        l.moduleName = MBILOG_MODULENAME;
+        l.message = message.str();
+        m_Backend->WriteMessage( l, 0 );
+      }
+    }
+
+    LoggingBackend* m_Backend;
+    Slot* m_Slots;
+
+    volatile AtomicType m_EnqueuePosition;
+    volatile AtomicType m_DequeuePosition; // only changed while logMutex is held
+    volatile AtomicType m_DroppedMessages;
+    AtomicType m_ReportedDroppedMessages; // only used while logMutex is held
+    volatile AtomicType m_WriterWaiting;
+    volatile AtomicType m_WriterStarted;
+    volatile AtomicType m_Stopped;
+
+#ifdef _WIN32
+    DWORD m_WriterThread;
+#else
+    pthread_t m_WriterThread;
+#endif
+
+    bool m_Stop;
+    itk::SimpleMutexLock m_Mutex;
+    itk::ConditionVariable::Pointer m_MessageAvailable;
+    itk::ConditionVariable::Pointer m_QueueDrained;
+
+    itk::MultiThreader::Pointer m_MultiThreader;
+    int m_ThreadID;
+};
+
+}
+
+mitk::LoggingBackend::LoggingBackend()
+  : m_Queue(new LoggingQueue(this))
+{
+}
+
+mitk::LoggingBackend::~LoggingBackend()
+{
+  delete m_Queue;
+}
+
 void mitk::LoggingBackend::EnableAdditionalConsoleWindow(bool enable)
 {
   logOutputWindow = enable;
@@ -38,20 +401,53 @@ void mitk::LoggingBackend::EnableAdditionalConsoleWindow(bool enable)
 
 void mitk::LoggingBackend::ProcessMessage(const mbilog::LogMessage& l )
 {
-  logMutex.Lock();
   #ifdef _WIN32
-    FormatSmart( l, (int)GetCurrentThreadId() );
+    int threadID = (int)GetCurrentThreadId();
   #else
-    FormatSmart( l );
+    int threadID = 0;
   #endif
 
+  if (m_Queue->IsStopped())
+  {
+    // after Unregister() or at exit there is no writer thread any more
+    m_Queue->WriteSynchronously( l, threadID );
+    return;
+  }
+
+  if (l.level == mbilog::Fatal)
+  {
+    // the application might terminate right after a fatal message, so it is written immediately
+    if (m_Queue->IsWriterThread())
+    {
+      // logged while a message is written, the writer thread already holds logMutex and cannot wait for itself
+      WriteMessage( l, threadID );
+      return;
+    }
+    while (!m_Queue->Enqueue( l, threadID ))
+    {
+      m_Queue->Flush();
+    }
+    m_Queue->Flush();
+  }
+  else
+  {
+    m_Queue->Enqueue( l, threadID );
+  }
+
+  // the writer thread might have been stopped before it saw the message
+  if (m_Queue->IsStopped())
+  {
+    m_Queue->WriteAvailableMessages();
+  }
+}
+
+void mitk::LoggingBackend::WriteMessage(const mbilog::LogMessage& l, int threadID)
+{
+  FormatSmart( l, threadID );
+
   if(logFile)
   {
-    #ifdef _WIN32
-      FormatFull( *logFile, l, (int)GetCurrentThreadId() );
-    #else
-      FormatFull( *logFile, l );
-    #endif
+    FormatFull( *logFile, l, threadID );
   }
   if(logOutputWindow)
   {
@@ -59,14 +455,9 @@ void mitk::LoggingBackend::ProcessMessage(const mbilog::LogMessage& l )
     {  outputWindow = new std::stringstream();}
     outputWindow->str("");
     outputWindow->clear();
-    #ifdef _WIN32
-      FormatFull( *outputWindow, l, (int)GetCurrentThreadId() );
-    #else
-      FormatFull( *outputWindow, l );
-    #endif
+    FormatFull( *outputWindow, l, threadID );
     itk::OutputWindow::GetInstance()->DisplayText(outputWindow->str().c_str());
   }
-  logMutex.Unlock();
 }
 
 void mitk::LoggingBackend::Register()
@@ -75,12 +466,21 @@ void mitk::LoggingBackend::Register()
     return;
   mitkLogBackend = new mitk::LoggingBackend();
   mbilog::RegisterBackend( mitkLogBackend );
+
+  static bool stopAtExitRegistered = false;
+  if (!stopAtExitRegistered)
+  {
+    stopAtExitRegistered = true;
+    atexit( StopWriterThread );
+  }
 }
 
 void mitk::LoggingBackend::Unregister()
 {
   if(mitkLogBackend)
   {
+    // messages that are logged from now on, e.g. when the log file is closed, are written immediately
+    StopWriterThread();
     SetLogFile(0);
     mbilog::UnregisterBackend( mitkLogBackend );
     delete mitkLogBackend;
@@ -88,8 +488,32 @@ void mitk::LoggingBackend::Unregister()
   }
 }
 
+void mitk::LoggingBackend::Flush()
+{
+  if(mitkLogBackend)
+  {
+    mitkLogBackend->m_Queue->Flush();
+  }
+}
+
+void mitk::LoggingBackend::StopWriterThread()
+{
+  if(mitkLogBackend)
+  {
+    mitkLogBackend->m_Queue->Stop();
+  }
+}
+
+unsigned long mitk::LoggingBackend::GetNumberOfDroppedMessages()
+{
+  return mitkLogBackend ? mitkLogBackend->m_Queue->GetNumberOfDroppedMessages() : 0;
+}
+
 void mitk::LoggingBackend::SetLogFile(const char *file)
 {
+  // messages logged so far still belong to the old logfile
+  Flush();
+
   // closing old logfile
   {
     bool closed = false;
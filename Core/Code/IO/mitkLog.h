@@ -24,14 +24,24 @@ See LICENSE.txt or http://www.mitk.org for details.
 namespace mitk
 {
 
+  class LoggingQueue;
+
   /*!
     \brief mbilog backend implementation for mitk
+
+    Messages are written to the console, the log file and the output window by a background thread,
+    the logging threads only put them into a bounded queue. If messages are emitted faster than they
+    can be written and the queue is full, they are dropped (see GetNumberOfDroppedMessages()). After
+    Unregister() and at exit, messages are written synchronously again.
    */
   class MITK_CORE_EXPORT LoggingBackend : public mbilog::TextBackendBase
   {
     public:
 
-     /** \brief overloaded method for receiving log message from mbilog
+      LoggingBackend();
+      virtual ~LoggingBackend();
+
+     /** \brief overloaded method for receiving log message from mbilog, queues the message
       */
       void ProcessMessage(const mbilog::LogMessage& );
 
@@ -61,6 +71,34 @@ namespace mitk
       */
       static void CatchLogFileCommandLineParameter(int &argc,char **argv);
 
+     /** \brief Blocks until all messages that were logged before are written
+      */
+      static void Flush();
+
+     /** @return Returns the number of messages that were dropped because the queue of the
+      *          registered backend was full.
+      */
+      static unsigned long GetNumberOfDroppedMessages();
+
+    protected:
+
+      friend class LoggingQueue;
+
+     /** \brief writes a message to the console, the log file and the output window, called by the writer thread
+      */
+      void WriteMessage(const mbilog::LogMessage& l, int threadID);
+
+    private:
+
+     /** \brief Writes the queued messages and stops the writer thread of the registered backend, later messages
+      *         are written before the logging call returns. Called by Unregister() and at exit.
+      */
+      static void StopWriterThread();
+
+      LoggingBackend(const LoggingBackend&); // purposely not implemented
+      void operator=(const LoggingBackend&); // purposely not implemented
+
+      LoggingQueue* m_Queue;
   };
 
 }
@@ -30,3 +30,8 @@ mitk::OperationType mitk::Operation::GetOperationType()
 {
   return m_OperationType;
 }
+
+unsigned long mitk::Operation::GetMemorySize() const
+{
+  return 0;
+}
@@ -39,6 +39,13 @@ public:
 
   OperationType GetOperationType();
 
+  //##Documentation
+  //## @brief Approximate number of bytes held by this operation
+  //##
+  //## Used by undo models to limit the memory of their stacks. Operations with large
+  //## payloads (e.g. image data) should override this, the default returns 0.
+  virtual unsigned long GetMemorySize() const;
+
   protected:
   OperationType m_OperationType;
 };
@@ -17,13 +17,15 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 #include "mitkRawImageFileReader.h"
 #include "mitkITKImageImport.h"
+#include "mitkMemoryMappedFile.h"
 
 #include <itkImage.h>
 #include <itkRawImageIO.h>
 #include <itkImageFileReader.h>
+#include <itkByteSwapper.h>
 
 mitk::RawImageFileReader::RawImageFileReader()
-    : m_FileName(""), m_FilePrefix(""), m_FilePattern("")
+    : m_FileName(""), m_FilePrefix(""), m_FilePattern(""), m_UseMemoryMapping(false)
 {
 }
 
@@ -138,6 +140,33 @@ void mitk::RawImageFileReader::TypedGenerateData()
     return ;
   }
 
+  // map the file if its byte order matches the byte order of this machine
+  if ( m_UseMemoryMapping &&
+       ( sizeof(TPixel) == 1 || ( m_Endianity == BIG ) == itk::ByteSwapper<TPixel>::SystemIsBigEndian() ) )
+  {
+    unsigned int dimensions[ VImageDimensions ];
+    size_t size = sizeof(TPixel);
+    for (unsigned short int dim = 0; dim < VImageDimensions; ++dim)
+    {
+      dimensions[dim] = m_Dimensions[dim];
+      size *= dimensions[dim];
+    }
+
+    // like itk::RawImageIO, a header is skipped and the image data is taken from the end of the file
+    const size_t fileSize = mitk::MemoryMappedFile::GetFileSize( m_FileName );
+    try
+    {
+      mitk::MemoryMappedFile::Pointer mappedFile = mitk::MemoryMappedFile::New( m_FileName, fileSize > size ? fileSize - size : 0, size );
+      output->Initialize( mitk::MakeScalarPixelType<TPixel>(), VImageDimensions, dimensions );
+      if ( output->SetMemoryMappedChannel( mappedFile ) )
+        return;
+    }
+    catch( mitk::Exception & err )
+    {
+      MITK_WARN << "Could not map raw file, reading it instead: " << err.GetDescription();
+    }
+  }
+
   typedef itk::Image< TPixel, VImageDimensions > ImageType;
   typedef itk::ImageFileReader< ImageType > ReaderType;
   typedef itk::RawImageIO< TPixel, VImageDimensions >  IOType;
@@ -68,6 +68,12 @@ public:
 
     unsigned int GetDimensions(unsigned int i) const;
 
+    /** Map the file into memory instead of reading it, see Image::SetMemoryMappedChannel().
+        Only used if the endianity of the file matches the endianity of this machine. */
+    itkSetMacro(UseMemoryMapping, bool);
+    itkGetMacro(UseMemoryMapping, bool);
+    itkBooleanMacro(UseMemoryMapping);
+
     static bool CanReadFile(const std::string filename, const std::string filePrefix, const std::string filePattern);
 
 protected:
@@ -101,6 +107,9 @@ protected:
     /** Vector containing dimensions of image to be read. */
     itk::Vector<int, 3> m_Dimensions;
 
+    /** Map the file instead of reading it. Default is false. */
+    bool m_UseMemoryMapping;
+
 };
 
 } // namespace mitk
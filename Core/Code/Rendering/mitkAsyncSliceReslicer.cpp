@@ -0,0 +1,487 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkAsyncSliceReslicer.h"
+#include "mitkCallbackFromGUIThread.h"
+#include "mitkImageReadAccessor.h"
+#include "mitkRenderingManager.h"
+#include "vtkMitkThickSlicesFilter.h"
+
+#include <itkCommand.h>
+
+#include <vtkAlgorithm.h>
+#include <vtkCallbackCommand.h>
+#include <vtkCommand.h>
+#include <vtkImageData.h>
+#include <vtkImageReslice.h>
+#include <vtkMatrix4x4.h>
+
+namespace
+{
+
+// asks the RenderingManager for an update of one render window, executed on the application thread
+class RequestUpdateCommand : public itk::Command
+{
+public:
+  mitkClassMacro(RequestUpdateCommand, itk::Command);
+  itkNewMacro(Self);
+
+  void SetRenderWindow(vtkRenderWindow* renderWindow)
+  {
+    m_RenderWindow = renderWindow;
+  }
+
+  virtual void Execute(itk::Object* /*caller*/, const itk::EventObject& /*event*/)
+  {
+    // the window is only used as key, RequestUpdate ignores windows that have been removed meanwhile
+    mitk::RenderingManager::GetInstance()->RequestUpdate( m_RenderWindow );
+  }
+
+  virtual void Execute(const itk::Object* /*caller*/, const itk::EventObject& /*event*/)
+  {
+    mitk::RenderingManager::GetInstance()->RequestUpdate( m_RenderWindow );
+  }
+
+protected:
+  RequestUpdateCommand()
+    : m_RenderWindow(NULL)
+  {
+  }
+
+  vtkRenderWindow* m_RenderWindow;
+};
+
+}
+
+mitk::AsyncSliceReslicer::Request::Request()
+  : m_TimeStep(0),
+    m_InterpolationMode(ExtractSliceFilter::RESLICE_NEAREST),
+    m_InPlaneResampleExtentByGeometry(false),
+    m_ThickSlicesMode(0),
+    m_ThickSlicesNum(1),
+    m_DataZSpacing(1.0),
+    m_DataMTime(0),
+    m_RenderWindow(NULL)
+{
+}
+
+mitk::AsyncSliceReslicer::Result::Result()
+  : m_Generation(0)
+{
+  for ( int i = 0; i < 6; ++i )
+  {
+    m_SliceBounds[i] = 0.0;
+  }
+  m_mmPerPixel[0] = m_mmPerPixel[1] = 1.0;
+}
+
+mitk::AsyncSliceReslicer::AsyncSliceReslicer()
+  : m_MultiThreader(itk::MultiThreader::New()),
+    m_ThreadID(-1),
+    m_RequestAvailable(itk::ConditionVariable::New()),
+    m_StopThread(false),
+    m_Generation(0),
+    m_RunningGeneration(0),
+    m_RunningPrefetch(false),
+    m_HasPendingRequest(false),
+    m_PendingGeneration(0),
+    m_HasResult(false),
+    m_PrefetchGeneration(0)
+{
+  m_VtkReslice = vtkSmartPointer<vtkImageReslice>::New();
+  m_Reslicer = ExtractSliceFilter::New(m_VtkReslice);
+  m_Reslicer->SetVtkOutputRequest(true);
+
+  m_TSFilter = vtkSmartPointer<vtkMitkThickSlicesFilter>::New();
+  m_TSFilter->ReleaseDataFlagOn();
+
+  // progress events are emitted by the thread that does the work, so the
+  // filters can be told to abort from there without touching them from the
+  // application thread
+  m_AbortCommand = vtkSmartPointer<vtkCallbackCommand>::New();
+  m_AbortCommand->SetCallback( &AsyncSliceReslicer::AbortCallback );
+  m_AbortCommand->SetClientData( this );
+  m_VtkReslice->AddObserver( vtkCommand::ProgressEvent, m_AbortCommand );
+  m_TSFilter->AddObserver( vtkCommand::ProgressEvent, m_AbortCommand );
+
+  // create the singleton on the application thread, the worker only posts to it
+  CallbackFromGUIThread::GetInstance();
+
+  m_ThreadID = m_MultiThreader->SpawnThread( this->ThreadStartReslicing, this );
+}
+
+mitk::AsyncSliceReslicer::~AsyncSliceReslicer()
+{
+  m_Mutex.Lock();
+  m_StopThread = true;
+  ++m_Generation;
+  ++m_PrefetchGeneration;
+  m_Mutex.Unlock();
+  m_RequestAvailable->Broadcast();
+
+  if ( m_ThreadID >= 0 )
+  {
+    m_MultiThreader->TerminateThread( m_ThreadID );
+    m_ThreadID = -1;
+  }
+}
+
+bool mitk::AsyncSliceReslicer::PrepareJob(const Request& request, Job& job)
+{
+  job.m_Request = request;
+  job.m_Volume = NULL;
+  job.m_Snapshot = NULL;
+
+  if ( request.m_Image.IsNull() || !request.m_Image->IsInitialized() )
+  {
+    return false;
+  }
+
+  // GetVolumeData() may assemble the volume from slices or load it, which must not happen concurrently
+  // to the application's use of the image
+  Image* image = const_cast<Image*>( request.m_Image.GetPointer() );
+  const TimeSlicedGeometry* timeGeometry = image->GetTimeSlicedGeometry();
+  if ( timeGeometry == NULL || !timeGeometry->IsValidTime( request.m_TimeStep ) )
+  {
+    return false;
+  }
+  job.m_Volume = image->GetVolumeData( request.m_TimeStep );
+  if ( job.m_Volume.IsNull() )
+  {
+    return false;
+  }
+
+  try
+  {
+    ImageReadAccessor readAccess( image, job.m_Volume, ImageAccessorBase::ExceptionIfLocked );
+
+    // the snapshot gets its own vtkImageData when it is resliced, the image's one is left alone
+    job.m_Snapshot = Image::New();
+    job.m_Snapshot->Initialize( image );
+    job.m_Snapshot->SetImportVolume( const_cast<void*>( readAccess.GetData() ), request.m_TimeStep, 0, Image::ReferenceMemory );
+  }
+  catch ( MemoryIsLockedException& )
+  {
+    // the image is being modified, which leads to a new request
+    job.m_Volume = NULL;
+    job.m_Snapshot = NULL;
+    return false;
+  }
+  return true;
+}
+
+unsigned long mitk::AsyncSliceReslicer::Submit(const Request& request)
+{
+  this->ReleaseFinishedJobs();
+
+  Job job;
+  PrepareJob( request, job );
+
+  m_Mutex.Lock();
+  unsigned long generation = ++m_Generation;
+  m_PendingJob = job;
+  m_PendingGeneration = generation;
+  m_HasPendingRequest = true;
+  m_HasResult = false;
+  m_Result = Result();
+  m_Mutex.Unlock();
+
+  m_RequestAvailable->Signal();
+  return generation;
+}
+
+void mitk::AsyncSliceReslicer::Cancel()
+{
+  this->ReleaseFinishedJobs();
+
+  m_Mutex.Lock();
+  ++m_Generation;
+  m_HasPendingRequest = false;
+  m_PendingJob = Job();
+  m_HasResult = false;
+  m_Result = Result();
+  m_Mutex.Unlock();
+}
+
+bool mitk::AsyncSliceReslicer::FetchResult(Result& result)
+{
+  this->ReleaseFinishedJobs();
+
+  m_Mutex.Lock();
+  bool available = m_HasResult && m_Result.m_Generation == m_Generation;
+  if ( available )
+  {
+    result = m_Result;
+  }
+  m_HasResult = false;
+  m_Result = Result();
+  m_Mutex.Unlock();
+
+  return available;
+}
+
+unsigned long mitk::AsyncSliceReslicer::GetCurrentGeneration() const
+{
+  m_Mutex.Lock();
+  unsigned long generation = m_Generation;
+  m_Mutex.Unlock();
+  return generation;
+}
+
+void mitk::AsyncSliceReslicer::Prefetch(const std::vector<Request>& requests)
+{
+  this->ReleaseFinishedJobs();
+
+  std::deque<Job> jobs;
+  for ( std::vector<Request>::const_iterator iter = requests.begin(); iter != requests.end(); ++iter )
+  {
+    Job job;
+    if ( PrepareJob( *iter, job ) )
+    {
+      jobs.push_back( job );
+    }
+  }
+
+  m_Mutex.Lock();
+  ++m_PrefetchGeneration;
+  m_PrefetchJobs.swap( jobs );
+  m_Mutex.Unlock();
+
+  m_RequestAvailable->Signal();
+}
+
+void mitk::AsyncSliceReslicer::FetchPrefetchResults(PrefetchResultList& results)
+{
+  this->ReleaseFinishedJobs();
+
+  m_Mutex.Lock();
+  results.insert( results.end(), m_PrefetchResults.begin(), m_PrefetchResults.end() );
+  m_PrefetchResults.clear();
+  m_Mutex.Unlock();
+}
+
+void mitk::AsyncSliceReslicer::ReleaseFinishedJobs()
+{
+  std::vector<Job> finishedJobs;
+  m_Mutex.Lock();
+  finishedJobs.swap( m_FinishedJobs );
+  m_Mutex.Unlock();
+
+  // the images of the jobs are destroyed here, outside of the lock
+}
+
+bool mitk::AsyncSliceReslicer::IsOutdated(unsigned long generation) const
+{
+  m_Mutex.Lock();
+  bool outdated = m_StopThread;
+  if ( m_RunningPrefetch )
+  {
+    // regular requests take precedence over prefetching
+    outdated = outdated || generation != m_PrefetchGeneration || m_HasPendingRequest;
+  }
+  else
+  {
+    outdated = outdated || generation != m_Generation;
+  }
+  m_Mutex.Unlock();
+  return outdated;
+}
+
+ITK_THREAD_RETURN_TYPE mitk::AsyncSliceReslicer::ThreadStartReslicing(void* pInfoStruct)
+{
+  struct itk::MultiThreader::ThreadInfoStruct * pInfo = (struct itk::MultiThreader::ThreadInfoStruct*)pInfoStruct;
+  if ( pInfo == NULL || pInfo->UserData == NULL )
+  {
+    return ITK_THREAD_RETURN_VALUE;
+  }
+
+  AsyncSliceReslicer *reslicer = static_cast<AsyncSliceReslicer*>( pInfo->UserData );
+  reslicer->ProcessRequests();
+
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+void mitk::AsyncSliceReslicer::AbortCallback(vtkObject* caller, unsigned long /*eventId*/, void* clientData, void* /*callData*/)
+{
+  AsyncSliceReslicer* self = static_cast<AsyncSliceReslicer*>( clientData );
+  vtkAlgorithm* algorithm = vtkAlgorithm::SafeDownCast( caller );
+  if ( self != NULL && algorithm != NULL && self->IsOutdated( self->m_RunningGeneration ) )
+  {
+    algorithm->SetAbortExecute( 1 );
+  }
+}
+
+void mitk::AsyncSliceReslicer::ProcessRequests()
+{
+  m_Mutex.Lock();
+  while ( true )
+  {
+    while ( !m_HasPendingRequest && m_PrefetchJobs.empty() && !m_StopThread )
+    {
+      m_RequestAvailable->Wait( &m_Mutex );
+    }
+    if ( m_StopThread )
+    {
+      break;
+    }
+
+    bool prefetch = !m_HasPendingRequest;
+    Job job;
+    unsigned long generation;
+    if ( prefetch )
+    {
+      job = m_PrefetchJobs.front();
+      m_PrefetchJobs.pop_front();
+      generation = m_PrefetchGeneration;
+    }
+    else
+    {
+      job = m_PendingJob;
+      generation = m_PendingGeneration;
+      m_HasPendingRequest = false;
+      m_PendingJob = Job();
+    }
+    m_RunningGeneration = generation;
+    m_RunningPrefetch = prefetch;
+    m_Mutex.Unlock();
+
+    Result result;
+    bool finished = false;
+    try
+    {
+      finished = this->Reslice( job, generation, result );
+    }
+    catch ( MemoryIsLockedException& )
+    {
+      // the image is being modified, which leads to a new request
+    }
+    catch ( std::exception& e )
+    {
+      MITK_WARN << "Asynchronous reslicing failed: " << e.what();
+    }
+
+    bool notify = false;
+    m_Mutex.Lock();
+    m_RunningPrefetch = false;
+    if ( prefetch )
+    {
+      if ( finished && generation == m_PrefetchGeneration && !m_StopThread )
+      {
+        m_PrefetchResults.push_back( std::make_pair( job.m_Request, result ) );
+      }
+    }
+    else if ( finished && generation == m_Generation && !m_StopThread )
+    {
+      m_Result = result;
+      m_HasResult = true;
+      notify = job.m_Request.m_RenderWindow != NULL;
+    }
+    vtkRenderWindow* renderWindow = job.m_Request.m_RenderWindow;
+
+    // the job may hold the last reference to its image, which has to be released by the application thread;
+    // both happen under the lock, so the job is never released by the worker's copy
+    m_FinishedJobs.push_back( job );
+    job = Job();
+    m_Mutex.Unlock();
+
+    if ( notify )
+    {
+      // the RenderingManager must only be used from the application thread
+      RequestUpdateCommand::Pointer command = RequestUpdateCommand::New();
+      command->SetRenderWindow( renderWindow );
+      CallbackFromGUIThread::GetInstance()->CallThisFromGUIThread( command );
+    }
+
+    m_Mutex.Lock();
+  }
+  m_Mutex.Unlock();
+}
+
+bool mitk::AsyncSliceReslicer::Reslice(const Job& job, unsigned long generation, Result& result)
+{
+  const Request& request = job.m_Request;
+  if ( job.m_Snapshot.IsNull() || request.m_WorldGeometry.IsNull() )
+  {
+    return false;
+  }
+
+  // keeps write accessors of the application away from the pixels while they are read
+  ImageReadAccessor readAccess( const_cast<Image*>( request.m_Image.GetPointer() ), job.m_Volume,
+                                ImageAccessorBase::ExceptionIfLocked );
+
+  const TimeSlicedGeometry* timeGeometry = job.m_Snapshot->GetTimeSlicedGeometry();
+
+  m_VtkReslice->AbortExecuteOff();
+  m_TSFilter->AbortExecuteOff();
+
+  m_Reslicer->SetInput( job.m_Snapshot );
+  m_Reslicer->SetWorldGeometry( request.m_WorldGeometry );
+  m_Reslicer->SetTimeStep( request.m_TimeStep );
+  m_Reslicer->SetResliceTransformByGeometry( timeGeometry->GetGeometry3D( request.m_TimeStep ) );
+  m_Reslicer->SetInPlaneResampleExtentByGeometry( request.m_InPlaneResampleExtentByGeometry );
+  m_Reslicer->SetInterpolationMode( request.m_InterpolationMode );
+
+  vtkImageData* slice = NULL;
+  if ( request.m_ThickSlicesMode > 0 )
+  {
+    m_Reslicer->SetOutputDimensionality( 3 );
+    m_Reslicer->SetOutputSpacingZDirection( request.m_DataZSpacing );
+    m_Reslicer->SetOutputExtentZDirection( -request.m_ThickSlicesNum, request.m_ThickSlicesNum );
+    m_Reslicer->Modified();
+    m_Reslicer->Update();
+
+    if ( this->IsOutdated( generation ) )
+    {
+      return false;
+    }
+
+    m_TSFilter->SetThickSliceMode( request.m_ThickSlicesMode - 1 );
+    m_TSFilter->SetInput( m_Reslicer->GetVtkOutput() );
+    m_TSFilter->Modified();
+    m_TSFilter->Update();
+    slice = m_TSFilter->GetOutput();
+  }
+  else
+  {
+    m_Reslicer->SetOutputDimensionality( 2 );
+    m_Reslicer->SetOutputSpacingZDirection( 1.0 );
+    m_Reslicer->SetOutputExtentZDirection( 0, 0 );
+    m_Reslicer->Modified();
+    m_Reslicer->UpdateLargestPossibleRegion();
+    slice = m_Reslicer->GetVtkOutput();
+  }
+
+  if ( slice == NULL || this->IsOutdated( generation ) )
+  {
+    return false;
+  }
+
+  // the pipeline output is reused by the next request, so hand out a copy
+  result.m_Generation = generation;
+  result.m_ReslicedImage = vtkSmartPointer<vtkImageData>::New();
+  result.m_ReslicedImage->DeepCopy( slice );
+
+  m_Reslicer->GetClippedPlaneBounds( result.m_SliceBounds );
+
+  ScalarType* spacing = m_Reslicer->GetOutputSpacing();
+  result.m_mmPerPixel[0] = spacing[0];
+  result.m_mmPerPixel[1] = spacing[1];
+
+  result.m_ResliceAxes = vtkSmartPointer<vtkMatrix4x4>::New();
+  result.m_ResliceAxes->DeepCopy( m_Reslicer->GetResliceAxes() );
+
+  return true;
+}
@@ -0,0 +1,205 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#ifndef MITKASYNCSLICERESLICER_H_HEADER_INCLUDED
+#define MITKASYNCSLICERESLICER_H_HEADER_INCLUDED
+
+#include <MitkExports.h>
+#include <mitkCommon.h>
+#include "mitkImage.h"
+#include "mitkGeometry2D.h"
+#include "mitkExtractSliceFilter.h"
+
+#include <itkObject.h>
+#include <itkMultiThreader.h>
+#include <itkMutexLock.h>
+#include <itkConditionVariable.h>
+
+#include <vtkSmartPointer.h>
+
+#include <deque>
+#include <utility>
+#include <vector>
+
+class vtkImageData;
+class vtkMatrix4x4;
+class vtkObject;
+class vtkRenderWindow;
+class vtkCallbackCommand;
+class vtkMitkThickSlicesFilter;
+
+namespace mitk {
+
+/** \brief Reslices image slices on a worker thread for ImageVtkMapper2D.
+ *
+ * Only the most recently submitted request is of interest to a render window:
+ * a new request replaces a pending one, and a request that is currently being
+ * resliced is aborted via the progress events of vtkImageReslice. Every request
+ * is tagged with a generation number, results of outdated generations are
+ * dropped and never returned by FetchResult().
+ *
+ * When a result is ready, a rendering update for the render window of the request
+ * is requested from the application thread (via CallbackFromGUIThread). The mapper
+ * then picks up the result during its next Update().
+ *
+ * Additionally, slices that are likely to be shown next can be queued with
+ * Prefetch(). These requests are only processed while no regular request is
+ * waiting, and their results are collected until FetchPrefetchResults() is called.
+ *
+ * The worker never touches the image of a request. Submit() fetches the volume
+ * of the requested time step on the application thread and wraps its pixels in
+ * a private image, which is resliced by the worker. While reslicing, the worker
+ * holds an ImageReadAccessor of the volume, so that write accessors of the
+ * application wait until the slice is done. If the volume is locked for writing
+ * when the worker starts, the request is dropped; the modification of the image
+ * causes a new request anyway.
+ *
+ * A job may hold the last reference to an image that has been removed from the data
+ * storage meanwhile, and an mitk::Image must not be destroyed on the worker thread.
+ * The worker therefore hands finished jobs back, and they are released by the next
+ * call of one of the public methods on the application thread (usually the
+ * FetchResult() of the update the worker has requested) or by the destructor.
+ */
+class MITK_CORE_EXPORT AsyncSliceReslicer : public itk::Object
+{
+public:
+  mitkClassMacro(AsyncSliceReslicer, itk::Object);
+  itkNewMacro(Self);
+
+  /** \brief Everything that is needed to reslice one slice, detached from the renderer. */
+  struct MITK_CORE_EXPORT Request
+  {
+    Request();
+
+    Image::ConstPointer m_Image;
+    /** \brief Private copy of the world geometry, the one of the renderer changes while scrolling. */
+    Geometry2D::ConstPointer m_WorldGeometry;
+    unsigned int m_TimeStep;
+    ExtractSliceFilter::ResliceInterpolation m_InterpolationMode;
+    bool m_InPlaneResampleExtentByGeometry;
+    /** \brief Thick slice mode as used by the "reslice.thickslices" property, 0 means off. */
+    int m_ThickSlicesMode;
+    int m_ThickSlicesNum;
+    double m_DataZSpacing;
+    /** \brief Modification time of the image when the request was made. */
+    unsigned long m_DataMTime;
+    /** \brief Render window which is asked to update once the result is available. May be NULL. */
+    vtkRenderWindow* m_RenderWindow;
+  };
+
+  /** \brief The resliced slice and the placement information the mapper needs to display it. */
+  struct MITK_CORE_EXPORT Result
+  {
+    Result();
+
+    unsigned long m_Generation;
+    vtkSmartPointer<vtkImageData> m_ReslicedImage;
+    vtkFloatingPointType m_SliceBounds[6];
+    ScalarType m_mmPerPixel[2];
+    vtkSmartPointer<vtkMatrix4x4> m_ResliceAxes;
+  };
+
+  /** \brief Queues a request, superseding any older one.
+   *  \return The generation number of the request. */
+  unsigned long Submit(const Request& request);
+
+  /** \brief Drops the pending request and aborts the one that is currently processed. */
+  void Cancel();
+
+  /** \brief Takes the result of the latest request.
+   *  \return false if the latest request is not finished yet or has been cancelled. */
+  bool FetchResult(Result& result);
+
+  /** \brief Generation number of the latest request. */
+  unsigned long GetCurrentGeneration() const;
+
+  typedef std::vector< std::pair<Request, Result> > PrefetchResultList;
+
+  /** \brief Replaces the queue of slices to compute while the worker is idle. */
+  void Prefetch(const std::vector<Request>& requests);
+
+  /** \brief Appends all prefetched slices computed so far to results and forgets them. */
+  void FetchPrefetchResults(PrefetchResultList& results);
+
+protected:
+  AsyncSliceReslicer();
+  virtual ~AsyncSliceReslicer();
+
+  /** \brief A request together with the data the worker uses instead of the image of the request. */
+  struct Job
+  {
+    Request m_Request;
+    /** \brief Volume of the requested time step, keeps the pixels alive and is locked while reslicing. */
+    ImageDataItem::Pointer m_Volume;
+    /** \brief Private image with the geometry of the request's image, referencing the pixels of m_Volume. */
+    Image::Pointer m_Snapshot;
+  };
+
+  /** \brief Prepares a request for the worker, must be called from the application thread.
+   *  \return false if the image has no data for the requested time step. */
+  static bool PrepareJob(const Request& request, Job& job);
+
+  static ITK_THREAD_RETURN_TYPE ThreadStartReslicing(void* pInfoStruct);
+
+  static void AbortCallback(vtkObject* caller, unsigned long eventId, void* clientData, void* callData);
+
+  /** \brief Main loop of the worker thread. */
+  void ProcessRequests();
+
+  /** \brief Reslices one request on the worker thread.
+   *  \return false if the request became outdated in the meantime. */
+  bool Reslice(const Job& job, unsigned long generation, Result& result);
+
+  bool IsOutdated(unsigned long generation) const;
+
+  /** \brief Destroys the jobs the worker has finished, must be called from the application thread. */
+  void ReleaseFinishedJobs();
+
+  itk::MultiThreader::Pointer m_MultiThreader;
+  int m_ThreadID;
+
+  mutable itk::SimpleMutexLock m_Mutex;
+  itk::ConditionVariable::Pointer m_RequestAvailable;
+
+  bool m_StopThread;
+  unsigned long m_Generation;
+  unsigned long m_RunningGeneration;
+  bool m_RunningPrefetch;
+
+  bool m_HasPendingRequest;
+  Job m_PendingJob;
+  unsigned long m_PendingGeneration;
+
+  bool m_HasResult;
+  Result m_Result;
+
+  unsigned long m_PrefetchGeneration;
+  std::deque<Job> m_PrefetchJobs;
+  PrefetchResultList m_PrefetchResults;
+
+  /** \brief Jobs the worker is done with, kept until the application thread releases them. */
+  std::vector<Job> m_FinishedJobs;
+
+  /** Pipeline used by the worker thread only */
+  vtkSmartPointer<vtkImageReslice> m_VtkReslice;
+  ExtractSliceFilter::Pointer m_Reslicer;
+  vtkSmartPointer<vtkMitkThickSlicesFilter> m_TSFilter;
+  vtkSmartPointer<vtkCallbackCommand> m_AbortCommand;
+};
+
+} // namespace mitk
+
+#endif /* MITKASYNCSLICERESLICER_H_HEADER_INCLUDED */
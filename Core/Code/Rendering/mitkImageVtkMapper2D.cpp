@@ -24,6 +24,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <mitkPlaneGeometry.h>
 #include <mitkProperties.h>
 #include <mitkResliceMethodProperty.h>
+#include <mitkSlicedGeometry3D.h>
 #include <mitkTimeSlicedGeometry.h>
 #include <mitkVtkResliceInterpolationProperty.h>
 #include <mitkPixelType.h>
@@ -56,6 +57,8 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 //ITK
 #include <itkRGBAPixel.h>
+
+#include <algorithm>
 #include <mitkRenderingModeProperty.h>
 
 mitk::ImageVtkMapper2D::ImageVtkMapper2D()
@@ -146,28 +149,22 @@ void mitk::ImageVtkMapper2D::GenerateDataForRenderer( mitk::BaseRenderer *render
     // see bug-13275
     localStorage->m_ReslicedImage = NULL;
     localStorage->m_Mapper->SetInput( localStorage->m_EmptyPolyData );
+    if ( localStorage->m_AsyncReslicer.IsNotNull() )
+    {
+      localStorage->m_AsyncReslicer->Cancel();
+    }
     return;
   }
 
 
-  //set main input for ExtractSliceFilter
-  localStorage->m_Reslicer->SetInput(input);
-  localStorage->m_Reslicer->SetWorldGeometry(worldGeometry);
-  localStorage->m_Reslicer->SetTimeStep( this->GetTimestep() );
-
-
-  //set the transformation of the image to adapt reslice axis
-  localStorage->m_Reslicer->SetResliceTransformByGeometry( input->GetTimeSlicedGeometry()->GetGeometry3D( this->GetTimestep() ) );
-
-
   //is the geometry of the slice based on the input image or the worldgeometry?
   bool inPlaneResampleExtentByGeometry = false;
   datanode->GetBoolProperty("in plane resample extent by geometry", inPlaneResampleExtentByGeometry, renderer);
-  localStorage->m_Reslicer->SetInPlaneResampleExtentByGeometry(inPlaneResampleExtentByGeometry);
 
 
   // Initialize the interpolation mode for resampling; switch to nearest
   // neighbor if the input image is too small.
+  ExtractSliceFilter::ResliceInterpolation interpolation = ExtractSliceFilter::RESLICE_NEAREST;
   if ( (input->GetDimension() >= 3) && (input->GetDimension(2) > 1) )
   {
     VtkResliceInterpolationProperty *resliceInterpolationProperty;
@@ -183,24 +180,16 @@ void mitk::ImageVtkMapper2D::GenerateDataForRenderer( mitk::BaseRenderer *render
     switch ( interpolationMode )
     {
     case VTK_RESLICE_NEAREST:
-      localStorage->m_Reslicer->SetInterpolationMode(ExtractSliceFilter::RESLICE_NEAREST);
+      interpolation = ExtractSliceFilter::RESLICE_NEAREST;
       break;
     case VTK_RESLICE_LINEAR:
-      localStorage->m_Reslicer->SetInterpolationMode(ExtractSliceFilter::RESLICE_LINEAR);
+      interpolation = ExtractSliceFilter::RESLICE_LINEAR;
       break;
     case VTK_RESLICE_CUBIC:
-      localStorage->m_Reslicer->SetInterpolationMode(ExtractSliceFilter::RESLICE_CUBIC);
+      interpolation = ExtractSliceFilter::RESLICE_CUBIC;
       break;
     }
   }
-  else
-  {
-    localStorage->m_Reslicer->SetInterpolationMode(ExtractSliceFilter::RESLICE_NEAREST);
-  }
-
-  //set the vtk output property to true, makes sure that no unneeded mitk image convertion
-  //is done.
-  localStorage->m_Reslicer->SetVtkOutputRequest(true);
 
 
   //Thickslicing
@@ -233,10 +222,9 @@ void mitk::ImageVtkMapper2D::GenerateDataForRenderer( mitk::BaseRenderer *render
 
   const PlaneGeometry *planeGeometry = dynamic_cast< const PlaneGeometry * >( worldGeometry );
 
+  double dataZSpacing = 1.0;
   if(thickSlicesMode > 0)
   {
-    double dataZSpacing = 1.0;
-
     Vector3D normInIndex, normal;
 
     if ( planeGeometry != NULL ){
@@ -253,7 +241,87 @@ void mitk::ImageVtkMapper2D::GenerateDataForRenderer( mitk::BaseRenderer *render
     input->GetTimeSlicedGeometry()->GetGeometry3D( this->GetTimestep() )->WorldToIndex( normal, normInIndex );
 
     dataZSpacing = 1.0 / normInIndex.GetNorm();
+  }
+
+
+  // everything that determines the content of the slice, used as key of the
+  // slice cache and for reslicing in the background
+  AsyncSliceReslicer::Request request;
+  request.m_Image = input;
+  request.m_WorldGeometry = worldGeometry;
+  request.m_TimeStep = this->GetTimestep();
+  request.m_InterpolationMode = interpolation;
+  request.m_InPlaneResampleExtentByGeometry = inPlaneResampleExtentByGeometry;
+  request.m_ThickSlicesMode = thickSlicesMode;
+  request.m_ThickSlicesNum = thickSlicesNum;
+  request.m_DataZSpacing = dataZSpacing;
+  request.m_DataMTime = input->GetMTime();
+
+  int cacheSize = 0;
+  datanode->GetIntProperty( "reslice cache size", cacheSize, renderer );
+  localStorage->m_SliceCache.SetMaximumSize( cacheSize > 0 ? cacheSize : 0 );
+  this->CollectPrefetchedSlices( renderer );
+
+  AsyncSliceReslicer::Result cachedSlice;
+  if ( localStorage->m_SliceCache.Get( request, cachedSlice ) )
+  {
+    if ( localStorage->m_AsyncReslicer.IsNotNull() )
+    {
+      localStorage->m_AsyncReslicer->Cancel();
+    }
+    this->PrefetchNeighboringSlices( renderer, request );
+    this->GenerateActorForSlice( renderer, cachedSlice );
+    return;
+  }
+
+  // Interpolated and thick slices can be computed in the background. Until the
+  // result arrives, a nearest neighbor slice without thick slicing is shown.
+  bool asynchronous = false;
+  datanode->GetBoolProperty( "reslice asynchronous", asynchronous, renderer );
+  asynchronous = asynchronous && ( interpolation != ExtractSliceFilter::RESLICE_NEAREST || thickSlicesMode > 0 );
 
+  if ( asynchronous )
+  {
+    if ( localStorage->m_AsyncReslicer.IsNull() )
+    {
+      localStorage->m_AsyncReslicer = AsyncSliceReslicer::New();
+    }
+
+    AsyncSliceReslicer::Request asyncRequest = request;
+    asyncRequest.m_WorldGeometry = worldGeometry->Clone().GetPointer();
+    asyncRequest.m_RenderWindow = renderer->GetRenderWindow();
+    localStorage->m_AsyncReslicer->Submit( asyncRequest );
+    localStorage->m_AsyncRequest = asyncRequest;
+
+    interpolation = ExtractSliceFilter::RESLICE_NEAREST;
+    thickSlicesMode = 0;
+  }
+  else if ( localStorage->m_AsyncReslicer.IsNotNull() )
+  {
+    // a result that is still computed for an older request must not replace this slice
+    localStorage->m_AsyncReslicer->Cancel();
+  }
+
+
+  //set main input for ExtractSliceFilter
+  localStorage->m_Reslicer->SetInput(input);
+  localStorage->m_Reslicer->SetWorldGeometry(worldGeometry);
+  localStorage->m_Reslicer->SetTimeStep( this->GetTimestep() );
+
+
+  //set the transformation of the image to adapt reslice axis
+  localStorage->m_Reslicer->SetResliceTransformByGeometry( input->GetTimeSlicedGeometry()->GetGeometry3D( this->GetTimestep() ) );
+
+  localStorage->m_Reslicer->SetInPlaneResampleExtentByGeometry(inPlaneResampleExtentByGeometry);
+  localStorage->m_Reslicer->SetInterpolationMode(interpolation);
+
+  //set the vtk output property to true, makes sure that no unneeded mitk image convertion
+  //is done.
+  localStorage->m_Reslicer->SetVtkOutputRequest(true);
+
+
+  if(thickSlicesMode > 0)
+  {
     localStorage->m_Reslicer->SetOutputDimensionality( 3 );
     localStorage->m_Reslicer->SetOutputSpacingZDirection(dataZSpacing);
     localStorage->m_Reslicer->SetOutputExtentZDirection( -thickSlicesNum, 0+thickSlicesNum );
@@ -297,7 +365,140 @@ void mitk::ImageVtkMapper2D::GenerateDataForRenderer( mitk::BaseRenderer *render
   localStorage->m_Reslicer->GetClippedPlaneBounds(sliceBounds);
 
   //get the spacing of the slice
-  localStorage->m_mmPerPixel = localStorage->m_Reslicer->GetOutputSpacing();
+  localStorage->m_mmPerPixel[0] = localStorage->m_Reslicer->GetOutputSpacing()[0];
+  localStorage->m_mmPerPixel[1] = localStorage->m_Reslicer->GetOutputSpacing()[1];
+
+  //get the transformation of the slice
+  localStorage->m_ResliceAxes->DeepCopy( localStorage->m_Reslicer->GetResliceAxes() );
+
+  // the preview is not cached, the full quality slice is added once it arrives
+  if ( !asynchronous && localStorage->m_SliceCache.GetMaximumSize() > 0 )
+  {
+    AsyncSliceReslicer::Result slice;
+    // the reslicer reuses its output, so the cache needs a copy
+    slice.m_ReslicedImage = vtkSmartPointer<vtkImageData>::New();
+    slice.m_ReslicedImage->DeepCopy( localStorage->m_ReslicedImage );
+    for ( int i = 0; i < 6; ++i )
+    {
+      slice.m_SliceBounds[i] = sliceBounds[i];
+    }
+    slice.m_mmPerPixel[0] = localStorage->m_mmPerPixel[0];
+    slice.m_mmPerPixel[1] = localStorage->m_mmPerPixel[1];
+    slice.m_ResliceAxes = vtkSmartPointer<vtkMatrix4x4>::New();
+    slice.m_ResliceAxes->DeepCopy( localStorage->m_ResliceAxes );
+    localStorage->m_SliceCache.Insert( request, slice );
+  }
+
+  this->PrefetchNeighboringSlices( renderer, request );
+
+  this->GenerateActorForReslicedImage( renderer, sliceBounds );
+}
+
+void mitk::ImageVtkMapper2D::GenerateActorForSlice( mitk::BaseRenderer *renderer, const AsyncSliceReslicer::Result& slice )
+{
+  LocalStorage *localStorage = m_LSH.GetLocalStorage(renderer);
+
+  localStorage->m_ReslicedImage = slice.m_ReslicedImage;
+  localStorage->m_mmPerPixel[0] = slice.m_mmPerPixel[0];
+  localStorage->m_mmPerPixel[1] = slice.m_mmPerPixel[1];
+  localStorage->m_ResliceAxes->DeepCopy( slice.m_ResliceAxes );
+
+  vtkFloatingPointType sliceBounds[6];
+  for ( int i = 0; i < 6; ++i )
+  {
+    sliceBounds[i] = slice.m_SliceBounds[i];
+  }
+  this->GenerateActorForReslicedImage( renderer, sliceBounds );
+}
+
+void mitk::ImageVtkMapper2D::CollectPrefetchedSlices( mitk::BaseRenderer *renderer )
+{
+  LocalStorage *localStorage = m_LSH.GetLocalStorage(renderer);
+  if ( localStorage->m_AsyncReslicer.IsNull() )
+  {
+    return;
+  }
+
+  const mitk::Image *input = this->GetInput();
+  AsyncSliceReslicer::PrefetchResultList prefetched;
+  localStorage->m_AsyncReslicer->FetchPrefetchResults( prefetched );
+  for ( AsyncSliceReslicer::PrefetchResultList::const_iterator iter = prefetched.begin();
+        iter != prefetched.end();
+        ++iter )
+  {
+    // slices of modified image data would never be requested again
+    if ( iter->first.m_Image == input && iter->first.m_DataMTime == input->GetMTime() )
+    {
+      localStorage->m_SliceCache.Insert( iter->first, iter->second );
+    }
+  }
+}
+
+void mitk::ImageVtkMapper2D::PrefetchNeighboringSlices( mitk::BaseRenderer *renderer, const AsyncSliceReslicer::Request& request )
+{
+  LocalStorage *localStorage = m_LSH.GetLocalStorage(renderer);
+
+  int numberOfSlices = 0;
+  this->GetDataNode()->GetIntProperty( "reslice prefetch", numberOfSlices, renderer );
+  // keep at least the current slice in the cache
+  numberOfSlices = std::min( numberOfSlices, static_cast<int>( localStorage->m_SliceCache.GetMaximumSize() ) - 1 );
+
+  const TimeSlicedGeometry *worldTimeGeometry = dynamic_cast< const TimeSlicedGeometry * >( renderer->GetWorldGeometry() );
+  const SlicedGeometry3D *slicedWorldGeometry = NULL;
+  if ( worldTimeGeometry != NULL && worldTimeGeometry->IsValidTime( renderer->GetTimeStep() ) )
+  {
+    slicedWorldGeometry = dynamic_cast< const SlicedGeometry3D * >( worldTimeGeometry->GetGeometry3D( renderer->GetTimeStep() ) );
+  }
+
+  if ( numberOfSlices <= 0 || slicedWorldGeometry == NULL )
+  {
+    if ( localStorage->m_AsyncReslicer.IsNotNull() )
+    {
+      localStorage->m_AsyncReslicer->Prefetch( std::vector<AsyncSliceReslicer::Request>() );
+    }
+    return;
+  }
+
+  // prefetch in the direction the user is scrolling
+  int slice = static_cast<int>( renderer->GetSlice() );
+  if ( slice != localStorage->m_LastSlice )
+  {
+    localStorage->m_ScrollDirection = ( slice > localStorage->m_LastSlice ) ? 1 : -1;
+    localStorage->m_LastSlice = slice;
+  }
+
+  std::vector<AsyncSliceReslicer::Request> prefetchRequests;
+  for ( int i = 1; i <= numberOfSlices; ++i )
+  {
+    int neighbor = slice + i * localStorage->m_ScrollDirection;
+    if ( neighbor < 0 || !slicedWorldGeometry->IsValidSlice( neighbor ) )
+    {
+      break;
+    }
+
+    AsyncSliceReslicer::Request neighborRequest = request;
+    neighborRequest.m_WorldGeometry = slicedWorldGeometry->GetGeometry2D( neighbor )->Clone().GetPointer();
+    neighborRequest.m_RenderWindow = NULL;
+    if ( !localStorage->m_SliceCache.Contains( neighborRequest ) )
+    {
+      prefetchRequests.push_back( neighborRequest );
+    }
+  }
+
+  if ( localStorage->m_AsyncReslicer.IsNull() )
+  {
+    localStorage->m_AsyncReslicer = AsyncSliceReslicer::New();
+  }
+  localStorage->m_AsyncReslicer->Prefetch( prefetchRequests );
+}
+
+void mitk::ImageVtkMapper2D::GenerateActorForReslicedImage( mitk::BaseRenderer *renderer, vtkFloatingPointType sliceBounds[6] )
+{
+  LocalStorage *localStorage = m_LSH.GetLocalStorage(renderer);
+
+  mitk::Image *input = const_cast< mitk::Image * >( this->GetInput() );
+  mitk::DataNode* datanode = this->GetDataNode();
+  const PlaneGeometry *planeGeometry = dynamic_cast< const PlaneGeometry * >( renderer->GetCurrentWorldGeometry2D() );
 
   // calculate minimum bounding rect of IMAGE in texture
   {
@@ -653,6 +854,16 @@ void mitk::ImageVtkMapper2D::Update(mitk::BaseRenderer* renderer)
   {
     this->GenerateDataForRenderer( renderer );
   }
+  else if ( localStorage->m_AsyncReslicer.IsNotNull() )
+  {
+    // replace the preview by the full quality slice once it has been computed
+    AsyncSliceReslicer::Result result;
+    if ( localStorage->m_AsyncReslicer->FetchResult( result ) )
+    {
+      localStorage->m_SliceCache.Insert( localStorage->m_AsyncRequest, result );
+      this->GenerateActorForSlice( renderer, result );
+    }
+  }
 
   // since we have checked that nothing important has changed, we can set
   // m_LastUpdateTime to the current time
@@ -674,6 +885,9 @@ void mitk::ImageVtkMapper2D::SetDefaultProperties(mitk::DataNode* node, mitk::Ba
   else node->AddProperty( "reslice interpolation", mitk::VtkResliceInterpolationProperty::New() );
   node->AddProperty( "texture interpolation", mitk::BoolProperty::New( mitk::DataNodeFactory::m_TextureInterpolationActive ) );  // set to user configurable default value (see global options)
   node->AddProperty( "in plane resample extent by geometry", mitk::BoolProperty::New( false ) );
+  node->AddProperty( "reslice asynchronous", mitk::BoolProperty::New( false ) );
+  node->AddProperty( "reslice cache size", mitk::IntProperty::New( 0 ) );
+  node->AddProperty( "reslice prefetch", mitk::IntProperty::New( 0 ) );
   node->AddProperty( "bounding box", mitk::BoolProperty::New( false ) );
 
   mitk::RenderingModeProperty::Pointer renderingModeProperty = mitk::RenderingModeProperty::New();
@@ -966,8 +1180,7 @@ void mitk::ImageVtkMapper2D::TransformActor(mitk::BaseRenderer* renderer)
   LocalStorage *localStorage = m_LSH.GetLocalStorage(renderer);
   //get the transformation matrix of the reslicer in order to render the slice as axial, coronal or saggital
   vtkSmartPointer<vtkTransform> trans = vtkSmartPointer<vtkTransform>::New();
-  vtkSmartPointer<vtkMatrix4x4> matrix = localStorage->m_Reslicer->GetResliceAxes();
-  trans->SetMatrix(matrix);
+  trans->SetMatrix(localStorage->m_ResliceAxes);
   //transform the plane/contour (the actual actor) to the corresponding view (axial, coronal or saggital)
   localStorage->m_Actor->SetUserTransform(trans);
   //transform the origin to center based coordinates, because MITK is center based.
@@ -1031,6 +1244,9 @@ mitk::ImageVtkMapper2D::LocalStorage::LocalStorage()
   m_TSFilter = vtkSmartPointer<vtkMitkThickSlicesFilter>::New();
   m_OutlinePolyData = vtkSmartPointer<vtkPolyData>::New();
   m_ReslicedImage = vtkSmartPointer<vtkImageData>::New();
+  m_ResliceAxes = vtkSmartPointer<vtkMatrix4x4>::New();
+  m_LastSlice = 0;
+  m_ScrollDirection = 1;
   m_EmptyPolyData = vtkSmartPointer<vtkPolyData>::New();
 
   //the following actions are always the same and thus can be performed
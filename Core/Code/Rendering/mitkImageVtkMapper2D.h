@@ -24,6 +24,8 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "mitkBaseRenderer.h"
 #include "mitkVtkMapper.h"
 #include "mitkExtractSliceFilter.h"
+#include "mitkAsyncSliceReslicer.h"
+#include "mitkSliceCache.h"
 
 //VTK
 #include <vtkSmartPointer.h>
@@ -35,6 +37,7 @@ class vtkPlaneSource;
 class vtkImageData;
 class vtkLookupTable;
 class vtkImageReslice;
+class vtkMatrix4x4;
 class vtkImageChangeInformation;
 class vtkPoints;
 class vtkMitkThickSlicesFilter;
@@ -88,6 +91,12 @@ namespace mitk {
  *   - \b "texture interpolation": (BoolProperty) texture interpolation of the image
  *   - \b "reslice interpolation": (VtkResliceInterpolationProperty) reslice interpolation of the image
  *   - \b "in plane resample extent by geometry": (BoolProperty) Do it or not
+ *   - \b "reslice asynchronous": (BoolProperty) Show a nearest neighbor preview first and compute
+          linear, cubic or thick slices on a worker thread
+ *   - \b "reslice cache size": (IntProperty) Number of resliced slices kept per render window, 0 disables the cache.
+          Each cached slice costs a copy of the slice, so the cache is off unless it is asked for
+ *   - \b "reslice prefetch": (IntProperty) Number of slices in scroll direction that are resliced in the background,
+          at most "reslice cache size" - 1
  *   - \b "bounding box": (BoolProperty) Is the Bounding Box of the image shown or not
  *   - \b "layer": (IntProperty) Layer of the image
  *   - \b "volume annotation color": (ColorProperty) color of the volume annotation, TODO has to be reimplemented
@@ -103,6 +112,9 @@ namespace mitk {
  *   - \b "texture interpolation", mitk::BoolProperty::New( mitk::DataNodeFactory::m_TextureInterpolationActive ) )
  *   - \b "reslice interpolation", mitk::VtkResliceInterpolationProperty::New() )
  *   - \b "in plane resample extent by geometry", mitk::BoolProperty::New( false ) )
+ *   - \b "reslice asynchronous", mitk::BoolProperty::New( false ) )
+ *   - \b "reslice cache size", mitk::IntProperty::New( 0 ) )
+ *   - \b "reslice prefetch", mitk::IntProperty::New( 0 ) )
  *   - \b "bounding box", mitk::BoolProperty::New( false ) )
  *   - \b "layer", mitk::IntProperty::New(10), renderer, overwrite)
  *   - \b "Image Rendering.Transfer Function":  Default color transfer function for CTs
@@ -182,7 +194,25 @@ public:
     itk::TimeStamp m_LastUpdateTime;
 
     /** \brief mmPerPixel relation between pixel and mm. (World spacing).*/
-    mitk::ScalarType* m_mmPerPixel;
+    mitk::ScalarType m_mmPerPixel[2];
+
+    /** \brief Reslice axes of m_ReslicedImage, used to place the actor. */
+    vtkSmartPointer<vtkMatrix4x4> m_ResliceAxes;
+
+    /** \brief Computes full quality slices in the background if "reslice asynchronous" is set.
+          Created on first use. */
+    mitk::AsyncSliceReslicer::Pointer m_AsyncReslicer;
+
+    /** \brief The request that was handed to m_AsyncReslicer last. */
+    mitk::AsyncSliceReslicer::Request m_AsyncRequest;
+
+    /** \brief Recently shown and prefetched slices, see "reslice cache size". */
+    mitk::SliceCache m_SliceCache;
+
+    /** \brief Slice of the renderer at the last reslicing, used to find the scroll direction. */
+    int m_LastSlice;
+    /** \brief +1 or -1, direction in which neighboring slices are prefetched. */
+    int m_ScrollDirection;
 
     /** \brief This filter is used to apply the level window to Grayvalue and RBG(A) images. */
     vtkSmartPointer<vtkMitkLevelWindowFilter> m_LevelWindowFilter;
@@ -255,6 +285,24 @@ protected:
     */
   virtual void GenerateDataForRenderer(mitk::BaseRenderer *renderer);
 
+  /** \brief Sets up texture, plane and actor for the slice in m_ReslicedImage.
+    * Used after synchronous reslicing as well as for results of the asynchronous reslicer.
+    * \param sliceBounds Bounds of the resliced plane in milimeters.
+    */
+  void GenerateActorForReslicedImage(mitk::BaseRenderer *renderer, vtkFloatingPointType sliceBounds[6]);
+
+  /** \brief Shows a slice that was taken from the slice cache or computed in the background. */
+  void GenerateActorForSlice(mitk::BaseRenderer *renderer, const AsyncSliceReslicer::Result& slice);
+
+  /** \brief Moves slices that have been prefetched in the background into the slice cache. */
+  void CollectPrefetchedSlices(mitk::BaseRenderer *renderer);
+
+  /** \brief Queues the next slices in scroll direction for background reslicing,
+    * as configured by the property "reslice prefetch".
+    * \param request Parameters of the current slice, only the geometry differs for the neighbors.
+    */
+  void PrefetchNeighboringSlices(mitk::BaseRenderer *renderer, const AsyncSliceReslicer::Request& request);
+
   /** \brief This method uses the vtkCamera clipping range and the layer property
     * to calcualte the depth of the object (e.g. image or contour). The depth is used
     * to keep the correct order for the final VTK rendering.*/
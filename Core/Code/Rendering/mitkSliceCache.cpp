@@ -0,0 +1,167 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkSliceCache.h"
+#include "mitkPlaneGeometry.h"
+
+bool mitk::SliceCache::Key::operator<(const Key& other) const
+{
+  if ( m_Image != other.m_Image ) return m_Image < other.m_Image;
+  if ( m_DataMTime != other.m_DataMTime ) return m_DataMTime < other.m_DataMTime;
+  if ( m_TimeStep != other.m_TimeStep ) return m_TimeStep < other.m_TimeStep;
+  if ( m_InterpolationMode != other.m_InterpolationMode ) return m_InterpolationMode < other.m_InterpolationMode;
+  if ( m_InPlaneResampleExtentByGeometry != other.m_InPlaneResampleExtentByGeometry ) return other.m_InPlaneResampleExtentByGeometry;
+  if ( m_ThickSlicesMode != other.m_ThickSlicesMode ) return m_ThickSlicesMode < other.m_ThickSlicesMode;
+  if ( m_ThickSlicesNum != other.m_ThickSlicesNum ) return m_ThickSlicesNum < other.m_ThickSlicesNum;
+  if ( m_ReferenceGeometry != other.m_ReferenceGeometry ) return m_ReferenceGeometry < other.m_ReferenceGeometry;
+  return m_Plane < other.m_Plane;
+}
+
+mitk::SliceCache::SliceCache()
+  : m_MaximumSize(0),
+    m_Hits(0),
+    m_Misses(0)
+{
+}
+
+void mitk::SliceCache::SetMaximumSize(unsigned int size)
+{
+  m_MaximumSize = size;
+  while ( m_Entries.size() > m_MaximumSize )
+  {
+    m_Index.erase( m_Entries.back().first );
+    m_Entries.pop_back();
+  }
+}
+
+unsigned int mitk::SliceCache::GetMaximumSize() const
+{
+  return m_MaximumSize;
+}
+
+unsigned int mitk::SliceCache::GetSize() const
+{
+  return static_cast<unsigned int>( m_Entries.size() );
+}
+
+bool mitk::SliceCache::MakeKey(const Request& request, Key& key)
+{
+  // slices of curved geometries are not worth caching
+  const PlaneGeometry* planeGeometry = dynamic_cast<const PlaneGeometry*>( request.m_WorldGeometry.GetPointer() );
+  if ( request.m_Image.IsNull() || planeGeometry == NULL )
+  {
+    return false;
+  }
+
+  key.m_Image = request.m_Image;
+  key.m_DataMTime = request.m_DataMTime;
+  key.m_TimeStep = request.m_TimeStep;
+  key.m_InterpolationMode = request.m_InterpolationMode;
+  key.m_InPlaneResampleExtentByGeometry = request.m_InPlaneResampleExtentByGeometry;
+  key.m_ThickSlicesMode = request.m_ThickSlicesMode;
+  key.m_ThickSlicesNum = request.m_ThickSlicesMode > 0 ? request.m_ThickSlicesNum : 0;
+  key.m_ReferenceGeometry = planeGeometry->GetReferenceGeometry();
+
+  const Point3D origin = planeGeometry->GetOrigin();
+  const Vector3D right = planeGeometry->GetAxisVector( 0 );
+  const Vector3D bottom = planeGeometry->GetAxisVector( 1 );
+
+  key.m_Plane.clear();
+  key.m_Plane.reserve( 11 );
+  for ( unsigned int i = 0; i < 3; ++i )
+  {
+    key.m_Plane.push_back( origin[i] );
+    key.m_Plane.push_back( right[i] );
+    key.m_Plane.push_back( bottom[i] );
+  }
+  key.m_Plane.push_back( planeGeometry->GetExtent( 0 ) );
+  key.m_Plane.push_back( planeGeometry->GetExtent( 1 ) );
+
+  return true;
+}
+
+bool mitk::SliceCache::Get(const Request& request, Result& result)
+{
+  Key key;
+  if ( m_MaximumSize == 0 || !MakeKey( request, key ) )
+  {
+    return false;
+  }
+
+  EntryIndex::iterator indexIter = m_Index.find( key );
+  if ( indexIter == m_Index.end() )
+  {
+    ++m_Misses;
+    return false;
+  }
+
+  // move to the front of the list, which holds the most recently used slice
+  m_Entries.splice( m_Entries.begin(), m_Entries, indexIter->second );
+  result = m_Entries.front().second;
+  ++m_Hits;
+  return true;
+}
+
+bool mitk::SliceCache::Contains(const Request& request) const
+{
+  Key key;
+  if ( m_MaximumSize == 0 || !MakeKey( request, key ) )
+  {
+    return false;
+  }
+  return m_Index.find( key ) != m_Index.end();
+}
+
+void mitk::SliceCache::Insert(const Request& request, const Result& result)
+{
+  Key key;
+  if ( m_MaximumSize == 0 || result.m_ReslicedImage == NULL || !MakeKey( request, key ) )
+  {
+    return;
+  }
+
+  EntryIndex::iterator indexIter = m_Index.find( key );
+  if ( indexIter != m_Index.end() )
+  {
+    m_Entries.erase( indexIter->second );
+    m_Index.erase( indexIter );
+  }
+
+  m_Entries.push_front( std::make_pair( key, result ) );
+  m_Index[key] = m_Entries.begin();
+
+  while ( m_Entries.size() > m_MaximumSize )
+  {
+    m_Index.erase( m_Entries.back().first );
+    m_Entries.pop_back();
+  }
+}
+
+void mitk::SliceCache::Clear()
+{
+  m_Entries.clear();
+  m_Index.clear();
+}
+
+unsigned long mitk::SliceCache::GetNumberOfHits() const
+{
+  return m_Hits;
+}
+
+unsigned long mitk::SliceCache::GetNumberOfMisses() const
+{
+  return m_Misses;
+}
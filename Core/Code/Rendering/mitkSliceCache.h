@@ -0,0 +1,99 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#ifndef MITKSLICECACHE_H_HEADER_INCLUDED
+#define MITKSLICECACHE_H_HEADER_INCLUDED
+
+#include <MitkExports.h>
+#include "mitkAsyncSliceReslicer.h"
+
+#include <list>
+#include <map>
+#include <vector>
+
+namespace mitk {
+
+/** \brief Least recently used cache of resliced 2D slices.
+ *
+ * Slices are identified by the parameters of the request they were resliced
+ * for: image and its modification time, time step, plane geometry, interpolation
+ * and thick slice settings. Requests for non planar geometries are not cached.
+ *
+ * Used by ImageVtkMapper2D to avoid reslicing when the user scrolls back and
+ * forth and to store slices that were prefetched by AsyncSliceReslicer.
+ */
+class MITK_CORE_EXPORT SliceCache
+{
+public:
+  typedef AsyncSliceReslicer::Request Request;
+  typedef AsyncSliceReslicer::Result Result;
+
+  SliceCache();
+
+  /** \brief Sets the maximum number of cached slices, 0 disables the cache. */
+  void SetMaximumSize(unsigned int size);
+  unsigned int GetMaximumSize() const;
+
+  unsigned int GetSize() const;
+
+  /** \brief Looks up the slice for request and marks it as most recently used. */
+  bool Get(const Request& request, Result& result);
+
+  /** \brief Checks whether the slice for request is cached without changing the order. */
+  bool Contains(const Request& request) const;
+
+  /** \brief Stores the slice for request, evicting the least recently used one if necessary.
+   *  The cache keeps a reference to the image data of result, it must not be modified afterwards. */
+  void Insert(const Request& request, const Result& result);
+
+  void Clear();
+
+  unsigned long GetNumberOfHits() const;
+  unsigned long GetNumberOfMisses() const;
+
+protected:
+  struct Key
+  {
+    const Image* m_Image;
+    unsigned long m_DataMTime;
+    unsigned int m_TimeStep;
+    int m_InterpolationMode;
+    bool m_InPlaneResampleExtentByGeometry;
+    int m_ThickSlicesMode;
+    int m_ThickSlicesNum;
+    const Geometry3D* m_ReferenceGeometry;
+    /** \brief Origin, axis vectors and extent of the plane */
+    std::vector<ScalarType> m_Plane;
+
+    bool operator<(const Key& other) const;
+  };
+
+  static bool MakeKey(const Request& request, Key& key);
+
+  typedef std::list< std::pair<Key, Result> > EntryList;
+  typedef std::map< Key, EntryList::iterator > EntryIndex;
+
+  EntryList m_Entries;
+  EntryIndex m_Index;
+  unsigned int m_MaximumSize;
+
+  unsigned long m_Hits;
+  unsigned long m_Misses;
+};
+
+} // namespace mitk
+
+#endif /* MITKSLICECACHE_H_HEADER_INCLUDED */
@@ -513,6 +513,30 @@ void TestDataStorage( mitk::DataStorage* ds, std::string filename )
     /* Checking named node method with wrong name */
     MITK_TEST_CONDITION(ds->GetNamedNode("This name does not exist") == NULL, "Checking named node method with wrong name");
 
+    /* Checking named node method after renaming a node */
+    n5->SetProperty("name", mitk::StringProperty::New("Node 5 - renamed"));
+    MITK_TEST_CONDITION((ds->GetNamedNode("Node 5") == NULL) && (ds->GetNamedNode("Node 5 - renamed") == n5), "Checking named node method after renaming a node");
+    n5->SetProperty("name", mitk::StringProperty::New("Node 5"));
+    MITK_TEST_CONDITION(ds->GetNamedNode("Node 5") == n5, "Checking named node method after restoring the name of a node");
+
+    /* Checking property index of a StandaloneDataStorage */
+    if (mitk::StandaloneDataStorage* sds = dynamic_cast<mitk::StandaloneDataStorage*>(ds))
+    {
+      MITK_TEST_CONDITION(sds->IsIndexedPropertyKey("name"), "Checking that the name property is indexed by default");
+      mitk::NodePredicateProperty::Pointer predicate(mitk::NodePredicateProperty::New("Resection Proposal 2", mitk::GroupTagProperty::New()));
+      mitk::DataStorage::SetOfObjects::ConstPointer unindexed = ds->GetSubset(predicate);
+      sds->AddIndexedPropertyKey("Resection Proposal 2");
+      MITK_TEST_CONDITION(sds->IsIndexedPropertyKey("Resection Proposal 2"), "Checking AddIndexedPropertyKey()");
+      mitk::DataStorage::SetOfObjects::ConstPointer indexed = ds->GetSubset(predicate);
+      MITK_TEST_CONDITION(
+        (indexed->Size() == 2) && (unindexed->Size() == 2)
+        && (indexed->GetElement(0) == unindexed->GetElement(0))
+        && (indexed->GetElement(1) == unindexed->GetElement(1))
+        , "Checking indexed GetSubset() against the unindexed result");
+      sds->RemoveIndexedPropertyKey("Resection Proposal 2");
+      MITK_TEST_CONDITION(!sds->IsIndexedPropertyKey("Resection Proposal 2"), "Checking RemoveIndexedPropertyKey()");
+    }
+
     /* Checking named object method */
     MITK_TEST_CONDITION(ds->GetNamedObject<mitk::Image>("Node 1 - Image Node") == image, "Checking named object method");
     MITK_TEST_CONDITION(ds->GetNamedObject<mitk::Image>(std::string("Node 1 - Image Node")) == image, "Checking named object(std::string) method");
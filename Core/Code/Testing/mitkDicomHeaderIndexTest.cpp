@@ -0,0 +1,96 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include <mitkTestingMacros.h>
+#include "mitkDicomHeaderIndex.h"
+
+#include <cstdio>
+#include <fstream>
+
+static void WriteFile(const std::string& filename, const std::string& content)
+{
+  std::ofstream stream( filename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc );
+  stream << content;
+}
+
+int mitkDicomHeaderIndexTest(int /*argc*/, char* /*argv*/[])
+{
+  MITK_TEST_BEGIN("DicomHeaderIndexTest");
+
+  std::string outDir = MITK_TEST_OUTPUT_DIR;
+  std::string dicomFile = outDir + "/dicomHeaderIndexTest.dcm";
+  std::string otherFile = outDir + "/dicomHeaderIndexTest.txt";
+  std::string indexFile = outDir + "/dicomHeaderIndexTest.index";
+
+  WriteFile( dicomFile, "not really DICOM, but the index does not care" );
+  WriteFile( otherFile, "no DICOM" );
+
+  const gdcm::Tag seriesUID(0x0020, 0x000e);
+  const gdcm::Tag imagePosition(0x0020, 0x0032);
+  const gdcm::Tag patientName(0x0010, 0x0010);
+
+  mitk::DicomHeaderIndex::TagList tags;
+  tags.push_back( seriesUID );
+  tags.push_back( imagePosition );
+
+  mitk::DicomHeaderIndex::TagValueMap values;
+  values[seriesUID] = "1.2.3.4";
+  values[imagePosition] = "0\\0\\1.5";
+
+  mitk::DicomHeaderIndex index;
+  bool isDicom(false);
+  mitk::DicomHeaderIndex::TagValueMap foundValues;
+
+  MITK_TEST_CONDITION( !index.Lookup( dicomFile, tags, isDicom, foundValues ), "Testing that an unknown file is not found" );
+
+  index.Update( dicomFile, tags, true, values );
+  index.Update( otherFile, tags, false, mitk::DicomHeaderIndex::TagValueMap() );
+  MITK_TEST_CONDITION( index.IsModified() && index.GetNumberOfEntries() == 2, "Testing Update()" );
+
+  MITK_TEST_CONDITION_REQUIRED( index.Save( indexFile ), "Testing Save()" );
+  MITK_TEST_CONDITION( !index.IsModified(), "Testing that Save() resets the modified flag" );
+
+  mitk::DicomHeaderIndex loadedIndex;
+  MITK_TEST_CONDITION_REQUIRED( loadedIndex.Load( indexFile ) && loadedIndex.GetNumberOfEntries() == 2, "Testing Load()" );
+
+  MITK_TEST_CONDITION( loadedIndex.Lookup( dicomFile, tags, isDicom, foundValues ) && isDicom &&
+                       foundValues == values, "Testing that the loaded index returns the stored values" );
+
+  MITK_TEST_CONDITION( loadedIndex.Lookup( otherFile, tags, isDicom, foundValues ) && !isDicom,
+                       "Testing that files which are no DICOM are remembered" );
+
+  mitk::DicomHeaderIndex::TagList moreTags( tags );
+  moreTags.push_back( patientName );
+  MITK_TEST_CONDITION( !loadedIndex.Lookup( dicomFile, moreTags, isDicom, foundValues ),
+                       "Testing that a file is not found if a tag was not scanned" );
+
+  // tags that were scanned but did not exist in the file are known as well
+  loadedIndex.Update( dicomFile, mitk::DicomHeaderIndex::TagList( 1, patientName ), true, mitk::DicomHeaderIndex::TagValueMap() );
+  MITK_TEST_CONDITION( loadedIndex.Lookup( dicomFile, moreTags, isDicom, foundValues ) && foundValues == values,
+                       "Testing that values of an unchanged file are merged" );
+
+  WriteFile( dicomFile, "a modified file, of different length" );
+  MITK_TEST_CONDITION( !loadedIndex.Lookup( dicomFile, tags, isDicom, foundValues ), "Testing that a modified file is not found" );
+
+  loadedIndex.Clear();
+  MITK_TEST_CONDITION( loadedIndex.GetNumberOfEntries() == 0, "Testing Clear()" );
+
+  remove( dicomFile.c_str() );
+  remove( otherFile.c_str() );
+  remove( indexFile.c_str() );
+
+  MITK_TEST_END();
+}
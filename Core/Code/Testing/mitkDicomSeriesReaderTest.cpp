@@ -20,6 +20,13 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 #include "mitkDicomSeriesReader.h"
 #include "mitkProperties.h"
+#include "mitkImageReadAccessor.h"
+
+#include <itkMultiThreader.h>
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
 
 
 static std::map<std::string, std::map<gdcm::Tag, std::string> > GetTagInformationFromFile(mitk::DicomSeriesReader::StringContainer files)
@@ -57,6 +64,59 @@ static std::map<std::string, std::map<gdcm::Tag, std::string> > GetTagInformatio
   return tagInformations;
 }
 
+static mitk::Image::Pointer LoadWithThreads(const mitk::DicomSeriesReader::StringContainer& files, int numberOfThreads)
+{
+  const int defaultNumberOfThreads = itk::MultiThreader::GetGlobalDefaultNumberOfThreads();
+  itk::MultiThreader::SetGlobalDefaultNumberOfThreads( numberOfThreads );
+  mitk::DataNode::Pointer node = mitk::DicomSeriesReader::LoadDicomSeries( files );
+  itk::MultiThreader::SetGlobalDefaultNumberOfThreads( defaultNumberOfThreads );
+
+  return node.IsNotNull() ? dynamic_cast<mitk::Image*>( node->GetData() ) : NULL;
+}
+
+/**
+  The slices of a block are decoded by several threads, one chunk of files per thread.
+  The volume has to be the same as the one decoded by a single thread, and a damaged
+  file must not let an exception escape from a decoding thread.
+*/
+static void TestThreadedLoading(const mitk::DicomSeriesReader::StringContainer& files)
+{
+  mitk::Image::Pointer singleThreaded = LoadWithThreads( files, 1 );
+  mitk::Image::Pointer multiThreaded = LoadWithThreads( files, 4 );
+  MITK_TEST_CONDITION_REQUIRED( singleThreaded.IsNotNull() && multiThreaded.IsNotNull(), "Testing loading with one and with four threads" );
+
+  bool sameSize = singleThreaded->GetDimension() == multiThreaded->GetDimension()
+               && singleThreaded->GetPixelType() == multiThreaded->GetPixelType();
+  size_t volumeSize = singleThreaded->GetPixelType().GetSize();
+  for ( unsigned int i = 0; sameSize && i < 3; ++i )
+  {
+    sameSize = singleThreaded->GetDimension(i) == multiThreaded->GetDimension(i);
+    volumeSize *= singleThreaded->GetDimension(i);
+  }
+  MITK_TEST_CONDITION_REQUIRED( sameSize, "Testing that four threads load a volume of the same size" );
+
+  mitk::ImageReadAccessor singleThreadedAccessor( singleThreaded, singleThreaded->GetVolumeData(0) );
+  mitk::ImageReadAccessor multiThreadedAccessor( multiThreaded, multiThreaded->GetVolumeData(0) );
+  MITK_TEST_CONDITION( std::memcmp( singleThreadedAccessor.GetData(), multiThreadedAccessor.GetData(), volumeSize ) == 0,
+                       "Testing that four threads decode the same pixels as one thread" );
+
+  // cut the pixel data of the last slice, its thread fails while the other threads keep decoding
+  std::ifstream original( files.back().c_str(), std::ios::in | std::ios::binary );
+  std::string content( (std::istreambuf_iterator<char>(original)), std::istreambuf_iterator<char>() );
+  std::string damagedFile = std::string( MITK_TEST_OUTPUT_DIR ) + "/dicomSeriesReaderTestDamaged.dcm";
+  std::ofstream damaged( damagedFile.c_str(), std::ios::out | std::ios::binary | std::ios::trunc );
+  damaged.write( content.data(), content.size() - volumeSize / singleThreaded->GetDimension(2) / 2 );
+  damaged.close();
+
+  mitk::DicomSeriesReader::StringContainer damagedFiles( files );
+  damagedFiles.back() = damagedFile;
+  mitk::Image::Pointer damagedImage = LoadWithThreads( damagedFiles, 4 );
+  // reaching this point means no exception escaped, the series is then either rejected or read sequentially
+  MITK_TEST_CONDITION( damagedImage.IsNull() || damagedImage->GetDimension(2) == singleThreaded->GetDimension(2),
+                       "Testing that a damaged slice makes the decoding threads fall back without crashing" );
+  std::remove( damagedFile.c_str() );
+}
+
 int mitkDicomSeriesReaderTest(int argc, char* argv[])
 {
   // always start with this!
@@ -94,6 +154,9 @@ int mitkDicomSeriesReaderTest(int argc, char* argv[])
     }
   }
 
+  MITK_TEST_CONDITION_REQUIRED(!seriesInFiles.empty(), "Testing that the directory contains a series")
+  TestThreadedLoading( seriesInFiles.begin()->second.GetFilenames() );
+
   //Test if DICOM tags have been added correctly to the mitk::image properties
 
   const gdcm::Tag tagSliceLocation(0x0020, 0x1041); // slice location
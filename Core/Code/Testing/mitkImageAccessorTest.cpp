@@ -214,6 +214,67 @@ int mitkImageAccessorTest(int argc, char* argv[])
    MITK_TEST_FOR_EXCEPTION_END(mitk::Exception)
 
 
+   // REGION GRANULAR LOCKING
+
+   MITK_TEST_OUTPUT( << "Testing write accessors of disjoint and overlapping sub regions ...");
+   {
+     unsigned int dimensions[3] = {16, 16, 8};
+     mitk::Image::Pointer regionImage = mitk::Image::New();
+     regionImage->Initialize(mitk::MakeScalarPixelType<short>(), 3, dimensions);
+     regionImage->ResetAccessorStatistics();
+
+     itk::ImageRegion<4> lowerHalf;
+     itk::Size<4> halfSize = {{16, 16, 4, 1}};
+     lowerHalf.SetSize(halfSize);
+
+     itk::ImageRegion<4> upperHalf = lowerHalf;
+     itk::Index<4> upperIndex = {{0, 0, 4, 0}};
+     upperHalf.SetIndex(upperIndex);
+
+     itk::ImageRegion<4> centerBlock;
+     itk::Index<4> centerIndex = {{4, 4, 2, 0}};
+     itk::Size<4> centerSize = {{8, 8, 4, 1}};
+     centerBlock.SetIndex(centerIndex);
+     centerBlock.SetSize(centerSize);
+
+     bool disjointGranted = true;
+     bool overlapRejected = false;
+     try
+     {
+       mitk::ImageWriteAccessor lower(regionImage, lowerHalf, NULL, mitk::ImageAccessorBase::ExceptionIfLocked);
+       mitk::ImageWriteAccessor upper(regionImage, upperHalf, NULL, mitk::ImageAccessorBase::ExceptionIfLocked);
+
+       MITK_TEST_CONDITION(static_cast<char*>(upper.GetData()) - static_cast<char*>(lower.GetData()) == 16*16*4*sizeof(short),
+                           "Sub region accessor points to the first pixel of its region");
+       try
+       {
+         mitk::ImageReadAccessor center(regionImage, centerBlock, NULL, mitk::ImageAccessorBase::ExceptionIfLocked);
+       }
+       catch(mitk::MemoryIsLockedException&)
+       {
+         overlapRejected = true;
+       }
+     }
+     catch(mitk::Exception&)
+     {
+       disjointGranted = false;
+     }
+
+     MITK_TEST_CONDITION(disjointGranted, "Write accessors of disjoint sub regions are granted concurrently");
+     MITK_TEST_CONDITION(overlapRejected, "Read accessor of an overlapping sub region is rejected");
+
+     mitk::ImageAccessorStatistics statistics = regionImage->GetAccessorStatistics();
+     MITK_TEST_CONDITION(statistics.WriteAccesses == 2 && statistics.ReadAccesses == 0, "Granted accesses are counted");
+     MITK_TEST_CONDITION(statistics.RejectedAccesses == 1, "Rejected accesses are counted");
+
+     itk::ImageRegion<4> outside = centerBlock;
+     itk::Index<4> outsideIndex = {{12, 12, 6, 0}};
+     outside.SetIndex(outsideIndex);
+     MITK_TEST_FOR_EXCEPTION_BEGIN(mitk::Exception)
+       mitk::ImageReadAccessor invalid(regionImage, outside);
+     MITK_TEST_FOR_EXCEPTION_END(mitk::Exception)
+   }
+
    // CREATE THREADS
 
    image->GetGeometry()->Initialize();
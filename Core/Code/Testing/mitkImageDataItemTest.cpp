@@ -17,8 +17,13 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 #include "mitkImage.h"
 #include "mitkImageDataItem.h"
+#include "mitkImageReadAccessor.h"
+#include "mitkMemoryMappedFile.h"
+#include "mitkTestingConfig.h"
 
 #include <fstream>
+#include <sstream>
+#include <cstdio>
 int mitkImageDataItemTest(int /*argc*/, char* /*argv*/[])
 {
   unsigned long *pixels = new unsigned long [100];
@@ -28,6 +33,45 @@ int mitkImageDataItemTest(int /*argc*/, char* /*argv*/[])
   delete [] (unsigned char*) data;
   std::cout<<"[PASSED]"<<std::endl;
 
+  std::cout << "Testing memory mapped image data: ";
+  {
+    // raw file with a header of 7 bytes, followed by a 4x3x2 short volume
+    std::stringstream fileName;
+    fileName << MITK_TEST_OUTPUT_DIR << "/mitkImageDataItemTest.raw";
+    const unsigned int headerSize = 7;
+    unsigned int dimensions[3] = {4, 3, 2};
+    const unsigned int numberOfPixels = dimensions[0] * dimensions[1] * dimensions[2];
+    {
+      std::ofstream file(fileName.str().c_str(), std::ios::out | std::ios::binary);
+      file.write("header.", headerSize);
+      for (short i = 0; i < (short) numberOfPixels; ++i)
+        file.write(reinterpret_cast<const char*>(&i), sizeof(short));
+    }
+
+    mitk::Image::Pointer image = mitk::Image::New();
+    image->Initialize(mitk::MakeScalarPixelType<short>(), 3, dimensions);
+    mitk::MemoryMappedFile::Pointer mappedFile = mitk::MemoryMappedFile::New(fileName.str(), headerSize, numberOfPixels * sizeof(short));
+    if (!image->SetMemoryMappedChannel(mappedFile) || !image->GetVolumeData(0)->IsMemoryMapped())
+    {
+      std::cout<<"[FAILED]"<<std::endl;
+      return EXIT_FAILURE;
+    }
+    mappedFile = NULL; // the image keeps the mapping alive
+
+    {
+      mitk::ImageReadAccessor accessor(image, image->GetSliceData(1));
+      const short* slice = static_cast<const short*>(accessor.GetData());
+      if (slice[0] != (short)(dimensions[0] * dimensions[1]) || slice[dimensions[0] * dimensions[1] - 1] != (short)(numberOfPixels - 1))
+      {
+        std::cout<<"[FAILED]"<<std::endl;
+        return EXIT_FAILURE;
+      }
+    }
+    image = NULL;
+    std::remove(fileName.str().c_str());
+  }
+  std::cout<<"[PASSED]"<<std::endl;
+
   std::cout<<"[TEST DONE]"<<std::endl;
   return EXIT_SUCCESS;
 }
@@ -23,6 +23,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <mitkImageStatisticsHolder.h>
 #include "mitkImageGenerator.h"
 #include "mitkImageReadAccessor.h"
+#include "mitkImageWriteAccessor.h"
 #include "mitkException.h"
 
 // itk includes
@@ -31,10 +32,50 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 // stl includes
 #include <fstream>
+#include <limits>
 
 // vtk includes
 #include <vtkImageData.h>
 
+// Compares the extrema of time step t with the unchanged extrema loop of the former _ComputeExtremaInItkImage()
+template <typename TPixel>
+bool EqualToPerPixelExtrema(mitk::Image* image, int t)
+{
+  mitk::ImageReadAccessor volumeAccessor(image, image->GetVolumeData(t));
+  const TPixel* voxel = static_cast<const TPixel*>(volumeAccessor.GetData());
+  unsigned int numberOfVoxels = image->GetDimension(0) * image->GetDimension(1) * image->GetDimension(2);
+
+  mitk::ScalarType min, secondMin, max, secondMax, countOfMin = 0, countOfMax = 0;
+  secondMin = min = itk::NumericTraits<mitk::ScalarType>::max();
+  secondMax = max = itk::NumericTraits<mitk::ScalarType>::NonpositiveMin();
+  for (unsigned int i = 0; i < numberOfVoxels; ++i)
+  {
+    mitk::ScalarType value = voxel[i];
+    if (value < min)
+    {
+      secondMin = min; min = value; countOfMin = 1;
+    }
+    else if (value == min)
+      ++countOfMin;
+    else if (value < secondMin)
+      secondMin = value;
+
+    if (value > max)
+    {
+      secondMax = max; max = value; countOfMax = 1;
+    }
+    else if (value == max)
+      ++countOfMax;
+    else if (value > secondMax)
+      secondMax = value;
+  }
+
+  mitk::ImageStatisticsHolder* statistics = image->GetStatistics();
+  return statistics->GetScalarValueMin(t) == min && statistics->GetScalarValueMax(t) == max
+    && statistics->GetScalarValue2ndMin(t) == secondMin && statistics->GetScalarValue2ndMax(t) == secondMax
+    && statistics->GetCountOfMinValuedVoxels(t) == countOfMin && statistics->GetCountOfMaxValuedVoxels(t) == countOfMax;
+}
+
 // Checks if reference count is correct after using GetVtkImageData()
 bool ImageVtkDataReferenceCheck(const char* fname) {
 
@@ -407,6 +448,44 @@ int mitkImageTest(int argc, char* argv[])
   MITK_INFO << imageMin << " "<< imageMax << " "<< value << "";
   MITK_TEST_CONDITION( (value >= imageMin && value <= imageMax), "Value returned is between max/min");
 
+  // test the extrema computed on the image buffer against the per-pixel algorithm of the ITK based path
+  {
+    mitk::Image::Pointer image4D = mitk::ImageGenerator::GenerateRandomImage<short>(64, 64, 32, 3, 1, 1, 1, 500, -500);
+    mitk::Image::Pointer image4DClone = image4D->Clone();
+    image4DClone->GetStatistics()->SetComputeAllTimeStepsAtOnce(true);
+
+    bool equalExtrema = true;
+    bool equalExtremaAllTimeSteps = true;
+    for (int t = 2; t >= 0; --t)
+    {
+      equalExtrema = equalExtrema && EqualToPerPixelExtrema<short>(image4D, t);
+      equalExtremaAllTimeSteps = equalExtremaAllTimeSteps && EqualToPerPixelExtrema<short>(image4DClone, t);
+    }
+    MITK_TEST_CONDITION(equalExtrema, "Extrema of single time steps are equal to the extrema of a per-pixel loop over the voxels");
+    MITK_TEST_CONDITION(equalExtremaAllTimeSteps, "Extrema computed for all time steps at once are equal to the extrema of a per-pixel loop over the voxels");
+
+    // NaN voxels, also as first voxel of a time step and of the chunks of the threads, are ignored by the per-pixel loop
+    mitk::Image::Pointer nanImage = mitk::ImageGenerator::GenerateRandomImage<float>(64, 64, 32, 2, 1, 1, 1, 500, -500);
+    {
+      mitk::ImageWriteAccessor accessor(nanImage);
+      float* voxel = static_cast<float*>(accessor.GetData());
+      const unsigned int numberOfVoxels = 64 * 64 * 32;
+      for (unsigned int i = 0; i < 2 * numberOfVoxels; i += 4099)
+        voxel[i] = std::numeric_limits<float>::quiet_NaN();
+      for (unsigned int i = 0; i < 16; ++i)
+        voxel[numberOfVoxels * i / 16] = std::numeric_limits<float>::quiet_NaN();
+    }
+    mitk::Image::Pointer nanImageClone = nanImage->Clone();
+    nanImageClone->GetStatistics()->SetComputeAllTimeStepsAtOnce(true);
+    bool equalNaNExtrema = true;
+    for (int t = 1; t >= 0; --t)
+    {
+      equalNaNExtrema = equalNaNExtrema && EqualToPerPixelExtrema<float>(nanImage, t) && EqualToPerPixelExtrema<float>(nanImageClone, t)
+        && nanImage->GetStatistics()->GetScalarValueMin(t) >= -500 && nanImage->GetStatistics()->GetScalarValueMax(t) <= 500;
+    }
+    MITK_TEST_CONDITION(equalNaNExtrema, "Extrema of an image with NaN voxels are equal to the extrema of a per-pixel loop over the voxels");
+  }
+
   // test accessing PixelValue with coordinate leading to a negative index
   const mitk::Point3D geom_origin = image->GetGeometry()->GetOrigin();
   const mitk::Point3D geom_center = image->GetGeometry()->GetCenter();
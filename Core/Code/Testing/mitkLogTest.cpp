@@ -22,6 +22,8 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <itksys/SystemTools.hxx>
 #include <mitkStandardFileLocations.h>
 
+#include <fstream>
+
 
 /** Documentation
   *
@@ -257,6 +259,68 @@ static void TestAddAndRemoveBackends()
     MITK_TEST_CONDITION_REQUIRED(true,"Test add/remove logging backend.");
     }
 
+static void TestQueuedLogging()
+    {
+    mitk::LoggingBackend::Register();
+
+    std::string filename = mitk::StandardFileLocations::GetInstance()->GetOptionDirectory() + "/testqueuedlog.log";
+    itksys::SystemTools::RemoveFile(filename.c_str());
+    mitk::LoggingBackend::SetLogFile(filename.c_str());
+
+    // messages are written by a background thread, Flush() waits for them
+    mitk::LoggingBackend::Flush();
+    MITK_INFO << "Test queued logging marker";
+    mitk::LoggingBackend::Flush();
+
+    std::ifstream file(filename.c_str());
+    std::string line;
+    bool markerFound = false;
+    while (std::getline(file, line))
+    {
+      markerFound |= line.find("Test queued logging marker") != std::string::npos;
+    }
+    MITK_TEST_CONDITION(markerFound, "Testing if flushed message is written to log file.");
+
+    // a burst of messages may fill the queue, the ones that do not fit are dropped instead of blocking
+    const unsigned long numberOfBurstMessages = 20000;
+    unsigned long droppedBeforeBurst = mitk::LoggingBackend::GetNumberOfDroppedMessages();
+    for (unsigned long i = 0; i < numberOfBurstMessages; ++i)
+    {
+      MITK_INFO << "Test message burst " << i;
+    }
+    mitk::LoggingBackend::Flush();
+    unsigned long droppedMessages = mitk::LoggingBackend::GetNumberOfDroppedMessages() - droppedBeforeBurst;
+    MITK_TEST_OUTPUT(<< droppedMessages << " messages dropped during burst");
+
+    file.close();
+    file.clear();
+    file.open(filename.c_str());
+    unsigned long writtenMessages = 0;
+    while (std::getline(file, line))
+    {
+      if (line.find("Test message burst ") != std::string::npos)
+      {
+        ++writtenMessages;
+      }
+    }
+    file.close();
+    MITK_TEST_CONDITION(droppedMessages + writtenMessages == numberOfBurstMessages, "Testing if every message of the burst is either written or counted as dropped.");
+
+    // the writer thread is stopped on unregister, after it has written the messages queued so far
+    MITK_INFO << "Test unregister marker";
+    mitk::LoggingBackend::Unregister();
+    MITK_TEST_CONDITION(mitk::LoggingBackend::GetLogFile().empty(), "Testing if log file is closed on unregister.");
+
+    file.clear();
+    file.open(filename.c_str());
+    markerFound = false;
+    while (std::getline(file, line))
+    {
+      markerFound |= line.find("Test unregister marker") != std::string::npos;
+    }
+    MITK_TEST_CONDITION(markerFound, "Testing if messages logged right before unregister are written to log file.");
+    }
+
 static void  TestDefaultBackend()
     {
     //not possible now, because we cannot unregister the mitk logging backend in the moment. If such a method is added to mbilog utility one may add this test.
@@ -280,6 +344,7 @@ int mitkLogTest(int /* argc */, char* /*argv*/[])
   mitkLogTestClass::TestThreadSaveLog( false ); // false = to console
   mitkLogTestClass::TestThreadSaveLog( true );  // true = to file
   // TODO actually test file somehow?
+  mitkLogTestClass::TestQueuedLogging();
 
   // always end with this!
   MITK_TEST_END()
@@ -0,0 +1,243 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkTestingMacros.h"
+#include "mitkTestingConfig.h"
+
+#include "mitkImage.h"
+#include "mitkImageDataItem.h"
+#include "mitkImageReadAccessor.h"
+#include "mitkItkImageFileReader.h"
+#include "mitkMemoryMappedFile.h"
+#include "mitkRawImageFileReader.h"
+
+#include <itkByteSwapper.h>
+#include <itkImageIOFactory.h>
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+namespace
+{
+
+const unsigned int Dimensions[3] = {4, 3, 2};
+const unsigned int NumberOfPixels = 4 * 3 * 2;
+
+// gives access to the protected data location parser of ItkImageFileReader
+class DataLocationReader : public mitk::ItkImageFileReader
+{
+public:
+  static bool GetDataLocation(const std::string& fileName, std::string& dataFileName, size_t& dataOffset)
+  {
+    itk::ImageIOBase::Pointer imageIO = itk::ImageIOFactory::CreateImageIO( fileName.c_str(), itk::ImageIOFactory::ReadMode );
+    if ( imageIO.IsNull() )
+      return false;
+    imageIO->SetFileName( fileName );
+    imageIO->ReadImageInformation();
+    return GetUncompressedDataLocation( imageIO, fileName, dataFileName, dataOffset );
+  }
+};
+
+std::string GetFileName(const std::string& name)
+{
+  return std::string( MITK_TEST_OUTPUT_DIR ) + "/" + name;
+}
+
+const char* GetEndian()
+{
+  return itk::ByteSwapper<short>::SystemIsBigEndian() ? "big" : "little";
+}
+
+// writes text, then the 4x3x2 short volume 0, 1, 2, ... in the byte order of this machine
+void WriteFile(const std::string& fileName, const std::string& text)
+{
+  std::ofstream file( fileName.c_str(), std::ios::out | std::ios::binary );
+  file.write( text.c_str(), text.size() );
+  for (short i = 0; i < (short) NumberOfPixels; ++i)
+    file.write( reinterpret_cast<const char*>(&i), sizeof(short) );
+}
+
+bool HasVolume(mitk::Image* image)
+{
+  if ( image == NULL || image->GetDimension() != 3 || image->GetDimension(0) != Dimensions[0]
+       || image->GetDimension(1) != Dimensions[1] || image->GetDimension(2) != Dimensions[2] )
+    return false;
+
+  mitk::ImageReadAccessor accessor( image, image->GetVolumeData(0) );
+  const short* pixels = static_cast<const short*>( accessor.GetData() );
+  for (unsigned int i = 0; i < NumberOfPixels; ++i)
+  {
+    if ( pixels[i] != (short) i )
+      return false;
+  }
+  return true;
+}
+
+std::string NrrdHeader(const std::string& encoding, const std::string& dataFile, const std::string& byteSkip)
+{
+  std::stringstream header;
+  header << "NRRD0004\n"
+         << "# written by mitkMemoryMappedImageReaderTest\n"
+         << "type: short\n"
+         << "dimension: 3\n"
+         << "sizes: 4 3 2\n"
+         << "encoding: " << encoding << "\n"
+         << "endian: " << GetEndian() << "\n";
+  if ( !byteSkip.empty() )
+    header << "byte skip: " << byteSkip << "\n";
+  if ( !dataFile.empty() )
+    header << "data file: " << dataFile << "\n";
+  else
+    header << "\n";
+  return header.str();
+}
+
+std::string MetaImageHeader(const std::string& dataFile, const std::string& headerSize)
+{
+  std::stringstream header;
+  header << "ObjectType = Image\n"
+         << "NDims = 3\n"
+         << "DimSize = 4 3 2\n"
+         << "ElementType = MET_SHORT\n"
+         << "ElementByteOrderMSB = " << ( itk::ByteSwapper<short>::SystemIsBigEndian() ? "True" : "False" ) << "\n";
+  if ( !headerSize.empty() )
+    header << "HeaderSize = " << headerSize << "\n";
+  header << "ElementDataFile = " << dataFile << "\n";
+  return header.str();
+}
+
+void TestDataLocation()
+{
+  std::string dataFileName;
+  size_t dataOffset = 0;
+
+  // attached NRRD data follows the empty line after the header
+  std::string nrrdFile = GetFileName( "mitkMemoryMappedImageReaderTest.nrrd" );
+  std::string header = NrrdHeader( "raw", "", "" );
+  WriteFile( nrrdFile, header );
+  MITK_TEST_CONDITION( DataLocationReader::GetDataLocation( nrrdFile, dataFileName, dataOffset )
+                       && dataFileName == nrrdFile && dataOffset == header.size(), "Data location of a NRRD file with attached data" );
+
+  // detached NRRD data with a byte skip
+  std::string rawFile = GetFileName( "mitkMemoryMappedImageReaderTest.raw" );
+  WriteFile( rawFile, "16 bytes header." );
+  std::string nhdrFile = GetFileName( "mitkMemoryMappedImageReaderTest.nhdr" );
+  {
+    std::ofstream file( nhdrFile.c_str() );
+    file << NrrdHeader( "raw", "mitkMemoryMappedImageReaderTest.raw", "16" );
+  }
+  MITK_TEST_CONDITION( DataLocationReader::GetDataLocation( nhdrFile, dataFileName, dataOffset )
+                       && dataFileName == GetFileName( "mitkMemoryMappedImageReaderTest.raw" ) && dataOffset == 16, "Data location of a NRRD header with byte skip" );
+
+  // byte skip -1: the data are the last bytes of the data file
+  {
+    std::ofstream file( nhdrFile.c_str() );
+    file << NrrdHeader( "raw", "mitkMemoryMappedImageReaderTest.raw", "-1" );
+  }
+  MITK_TEST_CONDITION( DataLocationReader::GetDataLocation( nhdrFile, dataFileName, dataOffset )
+                       && dataOffset == mitk::MemoryMappedFile::GetFileSize( rawFile ) - NumberOfPixels * sizeof(short), "Data location of a NRRD header with byte skip -1" );
+
+  // compressed data cannot be mapped
+  {
+    std::ofstream file( nhdrFile.c_str() );
+    file << NrrdHeader( "gzip", "mitkMemoryMappedImageReaderTest.raw", "" );
+  }
+  MITK_TEST_CONDITION( !DataLocationReader::GetDataLocation( nhdrFile, dataFileName, dataOffset ), "No data location of a gzip compressed NRRD file" );
+
+  // MetaImage with the data in the same file
+  std::string mhaFile = GetFileName( "mitkMemoryMappedImageReaderTest.mha" );
+  header = MetaImageHeader( "LOCAL", "" );
+  WriteFile( mhaFile, header );
+  MITK_TEST_CONDITION( DataLocationReader::GetDataLocation( mhaFile, dataFileName, dataOffset )
+                       && dataFileName == mhaFile && dataOffset == header.size(), "Data location of a MetaImage with local data" );
+
+  // MetaImage with a separate data file and a header size
+  std::string mhdFile = GetFileName( "mitkMemoryMappedImageReaderTest.mhd" );
+  {
+    std::ofstream file( mhdFile.c_str() );
+    file << MetaImageHeader( "mitkMemoryMappedImageReaderTest.raw", "16" );
+  }
+  MITK_TEST_CONDITION( DataLocationReader::GetDataLocation( mhdFile, dataFileName, dataOffset )
+                       && dataFileName == GetFileName( "mitkMemoryMappedImageReaderTest.raw" ) && dataOffset == 16, "Data location of a MetaImage with a data file and header size" );
+
+  // the located data are the mapped voxels
+  mitk::ItkImageFileReader::Pointer reader = mitk::ItkImageFileReader::New();
+  reader->SetFileName( nrrdFile );
+  reader->UseMemoryMappingOn();
+  reader->Update();
+  MITK_TEST_CONDITION( HasVolume( reader->GetOutput() ) && reader->GetOutput()->GetVolumeData(0)->IsMemoryMapped(), "Mapped NRRD file with attached data" );
+
+  reader = mitk::ItkImageFileReader::New();
+  reader->SetFileName( mhdFile );
+  reader->UseMemoryMappingOn();
+  reader->Update();
+  MITK_TEST_CONDITION( HasVolume( reader->GetOutput() ) && reader->GetOutput()->GetVolumeData(0)->IsMemoryMapped(), "Mapped MetaImage with a data file and header size" );
+  reader = NULL;
+
+  std::remove( nrrdFile.c_str() );
+  std::remove( nhdrFile.c_str() );
+  std::remove( mhaFile.c_str() );
+  std::remove( mhdFile.c_str() );
+  std::remove( rawFile.c_str() );
+}
+
+mitk::Image::Pointer ReadRawFile(const std::string& fileName, bool useMemoryMapping)
+{
+  mitk::RawImageFileReader::Pointer reader = mitk::RawImageFileReader::New();
+  reader->SetFileName( fileName );
+  reader->SetPixelType( mitk::RawImageFileReader::SSHORT );
+  reader->SetEndianity( itk::ByteSwapper<short>::SystemIsBigEndian() ? mitk::RawImageFileReader::BIG : mitk::RawImageFileReader::LITTLE );
+  reader->SetDimensionality( 3 );
+  for (unsigned int i = 0; i < 3; ++i)
+    reader->SetDimensions( i, Dimensions[i] );
+  reader->SetUseMemoryMapping( useMemoryMapping );
+  reader->Update();
+  return reader->GetOutput();
+}
+
+void TestRawFileWithHeader()
+{
+  // like itk::RawImageIO, the reader skips everything in front of the image data
+  std::string rawFile = GetFileName( "mitkMemoryMappedImageReaderTestHeader.raw" );
+  WriteFile( rawFile, "a header of 23 bytes..." );
+
+  mitk::Image::Pointer read = ReadRawFile( rawFile, false );
+  MITK_TEST_CONDITION( HasVolume( read ), "Reading a raw file with header" );
+
+  mitk::Image::Pointer mapped = ReadRawFile( rawFile, true );
+  MITK_TEST_CONDITION( HasVolume( mapped ) && mapped->GetVolumeData(0)->IsMemoryMapped(), "Mapping a raw file with header" );
+
+  read = NULL;
+  mapped = NULL;
+  std::remove( rawFile.c_str() );
+}
+
+}
+
+/**Documentation
+ *  Test for the memory mapped reading of NRRD, MetaImage and raw files
+ */
+int mitkMemoryMappedImageReaderTest(int /*argc*/, char* /*argv*/[])
+{
+  MITK_TEST_BEGIN("MemoryMappedImageReader");
+
+  TestDataLocation();
+  TestRawFileWithHeader();
+
+  MITK_TEST_END();
+}
@@ -0,0 +1,91 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include <mitkTestingMacros.h>
+#include "mitkSliceCache.h"
+#include "mitkImageGenerator.h"
+#include "mitkPlaneGeometry.h"
+
+#include <vtkImageData.h>
+#include <vtkSmartPointer.h>
+
+static mitk::SliceCache::Request CreateRequest(mitk::Image* image, unsigned int slice)
+{
+  mitk::PlaneGeometry::Pointer plane = mitk::PlaneGeometry::New();
+  plane->InitializeStandardPlane( image->GetGeometry(), mitk::PlaneGeometry::Axial, slice );
+  plane->SetReferenceGeometry( image->GetGeometry() );
+
+  mitk::SliceCache::Request request;
+  request.m_Image = image;
+  request.m_WorldGeometry = plane.GetPointer();
+  request.m_DataMTime = image->GetMTime();
+  return request;
+}
+
+static mitk::SliceCache::Result CreateResult()
+{
+  mitk::SliceCache::Result result;
+  result.m_ReslicedImage = vtkSmartPointer<vtkImageData>::New();
+  return result;
+}
+
+int mitkSliceCacheTest(int /*argc*/, char* /*argv*/[])
+{
+  MITK_TEST_BEGIN("SliceCacheTest");
+
+  mitk::Image::Pointer image = mitk::ImageGenerator::GenerateGradientImage<unsigned char>(10, 10, 10);
+
+  mitk::SliceCache cache;
+  mitk::SliceCache::Result result;
+
+  cache.Insert( CreateRequest(image, 0), CreateResult() );
+  MITK_TEST_CONDITION( cache.GetSize() == 0, "Testing that a cache of size 0 stores nothing" );
+
+  cache.SetMaximumSize( 2 );
+  mitk::SliceCache::Result slice0 = CreateResult();
+  mitk::SliceCache::Result slice1 = CreateResult();
+  mitk::SliceCache::Result slice2 = CreateResult();
+
+  cache.Insert( CreateRequest(image, 0), slice0 );
+  cache.Insert( CreateRequest(image, 1), slice1 );
+  MITK_TEST_CONDITION( cache.GetSize() == 2, "Testing size after two insertions" );
+
+  MITK_TEST_CONDITION( cache.Get( CreateRequest(image, 0), result ) && result.m_ReslicedImage == slice0.m_ReslicedImage,
+                       "Testing that an equal plane geometry finds the cached slice" );
+  MITK_TEST_CONDITION( !cache.Get( CreateRequest(image, 5), result ), "Testing that another plane is not found" );
+
+  // slice 1 is least recently used now
+  cache.Insert( CreateRequest(image, 2), slice2 );
+  MITK_TEST_CONDITION( cache.GetSize() == 2, "Testing that the maximum size is kept" );
+  MITK_TEST_CONDITION( !cache.Contains( CreateRequest(image, 1) ), "Testing that the least recently used slice was evicted" );
+  MITK_TEST_CONDITION( cache.Contains( CreateRequest(image, 0) ), "Testing that the recently used slice was kept" );
+  MITK_TEST_CONDITION( cache.Contains( CreateRequest(image, 2) ), "Testing that the new slice was stored" );
+
+  mitk::SliceCache::Request request = CreateRequest(image, 0);
+  request.m_InterpolationMode = mitk::ExtractSliceFilter::RESLICE_CUBIC;
+  MITK_TEST_CONDITION( !cache.Contains( request ), "Testing that the interpolation mode is part of the key" );
+
+  request = CreateRequest(image, 0);
+  request.m_DataMTime = request.m_DataMTime + 1;
+  MITK_TEST_CONDITION( !cache.Contains( request ), "Testing that modified image data is not found" );
+
+  MITK_TEST_CONDITION( cache.GetNumberOfHits() == 1 && cache.GetNumberOfMisses() == 1, "Testing hit and miss counters" );
+
+  cache.Clear();
+  MITK_TEST_CONDITION( cache.GetSize() == 0 && !cache.Contains( CreateRequest(image, 0) ), "Testing Clear()" );
+
+  MITK_TEST_END();
+}
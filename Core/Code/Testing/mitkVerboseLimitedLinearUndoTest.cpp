@@ -33,8 +33,9 @@ namespace mitk {
 class TestOperation : public Operation
 {
 public:
-  TestOperation(OperationType operationType)
-    : Operation(operationType)
+  TestOperation(OperationType operationType, unsigned long memorySize = 0)
+    : Operation(operationType),
+      m_MemorySize(memorySize)
   {
     g_GlobalCounter++;
   };
@@ -43,6 +44,13 @@ public:
   {
     g_GlobalCounter--;
   };
+
+  virtual unsigned long GetMemorySize() const
+  {
+    return m_MemorySize;
+  }
+
+  unsigned long m_MemorySize;
 };
 }//namespace
 
@@ -133,6 +141,41 @@ int mitkVerboseLimitedLinearUndoTest(int /* argc */, char* /*argv*/[])
   }
   MITK_TEST_CONDITION_REQUIRED(g_GlobalCounter == 4,"checking added operations in UndoModel");
 
+  //limit the memory of the stacks: each operation event uses 200 bytes
+  mitk::LimitedLinearUndo* limitedModel = dynamic_cast<mitk::LimitedLinearUndo*>(myUndoController->GetCurrentUndoModel());
+  MITK_TEST_CONDITION_REQUIRED(limitedModel != NULL,"checking type of UndoModel");
+  myUndoController->Clear();
+  for (int i = 0; i<4; i++)
+  {
+    mitk::TestOperation* doOp = new mitk::TestOperation(mitk::OpTEST, 100);
+    mitk::TestOperation *undoOp = new mitk::TestOperation(mitk::OpTEST, 100);
+    mitk::OperationEvent *operationEvent = new mitk::OperationEvent(NULL, doOp, undoOp, "Test");
+    myUndoController->SetOperationEvent(operationEvent);
+    mitk::OperationEvent::IncCurrObjectEventId();
+    mitk::UndoStackItem::ExecuteIncrement();
+  }
+  MITK_TEST_CONDITION_REQUIRED(limitedModel->GetMemorySize() == 800,"checking memory size of UndoModel");
+
+  limitedModel->SetMaximumMemorySize(400);
+  MITK_TEST_CONDITION_REQUIRED(g_GlobalCounter == 4 && limitedModel->GetMemorySize() == 400,"checking that the oldest operations are deleted when the memory limit is set");
+
+  limitedModel->SetMaximumMemorySize(100);
+  MITK_TEST_CONDITION_REQUIRED(g_GlobalCounter == 2,"checking that the last operation event is kept even if it exceeds the memory limit");
+
+  limitedModel->SetMaximumMemorySize(0);
+  myUndoController->Clear();
+
+  //sending two new OperationEvents
+  for (int i = 0; i<2; i++)
+  {
+    mitk::TestOperation* doOp = new mitk::TestOperation(mitk::OpTEST);
+    mitk::TestOperation *undoOp = new mitk::TestOperation(mitk::OpTEST);
+    mitk::OperationEvent *operationEvent = new mitk::OperationEvent(NULL, doOp, undoOp, "Test");
+    myUndoController->SetOperationEvent(operationEvent);
+    mitk::OperationEvent::IncCurrObjectEventId();
+    mitk::UndoStackItem::ExecuteIncrement();
+  }
+
   delete myUndoController;
 
   //after deleting UndoController g_GlobalCounter will still be 4 because m_CurrentUndoModel inside myUndoModel is a static singleton
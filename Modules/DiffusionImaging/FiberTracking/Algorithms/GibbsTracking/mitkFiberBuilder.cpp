@@ -23,6 +23,7 @@ FiberBuilder::FiberBuilder(ParticleGrid* grid, ItkFloatImageType* image)
     m_Grid = grid;
     m_Image = image;
     m_FiberLength = 0;
+    m_FiberWriter = NULL;
 }
 
 FiberBuilder::~FiberBuilder()
@@ -50,9 +51,15 @@ vtkSmartPointer<vtkPolyData> FiberBuilder::iterate(int minFiberLength)
             cur_label++;
             if(m_FiberLength >= minFiberLength)
             {
-                m_VtkCellArray->InsertNextCell(container);
+                if (m_FiberWriter!=NULL)
+                    WriteFiber(container);
+                else
+                    m_VtkCellArray->InsertNextCell(container);
                 numFibers++;
             }
+            // the points of each fiber are only needed until it is written
+            if (m_FiberWriter!=NULL)
+                m_VtkPoints->Reset();
             m_FiberLength = 0;
         }
     }
@@ -68,6 +75,15 @@ vtkSmartPointer<vtkPolyData> FiberBuilder::iterate(int minFiberLength)
     return fiberPolyData;
 }
 
+void FiberBuilder::WriteFiber(vtkPolyLine* container)
+{
+    std::vector<double> points(3*container->GetNumberOfPoints());
+    for (vtkIdType j=0; j<container->GetNumberOfPoints(); j++)
+        m_VtkPoints->GetPoint(container->GetPointId(j), &points[3*j]);
+    if (!points.empty())
+        m_FiberWriter->AddFiber(&points[0], container->GetNumberOfPoints());
+}
+
 void FiberBuilder::LabelPredecessors(Particle* p, int ep, vtkPolyLine* container)
 {
     Particle* p2 = NULL;
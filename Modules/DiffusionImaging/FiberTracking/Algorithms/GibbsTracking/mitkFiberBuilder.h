@@ -19,6 +19,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 // MITK
 #include <FiberTrackingExports.h>
 #include <mitkParticleGrid.h>
+#include <mitkFiberBundleXBinaryFile.h>
 
 // VTK
 #include <vtkSmartPointer.h>
@@ -36,7 +37,9 @@ namespace mitk
 {
 
 /**
-* \brief Gnerates actual fiber structure (vtkPolyData) from the particle grid content.   */
+* \brief Gnerates actual fiber structure (vtkPolyData) from the particle grid content.
+*
+* If a fiber writer is set, the fibers are written to it one by one and iterate() returns an empty vtkPolyData.   */
 
 class FiberTracking_EXPORT FiberBuilder
 {
@@ -49,10 +52,14 @@ public:
 
     vtkSmartPointer<vtkPolyData> iterate(int minFiberLength);
 
+    void SetFiberWriter(FiberBundleXBinaryWriter* writer){ m_FiberWriter = writer; }
+
 protected:
 
     void AddPoint(Particle *dp, vtkSmartPointer<vtkPolyLine> container);
 
+    void WriteFiber(vtkPolyLine* container);
+
     void LabelPredecessors(Particle* p, int ep, vtkPolyLine* container);
     void LabelSuccessors(Particle* p, int ep, vtkPolyLine* container);
 
@@ -62,6 +69,7 @@ protected:
     ParticleGrid*               m_Grid;
     vtkSmartPointer<vtkCellArray> m_VtkCellArray;
     vtkSmartPointer<vtkPoints>    m_VtkPoints;
+    FiberBundleXBinaryWriter*     m_FiberWriter;
 
 };
 
@@ -0,0 +1,144 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+#ifndef __itkFiberPointToIndexTransform_h__
+#define __itkFiberPointToIndexTransform_h__
+
+#include <vtkCellArray.h>
+#include <vtkPoints.h>
+#include <vnl/vnl_inverse.h>
+#include <vnl/vnl_matrix_fixed.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+namespace itk{
+
+/**
+* \brief Physical point to continuous index transform of an image, precomputed as one affine transform.
+*
+* Gives the same continuous index as Image::TransformPhysicalPointToContinuousIndex(). TransformFiber() first copies
+* all points of a fiber and then transforms them in one loop without function calls, which the compiler can vectorize.
+* Also splits the fibers of a tractogram into contiguous ranges for the threads of the tract-to-image filters.
+*/
+class FiberPointToIndexTransform
+{
+public:
+
+  FiberPointToIndexTransform()
+  {
+    for (int i=0; i<9; i++)
+      m_Matrix[i] = i%4==0 ? 1 : 0;
+    m_Origin[0] = m_Origin[1] = m_Origin[2] = 0;
+  }
+
+  /** Takes origin, spacing and direction of the image **/
+  template< class TImage >
+  void SetImage(const TImage* image)
+  {
+    vnl_matrix_fixed<double, 3, 3> indexToPhysical;
+    for (int i=0; i<3; i++)
+      for (int j=0; j<3; j++)
+        indexToPhysical[i][j] = image->GetDirection()[i][j]*image->GetSpacing()[j];
+    vnl_matrix_fixed<double, 3, 3> physicalToIndex = vnl_inverse(indexToPhysical);
+
+    for (int i=0; i<3; i++)
+    {
+      m_Origin[i] = image->GetOrigin()[i];
+      for (int j=0; j<3; j++)
+        m_Matrix[3*i+j] = physicalToIndex[i][j];
+    }
+  }
+
+  void TransformPoint(const double point[3], double index[3]) const
+  {
+    double x = point[0]-m_Origin[0];
+    double y = point[1]-m_Origin[1];
+    double z = point[2]-m_Origin[2];
+    index[0] = m_Matrix[0]*x + m_Matrix[1]*y + m_Matrix[2]*z;
+    index[1] = m_Matrix[3]*x + m_Matrix[4]*y + m_Matrix[5]*z;
+    index[2] = m_Matrix[6]*x + m_Matrix[7]*y + m_Matrix[8]*z;
+  }
+
+  /** Continuous indices of the numPoints points of a fiber, stored as x0 y0 z0 x1 y1 z1 ... in indices **/
+  void TransformFiber(vtkPoints* points, const vtkIdType* ids, vtkIdType numPoints, std::vector<double>& indices) const
+  {
+    indices.resize(3*numPoints);
+    if (numPoints<=0)
+      return;
+    for (vtkIdType j=0; j<numPoints; j++)
+      points->GetPoint(ids[j], &indices[3*j]);
+    TransformPoints(&indices[0], numPoints, &indices[0]);
+  }
+
+  /** Transforms numPoints points stored as x0 y0 z0 x1 y1 z1 ..., points and indices may be the same array **/
+  void TransformPoints(const double* points, vtkIdType numPoints, double* indices) const
+  {
+    const double m00 = m_Matrix[0], m01 = m_Matrix[1], m02 = m_Matrix[2];
+    const double m10 = m_Matrix[3], m11 = m_Matrix[4], m12 = m_Matrix[5];
+    const double m20 = m_Matrix[6], m21 = m_Matrix[7], m22 = m_Matrix[8];
+    const double o0 = m_Origin[0], o1 = m_Origin[1], o2 = m_Origin[2];
+    for (vtkIdType j=0; j<3*numPoints; j+=3)
+    {
+      double x = points[j]-o0;
+      double y = points[j+1]-o1;
+      double z = points[j+2]-o2;
+      indices[j]   = m00*x + m01*y + m02*z;
+      indices[j+1] = m10*x + m11*y + m12*z;
+      indices[j+2] = m20*x + m21*y + m22*z;
+    }
+  }
+
+  /** Position of each line in the connectivity array of lines, so that threads can access any fiber directly **/
+  static void GetFiberOffsets(vtkCellArray* lines, std::vector<vtkIdType>& offsets)
+  {
+    offsets.resize(lines->GetNumberOfCells());
+    const vtkIdType* connectivity = lines->GetPointer();
+    for (vtkIdType i=0, loc=0; i<(vtkIdType)offsets.size(); i++)
+    {
+      offsets[i] = loc;
+      loc += connectivity[loc]+1;
+    }
+  }
+
+  /** Fibers first to last-1 of thread threadId, the fibers are split into numThreads contiguous ranges **/
+  static void GetFiberRange(int numFibers, int threadId, int numThreads, int& first, int& last)
+  {
+    first = (int)((long long)numFibers*threadId/numThreads);
+    last = (int)((long long)numFibers*(threadId+1)/numThreads);
+  }
+
+  /**
+  * Number of threads for numFibers fibers if every thread but the first needs its own image buffer of bufferSize bytes.
+  * The additional buffers together do not exceed maxBufferMemory bytes, at least one thread is used.
+  **/
+  static int GetNumberOfThreads(int maxThreads, int numFibers, std::size_t bufferSize, std::size_t maxBufferMemory)
+  {
+    int numThreads = std::max(1, std::min(maxThreads, numFibers));
+    if (bufferSize>0 && (std::size_t)(numThreads-1) > maxBufferMemory/bufferSize)
+      numThreads = (int)(maxBufferMemory/bufferSize)+1;
+    return numThreads;
+  }
+
+protected:
+
+  double m_Matrix[9];   ///< physical to index matrix, row major
+  double m_Origin[3];
+};
+
+}
+
+#endif // __itkFiberPointToIndexTransform_h__
@@ -314,8 +314,18 @@ void GibbsTrackingFilter< ItkQBallImageType >::GenerateData()
                 m_NumConnections = particleGrid->m_NumConnections;
 
                 FiberBuilder fiberBuilder(particleGrid, m_MaskImage);
-                m_FiberPolyData = fiberBuilder.iterate(m_MinFiberLength);
-                m_NumAcceptedFibers = m_FiberPolyData->GetNumberOfLines();
+                bool lastIteration = i==singleIts-1 && m_CurrentStep==m_Steps;
+                if (lastIteration && m_FiberWriter.IsNotNull())
+                {
+                    fiberBuilder.SetFiberWriter(m_FiberWriter);
+                    m_FiberPolyData = fiberBuilder.iterate(m_MinFiberLength);
+                    m_NumAcceptedFibers = m_FiberWriter->GetNumberOfFibers();
+                }
+                else
+                {
+                    m_FiberPolyData = fiberBuilder.iterate(m_MinFiberLength);
+                    m_NumAcceptedFibers = m_FiberPolyData->GetNumberOfLines();
+                }
                 m_BuildFibers = false;
             }
             counter++;
@@ -331,8 +341,17 @@ void GibbsTrackingFilter< ItkQBallImageType >::GenerateData()
     if (m_AbortTracking)
     {
         FiberBuilder fiberBuilder(particleGrid, m_MaskImage);
-        m_FiberPolyData = fiberBuilder.iterate(m_MinFiberLength);
-        m_NumAcceptedFibers = m_FiberPolyData->GetNumberOfLines();
+        if (m_FiberWriter.IsNotNull())
+        {
+            fiberBuilder.SetFiberWriter(m_FiberWriter);
+            m_FiberPolyData = fiberBuilder.iterate(m_MinFiberLength);
+            m_NumAcceptedFibers = m_FiberWriter->GetNumberOfFibers();
+        }
+        else
+        {
+            m_FiberPolyData = fiberBuilder.iterate(m_MinFiberLength);
+            m_NumAcceptedFibers = m_FiberPolyData->GetNumberOfLines();
+        }
     }
     clock.Stop();
 
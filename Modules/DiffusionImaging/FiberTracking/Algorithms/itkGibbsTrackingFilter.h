@@ -18,6 +18,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 // MITK
 #include <mitkSphereInterpolator.h>
+#include <mitkFiberBundleXBinaryFile.h>
 
 // ITK
 #include <itkProcessObject.h>
@@ -35,7 +36,9 @@ See LICENSE.txt or http://www.mitk.org for details.
 namespace itk{
 
 /**
-* \brief Performes global fiber tractography on the input Q-Ball or tensor image (Gibbs tracking, Reisert 2010).   */
+* \brief Performes global fiber tractography on the input Q-Ball or tensor image (Gibbs tracking, Reisert 2010).
+*
+* If a FiberWriter is set, the final fibers are written to it one by one instead of being collected in the output polydata.   */
 
 template< class ItkQBallImageType >
 class GibbsTrackingFilter : public ProcessObject
@@ -90,6 +93,9 @@ public:
     itkSetMacro(MaskImage, ItkFloatImageType::Pointer)
     itkSetMacro(TensorImage, ItkTensorImage::Pointer)
 
+    // output file
+    itkSetObjectMacro(FiberWriter, mitk::FiberBundleXBinaryWriter)   ///< open writer which receives the final fibers
+
     void GenerateData();
 
     virtual void Update(){
@@ -140,6 +146,7 @@ protected:
     bool            m_IsInValidState;       ///< Whether the filter is in a valid state, false if error occured
 
     FiberPolyDataType m_FiberPolyData;      ///< container for reconstructed fibers
+    mitk::FiberBundleXBinaryWriter::Pointer m_FiberWriter; ///< receives the final fibers instead of m_FiberPolyData if set
 
     //Constant values
     static const int m_ParticleGridCellCapacity = 1024;
@@ -20,11 +20,14 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <time.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <algorithm>
 
 #include "itkStreamlineTrackingFilter.h"
 #include <itkImageRegionConstIterator.h>
 #include <itkImageRegionConstIteratorWithIndex.h>
 #include <itkImageRegionIterator.h>
+#include <itkMersenneTwisterRandomVariateGenerator.h>
+#include <vtkIdTypeArray.h>
 
 #define _USE_MATH_DEFINES
 #include <math.h>
@@ -44,7 +47,8 @@ TPDPixelType>
     m_F(1.0),
     m_G(0.0),
     m_Interpolate(true),
-    m_MinTractLength(0.0)
+    m_MinTractLength(0.0),
+    m_NextSeed(0)
 {
     // At least 1 inputs is necessary for a vector image.
     // For images added one at a time we need at least six
@@ -66,8 +70,6 @@ TPDPixelType>
 ::BeforeThreadedGenerateData()
 {
     m_FiberPolyData = FiberPolyDataType::New();
-    m_Points = vtkPoints::New();
-    m_Cells = vtkCellArray::New();
 
     m_InputImage = static_cast< InputImageType * >( this->ProcessObject::GetInput(0) );
     m_ImageSize.resize(3);
@@ -96,12 +98,8 @@ TPDPixelType>
         m_PointPistance = 0.5*minSpacing;
     }
 
-    m_PolyDataContainer = itk::VectorContainer< int, FiberPolyDataType >::New();
-    for (int i=0; i<this->GetNumberOfThreads(); i++)
-    {
-        FiberPolyDataType poly = FiberPolyDataType::New();
-        m_PolyDataContainer->InsertElement(i, poly);
-    }
+    m_FiberBuffers.clear();
+    m_FiberBuffers.resize(this->GetNumberOfThreads());
 
     if (m_SeedImage.IsNull())
     {
@@ -150,27 +148,24 @@ TPDPixelType>
     m_EmaxImage->Allocate();
     m_EmaxImage->FillBuffer(1.0);
 
-    typedef itk::DiffusionTensor3D<TTensorPixelType>    TensorType;
-    typename TensorType::EigenValuesArrayType eigenvalues;
-    typename TensorType::EigenVectorsMatrixType eigenvectors;
-    for (int x=0; x<m_ImageSize[0]; x++)
-        for (int y=0; y<m_ImageSize[1]; y++)
-            for (int z=0; z<m_ImageSize[2]; z++)
-            {
-                typename InputImageType::IndexType index;
-                index[0] = x; index[1] = y; index[2] = z;
-                typename InputImageType::PixelType tensor = m_InputImage->GetPixel(index);
-
-                vnl_vector_fixed<double,3> dir;
-                tensor.ComputeEigenAnalysis(eigenvalues, eigenvectors);
-                dir[0] = eigenvectors(2, 0);
-                dir[1] = eigenvectors(2, 1);
-                dir[2] = eigenvectors(2, 2);
-                dir.normalize();
-                m_PdImage->SetPixel(index, dir);
-                m_FaImage->SetPixel(index, tensor.GetFractionalAnisotropy());
-                m_EmaxImage->SetPixel(index, 2/eigenvalues[2]);
-            }
+    // one eigen analysis per voxel, the whole image is needed before tracking can start
+    itk::MultiThreader::Pointer threader = itk::MultiThreader::New();
+    threader->SetNumberOfThreads(this->GetNumberOfThreads());
+    threader->SetSingleMethod(ComputeDerivedImagesThread, this);
+    threader->SingleMethodExecute();
+
+    // collect seed voxels, they are distributed dynamically in ThreadedGenerateData()
+    typedef ImageRegionConstIteratorWithIndex< ItkUcharImgType > MaskIteratorType;
+    typedef ImageRegionConstIterator< ItkFloatImgType >          FloatIteratorType;
+    typename OutputImageType::RegionType region = this->GetOutput()->GetRequestedRegion();
+    MaskIteratorType    mit(m_SeedImage, region );
+    MaskIteratorType    mit2(m_MaskImage, region );
+    FloatIteratorType   fit(m_FaImage, region );
+    m_Seeds.clear();
+    m_NextSeed = 0;
+    for (mit.GoToBegin(), mit2.GoToBegin(), fit.GoToBegin(); !mit.IsAtEnd(); ++mit, ++mit2, ++fit)
+        if (mit.Value()!=0 && fit.Value()>=m_FaThreshold && mit2.Value()!=0)
+            m_Seeds.push_back(mit.GetIndex());
 
     if (m_Interpolate)
         std::cout << "StreamlineTrackingFilter: using trilinear interpolation" << std::endl;
@@ -190,9 +185,61 @@ TPDPixelType>
     std::cout << "StreamlineTrackingFilter: stepsize: " << m_StepSize << " mm" << std::endl;
     std::cout << "StreamlineTrackingFilter: f: " << m_F << std::endl;
     std::cout << "StreamlineTrackingFilter: g: " << m_G << std::endl;
+    std::cout << "StreamlineTrackingFilter: seed voxels: " << m_Seeds.size() << std::endl;
     std::cout << "StreamlineTrackingFilter: starting streamline tracking" << std::endl;
 }
 
+template< class TTensorPixelType, class TPDPixelType>
+ITK_THREAD_RETURN_TYPE StreamlineTrackingFilter< TTensorPixelType, TPDPixelType>
+::ComputeDerivedImagesThread(void* pInfoStruct)
+{
+    itk::MultiThreader::ThreadInfoStruct* pInfo = static_cast<itk::MultiThreader::ThreadInfoStruct*>(pInfoStruct);
+    Self* filter = static_cast<Self*>(pInfo->UserData);
+
+    typedef itk::DiffusionTensor3D<TTensorPixelType>    TensorType;
+    typename TensorType::EigenValuesArrayType eigenvalues;
+    typename TensorType::EigenVectorsMatrixType eigenvectors;
+
+    int firstSlice = filter->m_ImageSize[2]*pInfo->ThreadID/pInfo->NumberOfThreads;
+    int lastSlice = filter->m_ImageSize[2]*(pInfo->ThreadID+1)/pInfo->NumberOfThreads;
+    for (int z=firstSlice; z<lastSlice; z++)
+        for (int y=0; y<filter->m_ImageSize[1]; y++)
+            for (int x=0; x<filter->m_ImageSize[0]; x++)
+            {
+                typename InputImageType::IndexType index;
+                index[0] = x; index[1] = y; index[2] = z;
+                typename InputImageType::PixelType tensor = filter->m_InputImage->GetPixel(index);
+
+                vnl_vector_fixed<double,3> dir;
+                tensor.ComputeEigenAnalysis(eigenvalues, eigenvectors);
+                dir[0] = eigenvectors(2, 0);
+                dir[1] = eigenvectors(2, 1);
+                dir[2] = eigenvectors(2, 2);
+                dir.normalize();
+                filter->m_PdImage->SetPixel(index, dir);
+                filter->m_FaImage->SetPixel(index, tensor.GetFractionalAnisotropy());
+                filter->m_EmaxImage->SetPixel(index, 2/eigenvalues[2]);
+            }
+
+    return ITK_THREAD_RETURN_VALUE;
+}
+
+template< class TTensorPixelType, class TPDPixelType>
+bool StreamlineTrackingFilter< TTensorPixelType, TPDPixelType>
+::GetNextSeedChunk(unsigned long& first, unsigned long& last)
+{
+    // small enough to balance the load, large enough to make locking negligible
+    const unsigned long chunkSize = 64;
+
+    m_SeedLock.Lock();
+    first = m_NextSeed;
+    last = std::min<unsigned long>(first+chunkSize, m_Seeds.size());
+    m_NextSeed = last;
+    m_SeedLock.Unlock();
+
+    return first<last;
+}
+
 template< class TTensorPixelType, class TPDPixelType>
 void StreamlineTrackingFilter< TTensorPixelType, TPDPixelType>
 ::CalculateNewPosition(itk::ContinuousIndex<double, 3>& pos, vnl_vector_fixed<double,3>& dir, typename InputImageType::IndexType& index)
@@ -428,7 +475,7 @@ bool StreamlineTrackingFilter< TTensorPixelType, TPDPixelType>
 
 template< class TTensorPixelType, class TPDPixelType>
 float StreamlineTrackingFilter< TTensorPixelType, TPDPixelType>
-::FollowStreamline(itk::ContinuousIndex<double, 3> pos, int dirSign, vtkPoints* points, std::vector< vtkIdType >& ids)
+::FollowStreamline(itk::ContinuousIndex<double, 3> pos, int dirSign, std::vector< itk::Point<double> >& points)
 {
     float tractLength = 0;
     typedef itk::DiffusionTensor3D<TTensorPixelType>    TensorType;
@@ -464,13 +511,13 @@ float StreamlineTrackingFilter< TTensorPixelType, TPDPixelType>
         if (!IsValidPosition(pos, index, interpWeights))   // if not add last point and end streamline
         {
             m_InputImage->TransformContinuousIndexToPhysicalPoint( pos, worldPos );
-            ids.push_back(points->InsertNextPoint(worldPos.GetDataPointer()));
+            points.push_back(worldPos);
             return tractLength;
         }
         else if (distance>=m_PointPistance)
         {
             m_InputImage->TransformContinuousIndexToPhysicalPoint( pos, worldPos );
-            ids.push_back(points->InsertNextPoint(worldPos.GetDataPointer()));
+            points.push_back(worldPos);
             distance = 0;
         }
 
@@ -564,148 +611,143 @@ template< class TTensorPixelType,
           class TPDPixelType>
 void StreamlineTrackingFilter< TTensorPixelType,
 TPDPixelType>
-::ThreadedGenerateData(const OutputImageRegionType& outputRegionForThread,
+::ThreadedGenerateData(const OutputImageRegionType& /*outputRegionForThread*/,
                        ThreadIdType threadId)
 {
-    FiberPolyDataType poly = m_PolyDataContainer->GetElement(threadId);
-    vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
-    vtkSmartPointer<vtkCellArray> Cells = vtkSmartPointer<vtkCellArray>::New();
-
-    typedef itk::DiffusionTensor3D<TTensorPixelType>        TensorType;
-    typedef ImageRegionConstIterator< InputImageType >      InputIteratorType;
-    typedef ImageRegionConstIterator< ItkUcharImgType >     MaskIteratorType;
-    typedef ImageRegionConstIterator< ItkFloatImgType >     FloatIteratorType;
-    typedef typename InputImageType::PixelType              InputTensorType;
-
-    InputIteratorType   it(m_InputImage, outputRegionForThread );
-    MaskIteratorType    mit(m_SeedImage, outputRegionForThread );
-    FloatIteratorType   fit(m_FaImage, outputRegionForThread );
-    MaskIteratorType    mit2(m_MaskImage, outputRegionForThread );
+    // the seeds of all regions were collected in BeforeThreadedGenerateData()
+    FiberBuffer& buffer = m_FiberBuffers[threadId];
+    std::vector< itk::Point<double> > forwardPoints;
+    std::vector< itk::Point<double> > backwardPoints;
+    itk::Point<double> worldPos;
 
+    // rand() shares its state between threads
+    typedef itk::Statistics::MersenneTwisterRandomVariateGenerator RandGenType;
+    RandGenType::Pointer randGen = RandGenType::New();
+    randGen->SetSeed(threadId);
 
-    it.GoToBegin();
-    mit.GoToBegin();
-    mit2.GoToBegin();
-    fit.GoToBegin();
-    itk::Point<double> worldPos;
-    while( !it.IsAtEnd() )
+    unsigned long first, last;
+    while (GetNextSeedChunk(first, last))
     {
-        if (mit.Value()==0 || fit.Value()<m_FaThreshold || mit2.Value()==0)
-        {
-            ++mit;
-            ++mit2;
-            ++it;
-            ++fit;
-            continue;
-        }
-
-        for (int s=0; s<m_SeedsPerVoxel; s++)
+        for (unsigned long i=first; i<last; i++)
         {
-            vtkSmartPointer<vtkPolyLine> line = vtkSmartPointer<vtkPolyLine>::New();
-            std::vector< vtkIdType > pointIDs;
-            typename InputImageType::IndexType index = it.GetIndex();
-            itk::ContinuousIndex<double, 3> start;
-            unsigned int counter = 0;
-
-            if (m_SeedsPerVoxel>1)
-            {
-                start[0] = index[0]+(double)(rand()%99-49)/100;
-                start[1] = index[1]+(double)(rand()%99-49)/100;
-                start[2] = index[2]+(double)(rand()%99-49)/100;
-            }
-            else
+            const typename InputImageType::IndexType& index = m_Seeds[i];
+            for (int s=0; s<m_SeedsPerVoxel; s++)
             {
-                start[0] = index[0];
-                start[1] = index[1];
-                start[2] = index[2];
-            }
-
-            // forward tracking
-            float tractLength = FollowStreamline(start, 1, points, pointIDs);
+                itk::ContinuousIndex<double, 3> start;
+                if (m_SeedsPerVoxel>1)
+                {
+                    start[0] = index[0]+(double)((int)randGen->GetIntegerVariate(98)-49)/100;
+                    start[1] = index[1]+(double)((int)randGen->GetIntegerVariate(98)-49)/100;
+                    start[2] = index[2]+(double)((int)randGen->GetIntegerVariate(98)-49)/100;
+                }
+                else
+                {
+                    start[0] = index[0];
+                    start[1] = index[1];
+                    start[2] = index[2];
+                }
 
-            // add ids to line
-            counter += pointIDs.size();
-            while (!pointIDs.empty())
-            {
-                line->GetPointIds()->InsertNextId(pointIDs.back());
-                pointIDs.pop_back();
+                forwardPoints.clear();
+                backwardPoints.clear();
+                float tractLength = FollowStreamline(start, 1, forwardPoints);
+                tractLength += FollowStreamline(start, -1, backwardPoints);
+
+                if (tractLength<m_MinTractLength || forwardPoints.size()+backwardPoints.size()<2)
+                    continue;
+
+                // reversed forward part, start point, backward part
+                buffer.m_NumberOfPoints.push_back(forwardPoints.size()+backwardPoints.size()+1);
+                for (int j=forwardPoints.size()-1; j>=0; j--)
+                    buffer.AddPoint(forwardPoints[j]);
+                m_InputImage->TransformContinuousIndexToPhysicalPoint( start, worldPos );
+                buffer.AddPoint(worldPos);
+                for (unsigned int j=0; j<backwardPoints.size(); j++)
+                    buffer.AddPoint(backwardPoints[j]);
+
+                if (m_FiberWriter.IsNotNull() && buffer.m_Coordinates.size()>=FiberBufferSize)
+                    WriteFiberBuffer(buffer);
             }
-
-            // insert start point
-            m_InputImage->TransformContinuousIndexToPhysicalPoint( start, worldPos );
-            line->GetPointIds()->InsertNextId(points->InsertNextPoint(worldPos.GetDataPointer()));
-
-            // backward tracking
-            tractLength += FollowStreamline(start, -1, points, pointIDs);
-
-            counter += pointIDs.size();
-
-            if (tractLength<m_MinTractLength || counter<2)
-                continue;
-
-            // add ids to line
-            for (int i=0; i<pointIDs.size(); i++)
-                line->GetPointIds()->InsertNextId(pointIDs.at(i));
-
-            Cells->InsertNextCell(line);
         }
-        ++mit;
-        ++mit2;
-        ++it;
-        ++fit;
     }
-    poly->SetPoints(points);
-    poly->SetLines(Cells);
 
     std::cout << "Thread " << threadId << " finished tracking" << std::endl;
 }
 
 template< class TTensorPixelType,
           class TPDPixelType>
-vtkSmartPointer< vtkPolyData > StreamlineTrackingFilter< TTensorPixelType,
+void StreamlineTrackingFilter< TTensorPixelType,
 TPDPixelType>
-::AddPolyData(FiberPolyDataType poly1, FiberPolyDataType poly2)
+::AfterThreadedGenerateData()
 {
-    vtkSmartPointer<vtkPolyData> vNewPolyData = vtkSmartPointer<vtkPolyData>::New();
-    vtkSmartPointer<vtkCellArray> vNewLines = poly1->GetLines();
-    vtkSmartPointer<vtkPoints> vNewPoints = poly1->GetPoints();
+    if (m_FiberWriter.IsNotNull())
+    {
+        for (unsigned int t=0; t<m_FiberBuffers.size(); t++)
+            WriteFiberBuffer(m_FiberBuffers[t]);
+        MITK_INFO << m_FiberWriter->GetNumberOfFibers() << " fibers written";
 
-    vtkSmartPointer<vtkCellArray> vLines = poly2->GetLines();
-    vLines->InitTraversal();
-    for( int i=0; i<vLines->GetNumberOfCells(); i++ )
+        m_FiberBuffers.clear();
+        m_Seeds.clear();
+        return;
+    }
+
+    MITK_INFO << "Generating polydata ";
+    vtkIdType numPoints = 0;
+    vtkIdType numFibers = 0;
+    for (unsigned int t=0; t<m_FiberBuffers.size(); t++)
     {
-        vtkIdType   numPoints(0);
-        vtkIdType*  points(NULL);
-        vLines->GetNextCell ( numPoints, points );
+        numPoints += m_FiberBuffers[t].m_Coordinates.size()/3;
+        numFibers += m_FiberBuffers[t].m_NumberOfPoints.size();
+    }
+
+    // the sizes are known, so points and cells are written into preallocated arrays
+    vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
+    points->SetNumberOfPoints(numPoints);
+    vtkSmartPointer<vtkIdTypeArray> cellIds = vtkSmartPointer<vtkIdTypeArray>::New();
+    cellIds->SetNumberOfValues(numFibers+numPoints);
 
-        vtkSmartPointer<vtkPolyLine> container = vtkSmartPointer<vtkPolyLine>::New();
-        for( int j=0; j<numPoints; j++)
+    vtkIdType pointId = 0;
+    vtkIdType cellIndex = 0;
+    for (unsigned int t=0; t<m_FiberBuffers.size(); t++)
+    {
+        const FiberBuffer& buffer = m_FiberBuffers[t];
+        const double* coordinates = buffer.m_Coordinates.empty() ? NULL : &buffer.m_Coordinates[0];
+        for (unsigned int f=0; f<buffer.m_NumberOfPoints.size(); f++)
         {
-            vtkIdType id = vNewPoints->InsertNextPoint(poly2->GetPoint(points[j]));
-            container->GetPointIds()->InsertNextId(id);
+            cellIds->SetValue(cellIndex++, buffer.m_NumberOfPoints[f]);
+            for (vtkIdType j=0; j<buffer.m_NumberOfPoints[f]; j++, coordinates+=3)
+            {
+                points->SetPoint(pointId, coordinates);
+                cellIds->SetValue(cellIndex++, pointId++);
+            }
         }
-        vNewLines->InsertNextCell(container);
     }
 
-    // initialize polydata
-    vNewPolyData->SetPoints(vNewPoints);
-    vNewPolyData->SetLines(vNewLines);
+    vtkSmartPointer<vtkCellArray> cells = vtkSmartPointer<vtkCellArray>::New();
+    cells->SetCells(numFibers, cellIds);
+
+    m_FiberPolyData = FiberPolyDataType::New();
+    m_FiberPolyData->SetPoints(points);
+    m_FiberPolyData->SetLines(cells);
 
-    return vNewPolyData;
+    m_FiberBuffers.clear();
+    m_Seeds.clear();
+    MITK_INFO << "done";
 }
+
 template< class TTensorPixelType,
           class TPDPixelType>
 void StreamlineTrackingFilter< TTensorPixelType,
 TPDPixelType>
-::AfterThreadedGenerateData()
+::WriteFiberBuffer(FiberBuffer& buffer)
 {
-    MITK_INFO << "Generating polydata ";
-    m_FiberPolyData = m_PolyDataContainer->GetElement(0);
-    for (int i=1; i<this->GetNumberOfThreads(); i++)
+    const double* coordinates = buffer.m_Coordinates.empty() ? NULL : &buffer.m_Coordinates[0];
+    for (unsigned int f=0; f<buffer.m_NumberOfPoints.size(); f++)
     {
-        m_FiberPolyData = AddPolyData(m_FiberPolyData, m_PolyDataContainer->GetElement(i));
+        m_FiberWriter->AddFiber(coordinates, buffer.m_NumberOfPoints[f]);
+        coordinates += 3*buffer.m_NumberOfPoints[f];
     }
-    MITK_INFO << "done";
+    buffer.m_Coordinates.clear();
+    buffer.m_NumberOfPoints.clear();
 }
 
 template< class TTensorPixelType,
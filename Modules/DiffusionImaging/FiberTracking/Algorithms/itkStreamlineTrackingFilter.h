@@ -27,16 +27,29 @@ This file is based heavily on a corresponding ITK filter.
 #include <itkVectorContainer.h>
 #include <itkVectorImage.h>
 #include <itkDiffusionTensor3D.h>
+#include <itkMultiThreader.h>
+#include <itkSimpleFastMutexLock.h>
 #include <vtkSmartPointer.h>
 #include <vtkPolyData.h>
 #include <vtkCellArray.h>
 #include <vtkPoints.h>
 #include <vtkPolyLine.h>
+#include <mitkFiberBundleXBinaryFile.h>
 
 namespace itk{
 
 /**
-* \brief Performes deterministic streamline tracking on the input tensor image.   */
+* \brief Performes deterministic streamline tracking on the input tensor image.
+*
+* Seed voxels are handed out to the threads in small chunks, so threads that
+* track short fibers do not wait for the ones that track through dense white matter.
+* Every thread stores its fibers in its own FiberBuffer, all buffers are merged
+* into the output polydata once after tracking. The order of the output fibers
+* therefore depends on the thread scheduling.
+*
+* If a FiberWriter is set, the threads write their fibers to it whenever their
+* buffer is full and no output polydata is generated, so the tracking result is
+* never held in memory as a whole.   */
 
   template< class TTensorPixelType, class TPDPixelType=double>
   class StreamlineTrackingFilter :
@@ -80,6 +93,7 @@ namespace itk{
     itkGetMacro( MinTractLength, float )
     itkSetMacro( MinCurvatureRadius, float )
     itkGetMacro( MinCurvatureRadius, float )
+    itkSetObjectMacro( FiberWriter, mitk::FiberBundleXBinaryWriter )   ///< open writer which receives the fibers instead of the output polydata
 
   protected:
     StreamlineTrackingFilter();
@@ -87,7 +101,7 @@ namespace itk{
     void PrintSelf(std::ostream& os, Indent indent) const;
 
     void CalculateNewPosition(itk::ContinuousIndex<double, 3>& pos, vnl_vector_fixed<double,3>& dir, typename InputImageType::IndexType& index);
-    float FollowStreamline(itk::ContinuousIndex<double, 3> pos, int dirSign, vtkPoints* points, std::vector< vtkIdType >& ids);
+    float FollowStreamline(itk::ContinuousIndex<double, 3> pos, int dirSign, std::vector< itk::Point<double> >& points);
     bool IsValidPosition(itk::ContinuousIndex<double, 3>& pos, typename InputImageType::IndexType& index, vnl_vector_fixed< float, 8 >& interpWeights);
 
     double RoundToNearest(double num);
@@ -95,11 +109,34 @@ namespace itk{
     void ThreadedGenerateData( const OutputImageRegionType &outputRegionForThread, ThreadIdType threadId);
     void AfterThreadedGenerateData();
 
-    FiberPolyDataType AddPolyData(FiberPolyDataType poly1, FiberPolyDataType poly2);
+    /** \brief Computes principal direction, FA and eigenvalue scale of the slices assigned to one thread. */
+    static ITK_THREAD_RETURN_TYPE ComputeDerivedImagesThread(void* pInfoStruct);
+
+    /** \brief Assigns the seeds [first, last) to the calling thread, returns false if all seeds are taken. */
+    bool GetNextSeedChunk(unsigned long& first, unsigned long& last);
+
+    /** \brief Fibers tracked by one thread, stored as plain arrays. */
+    struct FiberBuffer
+    {
+      std::vector< double >     m_Coordinates;      ///< x, y, z of all fiber points
+      std::vector< vtkIdType >  m_NumberOfPoints;   ///< number of points of each fiber
+
+      void AddPoint(const itk::Point<double>& point)
+      {
+        m_Coordinates.push_back(point[0]);
+        m_Coordinates.push_back(point[1]);
+        m_Coordinates.push_back(point[2]);
+      }
+    };
+
+    /** \brief Number of coordinates a thread collects before it writes them to m_FiberWriter. */
+    static const unsigned int FiberBufferSize = 3*65536;
+
+    /** \brief Writes the fibers of buffer to m_FiberWriter and clears buffer. */
+    void WriteFiberBuffer(FiberBuffer& buffer);
 
     FiberPolyDataType m_FiberPolyData;
-    vtkSmartPointer<vtkPoints> m_Points;
-    vtkSmartPointer<vtkCellArray> m_Cells;
+    mitk::FiberBundleXBinaryWriter::Pointer m_FiberWriter;
 
     ItkFloatImgType::Pointer    m_EmaxImage;
     ItkFloatImgType::Pointer    m_FaImage;
@@ -121,7 +158,10 @@ namespace itk{
     bool m_Interpolate;
     float m_PointPistance;
 
-    itk::VectorContainer< int, FiberPolyDataType >::Pointer m_PolyDataContainer;
+    std::vector< FiberBuffer > m_FiberBuffers;
+    std::vector< typename InputImageType::IndexType > m_Seeds;
+    unsigned long m_NextSeed;
+    SimpleFastMutexLock m_SeedLock;
 
   private:
 
@@ -22,7 +22,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 // misc
 #include <math.h>
-#include <boost/progress.hpp>
+#include <algorithm>
 
 namespace itk{
 
@@ -34,6 +34,8 @@ TractDensityImageFilter< OutputImageType >::TractDensityImageFilter()
     , m_InputImage(NULL)
     , m_UseImageGeometry(false)
     , m_OutputAbsoluteValues(false)
+    , m_ThreadBufferMemoryLimit(1024*1024*1024)
+    , m_ThreadFiberPolyData(NULL)
 {
 
 }
@@ -127,49 +129,100 @@ void TractDensityImageFilter< OutputImageType >::GenerateData()
 
     MITK_INFO << "TractDensityImageFilter: starting image generation";
     vtkSmartPointer<vtkPolyData> fiberPolyData = m_FiberBundle->GetFiberPolyData();
-    vtkSmartPointer<vtkCellArray> vLines = fiberPolyData->GetLines();
-    vLines->InitTraversal();
     int numFibers = m_FiberBundle->GetNumFibers();
-    boost::progress_display disp(numFibers);
-    for( int i=0; i<numFibers; i++ )
+    m_ThreadFiberPolyData = fiberPolyData;
+    FiberPointToIndexTransform::GetFiberOffsets(fiberPolyData->GetLines(), m_FiberOffsets);
+    m_PointToIndex.SetImage(outImage.GetPointer());
+    m_ImageSize[0] = w;
+    m_ImageSize[1] = h;
+    m_ImageSize[2] = d;
+
+    std::size_t threadBufferSize = (std::size_t)w*h*d*sizeof(OutPixelType);
+    int numThreads = FiberPointToIndexTransform::GetNumberOfThreads(this->GetNumberOfThreads(), numFibers, threadBufferSize, m_ThreadBufferMemoryLimit);
+    m_ThreadBufferStorage.resize(numThreads-1);
+    m_ThreadBuffers.resize(numThreads);
+    m_ThreadBuffers[0] = outImageBufferPointer;
+    for (int t=1; t<numThreads; t++)
     {
-        ++disp;
-        vtkIdType   numPoints(0);
-        vtkIdType*  points(NULL);
-        vLines->GetNextCell ( numPoints, points );
+        m_ThreadBufferStorage[t-1].assign(w*h*d, 0);
+        m_ThreadBuffers[t] = &m_ThreadBufferStorage[t-1][0];
+    }
 
-        // fill output image
-        for( int j=0; j<numPoints; j++)
+    itk::MultiThreader::Pointer threader = itk::MultiThreader::New();
+    threader->SetNumberOfThreads(numThreads);
+    threader->SetSingleMethod(GenerateFiberDensityThread, this);
+    threader->SingleMethodExecute();
+
+    // add the buffers of the other threads to the output
+    for (int t=1; t<numThreads; t++)
+    {
+        const OutPixelType* threadBuffer = m_ThreadBuffers[t];
+        if (m_BinaryOutput)
         {
-            itk::Point<float, 3> vertex = GetItkPoint(fiberPolyData->GetPoint(points[j]));
-            itk::Index<3> index;
-            itk::ContinuousIndex<float, 3> contIndex;
-            outImage->TransformPhysicalPointToIndex(vertex, index);
-            outImage->TransformPhysicalPointToContinuousIndex(vertex, contIndex);
+            for (int i=0; i<w*h*d; i++)
+                if (threadBuffer[i]>0)
+                    outImageBufferPointer[i] = 1;
+        }
+        else
+            for (int i=0; i<w*h*d; i++)
+                outImageBufferPointer[i] += threadBuffer[i];
+    }
+    m_ThreadBufferStorage.clear();
+    m_ThreadBuffers.clear();
+    m_FiberOffsets.clear();
+    m_ThreadFiberPolyData = NULL;
 
-            float frac_x = contIndex[0] - index[0];
-            float frac_y = contIndex[1] - index[1];
-            float frac_z = contIndex[2] - index[2];
+    if (!m_OutputAbsoluteValues && !m_BinaryOutput)
+    {
+        MITK_INFO << "TractDensityImageFilter: max-normalizing output image";
+        OutPixelType max = 0;
+        for (int i=0; i<w*h*d; i++)
+            if (max < outImageBufferPointer[i])
+                max = outImageBufferPointer[i];
+        if (max>0)
+            for (int i=0; i<w*h*d; i++)
+                outImageBufferPointer[i] /= max;
+    }
+    if (m_InvertImage)
+    {
+        MITK_INFO << "TractDensityImageFilter: inverting image";
+        for (int i=0; i<w*h*d; i++)
+            outImageBufferPointer[i] = 1-outImageBufferPointer[i];
+    }
+    MITK_INFO << "TractDensityImageFilter: finished processing";
+}
 
-            if (frac_x<0)
-            {
-                index[0] -= 1;
-                frac_x += 1;
-            }
-            if (frac_y<0)
-            {
-                index[1] -= 1;
-                frac_y += 1;
-            }
-            if (frac_z<0)
-            {
-                index[2] -= 1;
-                frac_z += 1;
-            }
+template< class OutputImageType >
+ITK_THREAD_RETURN_TYPE TractDensityImageFilter< OutputImageType >::GenerateFiberDensityThread(void* pInfoStruct)
+{
+    itk::MultiThreader::ThreadInfoStruct* pInfo = static_cast<itk::MultiThreader::ThreadInfoStruct*>(pInfoStruct);
+    Self* filter = static_cast<Self*>(pInfo->UserData);
 
-            frac_x = 1-frac_x;
-            frac_y = 1-frac_y;
-            frac_z = 1-frac_z;
+    int w = filter->m_ImageSize[0];
+    int h = filter->m_ImageSize[1];
+    int d = filter->m_ImageSize[2];
+    OutPixelType* outImageBufferPointer = filter->m_ThreadBuffers[pInfo->ThreadID];
+    vtkPoints* fiberPoints = filter->m_ThreadFiberPolyData->GetPoints();
+    const vtkIdType* connectivity = filter->m_ThreadFiberPolyData->GetLines()->GetPointer();
+
+    int firstFiber, lastFiber;
+    FiberPointToIndexTransform::GetFiberRange((int)filter->m_FiberOffsets.size(), pInfo->ThreadID, pInfo->NumberOfThreads, firstFiber, lastFiber);
+
+    std::vector<double> contIndices;
+    for( int i=firstFiber; i<lastFiber; i++ )
+    {
+        vtkIdType numPoints = connectivity[filter->m_FiberOffsets[i]];
+        const vtkIdType* points = connectivity+filter->m_FiberOffsets[i]+1;
+        filter->m_PointToIndex.TransformFiber(fiberPoints, points, numPoints, contIndices);
+
+        // fill output image
+        for( int j=0; j<numPoints; j++)
+        {
+            const double* contIndex = &contIndices[3*j];
+            itk::Index<3> index;
+            index[0] = (long)floor(contIndex[0]);
+            index[1] = (long)floor(contIndex[1]);
+            index[2] = (long)floor(contIndex[2]);
 
             // int coordinates inside image?
             if (index[0] < 0 || index[0] >= w-1)
@@ -179,7 +232,11 @@ void TractDensityImageFilter< OutputImageType >::GenerateData()
             if (index[2] < 0 || index[2] >= d-1)
                 continue;
 
-            if (m_BinaryOutput)
+            float frac_x = 1-(contIndex[0] - index[0]);
+            float frac_y = 1-(contIndex[1] - index[1]);
+            float frac_z = 1-(contIndex[2] - index[2]);
+
+            if (filter->m_BinaryOutput)
             {
                 outImageBufferPointer[( index[0]   + w*(index[1]  + h*index[2]  ))] = 1;
                 outImageBufferPointer[( index[0]   + w*(index[1]+1+ h*index[2]  ))] = 1;
@@ -203,24 +260,6 @@ void TractDensityImageFilter< OutputImageType >::GenerateData()
             }
         }
     }
-
-    if (!m_OutputAbsoluteValues && !m_BinaryOutput)
-    {
-        MITK_INFO << "TractDensityImageFilter: max-normalizing output image";
-        OutPixelType max = 0;
-        for (int i=0; i<w*h*d; i++)
-            if (max < outImageBufferPointer[i])
-                max = outImageBufferPointer[i];
-        if (max>0)
-            for (int i=0; i<w*h*d; i++)
-                outImageBufferPointer[i] /= max;
-    }
-    if (m_InvertImage)
-    {
-        MITK_INFO << "TractDensityImageFilter: inverting image";
-        for (int i=0; i<w*h*d; i++)
-            outImageBufferPointer[i] = 1-outImageBufferPointer[i];
-    }
-    MITK_INFO << "TractDensityImageFilter: finished processing";
+    return ITK_THREAD_RETURN_VALUE;
 }
 }
@@ -20,12 +20,19 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <itkImage.h>
 #include <itkVectorContainer.h>
 #include <itkRGBAPixel.h>
+#include <itkMultiThreader.h>
 #include <mitkFiberBundleX.h>
+#include "itkFiberPointToIndexTransform.h"
 
 namespace itk{
 
 /**
-* \brief Generates tract density images from input fiberbundles (Calamante 2010).   */
+* \brief Generates tract density images from input fiberbundles (Calamante 2010).
+*
+* The fibers are split into one contiguous range per thread. The first thread writes into the output image, every other
+* thread into its own image buffer, which are added to the output at the end. Uses one additional image per thread,
+* the number of threads is reduced so that these images together stay below ThreadBufferMemoryLimit.
+*/
 
 template< class OutputImageType >
 class TractDensityImageFilter : public ImageSource< OutputImageType >
@@ -54,6 +61,8 @@ public:
   itkGetMacro( UseImageGeometry, bool)                          ///< use input image geometry to initialize output image
   itkSetMacro( FiberBundle, mitk::FiberBundleX::Pointer)        ///< input fiber bundle
   itkSetMacro( InputImage, typename OutputImageType::Pointer)   ///< use input image geometry to initialize output image
+  itkSetMacro( ThreadBufferMemoryLimit, std::size_t)            ///< maximum size in bytes of the additional image buffers of the threads
+  itkGetMacro( ThreadBufferMemoryLimit, std::size_t)            ///< maximum size in bytes of the additional image buffers of the threads
 
   void GenerateData();
 
@@ -61,6 +70,9 @@ protected:
 
   itk::Point<float, 3> GetItkPoint(double point[3]);
 
+  /** Splats the fibers of one thread into its buffer **/
+  static ITK_THREAD_RETURN_TYPE GenerateFiberDensityThread(void* pInfoStruct);
+
   TractDensityImageFilter();
   virtual ~TractDensityImageFilter();
 
@@ -71,6 +83,15 @@ protected:
   bool                              m_BinaryOutput;         ///< generate binary fiber envelope
   bool                              m_UseImageGeometry;     ///< use input image geometry to initialize output image
   bool                              m_OutputAbsoluteValues; ///< do not normalize image values to 0-1
+  std::size_t                       m_ThreadBufferMemoryLimit; ///< maximum size in bytes of the additional image buffers of the threads, default 1 GB
+
+  // state shared by the threads of GenerateData()
+  vtkPolyData*                      m_ThreadFiberPolyData;
+  std::vector<vtkIdType>            m_FiberOffsets;         ///< position of each fiber in the connectivity array
+  FiberPointToIndexTransform        m_PointToIndex;
+  int                               m_ImageSize[3];
+  std::vector< OutPixelType* >      m_ThreadBuffers;        ///< output buffer for thread 0, own buffer for the others
+  std::vector< std::vector< OutPixelType > > m_ThreadBufferStorage;
 };
 
 }
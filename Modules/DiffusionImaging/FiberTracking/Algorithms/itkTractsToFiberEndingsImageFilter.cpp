@@ -19,7 +19,9 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <vtkPolyLine.h>
 #include <vtkCellArray.h>
 #include <vtkCellData.h>
-#include <boost/progress.hpp>
+
+#include <math.h>
+#include <algorithm>
 
 namespace itk{
 
@@ -30,6 +32,7 @@ namespace itk{
     , m_InputImage(NULL)
     , m_UseImageGeometry(false)
     , m_BinaryOutput(false)
+    , m_ThreadFiberPolyData(NULL)
   {
 
   }
@@ -117,44 +120,88 @@ namespace itk{
         minSpacing = newSpacing[2];
 
     vtkSmartPointer<vtkPolyData> fiberPolyData = m_FiberBundle->GetFiberPolyData();
-    vtkSmartPointer<vtkCellArray> vLines = fiberPolyData->GetLines();
-    vLines->InitTraversal();
-
     int numFibers = m_FiberBundle->GetNumFibers();
-    boost::progress_display disp(numFibers);
-    for( int i=0; i<numFibers; i++ )
+    m_ThreadFiberPolyData = fiberPolyData;
+    FiberPointToIndexTransform::GetFiberOffsets(fiberPolyData->GetLines(), m_FiberOffsets);
+    m_PointToIndex.SetImage(outImage.GetPointer());
+    m_ImageSize[0] = w;
+    m_ImageSize[1] = h;
+    m_ImageSize[2] = d;
+
+    int numThreads = std::max(1, std::min((int)this->GetNumberOfThreads(), numFibers));
+    m_ThreadEndings.clear();
+    m_ThreadEndings.resize(numThreads);
+
+    itk::MultiThreader::Pointer threader = itk::MultiThreader::New();
+    threader->SetNumberOfThreads(numThreads);
+    threader->SetSingleMethod(CollectFiberEndingsThread, this);
+    threader->SingleMethodExecute();
+
+    // fill output image
+    for (int t=0; t<numThreads; t++)
     {
-        ++disp;
-      vtkIdType   numPoints(0);
-      vtkIdType*  points(NULL);
-      vLines->GetNextCell ( numPoints, points );
-
-      // fill output image
-      if (numPoints>0)
+      const std::vector<int>& endings = m_ThreadEndings[t];
+      for (unsigned int i=0; i<endings.size(); i++)
       {
-        itk::Point<float, 3> vertex = GetItkPoint(fiberPolyData->GetPoint(points[0]));
-        itk::Index<3> index;
-        outImage->TransformPhysicalPointToIndex(vertex, index);
         if (m_BinaryOutput)
-            outImage->SetPixel(index, 1);
+          outImageBufferPointer[endings[i]] = 1;
         else
-            outImage->SetPixel(index, outImage->GetPixel(index)+1);
-      }
-
-      if (numPoints>2)
-      {
-        itk::Point<float, 3> vertex = GetItkPoint(fiberPolyData->GetPoint(points[numPoints-1]));
-        itk::Index<3> index;
-        outImage->TransformPhysicalPointToIndex(vertex, index);
-        if (m_BinaryOutput)
-            outImage->SetPixel(index, 1);
-        else
-            outImage->SetPixel(index, outImage->GetPixel(index)+1);
+          outImageBufferPointer[endings[i]] += 1;
       }
     }
+    m_ThreadEndings.clear();
+    m_FiberOffsets.clear();
+    m_ThreadFiberPolyData = NULL;
 
     if (m_InvertImage)
       for (int i=0; i<w*h*d; i++)
         outImageBufferPointer[i] = 1-outImageBufferPointer[i];
   }
+
+  template< class OutputImageType >
+  ITK_THREAD_RETURN_TYPE TractsToFiberEndingsImageFilter< OutputImageType >::CollectFiberEndingsThread(void* pInfoStruct)
+  {
+    itk::MultiThreader::ThreadInfoStruct* pInfo = static_cast<itk::MultiThreader::ThreadInfoStruct*>(pInfoStruct);
+    Self* filter = static_cast<Self*>(pInfo->UserData);
+
+    int w = filter->m_ImageSize[0];
+    int h = filter->m_ImageSize[1];
+    int d = filter->m_ImageSize[2];
+    std::vector<int>& endings = filter->m_ThreadEndings[pInfo->ThreadID];
+    vtkPoints* fiberPoints = filter->m_ThreadFiberPolyData->GetPoints();
+    const vtkIdType* connectivity = filter->m_ThreadFiberPolyData->GetLines()->GetPointer();
+
+    int firstFiber, lastFiber;
+    FiberPointToIndexTransform::GetFiberRange((int)filter->m_FiberOffsets.size(), pInfo->ThreadID, pInfo->NumberOfThreads, firstFiber, lastFiber);
+
+    for( int i=firstFiber; i<lastFiber; i++ )
+    {
+      vtkIdType numPoints = connectivity[filter->m_FiberOffsets[i]];
+      const vtkIdType* points = connectivity+filter->m_FiberOffsets[i]+1;
+
+      // first point of every fiber, last point of fibers with more than two points
+      vtkIdType endPoints[2];
+      int numEndPoints = 0;
+      if (numPoints>0)
+        endPoints[numEndPoints++] = points[0];
+      if (numPoints>2)
+        endPoints[numEndPoints++] = points[numPoints-1];
+
+      for (int j=0; j<numEndPoints; j++)
+      {
+        double vertex[3], contIndex[3];
+        fiberPoints->GetPoint(endPoints[j], vertex);
+        filter->m_PointToIndex.TransformPoint(vertex, contIndex);
+
+        // nearest voxel, rounded like Image::TransformPhysicalPointToIndex()
+        long index[3];
+        for (int k=0; k<3; k++)
+          index[k] = (long)floor(contIndex[k]+0.5);
+        if (index[0]<0 || index[0]>=w || index[1]<0 || index[1]>=h || index[2]<0 || index[2]>=d)
+          continue;
+        endings.push_back(index[0] + w*(index[1] + h*index[2]));
+      }
+    }
+    return ITK_THREAD_RETURN_VALUE;
+  }
 }
@@ -20,12 +20,17 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <itkImage.h>
 #include <itkVectorContainer.h>
 #include <itkRGBAPixel.h>
+#include <itkMultiThreader.h>
 #include <mitkFiberBundleX.h>
+#include "itkFiberPointToIndexTransform.h"
 
 namespace itk{
 
 /**
-* \brief Generates image where the pixel values are set according to the number of fibers ending in the voxel.   */
+* \brief Generates image where the pixel values are set according to the number of fibers ending in the voxel.
+*
+* Each thread collects the voxels of the fiber endings of its range of fibers, the output is written afterwards.
+*/
 
 template< class OutputImageType >
 class TractsToFiberEndingsImageFilter : public ImageSource< OutputImageType >
@@ -65,6 +70,9 @@ protected:
 
   itk::Point<float, 3> GetItkPoint(double point[3]);
 
+  /** Collects the ending voxels of the fibers of one thread **/
+  static ITK_THREAD_RETURN_TYPE CollectFiberEndingsThread(void* pInfoStruct);
+
   TractsToFiberEndingsImageFilter();
   virtual ~TractsToFiberEndingsImageFilter();
 
@@ -74,6 +82,13 @@ protected:
   bool                              m_UseImageGeometry;     ///< output image is given other geometry than fiberbundle (input image geometry)
   bool                              m_BinaryOutput;
   typename OutputImageType::Pointer m_InputImage;
+
+  // state shared by the threads of GenerateData()
+  vtkPolyData*                      m_ThreadFiberPolyData;
+  std::vector<vtkIdType>            m_FiberOffsets;         ///< position of each fiber in the connectivity array
+  FiberPointToIndexTransform        m_PointToIndex;
+  int                               m_ImageSize[3];
+  std::vector< std::vector<int> >   m_ThreadEndings;        ///< buffer offsets of the ending voxels found by each thread
 };
 
 }
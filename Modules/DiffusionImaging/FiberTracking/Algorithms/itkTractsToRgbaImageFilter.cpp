@@ -22,7 +22,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 // misc
 #include <math.h>
-#include <boost/progress.hpp>
+#include <algorithm>
 
 namespace itk{
 
@@ -31,6 +31,8 @@ namespace itk{
     : m_UpsamplingFactor(1)
     , m_InputImage(NULL)
     , m_UseImageGeometry(false)
+    , m_ThreadBufferMemoryLimit(1024*1024*1024)
+    , m_ThreadFiberPolyData(NULL)
   {
 
   }
@@ -108,9 +110,7 @@ namespace itk{
 
     // set/initialize output
     unsigned char* outImageBufferPointer = (unsigned char*)outImage->GetBufferPointer();
-    float* buffer = new float[w*h*d*4];
-    for (int i=0; i<w*h*d*4; i++)
-      buffer[i] = 0;
+    std::vector<float> buffer(w*h*d*4, 0);
 
     // resample fiber bundle
     float minSpacing = 1;
@@ -125,135 +125,44 @@ namespace itk{
     m_FiberBundle->ResampleFibers(minSpacing);
 
     vtkSmartPointer<vtkPolyData> fiberPolyData = m_FiberBundle->GetFiberPolyData();
-    vtkSmartPointer<vtkCellArray> vLines = fiberPolyData->GetLines();
-    vLines->InitTraversal();
-
     int numFibers = m_FiberBundle->GetNumFibers();
-    boost::progress_display disp(numFibers);
-    for( int i=0; i<numFibers; i++ )
+    m_ThreadFiberPolyData = fiberPolyData;
+    FiberPointToIndexTransform::GetFiberOffsets(fiberPolyData->GetLines(), m_FiberOffsets);
+    m_PointToIndex.SetImage(outImage.GetPointer());
+    m_ImageSize[0] = w;
+    m_ImageSize[1] = h;
+    m_ImageSize[2] = d;
+    for (int i=0; i<3; i++)
+      m_ImageSpacing[i] = outImage->GetSpacing()[i];
+
+    std::size_t threadBufferSize = (std::size_t)w*h*d*4*sizeof(float);
+    int numThreads = FiberPointToIndexTransform::GetNumberOfThreads(this->GetNumberOfThreads(), numFibers, threadBufferSize, m_ThreadBufferMemoryLimit);
+    m_ThreadBufferStorage.resize(numThreads-1);
+    m_ThreadBuffers.resize(numThreads);
+    m_ThreadBuffers[0] = &buffer[0];
+    for (int t=1; t<numThreads; t++)
     {
-      ++disp;
-      vtkIdType   numPoints(0);
-      vtkIdType*  points(NULL);
-      vLines->GetNextCell ( numPoints, points );
-
-      // calc directions (which are used as weights)
-      std::list< itk::Point<float, 3> > rgbweights;
-      std::list<float> intensities;
-
-      for( int j=0; j<numPoints-1; j++)
-      {
-
-        itk::Point<float, 3> vertex = GetItkPoint(fiberPolyData->GetPoint(points[j]));
-        itk::Point<float, 3> vertexPost = GetItkPoint(fiberPolyData->GetPoint(points[j+1]));
-
-        itk::Point<float, 3> dir;
-        dir[0] = fabs((vertexPost[0] - vertex[0]) * outImage->GetSpacing()[0]);
-        dir[1] = fabs((vertexPost[1] - vertex[1]) * outImage->GetSpacing()[1]);
-        dir[2] = fabs((vertexPost[2] - vertex[2]) * outImage->GetSpacing()[2]);
-
-        rgbweights.push_back(dir);
-
-        float intensity = sqrt(dir[0]*dir[0]+dir[1]*dir[1]+dir[2]*dir[2]);
-        intensities.push_back(intensity);
-
-        // last point gets same as previous one
-        if(j==numPoints-2)
-        {
-          rgbweights.push_back(dir);
-          intensities.push_back(intensity);
-        }
-      }
-
-      // fill output image
-      for( int j=0; j<numPoints; j++)
-      {
-        itk::Point<float, 3> vertex = GetItkPoint(fiberPolyData->GetPoint(points[j]));
-        itk::Index<3> index;
-        itk::ContinuousIndex<float, 3> contIndex;
-        outImage->TransformPhysicalPointToIndex(vertex, index);
-        outImage->TransformPhysicalPointToContinuousIndex(vertex, contIndex);
-
-        float frac_x = contIndex[0] - index[0];
-        float frac_y = contIndex[1] - index[1];
-        float frac_z = contIndex[2] - index[2];
-
-        int px = index[0];
-        if (frac_x<0)
-        {
-          px -= 1;
-          frac_x += 1;
-        }
+      m_ThreadBufferStorage[t-1].assign(w*h*d*4, 0);
+      m_ThreadBuffers[t] = &m_ThreadBufferStorage[t-1][0];
+    }
 
-        int py = index[1];
-        if (frac_y<0)
-        {
-          py -= 1;
-          frac_y += 1;
-        }
+    itk::MultiThreader::Pointer threader = itk::MultiThreader::New();
+    threader->SetNumberOfThreads(numThreads);
+    threader->SetSingleMethod(GenerateFiberColorsThread, this);
+    threader->SingleMethodExecute();
 
-        int pz = index[2];
-        if (frac_z<0)
-        {
-          pz -= 1;
-          frac_z += 1;
-        }
-
-        // int coordinates inside image?
-        if (px < 0 || px >= w-1)
-          continue;
-        if (py < 0 || py >= h-1)
-          continue;
-        if (pz < 0 || pz >= d-1)
-          continue;
-
-        float scale = 100 * pow((float)m_UpsamplingFactor,3);
-        itk::Point<float, 3> rgbweight = rgbweights.front();
-        rgbweights.pop_front();
-        float intweight = intensities.front();
-        intensities.pop_front();
-
-        // add to r-channel in output image
-        buffer[0+4*( px   + w*(py  + h*pz  ))] += (1-frac_x)*(1-frac_y)*(1-frac_z) * rgbweight[0] * scale;
-        buffer[0+4*( px   + w*(py+1+ h*pz  ))] += (1-frac_x)*(  frac_y)*(1-frac_z) * rgbweight[0] * scale;
-        buffer[0+4*( px   + w*(py  + h*pz+h))] += (1-frac_x)*(1-frac_y)*(  frac_z) * rgbweight[0] * scale;
-        buffer[0+4*( px   + w*(py+1+ h*pz+h))] += (1-frac_x)*(  frac_y)*(  frac_z) * rgbweight[0] * scale;
-        buffer[0+4*( px+1 + w*(py  + h*pz  ))] += (  frac_x)*(1-frac_y)*(1-frac_z) * rgbweight[0] * scale;
-        buffer[0+4*( px+1 + w*(py  + h*pz+h))] += (  frac_x)*(1-frac_y)*(  frac_z) * rgbweight[0] * scale;
-        buffer[0+4*( px+1 + w*(py+1+ h*pz  ))] += (  frac_x)*(  frac_y)*(1-frac_z) * rgbweight[0] * scale;
-        buffer[0+4*( px+1 + w*(py+1+ h*pz+h))] += (  frac_x)*(  frac_y)*(  frac_z) * rgbweight[0] * scale;
-
-        // add to g-channel in output image
-        buffer[1+4*( px   + w*(py  + h*pz  ))] += (1-frac_x)*(1-frac_y)*(1-frac_z) * rgbweight[1] * scale;
-        buffer[1+4*( px   + w*(py+1+ h*pz  ))] += (1-frac_x)*(  frac_y)*(1-frac_z) * rgbweight[1] * scale;
-        buffer[1+4*( px   + w*(py  + h*pz+h))] += (1-frac_x)*(1-frac_y)*(  frac_z) * rgbweight[1] * scale;
-        buffer[1+4*( px   + w*(py+1+ h*pz+h))] += (1-frac_x)*(  frac_y)*(  frac_z) * rgbweight[1] * scale;
-        buffer[1+4*( px+1 + w*(py  + h*pz  ))] += (  frac_x)*(1-frac_y)*(1-frac_z) * rgbweight[1] * scale;
-        buffer[1+4*( px+1 + w*(py  + h*pz+h))] += (  frac_x)*(1-frac_y)*(  frac_z) * rgbweight[1] * scale;
-        buffer[1+4*( px+1 + w*(py+1+ h*pz  ))] += (  frac_x)*(  frac_y)*(1-frac_z) * rgbweight[1] * scale;
-        buffer[1+4*( px+1 + w*(py+1+ h*pz+h))] += (  frac_x)*(  frac_y)*(  frac_z) * rgbweight[1] * scale;
-
-        // add to b-channel in output image
-        buffer[2+4*( px   + w*(py  + h*pz  ))] += (1-frac_x)*(1-frac_y)*(1-frac_z) * rgbweight[2] * scale;
-        buffer[2+4*( px   + w*(py+1+ h*pz  ))] += (1-frac_x)*(  frac_y)*(1-frac_z) * rgbweight[2] * scale;
-        buffer[2+4*( px   + w*(py  + h*pz+h))] += (1-frac_x)*(1-frac_y)*(  frac_z) * rgbweight[2] * scale;
-        buffer[2+4*( px   + w*(py+1+ h*pz+h))] += (1-frac_x)*(  frac_y)*(  frac_z) * rgbweight[2] * scale;
-        buffer[2+4*( px+1 + w*(py  + h*pz  ))] += (  frac_x)*(1-frac_y)*(1-frac_z) * rgbweight[2] * scale;
-        buffer[2+4*( px+1 + w*(py  + h*pz+h))] += (  frac_x)*(1-frac_y)*(  frac_z) * rgbweight[2] * scale;
-        buffer[2+4*( px+1 + w*(py+1+ h*pz  ))] += (  frac_x)*(  frac_y)*(1-frac_z) * rgbweight[2] * scale;
-        buffer[2+4*( px+1 + w*(py+1+ h*pz+h))] += (  frac_x)*(  frac_y)*(  frac_z) * rgbweight[2] * scale;
-
-        // add to a-channel in output image
-        buffer[3+4*( px   + w*(py  + h*pz  ))] += (1-frac_x)*(1-frac_y)*(1-frac_z) * intweight * scale;
-        buffer[3+4*( px   + w*(py+1+ h*pz  ))] += (1-frac_x)*(  frac_y)*(1-frac_z) * intweight * scale;
-        buffer[3+4*( px   + w*(py  + h*pz+h))] += (1-frac_x)*(1-frac_y)*(  frac_z) * intweight * scale;
-        buffer[3+4*( px   + w*(py+1+ h*pz+h))] += (1-frac_x)*(  frac_y)*(  frac_z) * intweight * scale;
-        buffer[3+4*( px+1 + w*(py  + h*pz  ))] += (  frac_x)*(1-frac_y)*(1-frac_z) * intweight * scale;
-        buffer[3+4*( px+1 + w*(py  + h*pz+h))] += (  frac_x)*(1-frac_y)*(  frac_z) * intweight * scale;
-        buffer[3+4*( px+1 + w*(py+1+ h*pz  ))] += (  frac_x)*(  frac_y)*(1-frac_z) * intweight * scale;
-        buffer[3+4*( px+1 + w*(py+1+ h*pz+h))] += (  frac_x)*(  frac_y)*(  frac_z) * intweight * scale;
-      }
+    // add the buffers of the other threads
+    for (int t=1; t<numThreads; t++)
+    {
+      const float* threadBuffer = m_ThreadBuffers[t];
+      for (int i=0; i<w*h*d*4; i++)
+        buffer[i] += threadBuffer[i];
     }
+    m_ThreadBufferStorage.clear();
+    m_ThreadBuffers.clear();
+    m_FiberOffsets.clear();
+    m_ThreadFiberPolyData = NULL;
+
     float maxRgb = 0.000000001;
     float maxInt = 0.000000001;
     int numPix;
@@ -283,4 +192,101 @@ namespace itk{
         outImageBufferPointer[i] = (unsigned char) (255.0 * buffer[i] / maxInt);
     }
   }
+
+  template< class OutputImageType >
+  ITK_THREAD_RETURN_TYPE TractsToRgbaImageFilter< OutputImageType >::GenerateFiberColorsThread(void* pInfoStruct)
+  {
+    itk::MultiThreader::ThreadInfoStruct* pInfo = static_cast<itk::MultiThreader::ThreadInfoStruct*>(pInfoStruct);
+    Self* filter = static_cast<Self*>(pInfo->UserData);
+
+    int w = filter->m_ImageSize[0];
+    int h = filter->m_ImageSize[1];
+    int d = filter->m_ImageSize[2];
+    const double* spacing = filter->m_ImageSpacing;
+    float scale = 100 * pow((float)filter->m_UpsamplingFactor,3);
+    float* buffer = filter->m_ThreadBuffers[pInfo->ThreadID];
+    vtkPoints* fiberPoints = filter->m_ThreadFiberPolyData->GetPoints();
+    const vtkIdType* connectivity = filter->m_ThreadFiberPolyData->GetLines()->GetPointer();
+
+    int firstFiber, lastFiber;
+    FiberPointToIndexTransform::GetFiberRange((int)filter->m_FiberOffsets.size(), pInfo->ThreadID, pInfo->NumberOfThreads, firstFiber, lastFiber);
+
+    std::vector<double> vertices;
+    std::vector<double> contIndices;
+    for( int i=firstFiber; i<lastFiber; i++ )
+    {
+      vtkIdType numPoints = connectivity[filter->m_FiberOffsets[i]];
+      const vtkIdType* points = connectivity+filter->m_FiberOffsets[i]+1;
+      if (numPoints<2)
+        continue;
+
+      vertices.resize(3*numPoints);
+      for( int j=0; j<numPoints; j++)
+        fiberPoints->GetPoint(points[j], &vertices[3*j]);
+      contIndices.resize(3*numPoints);
+      filter->m_PointToIndex.TransformPoints(&vertices[0], numPoints, &contIndices[0]);
+
+      // fill output image
+      for( int j=0; j<numPoints; j++)
+      {
+        const double* contIndex = &contIndices[3*j];
+        int px = (int)floor(contIndex[0]);
+        int py = (int)floor(contIndex[1]);
+        int pz = (int)floor(contIndex[2]);
+
+        // int coordinates inside image?
+        if (px < 0 || px >= w-1)
+          continue;
+        if (py < 0 || py >= h-1)
+          continue;
+        if (pz < 0 || pz >= d-1)
+          continue;
+
+        float frac_x = contIndex[0] - px;
+        float frac_y = contIndex[1] - py;
+        float frac_z = contIndex[2] - pz;
+
+        // directions are used as weights, the last point gets the same as the previous one
+        int segment = j<numPoints-1 ? j : j-1;
+        const double* vertex = &vertices[3*segment];
+        const double* vertexPost = &vertices[3*segment+3];
+        float rgbweight[3];
+        rgbweight[0] = fabs((vertexPost[0] - vertex[0]) * spacing[0]);
+        rgbweight[1] = fabs((vertexPost[1] - vertex[1]) * spacing[1]);
+        rgbweight[2] = fabs((vertexPost[2] - vertex[2]) * spacing[2]);
+        float intweight = sqrt(rgbweight[0]*rgbweight[0]+rgbweight[1]*rgbweight[1]+rgbweight[2]*rgbweight[2]);
+
+        float weights[8];
+        weights[0] = (1-frac_x)*(1-frac_y)*(1-frac_z) * scale;
+        weights[1] = (1-frac_x)*(  frac_y)*(1-frac_z) * scale;
+        weights[2] = (1-frac_x)*(1-frac_y)*(  frac_z) * scale;
+        weights[3] = (1-frac_x)*(  frac_y)*(  frac_z) * scale;
+        weights[4] = (  frac_x)*(1-frac_y)*(1-frac_z) * scale;
+        weights[5] = (  frac_x)*(1-frac_y)*(  frac_z) * scale;
+        weights[6] = (  frac_x)*(  frac_y)*(1-frac_z) * scale;
+        weights[7] = (  frac_x)*(  frac_y)*(  frac_z) * scale;
+
+        int voxels[8];
+        voxels[0] = 4*( px   + w*(py  + h*pz  ));
+        voxels[1] = 4*( px   + w*(py+1+ h*pz  ));
+        voxels[2] = 4*( px   + w*(py  + h*pz+h));
+        voxels[3] = 4*( px   + w*(py+1+ h*pz+h));
+        voxels[4] = 4*( px+1 + w*(py  + h*pz  ));
+        voxels[5] = 4*( px+1 + w*(py  + h*pz+h));
+        voxels[6] = 4*( px+1 + w*(py+1+ h*pz  ));
+        voxels[7] = 4*( px+1 + w*(py+1+ h*pz+h));
+
+        // add to r-, g-, b- and a-channel in output image
+        for (int k=0; k<8; k++)
+        {
+          float* voxel = buffer+voxels[k];
+          voxel[0] += weights[k] * rgbweight[0];
+          voxel[1] += weights[k] * rgbweight[1];
+          voxel[2] += weights[k] * rgbweight[2];
+          voxel[3] += weights[k] * intweight;
+        }
+      }
+    }
+    return ITK_THREAD_RETURN_VALUE;
+  }
 }
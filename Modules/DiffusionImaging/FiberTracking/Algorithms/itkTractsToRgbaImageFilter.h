@@ -20,12 +20,19 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <itkImage.h>
 #include <itkVectorContainer.h>
 #include <itkRGBAPixel.h>
+#include <itkMultiThreader.h>
 #include <mitkFiberBundleX.h>
+#include "itkFiberPointToIndexTransform.h"
 
 namespace itk{
 
 /**
-* \brief Generates RGBA image from the input fibers where color values are set according to the local fiber directions.   */
+* \brief Generates RGBA image from the input fibers where color values are set according to the local fiber directions.
+*
+* The fibers are split into one contiguous range per thread. Every thread but the first accumulates into its own float
+* RGBA buffer, the buffers are added before normalization. Uses one additional float RGBA image per thread, the number
+* of threads is reduced so that these images together stay below ThreadBufferMemoryLimit.
+*/
 
 template< class OutputImageType >
 class TractsToRgbaImageFilter : public ImageSource< OutputImageType >
@@ -54,6 +61,9 @@ public:
   itkSetMacro( UseImageGeometry, bool)
   itkGetMacro( UseImageGeometry, bool)
 
+  /** Maximum size in bytes of the additional float RGBA buffers of the threads, default 1 GB **/
+  itkSetMacro( ThreadBufferMemoryLimit, std::size_t)
+  itkGetMacro( ThreadBufferMemoryLimit, std::size_t)
 
   void GenerateData();
 
@@ -61,6 +71,9 @@ protected:
 
   itk::Point<float, 3> GetItkPoint(double point[3]);
 
+  /** Accumulates the colors of the fibers of one thread into its buffer **/
+  static ITK_THREAD_RETURN_TYPE GenerateFiberColorsThread(void* pInfoStruct);
+
   TractsToRgbaImageFilter();
   virtual ~TractsToRgbaImageFilter();
 
@@ -68,6 +81,16 @@ protected:
   float                             m_UpsamplingFactor; ///< use higher resolution for ouput image
   bool                              m_UseImageGeometry; ///< output image is given other geometry than fiberbundle (input image geometry)
   typename InputImageType::Pointer  m_InputImage;
+  std::size_t                       m_ThreadBufferMemoryLimit; ///< maximum size in bytes of the additional buffers of the threads
+
+  // state shared by the threads of GenerateData()
+  vtkPolyData*                      m_ThreadFiberPolyData;
+  std::vector<vtkIdType>            m_FiberOffsets;     ///< position of each fiber in the connectivity array
+  FiberPointToIndexTransform        m_PointToIndex;
+  int                               m_ImageSize[3];
+  double                            m_ImageSpacing[3];
+  std::vector< float* >             m_ThreadBuffers;    ///< RGBA float buffer of each thread
+  std::vector< std::vector<float> > m_ThreadBufferStorage;
 };
 
 }
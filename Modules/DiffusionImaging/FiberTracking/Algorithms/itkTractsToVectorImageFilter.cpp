@@ -6,12 +6,12 @@
 #include <vtkCellData.h>
 
 // ITK
-#include <itkTimeProbe.h>
 #include <itkImageRegionIterator.h>
 
 // misc
 #define _USE_MATH_DEFINES
 #include <math.h>
+#include <algorithm>
 #include <boost/progress.hpp>
 
 
@@ -32,7 +32,8 @@ TractsToVectorImageFilter< PixelType >::TractsToVectorImageFilter():
     m_UseWorkingCopy(true),
     m_MaxNumDirections(3),
     m_UseTrilinearInterpolation(false),
-    m_Thres(0.5)
+    m_Thres(0.5),
+    m_ThreadFiberPolyData(NULL)
 {
     this->SetNumberOfRequiredOutputs(1);
 }
@@ -65,6 +66,118 @@ itk::Point<float, 3> TractsToVectorImageFilter< PixelType >::GetItkPoint(double
     return itkPoint;
 }
 
+template< class PixelType >
+void TractsToVectorImageFilter< PixelType >::AddDirection(int idx, const DirectionType& dir)
+{
+    DirectionContainerType::Pointer dirCont;
+    if (m_DirectionsContainer->IndexExists(idx))
+        dirCont = m_DirectionsContainer->GetElement(idx);
+    if (dirCont.IsNull())
+    {
+        dirCont = DirectionContainerType::New();
+        dirCont->InsertElement(0, dir);
+        m_DirectionsContainer->InsertElement(idx, dirCont);
+    }
+    else
+        dirCont->InsertElement(dirCont->Size(), dir);
+}
+
+template< class PixelType >
+ITK_THREAD_RETURN_TYPE TractsToVectorImageFilter< PixelType >::GenerateFiberDirectionsThread(void* pInfoStruct)
+{
+    itk::MultiThreader::ThreadInfoStruct* pInfo = static_cast<itk::MultiThreader::ThreadInfoStruct*>(pInfoStruct);
+    Self* filter = static_cast<Self*>(pInfo->UserData);
+
+    const int* size = filter->m_ImageSize;
+    const unsigned char* mask = filter->m_MaskImage->GetBufferPointer();
+    VoxelDirectionListType& directions = filter->m_ThreadDirections[pInfo->ThreadID];
+    vtkPoints* fiberPoints = filter->m_ThreadFiberPolyData->GetPoints();
+    const vtkIdType* connectivity = filter->m_ThreadFiberPolyData->GetLines()->GetPointer();
+
+    int firstFiber, lastFiber;
+    FiberPointToIndexTransform::GetFiberRange((int)filter->m_FiberOffsets.size(), pInfo->ThreadID, pInfo->NumberOfThreads, firstFiber, lastFiber);
+
+    std::vector<double> vertices;
+    std::vector<double> contIndices;
+    for( int i=firstFiber; i<lastFiber; i++ )
+    {
+        vtkIdType numPoints = connectivity[filter->m_FiberOffsets[i]];
+        const vtkIdType* points = connectivity+filter->m_FiberOffsets[i]+1;
+        if (numPoints<2)
+            continue;
+
+        vertices.resize(3*numPoints);
+        contIndices.resize(3*numPoints);
+        for( int j=0; j<numPoints; j++)
+            fiberPoints->GetPoint(points[j], &vertices[3*j]);
+        filter->m_PointToIndex.TransformPoints(&vertices[0], numPoints, &contIndices[0]);
+
+        for( int j=0; j<numPoints-1; j++)
+        {
+            const double* contIndex = &contIndices[3*j];
+
+            DirectionType dir;
+            for (int k=0; k<3; k++)
+                dir[k] = vertices[3*j+3+k]-vertices[3*j+k];
+            dir.normalize();
+
+            // nearest voxel, rounded like Image::TransformPhysicalPointToIndex()
+            int index[3];
+            for (int k=0; k<3; k++)
+                index[k] = (int)floor(contIndex[k]+0.5);
+
+            if (!filter->m_UseTrilinearInterpolation)
+            {
+                if (index[0] < 0 || index[0] >= size[0])
+                    continue;
+                if (index[1] < 0 || index[1] >= size[1])
+                    continue;
+                if (index[2] < 0 || index[2] >= size[2])
+                    continue;
+
+                int idx = index[0] + size[0]*(index[1] + size[1]*index[2]);
+                if (mask[idx]==0)
+                    continue;
+                directions.push_back(std::make_pair(idx, dir));
+                continue;
+            }
+
+            int corner[3];
+            float frac[3];
+            for (int k=0; k<3; k++)
+            {
+                corner[k] = (int)floor(contIndex[k]);
+                frac[k] = 1-(contIndex[k]-corner[k]);
+            }
+
+            // int coordinates inside image?
+            if (corner[0] < 0 || corner[0] >= size[0]-1)
+                continue;
+            if (corner[1] < 0 || corner[1] >= size[1]-1)
+                continue;
+            if (corner[2] < 0 || corner[2] >= size[2]-1)
+                continue;
+
+            // the nearest voxel is one of the corners and therefore inside the image
+            if (mask[index[0] + size[0]*(index[1] + size[1]*index[2])]==0)
+                continue;
+
+            for (int dx=0; dx<2; dx++)
+                for (int dz=0; dz<2; dz++)
+                    for (int dy=0; dy<2; dy++)
+                    {
+                        float weight = (dx ? 1-frac[0] : frac[0]) * (dy ? 1-frac[1] : frac[1]) * (dz ? 1-frac[2] : frac[2]);
+                        if (weight>filter->m_Thres)
+                        {
+                            int idx = corner[0]+dx + size[0]*(corner[1]+dy + size[1]*(corner[2]+dz));
+                            directions.push_back(std::make_pair(idx, dir*weight));
+                        }
+                    }
+        }
+    }
+    return ITK_THREAD_RETURN_VALUE;
+}
+
 template< class PixelType >
 void TractsToVectorImageFilter< PixelType >::GenerateData()
 {
@@ -146,10 +259,7 @@ void TractsToVectorImageFilter< PixelType >::GenerateData()
 
     // iterate over all fibers
     vtkSmartPointer<vtkPolyData> fiberPolyData = m_FiberBundle->GetFiberPolyData();
-    vtkSmartPointer<vtkCellArray> vLines = fiberPolyData->GetLines();
-    vLines->InitTraversal();
     int numFibers = m_FiberBundle->GetNumFibers();
-    itk::TimeProbe clock;
     m_DirectionsContainer = ContainerType::New();
 
     if (m_UseTrilinearInterpolation)
@@ -157,313 +267,32 @@ void TractsToVectorImageFilter< PixelType >::GenerateData()
     else
         MITK_INFO << "Generating directions from tractogram";
 
-    boost::progress_display disp(numFibers);
-    for( int i=0; i<numFibers; i++ )
-    {
-        ++disp;
-        clock.Start();
-        vtkIdType   numPoints(0);
-        vtkIdType*  points(NULL);
-        vLines->GetNextCell ( numPoints, points );
-        if (numPoints<2)
-            continue;
-
-        itk::Index<3> index; index.Fill(0);
-        itk::ContinuousIndex<float, 3> contIndex;
-        vnl_vector_fixed<double, 3> dir, wDir;
-        itk::Point<float, 3> worldPos;
-        vnl_vector<double> v;
-        for( int j=0; j<numPoints-1; j++)
-        {
-            double* temp = fiberPolyData->GetPoint(points[j]);
-            worldPos = GetItkPoint(temp);
-            v = GetVnlVector(temp);
-
-            dir = GetVnlVector(fiberPolyData->GetPoint(points[j+1]))-v;
-            dir.normalize();
-
-            m_MaskImage->TransformPhysicalPointToIndex(worldPos, index);
-            m_MaskImage->TransformPhysicalPointToContinuousIndex(worldPos, contIndex);
-
-            if (m_MaskImage->GetPixel(index)==0)
-                continue;
-
-            if (!m_UseTrilinearInterpolation)
-            {
-                if (index[0] < 0 || index[0] >= outImageSize[0])
-                    continue;
-                if (index[1] < 0 || index[1] >= outImageSize[1])
-                    continue;
-                if (index[2] < 0 || index[2] >= outImageSize[2])
-                    continue;
-
-                int idx = index[0] + outImageSize[0]*(index[1] + outImageSize[1]*index[2]);
-                DirectionContainerType::Pointer dirCont = DirectionContainerType::New();
-                if (m_DirectionsContainer->IndexExists(idx))
-                {
-                    dirCont = m_DirectionsContainer->GetElement(idx);
-                    if (dirCont.IsNull())
-                    {
-                        dirCont = DirectionContainerType::New();
-                        dirCont->InsertElement(0, dir);
-                        m_DirectionsContainer->InsertElement(idx, dirCont);
-                    }
-                    else
-                        dirCont->InsertElement(dirCont->Size(), dir);
-                }
-                else
-                {
-                    dirCont->InsertElement(0, dir);
-                    m_DirectionsContainer->InsertElement(idx, dirCont);
-                }
+    m_ThreadFiberPolyData = fiberPolyData;
+    FiberPointToIndexTransform::GetFiberOffsets(fiberPolyData->GetLines(), m_FiberOffsets);
+    m_PointToIndex.SetImage(m_MaskImage.GetPointer());
+    for (int i=0; i<3; i++)
+        m_ImageSize[i] = outImageSize[i];
 
-                continue;
-            }
+    int numThreads = std::max(1, std::min((int)this->GetNumberOfThreads(), numFibers));
+    m_ThreadDirections.clear();
+    m_ThreadDirections.resize(numThreads);
 
-            float frac_x = contIndex[0] - index[0];
-            float frac_y = contIndex[1] - index[1];
-            float frac_z = contIndex[2] - index[2];
-
-            if (frac_x<0)
-            {
-                index[0] -= 1;
-                frac_x += 1;
-            }
-            if (frac_y<0)
-            {
-                index[1] -= 1;
-                frac_y += 1;
-            }
-            if (frac_z<0)
-            {
-                index[2] -= 1;
-                frac_z += 1;
-            }
+    itk::MultiThreader::Pointer threader = itk::MultiThreader::New();
+    threader->SetNumberOfThreads(numThreads);
+    threader->SetSingleMethod(GenerateFiberDirectionsThread, this);
+    threader->SingleMethodExecute();
 
-            frac_x = 1-frac_x;
-            frac_y = 1-frac_y;
-            frac_z = 1-frac_z;
-
-            // int coordinates inside image?
-            if (index[0] < 0 || index[0] >= outImageSize[0]-1)
-                continue;
-            if (index[1] < 0 || index[1] >= outImageSize[1]-1)
-                continue;
-            if (index[2] < 0 || index[2] >= outImageSize[2]-1)
-                continue;
-
-            DirectionContainerType::Pointer dirCont;
-            int idx;
-            wDir = dir;
-            float weight = (  frac_x)*(  frac_y)*(  frac_z);
-            if (weight>m_Thres)
-            {
-                wDir *= weight;
-                idx = index[0]   + outImageSize[0]*(index[1]  + outImageSize[1]*index[2]  );
-                dirCont = DirectionContainerType::New();
-                if (m_DirectionsContainer->IndexExists(idx))
-                {
-                    dirCont = m_DirectionsContainer->GetElement(idx);
-                    if (dirCont.IsNull())
-                    {
-                        dirCont = DirectionContainerType::New();
-                        dirCont->InsertElement(0, wDir);
-                        m_DirectionsContainer->InsertElement(idx, dirCont);
-                    }
-                    else
-                        dirCont->InsertElement(dirCont->Size(), wDir);
-                }
-                else
-                {
-                    dirCont->InsertElement(0, wDir);
-                    m_DirectionsContainer->InsertElement(idx, dirCont);
-                }
-            }
-
-            wDir = dir;
-            weight = (  frac_x)*(1-frac_y)*(  frac_z);
-            if (weight>m_Thres)
-            {
-                wDir *= weight;
-                idx = index[0]   + outImageSize[0]*(index[1]+1+ outImageSize[1]*index[2]  );
-                dirCont = DirectionContainerType::New();
-                if (m_DirectionsContainer->IndexExists(idx))
-                {
-                    dirCont = m_DirectionsContainer->GetElement(idx);
-                    if (dirCont.IsNull())
-                    {
-                        dirCont = DirectionContainerType::New();
-                        dirCont->InsertElement(0, wDir);
-                        m_DirectionsContainer->InsertElement(idx, dirCont);
-                    }
-                    else
-                        dirCont->InsertElement(dirCont->Size(), wDir);
-                }
-                else
-                {
-                    dirCont->InsertElement(0, wDir);
-                    m_DirectionsContainer->InsertElement(idx, dirCont);
-                }
-            }
-
-            wDir = dir;
-            weight = (  frac_x)*(  frac_y)*(1-frac_z);
-            if (weight>m_Thres)
-            {
-                wDir *= weight;
-                idx = index[0]   + outImageSize[0]*(index[1]  + outImageSize[1]*index[2]+outImageSize[1]);
-                dirCont = DirectionContainerType::New();
-                if (m_DirectionsContainer->IndexExists(idx))
-                {
-                    dirCont = m_DirectionsContainer->GetElement(idx);
-                    if (dirCont.IsNull())
-                    {
-                        dirCont = DirectionContainerType::New();
-                        dirCont->InsertElement(0, wDir);
-                        m_DirectionsContainer->InsertElement(idx, dirCont);
-                    }
-                    else
-                        dirCont->InsertElement(dirCont->Size(), wDir);
-                }
-                else
-                {
-                    dirCont->InsertElement(0, wDir);
-                    m_DirectionsContainer->InsertElement(idx, dirCont);
-                }
-            }
-
-            wDir = dir;
-            weight = (  frac_x)*(1-frac_y)*(1-frac_z);
-            if (weight>m_Thres)
-            {
-                wDir *= weight;
-                idx = index[0]   + outImageSize[0]*(index[1]+1+ outImageSize[1]*index[2]+outImageSize[1]);
-                dirCont = DirectionContainerType::New();
-                if (m_DirectionsContainer->IndexExists(idx))
-                {
-                    dirCont = m_DirectionsContainer->GetElement(idx);
-                    if (dirCont.IsNull())
-                    {
-                        dirCont = DirectionContainerType::New();
-                        dirCont->InsertElement(0, wDir);
-                        m_DirectionsContainer->InsertElement(idx, dirCont);
-                    }
-                    else
-                        dirCont->InsertElement(dirCont->Size(), wDir);
-                }
-                else
-                {
-                    dirCont->InsertElement(0, wDir);
-                    m_DirectionsContainer->InsertElement(idx, dirCont);
-                }
-            }
-
-            wDir = dir;
-            weight = (1-frac_x)*(  frac_y)*(  frac_z);
-            if (weight>m_Thres)
-            {
-                wDir *= weight;
-                idx = index[0]+1 + outImageSize[0]*(index[1]  + outImageSize[1]*index[2]  );
-                dirCont = DirectionContainerType::New();
-                if (m_DirectionsContainer->IndexExists(idx))
-                {
-                    dirCont = m_DirectionsContainer->GetElement(idx);
-                    if (dirCont.IsNull())
-                    {
-                        dirCont = DirectionContainerType::New();
-                        dirCont->InsertElement(0, wDir);
-                        m_DirectionsContainer->InsertElement(idx, dirCont);
-                    }
-                    else
-                        dirCont->InsertElement(dirCont->Size(), wDir);
-                }
-                else
-                {
-                    dirCont->InsertElement(0, wDir);
-                    m_DirectionsContainer->InsertElement(idx, dirCont);
-                }
-            }
-
-            wDir = dir;
-            weight = (1-frac_x)*(  frac_y)*(1-frac_z);
-            if (weight>m_Thres)
-            {
-                wDir *= weight;
-                idx = index[0]+1 + outImageSize[0]*(index[1]  + outImageSize[1]*index[2]+outImageSize[1]);
-                dirCont = DirectionContainerType::New();
-                if (m_DirectionsContainer->IndexExists(idx))
-                {
-                    dirCont = m_DirectionsContainer->GetElement(idx);
-                    if (dirCont.IsNull())
-                    {
-                        dirCont = DirectionContainerType::New();
-                        dirCont->InsertElement(0, wDir);
-                        m_DirectionsContainer->InsertElement(idx, dirCont);
-                    }
-                    else
-                        dirCont->InsertElement(dirCont->Size(), wDir);
-                }
-                else
-                {
-                    dirCont->InsertElement(0, wDir);
-                    m_DirectionsContainer->InsertElement(idx, dirCont);
-                }
-            }
-
-            wDir = dir;
-            weight = (1-frac_x)*(1-frac_y)*(  frac_z);
-            if (weight>m_Thres)
-            {
-                wDir *= weight;
-                idx = index[0]+1 + outImageSize[0]*(index[1]+1+ outImageSize[1]*index[2]  );
-                dirCont = DirectionContainerType::New();
-                if (m_DirectionsContainer->IndexExists(idx))
-                {
-                    dirCont = m_DirectionsContainer->GetElement(idx);
-                    if (dirCont.IsNull())
-                    {
-                        dirCont = DirectionContainerType::New();
-                        dirCont->InsertElement(0, wDir);
-                        m_DirectionsContainer->InsertElement(idx, dirCont);
-                    }
-                    else
-                        dirCont->InsertElement(dirCont->Size(), wDir);
-                }
-                else
-                {
-                    dirCont->InsertElement(0, wDir);
-                    m_DirectionsContainer->InsertElement(idx, dirCont);
-                }
-            }
-
-            wDir = dir;
-            weight = (1-frac_x)*(1-frac_y)*(1-frac_z);
-            if (weight>m_Thres)
-            {
-                wDir *= weight;
-                idx = index[0]+1 + outImageSize[0]*(index[1]+1+ outImageSize[1]*index[2]+outImageSize[1]);
-                dirCont = DirectionContainerType::New();
-                if (m_DirectionsContainer->IndexExists(idx))
-                {
-                    dirCont = m_DirectionsContainer->GetElement(idx);
-                    if (dirCont.IsNull())
-                    {
-                        dirCont = DirectionContainerType::New();
-                        dirCont->InsertElement(0, wDir);
-                        m_DirectionsContainer->InsertElement(idx, dirCont);
-                    }
-                    else
-                        dirCont->InsertElement(dirCont->Size(), wDir);
-                }
-                else
-                {
-                    dirCont->InsertElement(0, wDir);
-                    m_DirectionsContainer->InsertElement(idx, dirCont);
-                }
-            }
-        }
-        clock.Stop();
+    // the thread ranges are consecutive, so merging in thread order keeps the fiber order
+    for (int t=0; t<numThreads; t++)
+    {
+        const VoxelDirectionListType& directions = m_ThreadDirections[t];
+        for (unsigned int i=0; i<directions.size(); i++)
+            AddDirection(directions[i].first, directions[i].second);
+        m_ThreadDirections[t].clear();
     }
+    m_ThreadDirections.clear();
+    m_FiberOffsets.clear();
+    m_ThreadFiberPolyData = NULL;
 
     vtkSmartPointer<vtkCellArray> m_VtkCellArray = vtkSmartPointer<vtkCellArray>::New();
     vtkSmartPointer<vtkPoints>    m_VtkPoints = vtkSmartPointer<vtkPoints>::New();
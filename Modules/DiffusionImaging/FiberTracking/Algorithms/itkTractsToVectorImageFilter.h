@@ -7,6 +7,8 @@
 // ITK
 #include <itkImageSource.h>
 #include <itkVectorImage.h>
+#include <itkMultiThreader.h>
+#include "itkFiberPointToIndexTransform.h"
 
 // VTK
 #include <vtkSmartPointer.h>
@@ -20,7 +22,11 @@ using namespace mitk;
 namespace itk{
 
 /**
-* \brief Extracts the voxel-wise main directions of the input fiber bundle.   */
+* \brief Extracts the voxel-wise main directions of the input fiber bundle.
+*
+* The fiber directions are collected by several threads, each one handling a contiguous range of fibers. They are
+* merged in fiber order, so the directions of each voxel are in the same order as with a single thread.
+*/
 
 template< class PixelType >
 class TractsToVectorImageFilter : public ImageSource< VectorImage< float, 3 > >
@@ -75,6 +81,10 @@ protected:
     vnl_vector_fixed<double, 3> GetVnlVector(double point[3]);
     itk::Point<float, 3> GetItkPoint(double point[3]);
 
+    /** Collects the voxel directions of the fibers of one thread **/
+    static ITK_THREAD_RETURN_TYPE GenerateFiberDirectionsThread(void* pInfoStruct);
+    void AddDirection(int idx, const DirectionType& dir);  ///< appends dir to the directions of voxel idx
+
 
     TractsToVectorImageFilter();
     virtual ~TractsToVectorImageFilter();
@@ -97,6 +107,14 @@ protected:
     ItkUcharImgType::Pointer                m_CrossingsImage;               ///< shows voxels containing more than one fiber
     DirectionImageContainerType::Pointer    m_DirectionImageContainer;      ///< contains images that contain the output directions
     FiberBundleX::Pointer                   m_OutputFiberBundle;            ///< vector field for visualization purposes
+
+    // state shared by the threads of GenerateData()
+    typedef std::vector< std::pair< int, DirectionType > > VoxelDirectionListType;
+    vtkPolyData*                            m_ThreadFiberPolyData;
+    std::vector<vtkIdType>                  m_FiberOffsets;                 ///< position of each fiber in the connectivity array
+    FiberPointToIndexTransform              m_PointToIndex;
+    int                                     m_ImageSize[3];
+    std::vector< VoxelDirectionListType >   m_ThreadDirections;             ///< voxel index and direction found by each thread
 };
 
 }
@@ -0,0 +1,378 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkFiberBitmap.h"
+
+#include <algorithm>
+#include <iterator>
+
+mitk::FiberBitmap::FiberBitmap()
+{
+}
+
+mitk::FiberBitmap mitk::FiberBitmap::Fill(unsigned int size)
+{
+    FiberBitmap bitmap;
+    if (size==0)
+        return bitmap;
+
+    for (unsigned int key=0; key<=(size-1)/ChunkSize; key++)
+    {
+        unsigned int count = size-key*ChunkSize;
+        if (count>ChunkSize)
+            count = ChunkSize;
+
+        std::vector<WordType> bits(WordsPerChunk, 0);
+        for (unsigned int w=0; w<count/64; w++)
+            bits[w] = ~WordType(0);
+        if (count%64)
+            bits[count/64] = (WordType(1) << (count%64)) - 1;
+
+        Chunk chunk;
+        chunk.m_Key = key;
+        FromBits(chunk, bits);
+        bitmap.m_Chunks.push_back(chunk);
+    }
+    return bitmap;
+}
+
+void mitk::FiberBitmap::Add(unsigned int id)
+{
+    unsigned int key = id >> 16;
+    unsigned short value = id & 0xFFFF;
+
+    std::vector<Chunk>::iterator it = m_Chunks.end();
+    if (m_Chunks.empty() || m_Chunks.back().m_Key<key)
+    {
+        Chunk chunk;
+        chunk.m_Key = key;
+        chunk.m_Count = 0;
+        it = m_Chunks.insert(m_Chunks.end(), chunk);
+    }
+    else if (m_Chunks.back().m_Key==key)
+    {
+        it = m_Chunks.end()-1;
+    }
+    else
+    {
+        for (it = m_Chunks.begin(); it!=m_Chunks.end() && it->m_Key<key; ++it) {}
+        if (it==m_Chunks.end() || it->m_Key!=key)
+        {
+            Chunk chunk;
+            chunk.m_Key = key;
+            chunk.m_Count = 0;
+            it = m_Chunks.insert(it, chunk);
+        }
+    }
+
+    Chunk& chunk = *it;
+    if (!chunk.m_Bits.empty())
+    {
+        WordType mask = WordType(1) << (value%64);
+        if (!(chunk.m_Bits[value/64] & mask))
+        {
+            chunk.m_Bits[value/64] |= mask;
+            chunk.m_Count++;
+        }
+        return;
+    }
+
+    if (chunk.m_Array.empty() || chunk.m_Array.back()<value)
+        chunk.m_Array.push_back(value);
+    else
+    {
+        std::vector<unsigned short>::iterator pos = std::lower_bound(chunk.m_Array.begin(), chunk.m_Array.end(), value);
+        if (*pos==value)
+            return;
+        chunk.m_Array.insert(pos, value);
+    }
+    chunk.m_Count++;
+
+    if (chunk.m_Count>MaxArraySize)
+    {
+        std::vector<WordType> bits;
+        ToBits(chunk, bits);
+        FromBits(chunk, bits);
+    }
+}
+
+bool mitk::FiberBitmap::Contains(unsigned int id) const
+{
+    unsigned int key = id >> 16;
+    for (std::vector<Chunk>::const_iterator it = m_Chunks.begin(); it!=m_Chunks.end() && it->m_Key<=key; ++it)
+        if (it->m_Key==key)
+            return ChunkContains(*it, id & 0xFFFF);
+    return false;
+}
+
+void mitk::FiberBitmap::Clear()
+{
+    m_Chunks.clear();
+}
+
+bool mitk::FiberBitmap::IsEmpty() const
+{
+    return m_Chunks.empty();
+}
+
+unsigned int mitk::FiberBitmap::GetCount() const
+{
+    unsigned int count = 0;
+    for (unsigned int i=0; i<m_Chunks.size(); i++)
+        count += m_Chunks[i].m_Count;
+    return count;
+}
+
+void mitk::FiberBitmap::GetIds(std::vector<long>& ids) const
+{
+    ids.reserve(ids.size()+GetCount());
+    for (unsigned int i=0; i<m_Chunks.size(); i++)
+    {
+        const Chunk& chunk = m_Chunks[i];
+        long base = long(chunk.m_Key)*ChunkSize;
+        if (chunk.m_Bits.empty())
+        {
+            for (unsigned int j=0; j<chunk.m_Array.size(); j++)
+                ids.push_back(base+chunk.m_Array[j]);
+            continue;
+        }
+        for (unsigned int w=0; w<WordsPerChunk; w++)
+        {
+            WordType word = chunk.m_Bits[w];
+            for (unsigned int b=0; word!=0; b++, word >>= 1)
+                if (word & 1)
+                    ids.push_back(base+w*64+b);
+        }
+    }
+}
+
+void mitk::FiberBitmap::And(const FiberBitmap& other)
+{
+    std::vector<Chunk> result;
+    std::vector<Chunk>::const_iterator a = m_Chunks.begin();
+    std::vector<Chunk>::const_iterator b = other.m_Chunks.begin();
+    while (a!=m_Chunks.end() && b!=other.m_Chunks.end())
+    {
+        if (a->m_Key<b->m_Key)
+            ++a;
+        else if (b->m_Key<a->m_Key)
+            ++b;
+        else
+        {
+            Chunk chunk;
+            AndChunks(*a, *b, chunk);
+            if (chunk.m_Count>0)
+                result.push_back(chunk);
+            ++a; ++b;
+        }
+    }
+    m_Chunks.swap(result);
+}
+
+void mitk::FiberBitmap::Or(const FiberBitmap& other)
+{
+    std::vector<Chunk> result;
+    std::vector<Chunk>::const_iterator a = m_Chunks.begin();
+    std::vector<Chunk>::const_iterator b = other.m_Chunks.begin();
+    while (a!=m_Chunks.end() || b!=other.m_Chunks.end())
+    {
+        if (b==other.m_Chunks.end() || (a!=m_Chunks.end() && a->m_Key<b->m_Key))
+            result.push_back(*a++);
+        else if (a==m_Chunks.end() || b->m_Key<a->m_Key)
+            result.push_back(*b++);
+        else
+        {
+            Chunk chunk;
+            OrChunks(*a, *b, chunk);
+            result.push_back(chunk);
+            ++a; ++b;
+        }
+    }
+    m_Chunks.swap(result);
+}
+
+void mitk::FiberBitmap::AndNot(const FiberBitmap& other)
+{
+    std::vector<Chunk> result;
+    std::vector<Chunk>::const_iterator b = other.m_Chunks.begin();
+    for (std::vector<Chunk>::const_iterator a = m_Chunks.begin(); a!=m_Chunks.end(); ++a)
+    {
+        while (b!=other.m_Chunks.end() && b->m_Key<a->m_Key)
+            ++b;
+        if (b==other.m_Chunks.end() || b->m_Key!=a->m_Key)
+        {
+            result.push_back(*a);
+            continue;
+        }
+        Chunk chunk;
+        AndNotChunks(*a, *b, chunk);
+        if (chunk.m_Count>0)
+            result.push_back(chunk);
+    }
+    m_Chunks.swap(result);
+}
+
+bool mitk::FiberBitmap::operator==(const FiberBitmap& other) const
+{
+    if (m_Chunks.size()!=other.m_Chunks.size())
+        return false;
+    // the representation of a chunk only depends on its number of ids
+    for (unsigned int i=0; i<m_Chunks.size(); i++)
+    {
+        const Chunk& a = m_Chunks[i];
+        const Chunk& b = other.m_Chunks[i];
+        if (a.m_Key!=b.m_Key || a.m_Count!=b.m_Count || a.m_Array!=b.m_Array || a.m_Bits!=b.m_Bits)
+            return false;
+    }
+    return true;
+}
+
+bool mitk::FiberBitmap::ChunkContains(const Chunk& chunk, unsigned short value)
+{
+    if (!chunk.m_Bits.empty())
+        return (chunk.m_Bits[value/64] >> (value%64)) & 1;
+    return std::binary_search(chunk.m_Array.begin(), chunk.m_Array.end(), value);
+}
+
+void mitk::FiberBitmap::ToBits(const Chunk& chunk, std::vector<WordType>& bits)
+{
+    if (!chunk.m_Bits.empty())
+    {
+        bits = chunk.m_Bits;
+        return;
+    }
+    bits.assign(WordsPerChunk, 0);
+    for (unsigned int i=0; i<chunk.m_Array.size(); i++)
+        bits[chunk.m_Array[i]/64] |= WordType(1) << (chunk.m_Array[i]%64);
+}
+
+void mitk::FiberBitmap::FromBits(Chunk& chunk, std::vector<WordType>& bits)
+{
+    chunk.m_Count = CountBits(bits);
+    chunk.m_Array.clear();
+    chunk.m_Bits.clear();
+    if (chunk.m_Count>MaxArraySize)
+    {
+        chunk.m_Bits.swap(bits);
+        return;
+    }
+
+    chunk.m_Array.reserve(chunk.m_Count);
+    for (unsigned int w=0; w<WordsPerChunk; w++)
+    {
+        WordType word = bits[w];
+        for (unsigned int b=0; word!=0; b++, word >>= 1)
+            if (word & 1)
+                chunk.m_Array.push_back(w*64+b);
+    }
+}
+
+unsigned int mitk::FiberBitmap::CountBits(const std::vector<WordType>& bits)
+{
+    unsigned int count = 0;
+    for (unsigned int w=0; w<bits.size(); w++)
+    {
+        // parallel bit count
+        WordType x = bits[w];
+        x = x - ((x >> 1) & 0x5555555555555555ULL);
+        x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+        x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+        count += (unsigned int)((x * 0x0101010101010101ULL) >> 56);
+    }
+    return count;
+}
+
+void mitk::FiberBitmap::AndChunks(const Chunk& a, const Chunk& b, Chunk& result)
+{
+    result.m_Key = a.m_Key;
+    if (a.m_Bits.empty() && b.m_Bits.empty())
+    {
+        std::set_intersection(a.m_Array.begin(), a.m_Array.end(), b.m_Array.begin(), b.m_Array.end(), std::back_inserter(result.m_Array));
+        result.m_Count = result.m_Array.size();
+    }
+    else if (a.m_Bits.empty() || b.m_Bits.empty())
+    {
+        const Chunk& array = a.m_Bits.empty() ? a : b;
+        const Chunk& bitset = a.m_Bits.empty() ? b : a;
+        for (unsigned int i=0; i<array.m_Array.size(); i++)
+            if (ChunkContains(bitset, array.m_Array[i]))
+                result.m_Array.push_back(array.m_Array[i]);
+        result.m_Count = result.m_Array.size();
+    }
+    else
+    {
+        std::vector<WordType> bits(a.m_Bits);
+        for (unsigned int w=0; w<WordsPerChunk; w++)
+            bits[w] &= b.m_Bits[w];
+        FromBits(result, bits);
+    }
+}
+
+void mitk::FiberBitmap::OrChunks(const Chunk& a, const Chunk& b, Chunk& result)
+{
+    result.m_Key = a.m_Key;
+    if (a.m_Bits.empty() && b.m_Bits.empty() && a.m_Count+b.m_Count<=MaxArraySize)
+    {
+        std::set_union(a.m_Array.begin(), a.m_Array.end(), b.m_Array.begin(), b.m_Array.end(), std::back_inserter(result.m_Array));
+        result.m_Count = result.m_Array.size();
+        return;
+    }
+
+    std::vector<WordType> bits;
+    ToBits(a, bits);
+    if (b.m_Bits.empty())
+    {
+        for (unsigned int i=0; i<b.m_Array.size(); i++)
+            bits[b.m_Array[i]/64] |= WordType(1) << (b.m_Array[i]%64);
+    }
+    else
+    {
+        for (unsigned int w=0; w<WordsPerChunk; w++)
+            bits[w] |= b.m_Bits[w];
+    }
+    FromBits(result, bits);
+}
+
+void mitk::FiberBitmap::AndNotChunks(const Chunk& a, const Chunk& b, Chunk& result)
+{
+    result.m_Key = a.m_Key;
+    if (a.m_Bits.empty())
+    {
+        if (b.m_Bits.empty())
+            std::set_difference(a.m_Array.begin(), a.m_Array.end(), b.m_Array.begin(), b.m_Array.end(), std::back_inserter(result.m_Array));
+        else
+        {
+            for (unsigned int i=0; i<a.m_Array.size(); i++)
+                if (!ChunkContains(b, a.m_Array[i]))
+                    result.m_Array.push_back(a.m_Array[i]);
+        }
+        result.m_Count = result.m_Array.size();
+        return;
+    }
+
+    std::vector<WordType> bits(a.m_Bits);
+    if (b.m_Bits.empty())
+    {
+        for (unsigned int i=0; i<b.m_Array.size(); i++)
+            bits[b.m_Array[i]/64] &= ~(WordType(1) << (b.m_Array[i]%64));
+    }
+    else
+    {
+        for (unsigned int w=0; w<WordsPerChunk; w++)
+            bits[w] &= ~b.m_Bits[w];
+    }
+    FromBits(result, bits);
+}
@@ -0,0 +1,95 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#ifndef _MITK_FiberBitmap_H
+#define _MITK_FiberBitmap_H
+
+#include "FiberTrackingExports.h"
+#include <itkIntTypes.h>
+
+#include <vector>
+
+namespace mitk {
+
+/**
+  * \brief Compressed set of fiber ids.
+  *
+  * The ids are split into chunks of 65536. A chunk with few ids stores them as a sorted array of 16 bit
+  * values, a chunk with more than 4096 ids as a bitset of 8 kB. Both are never larger than the bitset,
+  * sparse ROI results of whole brain tractograms need only a few bytes per selected fiber.
+  * And(), Or() and AndNot() work chunk by chunk, bitsets are combined word by word.
+  */
+class FiberTracking_EXPORT FiberBitmap
+{
+public:
+
+    FiberBitmap();
+
+    /** \brief Returns a bitmap containing all ids from 0 to size-1. */
+    static FiberBitmap Fill(unsigned int size);
+
+    /** \brief Inserts id. Fastest if the ids are added in increasing order. */
+    void Add(unsigned int id);
+    bool Contains(unsigned int id) const;
+    void Clear();
+
+    bool IsEmpty() const;
+    unsigned int GetCount() const;
+
+    /** \brief Appends all ids in increasing order. */
+    void GetIds(std::vector<long>& ids) const;
+
+    /** \brief Keeps only the ids contained in both bitmaps. */
+    void And(const FiberBitmap& other);
+    /** \brief Adds all ids of other. */
+    void Or(const FiberBitmap& other);
+    /** \brief Removes all ids of other. */
+    void AndNot(const FiberBitmap& other);
+
+    bool operator==(const FiberBitmap& other) const;
+    bool operator!=(const FiberBitmap& other) const { return !(*this == other); }
+
+private:
+
+    typedef itk::uint64_t WordType;
+
+    static const unsigned int ChunkSize = 65536;
+    static const unsigned int WordsPerChunk = ChunkSize / 64;
+    static const unsigned int MaxArraySize = 4096;
+
+    struct Chunk
+    {
+        unsigned int m_Key;                     ///< id >> 16 of all ids in the chunk
+        unsigned int m_Count;
+        std::vector<unsigned short> m_Array;    ///< sorted ids & 0xFFFF, used if m_Bits is empty
+        std::vector<WordType> m_Bits;           ///< bitset of WordsPerChunk words, used if m_Count > MaxArraySize
+    };
+
+    static bool ChunkContains(const Chunk& chunk, unsigned short value);
+    static void ToBits(const Chunk& chunk, std::vector<WordType>& bits);
+    static void FromBits(Chunk& chunk, std::vector<WordType>& bits); ///< takes the words, picks the smaller representation
+    static unsigned int CountBits(const std::vector<WordType>& bits);
+
+    static void AndChunks(const Chunk& a, const Chunk& b, Chunk& result);
+    static void OrChunks(const Chunk& a, const Chunk& b, Chunk& result);
+    static void AndNotChunks(const Chunk& a, const Chunk& b, Chunk& result);
+
+    std::vector<Chunk> m_Chunks; ///< non-empty chunks sorted by key
+};
+
+} // namespace mitk
+
+#endif /*  _MITK_FiberBitmap_H */
@@ -36,7 +36,10 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <vtkParametricFunctionSource.h>
 #include <vtkParametricSpline.h>
 #include <vtkPolygon.h>
-#include <vtkCleanPolyData.h>
+#include <vtkFloatArray.h>
+#include <itkMultiThreader.h>
+#include <itkNumericTraits.h>
+#include <itkImageRegionConstIteratorWithIndex.h>
 #include <cmath>
 #include <boost/progress.hpp>
 
@@ -48,6 +51,464 @@ const char* mitk::FiberBundleX::FIBER_ID_ARRAY = "Fiber_IDs";
 
 using namespace std;
 
+namespace
+{
+
+// exact test of points on the plane of a PlanarCircle or a PlanarPolygon
+class RoiShape
+{
+public:
+
+    bool Initialize(mitk::PlanarFigure* pf, const mitk::Vector3D& planeNormal)
+    {
+        if (dynamic_cast<mitk::PlanarCircle*>(pf)!=NULL && pf->GetNumberOfControlPoints()>=2)
+        {
+            m_IsCircle = true;
+            m_Center = pf->GetWorldControlPoint(0); //centerPoint
+            m_Radius = m_Center.EuclideanDistanceTo(pf->GetWorldControlPoint(1)); //radiusPoint
+
+            // extent of the circle along each axis
+            for (int i=0; i<3; i++)
+            {
+                double extent = m_Radius*std::sqrt(std::max(0.0, 1.0-planeNormal[i]*planeNormal[i]));
+                m_Bounds[2*i] = m_Center[i]-extent;
+                m_Bounds[2*i+1] = m_Center[i]+extent;
+            }
+            return true;
+        }
+
+        if (dynamic_cast<mitk::PlanarPolygon*>(pf)!=NULL && pf->GetNumberOfControlPoints()>=3)
+        {
+            m_IsCircle = false;
+            m_PolygonPoints.clear();
+            for (unsigned int i=0; i<pf->GetNumberOfControlPoints(); i++)
+            {
+                mitk::Point3D p = pf->GetWorldControlPoint(i);
+                m_PolygonPoints.push_back(p[0]);
+                m_PolygonPoints.push_back(p[1]);
+                m_PolygonPoints.push_back(p[2]);
+            }
+            int numPoints = m_PolygonPoints.size()/3;
+            vtkPolygon::ComputeNormal(numPoints, &m_PolygonPoints[0], m_PolygonNormal);
+
+            for (int i=0; i<3; i++)
+            {
+                m_Bounds[2*i] = m_PolygonPoints[i];
+                m_Bounds[2*i+1] = m_PolygonPoints[i];
+            }
+            for (int j=1; j<numPoints; j++)
+                for (int i=0; i<3; i++)
+                {
+                    m_Bounds[2*i] = std::min(m_Bounds[2*i], m_PolygonPoints[3*j+i]);
+                    m_Bounds[2*i+1] = std::max(m_Bounds[2*i+1], m_PolygonPoints[3*j+i]);
+                }
+            return true;
+        }
+
+        return false;
+    }
+
+    void GetBounds(double tolerance, double bounds[6]) const
+    {
+        for (int i=0; i<3; i++)
+        {
+            bounds[2*i] = m_Bounds[2*i]-tolerance;
+            bounds[2*i+1] = m_Bounds[2*i+1]+tolerance;
+        }
+    }
+
+    bool IsInside(double x[3])
+    {
+        if (m_IsCircle)
+        {
+            double dist = std::sqrt((x[0]-m_Center[0])*(x[0]-m_Center[0]) + (x[1]-m_Center[1])*(x[1]-m_Center[1]) + (x[2]-m_Center[2])*(x[2]-m_Center[2]));
+            return dist <= m_Radius;
+        }
+        return vtkPolygon::PointInPolygon(x, m_PolygonPoints.size()/3, &m_PolygonPoints[0], m_Bounds, m_PolygonNormal)==1;
+    }
+
+private:
+
+    bool                    m_IsCircle;
+    mitk::Point3D           m_Center;
+    double                  m_Radius;
+    std::vector<double>     m_PolygonPoints;
+    double                  m_PolygonNormal[3];
+    double                  m_Bounds[6];
+};
+
+bool IsInsideMask(mitk::FiberBundleX::ItkUcharImgType* mask, const double p[3])
+{
+    itk::Point<float, 3> itkP;
+    itkP[0] = p[0]; itkP[1] = p[1]; itkP[2] = p[2];
+    itk::Index<3> idx;
+    return mask->TransformPhysicalPointToIndex(itkP, idx) && mask->GetPixel(idx)>0;
+}
+
+// physical bounding box of all mask voxels, false if the mask is empty
+bool GetMaskBounds(mitk::FiberBundleX::ItkUcharImgType* mask, double bounds[6])
+{
+    typedef mitk::FiberBundleX::ItkUcharImgType ImageType;
+    ImageType::IndexType min, max;
+    bool found = false;
+
+    itk::ImageRegionConstIteratorWithIndex<ImageType> it(mask, mask->GetLargestPossibleRegion());
+    for (it.GoToBegin(); !it.IsAtEnd(); ++it)
+    {
+        if (it.Get()<=0)
+            continue;
+        ImageType::IndexType idx = it.GetIndex();
+        if (!found)
+        {
+            min = idx;
+            max = idx;
+            found = true;
+        }
+        for (int i=0; i<3; i++)
+        {
+            min[i] = std::min(min[i], idx[i]);
+            max[i] = std::max(max[i], idx[i]);
+        }
+    }
+    if (!found)
+        return false;
+
+    for (int corner=0; corner<8; corner++)
+    {
+        itk::ContinuousIndex<double, 3> cIdx;
+        for (int i=0; i<3; i++)
+            cIdx[i] = (corner>>i)&1 ? max[i]+0.5 : min[i]-0.5;
+        itk::Point<double, 3> p;
+        mask->TransformContinuousIndexToPhysicalPoint(cIdx, p);
+        for (int i=0; i<3; i++)
+        {
+            if (corner==0 || p[i]<bounds[2*i])
+                bounds[2*i] = p[i];
+            if (corner==0 || p[i]>bounds[2*i+1])
+                bounds[2*i+1] = p[i];
+        }
+    }
+    return true;
+}
+
+// the processors work on the fibers of one thread each and write to m_Parts[threadId], concatenated afterwards
+class FiberPartsProcessor : public mitk::FiberColumnStore::FiberProcessor
+{
+public:
+
+    FiberPartsProcessor(unsigned int numThreads) : m_Parts(numThreads)
+    {
+        // the parts are copies of one store and share its point array, which the threads must not release concurrently
+        for (unsigned int i=0; i<numThreads; i++)
+            m_Parts[i].Clear();
+    }
+
+    std::vector< mitk::FiberColumnStore > m_Parts;
+};
+
+// p' = matrix*(p-center) + center + translation
+class TransformProcessor : public FiberPartsProcessor
+{
+public:
+
+    TransformProcessor(unsigned int numThreads, const vnl_matrix_fixed< double, 3, 3 >& matrix, const mitk::Point3D& center, const mitk::Vector3D& translation)
+        : FiberPartsProcessor(numThreads)
+        , m_Matrix(matrix)
+        , m_Center(center)
+        , m_Translation(translation)
+    {}
+
+    void ProcessFibers(const mitk::FiberColumnStore& fibers, unsigned int firstFiber, unsigned int lastFiber, unsigned int threadId)
+    {
+        std::vector<double> newPoints;
+        for (unsigned int i=firstFiber; i<lastFiber; i++)
+        {
+            const float* points = fibers.GetPoints(i);
+            unsigned int numPoints = fibers.GetNumberOfPoints(i);
+            newPoints.resize(3*numPoints);
+            for (unsigned int j=0; j<numPoints; j++)
+            {
+                vnl_vector_fixed< double, 3 > p;
+                for (int k=0; k<3; k++)
+                    p[k] = points[3*j+k]-m_Center[k];
+                p = m_Matrix*p;
+                for (int k=0; k<3; k++)
+                    newPoints[3*j+k] = p[k]+m_Center[k]+m_Translation[k];
+            }
+            m_Parts[threadId].AddFiber(&newPoints[0], numPoints);
+        }
+    }
+
+private:
+
+    vnl_matrix_fixed< double, 3, 3 >    m_Matrix;
+    mitk::Point3D                       m_Center;
+    mitk::Vector3D                      m_Translation;
+};
+
+// equidistant points along each fiber
+class ResampleProcessor : public FiberPartsProcessor
+{
+public:
+
+    ResampleProcessor(unsigned int numThreads, float pointDistance) : FiberPartsProcessor(numThreads), m_PointDistance(pointDistance) {}
+
+    void ProcessFibers(const mitk::FiberColumnStore& fibers, unsigned int firstFiber, unsigned int lastFiber, unsigned int threadId)
+    {
+        std::vector<float> newPoints;
+        for (unsigned int i=firstFiber; i<lastFiber; i++)
+        {
+            const float* points = fibers.GetPoints(i);
+            int numPoints = fibers.GetNumberOfPoints(i);
+            newPoints.assign(points, points+3);
+
+            float dtau = 0;
+            int cur_p = 1;
+            itk::Vector<float,3> dR;
+            float normdR = 0;
+
+            for (;;)
+            {
+                while (dtau <= m_PointDistance && cur_p < numPoints)
+                {
+                    itk::Vector<float,3> v1(points+3*(cur_p-1));
+                    itk::Vector<float,3> v2(points+3*cur_p);
+
+                    dR  = v2 - v1;
+                    normdR = std::sqrt(dR.GetSquaredNorm());
+                    dtau += normdR;
+                    cur_p++;
+                }
+
+                if (dtau >= m_PointDistance)
+                {
+                    itk::Vector<float,3> v1(points+3*(cur_p-1));
+                    itk::Vector<float,3> v2 = v1 - dR*( (dtau-m_PointDistance)/normdR );
+                    newPoints.insert(newPoints.end(), v2.GetDataPointer(), v2.GetDataPointer()+3);
+                }
+                else
+                {
+                    newPoints.insert(newPoints.end(), points+3*(numPoints-1), points+3*numPoints);
+                    break;
+                }
+                dtau = dtau-m_PointDistance;
+            }
+
+            m_Parts[threadId].AddFiber(&newPoints[0], newPoints.size()/3);
+        }
+    }
+
+private:
+
+    float m_PointDistance;
+};
+
+// keeps the fibers with a length between m_MinLength and m_MaxLength
+class LengthProcessor : public FiberPartsProcessor
+{
+public:
+
+    LengthProcessor(unsigned int numThreads, const std::vector< float >& lengths, float minLength, float maxLength)
+        : FiberPartsProcessor(numThreads)
+        , m_Lengths(lengths)
+        , m_MinLength(minLength)
+        , m_MaxLength(maxLength)
+    {}
+
+    void ProcessFibers(const mitk::FiberColumnStore& fibers, unsigned int firstFiber, unsigned int lastFiber, unsigned int threadId)
+    {
+        for (unsigned int i=firstFiber; i<lastFiber; i++)
+            if (m_Lengths.at(i)>=m_MinLength && m_Lengths.at(i)<=m_MaxLength)
+                m_Parts[threadId].AddFiber(fibers.GetPoints(i), fibers.GetNumberOfPoints(i));
+    }
+
+private:
+
+    const std::vector< float >& m_Lengths;
+    float                       m_MinLength;
+    float                       m_MaxLength;
+};
+
+// splits or removes fibers at points with a curvature radius below m_MinRadius
+class CurvatureProcessor : public FiberPartsProcessor
+{
+public:
+
+    CurvatureProcessor(unsigned int numThreads, float minRadius, bool deleteFibers)
+        : FiberPartsProcessor(numThreads)
+        , m_MinRadius(minRadius)
+        , m_DeleteFibers(deleteFibers)
+    {}
+
+    void ProcessFibers(const mitk::FiberColumnStore& fibers, unsigned int firstFiber, unsigned int lastFiber, unsigned int threadId)
+    {
+        std::vector<float> container;
+        for (unsigned int i=firstFiber; i<lastFiber; i++)
+        {
+            const float* points = fibers.GetPoints(i);
+            int numPoints = fibers.GetNumberOfPoints(i);
+
+            container.clear();
+            for (int j=0; j<numPoints-2; j++)
+            {
+                const float* p1 = points+3*j;
+                const float* p2 = points+3*j+3;
+                const float* p3 = points+3*j+6;
+
+                vnl_vector_fixed< float, 3 > v1, v2, v3;
+
+                v1[0] = p2[0]-p1[0];
+                v1[1] = p2[1]-p1[1];
+                v1[2] = p2[2]-p1[2];
+
+                v2[0] = p3[0]-p2[0];
+                v2[1] = p3[1]-p2[1];
+                v2[2] = p3[2]-p2[2];
+
+                v3[0] = p1[0]-p3[0];
+                v3[1] = p1[1]-p3[1];
+                v3[2] = p1[2]-p3[2];
+
+                float a = v1.magnitude();
+                float b = v2.magnitude();
+                float c = v3.magnitude();
+                float r = a*b*c/std::sqrt((a+b+c)*(a+b-c)*(b+c-a)*(a-b+c)); // radius of triangle via Heron's formula (area of triangle)
+
+                container.insert(container.end(), p1, p1+3);
+
+                if (m_DeleteFibers && r<m_MinRadius)
+                    break;
+
+                if (r<m_MinRadius)
+                {
+                    j += 2;
+                    AddFiber(container, threadId);
+                }
+                else if (j==numPoints-3)
+                {
+                    container.insert(container.end(), p2, p3+3);
+                    AddFiber(container, threadId);
+                }
+            }
+        }
+    }
+
+private:
+
+    // fibers with less than two points are dropped
+    void AddFiber(std::vector<float>& container, unsigned int threadId)
+    {
+        if (container.size()>=6)
+            m_Parts[threadId].AddFiber(&container[0], container.size()/3);
+        container.clear();
+    }
+
+    float   m_MinRadius;
+    bool    m_DeleteFibers;
+};
+
+// per point color from the local fiber direction
+class OrientationColorProcessor : public mitk::FiberColumnStore::FiberProcessor
+{
+public:
+
+    OrientationColorProcessor(unsigned char* colors) : m_Colors(colors) {}
+
+    void ProcessFibers(const mitk::FiberColumnStore& fibers, unsigned int firstFiber, unsigned int lastFiber, unsigned int)
+    {
+        for (unsigned int i=firstFiber; i<lastFiber; i++)
+        {
+            const float* points = fibers.GetPoints(i);
+            int numPoints = fibers.GetNumberOfPoints(i);
+            unsigned char* rgba = m_Colors+4*fibers.GetFirstPoint(i);
+            for (int j=0; j<numPoints; j++, rgba+=4)
+            {
+                // the first point has no previous point and the last point no next point
+                vnl_vector_fixed< double, 3 > diff;
+                int prev = j>0 ? j-1 : j;
+                int next = j<numPoints-1 ? j+1 : j;
+                for (int k=0; k<3; k++)
+                    diff[k] = points[3*prev+k]-points[3*next+k];
+                diff.normalize();
+
+                rgba[0] = (unsigned char) (255.0 * std::fabs(diff[0]));
+                rgba[1] = (unsigned char) (255.0 * std::fabs(diff[1]));
+                rgba[2] = (unsigned char) (255.0 * std::fabs(diff[2]));
+                rgba[3] = (unsigned char) (255.0);
+            }
+        }
+    }
+
+private:
+
+    unsigned char* m_Colors;
+};
+
+// fiber lengths and bounding box of the points of each thread
+class GeometryProcessor : public mitk::FiberColumnStore::FiberProcessor
+{
+public:
+
+    GeometryProcessor(unsigned int numThreads, std::vector< float >& lengths)
+        : m_Lengths(lengths)
+        , m_Bounds(6*numThreads)
+    {
+        for (unsigned int i=0; i<m_Bounds.size(); i+=2)
+        {
+            m_Bounds[i] = itk::NumericTraits<float>::max();
+            m_Bounds[i+1] = itk::NumericTraits<float>::NonpositiveMin();
+        }
+    }
+
+    void ProcessFibers(const mitk::FiberColumnStore& fibers, unsigned int firstFiber, unsigned int lastFiber, unsigned int threadId)
+    {
+        float* b = &m_Bounds[6*threadId];
+        for (unsigned int i=firstFiber; i<lastFiber; i++)
+        {
+            const float* points = fibers.GetPoints(i);
+            int numPoints = fibers.GetNumberOfPoints(i);
+            float length = 0;
+            for (int j=0; j<numPoints; j++)
+            {
+                const float* p1 = points+3*j;
+                for (int k=0; k<3; k++)
+                {
+                    if (p1[k]<b[2*k])
+                        b[2*k] = p1[k];
+                    if (p1[k]>b[2*k+1])
+                        b[2*k+1] = p1[k];
+                }
+
+                if (j<numPoints-1)
+                {
+                    const float* p2 = p1+3;
+                    length += std::sqrt((p1[0]-p2[0])*(p1[0]-p2[0])+(p1[1]-p2[1])*(p1[1]-p2[1])+(p1[2]-p2[2])*(p1[2]-p2[2]));
+                }
+            }
+            m_Lengths[i] = length;
+        }
+    }
+
+    void GetBounds(float b[6]) const
+    {
+        for (int k=0; k<6; k++)
+            b[k] = m_Bounds[k];
+        for (unsigned int t=6; t<m_Bounds.size(); t+=6)
+            for (int k=0; k<3; k++)
+            {
+                b[2*k] = std::min(b[2*k], m_Bounds[t+2*k]);
+                b[2*k+1] = std::max(b[2*k+1], m_Bounds[t+2*k+1]);
+            }
+    }
+
+private:
+
+    std::vector< float >&   m_Lengths;
+    std::vector< float >    m_Bounds;
+};
+
+}
+
 mitk::FiberBundleX::FiberBundleX( vtkPolyData* fiberPolyData )
     : m_CurrentColorCoding(NULL)
     , m_NumFibers(0)
@@ -55,13 +516,12 @@ mitk::FiberBundleX::FiberBundleX( vtkPolyData* fiberPolyData )
 {
     m_FiberPolyData = vtkSmartPointer<vtkPolyData>::New();
     if (fiberPolyData != NULL)
-    {
         m_FiberPolyData = fiberPolyData;
-        //m_FiberPolyData->DeepCopy(fiberPolyData);
-        this->DoColorCodingOrientationBased();
-    }
 
+    // the color coding is computed on the imported fibers
     this->UpdateFiberGeometry();
+    if (fiberPolyData != NULL)
+        this->DoColorCodingOrientationBased();
     this->SetColorCoding(COLORCODING_ORIENTATION_BASED);
     this->GenerateFiberIds();
 }
@@ -113,12 +573,13 @@ vtkSmartPointer<vtkPolyData> mitk::FiberBundleX::GeneratePolyDataByIds(std::vect
     std::vector<long>::iterator finIt = fiberIds.begin();
     while ( finIt != fiberIds.end() )
     {
-        if (*finIt < 0 || *finIt>GetNumFibers()){
-            MITK_INFO << "FiberID can not be negative or >NumFibers!!! check id Extraction!" << *finIt;
+        // fiber ids are cell ids of the lines
+        if (*finIt < m_FiberPolyData->GetNumberOfVerts() || *finIt >= m_FiberPolyData->GetNumberOfVerts()+m_FiberPolyData->GetNumberOfLines()){
+            MITK_INFO << "FiberID is no line of the fiber poly data!!! check id Extraction!" << *finIt;
             break;
         }
 
-        vtkSmartPointer<vtkCell> fiber = m_FiberIdDataSet->GetCell(*finIt);//->DeepCopy(fiber);
+        vtkSmartPointer<vtkCell> fiber = m_FiberPolyData->GetCell(*finIt);
 
         vtkSmartPointer<vtkPoints> fibPoints = fiber->GetPoints();
 
@@ -302,18 +763,20 @@ itk::Point<float, 3> mitk::FiberBundleX::GetItkPoint(double point[3])
  */
 void mitk::FiberBundleX::SetFiberPolyData(vtkSmartPointer<vtkPolyData> fiberPD, bool updateGeometry)
 {
-    if (fiberPD == NULL)
-        this->m_FiberPolyData = vtkSmartPointer<vtkPolyData>::New();
-    else
-    {
+    // new polydata, the arrays of the old one may be shared with other fiber bundles
+    m_FiberPolyData = vtkSmartPointer<vtkPolyData>::New();
+    if (fiberPD != NULL)
         m_FiberPolyData->DeepCopy(fiberPD);
-        DoColorCodingOrientationBased();
-    }
-
-    m_NumFibers = m_FiberPolyData->GetNumberOfLines();
 
     if (updateGeometry)
         UpdateFiberGeometry();
+    else
+    {
+        m_FiberPolyData = m_FiberStore.Import(m_FiberPolyData);
+        m_NumFibers = m_FiberStore.GetNumberOfFibers();
+    }
+    if (fiberPD != NULL)
+        DoColorCodingOrientationBased();
     SetColorCoding(COLORCODING_ORIENTATION_BASED);
     GenerateFiberIds();
 }
@@ -350,123 +813,25 @@ void mitk::FiberBundleX::DoColorCodingOrientationBased()
     }
 
     /* Finally, execute color calculation */
-    vtkPoints* extrPoints = NULL;
-    extrPoints = m_FiberPolyData->GetPoints();
-    int numOfPoints = 0;
-    if (extrPoints!=NULL)
-        numOfPoints = extrPoints->GetNumberOfPoints();
+    int numOfPoints = m_FiberStore.GetNumberOfPoints();
 
     //colors and alpha value for each single point, RGBA = 4 components
-    unsigned char rgba[4] = {0,0,0,0};
-    //    int componentSize = sizeof(rgba);
     int componentSize = 4;
 
     vtkSmartPointer<vtkUnsignedCharArray> colorsT = vtkSmartPointer<vtkUnsignedCharArray>::New();
-    colorsT->Allocate(numOfPoints * componentSize);
     colorsT->SetNumberOfComponents(componentSize);
+    colorsT->SetNumberOfTuples(numOfPoints);
     colorsT->SetName(COLORCODING_ORIENTATION_BASED);
 
-
-
     /* checkpoint: does polydata contain any fibers */
-    int numOfFibers = m_FiberPolyData->GetNumberOfLines();
-    if (numOfFibers < 1) {
+    if (m_FiberStore.GetNumberOfFibers() < 1) {
         MITK_DEBUG << "\n ========= Number of Fibers is 0 and below ========= \n";
         return;
     }
 
-
-    /* extract single fibers of fiberBundle */
-    vtkCellArray* fiberList = m_FiberPolyData->GetLines();
-    fiberList->InitTraversal();
-    for (int fi=0; fi<numOfFibers; ++fi) {
-
-        vtkIdType* idList; // contains the point id's of the line
-        vtkIdType pointsPerFiber; // number of points for current line
-        fiberList->GetNextCell(pointsPerFiber, idList);
-
-        //    MITK_DEBUG << "Fib#: " << fi << " of " << numOfFibers << " pnts in fiber: " << pointsPerFiber ;
-
-        /* single fiber checkpoints: is number of points valid */
-        if (pointsPerFiber > 1)
-        {
-            /* operate on points of single fiber */
-            for (int i=0; i <pointsPerFiber; ++i)
-            {
-                /* process all points except starting and endpoint
-         * for calculating color value take current point, previous point and next point */
-                if (i<pointsPerFiber-1 && i > 0)
-                {
-                    /* The color value of the current point is influenced by the previous point and next point. */
-                    vnl_vector_fixed< double, 3 > currentPntvtk(extrPoints->GetPoint(idList[i])[0], extrPoints->GetPoint(idList[i])[1],extrPoints->GetPoint(idList[i])[2]);
-                    vnl_vector_fixed< double, 3 > nextPntvtk(extrPoints->GetPoint(idList[i+1])[0], extrPoints->GetPoint(idList[i+1])[1], extrPoints->GetPoint(idList[i+1])[2]);
-                    vnl_vector_fixed< double, 3 > prevPntvtk(extrPoints->GetPoint(idList[i-1])[0], extrPoints->GetPoint(idList[i-1])[1], extrPoints->GetPoint(idList[i-1])[2]);
-
-                    vnl_vector_fixed< double, 3 > diff1;
-                    diff1 = currentPntvtk - nextPntvtk;
-
-                    vnl_vector_fixed< double, 3 > diff2;
-                    diff2 = currentPntvtk - prevPntvtk;
-
-                    vnl_vector_fixed< double, 3 > diff;
-                    diff = (diff1 - diff2) / 2.0;
-                    diff.normalize();
-
-                    rgba[0] = (unsigned char) (255.0 * std::fabs(diff[0]));
-                    rgba[1] = (unsigned char) (255.0 * std::fabs(diff[1]));
-                    rgba[2] = (unsigned char) (255.0 * std::fabs(diff[2]));
-                    rgba[3] = (unsigned char) (255.0);
-
-
-                } else if (i==0) {
-                    /* First point has no previous point, therefore only diff1 is taken */
-
-                    vnl_vector_fixed< double, 3 > currentPntvtk(extrPoints->GetPoint(idList[i])[0], extrPoints->GetPoint(idList[i])[1],extrPoints->GetPoint(idList[i])[2]);
-                    vnl_vector_fixed< double, 3 > nextPntvtk(extrPoints->GetPoint(idList[i+1])[0], extrPoints->GetPoint(idList[i+1])[1], extrPoints->GetPoint(idList[i+1])[2]);
-
-                    vnl_vector_fixed< double, 3 > diff1;
-                    diff1 = currentPntvtk - nextPntvtk;
-                    diff1.normalize();
-
-                    rgba[0] = (unsigned char) (255.0 * std::fabs(diff1[0]));
-                    rgba[1] = (unsigned char) (255.0 * std::fabs(diff1[1]));
-                    rgba[2] = (unsigned char) (255.0 * std::fabs(diff1[2]));
-                    rgba[3] = (unsigned char) (255.0);
-
-
-                } else if (i==pointsPerFiber-1) {
-                    /* Last point has no next point, therefore only diff2 is taken */
-                    vnl_vector_fixed< double, 3 > currentPntvtk(extrPoints->GetPoint(idList[i])[0], extrPoints->GetPoint(idList[i])[1],extrPoints->GetPoint(idList[i])[2]);
-                    vnl_vector_fixed< double, 3 > prevPntvtk(extrPoints->GetPoint(idList[i-1])[0], extrPoints->GetPoint(idList[i-1])[1], extrPoints->GetPoint(idList[i-1])[2]);
-
-                    vnl_vector_fixed< double, 3 > diff2;
-                    diff2 = currentPntvtk - prevPntvtk;
-                    diff2.normalize();
-
-                    rgba[0] = (unsigned char) (255.0 * std::fabs(diff2[0]));
-                    rgba[1] = (unsigned char) (255.0 * std::fabs(diff2[1]));
-                    rgba[2] = (unsigned char) (255.0 * std::fabs(diff2[2]));
-                    rgba[3] = (unsigned char) (255.0);
-
-                }
-
-                colorsT->InsertTupleValue(idList[i], rgba);
-
-            } //end for loop
-
-        } else if (pointsPerFiber == 1) {
-            /* a single point does not define a fiber (use vertex mechanisms instead */
-            continue;
-            //      colorsT->InsertTupleValue(0, rgba);
-
-        } else {
-            MITK_DEBUG << "Fiber with 0 points detected... please check your tractography algorithm!" ;
-            continue;
-
-        }
-
-
-    }//end for loop
+    /* the fibers are stored point after point, so each thread writes the colors of its fibers directly */
+    OrientationColorProcessor processor(colorsT->GetPointer(0));
+    m_FiberStore.ProcessFibers(&processor, itk::MultiThreader::GetGlobalDefaultNumberOfThreads());
 
     m_FiberPolyData->GetPointData()->AddArray(colorsT);
 
@@ -475,12 +840,6 @@ void mitk::FiberBundleX::DoColorCodingOrientationBased()
       - think about sourcing this to a explicit method which coordinates colorcoding */
     this->SetColorCoding(COLORCODING_ORIENTATION_BASED);
     //  ===========================
-
-    //mini test, shall be ported to MITK TESTINGS!
-    if (colorsT->GetSize() != numOfPoints*componentSize)
-        MITK_DEBUG << "ALLOCATION ERROR IN INITIATING COLOR ARRAY";
-
-
 }
 
 void mitk::FiberBundleX::DoColorCodingFaBased()
@@ -570,7 +929,13 @@ void mitk::FiberBundleX::GenerateFiberIds()
 
 mitk::FiberBundleX::Pointer mitk::FiberBundleX::ExtractFiberSubset(ItkUcharImgType* mask, bool anyPoint)
 {
-    vtkSmartPointer<vtkPolyData> polyData = m_FiberPolyData;
+    if (mask==NULL)
+        return NULL;
+
+    vtkPoints* points = m_FiberPolyData->GetPoints();
+    FiberBitmap fibers;
+
+    MITK_INFO << "Extracting fibers";
     if (anyPoint)
     {
         float minSpacing = 1;
@@ -580,91 +945,71 @@ mitk::FiberBundleX::Pointer mitk::FiberBundleX::ExtractFiberSubset(ItkUcharImgTy
             minSpacing = mask->GetSpacing()[1];
         else
             minSpacing = mask->GetSpacing()[2];
+        double sampling = minSpacing/10;
 
-        mitk::FiberBundleX::Pointer fibCopy = this->GetDeepCopy();
-        fibCopy->ResampleFibers(minSpacing/10);
-        polyData = fibCopy->GetFiberPolyData();
-    }
-    vtkSmartPointer<vtkPoints> vtkNewPoints = vtkSmartPointer<vtkPoints>::New();
-    vtkSmartPointer<vtkCellArray> vtkNewCells = vtkSmartPointer<vtkCellArray>::New();
-
-    MITK_INFO << "Extracting fibers";
-    boost::progress_display disp(m_NumFibers);
-    for (int i=0; i<m_NumFibers; i++)
-    {
-        ++disp;
-
-        vtkCell* cell = polyData->GetCell(i);
-        int numPoints = cell->GetNumberOfPoints();
-        vtkPoints* points = cell->GetPoints();
-
-        vtkCell* cellOriginal = m_FiberPolyData->GetCell(i);
-        int numPointsOriginal = cellOriginal->GetNumberOfPoints();
-        vtkPoints* pointsOriginal = cellOriginal->GetPoints();
+        // only the segments passing the bounding box of the mask are sampled
+        double bounds[6];
+        if (!GetMaskBounds(mask, bounds))
+            return mitk::FiberBundleX::New();
 
-        vtkSmartPointer<vtkPolyLine> container = vtkSmartPointer<vtkPolyLine>::New();
+        UpdateSpatialIndex();
+        std::vector<FiberSpatialIndex::SegmentRun> runs;
+        m_SpatialIndex.FindSegments(bounds, runs);
 
-        if (numPoints>1 && numPointsOriginal)
+        std::vector<bool> selected(m_FiberPolyData->GetNumberOfCells(), false);
+        for (unsigned int r=0; r<runs.size(); r++)
         {
-            if (anyPoint)
+            const FiberSpatialIndex::SegmentRun& run = runs[r];
+            if (selected[run.m_Fiber])
+                continue;
+
+            vtkIdType numPoints;
+            const vtkIdType* ids = m_SpatialIndex.GetFiberPointIds(run.m_Fiber, numPoints);
+            for (unsigned int j=run.m_FirstSegment; j<run.m_FirstSegment+run.m_NumberOfSegments && !selected[run.m_Fiber]; j++)
             {
-                for (int j=0; j<numPoints; j++)
+                double p0[3], p1[3];
+                points->GetPoint(ids[j], p0);
+                points->GetPoint(ids[j+1], p1);
+                double length = std::sqrt((p1[0]-p0[0])*(p1[0]-p0[0])+(p1[1]-p0[1])*(p1[1]-p0[1])+(p1[2]-p0[2])*(p1[2]-p0[2]));
+
+                // sample the segment at least as densely as the fibers resampled to minSpacing/10
+                int steps = std::max(1, (int)std::ceil(length/sampling));
+                for (int k=0; k<=steps; k++)
                 {
-                    double* p = points->GetPoint(j);
-
-                    itk::Point<float, 3> itkP;
-                    itkP[0] = p[0]; itkP[1] = p[1]; itkP[2] = p[2];
-                    itk::Index<3> idx;
-                    mask->TransformPhysicalPointToIndex(itkP, idx);
-
-                    if ( mask->GetPixel(idx)>0 && mask->GetLargestPossibleRegion().IsInside(idx) )
+                    double t = (double)k/steps;
+                    double p[3] = {p0[0]+t*(p1[0]-p0[0]), p0[1]+t*(p1[1]-p0[1]), p0[2]+t*(p1[2]-p0[2])};
+                    if (IsInsideMask(mask, p))
                     {
-                        for (int k=0; k<numPointsOriginal; k++)
-                        {
-                            double* p = pointsOriginal->GetPoint(k);
-                            vtkIdType id = vtkNewPoints->InsertNextPoint(p);
-                            container->GetPointIds()->InsertNextId(id);
-                        }
+                        selected[run.m_Fiber] = true;
                         break;
                     }
                 }
             }
-            else
-            {
-                double* start = pointsOriginal->GetPoint(0);
-                itk::Point<float, 3> itkStart;
-                itkStart[0] = start[0]; itkStart[1] = start[1]; itkStart[2] = start[2];
-                itk::Index<3> idxStart;
-                mask->TransformPhysicalPointToIndex(itkStart, idxStart);
-
-                double* end = pointsOriginal->GetPoint(numPointsOriginal-1);
-                itk::Point<float, 3> itkEnd;
-                itkEnd[0] = end[0]; itkEnd[1] = end[1]; itkEnd[2] = end[2];
-                itk::Index<3> idxEnd;
-                mask->TransformPhysicalPointToIndex(itkEnd, idxEnd);
-
-                if ( mask->GetPixel(idxStart)>0 && mask->GetPixel(idxEnd)>0 && mask->GetLargestPossibleRegion().IsInside(idxStart) && mask->GetLargestPossibleRegion().IsInside(idxEnd) )
-                {
-                    for (int j=0; j<numPointsOriginal; j++)
-                    {
-                        double* p = pointsOriginal->GetPoint(j);
-                        vtkIdType id = vtkNewPoints->InsertNextPoint(p);
-                        container->GetPointIds()->InsertNextId(id);
-                    }
-                }
-            }
         }
 
-        vtkNewCells->InsertNextCell(container);
+        for (unsigned int i=0; i<selected.size(); i++)
+            if (selected[i])
+                fibers.Add(i);
+    }
+    else
+    {
+        vtkCellArray* lines = m_FiberPolyData->GetLines();
+        vtkIdType fiber = m_FiberPolyData->GetNumberOfVerts();
+        vtkIdType numPoints;
+        vtkIdType* ids;
+        for (lines->InitTraversal(); lines->GetNextCell(numPoints, ids); fiber++)
+        {
+            if (numPoints>1 && IsInsideMask(mask, points->GetPoint(ids[0])) && IsInsideMask(mask, points->GetPoint(ids[numPoints-1])))
+                fibers.Add(fiber);
+        }
     }
 
-    if (vtkNewCells->GetNumberOfCells()<=0)
-        return NULL;
+    if (fibers.IsEmpty())
+        return mitk::FiberBundleX::New();
 
-    vtkSmartPointer<vtkPolyData> newPolyData = vtkSmartPointer<vtkPolyData>::New();
-    newPolyData->SetPoints(vtkNewPoints);
-    newPolyData->SetLines(vtkNewCells);
-    return mitk::FiberBundleX::New(newPolyData);
+    std::vector<long> fiberIds;
+    fibers.GetIds(fiberIds);
+    return mitk::FiberBundleX::New(GeneratePolyDataByIds(fiberIds));
 }
 
 mitk::FiberBundleX::Pointer mitk::FiberBundleX::RemoveFibersOutside(ItkUcharImgType* mask, bool invert)
@@ -765,326 +1110,199 @@ std::vector<long> mitk::FiberBundleX::ExtractFiberIdSubset(mitk::PlanarFigure* p
     if (pf==NULL)
         return FibersInROI;
 
-    /* Handle type of planarfigure */
-    // if incoming pf is a pfc
-    mitk::PlanarFigureComposite::Pointer pfcomp= dynamic_cast<mitk::PlanarFigureComposite*>(pf);
-    if (!pfcomp.IsNull()) {
-        // process requested boolean operation of PFC
-        switch (pfcomp->getOperationType()) {
-        case 0:
-        {
-            MITK_DEBUG << "AND PROCESSING";
-            //AND
-            //temporarly store results of the child in this vector, we need that to accumulate the
-            std::vector<long> childResults = this->ExtractFiberIdSubset(pfcomp->getChildAt(0));
-            MITK_DEBUG << "first roi got fibers in ROI: " << childResults.size();
-            MITK_DEBUG << "sorting...";
-            std::sort(childResults.begin(), childResults.end());
-            MITK_DEBUG << "sorting done";
-            std::vector<long> AND_Assamblage(childResults.size());
-            //std::vector<unsigned long> AND_Assamblage;
-            fill(AND_Assamblage.begin(), AND_Assamblage.end(), -1);
-            //AND_Assamblage.reserve(childResults.size()); //max size AND can reach anyway
-
-            std::vector<long>::iterator it;
-            for (int i=1; i<pfcomp->getNumberOfChildren(); ++i)
-            {
-                std::vector<long> tmpChild = this->ExtractFiberIdSubset(pfcomp->getChildAt(i));
-                MITK_DEBUG << "ROI " << i << " has fibers in ROI: " << tmpChild.size();
-                sort(tmpChild.begin(), tmpChild.end());
+    FiberBitmap fibers;
+    ExtractFiberBitmap(pf, fibers);
+    fibers.GetIds(FibersInROI);
 
-                it = std::set_intersection(childResults.begin(), childResults.end(),
-                                           tmpChild.begin(), tmpChild.end(),
-                                           AND_Assamblage.begin() );
-            }
+    MITK_DEBUG << "Fibers in ROI: " << FibersInROI.size();
+    return FibersInROI;
+}
 
-            MITK_DEBUG << "resize Vector";
-            long i=0;
-            while (i < AND_Assamblage.size() && AND_Assamblage[i] != -1){ //-1 represents a placeholder in the array
-                ++i;
-            }
-            AND_Assamblage.resize(i);
+void mitk::FiberBundleX::ExtractFiberBitmap(mitk::PlanarFigure* pf, FiberBitmap& fibers)
+{
+    fibers.Clear();
 
-            MITK_DEBUG << "returning AND vector, size: " << AND_Assamblage.size();
-            return AND_Assamblage;
-            //            break;
+    mitk::PlanarFigureComposite* pfcomp = dynamic_cast<mitk::PlanarFigureComposite*>(pf);
+    if (pfcomp==NULL)
+    {
+        ExtractFiberBitmapOfFigure(pf, fibers);
+        return;
+    }
+    if (pfcomp->getNumberOfChildren()<=0)
+        return;
 
-        }
-        case 1:
+    // process requested boolean operation of PFC, the results of unchanged leaf figures come from the cache
+    switch (pfcomp->getOperationType())
+    {
+    case PFCOMPOSITION_AND_OPERATION:
+    {
+        ExtractFiberBitmap(pfcomp->getChildAt(0), fibers);
+        for (int i=1; i<pfcomp->getNumberOfChildren() && !fibers.IsEmpty(); ++i)
         {
-            //OR
-            std::vector<long> OR_Assamblage = this->ExtractFiberIdSubset(pfcomp->getChildAt(0));
-            std::vector<long>::iterator it;
-            MITK_DEBUG << OR_Assamblage.size();
-
-            for (int i=1; i<pfcomp->getNumberOfChildren(); ++i) {
-                it = OR_Assamblage.end();
-                std::vector<long> tmpChild = this->ExtractFiberIdSubset(pfcomp->getChildAt(i));
-                OR_Assamblage.insert(it, tmpChild.begin(), tmpChild.end());
-                MITK_DEBUG << "ROI " << i << " has fibers in ROI: " << tmpChild.size() << " OR Assamblage: " << OR_Assamblage.size();
-            }
-
-            sort(OR_Assamblage.begin(), OR_Assamblage.end());
-            it = unique(OR_Assamblage.begin(), OR_Assamblage.end());
-            OR_Assamblage.resize( it - OR_Assamblage.begin() );
-            MITK_DEBUG << "returning OR vector, size: " << OR_Assamblage.size();
-
-            return OR_Assamblage;
+            FiberBitmap child;
+            ExtractFiberBitmap(pfcomp->getChildAt(i), child);
+            fibers.And(child);
         }
-        case 2:
+        break;
+    }
+    case PFCOMPOSITION_OR_OPERATION:
+    {
+        for (int i=0; i<pfcomp->getNumberOfChildren(); ++i)
         {
-            //NOT
-            //get IDs of all fibers
-            std::vector<long> childResults;
-            childResults.reserve(this->GetNumFibers());
-            vtkSmartPointer<vtkDataArray> idSet = m_FiberIdDataSet->GetCellData()->GetArray(FIBER_ID_ARRAY);
-            MITK_DEBUG << "m_NumOfFib: " << this->GetNumFibers() << " cellIdNum: " << idSet->GetNumberOfTuples();
-            for(long i=0; i<this->GetNumFibers(); i++)
-            {
-                MITK_DEBUG << "i: " << i << " idset: " << idSet->GetTuple(i)[0];
-                childResults.push_back(idSet->GetTuple(i)[0]);
-            }
-
-            std::sort(childResults.begin(), childResults.end());
-            std::vector<long> NOT_Assamblage(childResults.size());
-            //fill it with -1, otherwise 0 will be stored and 0 can also be an ID of fiber!
-            fill(NOT_Assamblage.begin(), NOT_Assamblage.end(), -1);
-            std::vector<long>::iterator it;
-
-            for (long i=0; i<pfcomp->getNumberOfChildren(); ++i)
-            {
-                std::vector<long> tmpChild = ExtractFiberIdSubset(pfcomp->getChildAt(i));
-                sort(tmpChild.begin(), tmpChild.end());
-
-                it = std::set_difference(childResults.begin(), childResults.end(),
-                                         tmpChild.begin(), tmpChild.end(),
-                                         NOT_Assamblage.begin() );
-
-            }
-
-            MITK_DEBUG << "resize Vector";
-            long i=0;
-            while (NOT_Assamblage[i] != -1){ //-1 represents a placeholder in the array
-                ++i;
-            }
-            NOT_Assamblage.resize(i);
-
-            return NOT_Assamblage;
-        }
-        default:
-            MITK_DEBUG << "we have an UNDEFINED composition... ERROR" ;
-            break;
-
+            FiberBitmap child;
+            ExtractFiberBitmap(pfcomp->getChildAt(i), child);
+            fibers.Or(child);
         }
+        break;
     }
-    else
+    case PFCOMPOSITION_NOT_OPERATION:
     {
-        mitk::Geometry2D::ConstPointer pfgeometry = pf->GetGeometry2D();
-        const mitk::PlaneGeometry* planeGeometry = dynamic_cast<const mitk::PlaneGeometry*> (pfgeometry.GetPointer());
-        Vector3D planeNormal = planeGeometry->GetNormal();
-        planeNormal.Normalize();
-        Point3D planeOrigin = planeGeometry->GetOrigin();
-
-        MITK_DEBUG << "planeOrigin: " << planeOrigin[0] << " | " << planeOrigin[1] << " | " << planeOrigin[2] << endl;
-        MITK_DEBUG << "planeNormal: " << planeNormal[0] << " | " << planeNormal[1] << " | " << planeNormal[2] << endl;
-
-        std::vector<int> PointsOnPlane; // contains all pointIds which are crossing the cutting plane
-        std::vector<int> PointsInROI; // based on PointsOnPlane, all ROI relevant point IDs are stored here
-
-        /* Define cutting plane by ROI (PlanarFigure) */
-        vtkSmartPointer<vtkPlane> plane = vtkSmartPointer<vtkPlane>::New();
-        plane->SetOrigin(planeOrigin[0],planeOrigin[1],planeOrigin[2]);
-        plane->SetNormal(planeNormal[0],planeNormal[1],planeNormal[2]);
-
-        /* get all points/fibers cutting the plane */
-        MITK_DEBUG << "start clipping";
-        vtkSmartPointer<vtkClipPolyData> clipper = vtkSmartPointer<vtkClipPolyData>::New();
-        clipper->SetInput(m_FiberIdDataSet);
-        clipper->SetClipFunction(plane);
-        clipper->GenerateClipScalarsOn();
-        clipper->GenerateClippedOutputOn();
-        vtkSmartPointer<vtkPolyData> clipperout = clipper->GetClippedOutput();
-        MITK_DEBUG << "end clipping";
-
-        MITK_DEBUG << "init and update clipperoutput";
-        clipperout->GetPointData()->Initialize();
-        clipperout->Update();
-        MITK_DEBUG << "init and update clipperoutput completed";
-
-        MITK_DEBUG << "STEP 1: find all points which have distance 0 to the given plane";
-        /*======STEP 1======
-      * extract all points, which are crossing the plane */
-        // Scalar values describe the distance between each remaining point to the given plane. Values sorted by point index
-        vtkSmartPointer<vtkDataArray> distanceList = clipperout->GetPointData()->GetScalars();
-        vtkIdType sizeOfList =  distanceList->GetNumberOfTuples();
-        PointsOnPlane.reserve(sizeOfList); /* use reserve for high-performant push_back, no hidden copy procedures are processed then!
-                                         * size of list can be optimized by reducing allocation, but be aware of iterator and vector size*/
-
-        for (int i=0; i<sizeOfList; ++i) {
-            double *distance = distanceList->GetTuple(i);
-
-            // check if point is on plane.
-            // 0.01 due to some approximation errors when calculating distance
-            if (distance[0] >= -0.01 && distance[0] <= 0.01)
-                PointsOnPlane.push_back(i);
+        // all fibers which are in none of the children
+        FiberBitmap children;
+        for (int i=0; i<pfcomp->getNumberOfChildren(); ++i)
+        {
+            FiberBitmap child;
+            ExtractFiberBitmap(pfcomp->getChildAt(i), child);
+            children.Or(child);
         }
+        // the fiber ids are cell ids, the lines follow the verts of the poly data
+        vtkIdType firstFiber = m_FiberPolyData->GetNumberOfVerts();
+        fibers = FiberBitmap::Fill(firstFiber+m_FiberPolyData->GetNumberOfLines());
+        fibers.AndNot(FiberBitmap::Fill(firstFiber));
+        fibers.AndNot(children);
+        break;
+    }
+    default:
+        MITK_DEBUG << "we have an UNDEFINED composition... ERROR" ;
+        break;
+    }
+}
 
+void mitk::FiberBundleX::ExtractFiberBitmapOfFigure(mitk::PlanarFigure* pf, FiberBitmap& fibers)
+{
+    fibers.Clear();
 
-        MITK_DEBUG << "Num Of points on plane: " <<  PointsOnPlane.size();
-
-        MITK_DEBUG << "Step 2: extract Interesting points with respect to given extraction planarFigure";
+    const mitk::PlaneGeometry* planeGeometry = dynamic_cast<const mitk::PlaneGeometry*>(pf->GetGeometry2D());
+    if (planeGeometry==NULL)
+        return;
 
-        PointsInROI.reserve(PointsOnPlane.size());
-        /*=======STEP 2=====
-     * extract ROI relevant pointIds */
+    Vector3D planeNormal = planeGeometry->GetNormal();
+    planeNormal.Normalize();
+    Point3D planeOrigin = planeGeometry->GetOrigin();
 
-        mitk::PlanarCircle::Pointer circleName = mitk::PlanarCircle::New();
-        mitk::PlanarPolygon::Pointer polyName = mitk::PlanarPolygon::New();
-        if ( pf->GetNameOfClass() == circleName->GetNameOfClass() )
-        {
-            //calculate circle radius
-            mitk::Point3D V1w = pf->GetWorldControlPoint(0); //centerPoint
-            mitk::Point3D V2w  = pf->GetWorldControlPoint(1); //radiusPoint
+    UpdateSpatialIndex();
 
-            double distPF = V1w.EuclideanDistanceTo(V2w);
+    // the selection only depends on the plane and the control points; figures do not call Modified() when they are edited
+    std::vector<double> parameters;
+    for (int i=0; i<3; i++)
+    {
+        parameters.push_back(planeOrigin[i]);
+        parameters.push_back(planeNormal[i]);
+    }
+    for (unsigned int i=0; i<pf->GetNumberOfControlPoints(); i++)
+    {
+        Point3D p = pf->GetWorldControlPoint(i);
+        parameters.push_back(p[0]);
+        parameters.push_back(p[1]);
+        parameters.push_back(p[2]);
+    }
 
-            for (int i=0; i<PointsOnPlane.size(); i++)
-            {
-                //distance between circle radius and given point
-                double XdistPnt =  sqrt((double) (clipperout->GetPoint(PointsOnPlane[i])[0] - V1w[0]) * (clipperout->GetPoint(PointsOnPlane[i])[0] - V1w[0]) +
-                                        (clipperout->GetPoint(PointsOnPlane[i])[1] - V1w[1]) * (clipperout->GetPoint(PointsOnPlane[i])[1] - V1w[1]) +
-                                        (clipperout->GetPoint(PointsOnPlane[i])[2] - V1w[2]) * (clipperout->GetPoint(PointsOnPlane[i])[2] - V1w[2])) ;
+    std::map< const PlanarFigure*, RoiCacheEntry >::iterator cached = m_RoiCache.find(pf);
+    if (cached!=m_RoiCache.end() && cached->second.m_Type==pf->GetNameOfClass() && cached->second.m_Parameters==parameters)
+    {
+        fibers = cached->second.m_Fibers;
+        return;
+    }
 
-                if( XdistPnt <= distPF)
-                    PointsInROI.push_back(PointsOnPlane[i]);
-            }
-        }
-        else if ( pf->GetNameOfClass() == polyName->GetNameOfClass() )
+    RoiShape roi;
+    if (roi.Initialize(pf, planeNormal))
+    {
+        /* Candidate segments are the ones in the grid cells overlapping the figure. A fiber is selected if it crosses the
+         * plane of the figure inside the figure or if one of its points lies on the plane inside the figure. */
+        const double tolerance = 0.01; // due to some approximation errors when calculating distance
+        double bounds[6];
+        roi.GetBounds(tolerance, bounds);
+        std::vector<FiberSpatialIndex::SegmentRun> runs;
+        m_SpatialIndex.FindSegments(bounds, runs);
+
+        vtkPoints* points = m_FiberPolyData->GetPoints();
+        std::vector<bool> selected(m_FiberPolyData->GetNumberOfCells(), false);
+        std::vector<unsigned int> selectedIds;
+        for (unsigned int r=0; r<runs.size(); r++)
         {
-            //create vtkPolygon using controlpoints from planarFigure polygon
-            vtkSmartPointer<vtkPolygon> polygonVtk = vtkSmartPointer<vtkPolygon>::New();
-
-            //get the control points from pf and insert them to vtkPolygon
-            unsigned int nrCtrlPnts = pf->GetNumberOfControlPoints();
-
-            for (int i=0; i<nrCtrlPnts; ++i)
-            {
-                polygonVtk->GetPoints()->InsertNextPoint((double)pf->GetWorldControlPoint(i)[0], (double)pf->GetWorldControlPoint(i)[1], (double)pf->GetWorldControlPoint(i)[2] );
-            }
-
-            //prepare everything for using pointInPolygon function
-            double n[3];
-            polygonVtk->ComputeNormal(polygonVtk->GetPoints()->GetNumberOfPoints(),
-                                      static_cast<double*>(polygonVtk->GetPoints()->GetData()->GetVoidPointer(0)), n);
-
-            double bounds[6];
-            polygonVtk->GetPoints()->GetBounds(bounds);
+            const FiberSpatialIndex::SegmentRun& run = runs[r];
+            if (selected[run.m_Fiber])
+                continue;
 
-            for (int i=0; i<PointsOnPlane.size(); i++)
+            vtkIdType numPoints;
+            const vtkIdType* ids = m_SpatialIndex.GetFiberPointIds(run.m_Fiber, numPoints);
+            double p0[3], p1[3];
+            points->GetPoint(ids[run.m_FirstSegment], p0);
+            double d0 = (p0[0]-planeOrigin[0])*planeNormal[0] + (p0[1]-planeOrigin[1])*planeNormal[1] + (p0[2]-planeOrigin[2])*planeNormal[2];
+            for (unsigned int j=run.m_FirstSegment; j<run.m_FirstSegment+run.m_NumberOfSegments; j++)
             {
-                double checkIn[3] = {clipperout->GetPoint(PointsOnPlane[i])[0], clipperout->GetPoint(PointsOnPlane[i])[1], clipperout->GetPoint(PointsOnPlane[i])[2]};
-                int isInPolygon = polygonVtk->PointInPolygon(checkIn, polygonVtk->GetPoints()->GetNumberOfPoints()
-                                                             , static_cast<double*>(polygonVtk->GetPoints()->GetData()->GetVoidPointer(0)), bounds, n);
-                if( isInPolygon )
-                    PointsInROI.push_back(PointsOnPlane[i]);
-            }
-        }
-
-        MITK_DEBUG << "Step3: Identify fibers";
-        // we need to access the fiberId Array, so make sure that this array is available
-        if (!clipperout->GetCellData()->HasArray(FIBER_ID_ARRAY))
-        {
-            MITK_DEBUG << "ERROR: FiberID array does not exist, no correlation between points and fiberIds possible! Make sure calling GenerateFiberIds()";
-            return FibersInROI; // FibersInRoi is empty then
-        }
-        if (PointsInROI.size()<=0)
-            return FibersInROI;
-
-        // prepare a structure where each point id is represented as an indexId.
-        // vector looks like: | pntId | fiberIdx |
-        std::vector< long > pointindexFiberMap;
-
-        // walk through the whole subline section and create an vector sorted by point index
-        vtkCellArray *clipperlines = clipperout->GetLines();
-        clipperlines->InitTraversal();
-        long numOfLineCells = clipperlines->GetNumberOfCells();
-        long numofClippedPoints = clipperout->GetNumberOfPoints();
-        pointindexFiberMap.resize(numofClippedPoints);
-
-
-        //prepare resulting vector
-        FibersInROI.reserve(PointsInROI.size());
-
-        MITK_DEBUG << "\n===== Pointindex based structure initialized ======\n";
-
-        // go through resulting "sub"lines which are stored as cells, "i" corresponds to current line id.
-        for (int i=0, ic=0 ; i<numOfLineCells; i++, ic+=3)
-        { //ic is the index counter for the cells hosting the desired information, eg. 2 | 45 | 46. each cell consits of 3 items.
+                points->GetPoint(ids[j+1], p1);
+                double d1 = (p1[0]-planeOrigin[0])*planeNormal[0] + (p1[1]-planeOrigin[1])*planeNormal[1] + (p1[2]-planeOrigin[2])*planeNormal[2];
 
-            vtkIdType npts;
-            vtkIdType *pts;
-            clipperlines->GetCell(ic, npts, pts);
+                bool inside = false;
+                if ((d0<0 && d1>0) || (d0>0 && d1<0))
+                {
+                    double t = d0/(d0-d1);
+                    double x[3] = {p0[0]+t*(p1[0]-p0[0]), p0[1]+t*(p1[1]-p0[1]), p0[2]+t*(p1[2]-p0[2])};
+                    inside = roi.IsInside(x);
+                }
+                else
+                    inside = (std::fabs(d0)<=tolerance && roi.IsInside(p0)) || (std::fabs(d1)<=tolerance && roi.IsInside(p1));
 
-            // go through point ids in hosting subline, "j" corresponds to current pointindex in current line i. eg. idx[0]=45; idx[1]=46
-            for (long j=0; j<npts; j++)
-            {
-                // MITK_DEBUG << "writing fiber id: " << clipperout->GetCellData()->GetArray(FIBER_ID_ARRAY)->GetTuple(i)[0] << " to pointId: " << pts[j];
-                pointindexFiberMap[ pts[j] ] = clipperout->GetCellData()->GetArray(FIBER_ID_ARRAY)->GetTuple(i)[0];
-                // MITK_DEBUG << "in array: " << pointindexFiberMap[ pts[j] ];
+                if (inside)
+                {
+                    selected[run.m_Fiber] = true;
+                    selectedIds.push_back(run.m_Fiber);
+                    break;
+                }
+                p0[0] = p1[0]; p0[1] = p1[1]; p0[2] = p1[2];
+                d0 = d1;
             }
-
         }
 
-        MITK_DEBUG << "\n===== Pointindex based structure finalized ======\n";
-
-        // get all Points in ROI with according fiberID
-        for (long k = 0; k < PointsInROI.size(); k++)
-        {
-            //MITK_DEBUG << "point " << PointsInROI[k] << " belongs to fiber " << pointindexFiberMap[ PointsInROI[k] ];
-            if (pointindexFiberMap[ PointsInROI[k] ]<=GetNumFibers() && pointindexFiberMap[ PointsInROI[k] ]>=0)
-                FibersInROI.push_back(pointindexFiberMap[ PointsInROI[k] ]);
-            else
-                MITK_INFO << "ERROR in ExtractFiberIdSubset; impossible fiber id detected";
-        }
-
-        m_PointsRoi = PointsInROI;
-
+        std::sort(selectedIds.begin(), selectedIds.end());
+        for (unsigned int i=0; i<selectedIds.size(); i++)
+            fibers.Add(selectedIds[i]);
     }
 
-    //  detecting fiberId duplicates
-    MITK_DEBUG << "check for duplicates";
-
-    sort(FibersInROI.begin(), FibersInROI.end());
-    bool hasDuplicats = false;
-    for(long i=0; i<FibersInROI.size()-1; ++i)
-    {
-        if(FibersInROI[i] == FibersInROI[i+1])
-            hasDuplicats = true;
-    }
+    // results of deleted figures are dropped now and then
+    if (m_RoiCache.size()>=100)
+        m_RoiCache.clear();
+    RoiCacheEntry& entry = m_RoiCache[pf];
+    entry.m_Type = pf->GetNameOfClass();
+    entry.m_Parameters = parameters;
+    entry.m_Fibers = fibers;
+}
 
-    if(hasDuplicats)
-    {
-        std::vector<long>::iterator it;
-        it = unique (FibersInROI.begin(), FibersInROI.end());
-        FibersInROI.resize( it - FibersInROI.begin() );
-    }
+void mitk::FiberBundleX::UpdateSpatialIndex()
+{
+    if (m_SpatialIndex.IsUpToDate(m_FiberPolyData))
+        return;
 
-    return FibersInROI;
+    MITK_DEBUG << "Building spatial index of fibers";
+    m_SpatialIndex.Build(m_FiberPolyData);
+    m_RoiCache.clear();
 }
 
 void mitk::FiberBundleX::UpdateFiberGeometry()
 {
-    vtkSmartPointer<vtkCleanPolyData> cleaner = vtkSmartPointer<vtkCleanPolyData>::New();
-    cleaner->SetInput(m_FiberPolyData);
-    cleaner->PointMergingOff();
-    cleaner->Update();
-    m_FiberPolyData = cleaner->GetOutput();
+    // the spatial index is rebuilt with the next ROI selection
+    m_SpatialIndex.Clear();
+    m_RoiCache.clear();
+
+    // takes the points without copying if m_FiberPolyData was created by the fiber store
+    m_FiberPolyData = m_FiberStore.Import(m_FiberPolyData);
 
     m_FiberLengths.clear();
     m_MeanFiberLength = 0;
     m_MedianFiberLength = 0;
     m_LengthStDev = 0;
-    m_NumFibers = m_FiberPolyData->GetNumberOfCells();
+    m_NumFibers = m_FiberStore.GetNumberOfFibers();
 
     if (m_NumFibers<=0) // no fibers present; apply default geometry
     {
@@ -1097,61 +1315,24 @@ void mitk::FiberBundleX::UpdateFiberGeometry()
         SetGeometry(geometry);
         return;
     }
-    float min = itk::NumericTraits<float>::NonpositiveMin();
-    float max = itk::NumericTraits<float>::max();
-    float b[] = {max, min, max, min, max, min};
 
-    for (int i=0; i<m_FiberPolyData->GetNumberOfCells(); i++)
-    {
-        vtkCell* cell = m_FiberPolyData->GetCell(i);
-        int p = cell->GetNumberOfPoints();
-        vtkPoints* points = cell->GetPoints();
-        float length = 0;
-        for (int j=0; j<p; j++)
-        {
-            // calculate bounding box
-            double p1[3];
-            points->GetPoint(j, p1);
-
-            if (p1[0]<b[0])
-                b[0]=p1[0];
-            if (p1[0]>b[1])
-                b[1]=p1[0];
-
-            if (p1[1]<b[2])
-                b[2]=p1[1];
-            if (p1[1]>b[3])
-                b[3]=p1[1];
-
-            if (p1[2]<b[4])
-                b[4]=p1[2];
-            if (p1[2]>b[5])
-                b[5]=p1[2];
-
-            // calculate statistics
-            if (j<p-1)
-            {
-                double p2[3];
-                points->GetPoint(j+1, p2);
+    m_FiberLengths.resize(m_NumFibers);
+    unsigned int numThreads = itk::MultiThreader::GetGlobalDefaultNumberOfThreads();
+    GeometryProcessor processor(numThreads, m_FiberLengths);
+    m_FiberStore.ProcessFibers(&processor, numThreads);
+    float b[6];
+    processor.GetBounds(b);
 
-                float dist = std::sqrt((p1[0]-p2[0])*(p1[0]-p2[0])+(p1[1]-p2[1])*(p1[1]-p2[1])+(p1[2]-p2[2])*(p1[2]-p2[2]));
-                length += dist;
-            }
-        }
-        m_FiberLengths.push_back(length);
+    m_MinFiberLength = m_FiberLengths.at(0);
+    m_MaxFiberLength = m_FiberLengths.at(0);
+    for (int i=0; i<m_NumFibers; i++)
+    {
+        float length = m_FiberLengths.at(i);
         m_MeanFiberLength += length;
-        if (i==0)
-        {
+        if (length<m_MinFiberLength)
             m_MinFiberLength = length;
+        if (length>m_MaxFiberLength)
             m_MaxFiberLength = length;
-        }
-        else
-        {
-            if (length<m_MinFiberLength)
-                m_MinFiberLength = length;
-            if (length>m_MaxFiberLength)
-                m_MaxFiberLength = length;
-        }
     }
     m_MeanFiberLength /= m_NumFibers;
 
@@ -1221,6 +1402,15 @@ void mitk::FiberBundleX::SetColorCoding(const char* requestedColorCoding)
     }
 }
 
+void mitk::FiberBundleX::SetFiberParts(const std::vector< FiberColumnStore >& parts)
+{
+    FiberColumnStore fibers;
+    fibers.Concatenate(parts);
+    m_FiberPolyData = fibers.GetPolyData();
+    UpdateFiberGeometry();
+    UpdateColorCoding();
+}
+
 void mitk::FiberBundleX::RotateAroundAxis(double x, double y, double z)
 {
     MITK_INFO << "Rotating fibers";
@@ -1248,117 +1438,48 @@ void mitk::FiberBundleX::RotateAroundAxis(double x, double y, double z)
 
     mitk::Geometry3D::Pointer geom = this->GetGeometry();
     mitk::Point3D center = geom->GetCenter();
+    mitk::Vector3D translation; translation.Fill(0);
 
-    boost::progress_display disp(m_NumFibers);
-
-    vtkSmartPointer<vtkPoints> vtkNewPoints = vtkSmartPointer<vtkPoints>::New();
-    vtkSmartPointer<vtkCellArray> vtkNewCells = vtkSmartPointer<vtkCellArray>::New();
-
-    for (int i=0; i<m_NumFibers; i++)
-    {
-        ++disp ;
-        vtkCell* cell = m_FiberPolyData->GetCell(i);
-        int numPoints = cell->GetNumberOfPoints();
-        vtkPoints* points = cell->GetPoints();
-
-        vtkSmartPointer<vtkPolyLine> container = vtkSmartPointer<vtkPolyLine>::New();
-        for (int j=0; j<numPoints; j++)
-        {
-            double* p = points->GetPoint(j);
-            vnl_vector_fixed< double, 3 > dir;
-            dir[0] = p[0]-center[0];
-            dir[1] = p[1]-center[1];
-            dir[2] = p[2]-center[2];
-            dir = rotZ*rotY*rotX*dir;
-            dir[0] += center[0];
-            dir[1] += center[1];
-            dir[2] += center[2];
-            vtkIdType id = vtkNewPoints->InsertNextPoint(dir.data_block());
-            container->GetPointIds()->InsertNextId(id);
-        }
-        vtkNewCells->InsertNextCell(container);
-    }
-
-    m_FiberPolyData = vtkSmartPointer<vtkPolyData>::New();
-    m_FiberPolyData->SetPoints(vtkNewPoints);
-    m_FiberPolyData->SetLines(vtkNewCells);
-    UpdateColorCoding();
-    UpdateFiberGeometry();
+    unsigned int numThreads = itk::MultiThreader::GetGlobalDefaultNumberOfThreads();
+    TransformProcessor processor(numThreads, rotZ*rotY*rotX, center, translation);
+    m_FiberStore.ProcessFibers(&processor, numThreads);
+    SetFiberParts(processor.m_Parts);
 }
 
 void mitk::FiberBundleX::ScaleFibers(double x, double y, double z)
 {
     MITK_INFO << "Scaling fibers";
-    boost::progress_display disp(m_NumFibers);
 
     mitk::Geometry3D* geom = this->GetGeometry();
     mitk::Point3D c = geom->GetCenter();
+    mitk::Vector3D translation; translation.Fill(0);
 
-    vtkSmartPointer<vtkPoints> vtkNewPoints = vtkSmartPointer<vtkPoints>::New();
-    vtkSmartPointer<vtkCellArray> vtkNewCells = vtkSmartPointer<vtkCellArray>::New();
+    vnl_matrix_fixed< double, 3, 3 > scale; scale.set_identity();
+    scale[0][0] = x;
+    scale[1][1] = y;
+    scale[2][2] = z;
 
-    for (int i=0; i<m_NumFibers; i++)
-    {
-        ++disp ;
-        vtkCell* cell = m_FiberPolyData->GetCell(i);
-        int numPoints = cell->GetNumberOfPoints();
-        vtkPoints* points = cell->GetPoints();
-
-        vtkSmartPointer<vtkPolyLine> container = vtkSmartPointer<vtkPolyLine>::New();
-        for (int j=0; j<numPoints; j++)
-        {
-            double* p = points->GetPoint(j);
-            p[0] -= c[0]; p[1] -= c[1]; p[2] -= c[2];
-            p[0] *= x;
-            p[1] *= y;
-            p[2] *= z;
-            p[0] += c[0]; p[1] += c[1]; p[2] += c[2];
-            vtkIdType id = vtkNewPoints->InsertNextPoint(p);
-            container->GetPointIds()->InsertNextId(id);
-        }
-        vtkNewCells->InsertNextCell(container);
-    }
-
-    m_FiberPolyData = vtkSmartPointer<vtkPolyData>::New();
-    m_FiberPolyData->SetPoints(vtkNewPoints);
-    m_FiberPolyData->SetLines(vtkNewCells);
-    UpdateColorCoding();
-    UpdateFiberGeometry();
+    unsigned int numThreads = itk::MultiThreader::GetGlobalDefaultNumberOfThreads();
+    TransformProcessor processor(numThreads, scale, c, translation);
+    m_FiberStore.ProcessFibers(&processor, numThreads);
+    SetFiberParts(processor.m_Parts);
 }
 
 void mitk::FiberBundleX::TranslateFibers(double x, double y, double z)
 {
     MITK_INFO << "Translating fibers";
-    boost::progress_display disp(m_NumFibers);
 
-    vtkSmartPointer<vtkPoints> vtkNewPoints = vtkSmartPointer<vtkPoints>::New();
-    vtkSmartPointer<vtkCellArray> vtkNewCells = vtkSmartPointer<vtkCellArray>::New();
-
-    for (int i=0; i<m_NumFibers; i++)
-    {
-        ++disp;
-        vtkCell* cell = m_FiberPolyData->GetCell(i);
-        int numPoints = cell->GetNumberOfPoints();
-        vtkPoints* points = cell->GetPoints();
-
-        vtkSmartPointer<vtkPolyLine> container = vtkSmartPointer<vtkPolyLine>::New();
-        for (int j=0; j<numPoints; j++)
-        {
-            double* p = points->GetPoint(j);
-            p[0] += x;
-            p[1] += y;
-            p[2] += z;
-            vtkIdType id = vtkNewPoints->InsertNextPoint(p);
-            container->GetPointIds()->InsertNextId(id);
-        }
-        vtkNewCells->InsertNextCell(container);
-    }
-
-    m_FiberPolyData = vtkSmartPointer<vtkPolyData>::New();
-    m_FiberPolyData->SetPoints(vtkNewPoints);
-    m_FiberPolyData->SetLines(vtkNewCells);
-    UpdateColorCoding();
-    UpdateFiberGeometry();
+    vnl_matrix_fixed< double, 3, 3 > identity; identity.set_identity();
+    mitk::Point3D origin; origin.Fill(0);
+    mitk::Vector3D translation;
+    translation[0] = x;
+    translation[1] = y;
+    translation[2] = z;
+
+    unsigned int numThreads = itk::MultiThreader::GetGlobalDefaultNumberOfThreads();
+    TransformProcessor processor(numThreads, identity, origin, translation);
+    m_FiberStore.ProcessFibers(&processor, numThreads);
+    SetFiberParts(processor.m_Parts);
 }
 
 void mitk::FiberBundleX::MirrorFibers(unsigned int axis)
@@ -1367,34 +1488,16 @@ void mitk::FiberBundleX::MirrorFibers(unsigned int axis)
         return;
 
     MITK_INFO << "Mirroring fibers";
-    boost::progress_display disp(m_NumFibers);
-
-    vtkSmartPointer<vtkPoints> vtkNewPoints = vtkSmartPointer<vtkPoints>::New();
-    vtkSmartPointer<vtkCellArray> vtkNewCells = vtkSmartPointer<vtkCellArray>::New();
 
-    for (int i=0; i<m_NumFibers; i++)
-    {
-        ++disp;
-        vtkCell* cell = m_FiberPolyData->GetCell(i);
-        int numPoints = cell->GetNumberOfPoints();
-        vtkPoints* points = cell->GetPoints();
+    vnl_matrix_fixed< double, 3, 3 > mirror; mirror.set_identity();
+    mirror[axis][axis] = -1;
+    mitk::Point3D origin; origin.Fill(0);
+    mitk::Vector3D translation; translation.Fill(0);
 
-        vtkSmartPointer<vtkPolyLine> container = vtkSmartPointer<vtkPolyLine>::New();
-        for (int j=0; j<numPoints; j++)
-        {
-            double* p = points->GetPoint(j);
-            p[axis] = -p[axis];
-            vtkIdType id = vtkNewPoints->InsertNextPoint(p);
-            container->GetPointIds()->InsertNextId(id);
-        }
-        vtkNewCells->InsertNextCell(container);
-    }
-
-    m_FiberPolyData = vtkSmartPointer<vtkPolyData>::New();
-    m_FiberPolyData->SetPoints(vtkNewPoints);
-    m_FiberPolyData->SetLines(vtkNewCells);
-    UpdateColorCoding();
-    UpdateFiberGeometry();
+    unsigned int numThreads = itk::MultiThreader::GetGlobalDefaultNumberOfThreads();
+    TransformProcessor processor(numThreads, mirror, origin, translation);
+    m_FiberStore.ProcessFibers(&processor, numThreads);
+    SetFiberParts(processor.m_Parts);
 }
 
 bool mitk::FiberBundleX::ApplyCurvatureThreshold(float minRadius, bool deleteFibers)
@@ -1402,80 +1505,18 @@ bool mitk::FiberBundleX::ApplyCurvatureThreshold(float minRadius, bool deleteFib
     if (minRadius<0)
         return true;
 
-    vtkSmartPointer<vtkPoints> vtkNewPoints = vtkSmartPointer<vtkPoints>::New();
-    vtkSmartPointer<vtkCellArray> vtkNewCells = vtkSmartPointer<vtkCellArray>::New();
-
     MITK_INFO << "Applying curvature threshold";
-    boost::progress_display disp(m_FiberPolyData->GetNumberOfCells());
-    for (int i=0; i<m_FiberPolyData->GetNumberOfCells(); i++)
-    {
-        ++disp ;
-        vtkCell* cell = m_FiberPolyData->GetCell(i);
-        int numPoints = cell->GetNumberOfPoints();
-        vtkPoints* points = cell->GetPoints();
-
-        // calculate curvatures
-        vtkSmartPointer<vtkPolyLine> container = vtkSmartPointer<vtkPolyLine>::New();
-        for (int j=0; j<numPoints-2; j++)
-        {
-            double p1[3];
-            points->GetPoint(j, p1);
-            double p2[3];
-            points->GetPoint(j+1, p2);
-            double p3[3];
-            points->GetPoint(j+2, p3);
-
-            vnl_vector_fixed< float, 3 > v1, v2, v3;
-
-            v1[0] = p2[0]-p1[0];
-            v1[1] = p2[1]-p1[1];
-            v1[2] = p2[2]-p1[2];
-
-            v2[0] = p3[0]-p2[0];
-            v2[1] = p3[1]-p2[1];
-            v2[2] = p3[2]-p2[2];
-
-            v3[0] = p1[0]-p3[0];
-            v3[1] = p1[1]-p3[1];
-            v3[2] = p1[2]-p3[2];
-
-            float a = v1.magnitude();
-            float b = v2.magnitude();
-            float c = v3.magnitude();
-            float r = a*b*c/std::sqrt((a+b+c)*(a+b-c)*(b+c-a)*(a-b+c)); // radius of triangle via Heron's formula (area of triangle)
-
-            vtkIdType id = vtkNewPoints->InsertNextPoint(p1);
-            container->GetPointIds()->InsertNextId(id);
-
-            if (deleteFibers && r<minRadius)
-                break;
-
-            if (r<minRadius)
-            {
-                j += 2;
-                vtkNewCells->InsertNextCell(container);
-                container = vtkSmartPointer<vtkPolyLine>::New();
-            }
-            else if (j==numPoints-3)
-            {
-                id = vtkNewPoints->InsertNextPoint(p2);
-                container->GetPointIds()->InsertNextId(id);
-                id = vtkNewPoints->InsertNextPoint(p3);
-                container->GetPointIds()->InsertNextId(id);
-                vtkNewCells->InsertNextCell(container);
-            }
-        }
-    }
-
-    if (vtkNewCells->GetNumberOfCells()<=0)
+    unsigned int numThreads = itk::MultiThreader::GetGlobalDefaultNumberOfThreads();
+    CurvatureProcessor processor(numThreads, minRadius, deleteFibers);
+    m_FiberStore.ProcessFibers(&processor, numThreads);
+
+    unsigned int numNewFibers = 0;
+    for (unsigned int i=0; i<processor.m_Parts.size(); i++)
+        numNewFibers += processor.m_Parts[i].GetNumberOfFibers();
+    if (numNewFibers<=0)
         return false;
 
-    m_FiberPolyData = vtkSmartPointer<vtkPolyData>::New();
-    m_FiberPolyData->SetPoints(vtkNewPoints);
-    m_FiberPolyData->SetLines(vtkNewCells);
-
-    UpdateColorCoding();
-    UpdateFiberGeometry();
+    SetFiberParts(processor.m_Parts);
     return true;
 }
 
@@ -1494,42 +1535,10 @@ bool mitk::FiberBundleX::RemoveShortFibers(float lengthInMM)
         return false;
     }
 
-    vtkSmartPointer<vtkPoints> vtkNewPoints = vtkSmartPointer<vtkPoints>::New();
-    vtkSmartPointer<vtkCellArray> vtkNewCells = vtkSmartPointer<vtkCellArray>::New();
-    float min = m_MaxFiberLength;
-
-    boost::progress_display disp(m_NumFibers);
-    for (int i=0; i<m_NumFibers; i++)
-    {
-        ++disp;
-        vtkCell* cell = m_FiberPolyData->GetCell(i);
-        int numPoints = cell->GetNumberOfPoints();
-        vtkPoints* points = cell->GetPoints();
-
-        if (m_FiberLengths.at(i)>=lengthInMM)
-        {
-            vtkSmartPointer<vtkPolyLine> container = vtkSmartPointer<vtkPolyLine>::New();
-            for (int j=0; j<numPoints; j++)
-            {
-                double* p = points->GetPoint(j);
-                vtkIdType id = vtkNewPoints->InsertNextPoint(p);
-                container->GetPointIds()->InsertNextId(id);
-            }
-            vtkNewCells->InsertNextCell(container);
-            if (m_FiberLengths.at(i)<min)
-                min = m_FiberLengths.at(i);
-        }
-    }
-
-    if (vtkNewCells->GetNumberOfCells()<=0)
-        return false;
-
-    m_FiberPolyData = vtkSmartPointer<vtkPolyData>::New();
-    m_FiberPolyData->SetPoints(vtkNewPoints);
-    m_FiberPolyData->SetLines(vtkNewCells);
-
-    UpdateColorCoding();
-    UpdateFiberGeometry();
+    unsigned int numThreads = itk::MultiThreader::GetGlobalDefaultNumberOfThreads();
+    LengthProcessor processor(numThreads, m_FiberLengths, lengthInMM, itk::NumericTraits<float>::max());
+    m_FiberStore.ProcessFibers(&processor, numThreads);
+    SetFiberParts(processor.m_Parts);
     return true;
 }
 
@@ -1541,39 +1550,11 @@ bool mitk::FiberBundleX::RemoveLongFibers(float lengthInMM)
     if (lengthInMM<m_MinFiberLength)    // can't remove all fibers
         return false;
 
-    vtkSmartPointer<vtkPoints> vtkNewPoints = vtkSmartPointer<vtkPoints>::New();
-    vtkSmartPointer<vtkCellArray> vtkNewCells = vtkSmartPointer<vtkCellArray>::New();
-
     MITK_INFO << "Removing long fibers";
-    boost::progress_display disp(m_NumFibers);
-    for (int i=0; i<m_NumFibers; i++)
-    {
-        ++disp;
-        vtkCell* cell = m_FiberPolyData->GetCell(i);
-        int numPoints = cell->GetNumberOfPoints();
-        vtkPoints* points = cell->GetPoints();
-
-        if (m_FiberLengths.at(i)<=lengthInMM)
-        {
-            vtkSmartPointer<vtkPolyLine> container = vtkSmartPointer<vtkPolyLine>::New();
-            for (int j=0; j<numPoints; j++)
-            {
-                double* p = points->GetPoint(j);
-                vtkIdType id = vtkNewPoints->InsertNextPoint(p);
-                container->GetPointIds()->InsertNextId(id);
-            }
-            vtkNewCells->InsertNextCell(container);
-        }
-    }
-
-    if (vtkNewCells->GetNumberOfCells()<=0)
-        return false;
-
-    m_FiberPolyData = vtkSmartPointer<vtkPolyData>::New();
-    m_FiberPolyData->SetPoints(vtkNewPoints);
-    m_FiberPolyData->SetLines(vtkNewCells);
-    UpdateColorCoding();
-    UpdateFiberGeometry();
+    unsigned int numThreads = itk::MultiThreader::GetGlobalDefaultNumberOfThreads();
+    LengthProcessor processor(numThreads, m_FiberLengths, itk::NumericTraits<float>::NonpositiveMin(), lengthInMM);
+    m_FiberStore.ProcessFibers(&processor, numThreads);
+    SetFiberParts(processor.m_Parts);
     return true;
 }
 
@@ -1582,24 +1563,21 @@ void mitk::FiberBundleX::DoFiberSmoothing(float pointDistance, double tension, d
     if (pointDistance<=0)
         return;
 
-    vtkSmartPointer<vtkPoints> vtkSmoothPoints = vtkSmartPointer<vtkPoints>::New(); //in smoothpoints the interpolated points representing a fiber are stored.
-
-    //in vtkcells all polylines are stored, actually all id's of them are stored
-    vtkSmartPointer<vtkCellArray> vtkSmoothCells = vtkSmartPointer<vtkCellArray>::New(); //cellcontainer for smoothed lines
-    vtkIdType pointHelperCnt = 0;
+    // the VTK spline objects are not shared between fibers but not made for threads either, so this stays sequential
+    std::vector< FiberColumnStore > smoothFibers(1);
 
     MITK_INFO << "Smoothing fibers";
     boost::progress_display disp(m_NumFibers);
+    std::vector<double> smoothPoints;
     for (int i=0; i<m_NumFibers; i++)
     {
         ++disp;
-        vtkCell* cell = m_FiberPolyData->GetCell(i);
-        int numPoints = cell->GetNumberOfPoints();
-        vtkPoints* points = cell->GetPoints();
+        const float* points = m_FiberStore.GetPoints(i);
+        int numPoints = m_FiberStore.GetNumberOfPoints(i);
 
         vtkSmartPointer<vtkPoints> newPoints = vtkSmartPointer<vtkPoints>::New();
         for (int j=0; j<numPoints; j++)
-            newPoints->InsertNextPoint(points->GetPoint(j));
+            newPoints->InsertNextPoint(points+3*j);
 
         float length = m_FiberLengths.at(i);
         int sampling = std::ceil(length/pointDistance);
@@ -1627,23 +1605,15 @@ void mitk::FiberBundleX::DoFiberSmoothing(float pointDistance, double tension, d
         vtkPolyData* outputFunction = functionSource->GetOutput();
         vtkPoints* tmpSmoothPnts = outputFunction->GetPoints(); //smoothPoints of current fiber
 
-        vtkSmartPointer<vtkPolyLine> smoothLine = vtkSmartPointer<vtkPolyLine>::New();
-        smoothLine->GetPointIds()->SetNumberOfIds(tmpSmoothPnts->GetNumberOfPoints());
-
-        for (int j=0; j<smoothLine->GetNumberOfPoints(); j++)
-        {
-            smoothLine->GetPointIds()->SetId(j, j+pointHelperCnt);
-            vtkSmoothPoints->InsertNextPoint(tmpSmoothPnts->GetPoint(j));
-        }
-        vtkSmoothCells->InsertNextCell(smoothLine);
-        pointHelperCnt += tmpSmoothPnts->GetNumberOfPoints();
+        vtkIdType numSmoothPoints = tmpSmoothPnts->GetNumberOfPoints();
+        smoothPoints.resize(3*numSmoothPoints);
+        for (vtkIdType j=0; j<numSmoothPoints; j++)
+            tmpSmoothPnts->GetPoint(j, &smoothPoints[3*j]);
+        if (numSmoothPoints>0)
+            smoothFibers[0].AddFiber(&smoothPoints[0], numSmoothPoints);
     }
 
-    m_FiberPolyData = vtkSmartPointer<vtkPolyData>::New();
-    m_FiberPolyData->SetPoints(vtkSmoothPoints);
-    m_FiberPolyData->SetLines(vtkSmoothCells);
-    UpdateColorCoding();
-    UpdateFiberGeometry();
+    SetFiberParts(smoothFibers);
     m_FiberSampling = 10/pointDistance;
 }
 
@@ -1658,83 +1628,11 @@ void mitk::FiberBundleX::ResampleFibers(float pointDistance)
     if (pointDistance<=0.00001)
         return;
 
-    vtkSmartPointer<vtkPolyData> newPoly = vtkSmartPointer<vtkPolyData>::New();
-    vtkSmartPointer<vtkCellArray> newCellArray = vtkSmartPointer<vtkCellArray>::New();
-    vtkSmartPointer<vtkPoints>    newPoints = vtkSmartPointer<vtkPoints>::New();
-
-    int numberOfLines = m_NumFibers;
-
     MITK_INFO << "Resampling fibers";
-    boost::progress_display disp(m_NumFibers);
-    for (int i=0; i<numberOfLines; i++)
-    {
-        ++disp;
-        vtkCell* cell = m_FiberPolyData->GetCell(i);
-        int numPoints = cell->GetNumberOfPoints();
-        vtkPoints* points = cell->GetPoints();
-
-        vtkSmartPointer<vtkPolyLine> container = vtkSmartPointer<vtkPolyLine>::New();
-
-        double* point = points->GetPoint(0);
-        vtkIdType pointId = newPoints->InsertNextPoint(point);
-        container->GetPointIds()->InsertNextId(pointId);
-
-        float dtau = 0;
-        int cur_p = 1;
-        itk::Vector<float,3> dR;
-        float normdR = 0;
-
-        for (;;)
-        {
-            while (dtau <= pointDistance && cur_p < numPoints)
-            {
-                itk::Vector<float,3> v1;
-                point = points->GetPoint(cur_p-1);
-                v1[0] = point[0];
-                v1[1] = point[1];
-                v1[2] = point[2];
-                itk::Vector<float,3> v2;
-                point = points->GetPoint(cur_p);
-                v2[0] = point[0];
-                v2[1] = point[1];
-                v2[2] = point[2];
-
-                dR  = v2 - v1;
-                normdR = std::sqrt(dR.GetSquaredNorm());
-                dtau += normdR;
-                cur_p++;
-            }
-
-            if (dtau >= pointDistance)
-            {
-                itk::Vector<float,3> v1;
-                point = points->GetPoint(cur_p-1);
-                v1[0] = point[0];
-                v1[1] = point[1];
-                v1[2] = point[2];
-
-                itk::Vector<float,3> v2 = v1 - dR*( (dtau-pointDistance)/normdR );
-                pointId = newPoints->InsertNextPoint(v2.GetDataPointer());
-                container->GetPointIds()->InsertNextId(pointId);
-            }
-            else
-            {
-                point = points->GetPoint(numPoints-1);
-                pointId = newPoints->InsertNextPoint(point);
-                container->GetPointIds()->InsertNextId(pointId);
-                break;
-            }
-            dtau = dtau-pointDistance;
-        }
-
-        newCellArray->InsertNextCell(container);
-    }
-
-    newPoly->SetPoints(newPoints);
-    newPoly->SetLines(newCellArray);
-    m_FiberPolyData = newPoly;
-    UpdateFiberGeometry();
-    UpdateColorCoding();
+    unsigned int numThreads = itk::MultiThreader::GetGlobalDefaultNumberOfThreads();
+    ResampleProcessor processor(numThreads, pointDistance);
+    m_FiberStore.ProcessFibers(&processor, numThreads);
+    SetFiberParts(processor.m_Parts);
     m_FiberSampling = 10/pointDistance;
 }
 
@@ -33,6 +33,11 @@ See LICENSE.txt or http://www.mitk.org for details.
 //#include <QStringList>
 
 #include <mitkPlanarFigure.h>
+#include "mitkFiberBitmap.h"
+#include "mitkFiberSpatialIndex.h"
+#include "mitkFiberColumnStore.h"
+
+#include <map>
 
 namespace mitk {
 
@@ -96,6 +101,7 @@ public:
     // get/set data
     void SetFiberPolyData(vtkSmartPointer<vtkPolyData>, bool updateGeometry = true);
     vtkSmartPointer<vtkPolyData> GetFiberPolyData();
+    const FiberColumnStore& GetFiberColumnStore() const { return m_FiberStore; }  ///< float coordinates of all fibers, shared with GetFiberPolyData()
     std::vector< std::string > GetAvailableColorCodings();
     char* GetCurrentColorCoding();
     itkGetMacro( NumFibers, int)
@@ -106,11 +112,6 @@ public:
     itkGetMacro( MedianFiberLength, float )
     itkGetMacro( LengthStDev, float )
 
-    std::vector<int> GetPointsRoi()
-    {
-        return m_PointsRoi;
-    }
-
     // copy fiber bundle
     mitk::FiberBundleX::Pointer GetDeepCopy();
 
@@ -130,11 +131,26 @@ protected:
     // calculate colorcoding values according to m_CurrentColorCoding
     void UpdateColorCoding();
 
+    // replace the fibers by the concatenated parts and update geometry and colorcoding
+    void SetFiberParts(const std::vector< FiberColumnStore >& parts);
+
+    // rebuild the spatial index if the fibers changed since it was built
+    void UpdateSpatialIndex();
+
+    // fibers selected by a planar figure or by a composite of planar figures
+    void ExtractFiberBitmap(PlanarFigure* pf, FiberBitmap& fibers);
+
+    // fibers selected by a planar figure which is no composite, cached per figure
+    void ExtractFiberBitmapOfFigure(PlanarFigure* pf, FiberBitmap& fibers);
+
 private:
 
     // actual fiber container
     vtkSmartPointer<vtkPolyData>  m_FiberPolyData;
 
+    // points of m_FiberPolyData, shares the coordinate array with it
+    FiberColumnStore              m_FiberStore;
+
     // contains fiber ids
     vtkSmartPointer<vtkDataSet>   m_FiberIdDataSet;
 
@@ -149,7 +165,16 @@ private:
     float   m_LengthStDev;
     int     m_FiberSampling;
 
-    std::vector<int> m_PointsRoi; // this global variable needs to be refactored
+    // ROI selection
+    FiberSpatialIndex m_SpatialIndex;
+
+    struct RoiCacheEntry
+    {
+        std::string             m_Type;         // class of the planar figure
+        std::vector<double>     m_Parameters;   // plane and control points the result was computed for
+        FiberBitmap             m_Fibers;
+    };
+    std::map< const PlanarFigure*, RoiCacheEntry > m_RoiCache;
 
 };
 
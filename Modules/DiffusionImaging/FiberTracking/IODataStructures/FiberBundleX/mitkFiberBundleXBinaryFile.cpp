@@ -0,0 +1,375 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkFiberBundleXBinaryFile.h"
+
+#include <mitkException.h>
+
+#include <itkByteSwapper.h>
+#include <itkNumericTraits.h>
+
+#include <vtkFloatArray.h>
+#include <vtkObjectFactory.h>
+
+#include <itksys/SystemTools.hxx>
+
+#include <cstring>
+
+const char* const mitk::FiberBundleXBinaryFormat::FileMagic = "MITKFIBB";
+
+namespace
+{
+
+// float array using the points of a memory mapped file, keeps the mapping alive as long as the array exists
+class MappedFloatArray : public vtkFloatArray
+{
+public:
+
+    static MappedFloatArray* New();
+    vtkTypeMacro(MappedFloatArray, vtkFloatArray);
+
+    void SetMapping(mitk::MemoryMappedFile* file, const float* points, vtkIdType numPoints)
+    {
+        m_File = file;
+        this->SetNumberOfComponents(3);
+        // save=1: the array does not own the memory, it is released by the mapping
+        this->SetArray(const_cast<float*>(points), 3*numPoints, 1);
+    }
+
+protected:
+
+    MappedFloatArray() {}
+    ~MappedFloatArray() {}
+
+    mitk::MemoryMappedFile::Pointer m_File;
+
+private:
+
+    MappedFloatArray(const MappedFloatArray&);  // not implemented
+    void operator=(const MappedFloatArray&);    // not implemented
+};
+
+vtkStandardNewMacro(MappedFloatArray);
+
+struct Header
+{
+    itk::uint32_t   m_Version;
+    itk::uint32_t   m_Flags;
+    itk::uint64_t   m_NumberOfFibers;
+    itk::uint64_t   m_NumberOfPoints;
+    itk::uint64_t   m_OffsetsPosition;
+    float           m_Bounds[6];
+};
+
+// little endian values at fixed positions, independent of the struct layout of the compiler
+template< class T >
+void WriteValues(char* buffer, const T* values, unsigned int count)
+{
+    memcpy(buffer, values, count*sizeof(T));
+    itk::ByteSwapper<T>::SwapRangeFromSystemToLittleEndian(reinterpret_cast<T*>(buffer), count);
+}
+
+template< class T >
+void ReadValues(const char* buffer, T* values, unsigned int count)
+{
+    memcpy(values, buffer, count*sizeof(T));
+    itk::ByteSwapper<T>::SwapRangeFromSystemToLittleEndian(values, count);
+}
+
+void EncodeHeader(const Header& header, char buffer[mitk::FiberBundleXBinaryFormat::HeaderSize])
+{
+    memset(buffer, 0, mitk::FiberBundleXBinaryFormat::HeaderSize);
+    memcpy(buffer, mitk::FiberBundleXBinaryFormat::FileMagic, 8);
+    WriteValues(buffer+8, &header.m_Version, 1);
+    WriteValues(buffer+12, &header.m_Flags, 1);
+    WriteValues(buffer+16, &header.m_NumberOfFibers, 1);
+    WriteValues(buffer+24, &header.m_NumberOfPoints, 1);
+    WriteValues(buffer+32, &header.m_OffsetsPosition, 1);
+    WriteValues(buffer+40, header.m_Bounds, 6);
+}
+
+bool DecodeHeader(const char* buffer, Header& header)
+{
+    if (memcmp(buffer, mitk::FiberBundleXBinaryFormat::FileMagic, 8)!=0)
+        return false;
+    ReadValues(buffer+8, &header.m_Version, 1);
+    ReadValues(buffer+12, &header.m_Flags, 1);
+    ReadValues(buffer+16, &header.m_NumberOfFibers, 1);
+    ReadValues(buffer+24, &header.m_NumberOfPoints, 1);
+    ReadValues(buffer+32, &header.m_OffsetsPosition, 1);
+    ReadValues(buffer+40, header.m_Bounds, 6);
+    return true;
+}
+
+// the fiber offsets start at the first multiple of 8 after the points
+itk::uint64_t GetOffsetsPosition(itk::uint64_t numPoints)
+{
+    itk::uint64_t end = mitk::FiberBundleXBinaryFormat::HeaderSize + 12*numPoints;
+    return (end+7)/8*8;
+}
+
+}
+
+mitk::FiberBundleXBinaryWriter::FiberBundleXBinaryWriter()
+    : m_Offsets(1, 0)
+{
+}
+
+mitk::FiberBundleXBinaryWriter::~FiberBundleXBinaryWriter()
+{
+    if (IsOpen())
+    {
+        try
+        {
+            Close();
+        }
+        catch (mitk::Exception& e)
+        {
+            MITK_ERROR << e.GetDescription();
+        }
+    }
+}
+
+void mitk::FiberBundleXBinaryWriter::Write(const std::string& fileName, const FiberColumnStore& fibers)
+{
+    FiberBundleXBinaryWriter::Pointer writer = FiberBundleXBinaryWriter::New();
+    writer->Open(fileName);
+    for (unsigned int i=0; i<fibers.GetNumberOfFibers(); i++)
+        writer->AddFiber(fibers.GetPoints(i), fibers.GetNumberOfPoints(i));
+    writer->Close();
+}
+
+void mitk::FiberBundleXBinaryWriter::Open(const std::string& fileName)
+{
+    if (IsOpen())
+        mitkThrow() << "FiberBundleXBinaryWriter: " << m_FileName << " is still open";
+
+    // the fibers may be read from a mapping of fileName, it is replaced only by the complete file in Close()
+    std::string temporaryFileName = fileName + ".part";
+    m_Stream.open(temporaryFileName.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!m_Stream.is_open())
+        mitkThrow() << "Could not open file " << temporaryFileName << " for writing";
+    m_FileName = fileName;
+    m_TemporaryFileName = temporaryFileName;
+    m_Offsets.assign(1, 0);
+    for (int i=0; i<6; i+=2)
+    {
+        m_Bounds[i] = itk::NumericTraits<float>::max();
+        m_Bounds[i+1] = itk::NumericTraits<float>::NonpositiveMin();
+    }
+
+    // the header of an unfinished file has no fiber offsets
+    Header header;
+    memset(&header, 0, sizeof(header));
+    header.m_Version = FiberBundleXBinaryFormat::Version;
+    char buffer[FiberBundleXBinaryFormat::HeaderSize];
+    EncodeHeader(header, buffer);
+    m_Stream.write(buffer, FiberBundleXBinaryFormat::HeaderSize);
+}
+
+void mitk::FiberBundleXBinaryWriter::AddFiber(const float* points, unsigned int numPoints)
+{
+    if (numPoints<2)
+        return;
+    m_Mutex.Lock();
+    m_Buffer.assign(points, points+3*numPoints);
+    WriteBuffer();
+    m_Mutex.Unlock();
+}
+
+void mitk::FiberBundleXBinaryWriter::AddFiber(const double* points, unsigned int numPoints)
+{
+    if (numPoints<2)
+        return;
+    m_Mutex.Lock();
+    m_Buffer.assign(points, points+3*numPoints);
+    WriteBuffer();
+    m_Mutex.Unlock();
+}
+
+void mitk::FiberBundleXBinaryWriter::WriteBuffer()
+{
+    if (!IsOpen())
+        return;
+
+    for (unsigned int i=0; i<m_Buffer.size(); i++)
+    {
+        int k = i%3;
+        if (m_Buffer[i]<m_Bounds[2*k])
+            m_Bounds[2*k] = m_Buffer[i];
+        if (m_Buffer[i]>m_Bounds[2*k+1])
+            m_Bounds[2*k+1] = m_Buffer[i];
+    }
+
+    itk::ByteSwapper<float>::SwapRangeFromSystemToLittleEndian(&m_Buffer[0], m_Buffer.size());
+    m_Stream.write(reinterpret_cast<const char*>(&m_Buffer[0]), m_Buffer.size()*sizeof(float));
+    m_Offsets.push_back(m_Offsets.back()+m_Buffer.size()/3);
+}
+
+void mitk::FiberBundleXBinaryWriter::Close()
+{
+    if (!IsOpen())
+        return;
+
+    Header header;
+    header.m_Version = FiberBundleXBinaryFormat::Version;
+    header.m_Flags = 0;
+    header.m_NumberOfFibers = GetNumberOfFibers();
+    header.m_NumberOfPoints = m_Offsets.back();
+    header.m_OffsetsPosition = GetOffsetsPosition(m_Offsets.back());
+    for (int i=0; i<6; i++)
+        header.m_Bounds[i] = header.m_NumberOfPoints>0 ? m_Bounds[i] : 0;
+
+    const char padding[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+    itk::uint64_t end = FiberBundleXBinaryFormat::HeaderSize + 12*header.m_NumberOfPoints;
+    m_Stream.write(padding, header.m_OffsetsPosition-end);
+
+    std::vector<char> offsets(8*m_Offsets.size());
+    WriteValues(&offsets[0], &m_Offsets[0], m_Offsets.size());
+    m_Stream.write(&offsets[0], offsets.size());
+
+    char buffer[FiberBundleXBinaryFormat::HeaderSize];
+    EncodeHeader(header, buffer);
+    m_Stream.seekp(0);
+    m_Stream.write(buffer, FiberBundleXBinaryFormat::HeaderSize);
+
+    bool failed = !m_Stream.good();
+    m_Stream.close();
+    if (failed)
+    {
+        itksys::SystemTools::RemoveFile(m_TemporaryFileName.c_str());
+        mitkThrow() << "Could not write fiber bundle " << m_FileName;
+    }
+
+    // rename replaces an existing file on POSIX systems, on Windows it has to be removed first
+    if (!itksys::SystemTools::RenameFile(m_TemporaryFileName.c_str(), m_FileName.c_str()))
+    {
+        itksys::SystemTools::RemoveFile(m_FileName.c_str());
+        if (!itksys::SystemTools::RenameFile(m_TemporaryFileName.c_str(), m_FileName.c_str()))
+            mitkThrow() << "Could not replace " << m_FileName << " by " << m_TemporaryFileName;
+    }
+}
+
+mitk::FiberBundleXBinaryReader::FiberBundleXBinaryReader()
+{
+}
+
+mitk::FiberBundleXBinaryReader::~FiberBundleXBinaryReader()
+{
+}
+
+bool mitk::FiberBundleXBinaryReader::IsBinaryFiberBundle(const std::string& fileName)
+{
+    std::ifstream file(fileName.c_str(), std::ios::in | std::ios::binary);
+    char magic[8];
+    if (!file.read(magic, 8))
+        return false;
+    return memcmp(magic, FiberBundleXBinaryFormat::FileMagic, 8)==0;
+}
+
+void mitk::FiberBundleXBinaryReader::Open(const std::string& fileName)
+{
+    Close();
+
+    size_t fileSize = MemoryMappedFile::GetFileSize(fileName);
+    if (fileSize<FiberBundleXBinaryFormat::HeaderSize)
+        mitkThrow() << fileName << " is not a binary fiber bundle";
+
+    MemoryMappedFile::Pointer file = MemoryMappedFile::New(fileName, 0, fileSize);
+    const char* data = static_cast<const char*>(file->GetData());
+
+    Header header;
+    if (!DecodeHeader(data, header))
+        mitkThrow() << fileName << " is not a binary fiber bundle";
+    if (header.m_Version>FiberBundleXBinaryFormat::Version)
+        mitkThrow() << fileName << " has the unsupported version " << header.m_Version;
+    if (header.m_OffsetsPosition==0)
+        mitkThrow() << fileName << " was not closed after writing";
+    if (header.m_NumberOfPoints>fileSize/12 || header.m_OffsetsPosition!=GetOffsetsPosition(header.m_NumberOfPoints)
+            || header.m_OffsetsPosition>fileSize || header.m_NumberOfFibers>=(fileSize-header.m_OffsetsPosition)/8)
+        mitkThrow() << fileName << " is truncated or corrupt";
+
+    std::vector<itk::uint64_t> offsets(header.m_NumberOfFibers+1);
+    ReadValues(data+header.m_OffsetsPosition, &offsets[0], offsets.size());
+    if (offsets.front()!=0 || offsets.back()!=header.m_NumberOfPoints)
+        mitkThrow() << fileName << " has invalid fiber offsets";
+
+    m_Offsets.resize(offsets.size());
+    for (unsigned int i=0; i<offsets.size(); i++)
+    {
+        if (i>0 && offsets[i]<offsets[i-1]+2)
+        {
+            m_Offsets.clear();
+            mitkThrow() << fileName << " has invalid fiber offsets";
+        }
+        m_Offsets[i] = offsets[i];
+    }
+    m_File = file;
+}
+
+void mitk::FiberBundleXBinaryReader::Close()
+{
+    m_File = NULL;
+    m_Offsets.clear();
+}
+
+const float* mitk::FiberBundleXBinaryReader::GetPoints() const
+{
+    return reinterpret_cast<const float*>(static_cast<const char*>(m_File->GetData())+FiberBundleXBinaryFormat::HeaderSize);
+}
+
+vtkSmartPointer<vtkPolyData> mitk::FiberBundleXBinaryReader::Read()
+{
+    FiberColumnStore fibers;
+    if (m_File.IsNull() || GetNumberOfPoints()==0)
+        return fibers.GetPolyData();
+
+    if (itk::ByteSwapper<float>::SystemIsBigEndian())
+    {
+        vtkSmartPointer<vtkFloatArray> points = vtkSmartPointer<vtkFloatArray>::New();
+        points->SetNumberOfComponents(3);
+        points->SetNumberOfTuples(GetNumberOfPoints());
+        ReadValues(reinterpret_cast<const char*>(GetPoints()), points->GetPointer(0), 3*GetNumberOfPoints());
+        fibers.SetFibers(points, m_Offsets);
+    }
+    else
+    {
+        vtkSmartPointer<MappedFloatArray> points = vtkSmartPointer<MappedFloatArray>::New();
+        points->SetMapping(m_File, GetPoints(), GetNumberOfPoints());
+        fibers.SetFibers(points, m_Offsets);
+    }
+    return fibers.GetPolyData();
+}
+
+vtkSmartPointer<vtkPolyData> mitk::FiberBundleXBinaryReader::ReadPreview(unsigned int maxNumberOfFibers)
+{
+    FiberColumnStore fibers;
+    unsigned int numFibers = GetNumberOfFibers();
+    if (m_File.IsNull() || maxNumberOfFibers==0)
+        return fibers.GetPolyData();
+
+    // only the pages of the selected fibers are read from the file
+    const float* points = GetPoints();
+    std::vector<float> fiber;
+    unsigned int step = (numFibers+maxNumberOfFibers-1)/maxNumberOfFibers;
+    for (unsigned int i=0; i<numFibers; i+=step)
+    {
+        fiber.resize(3*(m_Offsets[i+1]-m_Offsets[i]));
+        ReadValues(reinterpret_cast<const char*>(points+3*m_Offsets[i]), &fiber[0], fiber.size());
+        fibers.AddFiber(&fiber[0], fiber.size()/3);
+    }
+    return fibers.GetPolyData();
+}
@@ -0,0 +1,158 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#ifndef _MITK_FiberBundleXBinaryFile_H
+#define _MITK_FiberBundleXBinaryFile_H
+
+#include "FiberTrackingExports.h"
+#include "mitkFiberColumnStore.h"
+
+#include <mitkCommon.h>
+#include <mitkMemoryMappedFile.h>
+
+#include <itkObject.h>
+#include <itkObjectFactory.h>
+#include <itkSimpleFastMutexLock.h>
+#include <itkIntTypes.h>
+
+#include <vtkSmartPointer.h>
+#include <vtkPolyData.h>
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace mitk {
+
+/**
+  * \brief Layout of the binary fiber bundle format (*.fbin), see FiberBundleXBinaryWriter and FiberBundleXBinaryReader.
+  *
+  * Header (64 bytes): "MITKFIBB", version (uint32), flags (uint32, 0), number of fibers (uint64), number of points
+  * (uint64), file position of the fiber offsets (uint64), bounds of all points (6 float: xmin xmax ymin ymax zmin zmax).
+  *
+  * Points: x y z (float) of all points, fiber after fiber, starting directly after the header. This is the layout of
+  * FiberColumnStore, so the points can be used from a memory mapping of the file without reading them.
+  *
+  * Fiber offsets: number of fibers + 1 values (uint64), the index of the first point of each fiber followed by the
+  * number of points. They start at the first multiple of 8 after the points and are written last, so a writer does
+  * not need to know the number of fibers in advance.
+  *
+  * All values are stored in little endian byte order. A file with fiber offset position 0 was not closed.
+  */
+struct FiberBundleXBinaryFormat
+{
+    static const char* const FileMagic;
+    static const unsigned int Version = 1;
+    static const unsigned int HeaderSize = 64;
+};
+
+/**
+  * \brief Writes fibers into a binary fiber bundle file (see FiberBundleXBinaryFormat) while they are generated.
+  *
+  * AddFiber() writes the points of the fiber to the file immediately, only the offset of each fiber (8 bytes) is
+  * kept until Close(). The tracking filters use this to write their result without building a vtkPolyData of all
+  * fibers. AddFiber() may be called from several threads, each fiber is written as a whole.
+  *
+  * The fibers are written to fileName.part, Close() renames it to fileName. An existing file is therefore kept
+  * until the new one is complete, which also allows to write fibers that are mapped from fileName itself.
+  */
+class FiberTracking_EXPORT FiberBundleXBinaryWriter : public itk::Object
+{
+public:
+
+    mitkClassMacro( FiberBundleXBinaryWriter, itk::Object )
+    itkNewMacro( Self )
+
+    /** \brief Writes the whole fiber bundle to fileName. @throw mitk::Exception if the file cannot be written. */
+    static void Write(const std::string& fileName, const FiberColumnStore& fibers);
+
+    /** \brief Creates the file and writes a preliminary header. @throw mitk::Exception if the file cannot be created. */
+    void Open(const std::string& fileName);
+
+    /** \brief Appends a fiber, points are given as x0 y0 z0 x1 y1 z1 ... Fibers with less than two points are skipped. */
+    void AddFiber(const float* points, unsigned int numPoints);
+    void AddFiber(const double* points, unsigned int numPoints);
+
+    /** \brief Writes the fiber offsets and the final header, closes the file and moves it to the file name given to Open(). @throw mitk::Exception if writing failed. */
+    void Close();
+
+    bool IsOpen() { return m_Stream.is_open(); }
+    /** \brief Number of fibers written since Open(), still valid after Close(). */
+    unsigned int GetNumberOfFibers() const { return m_Offsets.size()-1; }
+
+protected:
+
+    FiberBundleXBinaryWriter();
+    virtual ~FiberBundleXBinaryWriter();
+
+    /** \brief Writes the points in m_Buffer as the next fiber, m_Mutex has to be locked. */
+    void WriteBuffer();
+
+    std::ofstream               m_Stream;
+    std::string                 m_FileName;
+    std::string                 m_TemporaryFileName;    ///< file written until Close()
+    std::vector<itk::uint64_t>  m_Offsets;      ///< first point of each fiber and the number of points written so far
+    float                       m_Bounds[6];
+    std::vector<float>          m_Buffer;       ///< points of the fiber which is written
+    itk::SimpleFastMutexLock    m_Mutex;
+};
+
+/**
+  * \brief Reads binary fiber bundle files (see FiberBundleXBinaryFormat) through a memory mapping.
+  *
+  * Read() returns a vtkPolyData whose point array uses the mapped file directly (on little endian systems), the
+  * points are read from disk when they are used for the first time. FiberBundleX takes this array without copying.
+  * ReadPreview() copies every n-th fiber only, which allows to show a large tractogram before all of it is loaded.
+  */
+class FiberTracking_EXPORT FiberBundleXBinaryReader : public itk::Object
+{
+public:
+
+    mitkClassMacro( FiberBundleXBinaryReader, itk::Object )
+    itkNewMacro( Self )
+
+    /** \brief Returns true if the file starts with the magic number of the binary fiber bundle format. */
+    static bool IsBinaryFiberBundle(const std::string& fileName);
+
+    /** \brief Maps the file and reads header and fiber offsets. @throw mitk::Exception if the file is not a valid binary fiber bundle. */
+    void Open(const std::string& fileName);
+
+    /** \brief Releases the mapping. Polydata returned by Read() keep it alive as long as they use it. */
+    void Close();
+
+    unsigned int GetNumberOfFibers() const { return m_Offsets.empty() ? 0 : m_Offsets.size()-1; }
+    vtkIdType GetNumberOfPoints() const { return m_Offsets.empty() ? 0 : m_Offsets.back(); }
+
+    /** \brief All fibers, as one line per fiber. */
+    vtkSmartPointer<vtkPolyData> Read();
+
+    /** \brief At most maxNumberOfFibers fibers, evenly distributed over the file. */
+    vtkSmartPointer<vtkPolyData> ReadPreview(unsigned int maxNumberOfFibers);
+
+protected:
+
+    FiberBundleXBinaryReader();
+    virtual ~FiberBundleXBinaryReader();
+
+    const float* GetPoints() const;
+
+    MemoryMappedFile::Pointer   m_File;
+    std::vector<vtkIdType>      m_Offsets;      ///< number of fibers + 1 entries, the last is the number of points
+};
+
+} // namespace mitk
+
+#endif /*  _MITK_FiberBundleXBinaryFile_H */
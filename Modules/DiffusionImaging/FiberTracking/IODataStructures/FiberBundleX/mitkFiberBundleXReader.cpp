@@ -15,6 +15,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 ===================================================================*/
 
 #include "mitkFiberBundleXReader.h"
+#include "mitkFiberBundleXBinaryFile.h"
 #include <itkMetaDataObject.h>
 #include <vtkPolyData.h>
 #include <vtkDataReader.h>
@@ -61,7 +62,14 @@ namespace mitk
 
       vtkSmartPointer<vtkDataReader> chooser=vtkSmartPointer<vtkDataReader>::New();
       chooser->SetFileName(m_FileName.c_str() );
-      if( chooser->IsFilePolyData())
+      if (FiberBundleXBinaryReader::IsBinaryFiberBundle(m_FileName))
+      {
+        MITK_INFO << "Reading binary fiber bundle";
+        FiberBundleXBinaryReader::Pointer reader = FiberBundleXBinaryReader::New();
+        reader->Open(m_FileName);
+        m_OutputCache = OutputType::New(reader->Read());
+      }
+      else if( chooser->IsFilePolyData())
       {
         MITK_INFO << "Reading vtk fiber bundle";
         vtkSmartPointer<vtkPolyDataReader> reader = vtkSmartPointer<vtkPolyDataReader>::New();
@@ -270,7 +278,7 @@ namespace mitk
     std::string ext = itksys::SystemTools::GetFilenameLastExtension(filename);
     ext = itksys::SystemTools::LowerCase(ext);
 
-    if (ext == ".fib")
+    if (ext == ".fib" || ext == ".fbin")
     {
       return true;
     }
@@ -15,6 +15,8 @@ See LICENSE.txt or http://www.mitk.org for details.
 ===================================================================*/
 
 #include "mitkFiberBundleXWriter.h"
+#include "mitkFiberBundleXBinaryFile.h"
+#include <itksys/SystemTools.hxx>
 #include <vtkSmartPointer.h>
 #include <vtkCleanPolyData.h>
 
@@ -50,11 +52,19 @@ void mitk::FiberBundleXWriter::GenerateData()
         itkWarningMacro( << "Sorry, filename has not been set!" );
         return ;
     }
-    vtkSmartPointer<vtkPolyDataWriter> writer = vtkSmartPointer<vtkPolyDataWriter>::New();
-    writer->SetInput(input->GetFiberPolyData());
-    writer->SetFileName(m_FileName.c_str());
-    writer->SetFileTypeToASCII();
-    writer->Write();
+    std::string ext = itksys::SystemTools::LowerCase(itksys::SystemTools::GetFilenameLastExtension(m_FileName));
+    if (ext == ".fbin")
+    {
+        FiberBundleXBinaryWriter::Write(m_FileName, input->GetFiberColumnStore());
+    }
+    else
+    {
+        vtkSmartPointer<vtkPolyDataWriter> writer = vtkSmartPointer<vtkPolyDataWriter>::New();
+        writer->SetInput(input->GetFiberPolyData());
+        writer->SetFileName(m_FileName.c_str());
+        writer->SetFileTypeToASCII();
+        writer->Write();
+    }
 
     setlocale(LC_ALL, currLocale.c_str());
     m_Success = true;
@@ -91,5 +101,6 @@ std::vector<std::string> mitk::FiberBundleXWriter::GetPossibleFileExtensions()
   std::vector<std::string> possibleFileExtensions;
   possibleFileExtensions.push_back(".fib");
   possibleFileExtensions.push_back(".vtk");
+  possibleFileExtensions.push_back(".fbin");
   return possibleFileExtensions;
 }
@@ -0,0 +1,240 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkFiberColumnStore.h"
+
+#include <itkMultiThreader.h>
+#include <itkIntTypes.h>
+
+#include <vtkCellArray.h>
+#include <vtkCellData.h>
+#include <vtkIdTypeArray.h>
+#include <vtkPointData.h>
+#include <vtkPoints.h>
+
+#include <cstring>
+
+namespace
+{
+
+struct ProcessFibersData
+{
+    const mitk::FiberColumnStore*           m_Store;
+    mitk::FiberColumnStore::FiberProcessor* m_Processor;
+};
+
+ITK_THREAD_RETURN_TYPE ProcessFibersThread(void* pInfoStruct)
+{
+    itk::MultiThreader::ThreadInfoStruct* pInfo = static_cast<itk::MultiThreader::ThreadInfoStruct*>(pInfoStruct);
+    ProcessFibersData* data = static_cast<ProcessFibersData*>(pInfo->UserData);
+
+    itk::uint64_t numFibers = data->m_Store->GetNumberOfFibers();
+    unsigned int firstFiber = numFibers*pInfo->ThreadID/pInfo->NumberOfThreads;
+    unsigned int lastFiber = numFibers*(pInfo->ThreadID+1)/pInfo->NumberOfThreads;
+    data->m_Processor->ProcessFibers(*data->m_Store, firstFiber, lastFiber, pInfo->ThreadID);
+    return ITK_THREAD_RETURN_VALUE;
+}
+
+}
+
+mitk::FiberColumnStore::FiberColumnStore()
+{
+    Clear();
+}
+
+void mitk::FiberColumnStore::Clear()
+{
+    m_Points = vtkSmartPointer<vtkFloatArray>::New();
+    m_Points->SetNumberOfComponents(3);
+    m_Coordinates = m_Points->GetPointer(0);
+    m_Offsets.assign(1, 0);
+}
+
+float* mitk::FiberColumnStore::ReservePoints(unsigned int numPoints)
+{
+    // the array may be shared with a polydata created by GetPolyData(), which must not change
+    if (m_Points->GetReferenceCount()>1)
+    {
+        vtkSmartPointer<vtkFloatArray> copy = vtkSmartPointer<vtkFloatArray>::New();
+        copy->DeepCopy(m_Points);
+        m_Points = copy;
+    }
+    float* coordinates = m_Points->WritePointer(3*m_Offsets.back(), 3*numPoints);
+    m_Coordinates = m_Points->GetPointer(0);
+    return coordinates;
+}
+
+void mitk::FiberColumnStore::AddFiber(const float* points, unsigned int numPoints)
+{
+    float* coordinates = ReservePoints(numPoints);
+    if (numPoints>0)
+        memcpy(coordinates, points, 3*numPoints*sizeof(float));
+    m_Offsets.push_back(m_Offsets.back()+numPoints);
+}
+
+void mitk::FiberColumnStore::AddFiber(const double* points, unsigned int numPoints)
+{
+    float* coordinates = ReservePoints(numPoints);
+    for (unsigned int i=0; i<3*numPoints; i++)
+        coordinates[i] = points[i];
+    m_Offsets.push_back(m_Offsets.back()+numPoints);
+}
+
+void mitk::FiberColumnStore::SetFibers(vtkFloatArray* points, const std::vector<vtkIdType>& offsets)
+{
+    m_Points = points;
+    m_Coordinates = m_Points->GetPointer(0);
+    m_Offsets = offsets;
+}
+
+void mitk::FiberColumnStore::Concatenate(const std::vector< FiberColumnStore >& parts)
+{
+    vtkIdType numPoints = 0;
+    unsigned int numFibers = 0;
+    for (unsigned int i=0; i<parts.size(); i++)
+    {
+        numPoints += parts[i].GetNumberOfPoints();
+        numFibers += parts[i].GetNumberOfFibers();
+    }
+
+    Clear();
+    m_Points->SetNumberOfTuples(numPoints);
+    m_Coordinates = m_Points->GetPointer(0);
+    m_Offsets.reserve(numFibers+1);
+    for (unsigned int i=0; i<parts.size(); i++)
+    {
+        const FiberColumnStore& part = parts.at(i);
+        if (part.GetNumberOfPoints()>0)
+            memcpy(m_Coordinates+3*m_Offsets.back(), part.m_Coordinates, 3*part.GetNumberOfPoints()*sizeof(float));
+        vtkIdType first = m_Offsets.back();
+        for (unsigned int j=1; j<part.m_Offsets.size(); j++)
+            m_Offsets.push_back(first+part.m_Offsets[j]);
+    }
+}
+
+vtkSmartPointer<vtkPolyData> mitk::FiberColumnStore::Import(vtkPolyData* fiberPolyData)
+{
+    Clear();
+    if (fiberPolyData==NULL || fiberPolyData->GetPoints()==NULL || fiberPolyData->GetLines()==NULL)
+        return GetPolyData();
+
+    vtkPoints* points = fiberPolyData->GetPoints();
+    vtkCellArray* lines = fiberPolyData->GetLines();
+    const vtkIdType* connectivity = lines->GetPointer();
+    vtkIdType numLines = lines->GetNumberOfCells();
+
+    // the polydata already has the layout of the store if its lines use all float points in order
+    bool sameLayout = points->GetDataType()==VTK_FLOAT && fiberPolyData->GetNumberOfVerts()==0
+            && fiberPolyData->GetNumberOfPolys()==0 && fiberPolyData->GetNumberOfStrips()==0;
+    std::vector<vtkIdType> lineIds;
+    m_Offsets.reserve(numLines+1);
+    for (vtkIdType i=0, loc=0; i<numLines; i++)
+    {
+        vtkIdType numPoints = connectivity[loc];
+        if (numPoints<2)
+            sameLayout = false;
+        else
+        {
+            for (vtkIdType j=0; j<numPoints && sameLayout; j++)
+                sameLayout = connectivity[loc+1+j]==m_Offsets.back()+j;
+            lineIds.push_back(fiberPolyData->GetNumberOfVerts()+i);
+            m_Offsets.push_back(m_Offsets.back()+numPoints);
+        }
+        loc += numPoints+1;
+    }
+    sameLayout = sameLayout && m_Offsets.back()==points->GetNumberOfPoints();
+
+    if (sameLayout)
+    {
+        m_Points = vtkFloatArray::SafeDownCast(points->GetData());
+        m_Coordinates = m_Points->GetPointer(0);
+        vtkSmartPointer<vtkPolyData> result = vtkSmartPointer<vtkPolyData>::New();
+        result->ShallowCopy(fiberPolyData);
+        return result;
+    }
+
+    m_Points->SetNumberOfTuples(m_Offsets.back());
+    m_Coordinates = m_Points->GetPointer(0);
+    std::vector<vtkIdType> pointIds(m_Offsets.back());
+    for (vtkIdType i=0, loc=0, p=0; i<numLines; i++)
+    {
+        vtkIdType numPoints = connectivity[loc];
+        if (numPoints>=2)
+            for (vtkIdType j=0; j<numPoints; j++, p++)
+            {
+                double point[3];
+                pointIds[p] = connectivity[loc+1+j];
+                points->GetPoint(pointIds[p], point);
+                m_Coordinates[3*p] = point[0];
+                m_Coordinates[3*p+1] = point[1];
+                m_Coordinates[3*p+2] = point[2];
+            }
+        loc += numPoints+1;
+    }
+
+    vtkSmartPointer<vtkPolyData> result = GetPolyData();
+    vtkPointData* pointData = result->GetPointData();
+    pointData->CopyAllocate(fiberPolyData->GetPointData(), pointIds.size());
+    for (unsigned int i=0; i<pointIds.size(); i++)
+        pointData->CopyData(fiberPolyData->GetPointData(), pointIds[i], i);
+    vtkCellData* cellData = result->GetCellData();
+    cellData->CopyAllocate(fiberPolyData->GetCellData(), lineIds.size());
+    for (unsigned int i=0; i<lineIds.size(); i++)
+        cellData->CopyData(fiberPolyData->GetCellData(), lineIds[i], i);
+    return result;
+}
+
+vtkSmartPointer<vtkPolyData> mitk::FiberColumnStore::GetPolyData() const
+{
+    unsigned int numFibers = GetNumberOfFibers();
+
+    vtkSmartPointer<vtkIdTypeArray> connectivity = vtkSmartPointer<vtkIdTypeArray>::New();
+    connectivity->SetNumberOfValues(numFibers+GetNumberOfPoints());
+    vtkIdType* ids = connectivity->GetPointer(0);
+    for (unsigned int i=0; i<numFibers; i++)
+    {
+        *ids++ = GetNumberOfPoints(i);
+        for (vtkIdType id=m_Offsets[i]; id<m_Offsets[i+1]; id++)
+            *ids++ = id;
+    }
+    vtkSmartPointer<vtkCellArray> lines = vtkSmartPointer<vtkCellArray>::New();
+    lines->SetCells(numFibers, connectivity);
+
+    vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
+    points->SetData(m_Points);
+
+    vtkSmartPointer<vtkPolyData> polyData = vtkSmartPointer<vtkPolyData>::New();
+    polyData->SetPoints(points);
+    polyData->SetLines(lines);
+    return polyData;
+}
+
+void mitk::FiberColumnStore::ProcessFibers(FiberProcessor* processor, unsigned int numThreads) const
+{
+    if (numThreads>GetNumberOfFibers())
+        numThreads = GetNumberOfFibers();
+    if (numThreads<1)
+        numThreads = 1;
+
+    ProcessFibersData data;
+    data.m_Store = this;
+    data.m_Processor = processor;
+
+    itk::MultiThreader::Pointer threader = itk::MultiThreader::New();
+    threader->SetNumberOfThreads(numThreads);
+    threader->SetSingleMethod(ProcessFibersThread, &data);
+    threader->SingleMethodExecute();
+}
@@ -0,0 +1,98 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#ifndef _MITK_FiberColumnStore_H
+#define _MITK_FiberColumnStore_H
+
+#include "FiberTrackingExports.h"
+
+#include <vtkSmartPointer.h>
+#include <vtkPolyData.h>
+#include <vtkFloatArray.h>
+
+#include <vector>
+
+namespace mitk {
+
+/**
+  * \brief Fiber points stored as two columns: float coordinates and the offset of each fiber.
+  *
+  * The points of fiber i are the points m_Offsets[i] to m_Offsets[i+1]-1, stored as x y z in one vtkFloatArray.
+  * GetPolyData() puts this array into a vtkPolyData without copying it, so the store and all polydata created
+  * from it share the coordinates. The coordinate array is never modified after it was filled; operations on the
+  * fibers build a new store. Import() takes the array of a polydata without copying if the polydata already
+  * has this layout, e.g. if it was created by GetPolyData().
+  *
+  * ProcessFibers() splits the fibers into one contiguous range per thread.
+  */
+class FiberTracking_EXPORT FiberColumnStore
+{
+public:
+
+    /** \brief Work on a range of fibers, called by ProcessFibers() once per thread. */
+    class FiberProcessor
+    {
+    public:
+        virtual ~FiberProcessor() {}
+        virtual void ProcessFibers(const FiberColumnStore& fibers, unsigned int firstFiber, unsigned int lastFiber, unsigned int threadId) = 0;
+    };
+
+    FiberColumnStore();
+
+    void Clear();
+
+    /** \brief Stores the lines of fiberPolyData and returns a polydata of the stored fibers with the point data of fiberPolyData. Lines with less than two points are skipped. */
+    vtkSmartPointer<vtkPolyData> Import(vtkPolyData* fiberPolyData);
+
+    /** \brief New polydata with one line per fiber, using the coordinate array of the store. */
+    vtkSmartPointer<vtkPolyData> GetPolyData() const;
+
+    unsigned int GetNumberOfFibers() const { return m_Offsets.size()-1; }
+    vtkIdType GetNumberOfPoints() const { return m_Offsets.back(); }
+    unsigned int GetNumberOfPoints(unsigned int fiber) const { return m_Offsets[fiber+1]-m_Offsets[fiber]; }
+
+    /** \brief Point id of the first point of fiber, also the id in GetPolyData(). */
+    vtkIdType GetFirstPoint(unsigned int fiber) const { return m_Offsets[fiber]; }
+
+    /** \brief Coordinates of the points of fiber as x0 y0 z0 x1 y1 z1 ... */
+    const float* GetPoints(unsigned int fiber) const { return m_Coordinates+3*m_Offsets[fiber]; }
+
+    /** \brief Appends a fiber, points are given as x0 y0 z0 x1 y1 z1 ... */
+    void AddFiber(const float* points, unsigned int numPoints);
+    void AddFiber(const double* points, unsigned int numPoints);
+
+    /** \brief Replaces the content by fibers whose points are stored in points (3 components) without copying them, offsets as returned by GetFirstPoint() followed by the number of points. */
+    void SetFibers(vtkFloatArray* points, const std::vector<vtkIdType>& offsets);
+
+    /** \brief Replaces the content by the fibers of all parts, in order. */
+    void Concatenate(const std::vector< FiberColumnStore >& parts);
+
+    /** \brief Calls processor->ProcessFibers() for numThreads contiguous ranges of fibers in parallel. */
+    void ProcessFibers(FiberProcessor* processor, unsigned int numThreads) const;
+
+private:
+
+    /** \brief Makes room for numPoints more points and returns the first new coordinate. */
+    float* ReservePoints(unsigned int numPoints);
+
+    vtkSmartPointer<vtkFloatArray>  m_Points;           ///< 3 components per point
+    float*                          m_Coordinates;      ///< data of m_Points
+    std::vector<vtkIdType>          m_Offsets;          ///< number of fibers + 1 entries, the last is the number of points
+};
+
+} // namespace mitk
+
+#endif /*  _MITK_FiberColumnStore_H */
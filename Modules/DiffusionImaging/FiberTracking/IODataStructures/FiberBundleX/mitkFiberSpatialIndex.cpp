@@ -0,0 +1,227 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkFiberSpatialIndex.h"
+
+#include <mitkLogMacros.h>
+
+#include <vtkCellArray.h>
+#include <vtkPoints.h>
+
+#include <algorithm>
+#include <cmath>
+
+mitk::FiberSpatialIndex::FiberSpatialIndex()
+{
+    Clear();
+}
+
+void mitk::FiberSpatialIndex::Clear()
+{
+    m_PolyData = NULL;
+    m_PolyDataMTime = 0;
+    m_FirstFiber = 0;
+    m_FiberOffsets.clear();
+    m_Connectivity = NULL;
+    m_CellSize = 1;
+    for (int i=0; i<3; i++)
+    {
+        m_Origin[i] = 0;
+        m_Dimensions[i] = 0;
+    }
+    m_CellOffsets.clear();
+    m_Runs.clear();
+}
+
+unsigned long mitk::FiberSpatialIndex::GetGeometryMTime(vtkPolyData* fiberPolyData)
+{
+    // vtkPolyData::GetMTime() includes the point and cell data, which change with the color coding
+    unsigned long mTime = fiberPolyData->vtkObject::GetMTime();
+    if (fiberPolyData->GetPoints()!=NULL)
+        mTime = std::max(mTime, fiberPolyData->GetPoints()->GetMTime());
+    if (fiberPolyData->GetLines()!=NULL)
+        mTime = std::max(mTime, fiberPolyData->GetLines()->GetMTime());
+    return mTime;
+}
+
+bool mitk::FiberSpatialIndex::IsUpToDate(vtkPolyData* fiberPolyData) const
+{
+    return fiberPolyData!=NULL && fiberPolyData==m_PolyData.GetPointer() && GetGeometryMTime(fiberPolyData)==m_PolyDataMTime;
+}
+
+void mitk::FiberSpatialIndex::Build(vtkPolyData* fiberPolyData)
+{
+    Clear();
+    if (fiberPolyData==NULL)
+        return;
+
+    m_PolyData = fiberPolyData;
+    m_PolyDataMTime = GetGeometryMTime(fiberPolyData);
+
+    vtkPoints* points = fiberPolyData->GetPoints();
+    vtkCellArray* lines = fiberPolyData->GetLines();
+    if (points==NULL || lines==NULL || points->GetNumberOfPoints()<=0 || lines->GetNumberOfCells()<=0)
+        return;
+
+    m_Connectivity = lines->GetPointer();
+    m_FirstFiber = fiberPolyData->GetNumberOfVerts();
+
+    vtkIdType numFibers = lines->GetNumberOfCells();
+    m_FiberOffsets.resize(numFibers);
+    double numSegments = 0;
+    for (vtkIdType i=0, loc=0; i<numFibers; i++)
+    {
+        m_FiberOffsets[i] = loc;
+        if (m_Connectivity[loc]>1)
+            numSegments += m_Connectivity[loc]-1;
+        loc += m_Connectivity[loc]+1;
+    }
+
+    // cubic cells, about eight segments per cell
+    double bounds[6];
+    points->GetBounds(bounds);
+    double maxExtent = 0;
+    for (int i=0; i<3; i++)
+        maxExtent = std::max(maxExtent, bounds[2*i+1]-bounds[2*i]);
+
+    double numCells = std::max(1.0, std::min(numSegments/8, 2097152.0));
+    if (maxExtent>0)
+    {
+        double volume = 1;
+        for (int i=0; i<3; i++)
+            volume *= std::max(bounds[2*i+1]-bounds[2*i], maxExtent/1024);
+        m_CellSize = std::max(std::pow(volume/numCells, 1.0/3), maxExtent/1024);
+    }
+
+    unsigned int totalCells = 1;
+    for (int i=0; i<3; i++)
+    {
+        m_Origin[i] = bounds[2*i];
+        m_Dimensions[i] = (int)std::floor((bounds[2*i+1]-bounds[2*i])/m_CellSize)+1;
+        totalCells *= m_Dimensions[i];
+    }
+
+    // first pass counts the runs of each cell, second pass stores them
+    m_CellOffsets.assign(totalCells+1, 0);
+    std::vector<unsigned int> cursor;
+    std::vector<vtkIdType> lastFiber(totalCells);
+    std::vector<unsigned int> lastSegment(totalCells);
+    for (int pass=0; pass<2; pass++)
+    {
+        std::fill(lastFiber.begin(), lastFiber.end(), -1);
+        if (pass==1)
+        {
+            for (unsigned int c=0; c<totalCells; c++)
+                m_CellOffsets[c+1] += m_CellOffsets[c];
+            m_Runs.resize(m_CellOffsets[totalCells]);
+            cursor.assign(m_CellOffsets.begin(), m_CellOffsets.end()-1);
+        }
+
+        for (vtkIdType i=0; i<numFibers; i++)
+        {
+            vtkIdType numPoints = m_Connectivity[m_FiberOffsets[i]];
+            const vtkIdType* ids = m_Connectivity+m_FiberOffsets[i]+1;
+            if (numPoints<2)
+                continue;
+
+            double p0[3], p1[3];
+            points->GetPoint(ids[0], p0);
+            for (vtkIdType j=0; j<numPoints-1; j++)
+            {
+                points->GetPoint(ids[j+1], p1);
+                double segmentBounds[6];
+                for (int k=0; k<3; k++)
+                {
+                    segmentBounds[2*k] = std::min(p0[k], p1[k]);
+                    segmentBounds[2*k+1] = std::max(p0[k], p1[k]);
+                }
+                int min[3], max[3];
+                GetCellRange(segmentBounds, min, max);
+
+                for (int z=min[2]; z<=max[2]; z++)
+                    for (int y=min[1]; y<=max[1]; y++)
+                        for (int x=min[0]; x<=max[0]; x++)
+                        {
+                            unsigned int c = x + m_Dimensions[0]*(y + m_Dimensions[1]*z);
+                            bool extendsRun = lastFiber[c]==i && lastSegment[c]+1==j;
+                            lastFiber[c] = i;
+                            lastSegment[c] = j;
+                            if (pass==0)
+                            {
+                                if (!extendsRun)
+                                    m_CellOffsets[c+1]++;
+                            }
+                            else if (extendsRun)
+                                m_Runs[cursor[c]-1].m_NumberOfSegments++;
+                            else
+                            {
+                                SegmentRun& run = m_Runs[cursor[c]++];
+                                run.m_Fiber = m_FirstFiber+i;
+                                run.m_FirstSegment = j;
+                                run.m_NumberOfSegments = 1;
+                            }
+                        }
+
+                p0[0] = p1[0]; p0[1] = p1[1]; p0[2] = p1[2];
+            }
+        }
+    }
+
+    MITK_DEBUG << "FiberSpatialIndex: " << m_Dimensions[0] << "x" << m_Dimensions[1] << "x" << m_Dimensions[2] << " cells, " << m_Runs.size() << " segment runs";
+}
+
+bool mitk::FiberSpatialIndex::GetCellRange(const double bounds[6], int min[3], int max[3]) const
+{
+    for (int i=0; i<3; i++)
+    {
+        double lower = std::floor((bounds[2*i]-m_Origin[i])/m_CellSize);
+        double upper = std::floor((bounds[2*i+1]-m_Origin[i])/m_CellSize);
+        if (upper<0 || lower>=m_Dimensions[i])
+            return false;
+        min[i] = lower<0 ? 0 : (int)lower;
+        max[i] = upper>=m_Dimensions[i] ? m_Dimensions[i]-1 : (int)upper;
+    }
+    return true;
+}
+
+void mitk::FiberSpatialIndex::FindSegments(const double bounds[6], std::vector<SegmentRun>& runs) const
+{
+    int min[3], max[3];
+    if (m_Runs.empty() || !GetCellRange(bounds, min, max))
+        return;
+
+    for (int z=min[2]; z<=max[2]; z++)
+        for (int y=min[1]; y<=max[1]; y++)
+            for (int x=min[0]; x<=max[0]; x++)
+            {
+                unsigned int c = x + m_Dimensions[0]*(y + m_Dimensions[1]*z);
+                runs.insert(runs.end(), m_Runs.begin()+m_CellOffsets[c], m_Runs.begin()+m_CellOffsets[c+1]);
+            }
+}
+
+const vtkIdType* mitk::FiberSpatialIndex::GetFiberPointIds(unsigned int fiber, vtkIdType& numberOfPoints) const
+{
+    vtkIdType loc = m_FiberOffsets[fiber-m_FirstFiber];
+    numberOfPoints = m_Connectivity[loc];
+    return m_Connectivity+loc+1;
+}
+
+vtkPoints* mitk::FiberSpatialIndex::GetPoints() const
+{
+    if (m_PolyData==NULL)
+        return NULL;
+    return m_PolyData->GetPoints();
+}
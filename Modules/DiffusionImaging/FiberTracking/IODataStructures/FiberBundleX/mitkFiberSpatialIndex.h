@@ -0,0 +1,90 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#ifndef _MITK_FiberSpatialIndex_H
+#define _MITK_FiberSpatialIndex_H
+
+#include "FiberTrackingExports.h"
+
+#include <vtkSmartPointer.h>
+#include <vtkPolyData.h>
+
+#include <vector>
+
+namespace mitk {
+
+/**
+  * \brief Uniform grid over the fiber segments of a vtkPolyData.
+  *
+  * Every grid cell stores the segments whose bounding box overlaps the cell. Consecutive segments of one
+  * fiber in the same cell are stored as one SegmentRun, so a fiber passing a cell usually costs one entry.
+  * The cell size is chosen such that there are about eight segments per cell. FindSegments() returns all
+  * segments which may intersect an axis aligned box, the caller does the exact test.
+  *
+  * The index refers to the points and lines of the polydata, IsUpToDate() tells if they changed since Build().
+  */
+class FiberTracking_EXPORT FiberSpatialIndex
+{
+public:
+
+    struct SegmentRun
+    {
+        unsigned int m_Fiber;             ///< cell id of the fiber in the polydata
+        unsigned int m_FirstSegment;      ///< segment j connects point j and j+1 of the fiber
+        unsigned int m_NumberOfSegments;
+    };
+
+    FiberSpatialIndex();
+
+    void Build(vtkPolyData* fiberPolyData);
+    void Clear();
+
+    /** \brief Returns true if the index was built for fiberPolyData and its points and lines were not modified since. */
+    bool IsUpToDate(vtkPolyData* fiberPolyData) const;
+
+    /** \brief Appends the segments of all cells overlapping bounds (xmin, xmax, ymin, ymax, zmin, zmax). Runs may repeat. */
+    void FindSegments(const double bounds[6], std::vector<SegmentRun>& runs) const;
+
+    /** \brief Returns the point ids of a fiber, which must be a cell id contained in a SegmentRun. */
+    const vtkIdType* GetFiberPointIds(unsigned int fiber, vtkIdType& numberOfPoints) const;
+
+    vtkPoints* GetPoints() const;
+
+private:
+
+    /** \brief Index range of the cells overlapping bounds, returns false if bounds lie outside of the grid. */
+    bool GetCellRange(const double bounds[6], int min[3], int max[3]) const;
+
+    /** \brief Modification time of the points and lines of fiberPolyData. */
+    static unsigned long GetGeometryMTime(vtkPolyData* fiberPolyData);
+
+    vtkSmartPointer<vtkPolyData>    m_PolyData;
+    unsigned long                   m_PolyDataMTime;
+
+    vtkIdType                       m_FirstFiber;       ///< cell id of the first line (number of vertices)
+    std::vector<vtkIdType>          m_FiberOffsets;     ///< position of each line in the connectivity array
+    const vtkIdType*                m_Connectivity;
+
+    double                          m_Origin[3];
+    double                          m_CellSize;
+    int                             m_Dimensions[3];
+    std::vector<unsigned int>       m_CellOffsets;      ///< runs of cell c are m_Runs[m_CellOffsets[c]] to m_Runs[m_CellOffsets[c+1]-1]
+    std::vector<SegmentRun>         m_Runs;
+};
+
+} // namespace mitk
+
+#endif /*  _MITK_FiberSpatialIndex_H */
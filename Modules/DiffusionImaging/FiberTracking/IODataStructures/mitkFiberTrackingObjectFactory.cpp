@@ -103,9 +103,11 @@ void mitk::FiberTrackingObjectFactory::CreateFileExtensionsMap()
 {
   m_FileExtensionsMap.insert(std::pair<std::string, std::string>("*.fib", "Fiber Bundle"));
   m_FileExtensionsMap.insert(std::pair<std::string, std::string>("*.vtk", "Fiber Bundle"));
+  m_FileExtensionsMap.insert(std::pair<std::string, std::string>("*.fbin", "Fiber Bundle"));
 
   m_SaveFileExtensionsMap.insert(std::pair<std::string, std::string>("*.fib", "Fiber Bundle"));
   m_SaveFileExtensionsMap.insert(std::pair<std::string, std::string>("*.vtk", "Fiber Bundle"));
+  m_SaveFileExtensionsMap.insert(std::pair<std::string, std::string>("*.fbin", "Fiber Bundle"));
 }
 
 void mitk::FiberTrackingObjectFactory::RegisterIOFactories()
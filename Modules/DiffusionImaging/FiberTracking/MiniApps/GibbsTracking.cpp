@@ -65,7 +65,7 @@ int GibbsTracking(int argc, char* argv[])
     parser.addArgument("parameters", "p", ctkCommandLineParser::String, "parameter file (.gtp)", mitk::Any(), false);
     parser.addArgument("mask", "m", ctkCommandLineParser::String, "binary mask image");
     parser.addArgument("shConvention", "s", ctkCommandLineParser::String, "sh coefficient convention (FSL, MRtrix)", string("FSL"), true);
-    parser.addArgument("outFile", "o", ctkCommandLineParser::String, "output fiber bundle (.fib)", mitk::Any(), false);
+    parser.addArgument("outFile", "o", ctkCommandLineParser::String, "output fiber bundle (.fib or .fbin)", mitk::Any(), false);
 
     map<string, mitk::Any> parsedArgs = parser.parseArguments(argc, argv);
     if (parsedArgs.size()==0)
@@ -182,6 +182,18 @@ int GibbsTracking(int argc, char* argv[])
         gibbsTracker->SetDuplicateImage(false);
         gibbsTracker->SetLoadParameterFile( paramFileName );
 //        gibbsTracker->SetLutPath( "" );
+
+        if( boost::algorithm::iends_with(outFileName, ".fbin") )
+        {
+            mitk::FiberBundleXBinaryWriter::Pointer fiberWriter = mitk::FiberBundleXBinaryWriter::New();
+            fiberWriter->Open(outFileName);
+            gibbsTracker->SetFiberWriter(fiberWriter);
+            gibbsTracker->Update();
+            fiberWriter->Close();
+            MITK_INFO << "DONE";
+            return EXIT_SUCCESS;
+        }
+
         gibbsTracker->Update();
 
         mitk::FiberBundleX::Pointer mitkFiberBundle = mitk::FiberBundleX::New(gibbsTracker->GetFiberBundle());
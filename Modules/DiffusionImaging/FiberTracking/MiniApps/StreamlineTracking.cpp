@@ -24,6 +24,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <mitkFiberBundleX.h>
 #include <itkStreamlineTrackingFilter.h>
 #include <itkDiffusionTensor3D.h>
+#include <itksys/SystemTools.hxx>
 #include "ctkCommandLineParser.h"
 
 int StreamlineTracking(int argc, char* argv[])
@@ -42,7 +43,7 @@ int StreamlineTracking(int argc, char* argv[])
     parser.addArgument("minLength", "l", ctkCommandLineParser::Float, "minimum fiber length in mm", 20, true);
 
     parser.addArgument("interpolate", "a", ctkCommandLineParser::Bool, "Use linear interpolation", false, true);
-    parser.addArgument("outFile", "o", ctkCommandLineParser::String, "output fiber bundle (.fib)", mitk::Any(), false);
+    parser.addArgument("outFile", "o", ctkCommandLineParser::String, "output fiber bundle (.fib or .fbin, fibers are written to .fbin files while tracking)", mitk::Any(), false);
 
     map<string, mitk::Any> parsedArgs = parser.parseArguments(argc, argv);
     if (parsedArgs.size()==0)
@@ -134,6 +135,22 @@ int StreamlineTracking(int argc, char* argv[])
             filter->SetMaskImage(mask);
         }
 
+        if (itksys::SystemTools::LowerCase(itksys::SystemTools::GetFilenameLastExtension(outFileName)) == ".fbin")
+        {
+            mitk::FiberBundleXBinaryWriter::Pointer fiberWriter = mitk::FiberBundleXBinaryWriter::New();
+            fiberWriter->Open(outFileName);
+            filter->SetFiberWriter(fiberWriter);
+            filter->Update();
+            fiberWriter->Close();
+            if ( fiberWriter->GetNumberOfFibers()==0 )
+            {
+                MITK_INFO << "No fibers reconstructed. Check parametrization.";
+                return EXIT_FAILURE;
+            }
+            MITK_INFO << "DONE";
+            return EXIT_SUCCESS;
+        }
+
         filter->Update();
 
         vtkSmartPointer<vtkPolyData> fiberBundle = filter->GetFiberPolyData();
@@ -1,3 +1,12 @@
+set(MODULE_TESTS
+  mitkFiberBitmapTest.cpp
+  mitkFiberColumnStoreTest.cpp
+  mitkFiberBundleXProcessingTest.cpp
+  mitkFiberBundleXSelectionTest.cpp
+  mitkTractDensityImageFilterTest.cpp
+  mitkFiberBundleXBinaryFileTest.cpp
+)
+
 SET(MODULE_CUSTOM_TESTS
   mitkFiberBundleXReaderWriterTest.cpp
   mitkFiberBundleXTest.cpp
@@ -0,0 +1,89 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkTestingMacros.h"
+
+#include <mitkFiberBitmap.h>
+
+#include <algorithm>
+#include <iterator>
+#include <vector>
+
+static mitk::FiberBitmap CreateBitmap(const std::vector<long>& ids)
+{
+  mitk::FiberBitmap bitmap;
+  for (unsigned int i=0; i<ids.size(); i++)
+    bitmap.Add(ids[i]);
+  return bitmap;
+}
+
+static std::vector<long> GetIds(const mitk::FiberBitmap& bitmap)
+{
+  std::vector<long> ids;
+  bitmap.GetIds(ids);
+  return ids;
+}
+
+/**Documentation
+ *  Test for the compressed fiber id sets used by the ROI selection of FiberBundleX
+ */
+int mitkFiberBitmapTest(int /*argc*/, char* /*argv*/[])
+{
+  MITK_TEST_BEGIN("mitkFiberBitmapTest");
+
+  // sparse ids, dense ids (stored as bitset) and ids in several chunks
+  std::vector<long> a, b;
+  for (long i=0; i<200000; i+=3)
+    a.push_back(i);
+  for (long i=0; i<10000; i++)
+    b.push_back(i);
+  for (long i=150000; i<300000; i+=1000)
+    b.push_back(i);
+
+  std::vector<long> reversed(a.rbegin(), a.rend());
+  mitk::FiberBitmap bitmapA = CreateBitmap(reversed);
+  mitk::FiberBitmap bitmapB = CreateBitmap(b);
+  MITK_TEST_CONDITION(GetIds(bitmapA)==a, "Add() in arbitrary order")
+  MITK_TEST_CONDITION(bitmapA.GetCount()==a.size(), "GetCount()")
+  MITK_TEST_CONDITION(bitmapA.Contains(3) && !bitmapA.Contains(4) && !bitmapA.Contains(200001), "Contains()")
+
+  std::vector<long> expected;
+  mitk::FiberBitmap result = bitmapA;
+  result.And(bitmapB);
+  std::set_intersection(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(expected));
+  MITK_TEST_CONDITION(GetIds(result)==expected, "And()")
+
+  expected.clear();
+  result = bitmapA;
+  result.Or(bitmapB);
+  std::set_union(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(expected));
+  MITK_TEST_CONDITION(GetIds(result)==expected, "Or()")
+  MITK_TEST_CONDITION(result==CreateBitmap(expected), "operator==")
+
+  expected.clear();
+  result = bitmapA;
+  result.AndNot(bitmapB);
+  std::set_difference(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(expected));
+  MITK_TEST_CONDITION(GetIds(result)==expected, "AndNot()")
+
+  result = mitk::FiberBitmap::Fill(200000);
+  result.AndNot(bitmapA);
+  result.Or(bitmapA);
+  MITK_TEST_CONDITION(result==mitk::FiberBitmap::Fill(200000) && result.GetCount()==200000, "Fill()")
+  MITK_TEST_CONDITION(mitk::FiberBitmap::Fill(0).IsEmpty(), "Fill(0)")
+
+  MITK_TEST_END();
+}
@@ -0,0 +1,135 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkTestingMacros.h"
+
+#include <mitkFiberBundleXBinaryFile.h>
+#include <mitkException.h>
+
+#include <itksys/SystemTools.hxx>
+
+#include <cmath>
+#include <fstream>
+#include <vector>
+
+static bool ReadThrows(const std::string& fileName)
+{
+  try
+  {
+    mitk::FiberBundleXBinaryReader::Pointer reader = mitk::FiberBundleXBinaryReader::New();
+    reader->Open(fileName);
+  }
+  catch (mitk::Exception&)
+  {
+    return true;
+  }
+  return false;
+}
+
+static bool EqualFibers(const mitk::FiberColumnStore& a, const mitk::FiberColumnStore& b)
+{
+  bool equal = a.GetNumberOfFibers()==b.GetNumberOfFibers();
+  for (unsigned int i=0; equal && i<a.GetNumberOfFibers(); i++)
+  {
+    equal = a.GetNumberOfPoints(i)==b.GetNumberOfPoints(i);
+    for (unsigned int j=0; equal && j<3*a.GetNumberOfPoints(i); j++)
+      equal = a.GetPoints(i)[j]==b.GetPoints(i)[j];
+  }
+  return equal;
+}
+
+/**Documentation
+ *  Test for writing and reading the binary fiber bundle format (*.fbin)
+ */
+int mitkFiberBundleXBinaryFileTest(int /*argc*/, char* /*argv*/[])
+{
+  MITK_TEST_BEGIN("mitkFiberBundleXBinaryFileTest");
+
+  std::string fileName = itksys::SystemTools::GetCurrentWorkingDirectory() + "/mitkFiberBundleXBinaryFileTest.fbin";
+
+  // fibers of different length, the single point fiber is skipped
+  mitk::FiberColumnStore fibers;
+  mitk::FiberBundleXBinaryWriter::Pointer writer = mitk::FiberBundleXBinaryWriter::New();
+  writer->Open(fileName);
+  std::vector<double> points;
+  for (unsigned int i=0; i<51; i++)
+  {
+    points.clear();
+    unsigned int numPoints = i==17 ? 1 : 2+i%5;
+    for (unsigned int j=0; j<numPoints; j++)
+    {
+      points.push_back(i+0.25*j);
+      points.push_back(std::cos(0.3*i*j));
+      points.push_back(-0.5*j);
+    }
+    writer->AddFiber(&points[0], numPoints);
+    if (numPoints>1)
+      fibers.AddFiber(&points[0], numPoints);
+  }
+  MITK_TEST_CONDITION(writer->GetNumberOfFibers()==50, "AddFiber() skips fibers with less than two points")
+  writer->Close();
+  MITK_TEST_CONDITION(!writer->IsOpen() && writer->GetNumberOfFibers()==50, "Close() keeps the number of fibers")
+  MITK_TEST_CONDITION(mitk::FiberBundleXBinaryReader::IsBinaryFiberBundle(fileName), "IsBinaryFiberBundle()")
+
+  mitk::FiberBundleXBinaryReader::Pointer reader = mitk::FiberBundleXBinaryReader::New();
+  reader->Open(fileName);
+  MITK_TEST_CONDITION(reader->GetNumberOfFibers()==50 && reader->GetNumberOfPoints()==fibers.GetNumberOfPoints(), "Open() reads the header")
+
+  mitk::FiberColumnStore read;
+  read.Import(reader->Read());
+  reader->Close();
+  MITK_TEST_CONDITION(EqualFibers(read, fibers), "Read() returns the written fibers after Close() of the reader")
+
+  // read uses the mapping of fileName, writing it to the same file must not destroy the points
+  mitk::FiberBundleXBinaryWriter::Write(fileName, read);
+  MITK_TEST_CONDITION(EqualFibers(read, fibers), "Write() to the mapped file keeps the mapped fibers")
+  reader->Open(fileName);
+  read.Import(reader->Read());
+  reader->Close();
+  MITK_TEST_CONDITION(EqualFibers(read, fibers), "Write() to the mapped file")
+  MITK_TEST_CONDITION(!itksys::SystemTools::FileExists((fileName+".part").c_str()), "Close() removes the temporary file")
+
+  reader->Open(fileName);
+  vtkSmartPointer<vtkPolyData> preview = reader->ReadPreview(10);
+  MITK_TEST_CONDITION(preview->GetNumberOfLines()==10, "ReadPreview()")
+  reader->Close();
+
+  mitk::FiberBundleXBinaryWriter::Write(fileName, fibers);
+  reader->Open(fileName);
+  MITK_TEST_CONDITION(reader->GetNumberOfFibers()==50, "Write()")
+  reader->Close();
+
+  // cut off the last fiber offset
+  std::vector<char> content(itksys::SystemTools::FileLength(fileName.c_str()));
+  std::ifstream in(fileName.c_str(), std::ios::binary);
+  in.read(&content[0], content.size());
+  in.close();
+  std::ofstream out(fileName.c_str(), std::ios::binary | std::ios::trunc);
+  out.write(&content[0], content.size()-8);
+  out.close();
+  MITK_TEST_CONDITION(ReadThrows(fileName), "Open() of a truncated file throws")
+
+  writer->Open(fileName);
+  writer->AddFiber(&points[0], points.size()/3);
+  MITK_TEST_CONDITION(ReadThrows(fileName+".part"), "Open() of a file which was not closed throws")
+  MITK_TEST_CONDITION(ReadThrows(fileName), "Open() does not change the existing file")
+  writer->Close();
+  MITK_TEST_CONDITION(!ReadThrows(fileName), "Close() replaces the existing file")
+
+  itksys::SystemTools::RemoveFile(fileName.c_str());
+
+  MITK_TEST_END();
+}
@@ -0,0 +1,371 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkTestingMacros.h"
+
+#include <mitkFiberBundleX.h>
+#include <mitkFiberColumnStore.h>
+
+#include <itkMultiThreader.h>
+#include <itkNumericTraits.h>
+#include <itkVector.h>
+#include <vnl/vnl_math.h>
+#include <vnl/vnl_matrix_fixed.h>
+#include <vnl/vnl_vector_fixed.h>
+
+#include <vtkCell.h>
+#include <vtkCellArray.h>
+#include <vtkPoints.h>
+#include <vtkPolyLine.h>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+// The reference implementations below are the per cell vtkPolyData versions of the fiber operations
+// that FiberBundleX used before its points were moved into a FiberColumnStore.
+
+static vtkSmartPointer<vtkPolyData> NewPolyData(vtkPoints* points, vtkCellArray* cells)
+{
+  vtkSmartPointer<vtkPolyData> polyData = vtkSmartPointer<vtkPolyData>::New();
+  polyData->SetPoints(points);
+  polyData->SetLines(cells);
+  return polyData;
+}
+
+static vtkSmartPointer<vtkPolyData> ReferenceTransform(vtkPolyData* fibers, const vnl_matrix_fixed< double, 3, 3 >& matrix, const mitk::Point3D& center, const mitk::Vector3D& translation)
+{
+  vtkSmartPointer<vtkPoints> vtkNewPoints = vtkSmartPointer<vtkPoints>::New();
+  vtkSmartPointer<vtkCellArray> vtkNewCells = vtkSmartPointer<vtkCellArray>::New();
+  for (int i=0; i<fibers->GetNumberOfCells(); i++)
+  {
+    vtkCell* cell = fibers->GetCell(i);
+    int numPoints = cell->GetNumberOfPoints();
+    vtkPoints* points = cell->GetPoints();
+
+    vtkSmartPointer<vtkPolyLine> container = vtkSmartPointer<vtkPolyLine>::New();
+    for (int j=0; j<numPoints; j++)
+    {
+      double* p = points->GetPoint(j);
+      vnl_vector_fixed< double, 3 > dir;
+      for (int k=0; k<3; k++)
+        dir[k] = p[k]-center[k];
+      dir = matrix*dir;
+      for (int k=0; k<3; k++)
+        dir[k] += center[k]+translation[k];
+      vtkIdType id = vtkNewPoints->InsertNextPoint(dir.data_block());
+      container->GetPointIds()->InsertNextId(id);
+    }
+    vtkNewCells->InsertNextCell(container);
+  }
+  return NewPolyData(vtkNewPoints, vtkNewCells);
+}
+
+static vtkSmartPointer<vtkPolyData> ReferenceResample(vtkPolyData* fibers, float pointDistance)
+{
+  vtkSmartPointer<vtkPoints> newPoints = vtkSmartPointer<vtkPoints>::New();
+  vtkSmartPointer<vtkCellArray> newCellArray = vtkSmartPointer<vtkCellArray>::New();
+  for (int i=0; i<fibers->GetNumberOfCells(); i++)
+  {
+    vtkCell* cell = fibers->GetCell(i);
+    int numPoints = cell->GetNumberOfPoints();
+    vtkPoints* points = cell->GetPoints();
+
+    vtkSmartPointer<vtkPolyLine> container = vtkSmartPointer<vtkPolyLine>::New();
+    double* point = points->GetPoint(0);
+    container->GetPointIds()->InsertNextId(newPoints->InsertNextPoint(point));
+
+    float dtau = 0;
+    int cur_p = 1;
+    itk::Vector<float,3> dR;
+    float normdR = 0;
+    for (;;)
+    {
+      while (dtau <= pointDistance && cur_p < numPoints)
+      {
+        itk::Vector<float,3> v1;
+        point = points->GetPoint(cur_p-1);
+        v1[0] = point[0]; v1[1] = point[1]; v1[2] = point[2];
+        itk::Vector<float,3> v2;
+        point = points->GetPoint(cur_p);
+        v2[0] = point[0]; v2[1] = point[1]; v2[2] = point[2];
+
+        dR  = v2 - v1;
+        normdR = std::sqrt(dR.GetSquaredNorm());
+        dtau += normdR;
+        cur_p++;
+      }
+
+      if (dtau >= pointDistance)
+      {
+        itk::Vector<float,3> v1;
+        point = points->GetPoint(cur_p-1);
+        v1[0] = point[0]; v1[1] = point[1]; v1[2] = point[2];
+        itk::Vector<float,3> v2 = v1 - dR*( (dtau-pointDistance)/normdR );
+        container->GetPointIds()->InsertNextId(newPoints->InsertNextPoint(v2.GetDataPointer()));
+      }
+      else
+      {
+        point = points->GetPoint(numPoints-1);
+        container->GetPointIds()->InsertNextId(newPoints->InsertNextPoint(point));
+        break;
+      }
+      dtau = dtau-pointDistance;
+    }
+    newCellArray->InsertNextCell(container);
+  }
+  return NewPolyData(newPoints, newCellArray);
+}
+
+static vtkSmartPointer<vtkPolyData> ReferenceCurvatureThreshold(vtkPolyData* fibers, float minRadius, bool deleteFibers)
+{
+  vtkSmartPointer<vtkPoints> vtkNewPoints = vtkSmartPointer<vtkPoints>::New();
+  vtkSmartPointer<vtkCellArray> vtkNewCells = vtkSmartPointer<vtkCellArray>::New();
+  for (int i=0; i<fibers->GetNumberOfCells(); i++)
+  {
+    vtkCell* cell = fibers->GetCell(i);
+    int numPoints = cell->GetNumberOfPoints();
+    vtkPoints* points = cell->GetPoints();
+
+    vtkSmartPointer<vtkPolyLine> container = vtkSmartPointer<vtkPolyLine>::New();
+    for (int j=0; j<numPoints-2; j++)
+    {
+      double p1[3], p2[3], p3[3];
+      points->GetPoint(j, p1);
+      points->GetPoint(j+1, p2);
+      points->GetPoint(j+2, p3);
+
+      vnl_vector_fixed< float, 3 > v1, v2, v3;
+      for (int k=0; k<3; k++)
+      {
+        v1[k] = p2[k]-p1[k];
+        v2[k] = p3[k]-p2[k];
+        v3[k] = p1[k]-p3[k];
+      }
+      float a = v1.magnitude();
+      float b = v2.magnitude();
+      float c = v3.magnitude();
+      float r = a*b*c/std::sqrt((a+b+c)*(a+b-c)*(b+c-a)*(a-b+c));
+
+      container->GetPointIds()->InsertNextId(vtkNewPoints->InsertNextPoint(p1));
+
+      if (deleteFibers && r<minRadius)
+        break;
+
+      if (r<minRadius)
+      {
+        j += 2;
+        vtkNewCells->InsertNextCell(container);
+        container = vtkSmartPointer<vtkPolyLine>::New();
+      }
+      else if (j==numPoints-3)
+      {
+        container->GetPointIds()->InsertNextId(vtkNewPoints->InsertNextPoint(p2));
+        container->GetPointIds()->InsertNextId(vtkNewPoints->InsertNextPoint(p3));
+        vtkNewCells->InsertNextCell(container);
+      }
+    }
+  }
+  return NewPolyData(vtkNewPoints, vtkNewCells);
+}
+
+static std::vector<float> ReferenceLengths(vtkPolyData* fibers)
+{
+  std::vector<float> lengths;
+  for (int i=0; i<fibers->GetNumberOfCells(); i++)
+  {
+    vtkCell* cell = fibers->GetCell(i);
+    vtkPoints* points = cell->GetPoints();
+    float length = 0;
+    for (int j=0; j<cell->GetNumberOfPoints()-1; j++)
+    {
+      double p1[3], p2[3];
+      points->GetPoint(j, p1);
+      points->GetPoint(j+1, p2);
+      length += std::sqrt((p1[0]-p2[0])*(p1[0]-p2[0])+(p1[1]-p2[1])*(p1[1]-p2[1])+(p1[2]-p2[2])*(p1[2]-p2[2]));
+    }
+    lengths.push_back(length);
+  }
+  return lengths;
+}
+
+static vtkSmartPointer<vtkPolyData> ReferenceLengthThreshold(vtkPolyData* fibers, float minLength, float maxLength)
+{
+  std::vector<float> lengths = ReferenceLengths(fibers);
+  vtkSmartPointer<vtkPoints> vtkNewPoints = vtkSmartPointer<vtkPoints>::New();
+  vtkSmartPointer<vtkCellArray> vtkNewCells = vtkSmartPointer<vtkCellArray>::New();
+  for (int i=0; i<fibers->GetNumberOfCells(); i++)
+  {
+    if (lengths[i]<minLength || lengths[i]>maxLength)
+      continue;
+    vtkCell* cell = fibers->GetCell(i);
+    vtkSmartPointer<vtkPolyLine> container = vtkSmartPointer<vtkPolyLine>::New();
+    for (int j=0; j<cell->GetNumberOfPoints(); j++)
+      container->GetPointIds()->InsertNextId(vtkNewPoints->InsertNextPoint(cell->GetPoints()->GetPoint(j)));
+    vtkNewCells->InsertNextCell(container);
+  }
+  return NewPolyData(vtkNewPoints, vtkNewCells);
+}
+
+// the lines of reference with less than two points are skipped, FiberBundleX drops them
+static bool EqualFibers(mitk::FiberBundleX* fib, vtkPolyData* reference, float tolerance)
+{
+  mitk::FiberColumnStore expected;
+  expected.Import(reference);
+  const mitk::FiberColumnStore& fibers = fib->GetFiberColumnStore();
+  if (expected.GetNumberOfFibers()==0 || fibers.GetNumberOfFibers()!=expected.GetNumberOfFibers() || fibers.GetNumberOfPoints()!=expected.GetNumberOfPoints())
+    return false;
+  for (unsigned int i=0; i<fibers.GetNumberOfFibers(); i++)
+  {
+    if (fibers.GetNumberOfPoints(i)!=expected.GetNumberOfPoints(i))
+      return false;
+    for (unsigned int j=0; j<3*fibers.GetNumberOfPoints(i); j++)
+      if (std::fabs(fibers.GetPoints(i)[j]-expected.GetPoints(i)[j])>tolerance)
+        return false;
+  }
+  return true;
+}
+
+static bool EqualLengthStatistics(mitk::FiberBundleX* fib, vtkPolyData* reference)
+{
+  std::vector<float> lengths = ReferenceLengths(reference);
+  double mean = 0;
+  for (unsigned int i=0; i<lengths.size(); i++)
+    mean += lengths[i];
+  mean /= lengths.size();
+  std::sort(lengths.begin(), lengths.end());
+
+  const float tolerance = 1e-3;
+  return std::fabs(fib->GetMinFiberLength()-lengths.front())<tolerance
+      && std::fabs(fib->GetMaxFiberLength()-lengths.back())<tolerance
+      && std::fabs(fib->GetMedianFiberLength()-lengths[lengths.size()/2])<tolerance
+      && std::fabs(fib->GetMeanFiberLength()-mean)<tolerance;
+}
+
+// smooth helices and lines with a right angle in the middle, of different length
+static vtkSmartPointer<vtkPolyData> CreateFibers()
+{
+  vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
+  vtkSmartPointer<vtkCellArray> cells = vtkSmartPointer<vtkCellArray>::New();
+  for (int i=0; i<60; i++)
+  {
+    vtkSmartPointer<vtkPolyLine> container = vtkSmartPointer<vtkPolyLine>::New();
+    int numPoints = 4+(i*7)%23;
+    for (int j=0; j<numPoints; j++)
+    {
+      double p[3];
+      if (i%4==0)
+      {
+        int corner = numPoints/2;
+        p[0] = 0.8*std::min(j, corner)-i;
+        p[1] = 0.8*std::max(0, j-corner);
+        p[2] = 0.3*i;
+      }
+      else
+      {
+        p[0] = (10.0+i%5)*std::cos(0.2*j+i);
+        p[1] = (10.0+i%5)*std::sin(0.2*j+i);
+        p[2] = 0.7*j-0.5*i;
+      }
+      container->GetPointIds()->InsertNextId(points->InsertNextPoint(p));
+    }
+    cells->InsertNextCell(container);
+  }
+  return NewPolyData(points, cells);
+}
+
+/**Documentation
+ *  Test that the fiber operations of FiberBundleX give the results of the former per cell implementation
+ */
+int mitkFiberBundleXProcessingTest(int /*argc*/, char* /*argv*/[])
+{
+  MITK_TEST_BEGIN("mitkFiberBundleXProcessingTest");
+
+  // the fibers are split into several ranges processed in parallel
+  itk::MultiThreader::SetGlobalDefaultNumberOfThreads(4);
+
+  vtkSmartPointer<vtkPolyData> input = CreateFibers();
+  const float tolerance = 1e-4;
+
+  mitk::FiberBundleX::Pointer fib = mitk::FiberBundleX::New(input);
+  MITK_TEST_CONDITION_REQUIRED(EqualFibers(fib, input, 0), "FiberBundleX imports the fibers")
+  MITK_TEST_CONDITION(EqualLengthStatistics(fib, input), "Fiber lengths")
+
+  vtkSmartPointer<vtkPolyData> before = fib->GetFiberPolyData();
+  fib->ResampleFibers(0.6);
+  MITK_TEST_CONDITION(EqualFibers(fib, ReferenceResample(before, 0.6), tolerance), "ResampleFibers()")
+  MITK_TEST_CONDITION(EqualLengthStatistics(fib, fib->GetFiberPolyData()), "Fiber lengths after ResampleFibers()")
+
+  // RotateAroundAxis() takes degrees
+  double x = 30*vnl_math::pi/180, y = -10*vnl_math::pi/180, z = 60*vnl_math::pi/180;
+  vnl_matrix_fixed< double, 3, 3 > rotX; rotX.set_identity();
+  rotX[1][1] = cos(x); rotX[2][2] = rotX[1][1];
+  rotX[1][2] = -sin(x); rotX[2][1] = -rotX[1][2];
+  vnl_matrix_fixed< double, 3, 3 > rotY; rotY.set_identity();
+  rotY[0][0] = cos(y); rotY[2][2] = rotY[0][0];
+  rotY[0][2] = sin(y); rotY[2][0] = -rotY[0][2];
+  vnl_matrix_fixed< double, 3, 3 > rotZ; rotZ.set_identity();
+  rotZ[0][0] = cos(z); rotZ[1][1] = rotZ[0][0];
+  rotZ[0][1] = -sin(z); rotZ[1][0] = -rotZ[0][1];
+  mitk::Point3D center = fib->GetGeometry()->GetCenter();
+  mitk::Vector3D noTranslation; noTranslation.Fill(0);
+  before = fib->GetFiberPolyData();
+  fib->RotateAroundAxis(30, -10, 60);
+  MITK_TEST_CONDITION(EqualFibers(fib, ReferenceTransform(before, rotZ*rotY*rotX, center, noTranslation), tolerance), "RotateAroundAxis()")
+
+  vnl_matrix_fixed< double, 3, 3 > scale; scale.set_identity();
+  scale[0][0] = 1.5; scale[1][1] = 0.5; scale[2][2] = 2;
+  center = fib->GetGeometry()->GetCenter();
+  before = fib->GetFiberPolyData();
+  fib->ScaleFibers(1.5, 0.5, 2);
+  MITK_TEST_CONDITION(EqualFibers(fib, ReferenceTransform(before, scale, center, noTranslation), tolerance), "ScaleFibers()")
+
+  vnl_matrix_fixed< double, 3, 3 > identity; identity.set_identity();
+  mitk::Point3D origin; origin.Fill(0);
+  mitk::Vector3D translation; translation[0] = 3; translation[1] = -7.5; translation[2] = 0.25;
+  before = fib->GetFiberPolyData();
+  fib->TranslateFibers(3, -7.5, 0.25);
+  MITK_TEST_CONDITION(EqualFibers(fib, ReferenceTransform(before, identity, origin, translation), tolerance), "TranslateFibers()")
+
+  vnl_matrix_fixed< double, 3, 3 > mirror; mirror.set_identity();
+  mirror[1][1] = -1;
+  before = fib->GetFiberPolyData();
+  fib->MirrorFibers(1);
+  MITK_TEST_CONDITION(EqualFibers(fib, ReferenceTransform(before, mirror, origin, noTranslation), tolerance), "MirrorFibers()")
+  MITK_TEST_CONDITION(EqualLengthStatistics(fib, fib->GetFiberPolyData()), "Fiber lengths after the transformations")
+
+  // the corners have a radius of about 0.57, the helices a radius of more than 10
+  mitk::FiberBundleX::Pointer split = mitk::FiberBundleX::New(input);
+  MITK_TEST_CONDITION(split->ApplyCurvatureThreshold(2, false), "ApplyCurvatureThreshold() splitting fibers")
+  MITK_TEST_CONDITION(EqualFibers(split, ReferenceCurvatureThreshold(input, 2, false), tolerance), "ApplyCurvatureThreshold() splits the fibers at sharp corners")
+  MITK_TEST_CONDITION(split->GetNumFibers()>input->GetNumberOfCells(), "ApplyCurvatureThreshold() creates more fibers")
+
+  mitk::FiberBundleX::Pointer removed = mitk::FiberBundleX::New(input);
+  MITK_TEST_CONDITION(removed->ApplyCurvatureThreshold(2, true), "ApplyCurvatureThreshold() deleting fibers")
+  MITK_TEST_CONDITION(EqualFibers(removed, ReferenceCurvatureThreshold(input, 2, true), tolerance), "ApplyCurvatureThreshold() removes the fibers with sharp corners")
+
+  mitk::FiberBundleX::Pointer shortRemoved = mitk::FiberBundleX::New(input);
+  float minLength = shortRemoved->GetMeanFiberLength();
+  MITK_TEST_CONDITION(shortRemoved->RemoveShortFibers(minLength), "RemoveShortFibers()")
+  MITK_TEST_CONDITION(EqualFibers(shortRemoved, ReferenceLengthThreshold(input, minLength, itk::NumericTraits<float>::max()), 0), "RemoveShortFibers() keeps the long fibers")
+
+  mitk::FiberBundleX::Pointer longRemoved = mitk::FiberBundleX::New(input);
+  float maxLength = longRemoved->GetMeanFiberLength();
+  MITK_TEST_CONDITION(longRemoved->RemoveLongFibers(maxLength), "RemoveLongFibers()")
+  MITK_TEST_CONDITION(EqualFibers(longRemoved, ReferenceLengthThreshold(input, itk::NumericTraits<float>::NonpositiveMin(), maxLength), 0), "RemoveLongFibers() keeps the short fibers")
+
+  MITK_TEST_END();
+}
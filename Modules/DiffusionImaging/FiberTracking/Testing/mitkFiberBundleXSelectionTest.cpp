@@ -0,0 +1,428 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkTestingMacros.h"
+
+#include <mitkFiberBundleX.h>
+#include <mitkPlanarCircle.h>
+#include <mitkPlanarPolygon.h>
+#include <mitkPlanarFigureComposite.h>
+#include <mitkPlaneGeometry.h>
+
+#include <vtkCell.h>
+#include <vtkCellArray.h>
+#include <vtkCellData.h>
+#include <vtkClipPolyData.h>
+#include <vtkIdFilter.h>
+#include <vtkPlane.h>
+#include <vtkPointData.h>
+#include <vtkPoints.h>
+#include <vtkPolygon.h>
+#include <vtkPolyLine.h>
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <vector>
+
+typedef mitk::FiberBundleX::ItkUcharImgType UcharImageType;
+
+// The reference implementations below are the vtkClipPolyData based ROI selection and the per cell mask selection
+// that FiberBundleX used before the fibers were selected through its spatial index.
+
+static std::vector<long> ReferenceFigureIds(mitk::FiberBundleX* fib, mitk::PlanarFigure* pf)
+{
+  std::vector<long> FibersInROI;
+
+  vtkSmartPointer<vtkIdFilter> idFiberFilter = vtkSmartPointer<vtkIdFilter>::New();
+  idFiberFilter->SetInput(fib->GetFiberPolyData());
+  idFiberFilter->CellIdsOn();
+  idFiberFilter->SetIdsArrayName(mitk::FiberBundleX::FIBER_ID_ARRAY);
+  idFiberFilter->FieldDataOn();
+  idFiberFilter->Update();
+
+  const mitk::PlaneGeometry* planeGeometry = dynamic_cast<const mitk::PlaneGeometry*>(pf->GetGeometry2D());
+  mitk::Vector3D planeNormal = planeGeometry->GetNormal();
+  planeNormal.Normalize();
+  mitk::Point3D planeOrigin = planeGeometry->GetOrigin();
+
+  vtkSmartPointer<vtkPlane> plane = vtkSmartPointer<vtkPlane>::New();
+  plane->SetOrigin(planeOrigin[0],planeOrigin[1],planeOrigin[2]);
+  plane->SetNormal(planeNormal[0],planeNormal[1],planeNormal[2]);
+
+  vtkSmartPointer<vtkClipPolyData> clipper = vtkSmartPointer<vtkClipPolyData>::New();
+  clipper->SetInput(idFiberFilter->GetOutput());
+  clipper->SetClipFunction(plane);
+  clipper->GenerateClipScalarsOn();
+  clipper->GenerateClippedOutputOn();
+  vtkSmartPointer<vtkPolyData> clipperout = clipper->GetClippedOutput();
+  clipperout->GetPointData()->Initialize();
+  clipperout->Update();
+
+  // points with distance 0 to the plane
+  std::vector<int> PointsOnPlane;
+  vtkSmartPointer<vtkDataArray> distanceList = clipperout->GetPointData()->GetScalars();
+  for (int i=0; i<distanceList->GetNumberOfTuples(); ++i)
+  {
+    double *distance = distanceList->GetTuple(i);
+    if (distance[0] >= -0.01 && distance[0] <= 0.01)
+      PointsOnPlane.push_back(i);
+  }
+
+  // points on the plane inside the figure
+  std::vector<int> PointsInROI;
+  if (dynamic_cast<mitk::PlanarCircle*>(pf)!=NULL)
+  {
+    mitk::Point3D V1w = pf->GetWorldControlPoint(0);
+    mitk::Point3D V2w = pf->GetWorldControlPoint(1);
+    double distPF = V1w.EuclideanDistanceTo(V2w);
+
+    for (unsigned int i=0; i<PointsOnPlane.size(); i++)
+    {
+      double* p = clipperout->GetPoint(PointsOnPlane[i]);
+      double XdistPnt = sqrt((p[0]-V1w[0])*(p[0]-V1w[0]) + (p[1]-V1w[1])*(p[1]-V1w[1]) + (p[2]-V1w[2])*(p[2]-V1w[2]));
+      if (XdistPnt <= distPF)
+        PointsInROI.push_back(PointsOnPlane[i]);
+    }
+  }
+  else
+  {
+    vtkSmartPointer<vtkPolygon> polygonVtk = vtkSmartPointer<vtkPolygon>::New();
+    for (unsigned int i=0; i<pf->GetNumberOfControlPoints(); ++i)
+      polygonVtk->GetPoints()->InsertNextPoint(pf->GetWorldControlPoint(i)[0], pf->GetWorldControlPoint(i)[1], pf->GetWorldControlPoint(i)[2]);
+
+    double n[3];
+    polygonVtk->ComputeNormal(polygonVtk->GetPoints()->GetNumberOfPoints(),
+                              static_cast<double*>(polygonVtk->GetPoints()->GetData()->GetVoidPointer(0)), n);
+    double bounds[6];
+    polygonVtk->GetPoints()->GetBounds(bounds);
+
+    for (unsigned int i=0; i<PointsOnPlane.size(); i++)
+    {
+      double checkIn[3] = {clipperout->GetPoint(PointsOnPlane[i])[0], clipperout->GetPoint(PointsOnPlane[i])[1], clipperout->GetPoint(PointsOnPlane[i])[2]};
+      int isInPolygon = polygonVtk->PointInPolygon(checkIn, polygonVtk->GetPoints()->GetNumberOfPoints(),
+                                                   static_cast<double*>(polygonVtk->GetPoints()->GetData()->GetVoidPointer(0)), bounds, n);
+      if (isInPolygon)
+        PointsInROI.push_back(PointsOnPlane[i]);
+    }
+  }
+
+  // fiber ids of the points, the clipped lines consist of two points each
+  std::vector<long> pointindexFiberMap(clipperout->GetNumberOfPoints());
+  vtkCellArray *clipperlines = clipperout->GetLines();
+  for (int i=0, ic=0; i<clipperlines->GetNumberOfCells(); i++, ic+=3)
+  {
+    vtkIdType npts;
+    vtkIdType *pts;
+    clipperlines->GetCell(ic, npts, pts);
+    for (long j=0; j<npts; j++)
+      pointindexFiberMap[pts[j]] = clipperout->GetCellData()->GetArray(mitk::FiberBundleX::FIBER_ID_ARRAY)->GetTuple(i)[0];
+  }
+
+  for (unsigned int k=0; k<PointsInROI.size(); k++)
+    FibersInROI.push_back(pointindexFiberMap[PointsInROI[k]]);
+
+  std::sort(FibersInROI.begin(), FibersInROI.end());
+  FibersInROI.erase(std::unique(FibersInROI.begin(), FibersInROI.end()), FibersInROI.end());
+  return FibersInROI;
+}
+
+static std::vector<long> ReferenceIds(mitk::FiberBundleX* fib, mitk::PlanarFigure* pf)
+{
+  mitk::PlanarFigureComposite* pfcomp = dynamic_cast<mitk::PlanarFigureComposite*>(pf);
+  if (pfcomp==NULL)
+    return ReferenceFigureIds(fib, pf);
+
+  std::vector<long> result = ReferenceIds(fib, pfcomp->getChildAt(0));
+  if (pfcomp->getOperationType()==mitk::PFCOMPOSITION_NOT_OPERATION)
+  {
+    std::vector<long> all;
+    for (long i=0; i<fib->GetNumFibers(); i++)
+      all.push_back(i);
+    std::vector<long> difference;
+    std::set_difference(all.begin(), all.end(), result.begin(), result.end(), std::back_inserter(difference));
+    result = difference;
+  }
+  for (int i=1; i<pfcomp->getNumberOfChildren(); i++)
+  {
+    std::vector<long> child = ReferenceIds(fib, pfcomp->getChildAt(i));
+    std::vector<long> combined;
+    if (pfcomp->getOperationType()==mitk::PFCOMPOSITION_AND_OPERATION)
+      std::set_intersection(result.begin(), result.end(), child.begin(), child.end(), std::back_inserter(combined));
+    else if (pfcomp->getOperationType()==mitk::PFCOMPOSITION_OR_OPERATION)
+      std::set_union(result.begin(), result.end(), child.begin(), child.end(), std::back_inserter(combined));
+    else
+      std::set_difference(result.begin(), result.end(), child.begin(), child.end(), std::back_inserter(combined));
+    result = combined;
+  }
+  return result;
+}
+
+static bool IsInside(UcharImageType* mask, double* p)
+{
+  itk::Point<float, 3> itkP;
+  itkP[0] = p[0]; itkP[1] = p[1]; itkP[2] = p[2];
+  itk::Index<3> idx;
+  mask->TransformPhysicalPointToIndex(itkP, idx);
+  // the former code read the pixel before checking the region
+  return mask->GetLargestPossibleRegion().IsInside(idx) && mask->GetPixel(idx)>0;
+}
+
+static std::vector<long> ReferenceMaskIds(mitk::FiberBundleX* fib, UcharImageType* mask, bool anyPoint)
+{
+  vtkSmartPointer<vtkPolyData> polyData = fib->GetFiberPolyData();
+  vtkSmartPointer<vtkPolyData> polyDataOriginal = fib->GetFiberPolyData();
+  if (anyPoint)
+  {
+    float minSpacing = std::min(mask->GetSpacing()[0], std::min(mask->GetSpacing()[1], mask->GetSpacing()[2]));
+    mitk::FiberBundleX::Pointer fibCopy = fib->GetDeepCopy();
+    fibCopy->ResampleFibers(minSpacing/10);
+    polyData = fibCopy->GetFiberPolyData();
+  }
+
+  std::vector<long> ids;
+  for (int i=0; i<fib->GetNumFibers(); i++)
+  {
+    vtkCell* cell = polyData->GetCell(i);
+    int numPoints = cell->GetNumberOfPoints();
+    vtkPoints* points = cell->GetPoints();
+
+    vtkCell* cellOriginal = polyDataOriginal->GetCell(i);
+    int numPointsOriginal = cellOriginal->GetNumberOfPoints();
+    vtkPoints* pointsOriginal = cellOriginal->GetPoints();
+
+    if (numPoints<=1 || numPointsOriginal==0)
+      continue;
+
+    if (anyPoint)
+    {
+      for (int j=0; j<numPoints; j++)
+        if (IsInside(mask, points->GetPoint(j)))
+        {
+          ids.push_back(i);
+          break;
+        }
+    }
+    else if (IsInside(mask, pointsOriginal->GetPoint(0)) && IsInside(mask, pointsOriginal->GetPoint(numPointsOriginal-1)))
+      ids.push_back(i);
+  }
+  return ids;
+}
+
+// straight fibers with their points at integer x and z coordinates, so no point lies on the planes and mask borders below
+static vtkSmartPointer<vtkPolyData> CreateFibers()
+{
+  vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
+  vtkSmartPointer<vtkCellArray> cells = vtkSmartPointer<vtkCellArray>::New();
+  for (int a=-8; a<=8; a+=2)
+    for (int b=-8; b<=8; b+=2)
+      for (int dx=-2; dx<=2; dx+=2)
+      {
+        vtkSmartPointer<vtkPolyLine> container = vtkSmartPointer<vtkPolyLine>::New();
+        for (int k=0; k<=20; k++)
+          container->GetPointIds()->InsertNextId(points->InsertNextPoint(a+dx*k, b+0.3*k*sin((double)a+b), k-5));
+        cells->InsertNextCell(container);
+      }
+  vtkSmartPointer<vtkPolyData> polyData = vtkSmartPointer<vtkPolyData>::New();
+  polyData->SetPoints(points);
+  polyData->SetLines(cells);
+  return polyData;
+}
+
+// control points are clamped to the bounds of the plane, so (x,y,z) is at the 2D point (Offset,Offset)
+static const double Offset = 50;
+
+static mitk::PlaneGeometry::Pointer CreatePlane(mitk::PlaneGeometry::PlaneOrientation orientation, double x, double y, double z)
+{
+  mitk::Vector3D spacing;
+  spacing.Fill(1);
+  mitk::PlaneGeometry::Pointer planeGeometry = mitk::PlaneGeometry::New();
+  planeGeometry->InitializeStandardPlane(100.0, 100.0, spacing, orientation);
+  mitk::Vector3D right = planeGeometry->GetAxisVector(0);
+  mitk::Vector3D down = planeGeometry->GetAxisVector(1);
+  right.Normalize();
+  down.Normalize();
+  mitk::Point3D origin;
+  origin[0] = x; origin[1] = y; origin[2] = z;
+  planeGeometry->SetOrigin(origin-right*Offset-down*Offset);
+  return planeGeometry;
+}
+
+static mitk::PlanarFigure::Pointer CreateCircle(mitk::PlaneGeometry* plane, double x, double y, double radius)
+{
+  mitk::PlanarCircle::Pointer circle = mitk::PlanarCircle::New();
+  circle->SetGeometry2D(plane);
+  mitk::Point2D p;
+  p[0] = Offset+x; p[1] = Offset+y;
+  circle->PlaceFigure(p);
+  p[0] += radius;
+  circle->SetControlPoint(1, p, true);
+  return circle.GetPointer();
+}
+
+static mitk::PlanarFigure::Pointer CreatePolygon(mitk::PlaneGeometry* plane, const double (*points)[2], unsigned int numPoints)
+{
+  mitk::PlanarPolygon::Pointer polygon = mitk::PlanarPolygon::New();
+  polygon->SetGeometry2D(plane);
+  mitk::Point2D p;
+  p[0] = Offset+points[0][0]; p[1] = Offset+points[0][1];
+  polygon->PlaceFigure(p);
+  for (unsigned int i=1; i<numPoints; i++)
+  {
+    p[0] = Offset+points[i][0]; p[1] = Offset+points[i][1];
+    polygon->SetControlPoint(i, p, true);
+  }
+  return polygon.GetPointer();
+}
+
+static mitk::PlanarFigure::Pointer CreateComposite(mitk::PFCompositionOperation operation, mitk::PlanarFigure* first, mitk::PlanarFigure* second)
+{
+  mitk::PlanarFigureComposite::Pointer composite = mitk::PlanarFigureComposite::New();
+  composite->setOperationType(operation);
+  composite->addPlanarFigure(first);
+  if (second!=NULL)
+    composite->addPlanarFigure(second);
+  return composite.GetPointer();
+}
+
+static bool EqualFibers(vtkPolyData* a, vtkPolyData* b)
+{
+  if (a->GetNumberOfLines()!=b->GetNumberOfLines())
+    return false;
+  for (int i=0; i<a->GetNumberOfCells(); i++)
+  {
+    vtkCell* cellA = a->GetCell(i);
+    vtkCell* cellB = b->GetCell(i);
+    if (cellA->GetNumberOfPoints()!=cellB->GetNumberOfPoints())
+      return false;
+    for (int j=0; j<cellA->GetNumberOfPoints(); j++)
+    {
+      double* pA = cellA->GetPoints()->GetPoint(j);
+      double* pB = cellB->GetPoints()->GetPoint(j);
+      if (pA[0]!=pB[0] || pA[1]!=pB[1] || pA[2]!=pB[2])
+        return false;
+    }
+  }
+  return true;
+}
+
+static void TestPlanarFigureSelection(mitk::FiberBundleX* fib)
+{
+  mitk::PlaneGeometry::Pointer axial = CreatePlane(mitk::PlaneGeometry::Axial, 0, 0, 10.5);
+  mitk::PlaneGeometry::Pointer axial2 = CreatePlane(mitk::PlaneGeometry::Axial, 0, 0, 3.5);
+  mitk::PlaneGeometry::Pointer sagittal = CreatePlane(mitk::PlaneGeometry::Sagittal, 2.5, 0, 0);
+
+  const double concave[5][2] = { {-4.1,-3.2}, {6.3,-5.4}, {1.7,0.6}, {7.9,4.2}, {-5.8,8.7} };
+  const double quad[4][2] = { {-9.3,-2.1}, {3.4,-6.7}, {5.2,3.3}, {-2.6,7.1} };
+
+  mitk::PlanarFigure::Pointer circle = CreateCircle(axial, 0.37, -0.21, 6.3);
+  mitk::PlanarFigure::Pointer polygon = CreatePolygon(axial2, quad, 4);
+  mitk::PlanarFigure::Pointer sagittalPolygon = CreatePolygon(sagittal, concave, 5);
+  std::vector<mitk::PlanarFigure::Pointer> figures;
+  figures.push_back(circle);
+  figures.push_back(polygon);
+  figures.push_back(sagittalPolygon);
+  for (unsigned int i=0; i<figures.size(); i++)
+  {
+    std::vector<long> ids = ReferenceIds(fib, figures[i]);
+    MITK_TEST_CONDITION_REQUIRED(!ids.empty() && (long)ids.size()<fib->GetNumFibers(), "ROI " << i << " selects a part of the fibers")
+  }
+  figures.push_back(CreateComposite(mitk::PFCOMPOSITION_AND_OPERATION, circle, sagittalPolygon));
+  figures.push_back(CreateComposite(mitk::PFCOMPOSITION_OR_OPERATION, circle, polygon));
+  figures.push_back(CreateComposite(mitk::PFCOMPOSITION_NOT_OPERATION, circle, NULL));
+  figures.push_back(CreateComposite(mitk::PFCOMPOSITION_AND_OPERATION, CreateComposite(mitk::PFCOMPOSITION_OR_OPERATION, circle, polygon),
+                                    CreateComposite(mitk::PFCOMPOSITION_NOT_OPERATION, sagittalPolygon, NULL)));
+
+  for (unsigned int i=0; i<figures.size(); i++)
+  {
+    std::vector<long> expected = ReferenceIds(fib, figures[i]);
+    std::vector<long> ids = fib->ExtractFiberIdSubset(figures[i]);
+    MITK_TEST_CONDITION(ids==expected, "Fibers of ROI " << i << " equal the ones of the former clipping code (" << ids.size() << " fibers)")
+
+    mitk::FiberBundleX::Pointer subset = fib->ExtractFiberSubset(figures[i]);
+    MITK_TEST_CONDITION(EqualFibers(subset->GetFiberPolyData(), fib->GeneratePolyDataByIds(expected)), "ExtractFiberSubset() of ROI " << i)
+  }
+
+  // moved control points are not answered from the cache
+  mitk::Point2D p;
+  p[0] = Offset+3.1; p[1] = Offset+1.4;
+  circle->SetControlPoint(0, p);
+  p[0] += 4.9;
+  circle->SetControlPoint(1, p);
+  MITK_TEST_CONDITION(fib->ExtractFiberIdSubset(circle)==ReferenceIds(fib, circle), "Fibers of the moved circle equal the ones of the former clipping code")
+}
+
+static UcharImageType::Pointer CreateMask()
+{
+  UcharImageType::Pointer mask = UcharImageType::New();
+  UcharImageType::SizeType size;
+  size[0] = 120; size[1] = 40; size[2] = 30;
+  UcharImageType::IndexType start;
+  start.Fill(0);
+  mask->SetRegions(UcharImageType::RegionType(start, size));
+  UcharImageType::PointType origin;
+  origin[0] = -60; origin[1] = -20; origin[2] = -10;
+  mask->SetOrigin(origin);
+  mask->Allocate();
+  mask->FillBuffer(0);
+  return mask;
+}
+
+// voxels with center x in [x0,x1] and z in [z0,z1]
+static void FillSlab(UcharImageType* mask, int x0, int x1, int z0, int z1)
+{
+  UcharImageType::IndexType idx;
+  for (idx[0]=x0+60; idx[0]<=x1+60; idx[0]++)
+    for (idx[1]=0; idx[1]<40; idx[1]++)
+      for (idx[2]=z0+10; idx[2]<=z1+10; idx[2]++)
+        mask->SetPixel(idx, 1);
+}
+
+static void TestMaskSelection(mitk::FiberBundleX* fib)
+{
+  // a box which the fibers pass
+  UcharImageType::Pointer box = CreateMask();
+  FillSlab(box, -3, 4, 3, 6);
+  std::vector<long> expected = ReferenceMaskIds(fib, box, true);
+  mitk::FiberBundleX::Pointer subset = fib->ExtractFiberSubset(box, true);
+  MITK_TEST_CONDITION(!expected.empty() && (long)expected.size()<fib->GetNumFibers() && EqualFibers(subset->GetFiberPolyData(), fib->GeneratePolyDataByIds(expected)),
+                      "Fibers passing the mask equal the ones of the former per fiber code (" << expected.size() << " fibers)")
+
+  // start and end regions
+  UcharImageType::Pointer ends = CreateMask();
+  FillSlab(ends, -5, 5, -10, -4);
+  FillSlab(ends, -60, 59, 14, 19);
+  expected = ReferenceMaskIds(fib, ends, false);
+  subset = fib->ExtractFiberSubset(ends, false);
+  MITK_TEST_CONDITION(!expected.empty() && (long)expected.size()<fib->GetNumFibers() && EqualFibers(subset->GetFiberPolyData(), fib->GeneratePolyDataByIds(expected)),
+                      "Fibers ending in the mask equal the ones of the former per fiber code (" << expected.size() << " fibers)")
+}
+
+/**Documentation
+ *  Test for the ROI selection of FiberBundleX through its spatial index
+ */
+int mitkFiberBundleXSelectionTest(int /*argc*/, char* /*argv*/[])
+{
+  MITK_TEST_BEGIN("mitkFiberBundleXSelectionTest");
+
+  mitk::FiberBundleX::Pointer fib = mitk::FiberBundleX::New(CreateFibers());
+  MITK_TEST_CONDITION_REQUIRED(fib->GetNumFibers()==243, "Creating fibers")
+
+  TestPlanarFigureSelection(fib);
+  TestMaskSelection(fib);
+
+  MITK_TEST_END();
+}
@@ -0,0 +1,123 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkTestingMacros.h"
+
+#include <mitkFiberColumnStore.h>
+
+#include <vtkCellArray.h>
+#include <vtkPoints.h>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+// counts how often each fiber is visited, each fiber has to be visited exactly once
+class CountPointsProcessor : public mitk::FiberColumnStore::FiberProcessor
+{
+public:
+
+  CountPointsProcessor(unsigned int numFibers) : m_Visits(numFibers, 0) {}
+
+  void ProcessFibers(const mitk::FiberColumnStore&, unsigned int firstFiber, unsigned int lastFiber, unsigned int)
+  {
+    for (unsigned int i=firstFiber; i<lastFiber; i++)
+      m_Visits[i]++;
+  }
+
+  std::vector<int> m_Visits;
+};
+
+static bool EqualFibers(const mitk::FiberColumnStore& a, const mitk::FiberColumnStore& b, float tolerance)
+{
+  if (a.GetNumberOfFibers()!=b.GetNumberOfFibers() || a.GetNumberOfPoints()!=b.GetNumberOfPoints())
+    return false;
+  for (unsigned int i=0; i<a.GetNumberOfFibers(); i++)
+  {
+    if (a.GetNumberOfPoints(i)!=b.GetNumberOfPoints(i))
+      return false;
+    for (unsigned int j=0; j<3*a.GetNumberOfPoints(i); j++)
+      if (std::fabs(a.GetPoints(i)[j]-b.GetPoints(i)[j])>tolerance)
+        return false;
+  }
+  return true;
+}
+
+/**Documentation
+ *  Test for the columnar point storage of FiberBundleX
+ */
+int mitkFiberColumnStoreTest(int /*argc*/, char* /*argv*/[])
+{
+  MITK_TEST_BEGIN("mitkFiberColumnStoreTest");
+
+  // fibers of different length with negative and positive coordinates
+  std::vector<mitk::FiberColumnStore> parts(3);
+  mitk::FiberColumnStore fibers;
+  std::vector<double> points;
+  for (unsigned int i=0; i<100; i++)
+  {
+    points.clear();
+    for (unsigned int j=0; j<2+i%7; j++)
+    {
+      points.push_back(-50.0+i+0.37*j);
+      points.push_back(20.0*std::sin(0.1*i*j));
+      points.push_back(0.5*j-i%13);
+    }
+    fibers.AddFiber(&points[0], points.size()/3);
+    parts[i%3==0 ? 0 : i<60 ? 1 : 2].AddFiber(&points[0], points.size()/3);
+  }
+  MITK_TEST_CONDITION(fibers.GetNumberOfFibers()==100, "AddFiber()")
+  MITK_TEST_CONDITION(fibers.GetNumberOfPoints(5)==7 && fibers.GetFirstPoint(1)==2, "GetNumberOfPoints(), GetFirstPoint()")
+
+  mitk::FiberColumnStore concatenated;
+  concatenated.Concatenate(parts);
+  MITK_TEST_CONDITION(concatenated.GetNumberOfFibers()==100 && concatenated.GetNumberOfPoints()==fibers.GetNumberOfPoints(), "Concatenate()")
+  unsigned int firstOfPart1 = parts[0].GetNumberOfFibers();
+  MITK_TEST_CONDITION(concatenated.GetNumberOfPoints(firstOfPart1)==parts[1].GetNumberOfPoints(0) && concatenated.GetPoints(firstOfPart1)[0]==parts[1].GetPoints(0)[0], "Concatenate() keeps the order of the parts")
+
+  vtkSmartPointer<vtkPolyData> polyData = fibers.GetPolyData();
+  MITK_TEST_CONDITION(polyData->GetNumberOfLines()==100 && polyData->GetNumberOfPoints()==fibers.GetNumberOfPoints(), "GetPolyData()")
+
+  mitk::FiberColumnStore imported;
+  vtkSmartPointer<vtkPolyData> importedPolyData = imported.Import(polyData);
+  MITK_TEST_CONDITION(EqualFibers(imported, fibers, 0), "Import()")
+  MITK_TEST_CONDITION(importedPolyData->GetPoints()->GetData()==polyData->GetPoints()->GetData(), "Import() of GetPolyData() does not copy the points")
+
+  // add a single point line in front, which is skipped and forces a copy
+  vtkSmartPointer<vtkCellArray> lines = vtkSmartPointer<vtkCellArray>::New();
+  vtkIdType single = 0;
+  lines->InsertNextCell(1, &single);
+  vtkIdType numLines = polyData->GetLines()->GetNumberOfCells();
+  polyData->GetLines()->InitTraversal();
+  for (vtkIdType i=0; i<numLines; i++)
+  {
+    vtkIdType numPoints;
+    vtkIdType* ids;
+    polyData->GetLines()->GetNextCell(numPoints, ids);
+    lines->InsertNextCell(numPoints, ids);
+  }
+  vtkSmartPointer<vtkPolyData> withSinglePoint = vtkSmartPointer<vtkPolyData>::New();
+  withSinglePoint->SetPoints(polyData->GetPoints());
+  withSinglePoint->SetLines(lines);
+  imported.Import(withSinglePoint);
+  MITK_TEST_CONDITION(EqualFibers(imported, fibers, 0), "Import() skips lines with less than two points")
+
+  CountPointsProcessor counter(fibers.GetNumberOfFibers());
+  fibers.ProcessFibers(&counter, 7);
+  MITK_TEST_CONDITION(std::count(counter.m_Visits.begin(), counter.m_Visits.end(), 1)==100, "ProcessFibers() visits every fiber once")
+
+  MITK_TEST_END();
+}
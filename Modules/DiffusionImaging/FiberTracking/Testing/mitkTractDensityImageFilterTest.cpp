@@ -0,0 +1,226 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkTestingMacros.h"
+
+#include <mitkFiberBundleX.h>
+#include <itkFiberPointToIndexTransform.h>
+#include <itkTractDensityImageFilter.h>
+
+#include <itkImage.h>
+#include <itkImageRegionConstIterator.h>
+#include <vnl/vnl_math.h>
+
+#include <vtkCellArray.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkPolyLine.h>
+
+#include <cmath>
+#include <vector>
+
+typedef itk::Image<float, 3> FloatImageType;
+typedef itk::Image<unsigned char, 3> UcharImageType;
+
+// anisotropic spacing and a direction rotated around two axes
+template< class TImage >
+static typename TImage::Pointer CreateObliqueImage()
+{
+  typename TImage::Pointer image = TImage::New();
+  typename TImage::SizeType size;
+  size[0] = 24; size[1] = 20; size[2] = 16;
+  typename TImage::IndexType start;
+  start.Fill(0);
+  image->SetRegions(typename TImage::RegionType(start, size));
+
+  typename TImage::SpacingType spacing;
+  spacing[0] = 0.7; spacing[1] = 1.3; spacing[2] = 2.1;
+  image->SetSpacing(spacing);
+
+  typename TImage::PointType origin;
+  origin[0] = -10; origin[1] = 5; origin[2] = 3;
+  image->SetOrigin(origin);
+
+  double a = 30*vnl_math::pi/180, b = 20*vnl_math::pi/180;
+  typename TImage::DirectionType rotZ, rotX;
+  rotZ.SetIdentity();
+  rotZ[0][0] = cos(a); rotZ[0][1] = -sin(a);
+  rotZ[1][0] = sin(a); rotZ[1][1] = cos(a);
+  rotX.SetIdentity();
+  rotX[1][1] = cos(b); rotX[1][2] = -sin(b);
+  rotX[2][1] = sin(b); rotX[2][2] = cos(b);
+  image->SetDirection(rotZ*rotX);
+
+  image->Allocate();
+  image->FillBuffer(0);
+  return image;
+}
+
+// fibers that run through the image, with points given in index coordinates of the image
+static vtkSmartPointer<vtkPolyData> CreateFibers(FloatImageType* image)
+{
+  vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
+  vtkSmartPointer<vtkCellArray> cells = vtkSmartPointer<vtkCellArray>::New();
+  for (int i=0; i<50; i++)
+  {
+    vtkSmartPointer<vtkPolyLine> container = vtkSmartPointer<vtkPolyLine>::New();
+    for (int j=0; j<=20; j++)
+    {
+      itk::ContinuousIndex<double, 3> index;
+      index[0] = 1.5+j;
+      index[1] = 9.5+6*sin(0.3*j+0.2*i);
+      index[2] = 2.5+0.2*i+0.1*j;
+      FloatImageType::PointType p;
+      image->TransformContinuousIndexToPhysicalPoint(index, p);
+      container->GetPointIds()->InsertNextId(points->InsertNextPoint(p[0], p[1], p[2]));
+    }
+    cells->InsertNextCell(container);
+  }
+  vtkSmartPointer<vtkPolyData> polyData = vtkSmartPointer<vtkPolyData>::New();
+  polyData->SetPoints(points);
+  polyData->SetLines(cells);
+  return polyData;
+}
+
+static void TestFiberPointToIndexTransform()
+{
+  FloatImageType::Pointer image = CreateObliqueImage<FloatImageType>();
+  itk::FiberPointToIndexTransform transform;
+  transform.SetImage(image.GetPointer());
+
+  vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
+  std::vector<vtkIdType> ids;
+  bool samePoints = true;
+  for (int i=0; i<100; i++)
+  {
+    FloatImageType::PointType p;
+    p[0] = -12.0+0.37*i;
+    p[1] = 20.0*sin(0.1*i);
+    p[2] = 40.0-0.61*i;
+    itk::ContinuousIndex<double, 3> expected;
+    image->TransformPhysicalPointToContinuousIndex(p, expected);
+
+    double point[3] = {p[0], p[1], p[2]};
+    double index[3];
+    transform.TransformPoint(point, index);
+    for (int k=0; k<3; k++)
+      samePoints &= std::fabs(index[k]-expected[k])<1e-9;
+
+    // every other point of the array is part of the fiber
+    points->InsertNextPoint(point);
+    points->InsertNextPoint(-point[0], point[2], point[1]);
+    ids.push_back(2*i);
+  }
+  MITK_TEST_CONDITION(samePoints, "TransformPoint() gives the continuous index of TransformPhysicalPointToContinuousIndex() on an oblique image")
+
+  std::vector<double> indices;
+  transform.TransformFiber(points, &ids[0], ids.size(), indices);
+  bool sameFiber = indices.size()==3*ids.size();
+  for (unsigned int j=0; sameFiber && j<ids.size(); j++)
+  {
+    double index[3];
+    transform.TransformPoint(points->GetPoint(ids[j]), index);
+    for (int k=0; k<3; k++)
+      sameFiber &= std::fabs(indices[3*j+k]-index[k])<1e-12;
+  }
+  MITK_TEST_CONDITION(sameFiber, "TransformFiber() transforms the points of the fiber ids")
+}
+
+template< class TImage >
+static typename TImage::Pointer GenerateDensity(mitk::FiberBundleX* fib, TImage* geometryImage, bool binary, unsigned int numThreads)
+{
+  typename itk::TractDensityImageFilter< TImage >::Pointer filter = itk::TractDensityImageFilter< TImage >::New();
+  filter->SetFiberBundle(fib);
+  filter->SetInputImage(geometryImage);
+  filter->SetUseImageGeometry(true);
+  filter->SetBinaryOutput(binary);
+  filter->SetOutputAbsoluteValues(true);
+  filter->SetNumberOfThreads(numThreads);
+  filter->Update();
+  return filter->GetOutput();
+}
+
+template< class TImage >
+static bool EqualImages(TImage* a, TImage* b, double tolerance, bool& nonZero)
+{
+  if (a->GetLargestPossibleRegion()!=b->GetLargestPossibleRegion())
+    return false;
+  nonZero = false;
+  itk::ImageRegionConstIterator<TImage> itA(a, a->GetLargestPossibleRegion());
+  itk::ImageRegionConstIterator<TImage> itB(b, b->GetLargestPossibleRegion());
+  for (itA.GoToBegin(), itB.GoToBegin(); !itA.IsAtEnd(); ++itA, ++itB)
+  {
+    if (std::fabs((double)itA.Get()-(double)itB.Get())>tolerance)
+      return false;
+    nonZero |= itA.Get()!=0;
+  }
+  return true;
+}
+
+static void TestThreadBufferMemoryLimit()
+{
+  // 1000 byte buffers: one thread needs none, three additional buffers fit into 3500 bytes
+  MITK_TEST_CONDITION(itk::FiberPointToIndexTransform::GetNumberOfThreads(8, 100, 1000, 3500)==4, "Number of threads is limited by the memory of their buffers")
+  MITK_TEST_CONDITION(itk::FiberPointToIndexTransform::GetNumberOfThreads(8, 100, 1000, 0)==1, "One thread is used if no buffer fits")
+  MITK_TEST_CONDITION(itk::FiberPointToIndexTransform::GetNumberOfThreads(8, 3, 1000, 100000)==3, "Number of threads is limited by the number of fibers")
+
+  FloatImageType::Pointer floatGeometry = CreateObliqueImage<FloatImageType>();
+  mitk::FiberBundleX::Pointer fib = mitk::FiberBundleX::New(CreateFibers(floatGeometry));
+  itk::TractDensityImageFilter< FloatImageType >::Pointer filter = itk::TractDensityImageFilter< FloatImageType >::New();
+  filter->SetFiberBundle(fib);
+  filter->SetInputImage(floatGeometry);
+  filter->SetUseImageGeometry(true);
+  filter->SetOutputAbsoluteValues(true);
+  filter->SetNumberOfThreads(4);
+  filter->SetThreadBufferMemoryLimit(0);
+  filter->Update();
+
+  FloatImageType::Pointer single = GenerateDensity<FloatImageType>(fib, floatGeometry, false, 1);
+  bool nonZero;
+  MITK_TEST_CONDITION(EqualImages<FloatImageType>(single, filter->GetOutput(), 0, nonZero) && nonZero, "Tract density image without memory for thread buffers equals the one of a single thread")
+}
+
+static void TestMultiThreadedDensity()
+{
+  FloatImageType::Pointer floatGeometry = CreateObliqueImage<FloatImageType>();
+  UcharImageType::Pointer ucharGeometry = CreateObliqueImage<UcharImageType>();
+  mitk::FiberBundleX::Pointer fib = mitk::FiberBundleX::New(CreateFibers(floatGeometry));
+
+  // the buffers of the threads are added afterwards, so the sums may differ in the last bits
+  FloatImageType::Pointer single = GenerateDensity<FloatImageType>(fib, floatGeometry, false, 1);
+  FloatImageType::Pointer multi = GenerateDensity<FloatImageType>(fib, floatGeometry, false, 4);
+  bool nonZero;
+  MITK_TEST_CONDITION(EqualImages<FloatImageType>(single, multi, 1e-4, nonZero) && nonZero, "Tract density image of four threads equals the one of a single thread")
+
+  UcharImageType::Pointer singleBinary = GenerateDensity<UcharImageType>(fib, ucharGeometry, true, 1);
+  UcharImageType::Pointer multiBinary = GenerateDensity<UcharImageType>(fib, ucharGeometry, true, 4);
+  MITK_TEST_CONDITION(EqualImages<UcharImageType>(singleBinary, multiBinary, 0, nonZero) && nonZero, "Binary tract envelope of four threads equals the one of a single thread")
+}
+
+/**Documentation
+ *  Test for the point to index transform and the multi threaded image generation of TractDensityImageFilter,
+ *  also with a limited memory for the buffers of the threads
+ */
+int mitkTractDensityImageFilterTest(int /*argc*/, char* /*argv*/[])
+{
+  MITK_TEST_BEGIN("mitkTractDensityImageFilterTest");
+
+  TestFiberPointToIndexTransform();
+  TestMultiThreadedDensity();
+  TestThreadBufferMemoryLimit();
+
+  MITK_TEST_END();
+}
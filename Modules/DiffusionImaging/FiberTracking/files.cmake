@@ -9,6 +9,10 @@ set(CPP_FILES
   IODataStructures/FiberBundleX/mitkFiberBundleXIOFactory.cpp
   IODataStructures/FiberBundleX/mitkFiberBundleXWriterFactory.cpp
   IODataStructures/FiberBundleX/mitkFiberBundleXSerializer.cpp
+  IODataStructures/FiberBundleX/mitkFiberBitmap.cpp
+  IODataStructures/FiberBundleX/mitkFiberSpatialIndex.cpp
+  IODataStructures/FiberBundleX/mitkFiberColumnStore.cpp
+  IODataStructures/FiberBundleX/mitkFiberBundleXBinaryFile.cpp
 #  IODataStructures/FiberBundleX/mitkFiberBundleXThreadMonitor.cpp
 
   # DataStructures -> PlanarFigureComposite
@@ -52,6 +56,10 @@ set(H_FILES
   IODataStructures/FiberBundleX/mitkFiberBundleXIOFactory.h
   IODataStructures/FiberBundleX/mitkFiberBundleXWriterFactory.h
   IODataStructures/FiberBundleX/mitkFiberBundleXSerializer.h
+  IODataStructures/FiberBundleX/mitkFiberBitmap.h
+  IODataStructures/FiberBundleX/mitkFiberSpatialIndex.h
+  IODataStructures/FiberBundleX/mitkFiberColumnStore.h
+  IODataStructures/FiberBundleX/mitkFiberBundleXBinaryFile.h
 #  IODataStructures/FiberBundleX/mitkFiberBundleXThreadMonitor.h
 
   IODataStructures/mitkFiberTrackingObjectFactory.h
@@ -60,6 +68,7 @@ set(H_FILES
   Algorithms/itkTractDensityImageFilter.h
   Algorithms/itkTractsToFiberEndingsImageFilter.h
   Algorithms/itkTractsToRgbaImageFilter.h
+  Algorithms/itkFiberPointToIndexTransform.h
   Algorithms/itkElectrostaticRepulsionDiffusionGradientReductionFilter.h
   Algorithms/itkFibersFromPlanarFiguresFilter.h
   Algorithms/itkTractsToDWIImageFilter.h
@@ -0,0 +1,284 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkTestingMacros.h"
+
+#include "itkShortestPathImageFilter.h"
+#include "itkShortestPathCostFunction.h"
+
+#include <itkImage.h>
+#include <itkImageRegionConstIterator.h>
+#include <itkImageRegionIterator.h>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+typedef itk::Image<float, 2> ImageType;
+typedef itk::Image<unsigned char, 2> OutputImageType;
+typedef itk::ShortestPathImageFilter<ImageType, OutputImageType> ShortestPathFilterType;
+typedef std::vector<ImageType::IndexType> PathType;
+
+/**
+ * Costs are the mean of both pixel values times the distance of the pixels.
+ * With random pixel values the shortest path is unique, so paths of different searches can be compared.
+ */
+class PixelValueCostFunction : public itk::ShortestPathCostFunction<ImageType>
+{
+public:
+  typedef PixelValueCostFunction Self;
+  typedef itk::ShortestPathCostFunction<ImageType> Superclass;
+  typedef itk::SmartPointer<Self> Pointer;
+  typedef itk::SmartPointer<const Self> ConstPointer;
+
+  itkNewMacro(Self);
+
+  virtual double GetCost(IndexType p1, IndexType p2)
+  {
+    double squaredDistance = 0.0;
+    for (unsigned int i=0; i<ImageType::ImageDimension; ++i)
+    {
+      double d = p1[i] - p2[i];
+      squaredDistance += d*d;
+    }
+    return std::sqrt(squaredDistance) * 0.5 * (m_Image->GetPixel(p1) + m_Image->GetPixel(p2));
+  }
+
+  virtual double GetMinCost()
+  {
+    return m_MinCost;
+  }
+
+  virtual void Initialize()
+  {
+    itk::ImageRegionConstIterator<ImageType> it(m_Image, m_Image->GetLargestPossibleRegion());
+    m_MinCost = it.Get();
+    for (it.GoToBegin(); !it.IsAtEnd(); ++it)
+    {
+      m_MinCost = std::min<double>(m_MinCost, it.Get());
+    }
+  }
+
+protected:
+  PixelValueCostFunction() : m_MinCost(0.0) {}
+
+  double m_MinCost;
+};
+
+static ImageType::Pointer CreateRandomImage(unsigned int width, unsigned int height)
+{
+  ImageType::Pointer image = ImageType::New();
+  ImageType::SizeType size;
+  size[0] = width;
+  size[1] = height;
+  ImageType::IndexType start;
+  start.Fill(0);
+  image->SetRegions(ImageType::RegionType(start, size));
+  image->Allocate();
+
+  // values in [1, 2), from a fixed linear congruential generator so the test is reproducible
+  unsigned int state = 12345;
+  itk::ImageRegionIterator<ImageType> it(image, image->GetLargestPossibleRegion());
+  for (it.GoToBegin(); !it.IsAtEnd(); ++it)
+  {
+    state = state * 1103515245u + 12345u;
+    it.Set(1.0f + ((state >> 8) & 0xffff) / 65536.0f);
+  }
+  return image;
+}
+
+static PathType SearchPath(ShortestPathFilterType* filter, const ImageType::IndexType& start, const ImageType::IndexType& end)
+{
+  filter->SetStartIndex(start);
+  filter->SetEndIndex(end);
+  filter->Update();
+  return filter->GetVectorPath();
+}
+
+static PathType FreshSearchPath(ImageType* image, PixelValueCostFunction* costFunction, const ImageType::IndexType& start, const ImageType::IndexType& end,
+                                bool fullNeighbors, const ImageType::RegionType& searchRegion)
+{
+  ShortestPathFilterType::Pointer filter = ShortestPathFilterType::New();
+  filter->SetInput(image);
+  filter->SetCostFunction(costFunction);
+  filter->SetFullNeighborsMode(fullNeighbors);
+  filter->SetSearchRegion(searchRegion);
+  return SearchPath(filter, start, end);
+}
+
+// the path starts and ends at the requested points and only makes steps to neighbors
+static bool IsValidPath(const PathType& path, const ImageType::IndexType& start, const ImageType::IndexType& end, bool fullNeighbors)
+{
+  if (path.empty() || path.front() != start || path.back() != end)
+  {
+    return false;
+  }
+  for (unsigned int i=1; i<path.size(); ++i)
+  {
+    int changedCoordinates = 0;
+    for (unsigned int d=0; d<ImageType::ImageDimension; ++d)
+    {
+      long step = path[i][d] - path[i-1][d];
+      if (step < -1 || step > 1)
+      {
+        return false;
+      }
+      if (step != 0)
+      {
+        ++changedCoordinates;
+      }
+    }
+    if (changedCoordinates == 0 || (changedCoordinates > 1 && !fullNeighbors))
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+static ImageType::IndexType MakeIndex(long x, long y)
+{
+  ImageType::IndexType index;
+  index[0] = x;
+  index[1] = y;
+  return index;
+}
+
+static void TestReusedSearchTree()
+{
+  ImageType::Pointer image = CreateRandomImage(40, 30);
+  PixelValueCostFunction::Pointer costFunction = PixelValueCostFunction::New();
+  costFunction->SetImage(image);
+
+  // one filter for all searches keeps its search tree as long as the start point does not change
+  ShortestPathFilterType::Pointer filter = ShortestPathFilterType::New();
+  filter->SetInput(image);
+  filter->SetCostFunction(costFunction);
+  filter->SetFullNeighborsMode(true);
+
+  const ImageType::RegionType wholeImage;
+  std::vector< std::pair<ImageType::IndexType, ImageType::IndexType> > pairs;
+  pairs.push_back(std::make_pair(MakeIndex(3, 4), MakeIndex(35, 25)));
+  pairs.push_back(std::make_pair(MakeIndex(3, 4), MakeIndex(20, 28)));
+  pairs.push_back(std::make_pair(MakeIndex(3, 4), MakeIndex(39, 0)));
+  pairs.push_back(std::make_pair(MakeIndex(3, 4), MakeIndex(5, 5)));
+  pairs.push_back(std::make_pair(MakeIndex(30, 10), MakeIndex(0, 29)));
+  pairs.push_back(std::make_pair(MakeIndex(30, 10), MakeIndex(31, 27)));
+  pairs.push_back(std::make_pair(MakeIndex(30, 10), MakeIndex(3, 4)));
+
+  bool samePaths = true;
+  for (unsigned int i=0; i<pairs.size(); ++i)
+  {
+    PathType reused = SearchPath(filter, pairs[i].first, pairs[i].second);
+    PathType fresh = FreshSearchPath(image, costFunction, pairs[i].first, pairs[i].second, true, wholeImage);
+    if (reused != fresh || !IsValidPath(reused, pairs[i].first, pairs[i].second, true))
+    {
+      MITK_TEST_OUTPUT(<< "Paths differ for search " << i << " from " << pairs[i].first << " to " << pairs[i].second)
+      samePaths = false;
+    }
+  }
+  MITK_TEST_CONDITION(samePaths, "A reused search tree gives the same paths as fresh searches")
+
+  // a point on the last path was closed already, its path is only looked up
+  PathType lastPath = filter->GetVectorPath();
+  ImageType::IndexType onPath = lastPath[lastPath.size()/2];
+  PathType lookedUp = SearchPath(filter, pairs.back().first, onPath);
+  MITK_TEST_CONDITION(filter->GetNumberOfCheckedNodes() == 0, "The path to a closed node is looked up without searching")
+  MITK_TEST_CONDITION(lookedUp == PathType(lastPath.begin(), lastPath.begin() + lastPath.size()/2 + 1), "The looked up path is part of the previous path")
+
+  // changed costs have to invalidate the search tree
+  image->SetPixel(lastPath[lastPath.size()/4], 100.0f);
+  image->Modified();
+  PathType afterChange = SearchPath(filter, pairs.back().first, pairs.back().second);
+  PathType freshAfterChange = FreshSearchPath(image, costFunction, pairs.back().first, pairs.back().second, true, wholeImage);
+  MITK_TEST_CONDITION(afterChange == freshAfterChange && afterChange != lastPath, "A modified input discards the search tree")
+}
+
+static void TestSearchRegion()
+{
+  ImageType::Pointer image = CreateRandomImage(30, 30);
+
+  // a wall of high costs in the region, which is open at its top row only,
+  // and a cheap corridor above the region
+  ImageType::SizeType regionSize;
+  regionSize.Fill(20);
+  ImageType::RegionType searchRegion(MakeIndex(5, 5), regionSize);
+  for (long y=0; y<30; ++y)
+  {
+    for (long x=0; x<30; ++x)
+    {
+      ImageType::IndexType index = MakeIndex(x, y);
+      if (x == 15 && y >= 6)
+        image->SetPixel(index, 100.0f);
+      else if (y < 5)
+        image->SetPixel(index, image->GetPixel(index) - 0.9f);
+    }
+  }
+
+  PixelValueCostFunction::Pointer costFunction = PixelValueCostFunction::New();
+  costFunction->SetImage(image);
+
+  ImageType::IndexType start = MakeIndex(6, 20);
+  ImageType::IndexType end = MakeIndex(23, 20);
+
+  PathType unrestricted = FreshSearchPath(image, costFunction, start, end, false, ImageType::RegionType());
+  bool leavesRegion = false;
+  for (unsigned int i=0; i<unrestricted.size(); ++i)
+    leavesRegion |= !searchRegion.IsInside(unrestricted[i]);
+  MITK_TEST_CONDITION_REQUIRED(leavesRegion, "Without search region the path uses the corridor outside of the region")
+
+  PathType restricted = FreshSearchPath(image, costFunction, start, end, false, searchRegion);
+  bool insideRegion = IsValidPath(restricted, start, end, false);
+  bool passesTopRow = false;
+  for (unsigned int i=0; i<restricted.size(); ++i)
+  {
+    insideRegion &= searchRegion.IsInside(restricted[i]);
+    passesTopRow |= restricted[i] == MakeIndex(15, 5);
+  }
+  MITK_TEST_CONDITION(insideRegion, "The path stays inside the search region")
+  MITK_TEST_CONDITION(passesTopRow, "The path passes the wall through the region")
+
+  // outside of the region the pixels are unreachable, so a search of the whole image has to find the same path
+  ImageType::Pointer walledImage = ImageType::New();
+  walledImage->SetRegions(image->GetLargestPossibleRegion());
+  walledImage->Allocate();
+  itk::ImageRegionConstIterator<ImageType> in(image, image->GetLargestPossibleRegion());
+  itk::ImageRegionIterator<ImageType> out(walledImage, walledImage->GetLargestPossibleRegion());
+  for (in.GoToBegin(), out.GoToBegin(); !in.IsAtEnd(); ++in, ++out)
+  {
+    out.Set(searchRegion.IsInside(in.GetIndex()) ? in.Get() : 1e6f);
+  }
+  PixelValueCostFunction::Pointer walledCostFunction = PixelValueCostFunction::New();
+  walledCostFunction->SetImage(walledImage);
+  PathType walled = FreshSearchPath(walledImage, walledCostFunction, start, end, false, ImageType::RegionType());
+  MITK_TEST_CONDITION(restricted == walled, "The path in the search region is the shortest path inside of the region")
+
+  ImageType::RegionType outsideRegion(MakeIndex(40, 40), regionSize);
+  MITK_TEST_FOR_EXCEPTION(itk::ExceptionObject, FreshSearchPath(image, costFunction, start, end, false, outsideRegion))
+}
+
+/**Documentation
+ *  Test for the A* search of ShortestPathImageFilter, its reuse of the search tree and its search region
+ */
+int itkShortestPathImageFilterTest(int /*argc*/, char* /*argv*/[])
+{
+  MITK_TEST_BEGIN("itkShortestPathImageFilterTest")
+
+  TestReusedSearchTree();
+  TestSearchRegion();
+
+  MITK_TEST_END()
+}
@@ -125,7 +125,11 @@ namespace itk
 
     void SetUseCostMap(bool useCostMap)
     {
-      this->m_UseCostMap = useCostMap;
+      if (this->m_UseCostMap != useCostMap)
+      {
+        this->m_UseCostMap = useCostMap;
+        this->Modified();
+      }
     }
 
     /**
@@ -133,7 +137,11 @@ namespace itk
     */
     void SetCostMapMaximum(double max)
     {
-      this->m_MaxMapCosts = max;
+      if (this->m_MaxMapCosts != max)
+      {
+        this->m_MaxMapCosts = max;
+        this->Modified();
+      }
     }
 
 
@@ -187,10 +195,16 @@ namespace itk
 
     double m_MaxMapCosts;
 
+    bool m_MinCostsValid;
+    RegionType m_MinCostsRegion; ///< requested region minCosts was computed for
+
   private:
 
     double SigmoidFunction(double I, double max, double min, double alpha, double beta);
 
+    /** \brief Lowest costs per pixel distance within the requested region (without dynamic cost map)*/
+    double ComputeMinCosts();
+
 
   };
 
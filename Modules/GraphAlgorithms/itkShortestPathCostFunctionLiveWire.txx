@@ -45,6 +45,8 @@ namespace itk
     m_Initialized = false;
     m_UseCostMap = false;
     m_MaxMapCosts = -1.0;
+    m_MinCostsValid = false;
+    minCosts = 0.0;
   }
 
 
@@ -245,30 +247,35 @@ namespace itk
     nGradientAtP1[0] = gradientX;//previously computed for gradient magnitude
     nGradientAtP1[1] = gradientY;
 
-    //gradient direction unit vector of p1
-    nGradientAtP1[0] /= gradientMagnitude;
-    nGradientAtP1[1] /= gradientMagnitude;
-    //-------
+    double gradientDirectionCost = 0.0;
+    // without gradient there is no direction (and the costs would be NaN, which breaks the ordering of the shortest path search)
+    if (gradientMagnitude > 0.0)
+    {
+      //gradient direction unit vector of p1
+      nGradientAtP1[0] /= gradientMagnitude;
+      nGradientAtP1[1] /= gradientMagnitude;
+      //-------
 
-    // gradient vector at p1
-    double nGradientAtP2[2];
+      // gradient vector at p1
+      double nGradientAtP2[2];
 
 
-    nGradientAtP2[0] = m_GradientImage->GetPixel(p2)[0];
-    nGradientAtP2[1] = m_GradientImage->GetPixel(p2)[1];
+      nGradientAtP2[0] = m_GradientImage->GetPixel(p2)[0];
+      nGradientAtP2[1] = m_GradientImage->GetPixel(p2)[1];
 
-    nGradientAtP2[0] /= m_GradientMagnImage->GetPixel(p2);
-    nGradientAtP2[1] /= m_GradientMagnImage->GetPixel(p2);
+      nGradientAtP2[0] /= m_GradientMagnImage->GetPixel(p2);
+      nGradientAtP2[1] /= m_GradientMagnImage->GetPixel(p2);
 
 
-    double scalarProduct = (nGradientAtP1[0] * nGradientAtP2[0]) + (nGradientAtP1[1] * nGradientAtP2[1]);
-    if( abs(scalarProduct) >= 1.0)
-    {
-      //this should probably not happen; make sure the input for acos is valid
-      scalarProduct = 0.999999999;
-    }
+      double scalarProduct = (nGradientAtP1[0] * nGradientAtP2[0]) + (nGradientAtP1[1] * nGradientAtP2[1]);
+      if( abs(scalarProduct) >= 1.0)
+      {
+        //this should probably not happen; make sure the input for acos is valid
+        scalarProduct = 0.999999999;
+      }
 
-    double gradientDirectionCost = acos( scalarProduct ) / 3.14159265;
+      gradientDirectionCost = acos( scalarProduct ) / 3.14159265;
+    }
     /*------------------------------------------------------------------------*/
 
 
@@ -405,10 +412,21 @@ namespace itk
       m_EdgeImage = cannyEdgeDetectionfilter->GetOutput();
 
 
-      // set minCosts
-      minCosts = 0.0; // The lower, the more thouroughly! 0 = dijkstra. If estimate costs are lower than actual costs everything is fine. If estimation is higher than actual costs, you might not get the shortest but a different path.
-
       m_Initialized = true;
+      m_MinCostsValid = false;
+    }
+
+    // set minCosts
+    // The lower, the more thouroughly! 0 = dijkstra. If estimate costs are lower than actual costs everything is fine. If estimation is higher than actual costs, you might not get the shortest but a different path.
+    if (m_UseCostMap)
+    {
+      minCosts = 0.0; // costs of the dynamic cost map have no known lower bound
+    }
+    else if (!m_MinCostsValid || m_MinCostsRegion != m_RequestedRegion)
+    {
+      minCosts = this->ComputeMinCosts();
+      m_MinCostsRegion = m_RequestedRegion;
+      m_MinCostsValid = true;
     }
 
     // check start/end point value
@@ -418,6 +436,44 @@ namespace itk
 
 
 
+  template<class TInputImageType>
+  double ShortestPathCostFunctionLiveWire<TInputImageType>::ComputeMinCosts()
+  {
+    // Every step costs at least the laplacian and gradient magnitude costs of the pixel it goes to
+    // (the gradient direction costs are >= 0), multiplied with its length. So the lowest costs of
+    // a pixel are a lower bound for the costs per length of any path through the requested region.
+    RegionType region = m_RequestedRegion;
+    if (region.GetNumberOfPixels() == 0 || !region.Crop(m_GradientMagnImage->GetLargestPossibleRegion()))
+    {
+      region = m_GradientMagnImage->GetLargestPossibleRegion();
+    }
+
+    if (!(m_GradientMax > 0.0))
+    {
+      return 0.0;
+    }
+
+    // weights of GetCost() for the linear mapping of the gradient magnitude
+    const double w1 = 0.10;
+    const double w2 = 0.85;
+
+    double min = w1 + w2;
+    itk::ImageRegionConstIterator<ImageType> gradientIt(m_GradientMagnImage, region);
+    itk::ImageRegionConstIterator<FloatImageType> edgeIt(m_EdgeImage, region);
+    for (gradientIt.GoToBegin(), edgeIt.GoToBegin(); !gradientIt.IsAtEnd(); ++gradientIt, ++edgeIt)
+    {
+      double laplacianCost = (edgeIt.Get() < 0 || edgeIt.Get() > 0) ? 1.0 : 0.0;
+      double gradientCost = 1.0 - (gradientIt.Get() / m_GradientMax);
+      double costs = w1 * laplacianCost + w2 * gradientCost;
+      if (costs < min)
+      {
+        min = costs;
+      }
+    }
+    return min > 0.0 ? min : 0.0;
+  }
+
+
   template<class TInputImageType>
   double ShortestPathCostFunctionLiveWire<TInputImageType>::SigmoidFunction(double I, double max, double min, double alpha, double beta)
   {
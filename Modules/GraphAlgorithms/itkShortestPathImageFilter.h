@@ -23,6 +23,8 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 #include <itkMacro.h>
 
+#include <vector>
+
 // ------- INFORMATION ----------
 /// SET FUNCTIONS
 //void SetInput( ItkImage ) // Compulsory
@@ -34,6 +36,12 @@ See LICENSE.txt or http://www.mitk.org for details.
 //void SetCalcAllDistances(bool) // Optional (default=false), Calculate Distances over the whole image. CAREFUL, algorithm time extends a lot. Necessary for GetDistanceImage
 //void SetStoreVectorOrder(bool) // Optional (default=false), Stores in which order the pixels were checked. Necessary for GetVectorOrderImage
 //void AddEndIndex(const IndexType & EndIndex) //Optional. By calling this function you can add several endpoints! The algorithm will look for several shortest Pathes. From Start to all Endpoints.
+//void SetSearchRegion(const RegionType &) // Optional (default=empty region=whole image), restricts the search (and the memory of the graph) to a region of the image
+//
+/// REUSE OF THE SEARCH TREE
+// If only the end point was changed since the last update (same input, start point, search region, neighbor mode and
+// unmodified cost function), the search continues with the tree of the last update. If the new end point was already
+// reached by that tree, the path is only looked up. This makes interactive use (e.g. live wire) fast.
 //
 /// GET FUNCTIONS
 //std::vector< itk::Index<3> > GetVectorPath(); // returns the shortest path as vector
@@ -70,6 +78,8 @@ namespace itk
       typedef typename TInputImageType::PixelType                      InputImagePixelType;
       typedef typename TInputImageType::SizeType                       InputImageSizeType;
       typedef typename TInputImageType::IndexType                      IndexType;
+      typedef typename TInputImageType::OffsetType                     OffsetType;
+      typedef typename TInputImageType::RegionType                     RegionType;
       typedef typename itk::ImageRegionIteratorWithIndex< InputImageType >          InputImageIteratorType;
 
       typedef TOutputImageType                                    OutputImageType;
@@ -128,6 +138,13 @@ namespace itk
       itkSetMacro (ActivateTimeOut, bool);
       itkGetMacro (ActivateTimeOut, bool);
 
+      // \brief (default=empty region), restricts the search to this region of the input. Paths never leave it, nodes are only allocated for it. An empty region means the whole image.
+      itkSetMacro (SearchRegion, RegionType);
+      itkGetConstReferenceMacro (SearchRegion, RegionType);
+
+      // \brief returns the number of nodes which were closed during the last update (0 if the path was looked up in the search tree of the previous update)
+      itkGetMacro (NumberOfCheckedNodes, NodeNumType);
+
       // \brief returns shortest Path as vector
       std::vector< IndexType > GetVectorPath();
 
@@ -155,13 +172,20 @@ namespace itk
       std::vector< IndexType > m_endPoints; // if you fill this vector, the algo will not rest until all endPoints have been reached
       std::vector< IndexType > m_endPointsClosed;
 
-      ShortestPathNode* m_Nodes; // main list that contains all nodes
+      std::vector<ShortestPathNode> m_Nodes; // main list that contains all nodes of m_GraphRegion. Its memory is reused by the following updates
+      std::vector<NodeNumType> m_OpenList; // discovered but not closed nodes as binary heap ordered by distAndEst
+      std::vector<OffsetType> m_NeighborOffsets; // offsets of the neighbors of a node (N4/N8 or N6/N26)
       NodeNumType m_Graph_NumberOfNodes;
       NodeNumType m_Graph_StartNode;
       NodeNumType m_Graph_EndNode;
       int m_ImageDimensions;
-      bool m_Graph_fullNeighbors;
-      std::vector<ShortestPathNode*> m_Graph_DiscoveredNodeList;
+      bool m_Graph_fullNeighbors; // neighbor mode the graph was built with
+      RegionType m_GraphRegion; // region of the input covered by m_Nodes
+      const InputImageType* m_GraphInput; // input and modification times the graph was built for
+      unsigned long m_GraphInputMTime;
+      unsigned long m_GraphCostFunctionMTime;
+      double m_MinCost; // minimal costs per pixel distance, used for the A* estimate
+      NodeNumType m_NumberOfCheckedNodes;
       ShortestPathImageFilter(Self&);   // intentionally not implemented
       void operator=(const Self&);      // intentionally not implemented
       const static int BACKGROUND = 0;
@@ -176,7 +200,9 @@ namespace itk
 
       bool m_ActivateTimeOut; // if true, then i search max. 30 secs. then abort
 
-      bool m_Initialized;
+      bool m_Initialized; // true if m_Nodes contains the search tree of the last update
+
+      RegionType m_SearchRegion;
 
 
       CostFunctionTypePointer m_CostFunction;
@@ -210,15 +236,27 @@ namespace itk
       // \brief Convert image coordinate to a indexnumber of a node in m_Nodes
       unsigned int CoordToNode(IndexType);
 
-      // \brief Returns the neighbors of a node
-      std::vector<ShortestPathNode*> GetNeighbors(NodeNumType nodeNum, bool FullNeighbors);
-
-      // \brief Check if coords are in bounds of image
+      // \brief Check if coords are in bounds of the graph
       bool CoordIsInBounds(IndexType);
 
-      // \brief Initializes the graph
+      // \brief Initializes the graph, or keeps the search tree of the last update if only the end point changed
       void InitGraph();
 
+      // \brief Adds a discovered node to the open list
+      void PushOpenList(NodeNumType node);
+
+      // \brief Removes the node with the lowest distAndEst from the open list and returns it
+      NodeNumType PopOpenList();
+
+      // \brief Moves the node at position heapIndex of the open list up after its distAndEst was decreased
+      void SiftUp(NodeNumType heapIndex);
+
+      // \brief Moves the node at position heapIndex of the open list down after its distAndEst was increased
+      void SiftDown(NodeNumType heapIndex);
+
+      // \brief Recalculates distAndEst of all open nodes for a new end point and restores the heap order
+      void RebuildOpenList();
+
       // \brief Start ShortestPathSearch
       void StartShortestPathSearch();
 
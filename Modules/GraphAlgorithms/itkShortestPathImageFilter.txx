@@ -18,6 +18,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 
 #include "time.h"
+#include <cmath>
 #include "mitkMemoryUtilities.h"
 #include <iostream>
 #include <algorithm>
@@ -31,15 +32,22 @@ namespace itk
   template <class TInputImageType, class TOutputImageType>
   ShortestPathImageFilter<TInputImageType, TOutputImageType>
     ::ShortestPathImageFilter() :
+    m_Graph_NumberOfNodes(0),
+    m_Graph_StartNode(0),
+    m_Graph_EndNode(0),
+    m_Graph_fullNeighbors(false),
+    m_GraphInput(0),
+    m_GraphInputMTime(0),
+    m_GraphCostFunctionMTime(0),
+    m_MinCost(0.0),
+    m_NumberOfCheckedNodes(0),
     m_FullNeighborsMode(false),
     m_MakeOutputImage(true),
     m_StoreVectorOrder(false),
     m_CalcAllDistances(false),
-    m_ActivateTimeOut(false),
     multipleEndPoints(false),
-    m_Initialized(false),
-    m_Nodes(0),
-    m_Graph_NumberOfNodes(0)
+    m_ActivateTimeOut(false),
+    m_Initialized(false)
   {
     m_endPoints.clear();
     m_endPointsClosed.clear();
@@ -57,7 +65,6 @@ namespace itk
   ShortestPathImageFilter<TInputImageType, TOutputImageType>
     ::~ShortestPathImageFilter()
   {
-    delete [] m_Nodes;
   }
 
 
@@ -68,30 +75,16 @@ namespace itk
     ShortestPathImageFilter<TInputImageType, TOutputImageType>
     ::NodeToCoord (NodeNumType node)
   {
-    const InputImageSizeType &size = this->GetInput()->GetRequestedRegion().GetSize();
-    int dim = InputImageType::ImageDimension;
-    IndexType coord;
-    if (dim == 2)
+    const InputImageSizeType &size = m_GraphRegion.GetSize();
+    IndexType coord = m_GraphRegion.GetIndex();
+    if (node >= m_Graph_NumberOfNodes)
     {
-      coord[1] = node / size[0];
-      coord[0] = node % size[0];
-      if ((coord[0] >= size[0]) || (coord[1] >= size[1]))
-      {
-        coord[0] = 0;
-        coord[1] = 0;
-      }
+      return coord;
     }
-    if (dim == 3)
+    for (unsigned int i=0; i<InputImageType::ImageDimension; ++i)
     {
-      coord[2] = node / (size[0]*size[1]);
-      coord[1] = (node % (size[0]*size[1])) / size[0];
-      coord[0] = (node % (size[0]*size[1])) % size[0];
-      if ((coord[0] >= size[0]) || (coord[1] >= size[1]) || (coord[2] >= size[2]))
-      {
-        coord[0] = 0;
-        coord[1] = 0;
-        coord[2] = 0;
-      }
+      coord[i] += node % size[i];
+      node /= size[i];
     }
 
     return coord;
@@ -102,23 +95,16 @@ namespace itk
     ShortestPathImageFilter<TInputImageType, TOutputImageType>::
     CoordToNode (IndexType coord)
   {
-    const InputImageSizeType &size = this->GetInput()->GetRequestedRegion().GetSize();
-    int dim = InputImageType::ImageDimension;
+    const InputImageSizeType &size = m_GraphRegion.GetSize();
+    const IndexType &origin = m_GraphRegion.GetIndex();
     NodeNumType node = 0;
-    if (dim == 2)
-    {
-      node = (coord[1]*size[0]) + coord[0];
-    }
-    if (dim == 3)
+    for (int i=InputImageType::ImageDimension-1; i>=0; --i)
     {
-      node = (coord[2]*size[0]*size[1]) + (coord[1]*size[0]) + coord[0];
+      node = node*size[i] + (coord[i] - origin[i]);
     }
-    if ((m_Graph_NumberOfNodes > 0) && (node >= m_Graph_NumberOfNodes))
+    if (!CoordIsInBounds(coord))
     {
-      /*MITK_INFO << "WARNING! Coordinates outside image!";
-      MITK_INFO << "Coords = " << coord ;
-      MITK_INFO << "ImageDim = " << dim ;
-      MITK_INFO << "RequestedRegionSize = " << size ;*/
+      //MITK_INFO << "WARNING! Coordinates outside graph!";
       node = 0;
     }
 
@@ -130,267 +116,7 @@ namespace itk
     ShortestPathImageFilter<TInputImageType, TOutputImageType>::
     CoordIsInBounds  (IndexType coord)
   {
-    const InputImageSizeType &size = this->GetInput()->GetRequestedRegion().GetSize();
-    int dim = InputImageType::ImageDimension;
-
-    if (dim == 2)
-    {
-      if ((coord[0] >= 0)
-        && (coord[0] < size[0])
-        && (coord[1] >= 0 )
-        && (coord[1] < size[1] ))
-      {
-        return true;
-      }
-    }
-    if (dim == 3)
-    {
-      if ((coord[0] >= 0)
-        && (coord[0] < size[0])
-        && (coord[1] >= 0 )
-        && (coord[1] < size[1] )
-        && (coord[2] >= 0 )
-        && (coord[2] < size[2] ))
-      {
-        return true;
-      }
-    }
-    return false;
-  }
-
-
-  template <class TInputImageType, class TOutputImageType>
-  inline std::vector< ShortestPathNode* >
-    ShortestPathImageFilter<TInputImageType, TOutputImageType>::
-    GetNeighbors  (unsigned int nodeNum, bool FullNeighbors)
-  {
-    // returns a vector of nodepointers.. these nodes are the neighbors
-    int dim = InputImageType::ImageDimension;
-    IndexType Coord = NodeToCoord(nodeNum);
-    IndexType NeighborCoord;
-    std::vector<ShortestPathNode*> nodeList;
-
-    int neighborDistance = 1; //if i increase that, i might not hit the endnote
-
-    // maybe use itkNeighborhoodIterator here, might be faster
-
-    if ( dim == 2)
-    {
-      // N4
-      NeighborCoord[0] = Coord[0];
-      NeighborCoord[1] = Coord[1]-neighborDistance;
-      if (CoordIsInBounds(NeighborCoord))
-        nodeList.push_back(&m_Nodes[CoordToNode(NeighborCoord)]);
-
-      NeighborCoord[0] = Coord[0]+neighborDistance;
-      NeighborCoord[1] = Coord[1];
-      if (CoordIsInBounds(NeighborCoord))
-        nodeList.push_back(&m_Nodes[CoordToNode(NeighborCoord)]);
-
-      NeighborCoord[0] = Coord[0];
-      NeighborCoord[1] = Coord[1]+neighborDistance;
-      if (CoordIsInBounds(NeighborCoord))
-        nodeList.push_back(&m_Nodes[CoordToNode(NeighborCoord)]);
-
-      NeighborCoord[0] = Coord[0]-neighborDistance;
-      NeighborCoord[1] = Coord[1];
-      if (CoordIsInBounds(NeighborCoord))
-        nodeList.push_back(&m_Nodes[CoordToNode(NeighborCoord)]);
-
-      if (FullNeighbors)
-      {
-        // N8
-        NeighborCoord[0] = Coord[0]-neighborDistance;
-        NeighborCoord[1] = Coord[1]-neighborDistance;
-        if (CoordIsInBounds(NeighborCoord))
-          nodeList.push_back(&m_Nodes[CoordToNode(NeighborCoord)]);
-
-        NeighborCoord[0] = Coord[0]+neighborDistance;
-        NeighborCoord[1] = Coord[1]-neighborDistance;
-        if (CoordIsInBounds(NeighborCoord))
-          nodeList.push_back(&m_Nodes[CoordToNode(NeighborCoord)]);
-
-        NeighborCoord[0] = Coord[0]-neighborDistance;
-        NeighborCoord[1] = Coord[1]+neighborDistance;
-        if (CoordIsInBounds(NeighborCoord))
-          nodeList.push_back(&m_Nodes[CoordToNode(NeighborCoord)]);
-
-        NeighborCoord[0] = Coord[0]+neighborDistance;
-        NeighborCoord[1] = Coord[1]+neighborDistance;
-        if (CoordIsInBounds(NeighborCoord))
-          nodeList.push_back(&m_Nodes[CoordToNode(NeighborCoord)]);
-      }
-    }
-    if ( dim == 3)
-    {
-      // N6
-      NeighborCoord[0] = Coord[0];
-      NeighborCoord[1] = Coord[1]-neighborDistance;
-      NeighborCoord[2] = Coord[2];
-      if (CoordIsInBounds(NeighborCoord))
-        nodeList.push_back(&m_Nodes[CoordToNode(NeighborCoord)]);
-
-      NeighborCoord[0] = Coord[0]+neighborDistance;
-      NeighborCoord[1] = Coord[1];
-      NeighborCoord[2] = Coord[2];
-      if (CoordIsInBounds(NeighborCoord))
-        nodeList.push_back(&m_Nodes[CoordToNode(NeighborCoord)]);
-
-      NeighborCoord[0] = Coord[0];
-      NeighborCoord[1] = Coord[1]+neighborDistance;
-      NeighborCoord[2] = Coord[2];
-      if (CoordIsInBounds(NeighborCoord))
-        nodeList.push_back(&m_Nodes[CoordToNode(NeighborCoord)]);
-
-      NeighborCoord[0] = Coord[0]-neighborDistance;
-      NeighborCoord[1] = Coord[1];
-      NeighborCoord[2] = Coord[2];
-      if (CoordIsInBounds(NeighborCoord))
-        nodeList.push_back(&m_Nodes[CoordToNode(NeighborCoord)]);
-
-      NeighborCoord[0] = Coord[0];
-      NeighborCoord[1] = Coord[1];
-      NeighborCoord[2] = Coord[2]+neighborDistance;
-      if (CoordIsInBounds(NeighborCoord))
-        nodeList.push_back(&m_Nodes[CoordToNode(NeighborCoord)]);
-
-      NeighborCoord[0] = Coord[0];
-      NeighborCoord[1] = Coord[1];
-      NeighborCoord[2] = Coord[2]-neighborDistance;
-      if (CoordIsInBounds(NeighborCoord))
-        nodeList.push_back(&m_Nodes[CoordToNode(NeighborCoord)]);
-
-      if (FullNeighbors)
-      {
-        // N26
-        // Middle Slice
-        NeighborCoord[0] = Coord[0]-neighborDistance;
-        NeighborCoord[1] = Coord[1]-neighborDistance;
-        NeighborCoord[2] = Coord[2];
-        if (CoordIsInBounds(NeighborCoord))
-          nodeList.push_back(&m_Nodes[CoordToNode(NeighborCoord)]);
-
-        NeighborCoord[0] = Coord[0]+neighborDistance;
-        NeighborCoord[1] = Coord[1]-neighborDistance;
-        NeighborCoord[2] = Coord[2];
-        if (CoordIsInBounds(NeighborCoord))
-          nodeList.push_back(&m_Nodes[CoordToNode(NeighborCoord)]);
-
-        NeighborCoord[0] = Coord[0]-neighborDistance;
-        NeighborCoord[1] = Coord[1]+neighborDistance;
-        NeighborCoord[2] = Coord[2];
-        if (CoordIsInBounds(NeighborCoord))
-          nodeList.push_back(&m_Nodes[CoordToNode(NeighborCoord)]);
-
-        NeighborCoord[0] = Coord[0]+neighborDistance;
-        NeighborCoord[1] = Coord[1]+neighborDistance;
-        NeighborCoord[2] = Coord[2];
-        if (CoordIsInBounds(NeighborCoord))
-          nodeList.push_back(&m_Nodes[CoordToNode(NeighborCoord)]);
-
-        // BackSlice (Diagonal)
-        NeighborCoord[0] = Coord[0]-neighborDistance;
-        NeighborCoord[1] = Coord[1]-neighborDistance;
-        NeighborCoord[2] = Coord[2]-neighborDistance;
-        if (CoordIsInBounds(NeighborCoord))
-          nodeList.push_back(&m_Nodes[CoordToNode(NeighborCoord)]);
-
-        NeighborCoord[0] = Coord[0]+neighborDistance;
-        NeighborCoord[1] = Coord[1]-neighborDistance;
-        NeighborCoord[2] = Coord[2]-neighborDistance;
-        if (CoordIsInBounds(NeighborCoord))
-          nodeList.push_back(&m_Nodes[CoordToNode(NeighborCoord)]);
-
-        NeighborCoord[0] = Coord[0]-neighborDistance;
-        NeighborCoord[1] = Coord[1]+neighborDistance;
-        NeighborCoord[2] = Coord[2]-neighborDistance;
-        if (CoordIsInBounds(NeighborCoord))
-          nodeList.push_back(&m_Nodes[CoordToNode(NeighborCoord)]);
-
-        NeighborCoord[0] = Coord[0]+neighborDistance;
-        NeighborCoord[1] = Coord[1]+neighborDistance;
-        NeighborCoord[2] = Coord[2]-neighborDistance;
-        if (CoordIsInBounds(NeighborCoord))
-          nodeList.push_back(&m_Nodes[CoordToNode(NeighborCoord)]);
-
-        //BackSlice (Non-Diag)
-        NeighborCoord[0] = Coord[0];
-        NeighborCoord[1] = Coord[1]-neighborDistance;
-        NeighborCoord[2] = Coord[2]-neighborDistance;
-        if (CoordIsInBounds(NeighborCoord))
-          nodeList.push_back(&m_Nodes[CoordToNode(NeighborCoord)]);
-
-        NeighborCoord[0] = Coord[0]+neighborDistance;
-        NeighborCoord[1] = Coord[1];
-        NeighborCoord[2] = Coord[2]-neighborDistance;
-        if (CoordIsInBounds(NeighborCoord))
-          nodeList.push_back(&m_Nodes[CoordToNode(NeighborCoord)]);
-
-        NeighborCoord[0] = Coord[0];
-        NeighborCoord[1] = Coord[1]+neighborDistance;
-        NeighborCoord[2] = Coord[2]-neighborDistance;
-        if (CoordIsInBounds(NeighborCoord))
-          nodeList.push_back(&m_Nodes[CoordToNode(NeighborCoord)]);
-
-        NeighborCoord[0] = Coord[0]-neighborDistance;
-        NeighborCoord[1] = Coord[1];
-        NeighborCoord[2] = Coord[2]-neighborDistance;
-        if (CoordIsInBounds(NeighborCoord))
-          nodeList.push_back(&m_Nodes[CoordToNode(NeighborCoord)]);
-
-        // FrontSlice (Diagonal)
-        NeighborCoord[0] = Coord[0]-neighborDistance;
-        NeighborCoord[1] = Coord[1]-neighborDistance;
-        NeighborCoord[2] = Coord[2]+neighborDistance;
-        if (CoordIsInBounds(NeighborCoord))
-          nodeList.push_back(&m_Nodes[CoordToNode(NeighborCoord)]);
-
-        NeighborCoord[0] = Coord[0]+neighborDistance;
-        NeighborCoord[1] = Coord[1]-neighborDistance;
-        NeighborCoord[2] = Coord[2]+neighborDistance;
-        if (CoordIsInBounds(NeighborCoord))
-          nodeList.push_back(&m_Nodes[CoordToNode(NeighborCoord)]);
-
-        NeighborCoord[0] = Coord[0]-neighborDistance;
-        NeighborCoord[1] = Coord[1]+neighborDistance;
-        NeighborCoord[2] = Coord[2]+neighborDistance;
-        if (CoordIsInBounds(NeighborCoord))
-          nodeList.push_back(&m_Nodes[CoordToNode(NeighborCoord)]);
-
-        NeighborCoord[0] = Coord[0]+neighborDistance;
-        NeighborCoord[1] = Coord[1]+neighborDistance;
-        NeighborCoord[2] = Coord[2]+neighborDistance;
-        if (CoordIsInBounds(NeighborCoord))
-          nodeList.push_back(&m_Nodes[CoordToNode(NeighborCoord)]);
-
-        //FrontSlice(Non-Diag)
-        NeighborCoord[0] = Coord[0];
-        NeighborCoord[1] = Coord[1]-neighborDistance;
-        NeighborCoord[2] = Coord[2]+neighborDistance;
-        if (CoordIsInBounds(NeighborCoord))
-          nodeList.push_back(&m_Nodes[CoordToNode(NeighborCoord)]);
-
-        NeighborCoord[0] = Coord[0]+neighborDistance;
-        NeighborCoord[1] = Coord[1];
-        NeighborCoord[2] = Coord[2]+neighborDistance;
-        if (CoordIsInBounds(NeighborCoord))
-          nodeList.push_back(&m_Nodes[CoordToNode(NeighborCoord)]);
-
-        NeighborCoord[0] = Coord[0];
-        NeighborCoord[1] = Coord[1]+neighborDistance;
-        NeighborCoord[2] = Coord[2]+neighborDistance;
-        if (CoordIsInBounds(NeighborCoord))
-          nodeList.push_back(&m_Nodes[CoordToNode(NeighborCoord)]);
-
-        NeighborCoord[0] = Coord[0]-neighborDistance;
-        NeighborCoord[1] = Coord[1];
-        NeighborCoord[2] = Coord[2]+neighborDistance;
-        if (CoordIsInBounds(NeighborCoord))
-          nodeList.push_back(&m_Nodes[CoordToNode(NeighborCoord)]);
-
-      }
-    }
-    return nodeList;
+    return m_GraphRegion.IsInside(coord);
   }
 
 
@@ -402,10 +128,8 @@ namespace itk
     {
       m_StartIndex[i] = StartIndex[i];
     }
-    m_Graph_StartNode = CoordToNode(m_StartIndex);
-    //MITK_INFO << "StartIndex = " << StartIndex;
-    //MITK_INFO << "StartNode = " << m_Graph_StartNode;
-    m_Initialized = false;
+    // the node number is determined in InitGraph(), a new start point invalidates the search tree there
+    this->Modified();
   }
 
 
@@ -417,8 +141,7 @@ namespace itk
     {
       m_EndIndex[i] = EndIndex[i];
     }
-    m_Graph_EndNode = CoordToNode(m_EndIndex);
-    //MITK_INFO << "EndNode = " << m_Graph_EndNode;
+    this->Modified();
   }
 
   template <class TInputImageType, class TOutputImageType>
@@ -441,12 +164,14 @@ namespace itk
     getEstimatedCostsToTarget (const typename TInputImageType::IndexType &a)
   {
     // Returns the minimal possible costs for a path from "a" to targetnode.
-    itk::Vector<float,3> v;
-    v[0] = m_EndIndex[0]-a[0];
-    v[1] = m_EndIndex[1]-a[1];
-    v[2] = m_EndIndex[2]-a[2];
+    double squaredDistance = 0.0;
+    for (unsigned int i=0; i<TInputImageType::ImageDimension; ++i)
+    {
+      double d = m_EndIndex[i]-a[i];
+      squaredDistance += d*d;
+    }
 
-    return  m_CostFunction->GetMinCost() * v.GetNorm();
+    return m_MinCost * std::sqrt(squaredDistance);
   }
 
 
@@ -455,42 +180,198 @@ namespace itk
     ShortestPathImageFilter<TInputImageType, TOutputImageType>::
     InitGraph()
   {
-    if(!m_Initialized)
+    // The graph covers the search region or the whole input
+    RegionType graphRegion = this->GetInput()->GetRequestedRegion();
+    if (m_SearchRegion.GetNumberOfPixels() > 0)
     {
-      // Clean up previous stuff
-      CleanUp();
+      graphRegion = m_SearchRegion;
+      if (!graphRegion.Crop(this->GetInput()->GetRequestedRegion()))
+      {
+        itkExceptionMacro(<< "Search region " << m_SearchRegion << " is outside of the input image.");
+      }
+    }
+
+    // initalize cost function
+    m_CostFunction->Initialize();
+    m_MinCost = m_CostFunction->GetMinCost();
+
+    // With a consistent estimate every closed node already has its shortest path, so the tree of the
+    // last update can be extended as long as the graph and its costs did not change.
+    if (m_Initialized
+      && !multipleEndPoints
+      && !m_StoreVectorOrder
+      && graphRegion == m_GraphRegion
+      && m_GraphInput == this->GetInput()
+      && m_GraphInputMTime == this->GetInput()->GetMTime()
+      && m_GraphCostFunctionMTime == m_CostFunction->GetMTime()
+      && m_Graph_fullNeighbors == m_FullNeighborsMode
+      && m_Graph_StartNode == CoordToNode(m_StartIndex))
+    {
+      NodeNumType endNode = CoordToNode(m_EndIndex);
+      if (endNode != m_Graph_EndNode)
+      {
+        m_Graph_EndNode = endNode;
+        RebuildOpenList();
+      }
+      return;
+    }
+
+    // Clean up previous stuff
+    CleanUp();
+
+    m_GraphRegion = graphRegion;
+    m_GraphInput = this->GetInput();
+    m_GraphInputMTime = this->GetInput()->GetMTime();
+    m_GraphCostFunctionMTime = m_CostFunction->GetMTime();
+    m_Graph_fullNeighbors = m_FullNeighborsMode;
 
-      // Calc Number of nodes
-      m_ImageDimensions = TInputImageType::ImageDimension;
-      const InputImageSizeType &size = this->GetInput()->GetRequestedRegion().GetSize();
-      m_Graph_NumberOfNodes = 1;
-      for (NodeNumType i=0; i<m_ImageDimensions; ++i)
-        m_Graph_NumberOfNodes=m_Graph_NumberOfNodes*size[i];
+    // Calc Number of nodes
+    m_ImageDimensions = TInputImageType::ImageDimension;
+    m_Graph_NumberOfNodes = m_GraphRegion.GetNumberOfPixels();
 
-      // Initialize mainNodeList with that number
-      m_Nodes = new ShortestPathNode[m_Graph_NumberOfNodes];
+    // Initialize mainNodeList with that number, the vector keeps its memory if the graph gets smaller
+    m_Nodes.resize(m_Graph_NumberOfNodes);
 
-      // Initialize each node in nodelist
-      for (NodeNumType i=0; i<m_Graph_NumberOfNodes; i++)
+    // Initialize each node in nodelist
+    for (NodeNumType i=0; i<m_Graph_NumberOfNodes; i++)
+    {
+      m_Nodes[i].distAndEst = -1;
+      m_Nodes[i].distance = -1;
+      m_Nodes[i].prevNode = -1;
+      m_Nodes[i].mainListIndex=i;
+      m_Nodes[i].heapIndex=0;
+      m_Nodes[i].closed=false;
+    }
+
+    // Offsets of the neighbors: all 3^dim-1 surrounding pixels in full neighbors mode, else only the direct ones
+    m_NeighborOffsets.clear();
+    unsigned int numberOfOffsets = 1;
+    for (int i=0; i<m_ImageDimensions; ++i)
+      numberOfOffsets *= 3;
+    for (unsigned int n=0; n<numberOfOffsets; ++n)
+    {
+      OffsetType offset;
+      unsigned int code = n;
+      int nonZero = 0;
+      for (int i=0; i<m_ImageDimensions; ++i)
       {
-        m_Nodes[i].distAndEst = -1;
-        m_Nodes[i].distance = -1;
-        m_Nodes[i].prevNode = -1;
-        m_Nodes[i].mainListIndex=i;
-        m_Nodes[i].closed=false;
+        offset[i] = static_cast<int>(code % 3) - 1;
+        code /= 3;
+        if (offset[i] != 0)
+          nonZero++;
       }
-
-      m_Initialized = true;
+      if (nonZero == 1 || (nonZero > 1 && m_Graph_fullNeighbors))
+        m_NeighborOffsets.push_back(offset);
     }
 
+    m_Graph_StartNode = CoordToNode(m_StartIndex);
+    m_Graph_EndNode = CoordToNode(m_EndIndex);
+
     // In the beginning, the Startnode needs a distance of 0
     m_Nodes[m_Graph_StartNode].distance = 0;
-    m_Nodes[m_Graph_StartNode].distAndEst = 0;
+    m_Nodes[m_Graph_StartNode].distAndEst = getEstimatedCostsToTarget(m_StartIndex);
+    PushOpenList(m_Graph_StartNode);
 
-    // initalize cost function
-    m_CostFunction->Initialize();
+    m_Initialized = true;
   }
 
+
+  template <class TInputImageType, class TOutputImageType>
+  void
+    ShortestPathImageFilter<TInputImageType, TOutputImageType>::
+    PushOpenList(NodeNumType node)
+  {
+    m_Nodes[node].heapIndex = m_OpenList.size();
+    m_OpenList.push_back(node);
+    SiftUp(m_Nodes[node].heapIndex);
+  }
+
+
+  template <class TInputImageType, class TOutputImageType>
+  NodeNumType
+    ShortestPathImageFilter<TInputImageType, TOutputImageType>::
+    PopOpenList()
+  {
+    NodeNumType top = m_OpenList.front();
+    NodeNumType last = m_OpenList.back();
+    m_OpenList.pop_back();
+    if (!m_OpenList.empty())
+    {
+      m_OpenList[0] = last;
+      m_Nodes[last].heapIndex = 0;
+      SiftDown(0);
+    }
+    return top;
+  }
+
+
+  template <class TInputImageType, class TOutputImageType>
+  void
+    ShortestPathImageFilter<TInputImageType, TOutputImageType>::
+    SiftUp(NodeNumType heapIndex)
+  {
+    NodeNumType node = m_OpenList[heapIndex];
+    DistanceType key = m_Nodes[node].distAndEst;
+    while (heapIndex > 0)
+    {
+      NodeNumType parentIndex = (heapIndex - 1) / 2;
+      NodeNumType parent = m_OpenList[parentIndex];
+      if (!(key < m_Nodes[parent].distAndEst))
+        break;
+      m_OpenList[heapIndex] = parent;
+      m_Nodes[parent].heapIndex = heapIndex;
+      heapIndex = parentIndex;
+    }
+    m_OpenList[heapIndex] = node;
+    m_Nodes[node].heapIndex = heapIndex;
+  }
+
+
+  template <class TInputImageType, class TOutputImageType>
+  void
+    ShortestPathImageFilter<TInputImageType, TOutputImageType>::
+    SiftDown(NodeNumType heapIndex)
+  {
+    NodeNumType size = m_OpenList.size();
+    NodeNumType node = m_OpenList[heapIndex];
+    DistanceType key = m_Nodes[node].distAndEst;
+    while (true)
+    {
+      NodeNumType childIndex = 2 * heapIndex + 1;
+      if (childIndex >= size)
+        break;
+      if (childIndex + 1 < size
+        && m_Nodes[m_OpenList[childIndex + 1]].distAndEst < m_Nodes[m_OpenList[childIndex]].distAndEst)
+        ++childIndex;
+      NodeNumType child = m_OpenList[childIndex];
+      if (!(m_Nodes[child].distAndEst < key))
+        break;
+      m_OpenList[heapIndex] = child;
+      m_Nodes[child].heapIndex = heapIndex;
+      heapIndex = childIndex;
+    }
+    m_OpenList[heapIndex] = node;
+    m_Nodes[node].heapIndex = heapIndex;
+  }
+
+
+  template <class TInputImageType, class TOutputImageType>
+  void
+    ShortestPathImageFilter<TInputImageType, TOutputImageType>::
+    RebuildOpenList()
+  {
+    for (NodeNumType i=0; i<m_OpenList.size(); ++i)
+    {
+      ShortestPathNode &node = m_Nodes[m_OpenList[i]];
+      node.distAndEst = node.distance + getEstimatedCostsToTarget(NodeToCoord(node.mainListIndex));
+    }
+    for (NodeNumType i=m_OpenList.size()/2; i>0; --i)
+    {
+      SiftDown(i-1);
+    }
+  }
+
+
   template <class TInputImageType, class TOutputImageType>
   void
     ShortestPathImageFilter<TInputImageType, TOutputImageType>::
@@ -503,47 +384,25 @@ namespace itk
     // init variables
     double durationAll = 0;
     bool timeout = false;
-    bool makeNewHeapNecessary = false;
     NodeNumType mainNodeListIndex = 0;
-    DistanceType curNodeDistance = 0;
-    DistanceType curNodeDistAndEst = 0;
-    NodeNumType numberOfNodesChecked = 0;
-
-    // Create Multimap (tree structure for fast searching)
-    std::multimap<double,ShortestPathNode*> myMap;
-    std::pair< std::multimap<double,ShortestPathNode*>::iterator, std::multimap<double,ShortestPathNode*>::iterator> ret;
-    std::multimap<double,ShortestPathNode*>::iterator it;
+    m_NumberOfCheckedNodes = 0;
 
-    // At first, only startNote is discovered.
-    myMap.insert( std::pair<double,ShortestPathNode*> (m_Nodes[m_Graph_StartNode].distAndEst, &m_Nodes[m_Graph_StartNode]) );
+    // The end point may have been reached by the search tree of the last update already
+    if (!multipleEndPoints && !m_CalcAllDistances && m_Nodes[m_Graph_EndNode].closed)
+    {
+      return;
+    }
 
     // While there are discovered Nodes, pick the one with lowest distance,
     // update its neighbors and eventually delete it from the discovered Nodes list.
-    while(!myMap.empty())
+    while(!m_OpenList.empty())
     {
-      numberOfNodesChecked++;
-      /*if ( (numberOfNodesChecked % (m_Graph_NumberOfNodes/100)) == 0)
-      {
-        MITK_INFO << "Checked " << ( numberOfNodesChecked / (m_Graph_NumberOfNodes/100) ) << "% List: " << myMap.size() << "\n";
-      }*/
-
-      // Get element with lowest score
-      mainNodeListIndex = myMap.begin()->second->mainListIndex;
-      curNodeDistAndEst = myMap.begin()->second->distAndEst;
-      curNodeDistance = myMap.begin()->second->distance;
-      myMap.begin()->second->closed = true; // close it
-
-      // Debug:
-      //MITK_INFO << "INFO: size " << myMap.size();
-      /*
-      for (it = myMap.begin(); it != myMap.end(); ++it)
-      {
-      MITK_INFO << "(1) " << it->first << "|" << it->second->distAndEst << "|"<<it->second->mainListIndex;
-      }
-      */
+      m_NumberOfCheckedNodes++;
 
-      // Kicks out element with lowest score
-      myMap.erase( myMap.begin() );
+      // Kicks out element with lowest score and closes it
+      mainNodeListIndex = PopOpenList();
+      ShortestPathNode &curNode = m_Nodes[mainNodeListIndex];
+      curNode.closed = true;
 
       // if wanted, store vector order
       if (m_StoreVectorOrder)
@@ -552,140 +411,36 @@ namespace itk
       }
 
       // Check neighbors
-      std::vector<ShortestPathNode*> neighborNodes = GetNeighbors(mainNodeListIndex, m_Graph_fullNeighbors);
-      for (NodeNumType i=0; i<neighborNodes.size(); i++)
+      IndexType coordCurNode = NodeToCoord(mainNodeListIndex);
+      for (unsigned int i=0; i<m_NeighborOffsets.size(); i++)
       {
-        if (neighborNodes[i]->closed)
-          continue; // this nodes is already closed, go to next neighbor
+        IndexType coordNeighborNode = coordCurNode + m_NeighborOffsets[i];
+        if (!CoordIsInBounds(coordNeighborNode))
+          continue;
 
-        IndexType coordCurNode = NodeToCoord(mainNodeListIndex);
-        IndexType coordNeighborNode = NodeToCoord(neighborNodes[i]->mainListIndex);
+        ShortestPathNode &neighborNode = m_Nodes[CoordToNode(coordNeighborNode)];
+        if (neighborNode.closed)
+          continue; // this nodes is already closed, go to next neighbor
 
         // calculate the new Distance to the current neighbor
-        double newDistance = curNodeDistance
+        double newDistance = curNode.distance
           + (m_CostFunction->GetCost(coordCurNode, coordNeighborNode));
 
-        // if it is shorter than any yet known path to this neighbor, than the current path is better. Save that!
-        if ((newDistance < neighborNodes[i]->distance) || (neighborNodes[i]->distance == -1) )
+        // if that neighbornode is not in discoverednodeList yet, Push it there and update
+        if (neighborNode.distance == -1)
         {
-          // if that neighbornode is not in discoverednodeList yet, Push it there and update
-          if (neighborNodes[i]->distance == -1)
-          {
-
-            neighborNodes[i]->distance = newDistance;
-            neighborNodes[i]->distAndEst = newDistance + getEstimatedCostsToTarget(coordNeighborNode);
-            neighborNodes[i]->prevNode = mainNodeListIndex;
-            myMap.insert( std::pair<double,ShortestPathNode*> (m_Nodes[neighborNodes[i]->mainListIndex].distAndEst, &m_Nodes[neighborNodes[i]->mainListIndex]) );
-            /*
-            MITK_INFO << "Inserted: " << m_Nodes[neighborNodes[i]->mainListIndex].distAndEst << "|" << m_Nodes[neighborNodes[i]->mainListIndex].mainListIndex;
-            MITK_INFO << "INFO: size " << myMap.size();
-            for (it = myMap.begin(); it != myMap.end(); ++it)
-            {
-            MITK_INFO << "(1) " << it->first << "|" << it->second->distAndEst << "|"<<it->second->mainListIndex;
-            }
-            */
-          }
-          // or if is already in discoverednodelist, update
-          else
-          {
-
-            /*
-            it = myMap.find(neighborNodes[i]->distAndEst);
-            if (it == myMap.end() )
-            {
-            MITK_INFO << "Nothing!";
-            // look further
-            for (it = myMap.begin(); it != myMap.end(); ++it)
-            {
-            if ((*it).second->mainListIndex == lookForId)
-            {
-            MITK_INFO << "But it is there!!!";
-            MITK_INFO << "Searched for: " << lookFor << "   but had: " << (*it).second->distAndEst;
-            }
-
-            }
-            }
-            */
-
-            // 1st : find and delete old element
-            bool found = false;
-            double lookFor = neighborNodes[i]->distAndEst;
-            unsigned int lookForId = neighborNodes[i]->mainListIndex;
-            ret = myMap.equal_range(neighborNodes[i]->distAndEst);
-
-            if ((ret.first == ret.second))
-            {
-              /*+++++++++++++ no exact match +++++++++++++*/
-              //MITK_INFO << "No exact match!"; // if this happens, you are screwed
-              /*
-              MITK_INFO << "Was looking for: " << lookFor << "  ID: " << lookForId;
-              if (ret.first != myMap.end() )
-              {
-              it = ret.first;
-              MITK_INFO << "Found: " << it->first << "  ID: " << it->second->mainListIndex;
-              ++it;
-              MITK_INFO << "Found: " << it->first << "  ID: " << it->second->mainListIndex;
-              --it;
-              --it;
-              MITK_INFO << "Found: " << it->first << "  ID: " << it->second->mainListIndex;
-              }
-
-              // look if that ID is found in the map
-              for (it = myMap.begin(); it != myMap.end(); ++it)
-              {
-              if ((*it).second->mainListIndex == lookForId)
-              {
-              MITK_INFO << "But it is there!!!";
-              MITK_INFO << "Searched dist: " << lookFor << "  found dist: " << (*it).second->distAndEst;
-              }
-
-              }
-              */
-            }
-            else
-            {
-              for (it=ret.first; it!=ret.second; ++it)
-              {
-                if (it->second->mainListIndex == neighborNodes[i]->mainListIndex)
-                {
-                  found = true;
-                  myMap.erase(it);
-                  /*
-                  MITK_INFO << "INFO: size " << myMap.size();
-                  MITK_INFO << "Erase: " << it->first << "|" << it->second->mainListIndex;
-
-                  MITK_INFO << "INFO: size " << myMap.size();
-                  for (it = myMap.begin(); it != myMap.end(); ++it)
-                  {
-                  MITK_INFO << "(1) " << it->first << "|" << it->second->distAndEst << "|"<<it->second->mainListIndex;
-                  }
-                  */
-                  break;
-                }
-              }
-            }
-
-            if (!found)
-            {
-              //MITK_INFO << "Could not find it! :(";
-              continue;
-            }
-
-            // 2nd: update and insert new element
-            neighborNodes[i]->distance = newDistance;
-            neighborNodes[i]->distAndEst = newDistance + getEstimatedCostsToTarget(coordNeighborNode);
-            neighborNodes[i]->prevNode = mainNodeListIndex;
-            //myMap.insert( std::pair<double,ShortestPathNode*> (neighborNodes[i]->distAndEst, neighborNodes[i]));
-            myMap.insert( std::pair<double,ShortestPathNode*> (m_Nodes[neighborNodes[i]->mainListIndex].distAndEst, &m_Nodes[neighborNodes[i]->mainListIndex]) );
-
-            //MITK_INFO << "Re-Inserted: " << m_Nodes[neighborNodes[i]->mainListIndex].distAndEst << "|" << m_Nodes[neighborNodes[i]->mainListIndex].mainListIndex;
-            //MITK_INFO << "INFO: size " << myMap.size();
-            /*for (it = myMap.begin(); it != myMap.end(); ++it)
-            {
-            MITK_INFO << "(1) " << it->first << "|" << it->second->distAndEst << "|"<<it->second->mainListIndex;
-            }*/
-
-          }
+          neighborNode.distance = newDistance;
+          neighborNode.distAndEst = newDistance + getEstimatedCostsToTarget(coordNeighborNode);
+          neighborNode.prevNode = mainNodeListIndex;
+          PushOpenList(neighborNode.mainListIndex);
+        }
+        // or if it is shorter than any yet known path to this neighbor, than the current path is better. Save that!
+        else if (newDistance < neighborNode.distance)
+        {
+          neighborNode.distance = newDistance;
+          neighborNode.distAndEst = newDistance + getEstimatedCostsToTarget(coordNeighborNode);
+          neighborNode.prevNode = mainNodeListIndex;
+          SiftUp(neighborNode.heapIndex);
         }
       }
       // finished with checking all neighbors.
@@ -706,25 +461,30 @@ namespace itk
       // For multiple points
       if ( multipleEndPoints )
       {
-        // super slow, make it faster
-        for (int i=0 ;i<m_endPoints.size(); i++)
+        for (unsigned int i=0; i<m_endPoints.size(); )
         {
           if (CoordToNode(m_endPoints[i]) == mainNodeListIndex)
           {
             m_endPointsClosed.push_back(NodeToCoord(mainNodeListIndex));
             m_endPoints.erase(m_endPoints.begin()+i);
-            if (m_endPoints.empty())
-            {
-              // Finished! break
-              return;
-            }
-            if (m_Graph_EndNode == mainNodeListIndex)
-            {
-              // set new end
-              SetEndIndex( m_endPoints[0] );
-            }
+          }
+          else
+          {
+            ++i;
           }
         }
+        if (m_endPoints.empty())
+        {
+          // Finished! break
+          return;
+        }
+        if (m_Graph_EndNode == mainNodeListIndex)
+        {
+          // set new end, the estimates of all open nodes change with it
+          m_EndIndex = m_endPoints[0];
+          m_Graph_EndNode = CoordToNode(m_EndIndex);
+          RebuildOpenList();
+        }
       }
       // if single end point, then end, if this one is reached or timeout happened.
       else if ( ( mainNodeListIndex == m_Graph_EndNode || timeout) && !m_CalcAllDistances)
@@ -825,10 +585,15 @@ namespace itk
     for (distanceImageIt.GoToBegin(); !distanceImageIt.IsAtEnd(); ++distanceImageIt)
     {
       IndexType index = distanceImageIt.GetIndex();
-      myNodeNum = CoordToNode(index);
-      double newVal = m_Nodes[myNodeNum].distance;
+      double newVal = -1; // pixels outside the search region were never reached
+      if (m_Initialized && CoordIsInBounds(index))
+      {
+        myNodeNum = CoordToNode(index);
+        newVal = m_Nodes[myNodeNum].distance;
+      }
       distanceImageIt.Set(newVal);
     }
+    return image;
   }
 
 
@@ -914,8 +679,9 @@ namespace itk
     m_VectorPath.clear();
     //TODO: if multiple Path, clear all multiple Paths
 
-    if (m_Nodes)
-      delete [] m_Nodes;
+    // m_Nodes keeps its memory for the next graph
+    m_OpenList.clear();
+    m_Initialized = false;
   }
 
 
@@ -943,7 +709,8 @@ namespace itk
     PrintSelf( std::ostream& os, Indent indent ) const
   {
     Superclass::PrintSelf(os,indent);
-
+    os << indent << "SearchRegion: " << m_SearchRegion << std::endl;
+    os << indent << "NumberOfCheckedNodes: " << m_NumberOfCheckedNodes << std::endl;
   }
 
 } /* end namespace itk */
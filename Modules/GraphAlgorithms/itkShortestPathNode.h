@@ -30,6 +30,7 @@ namespace itk
      DistanceType distAndEst;    // Distance+Estimated Distnace to target
       NodeNumType prevNode;       // previous node. Important to find the Shortest Path
       NodeNumType mainListIndex;  // Indexnumber of this node in m_Nodes
+      NodeNumType heapIndex;      // position of this node in the open list (only valid while the node is discovered but not closed)
       bool closed; // determines if this node is closes, so its optimal path to startNode is known
   };
 
@@ -0,0 +1,724 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkNavigationDataBinaryFile.h"
+
+#include <itk_zlib.h>
+
+#include <cstring>
+
+//headers for exceptions
+#include "mitkIGTException.h"
+#include "mitkIGTIOException.h"
+
+const char* const mitk::NavigationDataBinaryFormat::FileMagic = "MITKNDBF";
+const char* const mitk::NavigationDataBinaryFormat::IndexMagic = "MITKNDBI";
+
+namespace
+{
+  typedef mitk::NavigationDataBinaryFormat Format;
+
+  template <typename T>
+  void AppendValue(std::vector<char>& buffer, T value)
+  {
+    const char* bytes = reinterpret_cast<const char*>(&value);
+    buffer.insert(buffer.end(), bytes, bytes + sizeof(T));
+  }
+
+  template <typename T>
+  T ReadValue(const char*& position)
+  {
+    T value;
+    memcpy(&value, position, sizeof(T));
+    position += sizeof(T);
+    return value;
+  }
+}
+
+mitk::NavigationDataBinaryWriter::NavigationDataBinaryWriter()
+: m_Compression(false),
+  m_FramesPerBlock(256),
+  m_NumberOfTools(0),
+  m_NumberOfFrames(0),
+  m_Stream(NULL),
+  m_CurrentBlock(NULL),
+  m_MultiThreader(itk::MultiThreader::New()),
+  m_ThreadID(-1),
+  m_BlockAvailable(itk::ConditionVariable::New()),
+  m_Closing(false),
+  m_WriteError(false),
+  m_BytesWritten(0),
+  m_NumberOfBlocks(0)
+{
+}
+
+mitk::NavigationDataBinaryWriter::~NavigationDataBinaryWriter()
+{
+  try
+  {
+    this->Close();
+  }
+  catch(mitk::IGTException& e)
+  {
+    MITK_ERROR << "Could not finish binary NavigationData recording: " << e.GetDescription();
+  }
+  delete m_CurrentBlock;
+}
+
+void mitk::NavigationDataBinaryWriter::Open(std::ostream* stream, unsigned int numberOfTools)
+{
+  if (m_Stream != NULL)
+  {
+    mitkThrowException(mitk::IGTException) << "Binary NavigationData writer is already open";
+  }
+  if (stream == NULL || !stream->good())
+  {
+    mitkThrowException(mitk::IGTIOException) << "The stream is NULL or it is not good";
+  }
+
+  if (m_FramesPerBlock == 0)
+  {
+    m_FramesPerBlock = 1;
+  }
+  m_NumberOfTools = numberOfTools;
+  m_NumberOfFrames = 0;
+  m_NumberOfBlocks = 0;
+  m_Index.clear();
+  m_Closing = false;
+  m_WriteError = false;
+
+  std::vector<char> header(Format::FileMagic, Format::FileMagic + 8);
+  AppendValue<itk::uint32_t>(header, Format::Version);
+  AppendValue<itk::uint32_t>(header, m_NumberOfTools);
+  AppendValue<itk::uint32_t>(header, m_Compression ? Format::Compressed : 0);
+  AppendValue<itk::uint32_t>(header, m_FramesPerBlock);
+  AppendValue<itk::uint32_t>(header, Format::GetFrameSize(m_NumberOfTools));
+  AppendValue<itk::uint32_t>(header, 0);
+
+  stream->write(&header[0], header.size());
+  if (!stream->good())
+  {
+    mitkThrowException(mitk::IGTIOException) << "Could not write header of binary NavigationData recording";
+  }
+  m_BytesWritten = header.size();
+
+  m_Stream = stream;
+  m_ThreadID = m_MultiThreader->SpawnThread(ThreadStartWriting, this);
+}
+
+void mitk::NavigationDataBinaryWriter::AddFrame(TimeStampType timeStamp, TimeStampType systemTimeStamp,
+                                                const std::vector<const NavigationData*>& navigationDatas)
+{
+  if (m_Stream == NULL)
+  {
+    mitkThrowException(mitk::IGTException) << "Binary NavigationData writer is not open";
+  }
+  if (navigationDatas.size() != m_NumberOfTools)
+  {
+    mitkThrowException(mitk::IGTException) << "Expected " << m_NumberOfTools << " NavigationDatas per frame, got " << navigationDatas.size();
+  }
+
+  if (m_CurrentBlock == NULL)
+  {
+    m_CurrentBlock = new Block;
+    m_CurrentBlock->m_Data.reserve(Format::GetFrameSize(m_NumberOfTools) * m_FramesPerBlock);
+    m_CurrentBlock->m_NumberOfFrames = 0;
+    m_CurrentBlock->m_FirstTimeStamp = timeStamp;
+  }
+
+  std::vector<char>& data = m_CurrentBlock->m_Data;
+  AppendValue<double>(data, timeStamp);
+  AppendValue<double>(data, systemTimeStamp);
+
+  for (unsigned int index = 0; index < m_NumberOfTools; index++)
+  {
+    const NavigationData* nd = navigationDatas[index];
+
+    const NavigationData::PositionType position = nd->GetPosition();
+    for (unsigned int i = 0; i < 3; i++)
+    {
+      AppendValue<double>(data, position[i]);
+    }
+
+    const NavigationData::OrientationType orientation = nd->GetOrientation();
+    for (unsigned int i = 0; i < 4; i++)
+    {
+      AppendValue<double>(data, orientation[i]);
+    }
+
+    const NavigationData::CovarianceMatrixType matrix = nd->GetCovErrorMatrix();
+    for (unsigned int row = 0; row < 2; row++)
+    {
+      for (unsigned int column = 0; column < 6; column++)
+      {
+        AppendValue<double>(data, matrix[row][column]);
+      }
+    }
+
+    itk::uint32_t flags = 0;
+    if (nd->IsDataValid())
+      flags |= Format::DataValid;
+    if (nd->GetHasOrientation())
+      flags |= Format::HasOrientation;
+    if (nd->GetHasPosition())
+      flags |= Format::HasPosition;
+    AppendValue<itk::uint32_t>(data, flags);
+  }
+
+  m_CurrentBlock->m_LastTimeStamp = timeStamp;
+  m_CurrentBlock->m_NumberOfFrames++;
+  m_NumberOfFrames++;
+
+  if (m_CurrentBlock->m_NumberOfFrames >= m_FramesPerBlock)
+  {
+    this->EnqueueCurrentBlock();
+  }
+}
+
+void mitk::NavigationDataBinaryWriter::Close()
+{
+  if (m_Stream == NULL)
+  {
+    return;
+  }
+
+  this->EnqueueCurrentBlock();
+
+  m_Mutex.Lock();
+  m_Closing = true;
+  m_Mutex.Unlock();
+  m_BlockAvailable->Signal();
+
+  // waits until the thread has written all blocks
+  m_MultiThreader->TerminateThread(m_ThreadID);
+  m_ThreadID = -1;
+
+  std::ostream* stream = m_Stream;
+  m_Stream = NULL;
+
+  if (m_WriteError)
+  {
+    mitkThrowException(mitk::IGTIOException) << "Could not write binary NavigationData recording";
+  }
+
+  std::vector<char> footer;
+  AppendValue<itk::uint64_t>(footer, m_BytesWritten);
+  AppendValue<itk::uint32_t>(footer, m_NumberOfBlocks);
+  AppendValue<itk::uint32_t>(footer, 0);
+  footer.insert(footer.end(), Format::IndexMagic, Format::IndexMagic + 8);
+
+  if (!m_Index.empty())
+  {
+    stream->write(&m_Index[0], m_Index.size());
+  }
+  stream->write(&footer[0], footer.size());
+  stream->flush();
+  m_Index.clear();
+
+  if (!stream->good())
+  {
+    mitkThrowException(mitk::IGTIOException) << "Could not write index of binary NavigationData recording";
+  }
+}
+
+void mitk::NavigationDataBinaryWriter::EnqueueCurrentBlock()
+{
+  if (m_CurrentBlock == NULL)
+  {
+    return;
+  }
+
+  m_Mutex.Lock();
+  m_Queue.push_back(m_CurrentBlock);
+  m_Mutex.Unlock();
+  m_CurrentBlock = NULL;
+
+  m_BlockAvailable->Signal();
+}
+
+ITK_THREAD_RETURN_TYPE mitk::NavigationDataBinaryWriter::ThreadStartWriting(void* pInfoStruct)
+{
+  itk::MultiThreader::ThreadInfoStruct* threadInfo = static_cast<itk::MultiThreader::ThreadInfoStruct*>(pInfoStruct);
+  static_cast<NavigationDataBinaryWriter*>(threadInfo->UserData)->WriteBlocks();
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+void mitk::NavigationDataBinaryWriter::WriteBlocks()
+{
+  m_Mutex.Lock();
+  while (true)
+  {
+    while (m_Queue.empty() && !m_Closing)
+    {
+      m_BlockAvailable->Wait( &m_Mutex );
+    }
+    if (m_Queue.empty())
+    {
+      break;
+    }
+
+    Block* block = m_Queue.front();
+    m_Queue.pop_front();
+    bool writeError = m_WriteError;
+    m_Mutex.Unlock();
+
+    // after an error the remaining blocks are discarded, the index would not match the file anymore
+    if (!writeError)
+    {
+      writeError = !this->WriteBlock(block);
+    }
+    delete block;
+
+    m_Mutex.Lock();
+    m_WriteError = writeError;
+  }
+  m_Mutex.Unlock();
+}
+
+bool mitk::NavigationDataBinaryWriter::WriteBlock(const Block* block)
+{
+  const char* data = &block->m_Data[0];
+  itk::uint32_t rawSize = block->m_Data.size();
+  itk::uint32_t storedSize = rawSize;
+  itk::uint32_t flags = 0;
+
+  std::vector<char> compressed;
+  if (m_Compression)
+  {
+    // the tracking data of one block is small, speed matters more than ratio
+    ::uLongf destLen = ::compressBound(rawSize);
+    compressed.resize(destLen);
+    int zlibRetVal = ::compress2( reinterpret_cast< ::Bytef*>(&compressed[0]), &destLen,
+                                  reinterpret_cast<const ::Bytef*>(data), rawSize, Z_BEST_SPEED );
+    if (zlibRetVal == Z_OK && destLen < rawSize)
+    {
+      data = &compressed[0];
+      storedSize = destLen;
+      flags |= Format::Compressed;
+    }
+  }
+
+  std::vector<char> header;
+  AppendValue<itk::uint32_t>(header, storedSize);
+  AppendValue<itk::uint32_t>(header, rawSize);
+  AppendValue<itk::uint32_t>(header, block->m_NumberOfFrames);
+  AppendValue<itk::uint32_t>(header, flags);
+  AppendValue<double>(header, block->m_FirstTimeStamp);
+  AppendValue<double>(header, block->m_LastTimeStamp);
+
+  m_Stream->write(&header[0], header.size());
+  m_Stream->write(data, storedSize);
+  // written blocks can be read even if the recording is never closed
+  m_Stream->flush();
+  if (!m_Stream->good())
+  {
+    return false;
+  }
+
+  AppendValue<double>(m_Index, block->m_FirstTimeStamp);
+  AppendValue<double>(m_Index, block->m_LastTimeStamp);
+  AppendValue<itk::uint64_t>(m_Index, m_BytesWritten);
+  AppendValue<itk::uint32_t>(m_Index, block->m_NumberOfFrames);
+  AppendValue<itk::uint32_t>(m_Index, 0);
+  m_NumberOfBlocks++;
+
+  m_BytesWritten += header.size() + storedSize;
+  return true;
+}
+
+
+mitk::NavigationDataBinaryReader::NavigationDataBinaryReader()
+: m_Stream(NULL),
+  m_StartPosition(0),
+  m_EndPosition(0),
+  m_NumberOfTools(0),
+  m_FrameSize(0),
+  m_NumberOfFrames(0),
+  m_DecodedBlock(-1)
+{
+}
+
+mitk::NavigationDataBinaryReader::~NavigationDataBinaryReader()
+{
+}
+
+bool mitk::NavigationDataBinaryReader::IsBinaryRecording(std::istream* stream)
+{
+  if (stream == NULL || !stream->good())
+  {
+    return false;
+  }
+
+  std::istream::pos_type position = stream->tellg();
+  if (position == std::istream::pos_type(-1))
+  {
+    return false;
+  }
+
+  char magic[8];
+  stream->read(magic, 8);
+  bool isBinary = (stream->gcount() == 8) && (memcmp(magic, Format::FileMagic, 8) == 0);
+
+  stream->clear();
+  stream->seekg(position);
+  return isBinary;
+}
+
+void mitk::NavigationDataBinaryReader::Open(std::istream* stream)
+{
+  this->Close();
+
+  if (stream == NULL || !stream->good())
+  {
+    mitkThrowException(mitk::IGTIOException) << "The stream is NULL or it is not good";
+  }
+
+  m_StartPosition = stream->tellg();
+
+  char header[Format::HeaderSize];
+  stream->read(header, Format::HeaderSize);
+  if (stream->gcount() != Format::HeaderSize || memcmp(header, Format::FileMagic, 8) != 0)
+  {
+    mitkThrowException(mitk::IGTIOException) << "The stream is not a binary NavigationData recording";
+  }
+
+  const char* position = header + 8;
+  itk::uint32_t version = ReadValue<itk::uint32_t>(position);
+  m_NumberOfTools = ReadValue<itk::uint32_t>(position);
+  ReadValue<itk::uint32_t>(position); // flags, compression is given per block
+  ReadValue<itk::uint32_t>(position); // frames per block, given per block
+  m_FrameSize = ReadValue<itk::uint32_t>(position);
+
+  if (version > Format::Version)
+  {
+    mitkThrowException(mitk::IGTIOException) << "Binary NavigationData recording has unsupported version " << version;
+  }
+  if (m_NumberOfTools == 0 || m_FrameSize != Format::GetFrameSize(m_NumberOfTools))
+  {
+    mitkThrowException(mitk::IGTIOException) << "Header of binary NavigationData recording is damaged";
+  }
+
+  m_Stream = stream;
+  m_Stream->seekg(0, std::ios::end);
+  std::istream::pos_type end = m_Stream->tellg();
+  m_EndPosition = end;
+
+  if (!this->ReadIndex(end))
+  {
+    MITK_WARN << "Binary NavigationData recording has no index, it was probably not closed. Reading all blocks.";
+    this->RebuildIndex(end);
+  }
+
+  m_NumberOfFrames = 0;
+  for (std::size_t block = 0; block < m_Index.size(); block++)
+  {
+    m_Index[block].m_FirstFrame = m_NumberOfFrames;
+    m_NumberOfFrames += m_Index[block].m_NumberOfFrames;
+  }
+}
+
+void mitk::NavigationDataBinaryReader::Close()
+{
+  m_Stream = NULL;
+  m_NumberOfTools = 0;
+  m_FrameSize = 0;
+  m_NumberOfFrames = 0;
+  m_Index.clear();
+  m_DecodedBlock = -1;
+  m_DecodedData.clear();
+}
+
+bool mitk::NavigationDataBinaryReader::ReadIndex(std::istream::pos_type end)
+{
+  std::streamoff size = end - m_StartPosition;
+  if (size < static_cast<std::streamoff>(Format::HeaderSize + Format::FooterSize))
+  {
+    return false;
+  }
+
+  char footer[Format::FooterSize];
+  m_Stream->clear();
+  m_Stream->seekg(end - static_cast<std::streamoff>(Format::FooterSize));
+  m_Stream->read(footer, Format::FooterSize);
+  if (m_Stream->gcount() != Format::FooterSize || memcmp(footer + Format::FooterSize - 8, Format::IndexMagic, 8) != 0)
+  {
+    m_Stream->clear();
+    return false;
+  }
+
+  const char* position = footer;
+  itk::uint64_t indexOffset = ReadValue<itk::uint64_t>(position);
+  itk::uint32_t numberOfBlocks = ReadValue<itk::uint32_t>(position);
+  if (indexOffset + static_cast<itk::uint64_t>(numberOfBlocks) * Format::IndexEntrySize + Format::FooterSize != static_cast<itk::uint64_t>(size))
+  {
+    return false;
+  }
+
+  std::vector<char> index(numberOfBlocks * Format::IndexEntrySize + 1);
+  m_Stream->seekg(m_StartPosition + static_cast<std::streamoff>(indexOffset));
+  m_Stream->read(&index[0], numberOfBlocks * Format::IndexEntrySize);
+  if (!m_Stream->good())
+  {
+    m_Stream->clear();
+    return false;
+  }
+
+  position = &index[0];
+  for (itk::uint32_t block = 0; block < numberOfBlocks; block++)
+  {
+    IndexEntry entry;
+    entry.m_FirstTimeStamp = ReadValue<double>(position);
+    entry.m_LastTimeStamp = ReadValue<double>(position);
+    entry.m_Offset = ReadValue<itk::uint64_t>(position);
+    entry.m_NumberOfFrames = ReadValue<itk::uint32_t>(position);
+    ReadValue<itk::uint32_t>(position); // reserved
+    entry.m_FirstFrame = 0;
+    if (entry.m_NumberOfFrames > 0)
+    {
+      m_Index.push_back(entry);
+    }
+  }
+  return true;
+}
+
+void mitk::NavigationDataBinaryReader::RebuildIndex(std::istream::pos_type end)
+{
+  std::streamoff size = end - m_StartPosition;
+  itk::uint64_t offset = Format::HeaderSize;
+  m_Index.clear();
+  m_Stream->clear();
+
+  while (offset + Format::BlockHeaderSize <= static_cast<itk::uint64_t>(size))
+  {
+    char header[Format::BlockHeaderSize];
+    m_Stream->seekg(m_StartPosition + static_cast<std::streamoff>(offset));
+    m_Stream->read(header, Format::BlockHeaderSize);
+    if (m_Stream->gcount() != Format::BlockHeaderSize)
+    {
+      break;
+    }
+
+    const char* position = header;
+    IndexEntry entry;
+    itk::uint32_t storedSize = ReadValue<itk::uint32_t>(position);
+    itk::uint32_t rawSize = ReadValue<itk::uint32_t>(position);
+    entry.m_NumberOfFrames = ReadValue<itk::uint32_t>(position);
+    ReadValue<itk::uint32_t>(position); // flags
+    entry.m_FirstTimeStamp = ReadValue<double>(position);
+    entry.m_LastTimeStamp = ReadValue<double>(position);
+    entry.m_Offset = offset;
+    entry.m_FirstFrame = 0;
+
+    // the last block may be incomplete, everything behind it is lost
+    if (rawSize != entry.m_NumberOfFrames * m_FrameSize
+        || offset + Format::BlockHeaderSize + storedSize > static_cast<itk::uint64_t>(size))
+    {
+      break;
+    }
+
+    if (entry.m_NumberOfFrames > 0)
+    {
+      m_Index.push_back(entry);
+    }
+    offset += Format::BlockHeaderSize + storedSize;
+  }
+
+  m_Stream->clear();
+}
+
+mitk::NavigationDataBinaryReader::TimeStampType mitk::NavigationDataBinaryReader::GetFirstTimeStamp() const
+{
+  return m_Index.empty() ? 0.0 : m_Index.front().m_FirstTimeStamp;
+}
+
+mitk::NavigationDataBinaryReader::TimeStampType mitk::NavigationDataBinaryReader::GetLastTimeStamp() const
+{
+  return m_Index.empty() ? 0.0 : m_Index.back().m_LastTimeStamp;
+}
+
+unsigned int mitk::NavigationDataBinaryReader::GetBlockOfFrame(unsigned int frame) const
+{
+  unsigned int low = 0;
+  unsigned int high = m_Index.size() - 1;
+  while (low < high)
+  {
+    unsigned int middle = (low + high + 1) / 2;
+    if (m_Index[middle].m_FirstFrame <= frame)
+      low = middle;
+    else
+      high = middle - 1;
+  }
+  return low;
+}
+
+unsigned int mitk::NavigationDataBinaryReader::FindFrame(TimeStampType timeStamp)
+{
+  if (m_NumberOfFrames == 0 || timeStamp < m_Index.front().m_FirstTimeStamp)
+  {
+    return 0;
+  }
+
+  // last block which starts not after timeStamp
+  unsigned int low = 0;
+  unsigned int high = m_Index.size() - 1;
+  while (low < high)
+  {
+    unsigned int middle = (low + high + 1) / 2;
+    if (m_Index[middle].m_FirstTimeStamp <= timeStamp)
+      low = middle;
+    else
+      high = middle - 1;
+  }
+  const IndexEntry& entry = m_Index[low];
+  const char* frames = this->DecodeBlock(low);
+
+  // last frame of this block which is not after timeStamp, the first frame always is
+  low = 0;
+  high = entry.m_NumberOfFrames - 1;
+  while (low < high)
+  {
+    unsigned int middle = (low + high + 1) / 2;
+    const char* position = frames + middle * m_FrameSize;
+    if (ReadValue<double>(position) <= timeStamp)
+      low = middle;
+    else
+      high = middle - 1;
+  }
+  return entry.m_FirstFrame + low;
+}
+
+mitk::NavigationDataBinaryReader::TimeStampType mitk::NavigationDataBinaryReader::ReadFrame(unsigned int frame,
+                                                                                            std::vector<NavigationData::Pointer>& navigationDatas)
+{
+  if (frame >= m_NumberOfFrames)
+  {
+    mitkThrowException(mitk::IGTException) << "Frame " << frame << " is out of range, the recording has " << m_NumberOfFrames << " frames";
+  }
+
+  unsigned int block = this->GetBlockOfFrame(frame);
+  const char* position = this->DecodeBlock(block) + (frame - m_Index[block].m_FirstFrame) * m_FrameSize;
+
+  TimeStampType timeStamp = ReadValue<double>(position);
+  ReadValue<double>(position); // system time
+
+  navigationDatas.resize(m_NumberOfTools);
+  for (unsigned int index = 0; index < m_NumberOfTools; index++)
+  {
+    if (navigationDatas[index].IsNull())
+    {
+      navigationDatas[index] = mitk::NavigationData::New();
+    }
+
+    mitk::NavigationData::PositionType position3D;
+    for (unsigned int i = 0; i < 3; i++)
+    {
+      position3D[i] = ReadValue<double>(position);
+    }
+
+    mitk::NavigationData::OrientationType orientation(0.0, 0.0, 0.0, 0.0);
+    for (unsigned int i = 0; i < 4; i++)
+    {
+      orientation[i] = ReadValue<double>(position);
+    }
+
+    mitk::NavigationData::CovarianceMatrixType matrix;
+    matrix.SetIdentity();
+    for (unsigned int row = 0; row < 2; row++)
+    {
+      for (unsigned int column = 0; column < 6; column++)
+      {
+        matrix[row][column] = ReadValue<double>(position);
+      }
+    }
+
+    itk::uint32_t flags = ReadValue<itk::uint32_t>(position);
+
+    mitk::NavigationData* nd = navigationDatas[index];
+    nd->SetIGTTimeStamp(timeStamp);
+    nd->SetPosition(position3D);
+    nd->SetOrientation(orientation);
+    nd->SetCovErrorMatrix(matrix);
+    nd->SetDataValid((flags & Format::DataValid) != 0);
+    nd->SetHasOrientation((flags & Format::HasOrientation) != 0);
+    nd->SetHasPosition((flags & Format::HasPosition) != 0);
+  }
+
+  return timeStamp;
+}
+
+const char* mitk::NavigationDataBinaryReader::DecodeBlock(unsigned int block)
+{
+  if (m_DecodedBlock == static_cast<int>(block))
+  {
+    return &m_DecodedData[0];
+  }
+  m_DecodedBlock = -1;
+
+  const IndexEntry& entry = m_Index[block];
+
+  char header[Format::BlockHeaderSize];
+  m_Stream->clear();
+  m_Stream->seekg(m_StartPosition + static_cast<std::streamoff>(entry.m_Offset));
+  m_Stream->read(header, Format::BlockHeaderSize);
+
+  const char* position = header;
+  itk::uint32_t storedSize = ReadValue<itk::uint32_t>(position);
+  itk::uint32_t rawSize = ReadValue<itk::uint32_t>(position);
+  itk::uint32_t numberOfFrames = ReadValue<itk::uint32_t>(position);
+  itk::uint32_t flags = ReadValue<itk::uint32_t>(position);
+
+  if (!m_Stream->good() || numberOfFrames != entry.m_NumberOfFrames || rawSize != numberOfFrames * m_FrameSize)
+  {
+    m_Stream->clear();
+    mitkThrowException(mitk::IGTIOException) << "Block " << block << " of binary NavigationData recording is damaged";
+  }
+
+  // the size is not trusted before the buffer is allocated, a damaged header could request gigabytes
+  std::streamoff bytesLeft = m_EndPosition - m_Stream->tellg();
+  if (storedSize == 0 || static_cast<std::streamoff>(storedSize) > bytesLeft
+      || (!(flags & Format::Compressed) && storedSize != rawSize))
+  {
+    mitkThrowException(mitk::IGTIOException) << "Block " << block << " of binary NavigationData recording has an invalid size of "
+                                             << storedSize << " bytes, " << bytesLeft << " bytes are left in the stream";
+  }
+
+  std::vector<char> stored(storedSize);
+  m_Stream->read(&stored[0], storedSize);
+  if (!m_Stream->good())
+  {
+    m_Stream->clear();
+    mitkThrowException(mitk::IGTIOException) << "Block " << block << " of binary NavigationData recording is incomplete";
+  }
+
+  if (flags & Format::Compressed)
+  {
+    m_DecodedData.resize(rawSize);
+    ::uLongf destLen(rawSize);
+    int zlibRetVal = ::uncompress( reinterpret_cast< ::Bytef*>(&m_DecodedData[0]), &destLen,
+                                   reinterpret_cast<const ::Bytef*>(&stored[0]), storedSize );
+    if (zlibRetVal != Z_OK || destLen != rawSize)
+    {
+      mitkThrowException(mitk::IGTIOException) << "Could not decompress block " << block << " of binary NavigationData recording (zlib error " << zlibRetVal << ")";
+    }
+  }
+  else
+  {
+    m_DecodedData.swap(stored);
+  }
+
+  m_DecodedBlock = block;
+  return &m_DecodedData[0];
+}
@@ -0,0 +1,277 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#ifndef MITKNAVIGATIONDATABINARYFILE_H_HEADER_INCLUDED_
+#define MITKNAVIGATIONDATABINARYFILE_H_HEADER_INCLUDED_
+
+#include <itkObject.h>
+#include <itkObjectFactory.h>
+#include <itkMultiThreader.h>
+#include <itkConditionVariable.h>
+#include <itkIntTypes.h>
+#include "MitkIGTExports.h"
+#include "mitkCommon.h"
+#include "mitkNavigationData.h"
+
+#include <deque>
+#include <iostream>
+#include <vector>
+
+namespace mitk {
+
+  /**Documentation
+  * \brief Layout of the binary recording format of NavigationDataRecorder, see NavigationDataBinaryWriter.
+  *
+  * A file consists of a header, a sequence of blocks of frames, an index of the blocks and a footer.
+  * All values are stored in little endian byte order (the byte order of all supported platforms).
+  *
+  * Header (32 bytes): "MITKNDBF", version, number of tools, flags, frames per block, frame size, reserved.
+  *
+  * Block: block header (32 bytes: stored size, raw size, number of frames, flags, first and last time stamp),
+  * followed by the frames, zlib compressed if bit 0 of the block flags is set.
+  *
+  * Frame: time stamp and system time (double), then for each tool position (3 double), orientation (4 double),
+  * the first two rows of the covariance matrix (12 double, like the XML format) and flags (valid, hO, hP).
+  * The values are stored with the precision of NavigationData, so a recording is played back unchanged.
+  *
+  * Index: one entry (32 bytes: first and last time stamp, file offset, number of frames, reserved) per block.
+  *
+  * Footer (24 bytes): file offset of the index, number of blocks, reserved, "MITKNDBI".
+  *
+  * A file without footer (e.g. if the application crashed while recording) can still be read, the index
+  * is rebuilt from the block headers in this case.
+  *
+  * \ingroup IGT
+  */
+  struct NavigationDataBinaryFormat
+  {
+    static const char* const FileMagic;
+    static const char* const IndexMagic;
+    static const unsigned int Version = 1;
+
+    static const unsigned int HeaderSize = 32;
+    static const unsigned int BlockHeaderSize = 32;
+    static const unsigned int IndexEntrySize = 32;
+    static const unsigned int FooterSize = 24;
+    static const unsigned int FrameHeaderSize = 16;
+    static const unsigned int ToolSize = 156;
+
+    /** \brief Flags of the file header and of the block headers */
+    enum BlockFlags
+    {
+      Compressed = 1
+    };
+
+    /** \brief Flags of the tools of a frame */
+    enum ToolFlags
+    {
+      DataValid = 1,
+      HasOrientation = 2,
+      HasPosition = 4
+    };
+
+    static unsigned int GetFrameSize(unsigned int numberOfTools) { return FrameHeaderSize + numberOfTools * ToolSize; }
+  };
+
+  /**Documentation
+  * \brief Writes NavigationData frames in the binary recording format (see NavigationDataBinaryFormat).
+  *
+  * AddFrame() only copies the frame into the current block, which is cheap enough to be called from the
+  * tracking thread at high update rates. Full blocks are compressed (optionally) and written to the stream
+  * by a background thread. Close() writes the remaining frames and the index and must be called before
+  * the stream is closed. The stream must not be accessed by anyone else between Open() and Close().
+  *
+  * \ingroup IGT
+  */
+  class MitkIGT_EXPORT NavigationDataBinaryWriter : public itk::Object
+  {
+  public:
+    mitkClassMacro(NavigationDataBinaryWriter, itk::Object);
+    itkNewMacro(Self);
+
+    typedef mitk::NavigationData::TimeStampType TimeStampType;
+
+    /** \brief If true the blocks are compressed with zlib. Must be set before Open(), default is false. */
+    itkSetMacro(Compression, bool);
+    itkGetMacro(Compression, bool);
+
+    /** \brief Number of frames which are written together. Must be set before Open(), default is 256. */
+    itkSetMacro(FramesPerBlock, unsigned int);
+    itkGetMacro(FramesPerBlock, unsigned int);
+
+    /** \brief Returns the number of frames added since Open(). */
+    itkGetMacro(NumberOfFrames, unsigned int);
+
+    /**
+    * \brief Writes the file header and starts a new recording with numberOfTools NavigationDatas per frame.
+    * @throw mitk::IGTIOException Throws an exception if the stream is NULL or not good.
+    * @throw mitk::IGTException Throws an exception if the writer is open already.
+    */
+    void Open(std::ostream* stream, unsigned int numberOfTools);
+
+    /**
+    * \brief Adds one frame. navigationDatas must contain the number of tools given to Open().
+    * @throw mitk::IGTException Throws an exception if the writer is not open or the number of tools is wrong.
+    */
+    void AddFrame(TimeStampType timeStamp, TimeStampType systemTimeStamp, const std::vector<const NavigationData*>& navigationDatas);
+
+    /**
+    * \brief Writes all remaining frames and the index. Does nothing if the writer is not open.
+    * @throw mitk::IGTIOException Throws an exception if writing to the stream failed.
+    */
+    void Close();
+
+  protected:
+    NavigationDataBinaryWriter();
+    virtual ~NavigationDataBinaryWriter();
+
+    struct Block
+    {
+      std::vector<char> m_Data;
+      unsigned int m_NumberOfFrames;
+      TimeStampType m_FirstTimeStamp;
+      TimeStampType m_LastTimeStamp;
+    };
+
+    static ITK_THREAD_RETURN_TYPE ThreadStartWriting(void* pInfoStruct);
+
+    /** \brief Loop of the writing thread, ends when the writer is closed and all blocks are written. */
+    void WriteBlocks();
+
+    /** \brief Compresses (if enabled) and writes one block, called in the writing thread. Returns false on errors. */
+    bool WriteBlock(const Block* block);
+
+    /** \brief Hands m_CurrentBlock over to the writing thread. */
+    void EnqueueCurrentBlock();
+
+    bool m_Compression;
+    unsigned int m_FramesPerBlock;
+    unsigned int m_NumberOfTools;
+    unsigned int m_NumberOfFrames;
+
+    std::ostream* m_Stream;
+    Block* m_CurrentBlock; ///< block which is filled by AddFrame()
+
+    itk::MultiThreader::Pointer m_MultiThreader;
+    int m_ThreadID;
+    itk::SimpleMutexLock m_Mutex; ///< guards all members below
+    itk::ConditionVariable::Pointer m_BlockAvailable;
+    std::deque<Block*> m_Queue;
+    bool m_Closing;
+    bool m_WriteError;
+
+    // only used by the writing thread until it is joined in Close()
+    itk::uint64_t m_BytesWritten;
+    std::vector<char> m_Index;
+    unsigned int m_NumberOfBlocks;
+  };
+
+  /**Documentation
+  * \brief Reads files of the binary recording format (see NavigationDataBinaryFormat).
+  *
+  * FindFrame() locates the frame of a time stamp in O(log n) with the block index, so a player can jump
+  * to any position of a recording. The block of the last read frame is kept decoded, reading the frames
+  * of a block one after the other does not read the stream again.
+  *
+  * \ingroup IGT
+  */
+  class MitkIGT_EXPORT NavigationDataBinaryReader : public itk::Object
+  {
+  public:
+    mitkClassMacro(NavigationDataBinaryReader, itk::Object);
+    itkNewMacro(Self);
+
+    typedef mitk::NavigationData::TimeStampType TimeStampType;
+
+    /**
+    * \brief Returns true if the stream (at its current position) starts with a binary recording.
+    * The position of the stream is not changed.
+    */
+    static bool IsBinaryRecording(std::istream* stream);
+
+    /**
+    * \brief Reads header and index of the recording which starts at the current position of the stream.
+    * The stream must stay valid until Close() and must be opened in binary mode.
+    * @throw mitk::IGTIOException Throws an exception if the stream is not a valid binary recording.
+    */
+    void Open(std::istream* stream);
+
+    /** \brief Forgets the stream given to Open(). */
+    void Close();
+
+    itkGetMacro(NumberOfTools, unsigned int);
+    itkGetMacro(NumberOfFrames, unsigned int);
+
+    /** \brief Returns the time stamp of the first frame (0 if there are no frames). */
+    TimeStampType GetFirstTimeStamp() const;
+
+    /** \brief Returns the time stamp of the last frame (0 if there are no frames). */
+    TimeStampType GetLastTimeStamp() const;
+
+    /**
+    * \brief Returns the last frame with a time stamp not greater than timeStamp, or frame 0 if timeStamp
+    * is before the first frame.
+    * @throw mitk::IGTIOException Throws an exception if the block containing the frame cannot be read.
+    */
+    unsigned int FindFrame(TimeStampType timeStamp);
+
+    /**
+    * \brief Reads the tools of one frame into navigationDatas (missing objects are created).
+    * @return the time stamp of the frame
+    * @throw mitk::IGTException Throws an exception if frame is out of range.
+    * @throw mitk::IGTIOException Throws an exception if the block containing the frame cannot be read.
+    */
+    TimeStampType ReadFrame(unsigned int frame, std::vector<NavigationData::Pointer>& navigationDatas);
+
+  protected:
+    NavigationDataBinaryReader();
+    virtual ~NavigationDataBinaryReader();
+
+    struct IndexEntry
+    {
+      TimeStampType m_FirstTimeStamp;
+      TimeStampType m_LastTimeStamp;
+      itk::uint64_t m_Offset;
+      unsigned int m_NumberOfFrames;
+      unsigned int m_FirstFrame; ///< number of frames in all blocks before
+    };
+
+    /** \brief Reads the index written by NavigationDataBinaryWriter::Close(), returns false if there is none. */
+    bool ReadIndex(std::istream::pos_type end);
+
+    /** \brief Builds the index from the block headers of an incomplete file. */
+    void RebuildIndex(std::istream::pos_type end);
+
+    /** \brief Makes block the decoded block, returns a pointer to its first frame. */
+    const char* DecodeBlock(unsigned int block);
+
+    /** \brief Returns the block index containing frame. */
+    unsigned int GetBlockOfFrame(unsigned int frame) const;
+
+    std::istream* m_Stream;
+    std::istream::pos_type m_StartPosition;
+    std::istream::pos_type m_EndPosition;
+    unsigned int m_NumberOfTools;
+    unsigned int m_FrameSize;
+    unsigned int m_NumberOfFrames;
+    std::vector<IndexEntry> m_Index;
+
+    int m_DecodedBlock; ///< block which is stored in m_DecodedData, -1 if none
+    std::vector<char> m_DecodedData;
+  };
+} // namespace mitk
+
+#endif /* MITKNAVIGATIONDATABINARYFILE_H_HEADER_INCLUDED_ */
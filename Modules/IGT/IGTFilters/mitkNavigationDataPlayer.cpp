@@ -86,6 +86,13 @@ void mitk::NavigationDataPlayer::GenerateData()
   //now we make a little time arithmetic
   //to get the elapsed time since the start of the player
   TimeStampType timeSinceStart = now - m_StartPlayingTimeStamp;
+
+  if (m_BinaryReader.IsNotNull())
+  {
+    this->GenerateBinaryData(timeSinceStart);
+    return;
+  }
+
   //init the vectors
   std::vector< NavigationData::Pointer > nextCandidates;
   std::vector< NavigationData::Pointer > lastCandidates;
@@ -158,6 +165,39 @@ void mitk::NavigationDataPlayer::GenerateData()
 }
 
 
+void mitk::NavigationDataPlayer::GenerateBinaryData(TimeStampType timeSinceStart)
+{
+  TimeStampType currentTimeOfData = timeSinceStart + m_StartTimeOfData.at(0);
+
+  //like for XML files, playing stops when the time of the last frame is over
+  if (currentTimeOfData > m_BinaryReader->GetLastTimeStamp())
+  {
+    m_StreamEnd = true;
+    StopPlaying();
+    return;
+  }
+
+  try
+  {
+    m_BinaryReader->ReadFrame(m_BinaryReader->FindFrame(currentTimeOfData), m_BinaryFrame);
+  }
+  catch(mitk::IGTException& e)
+  {
+    MITK_ERROR << "Playing not possible: " << e.GetDescription();
+    m_StreamEnd = true;
+    StopPlaying();
+    return;
+  }
+
+  for (unsigned int index = 0; index < m_NumberOfOutputs; index++)
+  {
+    mitk::NavigationData* output = this->GetOutput(index);
+    assert(output);
+    output->Graft(m_BinaryFrame.at(index));
+  }
+}
+
+
 void mitk::NavigationDataPlayer::UpdateOutputInformation()
 {
   this->Modified();  // make sure that we need to be updated
@@ -179,6 +219,12 @@ void mitk::NavigationDataPlayer::InitPlayer()
     return;
   }
 
+  if (mitk::NavigationDataBinaryReader::IsBinaryRecording(m_Stream))
+  {
+    InitBinaryPlayer();
+    return;
+  }
+
   //first get the file version
   m_FileVersion = GetFileVersion(m_Stream);
 
@@ -211,6 +257,56 @@ void mitk::NavigationDataPlayer::InitPlayer()
 
 }
 
+void mitk::NavigationDataPlayer::InitBinaryPlayer()
+{
+  m_BinaryReader = mitk::NavigationDataBinaryReader::New();
+  try
+  {
+    m_BinaryReader->Open(m_Stream);
+  }
+  catch(mitk::IGTException& e)
+  {
+    m_BinaryReader = NULL;
+    StreamInvalid(e.GetDescription());
+    return;
+  }
+
+  if (m_BinaryReader->GetNumberOfFrames() == 0)
+  {
+    m_BinaryReader = NULL;
+    StreamInvalid("The binary recording has no NavigationData.");
+    return;
+  }
+
+  if (m_NumberOfOutputs == 0) {m_NumberOfOutputs = m_BinaryReader->GetNumberOfTools();}
+  if (m_NumberOfOutputs != m_BinaryReader->GetNumberOfTools())
+  {
+    m_BinaryReader = NULL;
+    StreamInvalid("The number of tools of the binary recording does not match the outputs of the player.");
+    return;
+  }
+
+  if (this->GetNumberOfOutputs() != m_NumberOfOutputs) {SetNumberOfOutputs(m_NumberOfOutputs);}
+
+  m_BinaryFrame.clear();
+  m_BinaryReader->ReadFrame(0, m_BinaryFrame);
+
+  for (unsigned int index = 0; index < m_NumberOfOutputs; index++)
+  {
+    //Have a look it the output was set already without this check the pipline will disconnect after a start/stop cycle
+    if (this->GetOutput(index) == NULL)
+    {
+      mitk::NavigationData::Pointer nd = mitk::NavigationData::New();
+      nd->Graft(m_BinaryFrame[index]);
+      this->SetNthOutput(index, nd);
+    }
+    m_StartTimeOfData.push_back(m_BinaryReader->GetFirstTimeStamp());
+  }
+
+  m_ErrorMessage = "";
+  m_StreamValid = true;
+}
+
 unsigned int mitk::NavigationDataPlayer::GetFileVersion(std::istream* stream)
 {
   if (stream==NULL)
@@ -399,6 +495,8 @@ void mitk::NavigationDataPlayer::StopPlaying()
   //only PlayerMode and FileName are not changed
   m_Pause = false;
   m_Playing = false;
+  m_BinaryReader = NULL;
+  m_BinaryFrame.clear();
   if (!m_StreamSetOutsideFromClass)
     {delete m_Stream;}
   m_Stream = NULL;
@@ -486,6 +584,30 @@ void mitk::NavigationDataPlayer::Resume()
 }
 
 
+void mitk::NavigationDataPlayer::SeekToTime(mitk::NavigationData::TimeStampType time)
+{
+  if (!m_Playing && !m_Pause)
+  {
+    mitkThrowException(mitk::IGTException) << "Player is not started!";
+  }
+  if (m_BinaryReader.IsNull())
+  {
+    mitkThrowException(mitk::IGTException) << "Seeking is only possible in binary recordings!";
+  }
+
+  // GenerateData() computes the position from m_StartPlayingTimeStamp, a pause is continued at the new position
+  if (m_Pause)
+  {
+    m_StartPlayingTimeStamp = m_PauseTimeStamp - time;
+  }
+  else
+  {
+    m_StartPlayingTimeStamp = mitk::IGTTimeStamp::GetInstance()->GetElapsed() - time;
+  }
+  this->Modified();
+}
+
+
 void mitk::NavigationDataPlayer::CreateStreamFromFilename()
 {
   m_Stream = NULL;
@@ -498,7 +620,13 @@ void mitk::NavigationDataPlayer::CreateStreamFromFilename()
   switch(m_PlayerMode)
   {
   case NormalFile:
-    m_Stream = new std::ifstream(m_FileName.c_str());
+    m_Stream = new std::ifstream(m_FileName.c_str(), std::ios::in | std::ios::binary);
+    if (!mitk::NavigationDataBinaryReader::IsBinaryRecording(m_Stream))
+    {
+      //XML files are read in text mode
+      delete m_Stream;
+      m_Stream = new std::ifstream(m_FileName.c_str());
+    }
     m_StreamSetOutsideFromClass = false;
     break;
 
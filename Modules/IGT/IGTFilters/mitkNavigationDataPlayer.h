@@ -21,6 +21,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <mitkNavigationDataPlayerBase.h>
 #include <mitkNavigationDataSource.h>
 #include <mitkNavigationDataRecorder.h> //for the Recording Mode enum
+#include <mitkNavigationDataBinaryFile.h>
 #include "mitkTrackingDevice.h"
 
 #include <itkMultiThreader.h>
@@ -38,6 +39,9 @@ namespace mitk {
   * SetPlayerMode(PlayerMode). The presets need a FileName. Therefore the FileName must be set before the preset.
   * For pausing the player call Pause(). A call of Resume() will continue the playing.
   *
+  * Besides XML files the player reads the binary output format of NavigationDataRecorder, which is detected
+  * automatically. Binary recordings are indexed, SeekToTime() jumps to any position of them.
+  *
   *
   * \ingroup IGT
   */
@@ -96,6 +100,13 @@ namespace mitk {
     void Resume();
 
 
+    /**
+     * \brief Continues playing (or pausing) at the given time since the beginning of the recording.
+     * Only binary recordings (see NavigationDataRecorder::binary) can be seeked.
+     * @throw mitk::IGTException Throws an exception if the player is not started or the recording is no binary recording.
+     */
+    void SeekToTime(mitk::NavigationData::TimeStampType time);
+
     /**
      * \brief This method checks if player arrived at end of file.
      *
@@ -181,6 +192,17 @@ namespace mitk {
      */
     void InitPlayer();
 
+    /**
+     * \brief Initializes the player with the first frame of the binary recording in m_Stream.
+     * @throw mitk::IGTIOException Throws an exception if the recording is damaged or empty.
+     */
+    void InitBinaryPlayer();
+
+    /**
+     * \brief Sets the outputs to the frame of a binary recording at the current playing time.
+     */
+    void GenerateBinaryData(TimeStampType timeSinceStart);
+
     std::istream* m_Stream; ///< stores a pointer to the input stream
 
     bool m_StreamSetOutsideFromClass; ///< stores if the stream was created in this class and must be deleted in the end
@@ -211,6 +233,10 @@ namespace mitk {
 
     bool m_StreamEnd; ///< stores if the input stream arrived at end
 
+    mitk::NavigationDataBinaryReader::Pointer m_BinaryReader; ///< reads binary recordings, NULL while playing XML
+
+    std::vector<NavigationData::Pointer> m_BinaryFrame; ///< the frame of a binary recording which is played at the moment
+
     /**
      * @brief This is a helping method which gives an error message and throws an exception with the given message.
      *        It can be used if a stream is found to be invalid.
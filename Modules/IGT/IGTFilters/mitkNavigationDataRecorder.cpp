@@ -111,12 +111,20 @@ void mitk::NavigationDataRecorder::Update()
       *m_Stream << timestamp;
       }
 
+    m_BinaryFrame.clear();
+
     //write tool data for every tool
     for (unsigned int index = 0; index < inputs.size(); index++)
     {
       mitk::NavigationData* nd = dynamic_cast<mitk::NavigationData*>(inputs[index].GetPointer());
       nd->Update(); // call update to propagate update to previous filters
 
+      if (this->m_OutputFormat == mitk::NavigationDataRecorder::binary)
+      {
+        m_BinaryFrame.push_back(nd);
+        continue;
+      }
+
       mitk::NavigationData::PositionType position;
       mitk::NavigationData::OrientationType orientation(0.0, 0.0, 0.0, 0.0);
       mitk::NavigationData::CovarianceMatrixType matrix;
@@ -208,6 +216,10 @@ void mitk::NavigationDataRecorder::Update()
     {
       *m_Stream << "\n";
     }
+    else if (this->m_OutputFormat == mitk::NavigationDataRecorder::binary && timestamp >= 0)
+    {
+      m_BinaryWriter->AddFrame(timestamp, sysTimestamp, m_BinaryFrame);
+    }
   }
   m_RecordCounter++;
   if ((m_RecordCountLimit<=m_RecordCounter)&&(m_RecordCountLimit != -1)) {StopRecording();}
@@ -253,6 +265,12 @@ void mitk::NavigationDataRecorder::StartRecording()
       std::string extension = ".xml";
       if (m_OutputFormat == mitk::NavigationDataRecorder::csv)
         extension = ".csv";
+      else if (m_OutputFormat == mitk::NavigationDataRecorder::binary)
+        extension = ".ndb";
+
+      std::ios_base::openmode openMode = std::ios::out;
+      if (m_OutputFormat == mitk::NavigationDataRecorder::binary)
+        openMode |= std::ios::binary;
 
       ss << tmpPath << "/" <<  m_FileName << "-" << m_NumberOfRecordedFiles << extension;
 
@@ -282,13 +300,21 @@ void mitk::NavigationDataRecorder::StartRecording()
           }
           else
           {
-            stream = new std::ofstream(ss.str().c_str());
+            stream = new std::ofstream(ss.str().c_str(), openMode);
           }
           break;
 
         case ZipFile:
-          stream = &std::cout;
-          MITK_WARN << "Sorry no ZipFile support yet";
+          if (m_OutputFormat == mitk::NavigationDataRecorder::binary && m_FileName != "")
+          {
+            // the binary format compresses its blocks itself
+            stream = new std::ofstream(ss.str().c_str(), openMode);
+          }
+          else
+          {
+            stream = &std::cout;
+            MITK_WARN << "Sorry no ZipFile support yet";
+          }
           break;
 
         default:
@@ -331,6 +357,12 @@ void mitk::NavigationDataRecorder::StartRecording(std::ostream* stream)
       // should be a generic version, meaning a member variable, which has the actual version
       *m_Stream << "    " << "<Data ToolCount=\"" << (m_NumberOfInputs) << "\" version=\"1.0\">" << std::endl;
       }
+    else if (m_OutputFormat == mitk::NavigationDataRecorder::binary)
+      {
+      m_BinaryWriter = mitk::NavigationDataBinaryWriter::New();
+      m_BinaryWriter->SetCompression(m_RecordingMode == ZipFile);
+      m_BinaryWriter->Open(m_Stream, m_NumberOfInputs);
+      }
     m_Recording = true;
   }
   else
@@ -354,6 +386,19 @@ void mitk::NavigationDataRecorder::StopRecording()
     *m_Stream << "</Data>" << std::endl;
   }
 
+  if (m_BinaryWriter.IsNotNull())
+  {
+    try
+    {
+      m_BinaryWriter->Close(); // waits until all frames are written
+    }
+    catch(mitk::IGTException& e)
+    {
+      MITK_ERROR << "Binary recording is incomplete: " << e.GetDescription();
+    }
+    m_BinaryWriter = NULL;
+  }
+
   m_NumberOfRecordedFiles++;
   m_Recording = false;
   m_Stream->flush();
@@ -20,6 +20,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 #include <itkProcessObject.h>
 #include "mitkNavigationData.h"
+#include "mitkNavigationDataBinaryFile.h"
 
 #include <iostream>
 
@@ -31,7 +32,7 @@ namespace mitk
  /**Documentation
  * \brief This class records NavigationData objects.
  *
- * The output of this class is formated as a XML document.
+ * The output of this class is formated as a XML document, as CSV or in a compact binary format (see OutputFormatEnum).
  *
  * Internal this class uses streams for recording NavigationData objects. Therefore different types of output are possible
  * and can be set with the SetOutputMode() method. The default output is directed to the console. If you want to save into a
@@ -55,7 +56,7 @@ public:
     *
     * Console:    std::cout
     * NormalFile: std::ofstream
-    * ZipFile:    Not supported yet -> std::cout
+    * ZipFile:    std::ofstream with compressed blocks for the binary output format, not supported for xml and csv -> std::cout
     */
     enum RecordingMode
     {
@@ -69,11 +70,15 @@ public:
     *
     * xml:  XML format, also default, can be read by NavigationDataPlayer
     * csv:  use to export in excel, matlab, etc.
+    * binary: compact indexed format for high update rates (see NavigationDataBinaryFormat), can be read by
+    *         NavigationDataPlayer. The frames are written by a background thread, so Update() does not wait for
+    *         the stream. Additional attributes are not stored.
     */
     enum OutputFormatEnum
     {
       xml,
-      csv
+      csv,
+      binary
     };
 
     /**
@@ -212,6 +217,10 @@ protected:
 
     std::map<const mitk::NavigationData*, std::pair<std::string, std::string> > m_AdditionalAttributes;
 
+    mitk::NavigationDataBinaryWriter::Pointer m_BinaryWriter; ///< writes the frames in the binary output format
+
+    std::vector<const mitk::NavigationData*> m_BinaryFrame; ///< NavigationDatas of the current frame for m_BinaryWriter
+
 };
 
 }
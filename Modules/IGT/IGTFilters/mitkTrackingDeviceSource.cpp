@@ -23,7 +23,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 
 mitk::TrackingDeviceSource::TrackingDeviceSource()
-: mitk::NavigationDataSource(), m_TrackingDevice(NULL)
+: mitk::NavigationDataSource(), m_TrackingDevice(NULL), m_InterpolationDelay(0.0)
 {
 }
 
@@ -65,6 +65,10 @@ void mitk::TrackingDeviceSource::GenerateData()
       << m_TrackingDevice->GetToolCount() << " tools available in the tracking device.";
     throw std::out_of_range(ss.str());
   }
+  /* the sample buffers keep the last samples after tracking was stopped, they are only read while tracking */
+  bool tracking = (m_TrackingDevice->GetState() == mitk::TrackingDevice::Tracking);
+  double now = mitk::IGTTimeStamp::GetInstance()->GetElapsed();
+
   /* update outputs with tracking data from tools */
   unsigned int toolCount = m_TrackingDevice->GetToolCount();
   for (unsigned int i = 0; i < toolCount; ++i)
@@ -74,6 +78,32 @@ void mitk::TrackingDeviceSource::GenerateData()
     mitk::TrackingTool* t = m_TrackingDevice->GetTool(i);
     assert(t);
 
+    const mitk::TrackingToolSampleBuffer* buffer = tracking ? t->GetSampleBuffer() : NULL;
+    mitk::TrackingToolSample sample;
+    bool haveSample = false;
+    if (buffer != NULL)
+    {
+      haveSample = (m_InterpolationDelay > 0.0)
+        ? buffer->GetSampleAt(now - m_InterpolationDelay, sample)
+        : buffer->GetLatestSample(sample);
+    }
+    if (haveSample) // lock-free path: the sample is a consistent copy of the state of the tool
+    {
+      if ((t->IsEnabled() == false) || (sample.m_DataValid == false))
+      {
+        nd->SetDataValid(false);
+        continue;
+      }
+      nd->SetDataValid(true);
+      nd->SetPosition(sample.m_Position);
+      nd->SetOrientation(sample.m_Orientation);
+      nd->SetOrientationAccuracy(sample.m_TrackingError);
+      nd->SetPositionAccuracy(sample.m_TrackingError);
+      nd->SetIGTTimeStamp(sample.m_TimeStamp);
+      continue;
+    }
+
+    /* tools without samples are read directly */
     if ((t->IsEnabled() == false) || (t->IsDataValid() == false))
     {
       nd->SetDataValid(false);
@@ -94,6 +124,19 @@ void mitk::TrackingDeviceSource::GenerateData()
 }
 
 
+bool mitk::TrackingDeviceSource::GetToolSampleAt(unsigned int toolIndex, double timeStamp, mitk::TrackingToolSample& sample) const
+{
+  if (m_TrackingDevice.IsNull() || toolIndex >= m_TrackingDevice->GetToolCount())
+    return false;
+
+  mitk::TrackingTool* tool = m_TrackingDevice->GetTool(toolIndex);
+  const mitk::TrackingToolSampleBuffer* buffer = (tool != NULL) ? tool->GetSampleBuffer() : NULL;
+  if (buffer == NULL)
+    return false;
+  return buffer->GetSampleAt(timeStamp, sample);
+}
+
+
 void mitk::TrackingDeviceSource::SetTrackingDevice( mitk::TrackingDevice* td )
 {
   MITK_DEBUG << "Setting TrackingDevice to " << td;
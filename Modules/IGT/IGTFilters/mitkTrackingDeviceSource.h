@@ -20,6 +20,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 #include <mitkNavigationDataSource.h>
 #include "mitkTrackingDevice.h"
+#include "mitkTrackingToolSampleBuffer.h"
 
 namespace mitk {
   /**Documentation
@@ -108,6 +109,25 @@ namespace mitk {
     */
     virtual void UpdateOutputInformation();
 
+    /**
+    * \brief Sets the delay (in ms) of the generated NavigationData for latency compensation.
+    *
+    * While tracking, GenerateData() reads the samples which the tracking thread stores in the sample buffer of each
+    * tool (see TrackingTool::GetSampleBuffer()) without locking the tool. With a delay of 0 (default) the latest
+    * sample is used. With a delay greater than 0 the state of the tools at IGTTimeStamp - delay is interpolated,
+    * e.g. to match the tracking data with video frames which arrive later than the tracking data.
+    */
+    itkSetMacro(InterpolationDelay, double);
+    itkGetConstMacro(InterpolationDelay, double);
+
+    /**
+    * \brief Returns the state of tool toolIndex at timeStamp (IGTTimeStamp in ms) interpolated from its sample buffer.
+    *
+    * Can be used to get the pose of the tools at the acquisition time of data of other devices.
+    * @return false if the tool does not exist, has no sample buffer or no samples were recorded yet
+    */
+    bool GetToolSampleAt(unsigned int toolIndex, double timeStamp, mitk::TrackingToolSample& sample) const;
+
   protected:
     TrackingDeviceSource();
     virtual ~TrackingDeviceSource();
@@ -128,6 +148,7 @@ namespace mitk {
     void CreateOutputs();
 
     mitk::TrackingDevice::Pointer m_TrackingDevice;  ///< the tracking device that is used as a source for this filter object
+    double m_InterpolationDelay;                     ///< delay of the generated NavigationData in ms, see SetInterpolationDelay()
   };
 } // namespace mitk
 #endif /* MITKTrackingDeviceSource_H_HEADER_INCLUDED_ */
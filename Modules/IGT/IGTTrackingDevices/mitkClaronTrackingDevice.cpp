@@ -285,6 +285,7 @@ void mitk::ClaronTrackingDevice::TrackTools()
           currentTool->SetOrientation(mitk::Quaternion(0,0,0,0));
           currentTool->SetDataValid(false);
         }
+        currentTool->UpdateSampleBuffer();
       }
       /* Update the local copy of m_StopTracking */
       this->m_StopTrackingMutex->Lock();
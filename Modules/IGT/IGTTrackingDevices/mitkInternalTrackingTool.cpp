@@ -15,6 +15,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 ===================================================================*/
 
 #include "mitkInternalTrackingTool.h"
+#include "mitkIGTTimeStamp.h"
 
 #include <itkMutexLockHolder.h>
 
@@ -232,3 +233,27 @@ void mitk::InternalTrackingTool::SetErrorMessage(const char* _arg)
     this->m_ErrorMessage = "";
   this->Modified();
 }
+
+
+const mitk::TrackingToolSampleBuffer* mitk::InternalTrackingTool::GetSampleBuffer() const
+{
+  return &m_SampleBuffer;
+}
+
+
+void mitk::InternalTrackingTool::UpdateSampleBuffer()
+{
+  TrackingToolSample sample;
+  sample.m_TimeStamp = mitk::IGTTimeStamp::GetInstance()->GetElapsed();
+  this->GetPosition(sample.m_Position); // position and orientation of the tool tip
+  this->GetOrientation(sample.m_Orientation);
+  sample.m_TrackingError = this->GetTrackingError();
+  sample.m_DataValid = this->IsDataValid();
+
+  TrackingToolSample latest;
+  if (m_SampleBuffer.GetLatestSample(latest) && latest.m_TimeStamp > sample.m_TimeStamp)
+  {
+    m_SampleBuffer.Clear(); // the IGTTimeStamp was restarted, the old samples would disturb the interpolation
+  }
+  m_SampleBuffer.Push(sample);
+}
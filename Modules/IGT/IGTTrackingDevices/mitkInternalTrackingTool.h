@@ -19,6 +19,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 #define MITKINTERNALTRACKINGTOOL_H_HEADER_INCLUDED_
 
 #include <mitkTrackingTool.h>
+#include <mitkTrackingToolSampleBuffer.h>
 #include <MitkIGTExports.h>
 #include <mitkVector.h>
 #include <itkFastMutexLock.h>
@@ -57,6 +58,14 @@ namespace mitk {
     virtual void SetDataValid(bool _arg);                       ///< sets if the tracking data (position & Orientation) is valid
     virtual void SetErrorMessage(const char* _arg);             ///< sets the error message
     virtual void SetToolTip(mitk::Point3D toolTipPosition, mitk::Quaternion orientation = mitk::Quaternion(0,0,0,1)); ///< defines a tool tip for this tool in tool coordinates. GetPosition() and GetOrientation() return the data of the tool tip if it is defined. By default no tooltip is defined.
+    virtual const TrackingToolSampleBuffer* GetSampleBuffer() const; ///< returns the samples added by UpdateSampleBuffer()
+
+    /**
+    * \brief Adds the current state (position and orientation of the tool tip, tracking error, data valid) to the sample buffer,
+    * time stamped with the current IGTTimeStamp. Tracking devices call this once per measurement after all values of the tool
+    * were set. Must only be called by the tracking thread of the device.
+    */
+    virtual void UpdateSampleBuffer();
 
   protected:
     itkNewMacro(Self);
@@ -71,6 +80,7 @@ namespace mitk {
     Point3D m_ToolTip;
     Quaternion m_ToolTipRotation;
     bool m_ToolTipSet;
+    TrackingToolSampleBuffer m_SampleBuffer; ///< latest samples of the tool, read without locking m_MyMutex
   };
 } // namespace mitk
 #endif /* MITKINTERNALTRACKINGTOOL_H_HEADER_INCLUDED_ */
@@ -385,6 +385,7 @@ void mitk::MicroBirdTrackingDevice::TrackTools()
           mitk::Quaternion orientation(record.q[1], record.q[2], record.q[3],record.q[0]);
           tool->SetOrientation(orientation); // Set orientation as quaternion \todo : verify quaternion order q(r,x,y,z)
           tool->SetDataValid(true); // Set data state to valid
+          tool->UpdateSampleBuffer();
         }
         toolNumber++; // Increment tool number
       }
@@ -834,6 +834,7 @@ mitk::NDIErrorCode mitk::NDIProtocol::TX(bool trackIndividualMarkers, MarkerPoin
         m_TrackingDevice->Receive(&s, 1);   // read the line feed character, that terminates each handle data
         reply += s;                         // build complete command string
       }
+      tool->UpdateSampleBuffer();           // publish the new state of the tool to the readers of its sample buffer
     } // for
 
 
@@ -1085,6 +1086,7 @@ mitk::NDIErrorCode mitk::NDIProtocol::TX1000(MarkerPointContainerType* markerPos
         m_TrackingDevice->Receive(&s, 1);   // read the line feed character, that terminates each handle data
         reply += s;                         // build complete command string
       }
+      tool->UpdateSampleBuffer();           // publish the new state of the tool to the readers of its sample buffer
     }
     //Read Reply Option 1000 data
 
@@ -46,3 +46,9 @@ const char* mitk::TrackingTool::GetErrorMessage() const
  MutexLockHolder lock(*m_MyMutex); // lock and unlock the mutex
  return this->m_ErrorMessage.c_str();
 }
+
+
+const mitk::TrackingToolSampleBuffer* mitk::TrackingTool::GetSampleBuffer() const
+{
+  return NULL;
+}
@@ -26,6 +26,8 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 namespace mitk
 {
+  class TrackingToolSampleBuffer;
+
   /**Documentation
   * \brief Interface for all Tracking Tools
   *
@@ -48,6 +50,7 @@ namespace mitk
     virtual float GetTrackingError() const = 0;      ///< returns one value that corresponds to the overall tracking error.
     virtual const char* GetToolName() const;         ///< every tool has a name that can be used to identify it.
     virtual const char* GetErrorMessage() const;     ///< if the data is not valid, ErrorMessage should contain a string explaining why it is invalid (the Set-method should be implemented in subclasses, it should not be accessible by the user)
+    virtual const TrackingToolSampleBuffer* GetSampleBuffer() const; ///< returns the latest samples of the tool which can be read without locking the tool, or NULL if the tool does not record samples (default)
   protected:
     TrackingTool();
     virtual ~TrackingTool();
@@ -0,0 +1,193 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkTrackingToolSampleBuffer.h"
+
+#include "mitkAtomicOperations.h"
+
+#include <cmath>
+
+namespace
+{
+
+// the sequence numbers and positions wrap around, they are only compared for equality
+inline long SequenceOf(unsigned long position)
+{
+  return static_cast<long>(2 * position + 2);
+}
+
+}
+
+mitk::TrackingToolSampleBuffer::TrackingToolSampleBuffer()
+{
+  this->Clear();
+}
+
+void mitk::TrackingToolSampleBuffer::Clear()
+{
+  for (unsigned int i = 0; i < Capacity; ++i)
+  {
+    m_Slots[i].m_Sequence = 0;
+  }
+  AtomicStore(&m_WritePosition, 0);
+}
+
+void mitk::TrackingToolSampleBuffer::Push(const TrackingToolSample& sample)
+{
+  unsigned long position = static_cast<unsigned long>(m_WritePosition); // only written by this thread
+  Slot& slot = m_Slots[position % Capacity];
+
+  AtomicStore(&slot.m_Sequence, SequenceOf(position) - 1);
+  slot.m_Sample = sample;
+  AtomicStore(&slot.m_Sequence, SequenceOf(position));
+
+  AtomicStore(&m_WritePosition, static_cast<long>(position + 1));
+}
+
+bool mitk::TrackingToolSampleBuffer::ReadSample(unsigned long position, TrackingToolSample& sample) const
+{
+  const Slot& slot = m_Slots[position % Capacity];
+
+  long sequence = AtomicLoad(&slot.m_Sequence);
+  if (sequence != SequenceOf(position))
+  {
+    return false;
+  }
+  sample = slot.m_Sample;
+  // the copy has to be complete before the sequence is checked again, AtomicLoad() only orders later accesses
+  MemoryFence();
+  return AtomicLoad(&slot.m_Sequence) == sequence;
+}
+
+bool mitk::TrackingToolSampleBuffer::GetLatestSample(TrackingToolSample& sample) const
+{
+  while (true)
+  {
+    unsigned long writePosition = static_cast<unsigned long>(AtomicLoad(&m_WritePosition));
+    if (writePosition == 0)
+    {
+      return false;
+    }
+    if (this->ReadSample(writePosition - 1, sample))
+    {
+      return true;
+    }
+  }
+}
+
+bool mitk::TrackingToolSampleBuffer::GetSampleAt(double timeStamp, TrackingToolSample& sample) const
+{
+  unsigned long writePosition = static_cast<unsigned long>(AtomicLoad(&m_WritePosition));
+  // the slot of writePosition is the next one to be overwritten
+  unsigned long available = writePosition < Capacity ? writePosition : Capacity - 1;
+
+  TrackingToolSample after;
+  bool haveAfter = false;
+  for (unsigned long i = 1; i <= available; ++i)
+  {
+    TrackingToolSample before;
+    if (!this->ReadSample(writePosition - i, before))
+    {
+      break; // overwritten while we were reading, older samples are gone as well
+    }
+
+    if (before.m_TimeStamp <= timeStamp)
+    {
+      if (haveAfter)
+      {
+        Interpolate(before, after, timeStamp, sample);
+      }
+      else
+      {
+        sample = before;
+      }
+      return true;
+    }
+
+    after = before;
+    haveAfter = true;
+  }
+
+  if (haveAfter)
+  {
+    sample = after; // timeStamp is older than all samples in the buffer
+    return true;
+  }
+  return this->GetLatestSample(sample);
+}
+
+void mitk::TrackingToolSampleBuffer::Interpolate(const TrackingToolSample& before, const TrackingToolSample& after,
+                                                 double timeStamp, TrackingToolSample& result)
+{
+  double duration = after.m_TimeStamp - before.m_TimeStamp;
+  double weight = duration > 0.0 ? (timeStamp - before.m_TimeStamp) / duration : 1.0;
+
+  double dot = 0.0;
+  double normBefore = 0.0;
+  double normAfter = 0.0;
+  for (unsigned int i = 0; i < 4; ++i)
+  {
+    dot += before.m_Orientation[i] * after.m_Orientation[i];
+    normBefore += before.m_Orientation[i] * before.m_Orientation[i];
+    normAfter += after.m_Orientation[i] * after.m_Orientation[i];
+  }
+
+  // there is nothing to interpolate between an invalid and a valid measurement
+  if (!before.m_DataValid || !after.m_DataValid || normBefore == 0.0 || normAfter == 0.0)
+  {
+    result = weight < 0.5 ? before : after;
+    return;
+  }
+
+  result.m_TimeStamp = timeStamp;
+  result.m_DataValid = true;
+  result.m_TrackingError = static_cast<float>((1.0 - weight) * before.m_TrackingError + weight * after.m_TrackingError);
+  for (unsigned int i = 0; i < 3; ++i)
+  {
+    result.m_Position[i] = (1.0 - weight) * before.m_Position[i] + weight * after.m_Position[i];
+  }
+
+  // slerp along the shorter arc, linear interpolation if both orientations are almost equal
+  dot /= std::sqrt(normBefore * normAfter);
+  double sign = 1.0;
+  if (dot < 0.0)
+  {
+    dot = -dot;
+    sign = -1.0;
+  }
+  double weightBefore = 1.0 - weight;
+  double weightAfter = weight;
+  if (dot < 0.9995)
+  {
+    double angle = std::acos(dot);
+    weightBefore = std::sin((1.0 - weight) * angle) / std::sin(angle);
+    weightAfter = std::sin(weight * angle) / std::sin(angle);
+  }
+
+  double norm = 0.0;
+  double orientation[4];
+  for (unsigned int i = 0; i < 4; ++i)
+  {
+    orientation[i] = weightBefore * before.m_Orientation[i] / std::sqrt(normBefore)
+                   + sign * weightAfter * after.m_Orientation[i] / std::sqrt(normAfter);
+    norm += orientation[i] * orientation[i];
+  }
+  norm = std::sqrt(norm);
+  for (unsigned int i = 0; i < 4; ++i)
+  {
+    result.m_Orientation[i] = orientation[i] / norm;
+  }
+}
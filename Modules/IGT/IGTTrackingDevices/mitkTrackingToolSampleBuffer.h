@@ -0,0 +1,100 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#ifndef MITKTRACKINGTOOLSAMPLEBUFFER_H_HEADER_INCLUDED_
+#define MITKTRACKINGTOOLSAMPLEBUFFER_H_HEADER_INCLUDED_
+
+#include <MitkIGTExports.h>
+#include <mitkVector.h>
+
+namespace mitk
+{
+  /**Documentation
+  * \brief State of a tracking tool at one point in time, see TrackingToolSampleBuffer
+  *
+  * \ingroup IGT
+  */
+  struct TrackingToolSample
+  {
+    double m_TimeStamp;         ///< IGTTimeStamp (elapsed milliseconds) of the measurement
+    Point3D m_Position;         ///< position of the tool (tool tip, if defined)
+    Quaternion m_Orientation;   ///< orientation of the tool (tool tip, if defined)
+    float m_TrackingError;      ///< tracking error as given by the device
+    bool m_DataValid;           ///< false if the tool was not seen by the device
+  };
+
+  /**Documentation
+  * \brief Ring buffer of the latest samples of one tracking tool
+  *
+  * The tracking thread of a device adds samples with Push(), any number of other threads read them with
+  * GetLatestSample() or GetSampleAt() without taking a lock. Every slot carries a sequence number which is
+  * odd while the slot is written; a reader copies a slot and checks that the sequence number did not change.
+  * A read is only repeated if the producer wrote the whole ring while the reader copied one slot.
+  *
+  * Push() must only be called by one thread at a time.
+  *
+  * \ingroup IGT
+  */
+  class MitkIGT_EXPORT TrackingToolSampleBuffer
+  {
+  public:
+
+    /** \brief Number of samples kept in the buffer */
+    static const unsigned int Capacity = 64;
+
+    TrackingToolSampleBuffer();
+
+    /** \brief Adds a new sample, the oldest one is overwritten. Time stamps must not decrease. */
+    void Push(const TrackingToolSample& sample);
+
+    /** \brief Copies the latest sample to sample, returns false if no sample was pushed yet. */
+    bool GetLatestSample(TrackingToolSample& sample) const;
+
+    /**
+    * \brief Computes the state of the tool at timeStamp from the samples before and after timeStamp.
+    *
+    * Positions are interpolated linearly, orientations by slerp. If one of both samples is invalid, the nearer
+    * one is used. Time stamps after the latest sample give the latest sample, time stamps before the oldest
+    * sample in the buffer give the oldest sample. Returns false if no sample was pushed yet.
+    */
+    bool GetSampleAt(double timeStamp, TrackingToolSample& sample) const;
+
+    /** \brief Removes all samples. Must not be called concurrently with Push(), readers may continue. */
+    void Clear();
+
+  private:
+
+    TrackingToolSampleBuffer(const TrackingToolSampleBuffer&);
+    TrackingToolSampleBuffer& operator=(const TrackingToolSampleBuffer&);
+
+    /** \brief Copies the sample with number position, returns false if it was overwritten meanwhile */
+    bool ReadSample(unsigned long position, TrackingToolSample& sample) const;
+
+    static void Interpolate(const TrackingToolSample& before, const TrackingToolSample& after, double timeStamp,
+                            TrackingToolSample& result);
+
+    struct Slot
+    {
+      volatile long m_Sequence; ///< 2 * position + 2 when the sample with this position is complete, odd while written
+      TrackingToolSample m_Sample;
+    };
+
+    Slot m_Slots[Capacity];
+    volatile long m_WritePosition; ///< number of samples pushed so far
+  };
+} // namespace mitk
+
+#endif /* MITKTRACKINGTOOLSAMPLEBUFFER_H_HEADER_INCLUDED_ */
@@ -23,6 +23,7 @@ set(MODULE_TESTS
    mitkTrackingVolumeGeneratorTest.cpp
    mitkTrackingDeviceTest.cpp
    mitkTrackingToolTest.cpp
+   mitkTrackingToolSampleBufferTest.cpp
    mitkVirtualTrackingDeviceTest.cpp
    mitkNavigationDataPlayerTest.cpp # see bug 11636 (extend this test by microservices)
    mitkTrackingDeviceSourceTest.cpp
@@ -238,6 +238,69 @@ class mitkNavigationDataPlayerTestClass
     MITK_TEST_CONDITION_REQUIRED(player->IsAtEnd(), "Testing method IsAtEnd() #2");
     }
 
+    static void TestBinaryPlayingAndSeeking()
+    {
+    // a binary recording with one frame every 100 ms
+    std::stringstream stream( std::ios::in | std::ios::out | std::ios::binary );
+    mitk::NavigationDataBinaryWriter::Pointer writer = mitk::NavigationDataBinaryWriter::New();
+    writer->SetFramesPerBlock(16);
+    writer->Open(&stream, 1);
+
+    mitk::NavigationData::Pointer nd = mitk::NavigationData::New();
+    std::vector<const mitk::NavigationData*> frame(1, nd.GetPointer());
+    for ( unsigned int i=0; i<50; i++ )
+    {
+      mitk::Point3D pnt;
+      pnt[0] = i;
+      pnt[1] = 0;
+      pnt[2] = 0;
+      nd->SetPosition(pnt);
+      writer->AddFrame(1000.0 + i * 100.0, 0.0, frame);
+    }
+    writer->Close();
+
+    mitk::NavigationDataPlayer::Pointer player = mitk::NavigationDataPlayer::New();
+    player->SetStream(&stream);
+    player->StartPlaying();
+    player->Update();
+    MITK_TEST_CONDITION_REQUIRED(player->GetOutput()->GetPosition()[0] == 0, "Testing first frame of binary recording");
+
+    // the extra 50 ms cover the time between SeekToTime() and Update()
+    player->SeekToTime(2050.0);
+    player->Update();
+    MITK_TEST_CONDITION(player->GetOutput()->GetPosition()[0] == 20, "Testing seeking forward in binary recording");
+
+    player->SeekToTime(750.0);
+    player->Update();
+    MITK_TEST_CONDITION(player->GetOutput()->GetPosition()[0] == 7, "Testing seeking backward in binary recording");
+
+    player->Pause();
+    player->SeekToTime(3050.0);
+    player->Resume();
+    player->Update();
+    MITK_TEST_CONDITION(player->GetOutput()->GetPosition()[0] == 30, "Testing seeking while paused in binary recording");
+
+    player->SeekToTime(6000.0);
+    player->Update();
+    MITK_TEST_CONDITION(player->IsAtEnd(), "Testing end of binary recording");
+
+    // XML recordings cannot be seeked
+    mitk::NavigationDataPlayer::Pointer xmlPlayer = mitk::NavigationDataPlayer::New();
+    xmlPlayer->SetFileName( mitk::StandardFileLocations::GetInstance()->FindFile("NavigationDataTestData.xml", "Modules/IGT/Testing/Data") );
+    xmlPlayer->StartPlaying();
+    bool exceptionThrown = false;
+    try
+    {
+      xmlPlayer->SeekToTime(100.0);
+    }
+    catch(mitk::IGTException)
+    {
+      exceptionThrown = true;
+    }
+    xmlPlayer->StopPlaying();
+    MITK_TEST_CONDITION(exceptionThrown, "Testing exception when seeking in XML recording");
+    }
+
     static void TestInvalidStream()
     {
     MITK_TEST_OUTPUT(<<"#### Testing invalid input data: errors are expected. ####");
@@ -541,6 +604,7 @@ int mitkNavigationDataPlayerTest(int /* argc */, char* /*argv*/[])
   mitkNavigationDataPlayerTestClass::TestStartPlayingExceptions();
   mitkNavigationDataPlayerTestClass::TestPauseAndResume();
   mitkNavigationDataPlayerTestClass::TestInvalidStream();
+  mitkNavigationDataPlayerTestClass::TestBinaryPlayingAndSeeking();
 
   // always end with this!
   MITK_TEST_END();
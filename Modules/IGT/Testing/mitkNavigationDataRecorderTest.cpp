@@ -27,6 +27,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <iostream>
 #include <sstream>
 #include <fstream>
+#include <cstring>
 
 //for exceptions
 #include "mitkIGTException.h"
@@ -202,6 +203,135 @@ class mitkNavigationDataRecorderTestClass
     MITK_TEST_CONDITION(myFile.exists(),"Testing CSV recording on harddisc (does file exist?).");
     }
 
+  static void TestRecordingBinary()
+    {
+    std::stringstream stream( std::ios::in | std::ios::out | std::ios::binary );
+
+    mitk::NavigationDataRecorder::Pointer recorder = mitk::NavigationDataRecorder::New();
+    recorder->SetOutputFormat(mitk::NavigationDataRecorder::binary);
+    recorder->SetRecordingMode(mitk::NavigationDataRecorder::ZipFile); // compressed blocks
+
+    mitk::NavigationData::Pointer naviData1 = mitk::NavigationData::New();
+    mitk::NavigationData::Pointer naviData2 = mitk::NavigationData::New();
+    naviData2->SetDataValid(true);
+    recorder->AddNavigationData( naviData1 );
+    recorder->AddNavigationData( naviData2 );
+    recorder->StartRecording( &stream );
+
+    // more frames than fit into one block of the binary format
+    const unsigned int numberOfFrames = 1000;
+    for ( unsigned int i=0; i<numberOfFrames; i++ )
+    {
+      mitk::Point3D pnt;
+      pnt[0] = i;
+      pnt[1] = 2;
+      pnt[2] = 3;
+      naviData1->SetPosition(pnt);
+      pnt[1] = -1.0 * i;
+      naviData2->SetPosition(pnt);
+      recorder->Update();
+    }
+    recorder->StopRecording();
+
+    mitk::NavigationDataBinaryReader::Pointer reader = mitk::NavigationDataBinaryReader::New();
+    MITK_TEST_CONDITION_REQUIRED(mitk::NavigationDataBinaryReader::IsBinaryRecording(&stream), "Testing if binary recording is detected.");
+    reader->Open(&stream);
+    MITK_TEST_CONDITION(reader->GetNumberOfTools() == 2, "Testing number of tools of binary recording.");
+    MITK_TEST_CONDITION_REQUIRED(reader->GetNumberOfFrames() == numberOfFrames, "Testing number of frames of binary recording.");
+
+    std::vector<mitk::NavigationData::Pointer> frame;
+    bool framesCorrect = true;
+    mitk::NavigationData::TimeStampType lastTimeStamp = reader->GetFirstTimeStamp();
+    for ( unsigned int i=0; i<numberOfFrames; i+=7 )
+    {
+      mitk::NavigationData::TimeStampType timeStamp = reader->ReadFrame(i, frame);
+      if (frame[0]->GetPosition()[0] != i || frame[0]->GetPosition()[1] != 2 || frame[1]->GetPosition()[1] != -1.0 * i
+          || frame[0]->IsDataValid() || !frame[1]->IsDataValid() || timeStamp < lastTimeStamp)
+      {
+        framesCorrect = false;
+      }
+      lastTimeStamp = timeStamp;
+    }
+    MITK_TEST_CONDITION(framesCorrect, "Testing frames of binary recording.");
+
+    unsigned int lastFrame = reader->FindFrame(reader->GetLastTimeStamp());
+    MITK_TEST_CONDITION(lastFrame == numberOfFrames - 1, "Testing search of last time stamp in binary recording.");
+    }
+
+  static void TestBinaryRoundTrip()
+    {
+    // values which are not rounded on the way through the file
+    std::stringstream stream( std::ios::in | std::ios::out | std::ios::binary );
+    mitk::NavigationDataBinaryWriter::Pointer writer = mitk::NavigationDataBinaryWriter::New();
+    writer->SetCompression(true);
+    writer->Open(&stream, 1);
+
+    mitk::NavigationData::Pointer nd = mitk::NavigationData::New();
+    std::vector<const mitk::NavigationData*> frame(1, nd.GetPointer());
+    std::vector<mitk::NavigationData::Pointer> expected;
+    std::vector<mitk::NavigationData::TimeStampType> expectedTimeStamps;
+    for ( unsigned int i=0; i<100; i++ )
+    {
+      mitk::Point3D pnt;
+      pnt[0] = 1234.5678 + 0.001 * i;
+      pnt[1] = -0.1 * i;
+      pnt[2] = 1.0 / (i + 3);
+      nd->SetPosition(pnt);
+      mitk::NavigationData::OrientationType orientation(0.1 * i, 0.7, -0.3, 1.0 / (i + 1));
+      orientation.normalize();
+      nd->SetOrientation(orientation);
+      nd->SetPositionAccuracy(0.01 * i + 0.003);
+      nd->SetOrientationAccuracy(0.7 / (i + 1));
+      nd->SetDataValid(i % 3 != 0);
+      nd->SetHasOrientation(i % 2 == 0);
+
+      mitk::NavigationData::TimeStampType timeStamp = 1.0e9 + 0.123456789 * i;
+      writer->AddFrame(timeStamp, 0.0, frame);
+
+      mitk::NavigationData::Pointer copy = mitk::NavigationData::New();
+      copy->Graft(nd);
+      expected.push_back(copy);
+      expectedTimeStamps.push_back(timeStamp);
+    }
+    writer->Close();
+
+    mitk::NavigationDataBinaryReader::Pointer reader = mitk::NavigationDataBinaryReader::New();
+    reader->Open(&stream);
+    MITK_TEST_CONDITION_REQUIRED(reader->GetNumberOfFrames() == expected.size(), "Testing number of frames of binary round trip.");
+
+    std::vector<mitk::NavigationData::Pointer> read;
+    bool framesEqual = true;
+    for ( unsigned int i=0; i<expected.size(); i++ )
+    {
+      mitk::NavigationData::TimeStampType timeStamp = reader->ReadFrame(i, read);
+      const mitk::NavigationData* a = expected[i];
+      const mitk::NavigationData* b = read[0];
+      framesEqual &= timeStamp == expectedTimeStamps[i]
+          && a->GetPosition() == b->GetPosition()
+          && a->GetOrientation() == b->GetOrientation()
+          && a->IsDataValid() == b->IsDataValid()
+          && a->GetHasOrientation() == b->GetHasOrientation()
+          && a->GetHasPosition() == b->GetHasPosition();
+      for (unsigned int row = 0; row < 2; row++)
+      {
+        for (unsigned int column = 0; column < 6; column++)
+        {
+          framesEqual &= a->GetCovErrorMatrix()[row][column] == b->GetCovErrorMatrix()[row][column];
+        }
+      }
+    }
+    MITK_TEST_CONDITION(framesEqual, "Testing that binary recording returns the exact values of the recorded frames.");
+
+    // a damaged size of the first block must not be used to allocate its buffer
+    std::string damagedRecording = stream.str();
+    itk::uint32_t damagedSize = 0x7fffffff;
+    memcpy(&damagedRecording[mitk::NavigationDataBinaryFormat::HeaderSize], &damagedSize, sizeof(damagedSize));
+    std::stringstream damagedStream( damagedRecording, std::ios::in | std::ios::binary );
+    mitk::NavigationDataBinaryReader::Pointer damagedReader = mitk::NavigationDataBinaryReader::New();
+    damagedReader->Open(&damagedStream);
+    MITK_TEST_FOR_EXCEPTION(mitk::IGTIOException, damagedReader->ReadFrame(0, read));
+    }
+
   static void TestLoadingRecordedXMLFile()
     {
     mitk::NavigationDataPlayer::Pointer myPlayer = mitk::NavigationDataPlayer::New();
@@ -383,6 +513,8 @@ int mitkNavigationDataRecorderTest(int /* argc */, char* /*argv*/[])
   mitkNavigationDataRecorderTestClass::TestRecordingOnHarddiscXMLZIP();
   mitkNavigationDataRecorderTestClass::TestRecordingOnHarddiscCSV();
   mitkNavigationDataRecorderTestClass::TestRecordingInvalidData();
+  mitkNavigationDataRecorderTestClass::TestRecordingBinary();
+  mitkNavigationDataRecorderTestClass::TestBinaryRoundTrip();
   mitkNavigationDataRecorderTestClass::TestStartRecordingExceptions();
 
 
@@ -16,6 +16,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 #include "mitkTrackingDeviceSource.h"
 #include "mitkVirtualTrackingDevice.h"
+#include "mitkIGTTimeStamp.h"
 
 #include "mitkTestingMacros.h"
 #include <mitkReferenceCountWatcher.h>
@@ -109,6 +110,20 @@ int mitkTrackingDeviceSourceTest(int /* argc */, char* /*argv*/[])
     MITK_TEST_CONDITION(mitk::Equal(newPos, pos) == false, "Testing if output changes on each update");
   }
 
+  //test the samples recorded by the tracking thread
+  mitk::TrackingToolSample sample;
+  double now = mitk::IGTTimeStamp::GetInstance()->GetElapsed();
+  MITK_TEST_CONDITION(mySource->GetToolSampleAt(0, now, sample) && sample.m_DataValid, "Testing GetToolSampleAt() while tracking");
+  MITK_TEST_CONDITION(sample.m_TimeStamp <= now, "Testing time stamp of GetToolSampleAt()");
+  MITK_TEST_CONDITION(mySource->GetToolSampleAt(2, now, sample) == false, "Testing GetToolSampleAt() with invalid tool index");
+
+  mySource->SetInterpolationDelay(50.0);
+  MITK_TEST_CONDITION(mySource->GetInterpolationDelay() == 50.0, "Testing Set/GetInterpolationDelay()");
+  nd0->Update();
+  MITK_TEST_CONDITION(nd0->IsDataValid(), "Testing if output is valid with interpolation delay");
+  MITK_TEST_CONDITION(nd0->GetIGTTimeStamp() <= mitk::IGTTimeStamp::GetInstance()->GetElapsed() - 50.0, "Testing if output is delayed");
+  mySource->SetInterpolationDelay(0.0);
+
   mySource->StopTracking();
   mySource->Disconnect();
 
@@ -0,0 +1,153 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkTrackingToolSampleBuffer.h"
+
+#include "mitkTestingMacros.h"
+
+#include <itkMultiThreader.h>
+
+#include <cmath>
+
+class mitkTrackingToolSampleBufferTestClass
+{
+public:
+
+  /** \brief Sample at time t: all coordinates of the position are t, the orientation is a rotation of t degrees around z */
+  static mitk::TrackingToolSample CreateSample(double t)
+  {
+    mitk::TrackingToolSample sample;
+    sample.m_TimeStamp = t;
+    sample.m_Position.Fill(t);
+    double halfAngle = t * vnl_math::pi / 360.0;
+    sample.m_Orientation = mitk::Quaternion(0.0, 0.0, std::sin(halfAngle), std::cos(halfAngle));
+    sample.m_TrackingError = 0.5f;
+    sample.m_DataValid = true;
+    return sample;
+  }
+
+  static void TestEmptyBuffer()
+  {
+    mitk::TrackingToolSampleBuffer buffer;
+    mitk::TrackingToolSample sample;
+    MITK_TEST_CONDITION(buffer.GetLatestSample(sample) == false, "Testing GetLatestSample() of empty buffer");
+    MITK_TEST_CONDITION(buffer.GetSampleAt(0.0, sample) == false, "Testing GetSampleAt() of empty buffer");
+  }
+
+  static void TestLatestSample()
+  {
+    mitk::TrackingToolSampleBuffer buffer;
+    for (unsigned int i = 0; i < 3 * mitk::TrackingToolSampleBuffer::Capacity; ++i)
+    {
+      buffer.Push(CreateSample(i));
+    }
+    mitk::TrackingToolSample sample;
+    MITK_TEST_CONDITION(buffer.GetLatestSample(sample), "Testing GetLatestSample() of full buffer");
+    MITK_TEST_CONDITION(sample.m_TimeStamp == 3 * mitk::TrackingToolSampleBuffer::Capacity - 1, "Testing if GetLatestSample() returns the last pushed sample");
+
+    buffer.Clear();
+    MITK_TEST_CONDITION(buffer.GetLatestSample(sample) == false, "Testing Clear()");
+  }
+
+  static void TestInterpolation()
+  {
+    mitk::TrackingToolSampleBuffer buffer;
+    buffer.Push(CreateSample(0.0));
+    buffer.Push(CreateSample(90.0));
+
+    mitk::TrackingToolSample sample;
+    MITK_TEST_CONDITION(buffer.GetSampleAt(45.0, sample), "Testing GetSampleAt() between two samples");
+    MITK_TEST_CONDITION(sample.m_TimeStamp == 45.0, "Testing time stamp of interpolated sample");
+    MITK_TEST_CONDITION(mitk::Equal(sample.m_Position, CreateSample(45.0).m_Position), "Testing interpolated position");
+    mitk::Quaternion expected = CreateSample(45.0).m_Orientation;
+    bool orientationEqual = true;
+    for (unsigned int i = 0; i < 4; ++i)
+    {
+      orientationEqual = orientationEqual && std::fabs(sample.m_Orientation[i] - expected[i]) < 1e-6;
+    }
+    MITK_TEST_CONDITION(orientationEqual, "Testing interpolated orientation (slerp)");
+
+    MITK_TEST_CONDITION(buffer.GetSampleAt(200.0, sample) && sample.m_TimeStamp == 90.0, "Testing GetSampleAt() after the latest sample");
+    MITK_TEST_CONDITION(buffer.GetSampleAt(-10.0, sample) && sample.m_TimeStamp == 0.0, "Testing GetSampleAt() before the oldest sample");
+
+    mitk::TrackingToolSample invalid = CreateSample(100.0);
+    invalid.m_DataValid = false;
+    buffer.Push(invalid);
+    MITK_TEST_CONDITION(buffer.GetSampleAt(92.0, sample) && sample.m_DataValid && sample.m_TimeStamp == 90.0, "Testing GetSampleAt() near a valid sample");
+    MITK_TEST_CONDITION(buffer.GetSampleAt(98.0, sample) && !sample.m_DataValid, "Testing GetSampleAt() near an invalid sample");
+  }
+
+  struct ConcurrencyTestData
+  {
+    mitk::TrackingToolSampleBuffer m_Buffer;
+    unsigned int m_NumberOfSamples;
+  };
+
+  static ITK_THREAD_RETURN_TYPE ThreadStartPushing(void* pInfoStruct)
+  {
+    struct itk::MultiThreader::ThreadInfoStruct* pInfo = (struct itk::MultiThreader::ThreadInfoStruct*)pInfoStruct;
+    ConcurrencyTestData* data = static_cast<ConcurrencyTestData*>(pInfo->UserData);
+    for (unsigned int i = 1; i <= data->m_NumberOfSamples; ++i)
+    {
+      data->m_Buffer.Push(CreateSample(i));
+    }
+    return ITK_THREAD_RETURN_VALUE;
+  }
+
+  static void TestConcurrentReading()
+  {
+    ConcurrencyTestData data;
+    data.m_NumberOfSamples = 200000;
+
+    itk::MultiThreader::Pointer threader = itk::MultiThreader::New();
+    int threadID = threader->SpawnThread(ThreadStartPushing, &data);
+
+    // every sample which is read must be one that was pushed, never a mix of two samples
+    bool consistent = true;
+    double lastTimeStamp = 0.0;
+    bool monotonic = true;
+    mitk::TrackingToolSample sample;
+    while (lastTimeStamp < data.m_NumberOfSamples)
+    {
+      if (!data.m_Buffer.GetLatestSample(sample))
+      {
+        continue;
+      }
+      consistent = consistent && sample.m_Position[0] == sample.m_TimeStamp && sample.m_Position[2] == sample.m_TimeStamp;
+      monotonic = monotonic && sample.m_TimeStamp >= lastTimeStamp;
+      lastTimeStamp = sample.m_TimeStamp;
+    }
+    threader->TerminateThread(threadID);
+
+    MITK_TEST_CONDITION(consistent, "Testing consistency of samples read while pushing");
+    MITK_TEST_CONDITION(monotonic, "Testing order of samples read while pushing");
+  }
+};
+
+/**Documentation
+ *  test for the class "TrackingToolSampleBuffer".
+ */
+int mitkTrackingToolSampleBufferTest(int /* argc */, char* /*argv*/[])
+{
+  MITK_TEST_BEGIN("TrackingToolSampleBuffer");
+
+  mitkTrackingToolSampleBufferTestClass::TestEmptyBuffer();
+  mitkTrackingToolSampleBufferTestClass::TestLatestSample();
+  mitkTrackingToolSampleBufferTestClass::TestInterpolation();
+  mitkTrackingToolSampleBufferTestClass::TestConcurrentReading();
+
+  MITK_TEST_END();
+}
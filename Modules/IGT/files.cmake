@@ -5,6 +5,7 @@ set(CPP_FILES
   IGTFilters/mitkNavigationDataRecorder.cpp
   IGTFilters/mitkNavigationDataPlayer.cpp
   IGTFilters/mitkNavigationDataPlayerBase.cpp
+  IGTFilters/mitkNavigationDataBinaryFile.cpp
   IGTFilters/mitkNavigationDataObjectVisualizationFilter.cpp
   IGTFilters/mitkCameraVisualization.cpp
   IGTFilters/mitkNavigationData.cpp
@@ -31,6 +32,7 @@ set(CPP_FILES
   IGTTrackingDevices/mitkSerialCommunication.cpp
   IGTTrackingDevices/mitkTrackingDevice.cpp
   IGTTrackingDevices/mitkTrackingTool.cpp
+  IGTTrackingDevices/mitkTrackingToolSampleBuffer.cpp
   IGTTrackingDevices/mitkVirtualTrackingDevice.cpp
   IGTTrackingDevices/mitkVirtualTrackingTool.cpp
 
@@ -489,6 +489,33 @@ int mitkImageStatisticsCalculatorTest(int, char* [])
       << test.sd <<"' for testcase #" << test.id );
   }
 
+  // One calculator which is reused for all figures on the same slice has to
+  // deliver the same results as a new calculator for each figure, no matter
+  // whether the statistics were updated incrementally or recomputed
+  mitk::ImageStatisticsCalculator::Pointer incrementalCalculator = mitk::ImageStatisticsCalculator::New();
+  incrementalCalculator->SetImage( image );
+  incrementalCalculator->SetMaskingModeToPlanarFigure();
+  incrementalCalculator->IncrementalPlanarFigureUpdateOn();
+
+  for ( std::vector<mitkImageStatisticsCalculatorTestClass::testCase>::size_type i=0; i<allTestCases.size(); i++ )
+  {
+    mitkImageStatisticsCalculatorTestClass::testCase test = allTestCases[i];
+
+    const mitk::ImageStatisticsCalculator::Statistics stats =
+      mitkImageStatisticsCalculatorTestClass::TestStatistics( image, test.figure );
+
+    incrementalCalculator->SetPlanarFigure( test.figure );
+    incrementalCalculator->ComputeStatistics();
+    const mitk::ImageStatisticsCalculator::Statistics incrementalStats = incrementalCalculator->GetStatistics();
+
+    MITK_TEST_CONDITION( incrementalStats.N == stats.N
+      && fabs( incrementalStats.Mean - stats.Mean ) < mitk::eps
+      && fabs( incrementalStats.Sigma - stats.Sigma ) < mitk::eps
+      && incrementalStats.Min == stats.Min && incrementalStats.Max == stats.Max,
+      "Statistics of reused calculator (incremental update: " << incrementalCalculator->GetLastUpdateWasIncremental()
+      << ") are equal to a new calculator for testcase #" << test.id );
+  }
+
   TestUnitilizedImage();
 
   MITK_TEST_END()
@@ -24,10 +24,9 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 #include <itkChangeInformationImageFilter.h>
 #include <itkExtractImageFilter.h>
-#include <itkMinimumMaximumImageCalculator.h>
-#include <itkStatisticsImageFilter.h>
-#include <itkLabelStatisticsImageFilter.h>
-#include <itkMaskImageFilter.h>
+#include <itkImageDuplicator.h>
+#include <itkImageRegionConstIterator.h>
+#include <itkImageRegionSplitter.h>
 
 #include <itkCastImageFilter.h>
 #include <itkImageFileWriter.h>
@@ -48,7 +47,8 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <itkImageFileWriter.h>
 #include <itkRescaleIntensityImageFilter.h>
 
-#include <list>
+#include <algorithm>
+#include <limits>
 
 #if ( ( VTK_MAJOR_VERSION <= 5 ) && ( VTK_MINOR_VERSION<=8)  )
   #include "mitkvtkLassoStencilSource.h"
@@ -70,6 +70,16 @@ ImageStatisticsCalculator::ImageStatisticsCalculator()
   m_IgnorePixelValue(0.0),
   m_DoIgnorePixelValue(false),
   m_IgnorePixelValueChanged(false),
+  m_NumberOfThreads(0),
+  m_IncrementalPlanarFigureUpdate(true),
+  m_LastUpdateWasIncremental(false),
+  m_PlanarFigureCacheValid(false),
+  m_PlanarFigureCacheTimeStep(0),
+  m_PlanarFigureCacheAxis(0),
+  m_PlanarFigureCacheSlice(0),
+  m_PlanarFigureCacheImageMTime(0),
+  m_PlanarFigureCacheDoIgnorePixelValue(false),
+  m_PlanarFigureCacheIgnorePixelValue(0.0),
   m_PlanarFigureAxis (0),
   m_PlanarFigureSlice (0),
   m_PlanarFigureCoordinate0 (0),
@@ -96,6 +106,7 @@ void ImageStatisticsCalculator::SetImage( const mitk::Image *image )
   {
     m_Image = image;
     this->Modified();
+    m_PlanarFigureCacheValid = false;
 
     unsigned int numberOfTimeSteps = image->GetTimeSteps();
 
@@ -356,8 +367,28 @@ bool ImageStatisticsCalculator::ComputeStatistics( unsigned int timeStep )
     break;
   }
 
+  // A planar figure which was modified on the same slice only requires to
+  // update the previous statistics for the pixels that changed
+  bool incrementallyUpdated = false;
+  if ( m_MaskingMode == MASKING_MODE_PLANARFIGURE && m_IncrementalPlanarFigureUpdate
+    && this->IsPlanarFigureCacheValid( timeStep ) && m_InternalImage->GetDimension() == 2 )
+  {
+    AccessFixedDimensionByItk_3(
+      m_InternalImage,
+      InternalUpdatePlanarFigureStatistics,
+      2,
+      statisticsContainer,
+      histogramContainer,
+      &incrementallyUpdated );
+  }
+  m_LastUpdateWasIncremental = incrementallyUpdated;
+
   // Calculate statistics and histogram(s)
-  if ( m_InternalImage->GetDimension() == 3 )
+  if ( incrementallyUpdated )
+  {
+    // Statistics are up to date
+  }
+  else if ( m_InternalImage->GetDimension() == 3 )
   {
     if ( m_MaskingMode == MASKING_MODE_NONE && !m_DoIgnorePixelValue )
     {
@@ -407,6 +438,16 @@ bool ImageStatisticsCalculator::ComputeStatistics( unsigned int timeStep )
   }
 
 
+  if ( m_MaskingMode == MASKING_MODE_PLANARFIGURE && m_IncrementalPlanarFigureUpdate )
+  {
+    m_PlanarFigureCacheTimeStep = timeStep;
+    m_PlanarFigureCacheAxis = m_PlanarFigureAxis;
+    m_PlanarFigureCacheSlice = m_PlanarFigureSlice;
+    m_PlanarFigureCacheImageMTime = m_Image->GetMTime();
+    m_PlanarFigureCacheDoIgnorePixelValue = m_DoIgnorePixelValue;
+    m_PlanarFigureCacheIgnorePixelValue = m_IgnorePixelValue;
+  }
+
   // Release unused image smart pointers to free memory
   m_InternalImage = mitk::Image::ConstPointer();
   m_InternalImageMask3D = MaskImage3DType::Pointer();
@@ -721,56 +762,42 @@ void ImageStatisticsCalculator::InternalCalculateStatisticsUnmasked(
   statisticsContainer->clear();
   histogramContainer->clear();
 
-  // Progress listening...
-  typedef itk::SimpleMemberCommand< ImageStatisticsCalculator > ITKCommandType;
-  ITKCommandType::Pointer progressListener;
-  progressListener = ITKCommandType::New();
-  progressListener->SetCallbackFunction( this,
-    &ImageStatisticsCalculator::UnmaskedStatisticsProgressUpdate );
-
-
-  // Issue 100 artificial progress events since ScalarIMageToHistogramGenerator
-  // does not (yet?) support progress reporting
+  // Issue 100 artificial progress events since neither the parallel
+  // accumulation nor ScalarImageToHistogramGenerator support progress reporting
   this->InvokeEvent( itk::StartEvent() );
-  for ( unsigned int i = 0; i < 100; ++i )
+  for ( unsigned int i = 0; i < 200; ++i )
   {
     this->UnmaskedStatisticsProgressUpdate();
   }
 
-  // Calculate statistics (separate filter)
-  typedef itk::StatisticsImageFilter< ImageType > StatisticsFilterType;
-  typename StatisticsFilterType::Pointer statisticsFilter = StatisticsFilterType::New();
-  statisticsFilter->SetInput( image );
-  unsigned long observerTag = statisticsFilter->AddObserver( itk::ProgressEvent(), progressListener );
-  statisticsFilter->Update();
-  statisticsFilter->RemoveObserver( observerTag );
+  // Calculate moments, minimum and maximum in one parallel pass
+  LabelAccumulatorMap accumulators;
+  this->InternalAccumulateStatistics( image, (const MaskImageType *) NULL,
+    image->GetBufferedRegion(), HistogramBinning(), accumulators );
   this->InvokeEvent( itk::EndEvent() );
 
-  // Calculate minimum and maximum
-  typedef itk::MinimumMaximumImageCalculator< ImageType > MinMaxFilterType;
-  typename MinMaxFilterType::Pointer minMaxFilter = MinMaxFilterType::New();
-  minMaxFilter->SetImage( image );
-  unsigned long observerTag2 = minMaxFilter->AddObserver( itk::ProgressEvent(), progressListener );
-  minMaxFilter->Compute();
-  minMaxFilter->RemoveObserver( observerTag2 );
-  this->InvokeEvent( itk::EndEvent() );
+  const LabelAccumulator &accumulator = accumulators[1];
+  const double n = static_cast< double >( accumulator.Count );
 
   Statistics statistics; statistics.Reset();
   statistics.Label = 1;
   statistics.N = image->GetBufferedRegion().GetNumberOfPixels();
-  statistics.Min = statisticsFilter->GetMinimum();
-  statistics.Max = statisticsFilter->GetMaximum();
-  statistics.Mean = statisticsFilter->GetMean();
+  statistics.Min = accumulator.Min;
+  statistics.Max = accumulator.Max;
+  statistics.Mean = accumulator.Sum / n;
   statistics.Median = 0.0;
-  statistics.Sigma = statisticsFilter->GetSigma();
+  statistics.Variance = ( accumulator.Count > 1 ) ? std::max( ( accumulator.SumOfSquares - accumulator.Sum * accumulator.Sum / n ) / ( n - 1.0 ), 0.0 ) : 0.0;
+  statistics.Sigma = sqrt( statistics.Variance );
   statistics.RMS = sqrt( statistics.Mean * statistics.Mean + statistics.Sigma * statistics.Sigma );
 
+  IndexType minIndex = image->ComputeIndex( accumulator.MinOffset );
+  IndexType maxIndex = image->ComputeIndex( accumulator.MaxOffset );
   statistics.MinIndex.set_size(image->GetImageDimension());
   statistics.MaxIndex.set_size(image->GetImageDimension());
   for (int i=0; i<statistics.MaxIndex.size(); i++)
   {
-      statistics.MaxIndex[i] = minMaxFilter->GetIndexOfMaximum()[i];
-      statistics.MinIndex[i] = minMaxFilter->GetIndexOfMinimum()[i];
+      statistics.MaxIndex[i] = maxIndex[i];
+      statistics.MinIndex[i] = minIndex[i];
   }
 
   statisticsContainer->push_back( statistics );
@@ -829,8 +856,6 @@ void ImageStatisticsCalculator::InternalCalculateStatisticsMasked(
   typedef typename ImageType::PointType PointType;
   typedef typename ImageType::SpacingType SpacingType;
 
-  typedef itk::LabelStatisticsImageFilter< ImageType, MaskImageType > LabelStatisticsFilterType;
-
   typedef itk::ChangeInformationImageFilter< MaskImageType > ChangeInformationFilterType;
 
   typedef itk::ExtractImageFilter< ImageType, ImageType > ExtractImageFilterType;
@@ -940,131 +965,382 @@ void ImageStatisticsCalculator::InternalCalculateStatisticsMasked(
     adaptedImage = image;
   }
 
-  // Initialize Filter
-  typedef itk::StatisticsImageFilter< ImageType > StatisticsFilterType;
-  typename StatisticsFilterType::Pointer statisticsFilter = StatisticsFilterType::New();
-  statisticsFilter->SetInput( adaptedImage );
-
-  statisticsFilter->Update();
+  // Determine range of the histograms from the extrema of the whole image
+  LabelAccumulatorMap imageAccumulators;
+  this->InternalAccumulateStatistics( adaptedImage.GetPointer(), (const MaskImageType *) NULL,
+    adaptedImage->GetBufferedRegion(), HistogramBinning(), imageAccumulators );
 
   int numberOfBins = ( m_DoIgnorePixelValue && (m_MaskingMode == MASKING_MODE_NONE) ) ? 768 : 384;
-  typename LabelStatisticsFilterType::Pointer labelStatisticsFilter;
-  labelStatisticsFilter = LabelStatisticsFilterType::New();
-  labelStatisticsFilter->SetInput( adaptedImage );
-  labelStatisticsFilter->SetLabelInput( adaptedMaskImage );
-  labelStatisticsFilter->UseHistogramsOn();
-  labelStatisticsFilter->SetHistogramParameters( numberOfBins, statisticsFilter->GetMinimum(), statisticsFilter->GetMaximum() );
-
-
-  // Add progress listening
-  typedef itk::SimpleMemberCommand< ImageStatisticsCalculator > ITKCommandType;
-  ITKCommandType::Pointer progressListener;
-  progressListener = ITKCommandType::New();
-  progressListener->SetCallbackFunction( this,
-    &ImageStatisticsCalculator::MaskedStatisticsProgressUpdate );
-  unsigned long observerTag = labelStatisticsFilter->AddObserver(
-    itk::ProgressEvent(), progressListener );
-
-  // Execute filter
+  HistogramBinning binning;
+  if ( imageAccumulators[1].Count > 0 )
+  {
+    binning.Initialize( numberOfBins, imageAccumulators[1].Min, imageAccumulators[1].Max );
+  }
+  else
+  {
+    binning.Initialize( numberOfBins, 0.0, 0.0 );
+  }
+
+  // Execute the per label accumulation; only the mask region is considered
   this->InvokeEvent( itk::StartEvent() );
+  LabelAccumulatorMap labelAccumulators;
+  this->InternalAccumulateStatistics( adaptedImage.GetPointer(), adaptedMaskImage.GetPointer(),
+    adaptedMaskImage->GetLargestPossibleRegion(), binning, labelAccumulators );
+  this->MaskedStatisticsProgressUpdate();
+  this->InvokeEvent( itk::EndEvent() );
 
-  // Make sure that only the mask region is considered (otherwise, if the mask region is smaller
-  // than the image region, the Update() would result in an exception).
-  labelStatisticsFilter->GetOutput()->SetRequestedRegion( adaptedMaskImage->GetLargestPossibleRegion() );
+  if ( m_MaskingMode == MASKING_MODE_PLANARFIGURE && m_IncrementalPlanarFigureUpdate )
+  {
+    this->CachePlanarFigureStatistics( labelAccumulators, binning );
+  }
 
+  this->InternalStatisticsFromAccumulators( adaptedImage.GetPointer(), labelAccumulators, binning,
+    statisticsContainer, histogramContainer );
+}
 
-  // Execute the filter
-  labelStatisticsFilter->Update();
-  this->InvokeEvent( itk::EndEvent() );
-  labelStatisticsFilter->RemoveObserver( observerTag );
 
-  // Find all relevant labels of mask (other than 0)
-  std::list< int > relevantLabels;
-  bool maskNonEmpty = false;
-  unsigned int i;
-  for ( i = 1; i < 4096; ++i )
+template < typename TPixel, unsigned int VImageDimension >
+void ImageStatisticsCalculator::InternalStatisticsFromAccumulators(
+  const itk::Image< TPixel, VImageDimension > *image,
+  const LabelAccumulatorMap &accumulators,
+  const HistogramBinning &binning,
+  StatisticsContainer* statisticsContainer,
+  HistogramContainer* histogramContainer )
+{
+  typedef itk::Image< TPixel, VImageDimension > ImageType;
+  typedef typename ImageType::IndexType IndexType;
+
+  statisticsContainer->clear();
+  histogramContainer->clear();
+
+  // All relevant labels of mask (other than 0) in ascending order
+  LabelAccumulatorMap::const_iterator it;
+  for ( it = accumulators.begin(); it != accumulators.end(); ++it )
   {
-    if ( labelStatisticsFilter->HasLabel( i ) )
+    const LabelAccumulator &accumulator = it->second;
+    if ( it->first == 0 || it->first >= 4096 || accumulator.Count == 0 )
     {
-      relevantLabels.push_back( i );
-      maskNonEmpty = true;
+      continue;
+    }
+
+    histogramContainer->push_back( HistogramType::ConstPointer( binning.CreateHistogram( accumulator.Histogram ) ) );
+
+    const double n = static_cast< double >( accumulator.Count );
+
+    Statistics statistics; statistics.Reset();
+    statistics.Label = it->first;
+    statistics.N = accumulator.Count;
+    statistics.Min = accumulator.Min;
+    statistics.Max = accumulator.Max;
+    statistics.Mean = accumulator.Sum / n;
+    statistics.Median = binning.GetMedian( accumulator.Histogram, n );
+    statistics.Variance = ( accumulator.Count > 1 ) ? std::max( ( accumulator.SumOfSquares - accumulator.Sum * accumulator.Sum / n ) / ( n - 1.0 ), 0.0 ) : 0.0;
+    statistics.Sigma = sqrt( statistics.Variance );
+    statistics.RMS = sqrt( statistics.Mean * statistics.Mean
+      + statistics.Sigma * statistics.Sigma );
+
+    statistics.MinIndex.set_size(image->GetImageDimension());
+    statistics.MaxIndex.set_size(image->GetImageDimension());
+
+    IndexType tempMaxIndex = image->ComputeIndex( accumulator.MaxOffset );
+    IndexType tempMinIndex = image->ComputeIndex( accumulator.MinOffset );
+
+// FIX BUG 14644
+    //If a PlanarFigure is used for segmentation the
+    //adaptedImage is a single slice (2D). Adding the
+    // 3. dimension.
+    if (m_MaskingMode == MASKING_MODE_PLANARFIGURE && m_Image->GetDimension()==3)
+    {
+        statistics.MaxIndex.set_size(m_Image->GetDimension());
+        statistics.MaxIndex[m_PlanarFigureCoordinate0]=tempMaxIndex[0];
+        statistics.MaxIndex[m_PlanarFigureCoordinate1]=tempMaxIndex[1];
+        statistics.MaxIndex[m_PlanarFigureAxis]=m_PlanarFigureSlice;
+
+        statistics.MinIndex.set_size(m_Image->GetDimension());
+        statistics.MinIndex[m_PlanarFigureCoordinate0]=tempMinIndex[0];
+        statistics.MinIndex[m_PlanarFigureCoordinate1]=tempMinIndex[1];
+        statistics.MinIndex[m_PlanarFigureAxis]=m_PlanarFigureSlice;
+    } else
+    {
+      for (int i = 0; i<statistics.MaxIndex.size(); i++)
+      {
+        statistics.MaxIndex[i] = tempMaxIndex[i];
+        statistics.MinIndex[i] = tempMinIndex[i];
+      }
     }
+// FIX END
+
+    statisticsContainer->push_back( statistics );
   }
-  if ( maskNonEmpty )
+
+  if ( statisticsContainer->empty() )
   {
-    std::list< int >::iterator it;
-    for ( it = relevantLabels.begin(), i = 0;
-          it != relevantLabels.end();
-          ++it, ++i )
+    histogramContainer->push_back( HistogramType::ConstPointer( m_EmptyHistogram ) );
+    statisticsContainer->push_back( Statistics() );;
+  }
+}
+
+
+template < typename TPixel, unsigned int VImageDimension >
+void ImageStatisticsCalculator::InternalAccumulateStatistics(
+  const itk::Image< TPixel, VImageDimension > *image,
+  const itk::Image< unsigned short, VImageDimension > *maskImage,
+  const itk::ImageRegion< VImageDimension > &region,
+  const HistogramBinning &binning,
+  LabelAccumulatorMap &accumulators )
+{
+  typedef itk::ImageRegionSplitter< VImageDimension > SplitterType;
+  typedef AccumulateStatisticsThreadStruct< TPixel, VImageDimension > ThreadStructType;
+
+  accumulators.clear();
+
+  // Starting threads does not pay off for a few thousand pixels, e.g. a
+  // small planar figure
+  const unsigned long minimumPixelsPerThread = 16384;
+  unsigned int numberOfThreads = m_NumberOfThreads;
+  if ( numberOfThreads == 0 )
+  {
+    numberOfThreads = itk::MultiThreader::GetGlobalDefaultNumberOfThreads();
+  }
+  unsigned long maximumNumberOfThreads = region.GetNumberOfPixels() / minimumPixelsPerThread;
+  if ( numberOfThreads > maximumNumberOfThreads )
+  {
+    numberOfThreads = std::max( maximumNumberOfThreads, 1ul );
+  }
+
+  typename SplitterType::Pointer splitter = SplitterType::New();
+
+  ThreadStructType threadStruct;
+  threadStruct.Image = image;
+  threadStruct.Mask = maskImage;
+  threadStruct.Region = region;
+  threadStruct.Binning = &binning;
+  threadStruct.NumberOfSplits = splitter->GetNumberOfSplits( region, numberOfThreads );
+  threadStruct.Results.resize( threadStruct.NumberOfSplits );
+
+  if ( threadStruct.NumberOfSplits > 1 )
+  {
+    itk::MultiThreader::Pointer threader = itk::MultiThreader::New();
+    threader->SetNumberOfThreads( threadStruct.NumberOfSplits );
+    threader->SetSingleMethod( &ImageStatisticsCalculator::AccumulateStatisticsThreaderCallback< TPixel, VImageDimension >, &threadStruct );
+    threader->SingleMethodExecute();
+  }
+  else
+  {
+    itk::MultiThreader::ThreadInfoStruct threadInfo;
+    threadInfo.ThreadID = 0;
+    threadInfo.NumberOfThreads = 1;
+    threadInfo.UserData = &threadStruct;
+    ImageStatisticsCalculator::AccumulateStatisticsThreaderCallback< TPixel, VImageDimension >( &threadInfo );
+  }
+
+  // Merge partial results of all threads
+  for ( unsigned int split = 0; split < threadStruct.NumberOfSplits; ++split )
+  {
+    LabelAccumulatorMap::const_iterator it;
+    for ( it = threadStruct.Results[split].begin(); it != threadStruct.Results[split].end(); ++it )
     {
-      histogramContainer->push_back( HistogramType::ConstPointer( labelStatisticsFilter->GetHistogram( (*it) ) ) );
-
-      Statistics statistics;
-      statistics.Label = (*it);
-      statistics.N = labelStatisticsFilter->GetCount( *it );
-      statistics.Min = labelStatisticsFilter->GetMinimum( *it );
-      statistics.Max = labelStatisticsFilter->GetMaximum( *it );
-      statistics.Mean = labelStatisticsFilter->GetMean( *it );
-      statistics.Median = labelStatisticsFilter->GetMedian( *it );
-      statistics.Sigma = labelStatisticsFilter->GetSigma( *it );
-      statistics.RMS = sqrt( statistics.Mean * statistics.Mean
-        + statistics.Sigma * statistics.Sigma );
-
-      // restrict image to mask area for min/max index calculation
-      typedef itk::MaskImageFilter< ImageType, MaskImageType, ImageType > MaskImageFilterType;
-      typename MaskImageFilterType::Pointer masker = MaskImageFilterType::New();
-      masker->SetOutsideValue( (statistics.Min+statistics.Max)/2 );
-      masker->SetInput1(adaptedImage);
-      masker->SetInput2(adaptedMaskImage);
-      masker->Update();
-      // get index of minimum and maximum
-      typedef itk::MinimumMaximumImageCalculator< ImageType > MinMaxFilterType;
-      typename MinMaxFilterType::Pointer minMaxFilter = MinMaxFilterType::New();
-      minMaxFilter->SetImage( masker->GetOutput() );
-      unsigned long observerTag2 = minMaxFilter->AddObserver( itk::ProgressEvent(), progressListener );
-      minMaxFilter->Compute();
-      minMaxFilter->RemoveObserver( observerTag2 );
-      this->InvokeEvent( itk::EndEvent() );
-
-        statistics.MinIndex.set_size(adaptedImage->GetImageDimension());
-        statistics.MaxIndex.set_size(adaptedImage->GetImageDimension());
-
-        typename MinMaxFilterType::IndexType tempMaxIndex = minMaxFilter->GetIndexOfMaximum();
-        typename MinMaxFilterType::IndexType tempMinIndex = minMaxFilter->GetIndexOfMinimum();
+      accumulators[it->first].Merge( it->second );
+    }
+  }
+}
 
-// FIX BUG 14644
-        //If a PlanarFigure is used for segmentation the
-        //adaptedImage is a single slice (2D). Adding the
-        // 3. dimension.
-        if (m_MaskingMode == MASKING_MODE_PLANARFIGURE && m_Image->GetDimension()==3)
+
+template < typename TPixel, unsigned int VImageDimension >
+ITK_THREAD_RETURN_TYPE ImageStatisticsCalculator::AccumulateStatisticsThreaderCallback( void *arg )
+{
+  typedef itk::Image< TPixel, VImageDimension > ImageType;
+  typedef itk::Image< unsigned short, VImageDimension > MaskImageType;
+  typedef itk::ImageRegionSplitter< VImageDimension > SplitterType;
+  typedef AccumulateStatisticsThreadStruct< TPixel, VImageDimension > ThreadStructType;
+
+  itk::MultiThreader::ThreadInfoStruct *threadInfo = static_cast< itk::MultiThreader::ThreadInfoStruct * >( arg );
+  ThreadStructType *threadStruct = static_cast< ThreadStructType * >( threadInfo->UserData );
+
+  const ImageType *image = threadStruct->Image;
+  const MaskImageType *mask = threadStruct->Mask;
+  const HistogramBinning &binning = *threadStruct->Binning;
+
+  typename SplitterType::Pointer splitter = SplitterType::New();
+
+  for ( unsigned int split = threadInfo->ThreadID; split < threadStruct->NumberOfSplits; split += threadInfo->NumberOfThreads )
+  {
+    typename ImageType::RegionType splitRegion = splitter->GetSplit( split, threadStruct->NumberOfSplits, threadStruct->Region );
+    LabelAccumulatorMap &result = threadStruct->Results[split];
+
+    itk::ImageRegionConstIterator< ImageType > imageIt( image, splitRegion );
+    itk::ImageRegionConstIterator< MaskImageType > maskIt;
+    if ( mask != NULL )
+    {
+      maskIt = itk::ImageRegionConstIterator< MaskImageType >( mask, splitRegion );
+    }
+
+    // Mask images mostly contain long runs of the same label; avoid a map
+    // lookup per pixel
+    unsigned short currentLabel = 0;
+    LabelAccumulator *accumulator = NULL;
+
+    for ( ; !imageIt.IsAtEnd(); ++imageIt )
+    {
+      unsigned short label = 1;
+      if ( mask != NULL )
+      {
+        label = maskIt.Get();
+        ++maskIt;
+        if ( label == 0 )
         {
-            statistics.MaxIndex.set_size(m_Image->GetDimension());
-            statistics.MaxIndex[m_PlanarFigureCoordinate0]=tempMaxIndex[0];
-            statistics.MaxIndex[m_PlanarFigureCoordinate1]=tempMaxIndex[1];
-            statistics.MaxIndex[m_PlanarFigureAxis]=m_PlanarFigureSlice;
-
-            statistics.MinIndex.set_size(m_Image->GetDimension());
-            statistics.MinIndex[m_PlanarFigureCoordinate0]=tempMinIndex[0];
-            statistics.MinIndex[m_PlanarFigureCoordinate1]=tempMinIndex[1];
-            statistics.MinIndex[m_PlanarFigureAxis]=m_PlanarFigureSlice;
-        } else
+          continue;
+        }
+      }
+
+      if ( accumulator == NULL || label != currentLabel )
+      {
+        currentLabel = label;
+        accumulator = &result[label];
+        if ( accumulator->Histogram.size() != binning.NumberOfBins )
         {
-          for (int i = 0; i<statistics.MaxIndex.size(); i++)
-          {
-            statistics.MaxIndex[i] = tempMaxIndex[i];
-            statistics.MinIndex[i] = tempMinIndex[i];
-          }
+          accumulator->Histogram.resize( binning.NumberOfBins, 0.0 );
         }
-// FIX END
+      }
+
+      const double value = static_cast< double >( imageIt.Get() );
+      ++accumulator->Count;
+      accumulator->Sum += value;
+      accumulator->SumOfSquares += value * value;
+
+      // Strict comparison keeps the first extremal pixel in scan order
+      if ( value < accumulator->Min )
+      {
+        accumulator->Min = value;
+        accumulator->MinOffset = image->ComputeOffset( imageIt.GetIndex() );
+      }
+      if ( value > accumulator->Max )
+      {
+        accumulator->Max = value;
+        accumulator->MaxOffset = image->ComputeOffset( imageIt.GetIndex() );
+      }
 
-      statisticsContainer->push_back( statistics );
+      if ( binning.NumberOfBins > 0 )
+      {
+        accumulator->Histogram[ binning.GetBin( value ) ] += 1.0;
+      }
     }
   }
-  else
+
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+
+template < typename TPixel, unsigned int VImageDimension >
+void ImageStatisticsCalculator::InternalUpdatePlanarFigureStatistics(
+  const itk::Image< TPixel, VImageDimension > *image,
+  StatisticsContainer* statisticsContainer,
+  HistogramContainer* histogramContainer,
+  bool *updated )
+{
+  typedef itk::Image< TPixel, VImageDimension > ImageType;
+
+  *updated = false;
+
+  const MaskImage2DType *mask = m_InternalImageMask2D.GetPointer();
+  const MaskImage2DType *cachedMask = m_PlanarFigureCacheMask.GetPointer();
+  if ( mask == NULL || cachedMask == NULL
+    || mask->GetLargestPossibleRegion() != cachedMask->GetLargestPossibleRegion()
+    || image->GetBufferedRegion() != mask->GetLargestPossibleRegion() )
   {
-    histogramContainer->push_back( HistogramType::ConstPointer( m_EmptyHistogram ) );
-    statisticsContainer->push_back( Statistics() );;
+    return;
+  }
+
+  // Outside of the bounds of the previous and the current figure, both masks are empty
+  MaskImage2DType::RegionType changedRegion = m_PlanarFigureMaskBounds;
+  MaskImage2DType::IndexType lower, upper;
+  for ( unsigned int i = 0; i < 2; ++i )
+  {
+    lower[i] = std::min( m_PlanarFigureMaskBounds.GetIndex()[i], m_PlanarFigureCacheMaskBounds.GetIndex()[i] );
+    upper[i] = std::max( m_PlanarFigureMaskBounds.GetUpperIndex()[i], m_PlanarFigureCacheMaskBounds.GetUpperIndex()[i] );
   }
+  changedRegion.SetIndex( lower );
+  changedRegion.SetUpperIndex( upper );
+
+  // Pixels that entered the figure are added, pixels that left it are
+  // removed from a copy of the previous result
+  LabelAccumulatorMap accumulators = m_PlanarFigureCacheAccumulators;
+  const HistogramBinning &binning = m_PlanarFigureCacheBinning;
+
+  itk::ImageRegionConstIterator< MaskImage2DType > maskIt( mask, changedRegion );
+  itk::ImageRegionConstIterator< MaskImage2DType > cachedMaskIt( cachedMask, changedRegion );
+  itk::ImageRegionConstIterator< ImageType > imageIt( image, changedRegion );
+  for ( ; !maskIt.IsAtEnd(); ++maskIt, ++cachedMaskIt, ++imageIt )
+  {
+    const unsigned short label = maskIt.Get();
+    const unsigned short cachedLabel = cachedMaskIt.Get();
+    if ( label == cachedLabel )
+    {
+      continue;
+    }
+
+    const double value = static_cast< double >( imageIt.Get() );
+    const unsigned int bin = binning.GetBin( value );
+
+    if ( cachedLabel != 0 )
+    {
+      LabelAccumulatorMap::iterator accumulatorIt = accumulators.find( cachedLabel );
+      if ( accumulatorIt == accumulators.end() || !accumulatorIt->second.Remove( value, bin ) )
+      {
+        // An extremum left the figure, statistics need to be recomputed
+        return;
+      }
+    }
+
+    if ( label != 0 )
+    {
+      LabelAccumulator &accumulator = accumulators[label];
+      if ( accumulator.Histogram.size() != binning.NumberOfBins )
+      {
+        accumulator.Histogram.resize( binning.NumberOfBins, 0.0 );
+      }
+      accumulator.Add( value, image->ComputeOffset( imageIt.GetIndex() ), bin );
+    }
+  }
+
+  this->CachePlanarFigureStatistics( accumulators, binning );
+  this->InternalStatisticsFromAccumulators( image, accumulators, binning, statisticsContainer, histogramContainer );
+  *updated = true;
+}
+
+
+void ImageStatisticsCalculator::CachePlanarFigureStatistics(
+  const LabelAccumulatorMap &accumulators, const HistogramBinning &binning )
+{
+  m_PlanarFigureCacheValid = false;
+  if ( m_InternalImageMask2D.IsNull() )
+  {
+    return;
+  }
+
+  // The mask may refer to the memory of the VTK pipeline it was created with
+  typedef itk::ImageDuplicator< MaskImage2DType > DuplicatorType;
+  DuplicatorType::Pointer duplicator = DuplicatorType::New();
+  duplicator->SetInputImage( m_InternalImageMask2D );
+  duplicator->Update();
+
+  m_PlanarFigureCacheMask = duplicator->GetOutput();
+  m_PlanarFigureCacheMaskBounds = m_PlanarFigureMaskBounds;
+  m_PlanarFigureCacheAccumulators = accumulators;
+  m_PlanarFigureCacheBinning = binning;
+  m_PlanarFigureCacheValid = true;
+}
+
+
+bool ImageStatisticsCalculator::IsPlanarFigureCacheValid( unsigned int timeStep ) const
+{
+  return m_PlanarFigureCacheValid
+    && m_PlanarFigureCacheTimeStep == timeStep
+    && m_PlanarFigureCacheAxis == m_PlanarFigureAxis
+    && m_PlanarFigureCacheSlice == m_PlanarFigureSlice
+    && m_PlanarFigureCacheImageMTime == m_Image->GetMTime()
+    && m_PlanarFigureCacheDoIgnorePixelValue == m_DoIgnorePixelValue
+    && m_PlanarFigureCacheIgnorePixelValue == m_IgnorePixelValue;
 }
 
 
@@ -1193,6 +1469,206 @@ void ImageStatisticsCalculator::InternalCalculateMaskFromPlanarFigure(
 
   // Store mask
   m_InternalImageMask2D = itkImporter->GetOutput();
+
+  // Remember the part of the mask covered by the figure (with a safety
+  // margin for rasterization), which bounds the changes of incremental updates
+  MaskImage2DType::RegionType maskRegion = m_InternalImageMask2D->GetLargestPossibleRegion();
+  MaskImage2DType::IndexType boundsIndex;
+  MaskImage2DType::SizeType boundsSize;
+  for ( unsigned int i = 0; i < 2; ++i )
+  {
+    boundsIndex[i] = static_cast< MaskImage2DType::IndexValueType >( floor( bounds[2*i] ) ) - 2;
+    boundsSize[i] = static_cast< MaskImage2DType::SizeValueType >( ceil( bounds[2*i+1] ) - floor( bounds[2*i] ) ) + 5;
+  }
+  m_PlanarFigureMaskBounds.SetIndex( boundsIndex );
+  m_PlanarFigureMaskBounds.SetSize( boundsSize );
+  if ( !m_PlanarFigureMaskBounds.Crop( maskRegion ) )
+  {
+    m_PlanarFigureMaskBounds = maskRegion;
+  }
+}
+
+
+ImageStatisticsCalculator::HistogramBinning::HistogramBinning()
+: NumberOfBins( 0 ),
+  LowerBound( 0.0 ),
+  UpperBound( 0.0 )
+{
+}
+
+
+void ImageStatisticsCalculator::HistogramBinning::Initialize(
+  unsigned int numberOfBins, double lowerBound, double upperBound )
+{
+  NumberOfBins = numberOfBins;
+  LowerBound = lowerBound;
+  UpperBound = upperBound;
+
+  HistogramType::Pointer histogram = this->CreateHistogram( std::vector< double >() );
+  BinMins.resize( NumberOfBins );
+  BinMaxs.resize( NumberOfBins );
+  for ( unsigned int bin = 0; bin < NumberOfBins; ++bin )
+  {
+    BinMins[bin] = histogram->GetBinMin( 0, bin );
+    BinMaxs[bin] = histogram->GetBinMax( 0, bin );
+  }
+}
+
+
+unsigned int ImageStatisticsCalculator::HistogramBinning::GetBin( double value ) const
+{
+  // Like itk::Statistics::Histogram, values beyond the bounds fall into the
+  // first or last bin
+  if ( NumberOfBins == 0 || value <= BinMins[0] )
+  {
+    return 0;
+  }
+  if ( value >= BinMaxs[NumberOfBins - 1] )
+  {
+    return NumberOfBins - 1;
+  }
+
+  // Estimate the bin and correct it against the exact bin boundaries
+  double relativePosition = ( value - LowerBound ) / ( UpperBound - LowerBound );
+  unsigned int bin = static_cast< unsigned int >( std::min( std::max( relativePosition * NumberOfBins, 0.0 ),
+    static_cast< double >( NumberOfBins - 1 ) ) );
+  while ( bin > 0 && value < BinMins[bin] )
+  {
+    --bin;
+  }
+  while ( bin + 1 < NumberOfBins && value >= BinMins[bin + 1] )
+  {
+    ++bin;
+  }
+  return bin;
+}
+
+
+double ImageStatisticsCalculator::HistogramBinning::GetMedian(
+  const std::vector< double > &frequencies, double count ) const
+{
+  double runningCount = 0.0;
+  for ( unsigned int bin = 0; bin < frequencies.size() && bin < NumberOfBins; ++bin )
+  {
+    runningCount += frequencies[bin];
+    if ( runningCount >= count / 2.0 )
+    {
+      return ( BinMins[bin] + BinMaxs[bin] ) / 2.0;
+    }
+  }
+  return 0.0;
+}
+
+
+ImageStatisticsCalculator::HistogramType::Pointer
+ImageStatisticsCalculator::HistogramBinning::CreateHistogram( const std::vector< double > &frequencies ) const
+{
+  HistogramType::Pointer histogram = HistogramType::New();
+  histogram->SetMeasurementVectorSize( 1 );
+
+  HistogramType::SizeType histogramSize( 1 );
+  histogramSize.Fill( NumberOfBins );
+  HistogramType::MeasurementVectorType lowerBound( 1 );
+  HistogramType::MeasurementVectorType upperBound( 1 );
+  lowerBound.Fill( LowerBound );
+  upperBound.Fill( UpperBound );
+  histogram->Initialize( histogramSize, lowerBound, upperBound );
+
+  for ( unsigned int bin = 0; bin < frequencies.size() && bin < NumberOfBins; ++bin )
+  {
+    histogram->SetFrequency( bin, frequencies[bin] );
+  }
+
+  return histogram;
+}
+
+
+ImageStatisticsCalculator::LabelAccumulator::LabelAccumulator()
+: Count( 0 ),
+  Sum( 0.0 ),
+  SumOfSquares( 0.0 ),
+  Min( std::numeric_limits< double >::max() ),
+  Max( -std::numeric_limits< double >::max() ),
+  MinOffset( 0 ),
+  MaxOffset( 0 )
+{
+}
+
+
+void ImageStatisticsCalculator::LabelAccumulator::Add( double value, long offset, unsigned int bin )
+{
+  ++Count;
+  Sum += value;
+  SumOfSquares += value * value;
+
+  if ( value < Min || ( value == Min && offset < MinOffset ) )
+  {
+    Min = value;
+    MinOffset = offset;
+  }
+  if ( value > Max || ( value == Max && offset < MaxOffset ) )
+  {
+    Max = value;
+    MaxOffset = offset;
+  }
+
+  if ( bin < Histogram.size() )
+  {
+    Histogram[bin] += 1.0;
+  }
+}
+
+
+bool ImageStatisticsCalculator::LabelAccumulator::Remove( double value, unsigned int bin )
+{
+  // The next smaller/larger value is unknown once an extremum is removed
+  if ( value <= Min || value >= Max )
+  {
+    return false;
+  }
+
+  --Count;
+  Sum -= value;
+  SumOfSquares -= value * value;
+
+  if ( bin < Histogram.size() )
+  {
+    Histogram[bin] -= 1.0;
+  }
+  return true;
+}
+
+
+void ImageStatisticsCalculator::LabelAccumulator::Merge( const LabelAccumulator &other )
+{
+  if ( other.Count == 0 )
+  {
+    return;
+  }
+
+  Count += other.Count;
+  Sum += other.Sum;
+  SumOfSquares += other.SumOfSquares;
+
+  if ( other.Min < Min || ( other.Min == Min && other.MinOffset < MinOffset ) )
+  {
+    Min = other.Min;
+    MinOffset = other.MinOffset;
+  }
+  if ( other.Max > Max || ( other.Max == Max && other.MaxOffset < MaxOffset ) )
+  {
+    Max = other.Max;
+    MaxOffset = other.MaxOffset;
+  }
+
+  if ( Histogram.size() < other.Histogram.size() )
+  {
+    Histogram.resize( other.Histogram.size(), 0.0 );
+  }
+  for ( unsigned int bin = 0; bin < other.Histogram.size(); ++bin )
+  {
+    Histogram[bin] += other.Histogram[bin];
+  }
 }
 
 
@@ -22,6 +22,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "ImageStatisticsExports.h"
 #include <itkImage.h>
 #include <itkTimeStamp.h>
+#include <itkMultiThreader.h>
 
 #ifndef __itkHistogram_h
 #include <itkHistogram.h>
@@ -34,6 +35,8 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 #include <vtkSmartPointer.h>
 
+#include <map>
+
 namespace mitk
 {
 
@@ -54,6 +57,16 @@ namespace mitk
  * switching back and forth between operation modes without modifying mask or
  * image, the information doesn't need to be recalculated.
  *
+ * Moments, extrema and histograms are accumulated in a single pass per
+ * thread over a part of the image; the partial results are merged
+ * afterwards (see SetNumberOfThreads()).
+ *
+ * When masking with a planar figure, statistics can be updated incrementally
+ * (see SetIncrementalPlanarFigureUpdate()): if the figure is modified on the
+ * same slice, only the pixels that entered or left the figure are added to
+ * or removed from the previous result. This keeps interactive editing of a
+ * figure responsive.
+ *
  * Note: currently time-resolved and multi-channel pictures are not properly
  * supported.
  */
@@ -143,6 +156,25 @@ public:
   /** \brief Get wether a pixel value will be ignored in the statistics */
   bool GetDoIgnorePixelValue();
 
+  /** \brief Set/Get the number of threads used for computing statistics and
+   * histograms. 0 (default) uses the global default number of threads of ITK. */
+  itkSetMacro( NumberOfThreads, unsigned int );
+  itkGetMacro( NumberOfThreads, unsigned int );
+
+  /** \brief Set/Get whether statistics of a modified planar figure are
+   * updated from the pixels that changed, instead of being recomputed.
+   *
+   * The update is only incremental if the figure stays on the same slice of
+   * the same image and no pixel at the current minimum or maximum leaves the
+   * figure; otherwise, statistics are recomputed. Enabled by default. */
+  itkSetMacro( IncrementalPlanarFigureUpdate, bool );
+  itkGetMacro( IncrementalPlanarFigureUpdate, bool );
+  itkBooleanMacro( IncrementalPlanarFigureUpdate );
+
+  /** \brief Returns true if the last call of ComputeStatistics() updated the
+   * planar figure statistics incrementally. */
+  itkGetMacro( LastUpdateWasIncremental, bool );
+
   /** \brief Compute statistics (together with histogram) for the current
    * masking mode.
    *
@@ -183,6 +215,68 @@ protected:
   typedef itk::Image< unsigned short, 3 > MaskImage3DType;
   typedef itk::Image< unsigned short, 2 > MaskImage2DType;
 
+  /** \brief Bin boundaries of a histogram with equally sized bins; taken
+   * from an itk::Statistics::Histogram, so that values are binned exactly
+   * as they would be by ITK. */
+  struct HistogramBinning
+  {
+    HistogramBinning();
+
+    void Initialize( unsigned int numberOfBins, double lowerBound, double upperBound );
+
+    unsigned int GetBin( double value ) const;
+
+    /** \brief Median estimated as center of the bin containing the half of all counts. */
+    double GetMedian( const std::vector< double > &frequencies, double count ) const;
+
+    HistogramType::Pointer CreateHistogram( const std::vector< double > &frequencies ) const;
+
+    unsigned int NumberOfBins;
+    double LowerBound;
+    double UpperBound;
+    std::vector< double > BinMins;
+    std::vector< double > BinMaxs;
+  };
+
+  /** \brief Moments, extrema and histogram of the pixels of one label.
+   *
+   * Offsets refer to the buffer of the accumulated image; on equal values,
+   * the smaller offset is kept so that the first extremal pixel in scan order
+   * is found independent of how the image was split among threads. */
+  struct LabelAccumulator
+  {
+    LabelAccumulator();
+
+    void Add( double value, long offset, unsigned int bin );
+
+    /** \brief Returns false if the value cannot be removed without invalidating the extrema. */
+    bool Remove( double value, unsigned int bin );
+
+    void Merge( const LabelAccumulator &other );
+
+    unsigned long Count;
+    double Sum;
+    double SumOfSquares;
+    double Min;
+    double Max;
+    long MinOffset;
+    long MaxOffset;
+    std::vector< double > Histogram;
+  };
+
+  typedef std::map< unsigned short, LabelAccumulator > LabelAccumulatorMap;
+
+  template < typename TPixel, unsigned int VImageDimension >
+  struct AccumulateStatisticsThreadStruct
+  {
+    const itk::Image< TPixel, VImageDimension > *Image;
+    const itk::Image< unsigned short, VImageDimension > *Mask;
+    itk::ImageRegion< VImageDimension > Region;
+    const HistogramBinning *Binning;
+    unsigned int NumberOfSplits;
+    std::vector< LabelAccumulatorMap > Results;
+  };
+
   ImageStatisticsCalculator();
 
   virtual ~ImageStatisticsCalculator();
@@ -217,6 +311,44 @@ protected:
     StatisticsContainer* statisticsContainer,
     HistogramContainer* histogramContainer );
 
+  /** \brief Accumulates statistics of all pixels in region per label of
+   * maskImage (label 0 is skipped) in parallel. Without mask, all pixels are
+   * accumulated for label 1. */
+  template < typename TPixel, unsigned int VImageDimension >
+  void InternalAccumulateStatistics(
+    const itk::Image< TPixel, VImageDimension > *image,
+    const itk::Image< unsigned short, VImageDimension > *maskImage,
+    const itk::ImageRegion< VImageDimension > &region,
+    const HistogramBinning &binning,
+    LabelAccumulatorMap &accumulators );
+
+  template < typename TPixel, unsigned int VImageDimension >
+  static ITK_THREAD_RETURN_TYPE AccumulateStatisticsThreaderCallback( void *arg );
+
+  template < typename TPixel, unsigned int VImageDimension >
+  void InternalStatisticsFromAccumulators(
+    const itk::Image< TPixel, VImageDimension > *image,
+    const LabelAccumulatorMap &accumulators,
+    const HistogramBinning &binning,
+    StatisticsContainer* statisticsContainer,
+    HistogramContainer* histogramContainer );
+
+  /** \brief Updates the cached planar figure statistics from the pixels in
+   * which the current mask differs from the cached one; updated is set to
+   * false if the statistics need to be recomputed. */
+  template < typename TPixel, unsigned int VImageDimension >
+  void InternalUpdatePlanarFigureStatistics(
+    const itk::Image< TPixel, VImageDimension > *image,
+    StatisticsContainer* statisticsContainer,
+    HistogramContainer* histogramContainer,
+    bool *updated );
+
+  /** \brief Stores mask and accumulators of the current planar figure for
+   * incremental updates. */
+  void CachePlanarFigureStatistics( const LabelAccumulatorMap &accumulators, const HistogramBinning &binning );
+
+  bool IsPlanarFigureCacheValid( unsigned int timeStep ) const;
+
   template < typename TPixel, unsigned int VImageDimension >
   void InternalCalculateMaskFromPlanarFigure(
     const itk::Image< TPixel, VImageDimension > *image, unsigned int axis );
@@ -316,6 +448,26 @@ protected:
   bool m_DoIgnorePixelValue;
   bool m_IgnorePixelValueChanged;
 
+  unsigned int m_NumberOfThreads;
+
+  bool m_IncrementalPlanarFigureUpdate;
+  bool m_LastUpdateWasIncremental;
+
+  // State of the last planar figure statistics, used for incremental updates
+  bool m_PlanarFigureCacheValid;
+  unsigned int m_PlanarFigureCacheTimeStep;
+  unsigned int m_PlanarFigureCacheAxis;
+  unsigned int m_PlanarFigureCacheSlice;
+  unsigned long m_PlanarFigureCacheImageMTime;
+  bool m_PlanarFigureCacheDoIgnorePixelValue;
+  double m_PlanarFigureCacheIgnorePixelValue;
+  MaskImage2DType::Pointer m_PlanarFigureCacheMask;
+  MaskImage2DType::RegionType m_PlanarFigureCacheMaskBounds;
+  LabelAccumulatorMap m_PlanarFigureCacheAccumulators;
+  HistogramBinning m_PlanarFigureCacheBinning;
+
+  MaskImage2DType::RegionType m_PlanarFigureMaskBounds; // Region of the 2D mask covered by the PlanarFigure
+
   unsigned int m_PlanarFigureAxis;    // Normal axis for PlanarFigure
   unsigned int m_PlanarFigureSlice;   // Slice which contains PlanarFigure
   int m_PlanarFigureCoordinate0;      // First plane-axis for PlanarFigure
@@ -18,6 +18,12 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "mitkItkImageFileReader.h"
 #include "mitkException.h"
 
+#include <vtkPointLocator.h>
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+
+#include <cmath>
+
 bool CompareSurfacePointPositions(mitk::Surface::Pointer s1, mitk::Surface::Pointer s2)
 {
   vtkPoints* p1 = s1->GetVtkPolyData()->GetPoints();
@@ -38,6 +44,37 @@ bool CompareSurfacePointPositions(mitk::Surface::Pointer s1, mitk::Surface::Poin
   return false;
 }
 
+// true if every point of s2 has a point of s1 within tolerance and vice versa, regardless of the point order
+bool SamePointPositions(mitk::Surface::Pointer s1, mitk::Surface::Pointer s2, double tolerance)
+{
+  vtkPolyData* polyData[2] = { s1->GetVtkPolyData(), s2->GetVtkPolyData() };
+  if(polyData[0]->GetNumberOfPoints() != polyData[1]->GetNumberOfPoints())
+    return false;
+
+  for(int i = 0; i < 2; ++i)
+  {
+    vtkSmartPointer<vtkPointLocator> locator = vtkSmartPointer<vtkPointLocator>::New();
+    locator->SetDataSet(polyData[i]);
+    locator->BuildLocator();
+
+    vtkPoints* points = polyData[1 - i]->GetPoints();
+    for(vtkIdType j = 0; j < points->GetNumberOfPoints(); ++j)
+    {
+      double point[3];
+      points->GetPoint(j, point);
+      double closestPoint[3];
+      polyData[i]->GetPoint(locator->FindClosestPoint(point), closestPoint);
+      if(fabs(point[0] - closestPoint[0]) > tolerance ||
+        fabs(point[1] - closestPoint[1]) > tolerance ||
+        fabs(point[2] - closestPoint[2]) > tolerance )
+      {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
 int mitkImageToSurfaceFilterTest(int argc, char* argv[])
 {
   MITK_TEST_BEGIN("ImageToSurfaceFilterTest");
@@ -54,6 +91,8 @@ int mitkImageToSurfaceFilterTest(int argc, char* argv[])
   MITK_TEST_CONDITION_REQUIRED(testObject->GetSmooth() == false, "Testing initialization of smooth member variable");
   MITK_TEST_CONDITION_REQUIRED(testObject->GetDecimate() == mitk::ImageToSurfaceFilter::NoDecimation, "Testing initialization of decimate member variable");
   MITK_TEST_CONDITION_REQUIRED(testObject->GetTargetReduction() == 0.95f, "Testing initialization of target reduction member variable");
+  MITK_TEST_CONDITION_REQUIRED(testObject->GetSurfaceExtraction() == mitk::ImageToSurfaceFilter::MarchingCubes, "Testing initialization of surface extraction member variable");
+  MITK_TEST_CONDITION_REQUIRED(testObject->GetParallelSmoothing() == false, "Testing initialization of parallel smoothing member variable");
 
   // test cases excluded until bug 14530 is fixed, since wrong exception is caught!!
   //MITK_TEST_FOR_EXCEPTION_BEGIN(mitk::Exception)
@@ -76,6 +115,30 @@ int mitkImageToSurfaceFilterTest(int argc, char* argv[])
 
   mitk::Surface::Pointer testSurface1 = testObject->GetOutput()->Clone();
 
+  testObject->SetSurfaceExtraction(mitk::ImageToSurfaceFilter::ParallelFlyingEdges);
+  testObject->Update();
+  mitk::Surface::Pointer flyingEdgesSurface = testObject->GetOutput()->Clone();
+
+  MITK_TEST_CONDITION_REQUIRED(flyingEdgesSurface->GetVtkPolyData()->GetNumberOfPoints() == testSurface1->GetVtkPolyData()->GetNumberOfPoints() &&
+                               flyingEdgesSurface->GetVtkPolyData()->GetNumberOfPolys() == testSurface1->GetVtkPolyData()->GetNumberOfPolys(),
+                               "Testing that parallel flying edges creates as many points and triangles as marching cubes");
+  MITK_TEST_CONDITION(SamePointPositions(testSurface1, flyingEdgesSurface, 1e-4), "Testing that the points of parallel flying edges are at the positions of the marching cubes points");
+
+  // by default the flying edges surface is smoothed by vtkSmoothPolyDataFilter, like the marching cubes surface
+  testObject->SetSmooth(true);
+  testObject->Update();
+  mitk::Surface::Pointer smoothedFlyingEdgesSurface = testObject->GetOutput()->Clone();
+  MITK_TEST_CONDITION_REQUIRED( CompareSurfacePointPositions(flyingEdgesSurface, smoothedFlyingEdgesSurface), "Testing smoothing of flying edges surface changes point data!");
+  MITK_TEST_CONDITION(smoothedFlyingEdgesSurface->GetVtkPolyData()->GetNumberOfPolys() == flyingEdgesSurface->GetVtkPolyData()->GetNumberOfPolys(), "Testing smoothing keeps the triangles");
+
+  testObject->SetParallelSmoothing(true);
+  testObject->Update();
+  mitk::Surface::Pointer parallelSmoothedSurface = testObject->GetOutput()->Clone();
+  MITK_TEST_CONDITION_REQUIRED( CompareSurfacePointPositions(flyingEdgesSurface, parallelSmoothedSurface), "Testing parallel smoothing of surface changes point data!");
+  testObject->SetParallelSmoothing(false);
+  testObject->SetSmooth(false);
+  testObject->SetSurfaceExtraction(mitk::ImageToSurfaceFilter::MarchingCubes);
+
   testObject->SetDecimate(mitk::ImageToSurfaceFilter::DecimatePro);
   testObject->SetTargetReduction(0.5f);
   testObject->Update();
@@ -74,7 +74,8 @@ QmitkSlicesInterpolator::QmitkSlicesInterpolator(QWidget* parent, const char*  /
     m_LastSNC(0),
     m_LastSliceIndex(0),
     m_2DInterpolationEnabled(false),
-    m_3DInterpolationEnabled(false)
+    m_3DInterpolationEnabled(false),
+    m_3DInterpolationPending(false)
 {
 
   m_SurfaceInterpolator = mitk::SurfaceInterpolationController::GetInstance();
@@ -471,6 +472,16 @@ void QmitkSlicesInterpolator::OnSurfaceInterpolationFinished()
   {
     slicer->GetRenderer()->RequestUpdate();
   }
+
+  if (m_3DInterpolationPending)
+  {
+    // the contours changed while we were interpolating
+    m_3DInterpolationPending = false;
+    if (m_3DInterpolationEnabled)
+    {
+      this->Start3DInterpolation();
+    }
+  }
 }
 
 void QmitkSlicesInterpolator::OnAcceptInterpolationClicked()
@@ -750,6 +761,19 @@ void QmitkSlicesInterpolator::Run3DInterpolation()
   m_SurfaceInterpolator->Interpolate();
 }
 
+void QmitkSlicesInterpolator::Start3DInterpolation()
+{
+  if (m_Watcher.isRunning())
+  {
+    // don't block the GUI, the running interpolation is aborted by the controller and restarted when finished
+    m_3DInterpolationPending = true;
+    return;
+  }
+
+  m_Future = QtConcurrent::run(this, &QmitkSlicesInterpolator::Run3DInterpolation);
+  m_Watcher.setFuture(m_Future);
+}
+
 void QmitkSlicesInterpolator::StartUpdateInterpolationTimer()
 {
   m_Timer->start(500);
@@ -811,13 +835,9 @@ void QmitkSlicesInterpolator::On3DInterpolationActivated(bool on)
             ret = msgBox.exec();
           }
 
-          if (m_Watcher.isRunning())
-            m_Watcher.waitForFinished();
-
           if (ret == QMessageBox::Yes)
           {
-            m_Future = QtConcurrent::run(this, &QmitkSlicesInterpolator::Run3DInterpolation);
-            m_Watcher.setFuture(m_Future);
+            this->Start3DInterpolation();
           }
           else
           {
@@ -894,10 +914,7 @@ void QmitkSlicesInterpolator::OnSurfaceInterpolationInfoChanged(const itk::Event
 {
   if(m_3DInterpolationEnabled)
   {
-    if (m_Watcher.isRunning())
-      m_Watcher.waitForFinished();
-    m_Future = QtConcurrent::run(this, &QmitkSlicesInterpolator::Run3DInterpolation);
-    m_Watcher.setFuture(m_Future);
+    this->Start3DInterpolation();
   }
 }
 
@@ -943,10 +960,7 @@ void QmitkSlicesInterpolator:: SetCurrentContourListID()
 
         m_SurfaceInterpolator->SetCurrentSegmentationInterpolationList(dynamic_cast<mitk::Image*>(workingNode->GetData()));
 
-        if (m_Watcher.isRunning())
-          m_Watcher.waitForFinished();
-        m_Future = QtConcurrent::run(this, &QmitkSlicesInterpolator::Run3DInterpolation);
-        m_Watcher.setFuture(m_Future);
+        this->Start3DInterpolation();
       }
     }
     else
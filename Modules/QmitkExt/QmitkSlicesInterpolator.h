@@ -194,6 +194,12 @@ class QmitkExt_EXPORT QmitkSlicesInterpolator : public QWidget
 
     void AcceptAllInterpolations(mitk::SliceNavigationController* slicer);
 
+    /**
+      Starts the 3D interpolation in the background. If one is already running, it is started again
+      as soon as the running one has finished, so that several contour changes result in one new interpolation.
+    */
+    void Start3DInterpolation();
+
     /**
       Retrieves the currently selected PlaneGeometry from a SlicedGeometry3D that is generated by a SliceNavigationController
       and calls Interpolate to further process this PlaneGeometry into an interpolation.
@@ -257,6 +263,7 @@ private:
 
     bool m_2DInterpolationEnabled;
     bool m_3DInterpolationEnabled;
+    bool m_3DInterpolationPending;
     //unsigned int m_CurrentListID;
 
     mitk::DataStorage::Pointer m_DataStorage;
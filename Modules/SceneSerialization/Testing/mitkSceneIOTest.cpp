@@ -30,6 +30,9 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "Poco/File.h"
 #include "Poco/TemporaryFile.h"
 
+#include <clocale>
+#include <cmath>
+
 #ifndef WIN32
   #include <ulimit.h>
   #include <errno.h>
@@ -207,6 +210,62 @@ static void VerifyStorage(mitk::DataStorage* storage)
   MITK_TEST_CONDITION_REQUIRED(p[0] == 2.0 && p[1] == -3.0 && p[2] == 22.0, "Test Pointset entry 2 after loading");
 
 }
+// saving and loading under a locale with decimal comma, the writers have to write "C" numbers anyway
+static void TestSceneWithDecimalCommaLocale(const std::string& imageName, const std::string& surfaceName)
+{
+  std::string previousLocale = setlocale( LC_ALL, NULL );
+  const char* decimalCommaLocales[] = { "de_DE.UTF-8", "de_DE.utf8", "de_DE", "German_Germany.1252", "German" };
+  const char* decimalCommaLocale = NULL;
+  for (unsigned int i = 0; i < sizeof(decimalCommaLocales) / sizeof(decimalCommaLocales[0]) && decimalCommaLocale == NULL; ++i)
+  {
+    if ( setlocale( LC_ALL, decimalCommaLocales[i] ) != NULL && localeconv()->decimal_point[0] == ',' )
+    {
+      decimalCommaLocale = decimalCommaLocales[i];
+    }
+  }
+  if ( decimalCommaLocale == NULL )
+  {
+    setlocale( LC_ALL, previousLocale.c_str() );
+    MITK_TEST_OUTPUT( << "No locale with decimal comma available, skipping the locale test of SceneIO" );
+    return;
+  }
+  std::string currentLocale = setlocale( LC_ALL, NULL );
+
+  mitk::DataStorage::Pointer storage = mitk::StandaloneDataStorage::New().GetPointer();
+  FillStorage( storage, imageName, surfaceName );
+  mitk::Image::Pointer image = dynamic_cast<mitk::Image*>( storage->GetNamedNode("Pic3D")->GetData() );
+  mitk::Vector3D spacing = image->GetGeometry()->GetSpacing();
+  mitk::Point3D origin = image->GetGeometry()->GetOrigin();
+
+  mitk::SceneIO::Pointer sceneIO = mitk::SceneIO::New();
+  Poco::Path newname( Poco::TemporaryFile::tempName() );
+  std::string sceneFileName = std::string( MITK_TEST_OUTPUT_DIR ) + Poco::Path::separator() + newname.getFileName() + ".zip";
+  MITK_TEST_CONDITION_REQUIRED( sceneIO->SaveScene( storage->GetAll(), storage, sceneFileName ), "Saving scene file with locale " << decimalCommaLocale );
+  MITK_TEST_CONDITION( sceneIO->GetFailedNodes() != NULL && sceneIO->GetFailedNodes()->empty(), "Checking if all nodes have been saved with decimal comma locale" );
+  MITK_TEST_CONDITION( currentLocale == setlocale( LC_ALL, NULL ), "Checking that saving the scene restored the locale" );
+
+  sceneIO = mitk::SceneIO::New();
+  storage = sceneIO->LoadScene( sceneFileName, storage, true );
+  MITK_TEST_CONDITION( currentLocale == setlocale( LC_ALL, NULL ), "Checking that loading the scene restored the locale" );
+  VerifyStorage( storage );
+
+  mitk::Image::Pointer loadedImage = dynamic_cast<mitk::Image*>( storage->GetNamedNode("Pic3D")->GetData() );
+  mitk::Vector3D loadedSpacing = loadedImage->GetGeometry()->GetSpacing();
+  mitk::Point3D loadedOrigin = loadedImage->GetGeometry()->GetOrigin();
+  bool sameGeometry = true;
+  for (unsigned int i = 0; i < 3; ++i)
+  {
+    sameGeometry &= std::fabs( loadedSpacing[i] - spacing[i] ) < mitk::eps && std::fabs( loadedOrigin[i] - origin[i] ) < mitk::eps;
+  }
+  MITK_TEST_CONDITION( sameGeometry, "Spacing and origin of the image saved with decimal comma locale" );
+
+  setlocale( LC_ALL, previousLocale.c_str() );
+  if ( mitk::TestManager::GetInstance()->NumberOfFailedTests() == 0 )
+  {
+    Poco::File( sceneFileName ).remove();
+  }
+}
+
 }; // end test helper class
 
 int mitkSceneIOTest(int, char* argv[])
@@ -240,6 +299,9 @@ int mitkSceneIOTest(int, char* argv[])
 
     SceneIOTestClass::FillStorage(storage, argv[1], argv[2]);
 
+    // store larger files uncompressed, loading has to handle both kinds of zip entries
+    sceneIO->SetUncompressedFileSizeThreshold( 1024 );
+
     // attempt to save it
     Poco::Path newname( Poco::TemporaryFile::tempName() );
     sceneFileName = std::string( MITK_TEST_OUTPUT_DIR ) + Poco::Path::separator() + newname.getFileName() + ".zip";
@@ -334,6 +396,9 @@ int mitkSceneIOTest(int, char* argv[])
     SceneIOTestClass::VerifyStorage(storage);
 
   }
+
+  SceneIOTestClass::TestSceneWithDecimalCommaLocale( argv[1], argv[2] );
+
   // if no sub-test failed remove the scene file, otherwise it is kept for debugging purposes
   if ( mitk::TestManager::GetInstance()->NumberOfFailedTests() == 0 )
   {
@@ -21,6 +21,8 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 #include "mitkPropertyList.h"
 
+class TiXmlDocument;
+
 namespace mitk
 {
 
@@ -38,7 +40,15 @@ class SceneSerialization_EXPORT PropertyListDeserializer : public itk::Object
     itkGetStringMacro(Filename);
 
     /**
-      \brief Reads a propertylist from file
+      \brief XML text of the property list, read instead of the file Filename if not empty.
+
+      Scene files pass the contents of their zip members here. Filename is then only used in messages.
+      */
+    itkSetStringMacro(Content);
+    itkGetStringMacro(Content);
+
+    /**
+      \brief Reads a propertylist from Content or from file
       \return success of deserialization
       */
     virtual bool Deserialize();
@@ -50,7 +60,11 @@ class SceneSerialization_EXPORT PropertyListDeserializer : public itk::Object
     PropertyListDeserializer();
     virtual ~PropertyListDeserializer();
 
+    /// Parses Content or the file Filename into document
+    bool LoadDocument( TiXmlDocument& document );
+
     std::string m_Filename;
+    std::string m_Content;
     PropertyList::Pointer m_PropertyList;
 };
 
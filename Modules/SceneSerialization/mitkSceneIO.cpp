@@ -16,14 +16,16 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 #include <Poco/TemporaryFile.h>
 #include <Poco/Path.h>
-#include <Poco/Delegate.h>
+#include <Poco/DateTime.h>
+#include <Poco/DirectoryIterator.h>
+#include <Poco/Exception.h>
 #include <Poco/Zip/Compress.h>
-#include <Poco/Zip/Decompress.h>
 
 #include "mitkSceneIO.h"
 #include "mitkBaseDataSerializer.h"
 #include "mitkPropertyListSerializer.h"
 #include "mitkSceneReader.h"
+#include "mitkSceneZipArchive.h"
 
 #include "mitkProgressBar.h"
 #include "mitkBaseRenderer.h"
@@ -35,6 +37,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 #include <tinyxml.h>
 
+#include <algorithm>
 #include <fstream>
 #include <sstream>
 
@@ -42,7 +45,8 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 mitk::SceneIO::SceneIO()
 :m_WorkingDirectory(""),
- m_UnzipErrors(0)
+ m_NumberOfThreads( 1 ),
+ m_UncompressedFileSizeThreshold(1024 * 1024)
 {
 }
 
@@ -123,52 +127,36 @@ mitk::DataStorage::Pointer mitk::SceneIO::LoadScene( const std::string& filename
     return NULL;
   }
 
-  // get new temporary directory
-  m_WorkingDirectory = CreateEmptyTempDirectory();
-  if (m_WorkingDirectory.empty())
-  {
-    MITK_ERROR << "Could not create temporary directory. Cannot open scene files.";
-    return NULL;
-  }
-
-  // unzip all filenames contents to temp dir
-  m_UnzipErrors = 0;
-  Poco::Zip::Decompress unzipper( file, Poco::Path( m_WorkingDirectory ) );
-  unzipper.EError += Poco::Delegate<SceneIO, std::pair<const Poco::Zip::ZipLocalFileHeader, const std::string> >(this, &SceneIO::OnUnzipError);
-  unzipper.EOk    += Poco::Delegate<SceneIO, std::pair<const Poco::Zip::ZipLocalFileHeader, const Poco::Path> >(this, &SceneIO::OnUnzipOk);
-  unzipper.decompressAllFiles();
-  unzipper.EError -= Poco::Delegate<SceneIO, std::pair<const Poco::Zip::ZipLocalFileHeader, const std::string> >(this, &SceneIO::OnUnzipError);
-  unzipper.EOk    -= Poco::Delegate<SceneIO, std::pair<const Poco::Zip::ZipLocalFileHeader, const Poco::Path> >(this, &SceneIO::OnUnzipOk);
-
-  if ( m_UnzipErrors )
+  // read index.xml and the files it refers to directly from the zip file
+  try
   {
-    MITK_ERROR << "There were " << m_UnzipErrors << " errors unzipping '" << filename << "'. Will attempt to read whatever could be unzipped.";
-  }
+    SceneZipArchive archive( file );
 
-  // test if index.xml exists
-  // parse index.xml with TinyXML
-  TiXmlDocument document( m_WorkingDirectory + Poco::Path::separator() + "index.xml" );
-  if (!document.LoadFile())
-  {
-    MITK_ERROR << "Could not open/read/parse " << m_WorkingDirectory << "/index.xml\nTinyXML reports: " << document.ErrorDesc() << std::endl;
-    return NULL;
-  }
+    std::string index;
+    if ( !archive.ReadMember( "index.xml", index ) )
+    {
+      MITK_ERROR << "Could not read index.xml from " << filename;
+      return NULL;
+    }
 
-  SceneReader::Pointer reader = SceneReader::New();
-  if ( !reader->LoadScene( document, m_WorkingDirectory, storage ) )
-  {
-    MITK_ERROR << "There were errors while loading scene file " << filename << ". Your data may be corrupted";
-  }
+    TiXmlDocument document;
+    document.Parse( index.c_str() );
+    if ( document.Error() )
+    {
+      MITK_ERROR << "Could not parse index.xml of " << filename << "\nTinyXML reports: " << document.ErrorDesc() << std::endl;
+      return NULL;
+    }
 
-  // delete temp directory
-  try
-  {
-    Poco::File deleteDir( m_WorkingDirectory );
-    deleteDir.remove(true); // recursive
+    SceneReader::Pointer reader = SceneReader::New();
+    if ( !reader->LoadScene( document, archive, storage ) )
+    {
+      MITK_ERROR << "There were errors while loading scene file " << filename << ". Your data may be corrupted";
+    }
   }
-  catch(...)
+  catch ( Poco::Exception& e )
   {
-    MITK_ERROR << "Could not delete temporary directory " << m_WorkingDirectory;
+    MITK_ERROR << "Could not read zip file '" << filename << "': " << e.displayText();
+    return NULL;
   }
 
   // return new data storage, even if empty or uncomplete (return as much as possible but notify calling method)
@@ -201,6 +189,8 @@ bool mitk::SceneIO::SaveScene( DataStorage::SetOfObjects::ConstPointer sceneNode
 
     m_FailedNodes = DataStorage::SetOfObjects::New();
     m_FailedProperties = PropertyList::New();
+    m_WorkingDirectory = "";
+    m_MemoryFiles.clear();
 
     // start XML DOM
     TiXmlDocument document;
@@ -228,6 +218,7 @@ bool mitk::SceneIO::SaveScene( DataStorage::SetOfObjects::ConstPointer sceneNode
 
     MITK_INFO << "Storing scene with " << sceneNodes->size() << " objects to " << filename;
 
+      // only the BaseData serializers need a directory, they cannot write to a stream
       m_WorkingDirectory = CreateEmptyTempDirectory();
       if (m_WorkingDirectory.empty())
       {
@@ -246,6 +237,9 @@ bool mitk::SceneIO::SaveScene( DataStorage::SetOfObjects::ConstPointer sceneNode
 
       UIDGenerator nodeUIDGen("OBJECT_");
 
+      // BaseData is written after the XML structure is complete, several objects at a time
+      std::vector<SerializationJob> jobs;
+
       for (DataStorage::SetOfObjects::const_iterator iter = sceneNodes->begin();
            iter != sceneNodes->end();
            ++iter)
@@ -317,13 +311,19 @@ bool mitk::SceneIO::SaveScene( DataStorage::SetOfObjects::ConstPointer sceneNode
           // store basedata
           if ( BaseData* data = node->GetData() )
           {
-            //std::string filenameHint( node->GetName() );
-            bool error(false);
-            TiXmlElement* dataElement( SaveBaseData( data, filenameHint, error ) ); // returns a reference to a file
-            if (error)
+            SerializationJob job;
+            job.m_Element = PrepareBaseData( data, filenameHint, job.m_Serializer ); // file reference is added by SerializeThread()
+            job.m_Node = node;
+            job.m_Error = false;
+            if ( job.m_Serializer.IsNull() )
             {
               m_FailedNodes->push_back( node );
             }
+            else
+            {
+              jobs.push_back( job );
+            }
+            TiXmlElement* dataElement( job.m_Element );
 
             // store basedata properties
             PropertyList* propertyList = data->GetPropertyList();
@@ -373,36 +373,69 @@ bool mitk::SceneIO::SaveScene( DataStorage::SetOfObjects::ConstPointer sceneNode
         ProgressBar::GetInstance()->Progress();
       } // end for all nodes
 
-    } // end if sceneNodes
-
-    if ( !document.SaveFile( m_WorkingDirectory + Poco::Path::separator() + "index.xml" ) )
-    {
-      MITK_ERROR << "Could not write scene to " << m_WorkingDirectory << Poco::Path::separator() << "index.xml" << "\nTinyXML reports '" << document.ErrorDesc() << "'";
-      return false;
-    }
-    else
-    {
-      try
+      if ( !jobs.empty() )
       {
-        Poco::File deleteFile( filename.c_str() );
-        if (deleteFile.exists())
-        {
-          deleteFile.remove();
-        }
+        ProgressBar::GetInstance()->AddStepsToDo( jobs.size() );
+
+        SerializationThreadData threadData;
+        threadData.m_Jobs = &jobs;
+        threadData.m_NextJob = 0;
 
-        // create zip at filename
-        std::ofstream file( filename.c_str(), std::ios::binary | std::ios::out);
-        if (!file.good())
+        unsigned int numberOfThreads = std::min<unsigned int>( std::max( m_NumberOfThreads, 1u ), jobs.size() );
+        if ( numberOfThreads > 1 )
         {
-          MITK_ERROR << "Could not open a zip file for writing: '" << filename << "'";
+          itk::MultiThreader::Pointer threader = itk::MultiThreader::New();
+          threader->SetNumberOfThreads( numberOfThreads );
+          threader->SetSingleMethod( SerializeThread, &threadData );
+          threader->SingleMethodExecute();
         }
         else
         {
-          Poco::Zip::Compress zipper( file, true );
-          Poco::Path tmpdir( m_WorkingDirectory );
-          zipper.addRecursive( tmpdir );
-          zipper.close();
+          itk::MultiThreader::ThreadInfoStruct threadInfo;
+          threadInfo.UserData = &threadData;
+          SerializeThread( &threadInfo );
+        }
+
+        for ( std::vector<SerializationJob>::iterator jobIter = jobs.begin(); jobIter != jobs.end(); ++jobIter )
+        {
+          if ( jobIter->m_Error )
+          {
+            m_FailedNodes->push_back( jobIter->m_Node );
+          }
         }
+
+        ProgressBar::GetInstance()->Progress( jobs.size() );
+      }
+
+    } // end if sceneNodes
+
+    // index.xml and the property lists are written from memory
+    TiXmlPrinter printer;
+    document.Accept( &printer );
+    m_MemoryFiles.push_back( std::make_pair( std::string("index.xml"), std::string( printer.Str() ) ) );
+
+    try
+    {
+      Poco::File deleteFile( filename.c_str() );
+      if (deleteFile.exists())
+      {
+        deleteFile.remove();
+      }
+
+      // create zip at filename
+      std::ofstream file( filename.c_str(), std::ios::binary | std::ios::out);
+      if (!file.good())
+      {
+        MITK_ERROR << "Could not open a zip file for writing: '" << filename << "'";
+      }
+      else
+      {
+        WriteZipFile( file );
+      }
+      m_MemoryFiles.clear();
+
+      if ( !m_WorkingDirectory.empty() )
+      {
         try
         {
           Poco::File deleteDir( m_WorkingDirectory );
@@ -414,13 +447,13 @@ bool mitk::SceneIO::SaveScene( DataStorage::SetOfObjects::ConstPointer sceneNode
           return false; // ok?
         }
       }
-      catch(std::exception& e)
-      {
-        MITK_ERROR << "Could not create ZIP file from " << m_WorkingDirectory << "\nReason: " << e.what();
-        return false;
-      }
-      return true;
     }
+    catch(std::exception& e)
+    {
+      MITK_ERROR << "Could not create ZIP file " << filename << "\nReason: " << e.what();
+      return false;
+    }
+    return true;
   }
   catch(std::exception& e)
   {
@@ -430,10 +463,34 @@ bool mitk::SceneIO::SaveScene( DataStorage::SetOfObjects::ConstPointer sceneNode
 }
 
 
-TiXmlElement* mitk::SceneIO::SaveBaseData( BaseData* data, const std::string& filenamehint, bool& error )
+ITK_THREAD_RETURN_TYPE mitk::SceneIO::SerializeThread( void* pInfoStruct )
+{
+  itk::MultiThreader::ThreadInfoStruct* threadInfo = static_cast<itk::MultiThreader::ThreadInfoStruct*>( pInfoStruct );
+  SerializationThreadData* threadData = static_cast<SerializationThreadData*>( threadInfo->UserData );
+
+  while (true)
+  {
+    // objects differ a lot in size, so threads fetch the next job when they are done
+    threadData->m_Mutex.Lock();
+    unsigned int jobIndex = threadData->m_NextJob++;
+    threadData->m_Mutex.Unlock();
+
+    if ( jobIndex >= threadData->m_Jobs->size() )
+    {
+      break;
+    }
+
+    SerializationJob& job = (*threadData->m_Jobs)[jobIndex];
+    job.m_Error = !SerializeBaseData( job.m_Serializer, job.m_Element );
+  }
+
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+TiXmlElement* mitk::SceneIO::PrepareBaseData( BaseData* data, const std::string& filenamehint, itk::SmartPointer<BaseDataSerializer>& serializer )
 {
   assert(data);
-  error = true;
+  serializer = NULL;
 
   // find correct serializer
   // the serializer must
@@ -456,26 +513,86 @@ TiXmlElement* mitk::SceneIO::SaveBaseData( BaseData* data, const std::string& fi
         iter != thingsThatCanSerializeThis.end();
         ++iter )
   {
-    if (BaseDataSerializer* serializer = dynamic_cast<BaseDataSerializer*>( iter->GetPointer() ) )
+    if (BaseDataSerializer* candidate = dynamic_cast<BaseDataSerializer*>( iter->GetPointer() ) )
+    {
+      candidate->SetData(data);
+      candidate->SetFilenameHint(filenamehint);
+      candidate->SetWorkingDirectory( m_WorkingDirectory );
+      serializer = candidate;
+      break;
+    }
+  }
+
+  return element;
+}
+
+bool mitk::SceneIO::SerializeBaseData( BaseDataSerializer* serializer, TiXmlElement* element )
+{
+  try
+  {
+    std::string writtenfilename = serializer->Serialize();
+    element->SetAttribute("file", writtenfilename);
+    return true;
+  }
+  catch (std::exception& e)
+  {
+    MITK_ERROR << "Serializer " << serializer->GetNameOfClass() << " failed: " << e.what();
+  }
+  return false;
+}
+
+TiXmlElement* mitk::SceneIO::SaveBaseData( BaseData* data, const std::string& filenamehint, bool& error )
+{
+  BaseDataSerializer::Pointer serializer;
+  TiXmlElement* element = PrepareBaseData( data, filenamehint, serializer );
+  error = serializer.IsNull() || !SerializeBaseData( serializer, element );
+
+  return element;
+}
+
+static void AddDirectoryToZip( Poco::Zip::Compress& zipper, const Poco::Path& directory, const Poco::Path& nameInZip, unsigned long uncompressedFileSizeThreshold )
+{
+  Poco::DirectoryIterator end;
+  for ( Poco::DirectoryIterator iter( directory ); iter != end; ++iter )
+  {
+    Poco::Path name( nameInZip );
+    if ( iter->isDirectory() )
+    {
+      name.pushDirectory( iter.name() );
+      AddDirectoryToZip( zipper, Poco::Path( iter.path() ).makeDirectory(), name, uncompressedFileSizeThreshold );
+    }
+    else
     {
-      serializer->SetData(data);
-      serializer->SetFilenameHint(filenamehint);
-      serializer->SetWorkingDirectory( m_WorkingDirectory );
-      try
+      name.setFileName( iter.name() );
+      if ( uncompressedFileSizeThreshold > 0 && iter->getSize() >= uncompressedFileSizeThreshold )
       {
-        std::string writtenfilename = serializer->Serialize();
-        element->SetAttribute("file", writtenfilename);
-        error = false;
+        zipper.addFile( iter.path(), name, Poco::Zip::ZipCommon::CM_STORE );
       }
-      catch (std::exception& e)
+      else
       {
-        MITK_ERROR << "Serializer " << serializer->GetNameOfClass() << " failed: " << e.what();
+        zipper.addFile( iter.path(), name );
       }
-      break;
     }
   }
+}
 
-  return element;
+void mitk::SceneIO::WriteZipFile( std::ostream& file )
+{
+  Poco::Zip::Compress zipper( file, true );
+
+  // equivalent to addRecursive(), but with a choice of compression per file
+  if ( !m_WorkingDirectory.empty() )
+  {
+    AddDirectoryToZip( zipper, Poco::Path( m_WorkingDirectory ).makeDirectory(), Poco::Path(), m_UncompressedFileSizeThreshold );
+  }
+
+  for ( MemoryFileList::const_iterator iter = m_MemoryFiles.begin(); iter != m_MemoryFiles.end(); ++iter )
+  {
+    std::istringstream content( iter->second );
+    zipper.addFile( content, Poco::DateTime(), Poco::Path( iter->first ) );
+  }
+
+  zipper.close();
 }
 
 TiXmlElement* mitk::SceneIO::SavePropertyList( PropertyList* propertyList, const std::string& filenamehint)
@@ -489,12 +606,17 @@ TiXmlElement* mitk::SceneIO::SavePropertyList( PropertyList* propertyList, const
   PropertyListSerializer::Pointer serializer = PropertyListSerializer::New();
 
   serializer->SetPropertyList(propertyList);
-  serializer->SetFilenameHint(filenamehint);
-  serializer->SetWorkingDirectory( m_WorkingDirectory );
   try
   {
-    std::string writtenfilename = serializer->Serialize();
-    element->SetAttribute("file", writtenfilename);
+    std::ostringstream filename;
+    filename << "properties" << m_MemoryFiles.size() << "_" << itksys::SystemTools::MakeCindentifier( filenamehint.c_str() ) << ".xml";
+
+    std::string content = serializer->SerializeToString();
+    if ( !content.empty() )
+    {
+      m_MemoryFiles.push_back( std::make_pair( filename.str(), content ) );
+      element->SetAttribute("file", filename.str());
+    }
     PropertyList::Pointer failedProperties = serializer->GetFailedProperties();
     if (failedProperties.IsNotNull())
     {
@@ -520,14 +642,3 @@ const mitk::PropertyList* mitk::SceneIO::GetFailedProperties()
 {
   return m_FailedProperties;
 }
-
-void mitk::SceneIO::OnUnzipError(const void*  /*pSender*/, std::pair<const Poco::Zip::ZipLocalFileHeader, const std::string>& info)
-{
-  ++m_UnzipErrors;
-  MITK_ERROR << "Error while unzipping: " << info.second;
-}
-
-void mitk::SceneIO::OnUnzipOk(const void*  /*pSender*/, std::pair<const Poco::Zip::ZipLocalFileHeader, const Poco::Path>& /*info*/)
-{
-  // MITK_INFO << "Unzipped ok: " << info.second.toString();
-}
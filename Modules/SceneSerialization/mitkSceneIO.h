@@ -22,7 +22,12 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "mitkDataStorage.h"
 #include "mitkNodePredicateBase.h"
 
-#include <Poco/Zip/ZipLocalFileHeader.h>
+#include <itkMultiThreader.h>
+#include <itkSimpleFastMutexLock.h>
+
+#include <string>
+#include <utility>
+#include <vector>
 
 class TiXmlElement;
 
@@ -30,6 +35,7 @@ namespace mitk
 {
 
 class BaseData;
+class BaseDataSerializer;
 class PropertyList;
 
 class SceneSerialization_EXPORT SceneIO : public itk::Object
@@ -46,7 +52,9 @@ class SceneSerialization_EXPORT SceneIO : public itk::Object
      * \return DataStorage with all scene objects and their relations. If loading failed, query GetFailedNodes() and GetFailedProperties() for more detail.
      *
      * Attempts to read the provided file and create objects with
-     * parent/child relations into a DataStorage.
+     * parent/child relations into a DataStorage. The files of the scene are read
+     * directly from the zip file, only the BaseData of one node at a time is
+     * decompressed to a temporary file for its reader.
      *
      * \param filename full filename of the scene file
      * \param storage If given, this DataStorage is used instead of a newly created one
@@ -92,6 +100,26 @@ class SceneSerialization_EXPORT SceneIO : public itk::Object
      */
     const PropertyList* GetFailedProperties();
 
+    /**
+     * \brief Number of threads that write the BaseData of different nodes concurrently in SaveScene().
+     *
+     * Defaults to 1, i.e. one node after the other. Several writers (e.g. ImageWriter) switch the process wide
+     * locale to "C" while they write and restore it afterwards, which is not safe if they run concurrently.
+     * Only use more threads if the serializers of the scene do not change the locale.
+     * LoadScene() reads all nodes on the calling thread, because the readers report their progress to the GUI.
+     */
+    itkSetMacro( NumberOfThreads, unsigned int );
+    itkGetConstMacro( NumberOfThreads, unsigned int );
+
+    /**
+     * \brief Files of at least this many bytes are stored without compression in the scene file.
+     *
+     * Images are written as gzip compressed NRRD files already, compressing them a second time
+     * takes long and gains little. Storing them also makes loading faster. Defaults to 1 MB, 0 compresses all files.
+     */
+    itkSetMacro( UncompressedFileSizeThreshold, unsigned long );
+    itkGetConstMacro( UncompressedFileSizeThreshold, unsigned long );
+
   protected:
 
     SceneIO();
@@ -99,17 +127,51 @@ class SceneSerialization_EXPORT SceneIO : public itk::Object
 
     std::string CreateEmptyTempDirectory();
 
+    /// BaseData of one node, written by one of the threads in SaveScene()
+    struct SerializationJob
+    {
+      itk::SmartPointer<BaseDataSerializer> m_Serializer;
+      TiXmlElement* m_Element;
+      DataNode* m_Node;
+      bool m_Error;
+    };
+
+    struct SerializationThreadData
+    {
+      std::vector<SerializationJob>* m_Jobs;
+      unsigned int m_NextJob;
+      itk::SimpleFastMutexLock m_Mutex;
+    };
+
+    static ITK_THREAD_RETURN_TYPE SerializeThread( void* pInfoStruct );
+
+    /**
+     * \brief Creates the <data> element for data and a serializer that is ready to write it.
+     *
+     * The serializer is NULL if there is none for this type of data.
+     */
+    TiXmlElement* PrepareBaseData( BaseData* data, const std::string& filenamehint, itk::SmartPointer<BaseDataSerializer>& serializer );
+
+    /// Runs serializer and stores the written file's name in element
+    static bool SerializeBaseData( BaseDataSerializer* serializer, TiXmlElement* element );
+
+    /// Adds all files of the working directory and all files in m_MemoryFiles to the zip file
+    void WriteZipFile( std::ostream& file );
+
     TiXmlElement* SaveBaseData( BaseData* data, const std::string& filenamehint, bool& error);
     TiXmlElement* SavePropertyList( PropertyList* propertyList, const std::string& filenamehint );
 
-    void OnUnzipError(const void* pSender, std::pair<const Poco::Zip::ZipLocalFileHeader, const std::string>& info);
-    void OnUnzipOk(const void* pSender, std::pair<const Poco::Zip::ZipLocalFileHeader, const Poco::Path>& info);
-
     FailedBaseDataListType::Pointer m_FailedNodes;
     PropertyList::Pointer           m_FailedProperties;
 
-    std::string  m_WorkingDirectory;
-    unsigned int m_UnzipErrors;
+    /// name and contents of the files that go into the zip file without a detour through m_WorkingDirectory
+    typedef std::vector< std::pair<std::string, std::string> > MemoryFileList;
+
+    std::string    m_WorkingDirectory;
+    MemoryFileList m_MemoryFiles;
+
+    unsigned int  m_NumberOfThreads;
+    unsigned long m_UncompressedFileSizeThreshold;
 };
 
 }
@@ -16,7 +16,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 #include "mitkSceneReader.h"
 
-bool mitk::SceneReader::LoadScene( TiXmlDocument& document, const std::string& workingDirectory, DataStorage* storage )
+bool mitk::SceneReader::LoadScene( TiXmlDocument& document, SceneZipArchive& archive, DataStorage* storage )
 {
   // find version node --> note version in some variable
   int fileVersion = 1;
@@ -25,7 +25,7 @@ bool mitk::SceneReader::LoadScene( TiXmlDocument& document, const std::string& w
   {
     if ( versionObject->QueryIntAttribute( "FileVersion", &fileVersion ) != TIXML_SUCCESS )
     {
-      MITK_ERROR << "Scene file " << workingDirectory + "/index.xml" << " does not contain version information! Trying version 1 format." << std::endl;
+      MITK_ERROR << "Scene file index.xml does not contain version information! Trying version 1 format." << std::endl;
     }
   }
 
@@ -48,9 +48,9 @@ bool mitk::SceneReader::LoadScene( TiXmlDocument& document, const std::string& w
   {
     if (SceneReader* reader = dynamic_cast<SceneReader*>( iter->GetPointer() ) )
     {
-      if ( !reader->LoadScene( document, workingDirectory, storage ) )
+      if ( !reader->LoadScene( document, archive, storage ) )
       {
-        MITK_ERROR << "There were errors while loading scene file " << workingDirectory + "/index.xml. Your data may be corrupted";
+        MITK_ERROR << "There were errors while loading scene file index.xml. Your data may be corrupted";
         return false;
       }
       else
@@ -21,6 +21,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <itkObjectFactory.h>
 
 #include "mitkDataStorage.h"
+#include "mitkSceneZipArchive.h"
 
 namespace mitk
 {
@@ -32,7 +33,10 @@ class SceneSerialization_EXPORT SceneReader : public itk::Object
     mitkClassMacro( SceneReader, itk::Object );
     itkNewMacro( Self );
 
-    virtual bool LoadScene( TiXmlDocument& document, const std::string& workingDirectory, DataStorage* storage );
+    /**
+      \brief Creates the nodes described by document, reading their files from archive
+    */
+    virtual bool LoadScene( TiXmlDocument& document, SceneZipArchive& archive, DataStorage* storage );
 };
 
 }
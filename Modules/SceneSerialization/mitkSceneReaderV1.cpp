@@ -20,12 +20,12 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "mitkBaseRenderer.h"
 #include "mitkPropertyListDeserializer.h"
 #include "mitkProgressBar.h"
-#include "Poco/Path.h"
+#include "Poco/File.h"
 #include <mitkRenderingModeProperty.h>
 
 MITK_REGISTER_SERIALIZER(SceneReaderV1)
 
-bool mitk::SceneReaderV1::LoadScene( TiXmlDocument& document, const std::string& workingDirectory, DataStorage* storage )
+bool mitk::SceneReaderV1::LoadScene( TiXmlDocument& document, SceneZipArchive& archive, DataStorage* storage )
 {
   assert(storage);
   bool error(false);
@@ -46,11 +46,11 @@ bool mitk::SceneReaderV1::LoadScene( TiXmlDocument& document, const std::string&
   for( TiXmlElement* element = document.FirstChildElement("node"); element != NULL; element = element->NextSiblingElement("node") )
   {
     ++listSize;
-    DataNodes.push_back( LoadBaseDataFromDataTag( element->FirstChildElement("data"), workingDirectory, error ) );
+    DataNodes.push_back( LoadBaseDataFromDataTag( element->FirstChildElement("data"), archive, error ) );
   }
 
   OrderedLayers orderedLayers;
-  this->GetLayerOrder(document, workingDirectory, DataNodes, orderedLayers);
+  this->GetLayerOrder(document, archive, DataNodes, orderedLayers);
 
   ProgressBar::GetInstance()->AddStepsToDo( listSize );
 
@@ -68,7 +68,7 @@ bool mitk::SceneReaderV1::LoadScene( TiXmlDocument& document, const std::string&
       TiXmlElement *baseDataElement = dataXmlElement->FirstChildElement("properties");
       if ( node->GetData() )
       {
-        DecorateBaseDataWithProperties( node->GetData(), baseDataElement, workingDirectory);
+        DecorateBaseDataWithProperties( node->GetData(), baseDataElement, archive);
       }
       else
       {
@@ -96,7 +96,7 @@ bool mitk::SceneReaderV1::LoadScene( TiXmlDocument& document, const std::string&
     //        - instantiate the appropriate PropertyListDeSerializer
     //        - use them to construct PropertyList objects
     //        - add these properties to the node (if necessary, use renderwindow name)
-    bool success = DecorateNodeWithProperties(node, element, workingDirectory);
+    bool success = DecorateNodeWithProperties(node, element, archive);
     if (!success)
     {
       MITK_ERROR << "Could not load properties for node.";
@@ -207,7 +207,7 @@ bool mitk::SceneReaderV1::LoadScene( TiXmlDocument& document, const std::string&
   return !error;
 }
 
-void mitk::SceneReaderV1::GetLayerOrder(TiXmlDocument& document, const std::string& workingDirectory, std::vector<mitk::DataNode::Pointer> DataNodes, OrderedLayers& order)
+void mitk::SceneReaderV1::GetLayerOrder(TiXmlDocument& document, SceneZipArchive& archive, std::vector<mitk::DataNode::Pointer> DataNodes, OrderedLayers& order)
 {
   typedef std::vector<mitk::DataNode::Pointer> DataNodeVector;
   DataNodeVector::iterator nit = DataNodes.begin();
@@ -215,7 +215,7 @@ void mitk::SceneReaderV1::GetLayerOrder(TiXmlDocument& document, const std::stri
   {
     bool error(false);
     DataNode::Pointer node = *nit;
-    DecorateNodeWithProperties(node, element, workingDirectory);
+    DecorateNodeWithProperties(node, element, archive);
 
     int layer;
     node->GetIntProperty("layer", layer);
@@ -237,7 +237,7 @@ void mitk::SceneReaderV1::GetLayerOrder(TiXmlDocument& document, const std::stri
   }
 }
 
-mitk::DataNode::Pointer mitk::SceneReaderV1::LoadBaseDataFromDataTag( TiXmlElement* dataElement, const std::string& workingDirectory, bool& error )
+mitk::DataNode::Pointer mitk::SceneReaderV1::LoadBaseDataFromDataTag( TiXmlElement* dataElement, SceneZipArchive& archive, bool& error )
 {
   DataNode::Pointer node;
 
@@ -246,24 +246,43 @@ mitk::DataNode::Pointer mitk::SceneReaderV1::LoadBaseDataFromDataTag( TiXmlEleme
     const char* filename( dataElement->Attribute("file") );
     if ( filename )
     {
-      DataNodeFactory::Pointer factory = DataNodeFactory::New();
-      factory->SetFileName( workingDirectory + Poco::Path::separator() + filename );
-
-      try
-      {
-        factory->Update();
-        node = factory->GetOutput();
-      }
-      catch (std::exception& e)
+      // only this member is on disk, and only while it is read
+      std::string extractedFilename = archive.ExtractMember( filename );
+      if ( extractedFilename.empty() )
       {
-        MITK_ERROR << "Error during attempt to read '" << filename << "'. Exception says: " << e.what();
+        MITK_ERROR << "Error during attempt to read '" << filename << "'. Could not extract it from the scene file.";
         error = true;
       }
-
-      if (node.IsNull())
+      else
       {
-        MITK_ERROR << "Error during attempt to read '" << filename << "'. Factory returned NULL object.";
-        error = true;
+        DataNodeFactory::Pointer factory = DataNodeFactory::New();
+        factory->SetFileName( extractedFilename );
+
+        try
+        {
+          factory->Update();
+          node = factory->GetOutput();
+        }
+        catch (std::exception& e)
+        {
+          MITK_ERROR << "Error during attempt to read '" << filename << "'. Exception says: " << e.what();
+          error = true;
+        }
+
+        if (node.IsNull())
+        {
+          MITK_ERROR << "Error during attempt to read '" << filename << "'. Factory returned NULL object.";
+          error = true;
+        }
+
+        try
+        {
+          Poco::File( extractedFilename ).remove();
+        }
+        catch(...)
+        {
+          MITK_ERROR << "Could not delete temporary file " << extractedFilename;
+        }
       }
     }
   }
@@ -277,7 +296,7 @@ mitk::DataNode::Pointer mitk::SceneReaderV1::LoadBaseDataFromDataTag( TiXmlEleme
   return node;
 }
 
-bool mitk::SceneReaderV1::DecorateNodeWithProperties(DataNode* node, TiXmlElement* nodeElement, const std::string& workingDirectory)
+bool mitk::SceneReaderV1::DecorateNodeWithProperties(DataNode* node, TiXmlElement* nodeElement, SceneZipArchive& archive)
 {
   assert(node);
   assert(nodeElement);
@@ -298,10 +317,19 @@ bool mitk::SceneReaderV1::DecorateNodeWithProperties(DataNode* node, TiXmlElemen
       // clear all properties from node that might be set by DataNodeFactory during loading
       propertyList->Clear();
 
+      std::string content;
+      if ( !archive.ReadMember( propertiesfile, content ) || content.empty() )
+      {
+        MITK_ERROR << "Could not read properties " << propertiesfile << " from scene file.";
+        error = true;
+        continue;
+      }
+
       // use deserializer to construct new properties
       PropertyListDeserializer::Pointer deserializer = PropertyListDeserializer::New();
 
-      deserializer->SetFilename(workingDirectory + Poco::Path::separator() + propertiesfile);
+      deserializer->SetFilename(propertiesfile);
+      deserializer->SetContent(content);
       bool success = deserializer->Deserialize();
       error |= !success;
       PropertyList::Pointer readProperties = deserializer->GetOutput();
@@ -347,7 +375,7 @@ bool mitk::SceneReaderV1::DecorateNodeWithProperties(DataNode* node, TiXmlElemen
   return !error;
 }
 
-bool mitk::SceneReaderV1::DecorateBaseDataWithProperties(BaseData::Pointer data, TiXmlElement *baseDataNodeElem, const std::string &workingDir)
+bool mitk::SceneReaderV1::DecorateBaseDataWithProperties(BaseData::Pointer data, TiXmlElement *baseDataNodeElem, SceneZipArchive& archive)
 {
   // check given variables, initialize error variable
   assert(baseDataNodeElem);
@@ -358,12 +386,20 @@ bool mitk::SceneReaderV1::DecorateBaseDataWithProperties(BaseData::Pointer data,
   // check if the filename was found
   if(baseDataPropertyFile)
   {
+    std::string content;
+    if ( !archive.ReadMember( baseDataPropertyFile, content ) || content.empty() )
+    {
+      MITK_ERROR << "Could not read properties " << baseDataPropertyFile << " from scene file.";
+      return false;
+    }
+
     //PropertyList::Pointer dataPropList = data->GetPropertyList();
 
     PropertyListDeserializer::Pointer propertyDeserializer = PropertyListDeserializer::New();
 
     // initialize the property reader
-    propertyDeserializer->SetFilename(workingDir + Poco::Path::separator() + baseDataPropertyFile);
+    propertyDeserializer->SetFilename(baseDataPropertyFile);
+    propertyDeserializer->SetContent(content);
     bool ioSuccess = propertyDeserializer->Deserialize();
     error = !ioSuccess;
 
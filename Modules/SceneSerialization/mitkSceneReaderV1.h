@@ -26,28 +26,30 @@ class SceneReaderV1 : public SceneReader
     mitkClassMacro( SceneReaderV1, SceneReader);
     itkNewMacro( Self );
 
-    virtual bool LoadScene( TiXmlDocument& document, const std::string& workingDirectory, DataStorage* storage );
+    virtual bool LoadScene( TiXmlDocument& document, SceneZipArchive& archive, DataStorage* storage );
 
   protected:
 
     /**
       \brief tries to create one DataNode from a given XML <node> element
+
+      DataNodeFactory needs a file, so the member is extracted to a temporary file while it is read.
     */
     DataNode::Pointer LoadBaseDataFromDataTag( TiXmlElement* dataElement,
-                                                   const std::string& workingDirectory,
+                                                   SceneZipArchive& archive,
                                                    bool& error );
 
     /**
       \brief reads all the properties from the XML document and recreates them in node
     */
-    bool DecorateNodeWithProperties(DataNode* node, TiXmlElement* nodeElement, const std::string& workingDirectory);
+    bool DecorateNodeWithProperties(DataNode* node, TiXmlElement* nodeElement, SceneZipArchive& archive);
 
     /**
       \brief reads all properties assigned to a base data element and assigns the list to the base data object
 
       The baseDataNodeElem is supposed to be the <properties file="..."> element.
     */
-    bool DecorateBaseDataWithProperties(BaseData::Pointer data, TiXmlElement* baseDataNodeElem, const std::string& workingDir);
+    bool DecorateBaseDataWithProperties(BaseData::Pointer data, TiXmlElement* baseDataNodeElem, SceneZipArchive& archive);
 
     typedef std::multimap<int, std::string> UnorderedLayers;
     typedef std::map<std::string, int> OrderedLayers;
@@ -56,7 +58,7 @@ class SceneReaderV1 : public SceneReader
     typedef std::map<std::string, DataNode*> IDToNodeMappingType;
     typedef std::map<DataNode*, std::string> NodeToIDMappingType;
 
-    void GetLayerOrder(TiXmlDocument& document, const std::string& workingDirectory, std::vector<mitk::DataNode::Pointer> DataNodes, OrderedLayers& order);
+    void GetLayerOrder(TiXmlDocument& document, SceneZipArchive& archive, std::vector<mitk::DataNode::Pointer> DataNodes, OrderedLayers& order);
 
     UnorderedLayers         m_UnorderedLayers;
     OrderedLayers           m_OrderedLayers;
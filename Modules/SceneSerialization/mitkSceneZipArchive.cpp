@@ -0,0 +1,111 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkSceneZipArchive.h"
+
+#include <mitkCommon.h>
+
+#include <Poco/Exception.h>
+#include <Poco/File.h>
+#include <Poco/Path.h>
+#include <Poco/StreamCopier.h>
+#include <Poco/TemporaryFile.h>
+#include <Poco/Zip/ZipStream.h>
+
+#include <fstream>
+#include <sstream>
+
+mitk::SceneZipArchive::SceneZipArchive( std::istream& stream )
+:m_Stream( stream ),
+ m_Archive( stream )
+{
+}
+
+bool mitk::SceneZipArchive::HasMember( const std::string& name ) const
+{
+  Poco::Zip::ZipArchive::FileHeaders::const_iterator header = m_Archive.findHeader( name );
+  return header != m_Archive.headerEnd() && header->second.isFile();
+}
+
+bool mitk::SceneZipArchive::ReadMember( const std::string& name, std::string& content )
+{
+  std::ostringstream stream;
+  if ( !CopyMember( name, stream ) )
+  {
+    return false;
+  }
+  content = stream.str();
+  return true;
+}
+
+std::string mitk::SceneZipArchive::ExtractMember( const std::string& name )
+{
+  std::string filename = Poco::TemporaryFile::tempName() + "_" + Poco::Path( name ).getFileName();
+
+  std::ofstream file( filename.c_str(), std::ios::binary );
+  if ( !file.good() )
+  {
+    MITK_ERROR << "Could not create temporary file " << filename;
+    return "";
+  }
+
+  bool success = CopyMember( name, file );
+  file.close();
+  if ( !success || file.fail() )
+  {
+    try
+    {
+      Poco::File( filename ).remove();
+    }
+    catch(...)
+    {
+      MITK_ERROR << "Could not delete temporary file " << filename;
+    }
+    return "";
+  }
+
+  return filename;
+}
+
+bool mitk::SceneZipArchive::CopyMember( const std::string& name, std::ostream& target )
+{
+  if ( !HasMember( name ) )
+  {
+    MITK_ERROR << "Scene file does not contain " << name;
+    return false;
+  }
+
+  // reading the directory or the previous member leaves the stream at its end
+  m_Stream.clear();
+
+  try
+  {
+    Poco::Zip::ZipInputStream member( m_Stream, m_Archive.findHeader( name )->second, true );
+    Poco::StreamCopier::copyStream( member, target );
+    if ( member.bad() || !member.crcValid() )
+    {
+      MITK_ERROR << "Scene file member " << name << " is corrupt";
+      return false;
+    }
+  }
+  catch ( Poco::Exception& e )
+  {
+    MITK_ERROR << "Could not read " << name << " from scene file: " << e.displayText();
+    return false;
+  }
+
+  return target.good();
+}
@@ -0,0 +1,75 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#ifndef mitkSceneZipArchive_h_included
+#define mitkSceneZipArchive_h_included
+
+#include "SceneSerializationExports.h"
+
+#include <Poco/Zip/ZipArchive.h>
+
+#include <istream>
+#include <string>
+
+namespace mitk
+{
+
+/**
+  \brief Reads single members of a scene file.
+
+  Members are decompressed from the zip stream when they are needed, the scene
+  is never unpacked as a whole. All members are read from the same stream, so
+  an instance must only be used by one thread.
+*/
+class SceneSerialization_EXPORT SceneZipArchive
+{
+  public:
+
+    /**
+      \brief Reads the directory of the zip file in stream.
+
+      Throws a Poco::Exception if stream does not contain a zip file.
+    */
+    SceneZipArchive( std::istream& stream );
+
+    bool HasMember( const std::string& name ) const;
+
+    /**
+      \brief Decompresses member name into content.
+      \return false if there is no such member or it is corrupt
+    */
+    bool ReadMember( const std::string& name, std::string& content );
+
+    /**
+      \brief Decompresses member name into a temporary file, for readers that need a file name.
+
+      The file name ends with the name of the member, so readers can still be
+      chosen by extension. The caller has to remove the file.
+      \return the name of the temporary file, or an empty string on errors
+    */
+    std::string ExtractMember( const std::string& name );
+
+  private:
+
+    bool CopyMember( const std::string& name, std::ostream& target );
+
+    std::istream& m_Stream;
+    Poco::Zip::ZipArchive m_Archive;
+};
+
+}
+
+#endif
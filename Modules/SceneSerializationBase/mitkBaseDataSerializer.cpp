@@ -17,6 +17,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "mitkBaseDataSerializer.h"
 #include "mitkStandardFileLocations.h"
 #include <itksys/SystemTools.hxx>
+#include <itkSimpleFastMutexLock.h>
 
 mitk::BaseDataSerializer::BaseDataSerializer()
 : m_FilenameHint("unnamed")
@@ -40,9 +41,12 @@ std::string mitk::BaseDataSerializer::Serialize()
 
 std::string mitk::BaseDataSerializer::GetUniqueFilenameInWorkingDirectory()
 {
-  // tmpname
+  // tmpname, SceneIO runs several serializers at the same time
+  static itk::SimpleFastMutexLock countLock;
   static unsigned long count = 0;
+  countLock.Lock();
   unsigned long n = count++;
+  countLock.Unlock();
   std::ostringstream name;
   for (int i = 0; i < 6; ++i)
   {
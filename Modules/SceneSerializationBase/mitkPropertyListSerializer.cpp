@@ -35,11 +35,9 @@ mitk::PropertyListSerializer::~PropertyListSerializer()
 
 std::string mitk::PropertyListSerializer::Serialize()
 {
-  m_FailedProperties = PropertyList::New();
-
-  if ( m_PropertyList.IsNull() || m_PropertyList->IsEmpty() )
+  TiXmlDocument document;
+  if ( !CreateDocument( document ) )
   {
-    MITK_ERROR << "Not serializing NULL or empty PropertyList";
     return "";
   }
 
@@ -66,7 +64,39 @@ std::string mitk::PropertyListSerializer::Serialize()
   if (length >= 2 && fullname[0] == '"' && fullname[length - 1] == '"')
     fullname = fullname.substr(1, length - 2);
 
+  // save XML file
+  if ( !document.SaveFile( fullname ) )
+  {
+    MITK_ERROR << "Could not write PropertyList to " << fullname << "\nTinyXML reports '" << document.ErrorDesc() << "'";
+    return "";
+  }
+
+  return filename;
+}
+
+std::string mitk::PropertyListSerializer::SerializeToString()
+{
   TiXmlDocument document;
+  if ( !CreateDocument( document ) )
+  {
+    return "";
+  }
+
+  TiXmlPrinter printer;
+  document.Accept( &printer );
+  return printer.Str();
+}
+
+bool mitk::PropertyListSerializer::CreateDocument( TiXmlDocument& document )
+{
+  m_FailedProperties = PropertyList::New();
+
+  if ( m_PropertyList.IsNull() || m_PropertyList->IsEmpty() )
+  {
+    MITK_ERROR << "Not serializing NULL or empty PropertyList";
+    return false;
+  }
+
   TiXmlDeclaration* decl = new TiXmlDeclaration( "1.0", "", "" ); // TODO what to write here? encoding? etc....
   document.LinkEndChild( decl );
 
@@ -96,14 +126,7 @@ std::string mitk::PropertyListSerializer::Serialize()
     }
   }
 
-  // save XML file
-  if ( !document.SaveFile( fullname ) )
-  {
-    MITK_ERROR << "Could not write PropertyList to " << fullname << "\nTinyXML reports '" << document.ErrorDesc() << "'";
-    return "";
-  }
-
-  return filename;
+  return true;
 }
 
 TiXmlElement* mitk::PropertyListSerializer::SerializeOneProperty( const std::string& key, const BaseProperty* property )
@@ -23,6 +23,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 #include <itkObjectFactoryBase.h>
 
+class TiXmlDocument;
 class TiXmlElement;
 
 namespace mitk
@@ -52,6 +53,12 @@ class SceneSerializationBase_EXPORT PropertyListSerializer : public itk::Object
       */
     virtual std::string Serialize();
 
+    /**
+      \brief Serializes given PropertyList object into XML text instead of a file.
+      \return the XML text, empty if nothing was serialized.
+      */
+    std::string SerializeToString();
+
     PropertyList* GetFailedProperties();
 
   protected:
@@ -59,6 +66,9 @@ class SceneSerializationBase_EXPORT PropertyListSerializer : public itk::Object
     PropertyListSerializer();
     virtual ~PropertyListSerializer();
 
+    /// Fills document with all properties, false if there is nothing to serialize
+    bool CreateDocument( TiXmlDocument& document );
+
     TiXmlElement* SerializeOneProperty( const std::string& key, const BaseProperty* property );
 
     std::string m_FilenameHint;
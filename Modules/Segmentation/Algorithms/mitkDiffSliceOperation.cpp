@@ -17,6 +17,108 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "mitkDiffSliceOperation.h"
 
 #include <itkCommand.h>
+#include <itkMultiThreader.h>
+#include <itkConditionVariable.h>
+#include <itk_zlib.h>
+
+#include <algorithm>
+#include <deque>
+
+namespace
+{
+
+/** \brief Compresses the slices of new DiffSliceOperations in a background thread.
+
+  The interaction that created an operation does not have to wait for the compression.
+  Operations remove themselves on destruction and wait if they are compressed at that moment.
+*/
+class DiffSliceCompressor
+{
+public:
+
+  static DiffSliceCompressor* GetInstance()
+  {
+    // never deleted, operations on static undo stacks may be destroyed at any time during shutdown
+    static DiffSliceCompressor* s_Instance = new DiffSliceCompressor();
+    return s_Instance;
+  }
+
+  void Enqueue(mitk::DiffSliceOperation* operation)
+  {
+    m_Mutex.Lock();
+    if (m_ThreadID < 0)
+    {
+      m_ThreadID = m_MultiThreader->SpawnThread( ThreadStartCompressing, this );
+    }
+    m_Queue.push_back(operation);
+    m_Mutex.Unlock();
+
+    m_OperationAvailable->Signal();
+  }
+
+  void Remove(mitk::DiffSliceOperation* operation)
+  {
+    m_Mutex.Lock();
+    m_Queue.erase( std::remove(m_Queue.begin(), m_Queue.end(), operation), m_Queue.end() );
+    while (m_CurrentOperation == operation)
+    {
+      m_OperationFinished->Wait( &m_Mutex );
+    }
+    m_Mutex.Unlock();
+  }
+
+private:
+
+  DiffSliceCompressor()
+    : m_MultiThreader(itk::MultiThreader::New()),
+      m_ThreadID(-1),
+      m_OperationAvailable(itk::ConditionVariable::New()),
+      m_OperationFinished(itk::ConditionVariable::New()),
+      m_CurrentOperation(NULL)
+  {
+  }
+
+  static ITK_THREAD_RETURN_TYPE ThreadStartCompressing(void* arg)
+  {
+    itk::MultiThreader::ThreadInfoStruct* threadInfo = static_cast<itk::MultiThreader::ThreadInfoStruct*>(arg);
+    static_cast<DiffSliceCompressor*>(threadInfo->UserData)->CompressOperations();
+    return ITK_THREAD_RETURN_VALUE;
+  }
+
+  void CompressOperations()
+  {
+    m_Mutex.Lock();
+    while (true)
+    {
+      while (m_Queue.empty())
+      {
+        m_OperationAvailable->Wait( &m_Mutex );
+      }
+
+      m_CurrentOperation = m_Queue.front();
+      m_Queue.pop_front();
+      m_Mutex.Unlock();
+
+      m_CurrentOperation->CompressSlice();
+
+      m_Mutex.Lock();
+      m_CurrentOperation = NULL;
+      m_OperationFinished->Broadcast();
+    }
+  }
+
+  itk::MultiThreader::Pointer m_MultiThreader;
+  int m_ThreadID;
+
+  itk::SimpleMutexLock m_Mutex;
+  itk::ConditionVariable::Pointer m_OperationAvailable;
+  itk::ConditionVariable::Pointer m_OperationFinished;
+
+  std::deque<mitk::DiffSliceOperation*> m_Queue;
+  mitk::DiffSliceOperation* m_CurrentOperation;
+};
+
+}
 
 mitk::DiffSliceOperation::DiffSliceOperation():Operation(1)
 {
@@ -26,6 +128,9 @@ mitk::DiffSliceOperation::DiffSliceOperation():Operation(1)
   m_WorldGeometry = NULL;
   m_SliceGeometry = NULL;
   m_ImageIsValid = false;
+  m_ScalarType = 0;
+  m_NumberOfScalarComponents = 0;
+  m_UncompressedSize = 0;
 }
 
 
@@ -49,11 +154,13 @@ mitk::DiffSliceOperation::DiffSliceOperation(mitk::Image* imageVolume,
 
   m_TimeStep = timestep;
 
-  /*m_zlibSliceContainer = CompressedImageContainer::New();
-  m_zlibSliceContainer->SetImage( slice );*/
   m_Slice = vtkSmartPointer<vtkImageData>::New();
   m_Slice->DeepCopy(slice);
 
+  m_ScalarType = 0;
+  m_NumberOfScalarComponents = 0;
+  m_UncompressedSize = 0;
+
   m_Image = imageVolume;
 
   if ( m_Image) {
@@ -69,14 +176,15 @@ mitk::DiffSliceOperation::DiffSliceOperation(mitk::Image* imageVolume,
   else
     m_ImageIsValid = false;
 
+  DiffSliceCompressor::GetInstance()->Enqueue(this);
 }
 
 mitk::DiffSliceOperation::~DiffSliceOperation()
 {
+  DiffSliceCompressor::GetInstance()->Remove(this);
 
   m_Slice = NULL;
   m_WorldGeometry = NULL;
-  //m_zlibSliceContainer = NULL;
 
   if (m_ImageIsValid)
   {
@@ -86,19 +194,114 @@ mitk::DiffSliceOperation::~DiffSliceOperation()
   m_Image = NULL;
 }
 
-vtkImageData* mitk::DiffSliceOperation::GetSlice()
+void mitk::DiffSliceOperation::SetImage(vtkImageData* slice)
 {
-  //Image::ConstPointer image = m_zlibSliceContainer->GetImage().GetPointer();
-  return m_Slice;
+  m_SliceLock.Lock();
+  m_Slice = slice;
+  m_CompressedSlice.clear();
+  m_SliceStructure = NULL;
+  m_SliceLock.Unlock();
+}
+
+vtkSmartPointer<vtkImageData> mitk::DiffSliceOperation::GetSlice()
+{
+  m_SliceLock.Lock();
+
+  if (m_Slice.GetPointer() == NULL && !m_CompressedSlice.empty())
+  {
+    vtkSmartPointer<vtkImageData> slice = vtkSmartPointer<vtkImageData>::New();
+    slice->CopyStructure(m_SliceStructure);
+    slice->SetScalarType(m_ScalarType);
+    slice->SetNumberOfScalarComponents(m_NumberOfScalarComponents);
+    slice->AllocateScalars();
+
+    ::uLongf destLen(m_UncompressedSize);
+    int zlibRetVal = ::uncompress( static_cast< ::Bytef*>(slice->GetScalarPointer()), &destLen,
+                                   &m_CompressedSlice[0], m_CompressedSlice.size() );
+    if (zlibRetVal == Z_OK && destLen == m_UncompressedSize)
+    {
+      m_Slice = slice;
+    }
+    else
+    {
+      MITK_ERROR << "Could not decompress slice of undo operation (zlib error " << zlibRetVal << ")";
+    }
+  }
+
+  // take the reference while locked, CompressSlice() may release m_Slice right after unlocking
+  vtkSmartPointer<vtkImageData> slice = m_Slice;
+  m_SliceLock.Unlock();
+  return slice;
+}
+
+void mitk::DiffSliceOperation::CompressSlice()
+{
+  m_SliceLock.Lock();
+
+  if (m_Slice.GetPointer() != NULL && m_CompressedSlice.empty() && m_Slice->GetNumberOfPoints() > 0)
+  {
+    m_ScalarType = m_Slice->GetScalarType();
+    m_NumberOfScalarComponents = m_Slice->GetNumberOfScalarComponents();
+    m_UncompressedSize = m_Slice->GetNumberOfPoints() * m_NumberOfScalarComponents * m_Slice->GetScalarSize();
+
+    // speed matters more than ratio here, constant areas compress well at any level
+    ::uLongf destLen = ::compressBound(m_UncompressedSize);
+    std::vector<unsigned char> buffer(destLen);
+    int zlibRetVal = ::compress2( &buffer[0], &destLen, static_cast< ::Bytef*>(m_Slice->GetScalarPointer()),
+                                  m_UncompressedSize, Z_BEST_SPEED );
+
+    if (zlibRetVal == Z_OK)
+    {
+      m_CompressedSlice.assign(buffer.begin(), buffer.begin() + destLen);
+
+      m_SliceStructure = vtkSmartPointer<vtkImageData>::New();
+      m_SliceStructure->CopyStructure(m_Slice);
+
+      m_Slice = NULL;
+    }
+    else
+    {
+      MITK_WARN << "Could not compress slice of undo operation (zlib error " << zlibRetVal << "), keeping it uncompressed";
+    }
+  }
+
+  m_SliceLock.Unlock();
+}
+
+void mitk::DiffSliceOperation::DiscardUncompressedSlice()
+{
+  m_SliceLock.Lock();
+  if (!m_CompressedSlice.empty())
+  {
+    m_Slice = NULL;
+  }
+  m_SliceLock.Unlock();
+}
+
+unsigned long mitk::DiffSliceOperation::GetMemorySize() const
+{
+  m_SliceLock.Lock();
+  unsigned long size = m_CompressedSlice.size();
+  if (m_Slice.GetPointer() != NULL)
+  {
+    // vtk reports kilobytes
+    size += m_Slice->GetActualMemorySize() * 1024;
+  }
+  m_SliceLock.Unlock();
+  return size;
 }
 
 bool mitk::DiffSliceOperation::IsValid()
 {
-  return m_ImageIsValid && (m_Slice.GetPointer() != NULL) && (m_WorldGeometry.IsNotNull());//TODO improve
+  m_SliceLock.Lock();
+  bool hasSlice = (m_Slice.GetPointer() != NULL) || !m_CompressedSlice.empty();
+  m_SliceLock.Unlock();
+
+  return m_ImageIsValid && hasSlice && (m_WorldGeometry.IsNotNull());//TODO improve
 }
 
 void mitk::DiffSliceOperation::OnImageDeleted()
 {
   //if our imageVolume is removed e.g. from the datastorage the operation is no lnger valid
   m_ImageIsValid = false;
-}
\ No newline at end of file
+}
@@ -20,11 +20,13 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "SegmentationExports.h"
 #include "mitkCommon.h"
 #include <mitkOperation.h>
-//#include "mitkCompressedImageContainer.h"
 
 #include <mitkImage.h>
 #include <vtkSmartPointer.h>
 #include <vtkImageData.h>
+#include <itkMutexLock.h>
+
+#include <vector>
 
 
 namespace mitk
@@ -40,6 +42,11 @@ namespace mitk
      currentWorldGeometry   specifies the axis where the slice has to be applied in the volume.
 
     This Operation can be used to realize undo-redo functionality for e.g. segmentation purposes.
+
+    To keep long editing sessions small on the undo stack, the slice is compressed with zlib
+    in a background thread after construction. Segmentation slices mostly consist of large
+    constant areas, so the compressed slice is usually a small fraction of the original.
+    GetSlice() decompresses it on demand.
   */
   class Segmentation_EXPORT DiffSliceOperation : public Operation
   {
@@ -69,9 +76,21 @@ namespace mitk
     mitk::Image* GetImage(){return this->m_Image;}
 
     /** \brief Set thee slice to be applied.*/
-    void SetImage(vtkImageData* slice){ this->m_Slice = slice;}
-    /** \brief Get the slice that is applied in the operation.*/
-    vtkImageData* GetSlice();
+    void SetImage(vtkImageData* slice);
+    /** \brief Get the slice that is applied in the operation.
+      A compressed slice is decompressed and kept until DiscardUncompressedSlice() is called.
+      The returned pointer keeps the slice alive when the background compression releases it.*/
+    vtkSmartPointer<vtkImageData> GetSlice();
+
+    /** \brief Compress the slice and free the uncompressed data.
+      This is done in a background thread for every operation that is constructed with a slice.*/
+    void CompressSlice();
+
+    /** \brief Free the uncompressed slice if a compressed copy exists.*/
+    void DiscardUncompressedSlice();
+
+    /** \brief Bytes used by the compressed and the uncompressed slice.*/
+    virtual unsigned long GetMemorySize() const;
 
     /** \brief Get timeStep.*/
     void SetTimeStep(unsigned int timestep){this->m_TimeStep = timestep;}
@@ -96,12 +115,25 @@ namespace mitk
     /** \brief Callback for image observer.*/
     void OnImageDeleted();
 
-    //CompressedImageContainer::Pointer m_zlibSliceContainer;
-
     mitk::Image* m_Image;
 
     vtkSmartPointer<vtkImageData> m_Slice;
 
+    /** \brief zlib compressed scalars of the slice, empty until CompressSlice() was called*/
+    std::vector<unsigned char> m_CompressedSlice;
+
+    /** \brief Extent, spacing and origin of the compressed slice*/
+    vtkSmartPointer<vtkImageData> m_SliceStructure;
+
+    int m_ScalarType;
+
+    int m_NumberOfScalarComponents;
+
+    unsigned long m_UncompressedSize;
+
+    /** \brief Guards the slice data against the compression thread*/
+    mutable itk::SimpleMutexLock m_SliceLock;
+
     AffineGeometryFrame3D::Pointer m_SliceGeometry;
 
     unsigned int m_TimeStep;
@@ -41,8 +41,9 @@ void mitk::DiffSliceOperationApplier::ExecuteOperation( Operation* operation )
     //the actual overwrite filter (vtk)
     vtkSmartPointer<mitkVtkImageOverwrite> reslice = vtkSmartPointer<mitkVtkImageOverwrite>::New();
 
-    //Set the slice as 'input'
-    reslice->SetInputSlice(imageOperation->GetSlice());
+    //Set the slice as 'input', the smart pointer keeps it alive while it is written
+    vtkSmartPointer<vtkImageData> slice = imageOperation->GetSlice();
+    reslice->SetInputSlice(slice);
 
     //set overwrite mode to true to write back to the image volume
     reslice->SetOverwriteMode(true);
@@ -59,6 +60,9 @@ void mitk::DiffSliceOperationApplier::ExecuteOperation( Operation* operation )
     extractor->Modified();
     extractor->Update();
 
+    //the slice stays on the undo/redo stack, only its compressed version is needed there
+    imageOperation->DiscardUncompressedSlice();
+
     //make sure the modification is rendered
     RenderingManager::GetInstance()->RequestUpdateAll();
     imageOperation->GetImage()->Modified();
@@ -34,6 +34,7 @@ mitk::ImageLiveWireContourModelFilter::ImageLiveWireContourModelFilter()
   m_UseDynamicCostMap = false;
   m_ImageModified = false;
   m_Timestep = 0;
+  m_SearchRegionMargin = 20;
 }
 
 mitk::ImageLiveWireContourModelFilter::~ImageLiveWireContourModelFilter()
@@ -125,7 +126,7 @@ void mitk::ImageLiveWireContourModelFilter::ItkProcessImage (itk::Image<TPixel,
   typedef typename InputImageType::IndexType               IndexType;
 
 
-  /* compute the requested region for itk filters */
+  /* compute the search region for itk filters */
 
   IndexType startPoint, endPoint;
 
@@ -135,31 +136,57 @@ void mitk::ImageLiveWireContourModelFilter::ItkProcessImage (itk::Image<TPixel,
   endPoint[0] = m_EndPointInIndex[0];
   endPoint[1] = m_EndPointInIndex[1];
 
-  //minimum value in each direction for startRegion
-  IndexType startRegion;
-  startRegion[0] = startPoint[0] < endPoint[0] ? startPoint[0] : endPoint[0];
-  startRegion[1] = startPoint[1] < endPoint[1] ? startPoint[1] : endPoint[1];
-
-  //maximum value in each direction for size
-  typename InputImageType::SizeType size;
-  size[0] = abs( startPoint[0] - endPoint[0] );
-  size[1] = abs( startPoint[1] - endPoint[1] );
-
+  if( m_ImageModified )
+  {
+    m_SearchRegion = CostFunctionType::RegionType();
+  }
 
-  typename CostFunctionType::RegionType region;
-  region.SetSize( size );
-  region.SetIndex( startRegion );
+  typename CostFunctionType::RegionType region = inputImage->GetLargestPossibleRegion();
+  if( m_SearchRegionMargin > 0 )
+  {
+    //minimum value in each direction for startRegion
+    IndexType startRegion;
+    startRegion[0] = startPoint[0] < endPoint[0] ? startPoint[0] : endPoint[0];
+    startRegion[1] = startPoint[1] < endPoint[1] ? startPoint[1] : endPoint[1];
+
+    //maximum value in each direction for size
+    typename InputImageType::SizeType size;
+    size[0] = abs( startPoint[0] - endPoint[0] ) + 1;
+    size[1] = abs( startPoint[1] - endPoint[1] ) + 1;
+
+    // the farther apart the points are, the larger the detours the contour may take
+    long margin = m_SearchRegionMargin + ( size[0] > size[1] ? size[0] : size[1] ) / 2;
+
+    typename CostFunctionType::RegionType requiredRegion;
+    requiredRegion.SetIndex( startRegion );
+    requiredRegion.SetSize( size );
+    requiredRegion.PadByRadius( margin );
+    requiredRegion.Crop( inputImage->GetLargestPossibleRegion() );
+
+    // keep the search region as long as it contains the required region: while only the end point moves
+    // inside it, the shortest path filter continues its last search instead of starting a new one
+    if( m_SearchRegion.GetNumberOfPixels() == 0 || !m_SearchRegion.IsInside( requiredRegion ) )
+    {
+      m_SearchRegion.SetIndex( startRegion );
+      m_SearchRegion.SetSize( size );
+      m_SearchRegion.PadByRadius( 2 * margin );
+      m_SearchRegion.Crop( inputImage->GetLargestPossibleRegion() );
+    }
+    region = m_SearchRegion;
+  }
   /*---------------------------------------------*/
 
-  //inputImage->SetRequestedRegion(region);
-
-  typedef itk::CastImageFilter< InputImageType, FloatImageType > CastFilterType;
-  typename CastFilterType::Pointer castFilter = CastFilterType::New();
-  castFilter->SetInput(inputImage);
-  castFilter->Update();
-  /* extracts features from image and calculates costs */
-  if( m_ImageModified )
-    m_CostFunction->SetImage(castFilter->GetOutput());
+  /* cast only a new input, the shortest path filter keeps its search tree as long as its input does not change */
+  if( m_ImageModified || m_FloatImage.IsNull() )
+  {
+    typedef itk::CastImageFilter< InputImageType, FloatImageType > CastFilterType;
+    typename CastFilterType::Pointer castFilter = CastFilterType::New();
+    castFilter->SetInput(inputImage);
+    castFilter->Update();
+    m_FloatImage = castFilter->GetOutput();
+    /* extracts features from image and calculates costs */
+    m_CostFunction->SetImage(m_FloatImage);
+  }
   m_CostFunction->SetStartIndex(startPoint);
   m_CostFunction->SetEndIndex(endPoint);
   m_CostFunction->SetRequestedRegion(region);
@@ -169,8 +196,9 @@ void mitk::ImageLiveWireContourModelFilter::ItkProcessImage (itk::Image<TPixel,
 
   /* calculate shortest path between start and end point */
   m_ShortestPathFilter->SetFullNeighborsMode(true);
-  m_ShortestPathFilter->SetInput(castFilter->GetOutput());
+  m_ShortestPathFilter->SetInput(m_FloatImage);
   m_ShortestPathFilter->SetMakeOutputImage(false);
+  m_ShortestPathFilter->SetSearchRegion(region);
 
   //m_ShortestPathFilter->SetCalcAllDistances(true);
   m_ShortestPathFilter->SetStartIndex(startPoint);
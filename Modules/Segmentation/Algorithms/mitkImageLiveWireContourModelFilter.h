@@ -82,6 +82,13 @@ namespace mitk {
     itkSetMacro(UseDynamicCostMap, bool);
     itkGetMacro(UseDynamicCostMap, bool);
 
+    /** \brief Pixels the search region extends beyond the bounding box of start and end point, in addition to half of
+    the larger side of the box (default 20). The region is kept while the end point moves inside it, so the shortest
+    path search continues instead of starting again. 0 searches the whole image.
+    */
+    itkSetMacro(SearchRegionMargin, unsigned int);
+    itkGetMacro(SearchRegionMargin, unsigned int);
+
 
     virtual void SetInput( const InputType *input);
 
@@ -141,6 +148,15 @@ namespace mitk {
 
     unsigned int m_Timestep;
 
+    /** \brief Pixels the search region extends beyond start and end point*/
+    unsigned int m_SearchRegionMargin;
+
+    /** \brief Region the shortest path is searched in*/
+    CostFunctionType::RegionType m_SearchRegion;
+
+    /** \brief The input as float image, only recomputed if the input changes*/
+    FloatImageType::Pointer m_FloatImage;
+
     template<typename TPixel, unsigned int VImageDimension>
     void ItkProcessImage (itk::Image<TPixel, VImageDimension>* inputImage);
 
@@ -55,6 +55,7 @@ void ShowSegmentationAsSurface::Initialize(const NonBlockingAlgorithm* other)
   SetParameter("Decimate mesh", true );
   SetParameter("Decimation rate", 0.8f );
   SetParameter("Wireframe", false );
+  SetParameter("Parallel surface extraction", false );
 }
 
 
@@ -97,6 +98,9 @@ bool ShowSegmentationAsSurface::ThreadedUpdateFunction()
   float reductionRate(0.8);
   GetParameter("Decimation rate", reductionRate );
 
+  bool parallelSurfaceExtraction(false);
+  GetParameter("Parallel surface extraction", parallelSurfaceExtraction );
+
   MITK_INFO << "Creating polygon model with smoothing " << smooth << " gaussianSD " << gaussianSD
                                          << " median " << applyMedian << " median kernel " << medianKernelSize
                                          << " mesh reduction " << decimateMesh << " reductionRate " << reductionRate;
@@ -104,6 +108,12 @@ bool ShowSegmentationAsSurface::ThreadedUpdateFunction()
   ManualSegmentationToSurfaceFilter::Pointer surfaceFilter = ManualSegmentationToSurfaceFilter::New();
   surfaceFilter->SetInput( image );
   surfaceFilter->SetThreshold( 1 ); //expects binary image with zeros and ones
+  if (parallelSurfaceExtraction)
+  {
+    // the points of flying edges are numbered differently than those of vtkMarchingCubes, so smoothing and
+    // decimation give (slightly) different surfaces; therefore marching cubes stays the default
+    surfaceFilter->SetSurfaceExtraction( ImageToSurfaceFilter::ParallelFlyingEdges );
+  }
 
   surfaceFilter->SetUseGaussianImageSmooth(smooth); // apply gaussian to thresholded image ?
   if (smooth)
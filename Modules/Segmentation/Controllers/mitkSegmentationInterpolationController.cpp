@@ -26,7 +26,68 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 #include <itkCommand.h>
 #include <itkImage.h>
-#include <itkImageSliceConstIteratorWithIndex.h>
+#include <itkMultiThreader.h>
+
+#include <algorithm>
+
+namespace
+{
+
+/// Partial counts of the threads of SegmentationInterpolationController::ScanVolume()
+template < typename TPixel >
+struct ScanVolumeThreadData
+{
+  const TPixel* m_Pixels;
+  unsigned int m_Size[3];
+
+  /// one vector of x and y counts per thread, z slices are disjoint
+  std::vector< std::vector<int> > m_CountInX;
+  std::vector< std::vector<int> > m_CountInY;
+  std::vector<int> m_CountInZ;
+};
+
+/// Scans a slab of z slices, only pixels other than 0 are added to the x counts
+template < typename TPixel >
+ITK_THREAD_RETURN_TYPE ScanVolumeThread( void* pInfoStruct )
+{
+  itk::MultiThreader::ThreadInfoStruct* threadInfo = static_cast<itk::MultiThreader::ThreadInfoStruct*>(pInfoStruct);
+  ScanVolumeThreadData<TPixel>* data = static_cast<ScanVolumeThreadData<TPixel>*>(threadInfo->UserData);
+
+  const unsigned int sizeX = data->m_Size[0];
+  const unsigned int sizeY = data->m_Size[1];
+  const unsigned int sizeZ = data->m_Size[2];
+  const unsigned int begin = static_cast<unsigned int>( static_cast<unsigned long long>(sizeZ) * threadInfo->ThreadID / threadInfo->NumberOfThreads );
+  const unsigned int end = static_cast<unsigned int>( static_cast<unsigned long long>(sizeZ) * (threadInfo->ThreadID + 1) / threadInfo->NumberOfThreads );
+
+  std::vector<int>& countInX = data->m_CountInX[threadInfo->ThreadID];
+  std::vector<int>& countInY = data->m_CountInY[threadInfo->ThreadID];
+
+  for (unsigned int z = begin; z < end; ++z)
+  {
+    const TPixel* pixel = data->m_Pixels + static_cast<size_t>(sizeX) * sizeY * z;
+    int countInSlice(0);
+    for (unsigned int y = 0; y < sizeY; ++y)
+    {
+      int countInLine(0);
+      for (unsigned int x = 0; x < sizeX; ++x, ++pixel)
+      {
+        if ( *pixel != 0 )
+        {
+          int value = static_cast<int>( *pixel );
+          countInX[x] += value;
+          countInLine += value;
+        }
+      }
+      countInY[y] += countInLine;
+      countInSlice += countInLine;
+    }
+    data->m_CountInZ[z] = countInSlice;
+  }
+
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+}
 
 mitk::SegmentationInterpolationController::InterpolatorMapType mitk::SegmentationInterpolationController::s_InterpolatorForImage; // static member initialization
 
@@ -266,52 +327,10 @@ void mitk::SegmentationInterpolationController::ScanChangedSlice( itk::Image<DAT
 template < typename TPixel, unsigned int VImageDimension >
 void mitk::SegmentationInterpolationController::ScanChangedVolume( itk::Image<TPixel, VImageDimension>* diffImage, unsigned int timeStep )
 {
-  typedef itk::ImageSliceConstIteratorWithIndex< itk::Image<TPixel, VImageDimension> > IteratorType;
-
-  IteratorType iter( diffImage, diffImage->GetLargestPossibleRegion() );
-  iter.SetFirstDirection(0);
-  iter.SetSecondDirection(1);
-
-  int numberOfPixels(0); // number of pixels in this slice that are not 0
-
-  typename IteratorType::IndexType index;
-  unsigned int x = 0;
-  unsigned int y = 0;
-  unsigned int z = 0;
-
-  iter.GoToBegin();
-  while ( !iter.IsAtEnd() )
-  {
-    while ( !iter.IsAtEndOfSlice() )
-    {
-      while ( !iter.IsAtEndOfLine() )
-      {
-        index = iter.GetIndex();
-
-        x = index[0];
-        y = index[1];
-        z = index[2];
-
-        TPixel value = iter.Get();
-
-        assert ( (signed) m_SegmentationCountInSlice[timeStep][0][x] + (signed)value >= 0 ); // just for debugging. This must always be true, otherwise some counting is going wrong
-        assert ( (signed) m_SegmentationCountInSlice[timeStep][1][y] + (signed)value >= 0 );
-
-        m_SegmentationCountInSlice[timeStep][0][x] = static_cast<unsigned int>( m_SegmentationCountInSlice[timeStep][0][x] + value );
-        m_SegmentationCountInSlice[timeStep][1][y] = static_cast<unsigned int>( m_SegmentationCountInSlice[timeStep][1][y] + value );
-
-        numberOfPixels += static_cast<int>( value );
-
-        ++iter;
-      }
-      iter.NextLine();
-    }
-    assert ( (signed) m_SegmentationCountInSlice[timeStep][2][z] + numberOfPixels >= 0 );
-    m_SegmentationCountInSlice[timeStep][2][z] += numberOfPixels;
-    numberOfPixels = 0;
+  if ( timeStep >= m_SegmentationCountInSlice.size() ) return;
 
-    iter.NextSlice();
-  }
+  typename itk::Image<TPixel, VImageDimension>::SizeType size = diffImage->GetBufferedRegion().GetSize();
+  this->ScanVolume<TPixel>( diffImage->GetBufferPointer(), size[0], size[1], size[2], timeStep );
 }
 
 
@@ -321,13 +340,78 @@ void mitk::SegmentationInterpolationController::ScanWholeVolume( itk::Image<DATA
   if (!volume) return;
   if ( timeStep >= m_SegmentationCountInSlice.size() ) return;
 
-  for (unsigned int slice = 0; slice < volume->GetDimension(2); ++slice)
+  DATATYPE* rawVolume = static_cast<DATATYPE*>( const_cast<Image*>(volume)->GetVolumeData(timeStep)->GetData() ); // we again promise not to change anything, we'll just count
+  this->ScanVolume<DATATYPE>( rawVolume, volume->GetDimension(0), volume->GetDimension(1), volume->GetDimension(2), timeStep );
+}
+
+
+template < typename TPixel >
+void mitk::SegmentationInterpolationController::ScanVolume( const TPixel* pixels, unsigned int sizeX, unsigned int sizeY, unsigned int sizeZ, unsigned int timeStep )
+{
+  if ( !pixels ) return;
+  if ( sizeX > m_SegmentationCountInSlice[timeStep][0].size() ||
+       sizeY > m_SegmentationCountInSlice[timeStep][1].size() ||
+       sizeZ > m_SegmentationCountInSlice[timeStep][2].size() ) return;
+
+  // every thread scans a slab of slices, small volumes are not worth starting threads
+  const unsigned long long minimumNumberOfPixelsPerThread = 1 << 18;
+  unsigned long long numberOfPixels = static_cast<unsigned long long>(sizeX) * sizeY * sizeZ;
+  int numberOfThreads = std::min<unsigned long long>( itk::MultiThreader::GetGlobalDefaultNumberOfThreads(),
+                                                      numberOfPixels / minimumNumberOfPixelsPerThread );
+  numberOfThreads = std::max( 1, std::min( numberOfThreads, static_cast<int>(sizeZ) ) );
+
+  ScanVolumeThreadData<TPixel> data;
+  data.m_Pixels = pixels;
+  data.m_Size[0] = sizeX;
+  data.m_Size[1] = sizeY;
+  data.m_Size[2] = sizeZ;
+  data.m_CountInX.assign( numberOfThreads, std::vector<int>(sizeX, 0) );
+  data.m_CountInY.assign( numberOfThreads, std::vector<int>(sizeY, 0) );
+  data.m_CountInZ.assign( sizeZ, 0 );
+
+  if ( numberOfThreads > 1 )
+  {
+    itk::MultiThreader::Pointer threader = itk::MultiThreader::New();
+    threader->SetNumberOfThreads( numberOfThreads );
+    threader->SetSingleMethod( ScanVolumeThread<TPixel>, &data );
+    threader->SingleMethodExecute();
+  }
+  else
+  {
+    itk::MultiThreader::ThreadInfoStruct threadInfo;
+    threadInfo.ThreadID = 0;
+    threadInfo.NumberOfThreads = 1;
+    threadInfo.UserData = &data;
+    ScanVolumeThread<TPixel>( &threadInfo );
+  }
+
+  // merge the partial counts, values of difference images may be negative
+  for (int thread = 1; thread < numberOfThreads; ++thread)
   {
-    DATATYPE* rawVolume = static_cast<DATATYPE*>( const_cast<Image*>(volume)->GetVolumeData(timeStep)->GetData() ); // we again promise not to change anything, we'll just count
-    //DATATYPE* rawSlice = static_cast<DATATYPE*>( volume->GetSliceData(slice)->GetData() ); // TODO THIS wouldn't work. Did I mess up with some internal mitk::Image data structure?
-    DATATYPE* rawSlice = rawVolume + ( volume->GetDimension(0) * volume->GetDimension(1) * slice );
+    for (unsigned int x = 0; x < sizeX; ++x)
+    {
+      data.m_CountInX[0][x] += data.m_CountInX[thread][x];
+    }
+    for (unsigned int y = 0; y < sizeY; ++y)
+    {
+      data.m_CountInY[0][y] += data.m_CountInY[thread][y];
+    }
+  }
 
-    ScanChangedSlice<DATATYPE>( NULL, SetChangedSliceOptions(2, slice, 0, 1, timeStep, rawSlice) );
+  for (unsigned int x = 0; x < sizeX; ++x)
+  {
+    assert ( (signed) m_SegmentationCountInSlice[timeStep][0][x] + data.m_CountInX[0][x] >= 0 ); // just for debugging. This must always be true, otherwise some counting is going wrong
+    m_SegmentationCountInSlice[timeStep][0][x] = static_cast<unsigned int>( m_SegmentationCountInSlice[timeStep][0][x] + data.m_CountInX[0][x] );
+  }
+  for (unsigned int y = 0; y < sizeY; ++y)
+  {
+    assert ( (signed) m_SegmentationCountInSlice[timeStep][1][y] + data.m_CountInY[0][y] >= 0 );
+    m_SegmentationCountInSlice[timeStep][1][y] = static_cast<unsigned int>( m_SegmentationCountInSlice[timeStep][1][y] + data.m_CountInY[0][y] );
+  }
+  for (unsigned int z = 0; z < sizeZ; ++z)
+  {
+    assert ( (signed) m_SegmentationCountInSlice[timeStep][2][z] + data.m_CountInZ[z] >= 0 );
+    m_SegmentationCountInSlice[timeStep][2][z] = static_cast<unsigned int>( m_SegmentationCountInSlice[timeStep][2][z] + data.m_CountInZ[z] );
   }
 }
 
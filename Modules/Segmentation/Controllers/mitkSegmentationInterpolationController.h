@@ -181,6 +181,15 @@ class Segmentation_EXPORT SegmentationInterpolationController : public itk::Obje
     template < typename DATATYPE >
     void ScanWholeVolume( itk::Image<DATATYPE, 3>*, const Image* volume, unsigned int timeStep );
 
+    /**
+      \brief Adds the pixel values of a volume to the counts of a time step.
+
+      The slices are distributed to several threads, which keep partial counts for the x and y dimension
+      that are merged afterwards. Pixels with value 0, i.e. most pixels of a segmentation, are only skipped.
+    */
+    template < typename TPixel >
+    void ScanVolume( const TPixel* pixels, unsigned int sizeX, unsigned int sizeY, unsigned int sizeZ, unsigned int timeStep );
+
     void PrintStatus();
 
     /**
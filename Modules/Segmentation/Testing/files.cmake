@@ -4,6 +4,7 @@ set(MODULE_TESTS
   mitkDataNodeSegmentationTest.cpp
 #  mitkSegmentationInterpolationTest.cpp
   mitkOverwriteSliceFilterTest.cpp
+  mitkDiffSliceOperationTest.cpp
 #  mitkOverwriteSliceFilterObliquePlaneTest.cpp
   mitkContourModelTest.cpp
   mitkContourModelIOTest.cpp
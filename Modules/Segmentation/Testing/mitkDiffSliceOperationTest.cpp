@@ -0,0 +1,118 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkTestingMacros.h"
+
+#include <mitkDiffSliceOperation.h>
+#include <mitkDiffSliceOperationApplier.h>
+#include <mitkExtractSliceFilter.h>
+#include <mitkVtkImageOverwrite.h>
+#include <mitkImageCast.h>
+#include <mitkPlaneGeometry.h>
+
+#include <itkImage.h>
+
+#include <vtkImageData.h>
+#include <vtkSmartPointer.h>
+
+static const int VolumeSize = 32;
+static const int SliceIndex = 11;
+
+// the square that is painted into the slice
+static bool IsPainted(int x, int y, int z)
+{
+  return z == SliceIndex && x >= 5 && x < 20 && y >= 8 && y < 13;
+}
+
+/**Documentation
+ *  Test for the compression of DiffSliceOperation and applying its slice to the volume
+ */
+int mitkDiffSliceOperationTest(int /*argc*/, char* /*argv*/[])
+{
+  MITK_TEST_BEGIN("mitkDiffSliceOperationTest")
+
+  typedef itk::Image<unsigned char, 3> ImageType;
+  ImageType::Pointer itkImage = ImageType::New();
+  ImageType::IndexType start;
+  start.Fill(0);
+  ImageType::SizeType size;
+  size.Fill(VolumeSize);
+  ImageType::RegionType region(start, size);
+  itkImage->SetRegions(region);
+  itkImage->Allocate();
+  itkImage->FillBuffer(0);
+
+  mitk::Image::Pointer image;
+  mitk::CastToMitkImage(itkImage, image);
+
+  mitk::PlaneGeometry::Pointer plane = mitk::PlaneGeometry::New();
+  plane->InitializeStandardPlane(image->GetGeometry(), mitk::PlaneGeometry::Axial, SliceIndex, true, false);
+  mitk::Point3D origin = plane->GetOrigin();
+  mitk::Vector3D normal = plane->GetNormal();
+  normal.Normalize();
+  origin += normal * 0.5; // pixel spacing is 1, so this is the center of the slice
+  plane->SetOrigin(origin);
+
+  // extract the slice the way SegTool2D does and paint a square into it
+  vtkSmartPointer<mitkVtkImageOverwrite> reslice = vtkSmartPointer<mitkVtkImageOverwrite>::New();
+  mitk::ExtractSliceFilter::Pointer extractor = mitk::ExtractSliceFilter::New(reslice);
+  extractor->SetInput(image);
+  extractor->SetWorldGeometry(plane);
+  extractor->SetVtkOutputRequest(true);
+  extractor->Modified();
+  extractor->Update();
+
+  vtkSmartPointer<vtkImageData> slice = vtkSmartPointer<vtkImageData>::New();
+  slice->DeepCopy(extractor->GetVtkOutput());
+  for (int x = 0; x < VolumeSize; ++x)
+    for (int y = 0; y < VolumeSize; ++y)
+      if (IsPainted(x, y, SliceIndex))
+        slice->SetScalarComponentFromDouble(x, y, 0, 0, 1.0);
+
+  mitk::DiffSliceOperation* operation = new mitk::DiffSliceOperation(image, slice, plane, 0, plane);
+
+  operation->CompressSlice();
+  MITK_TEST_CONDITION(operation->IsValid(), "IsValid() after CompressSlice()")
+  MITK_TEST_CONDITION(operation->GetMemorySize() < static_cast<unsigned long>(VolumeSize*VolumeSize), "CompressSlice() reduces the memory size")
+
+  vtkSmartPointer<vtkImageData> decompressed = operation->GetSlice();
+  bool sameSlice = decompressed.GetPointer() != NULL;
+  for (int x = 0; sameSlice && x < VolumeSize; ++x)
+    for (int y = 0; sameSlice && y < VolumeSize; ++y)
+      sameSlice = decompressed->GetScalarComponentAsDouble(x, y, 0, 0) == slice->GetScalarComponentAsDouble(x, y, 0, 0);
+  MITK_TEST_CONDITION(sameSlice, "GetSlice() decompresses the slice")
+
+  // the returned slice stays valid when the operation drops its uncompressed copy
+  operation->DiscardUncompressedSlice();
+  MITK_TEST_CONDITION(decompressed->GetScalarComponentAsDouble(5, 8, 0, 0) == 1.0, "GetSlice() keeps the slice alive")
+
+  mitk::DiffSliceOperationApplier::GetInstance()->ExecuteOperation(operation);
+
+  bool applied = true;
+  mitk::Index3D index;
+  for (int x = 0; applied && x < VolumeSize; ++x)
+    for (int y = 0; applied && y < VolumeSize; ++y)
+      for (int z = 0; applied && z < VolumeSize; ++z)
+      {
+        index[0] = x; index[1] = y; index[2] = z;
+        applied = image->GetPixelValueByIndex(index) == (IsPainted(x, y, z) ? 1.0 : 0.0);
+      }
+  MITK_TEST_CONDITION(applied, "ExecuteOperation() writes the compressed slice into the volume")
+
+  delete static_cast<mitk::Operation*>(operation);
+
+  MITK_TEST_END()
+}
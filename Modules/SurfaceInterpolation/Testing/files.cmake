@@ -0,0 +1,3 @@
+set(MODULE_TESTS
+  mitkCreateDistanceImageFromSurfaceFilterTest.cpp
+)
@@ -0,0 +1,142 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkTestingMacros.h"
+#include "mitkCreateDistanceImageFromSurfaceFilter.h"
+#include "mitkImageReadAccessor.h"
+
+#include <itkImage.h>
+
+#include <vtkCellArray.h>
+#include <vtkCellData.h>
+#include <vtkDoubleArray.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+
+const double SphereRadius = 8.0;
+const unsigned int PointsPerContour = 36;
+
+/**
+ * One closed contour of a sphere at height z, like the contours that are drawn into the slices of an image.
+ * The normals point away from the center of the sphere; like the output of ComputeContourSetNormalsFilter
+ * they are stored as cell normals with one tuple per point.
+ */
+mitk::Surface::Pointer CreateSphereContour(double z)
+{
+  double contourRadius = std::sqrt(SphereRadius*SphereRadius - z*z);
+
+  vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
+  vtkSmartPointer<vtkDoubleArray> normals = vtkSmartPointer<vtkDoubleArray>::New();
+  normals->SetNumberOfComponents(3);
+  vtkSmartPointer<vtkCellArray> polys = vtkSmartPointer<vtkCellArray>::New();
+  polys->InsertNextCell(PointsPerContour);
+  for (unsigned int i = 0; i < PointsPerContour; i++)
+  {
+    double angle = 2.0 * 3.14159265358979 * i / PointsPerContour;
+    double point[3] = { contourRadius * std::cos(angle), contourRadius * std::sin(angle), z };
+    double normal[3] = { point[0] / SphereRadius, point[1] / SphereRadius, point[2] / SphereRadius };
+    polys->InsertCellPoint(points->InsertNextPoint(point));
+    normals->InsertNextTuple(normal);
+  }
+
+  vtkSmartPointer<vtkPolyData> polyData = vtkSmartPointer<vtkPolyData>::New();
+  polyData->SetPoints(points);
+  polyData->SetPolys(polys);
+  polyData->GetCellData()->SetNormals(normals);
+
+  mitk::Surface::Pointer contour = mitk::Surface::New();
+  contour->SetVtkPolyData(polyData);
+  return contour;
+}
+
+mitk::Image::Pointer CreateDistanceImage(unsigned int maximumNumberOfDenseCenters)
+{
+  typedef itk::Image<unsigned char, 3> ReferenceImageType;
+  ReferenceImageType::Pointer referenceImage = ReferenceImageType::New();
+  ReferenceImageType::SizeType size;
+  size.Fill(40);
+  ReferenceImageType::IndexType start;
+  start.Fill(0);
+  referenceImage->SetRegions(ReferenceImageType::RegionType(start, size));
+  ReferenceImageType::PointType origin;
+  origin.Fill(-20.0);
+  referenceImage->SetOrigin(origin);
+
+  mitk::CreateDistanceImageFromSurfaceFilter::Pointer filter = mitk::CreateDistanceImageFromSurfaceFilter::New();
+  filter->SetReferenceImage(referenceImage.GetPointer());
+  filter->SetMaximumNumberOfDenseCenters(maximumNumberOfDenseCenters);
+  unsigned int input = 0;
+  for (double z = -6.0; z <= 6.0; z += 3.0)
+  {
+    filter->SetInput(input++, CreateSphereContour(z));
+  }
+  filter->Update();
+  return filter->GetOutput();
+}
+
+}
+
+/**Documentation
+ *  Test for the two level interpolation of CreateDistanceImageFromSurfaceFilter: with few dense centers, the distance
+ *  image of contours of a sphere has to be close to the one obtained by the QR decomposition of the dense equation system
+ */
+int mitkCreateDistanceImageFromSurfaceFilterTest(int /*argc*/, char* /*argv*/[])
+{
+  MITK_TEST_BEGIN("CreateDistanceImageFromSurfaceFilter");
+
+  // 5 contours with 36 points and their inner and outer points give 540 centers
+  mitk::Image::Pointer denseImage = CreateDistanceImage(1500);
+  mitk::Image::Pointer twoLevelImage = CreateDistanceImage(150);
+
+  bool sameSize = denseImage->GetDimension() == 3 && twoLevelImage->GetDimension() == 3;
+  unsigned int numberOfVoxels = 1;
+  for (unsigned int i = 0; sameSize && i < 3; i++)
+  {
+    sameSize = denseImage->GetDimension(i) == twoLevelImage->GetDimension(i);
+    numberOfVoxels *= denseImage->GetDimension(i);
+  }
+  MITK_TEST_CONDITION_REQUIRED(sameSize, "Testing that the two level interpolation creates a distance image of the same size");
+
+  // the narrow band around the surface holds the interpolated distances, outside of it the images hold +-10 and 1000
+  double spacing = denseImage->GetGeometry()->GetSpacing()[0];
+  mitk::ImageReadAccessor denseAccessor(denseImage);
+  mitk::ImageReadAccessor twoLevelAccessor(twoLevelImage);
+  const double* dense = static_cast<const double*>(denseAccessor.GetData());
+  const double* twoLevel = static_cast<const double*>(twoLevelAccessor.GetData());
+
+  unsigned int numberOfSurfaceVoxels = 0;
+  double maximumDifference = 0.0;
+  for (unsigned int i = 0; i < numberOfVoxels; i++)
+  {
+    if (std::fabs(dense[i]) <= 0.5 * spacing)
+    {
+      ++numberOfSurfaceVoxels;
+      maximumDifference = std::max(maximumDifference, std::fabs(dense[i] - twoLevel[i]));
+    }
+  }
+  MITK_TEST_OUTPUT(<< numberOfSurfaceVoxels << " voxels near the surface, maximum difference " << maximumDifference << " at spacing " << spacing);
+  MITK_TEST_CONDITION_REQUIRED(numberOfSurfaceVoxels > 0, "Testing that the dense interpolation creates a surface");
+  MITK_TEST_CONDITION(maximumDifference < 0.5 * spacing, "Testing that the distances of the two level interpolation near the surface are within half a voxel of the dense interpolation");
+
+  MITK_TEST_END();
+}
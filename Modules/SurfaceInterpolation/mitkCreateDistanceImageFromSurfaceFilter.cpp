@@ -16,9 +16,41 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 #include "mitkCreateDistanceImageFromSurfaceFilter.h"
 
+#include <algorithm>
+#include <cmath>
+#include <set>
+
+namespace
+{
+  // orders points lexicographically, used to eliminate duplicated contour points
+  struct PointCompare
+  {
+    bool operator()(const mitk::CreateDistanceImageFromSurfaceFilter::PointType& a,
+                    const mitk::CreateDistanceImageFromSurfaceFilter::PointType& b) const
+    {
+      if (a[0] != b[0]) return a[0] < b[0];
+      if (a[1] != b[1]) return a[1] < b[1];
+      return a[2] < b[2];
+    }
+  };
+
+  // Wendland's C2 function, positive definite in 3D; r is relative to the support radius
+  inline double WendlandFunction(double r)
+  {
+    if (r >= 1.0)
+      return 0.0;
+    double t = 1.0 - r;
+    t *= t;
+    return t * t * (4.0 * r + 1.0);
+  }
+}
+
 mitk::CreateDistanceImageFromSurfaceFilter::CreateDistanceImageFromSurfaceFilter()
 {
   m_DistanceImageVolume = 50000;
+  m_MaximumNumberOfDenseCenters = 1500;
+  m_SupportRadius = 0.0;
+  m_UsedSupportRadius = 0.0;
   this->m_UseProgressBar = false;
   this->m_ProgressStepSize = 5;
 
@@ -35,10 +67,22 @@ void mitk::CreateDistanceImageFromSurfaceFilter::GenerateData()
 {
   //First of all we have to build the equation-system from the existing contour-edge-points
   this->CreateSolutionMatrixAndFunctionValues();
+  this->AbortIfRequested();
 
-  //Then we solve the equation-system via QR - decomposition. The interpolation weights are obtained in that way
-  vnl_qr<double> solver (m_SolutionMatrix);
-  m_Weights = solver.solve(m_FunctionValues);
+  if ( m_Centers.size() <= m_MaximumNumberOfDenseCenters )
+  {
+    //Then we solve the equation-system via QR - decomposition. The interpolation weights are obtained in that way
+    vnl_qr<double> solver (m_SolutionMatrix);
+    m_Weights = solver.solve(m_FunctionValues);
+    this->SetGlobalInterpolation(m_Centers, m_Weights);
+  }
+  else
+  {
+    //QR - decomposition of the whole system would take far too long
+    this->SolveTwoLevelSystem();
+  }
+
+  this->AbortIfRequested();
 
   //Setting progressbar
   if (this->m_UseProgressBar)
@@ -46,15 +90,35 @@ void mitk::CreateDistanceImageFromSurfaceFilter::GenerateData()
 
   //The last step is to create the distance map with the interpolated distance function
   this->CreateDistanceImage();
+  this->ClearInterpolationData();
+
+  //Setting progressbar
+  if (this->m_UseProgressBar)
+    mitk::ProgressBar::GetInstance()->Progress(3);
+}
+
+void mitk::CreateDistanceImageFromSurfaceFilter::ClearInterpolationData()
+{
   m_Centers.clear();
   m_FunctionValues.clear();
   m_Normals.clear();
   m_Weights.clear();
   m_SolutionMatrix.clear();
+  m_GlobalCenterCoordinates.clear();
+  m_GlobalWeights.clear();
+  m_LocalWeights.clear();
+  m_GridCells.clear();
+  m_GridCellStart.clear();
+  m_GridCenterIds.clear();
+}
 
-  //Setting progressbar
-  if (this->m_UseProgressBar)
-    mitk::ProgressBar::GetInstance()->Progress(3);
+void mitk::CreateDistanceImageFromSurfaceFilter::AbortIfRequested()
+{
+  if (this->GetAbortGenerateData())
+  {
+    this->ClearInterpolationData();
+    throw itk::ProcessAborted(__FILE__, __LINE__);
+  }
 }
 
 void mitk::CreateDistanceImageFromSurfaceFilter::CreateSolutionMatrixAndFunctionValues()
@@ -80,6 +144,7 @@ void mitk::CreateDistanceImageFromSurfaceFilter::CreateSolutionMatrixAndFunction
   double p[3];
   PointType currentPoint;
   PointType normal;
+  std::set<PointType, PointCompare> existingCenters;
 
   for (unsigned int i = 0; i < numberOfInputs; i++)
   {
@@ -110,9 +175,7 @@ void mitk::CreateDistanceImageFromSurfaceFilter::CreateSolutionMatrixAndFunction
 
         currentPoint.copy_in(p);
 
-        int count = std::count(m_Centers.begin() ,m_Centers.end(),currentPoint);
-
-        if (count == 0)
+        if ( existingCenters.insert(currentPoint).second )
         {
           double currentNormal[3];
           currentCellNormals->GetTuple(cell[j], currentNormal);
@@ -167,28 +230,225 @@ void mitk::CreateDistanceImageFromSurfaceFilter::CreateSolutionMatrixAndFunction
 
   //Now we have created all centers and all function values. Next step is to create the solution matrix
   numberOfCenters = m_Centers.size();
-  m_SolutionMatrix.set_size(numberOfCenters, numberOfCenters);
-
   m_Weights.set_size(numberOfCenters);
 
-  PointType p1;
-  PointType p2;
-  double norm;
+  //Larger systems are not solved directly, see SolveTwoLevelSystem()
+  if (numberOfCenters <= m_MaximumNumberOfDenseCenters)
+  {
+    CreateSolutionMatrix(m_Centers, m_SolutionMatrix);
+  }
+}
+
+void mitk::CreateDistanceImageFromSurfaceFilter::CreateSolutionMatrix(const CenterList& centers, SolutionMatrix& matrix)
+{
+  unsigned int numberOfCenters = centers.size();
+  matrix.set_size(numberOfCenters, numberOfCenters);
 
   for (unsigned int i = 0; i < numberOfCenters; i++)
   {
-    for (unsigned int j = 0; j < numberOfCenters; j++)
+    matrix(i,i) = 0.0;
+    for (unsigned int j = i+1; j < numberOfCenters; j++)
     {
       //Calculate the RBF value. Currently using Phi(r) = r with r is the euclidian distance between two points
-      p1 = m_Centers.at(i);
-      p2 = m_Centers.at(j);
-      p1 = p1 - p2;
-      norm = p1.two_norm();
-      m_SolutionMatrix(i,j) = norm;
+      double norm = (centers[i] - centers[j]).two_norm();
+      matrix(i,j) = norm;
+      matrix(j,i) = norm;
+    }
+  }
+}
+
+void mitk::CreateDistanceImageFromSurfaceFilter::SetGlobalInterpolation(const CenterList& centers, const InterpolationWeights& weights)
+{
+  m_GlobalCenterCoordinates.resize(centers.size()*3);
+  for (unsigned int i = 0; i < centers.size(); i++)
+  {
+    m_GlobalCenterCoordinates[3*i]   = centers[i][0];
+    m_GlobalCenterCoordinates[3*i+1] = centers[i][1];
+    m_GlobalCenterCoordinates[3*i+2] = centers[i][2];
+  }
+  m_GlobalWeights.assign(weights.begin(), weights.end());
+}
+
+void mitk::CreateDistanceImageFromSurfaceFilter::SolveTwoLevelSystem()
+{
+  //m_Centers holds the contour points, followed by all inner and all outer points
+  const unsigned int numberOfCenters = m_Centers.size();
+  const unsigned int numberOfContourPoints = numberOfCenters / 3;
+  m_LocalWeights.clear();
+
+  //1. Dense interpolation of every stride-th contour point together with its inner and outer point
+  const unsigned int maximumNumberOfDenseCenters = std::max(m_MaximumNumberOfDenseCenters, 3u);
+  const unsigned int stride = (numberOfCenters + maximumNumberOfDenseCenters - 1) / maximumNumberOfDenseCenters;
+
+  CenterList coarseCenters;
+  FunctionValues coarseValues(3 * ((numberOfContourPoints + stride - 1) / stride));
+  for (unsigned int level = 0; level < 3; level++)
+  {
+    for (unsigned int i = 0; i < numberOfContourPoints; i += stride)
+    {
+      coarseValues[coarseCenters.size()] = m_FunctionValues[level*numberOfContourPoints + i];
+      coarseCenters.push_back(m_Centers[level*numberOfContourPoints + i]);
+    }
+  }
+
+  CreateSolutionMatrix(coarseCenters, m_SolutionMatrix);
+  vnl_qr<double> solver (m_SolutionMatrix);
+  this->SetGlobalInterpolation(coarseCenters, solver.solve(coarseValues));
+
+  //2. The compactly supported functions have to bridge the gaps between the subsampled contour points
+  m_UsedSupportRadius = m_SupportRadius;
+  if (m_UsedSupportRadius <= 0.0)
+  {
+    std::vector<double> steps;
+    steps.reserve(numberOfContourPoints);
+    for (unsigned int i = 1; i < numberOfContourPoints; i++)
+    {
+      steps.push_back((m_Centers[i] - m_Centers[i-1]).two_norm());
+    }
+    double medianStep = 1.0;
+    if (!steps.empty())
+    {
+      std::nth_element(steps.begin(), steps.begin() + steps.size()/2, steps.end());
+      medianStep = steps[steps.size()/2];
+    }
+    //inner and outer points lie 1mm away from the contour and must always be coupled to it
+    m_UsedSupportRadius = std::max(2.5 * stride * medianStep, 3.0);
+  }
+  this->CreateCenterGrid();
+
+  //3. Remaining error of the dense interpolation at all centers (m_LocalWeights is still empty)
+  std::vector<double> coarseDistances;
+  this->CalculateDistanceValues(m_Centers, coarseDistances);
+
+  std::vector<double> residual(numberOfCenters);
+  double residualNorm(0);
+  for (unsigned int i = 0; i < numberOfCenters; i++)
+  {
+    residual[i] = m_FunctionValues[i] - coarseDistances[i];
+    residualNorm += residual[i]*residual[i];
+  }
+
+  //4. Sparse matrix of the compactly supported functions, one row after the other
+  std::vector<unsigned int> rowStart(1, 0);
+  std::vector<unsigned int> columns;
+  std::vector<double> values;
+  unsigned int begin, end;
+  for (unsigned int i = 0; i < numberOfCenters; i++)
+  {
+    for (int z = -1; z <= 1; z++)
+      for (int y = -1; y <= 1; y++)
+        for (int x = -1; x <= 1; x++)
+        {
+          this->GetCentersInCell(this->GetGridCell(m_Centers[i], x, y, z), begin, end);
+          for (unsigned int k = begin; k < end; k++)
+          {
+            unsigned int j = m_GridCenterIds[k];
+            double r = (m_Centers[i] - m_Centers[j]).two_norm() / m_UsedSupportRadius;
+            if (r < 1.0)
+            {
+              columns.push_back(j);
+              values.push_back(WendlandFunction(r));
+            }
+          }
+        }
+    rowStart.push_back(columns.size());
+  }
+
+  //5. The matrix is symmetric and positive definite, so we can use conjugate gradients
+  std::vector<double> weights(numberOfCenters, 0.0);
+  std::vector<double> direction(residual);
+  std::vector<double> product(numberOfCenters);
+  const double tolerance = 1e-12 * residualNorm;
+  const unsigned int maximumNumberOfIterations = std::max(1000u, numberOfCenters / 10);
+  unsigned int iteration = 0;
+  for (; iteration < maximumNumberOfIterations && residualNorm > tolerance; iteration++)
+  {
+    this->AbortIfRequested();
+
+    double directionProduct(0);
+    for (unsigned int i = 0; i < numberOfCenters; i++)
+    {
+      double sum(0);
+      for (unsigned int k = rowStart[i]; k < rowStart[i+1]; k++)
+      {
+        sum += values[k] * direction[columns[k]];
+      }
+      product[i] = sum;
+      directionProduct += direction[i] * sum;
+    }
+
+    double alpha = residualNorm / directionProduct;
+    double newResidualNorm(0);
+    for (unsigned int i = 0; i < numberOfCenters; i++)
+    {
+      weights[i] += alpha * direction[i];
+      residual[i] -= alpha * product[i];
+      newResidualNorm += residual[i]*residual[i];
+    }
 
+    double beta = newResidualNorm / residualNorm;
+    residualNorm = newResidualNorm;
+    for (unsigned int i = 0; i < numberOfCenters; i++)
+    {
+      direction[i] = residual[i] + beta * direction[i];
     }
   }
 
+  if (residualNorm > tolerance)
+  {
+    MITK_WARN << "mitk::CreateDistanceImageFromSurfaceFilter: Interpolation did not converge within " << iteration << " iterations";
+  }
+
+  m_LocalWeights.set_size(numberOfCenters);
+  m_LocalWeights.copy_in(&weights[0]);
+}
+
+long long mitk::CreateDistanceImageFromSurfaceFilter::GetGridCell(const PointType& p, int offsetX, int offsetY, int offsetZ) const
+{
+  //21 bits per dimension, shifted to be positive
+  const long long shift = 1 << 20;
+  long long x = static_cast<long long>(std::floor(p[0] / m_UsedSupportRadius)) + offsetX + shift;
+  long long y = static_cast<long long>(std::floor(p[1] / m_UsedSupportRadius)) + offsetY + shift;
+  long long z = static_cast<long long>(std::floor(p[2] / m_UsedSupportRadius)) + offsetZ + shift;
+  return (x << 42) | (y << 21) | z;
+}
+
+void mitk::CreateDistanceImageFromSurfaceFilter::CreateCenterGrid()
+{
+  std::vector< std::pair<long long, unsigned int> > cells(m_Centers.size());
+  for (unsigned int i = 0; i < m_Centers.size(); i++)
+  {
+    cells[i] = std::make_pair(this->GetGridCell(m_Centers[i]), i);
+  }
+  std::sort(cells.begin(), cells.end());
+
+  m_GridCells.clear();
+  m_GridCellStart.clear();
+  m_GridCenterIds.resize(cells.size());
+  for (unsigned int i = 0; i < cells.size(); i++)
+  {
+    m_GridCenterIds[i] = cells[i].second;
+    if (i == 0 || cells[i].first != cells[i-1].first)
+    {
+      m_GridCells.push_back(cells[i].first);
+      m_GridCellStart.push_back(i);
+    }
+  }
+  m_GridCellStart.push_back(cells.size());
+}
+
+void mitk::CreateDistanceImageFromSurfaceFilter::GetCentersInCell(long long cell, unsigned int& begin, unsigned int& end) const
+{
+  std::vector<long long>::const_iterator cellIter = std::lower_bound(m_GridCells.begin(), m_GridCells.end(), cell);
+  if (cellIter == m_GridCells.end() || *cellIter != cell)
+  {
+    begin = end = 0;
+    return;
+  }
+
+  unsigned int cellId = cellIter - m_GridCells.begin();
+  begin = m_GridCellStart[cellId];
+  end = m_GridCellStart[cellId+1];
 }
 
 void mitk::CreateDistanceImageFromSurfaceFilter::CreateDistanceImage()
@@ -282,13 +542,12 @@ void mitk::CreateDistanceImageFromSurfaceFilter::CreateDistanceImage()
   * Now we must calculate the distance for each pixel. But instead of calculating the distance value
   * for all of the image's pixels we proceed similar to the region growing algorithm:
   *
-  * 1. Take the first pixel from the narrowband_point_list and calculate the distance for each neighbor (6er)
-  * 2. If the current index's distance value is below a certain threshold push it into the list
-  * 3. Next iteration take the next index from the list and originAsIndex with 1. again
+  * 1. Take the pixels of the current front and calculate the distance for each neighbor (6er)
+  * 2. If the neighbor's distance value is below a certain threshold it belongs to the next front
+  * 3. Next iteration continue with the next front and 1. again
   *
-  * This is done until the narrowband_point_list is empty.
+  * This is done until the front is empty.
   */
-  std::queue<DistanceImageType::IndexType> narrowbandPoints;
   PointType currentPoint = m_Centers.at(0);
   double distance = this->CalculateDistanceValue(currentPoint);
 
@@ -304,7 +563,6 @@ void mitk::CreateDistanceImageFromSurfaceFilter::CreateDistanceImage()
 
   assert( lpRegion.IsInside(currentIndex) ); // we are quite certain this should hold
 
-  narrowbandPoints.push(currentIndex);
   distanceImg->SetPixel(currentIndex, distance);
 
   NeighborhoodImageIterator::RadiusType radius;
@@ -312,39 +570,66 @@ void mitk::CreateDistanceImageFromSurfaceFilter::CreateDistanceImage()
   NeighborhoodImageIterator nIt(radius, distanceImg, distanceImg->GetLargestPossibleRegion());
   unsigned int relativeNbIdx[] = {4, 10, 12, 14, 16, 22};
 
+  // The band is grown front by front: all not yet visited neighbors of the current
+  // front are collected first, so that their distances can be calculated in parallel
+  std::vector<DistanceImageType::IndexType> front(1, currentIndex);
+  std::vector<DistanceImageType::IndexType> candidates;
+  std::vector<PointType> candidatePoints;
+  std::vector<double> candidateDistances;
+  std::vector<bool> isCandidate(lpRegion.GetNumberOfPixels(), false);
+
   bool isInBounds = false;
-  while ( !narrowbandPoints.empty() )
+  while ( !front.empty() )
   {
+    this->AbortIfRequested();
 
-    nIt.SetLocation(narrowbandPoints.front());
-    narrowbandPoints.pop();
+    candidates.clear();
+    candidatePoints.clear();
 
-    unsigned int* relativeNb = &relativeNbIdx[0];
-    for (int i = 0; i < 6; i++)
+    for (std::vector<DistanceImageType::IndexType>::iterator frontIter = front.begin(); frontIter != front.end(); ++frontIter)
     {
-      nIt.GetPixel(*relativeNb, isInBounds);
-      if( isInBounds && nIt.GetPixel(*relativeNb) == 10)
-      {
-        currentIndex = nIt.GetIndex(*relativeNb);
-
-        // Transform the currently checked point from index-coordinates to
-        // world-coordinates
-        distanceImg->TransformIndexToPhysicalPoint( currentIndex, currentPointAsPoint );
+      nIt.SetLocation(*frontIter);
 
-        // create a vnl_vector
-        currentPoint[0] = currentPointAsPoint[0];
-        currentPoint[1] = currentPointAsPoint[1];
-        currentPoint[2] = currentPointAsPoint[2];
-
-        // and check the distance
-        distance = this->CalculateDistanceValue(currentPoint);
-        if ( abs(distance) <= m_DistanceImageSpacing )
+      unsigned int* relativeNb = &relativeNbIdx[0];
+      for (int i = 0; i < 6; i++)
+      {
+        nIt.GetPixel(*relativeNb, isInBounds);
+        if( isInBounds && nIt.GetPixel(*relativeNb) == 10)
         {
-          nIt.SetPixel(*relativeNb, distance);
-          narrowbandPoints.push(currentIndex);
+          currentIndex = nIt.GetIndex(*relativeNb);
+          DistanceImageType::OffsetValueType offset = distanceImg->ComputeOffset(currentIndex);
+          if (!isCandidate[offset])
+          {
+            isCandidate[offset] = true;
+            candidates.push_back(currentIndex);
+
+            // Transform the currently checked point from index-coordinates to
+            // world-coordinates
+            distanceImg->TransformIndexToPhysicalPoint( currentIndex, currentPointAsPoint );
+
+            // create a vnl_vector
+            currentPoint[0] = currentPointAsPoint[0];
+            currentPoint[1] = currentPointAsPoint[1];
+            currentPoint[2] = currentPointAsPoint[2];
+            candidatePoints.push_back(currentPoint);
+          }
         }
+        relativeNb++;
+      }
+    }
+
+    // and check the distances
+    this->CalculateDistanceValues(candidatePoints, candidateDistances);
+
+    front.clear();
+    for (unsigned int i = 0; i < candidates.size(); i++)
+    {
+      isCandidate[distanceImg->ComputeOffset(candidates[i])] = false;
+      if ( std::fabs(candidateDistances[i]) <= m_DistanceImageSpacing )
+      {
+        distanceImg->SetPixel(candidates[i], candidateDistances[i]);
+        front.push_back(candidates[i]);
       }
-      relativeNb++;
     }
   }
 
@@ -422,6 +707,7 @@ void mitk::CreateDistanceImageFromSurfaceFilter::CreateDistanceImage()
   // Now we make some kind of region growing from the middle of the image to set all
   // inner pixels to -10. In this way we assure to extract a valid surface
   NeighborhoodImageIterator nIt2(radius, distanceImg, distanceImg->GetLargestPossibleRegion());
+  std::queue<DistanceImageType::IndexType> narrowbandPoints;
 
   currentIndex[0] = distanceImg->GetLargestPossibleRegion().GetSize()[0]*0.5;
   currentIndex[1] = distanceImg->GetLargestPossibleRegion().GetSize()[1]*0.5;
@@ -468,28 +754,86 @@ void mitk::CreateDistanceImageFromSurfaceFilter::FillImageRegion(DistanceImageTy
 }
 
 
-double mitk::CreateDistanceImageFromSurfaceFilter::CalculateDistanceValue(PointType p)
+double mitk::CreateDistanceImageFromSurfaceFilter::CalculateDistanceValue(const PointType& p) const
 {
   double distanceValue (0);
-  PointType p1;
-  PointType p2;
-  double norm;
 
-  CenterList::iterator centerIter;
-  InterpolationWeights::iterator weightsIter;
+  const double* center = m_GlobalCenterCoordinates.empty() ? NULL : &m_GlobalCenterCoordinates[0];
+  for (unsigned int i = 0; i < m_GlobalWeights.size(); i++, center += 3)
+  {
+    //Phi(r) = r with r is the euclidian distance between p and the center
+    double dx = p[0] - center[0];
+    double dy = p[1] - center[1];
+    double dz = p[2] - center[2];
+    distanceValue += m_GlobalWeights[i] * std::sqrt(dx*dx + dy*dy + dz*dz);
+  }
 
-  for ( centerIter=m_Centers.begin(), weightsIter=m_Weights.begin();
-    centerIter!=m_Centers.end(), weightsIter!=m_Weights.end();
-    centerIter++, weightsIter++ )
+  if (!m_LocalWeights.empty())
   {
-    p1 = *centerIter;
-    p2 = p-p1;
-    norm = p2.two_norm();
-    distanceValue = distanceValue + norm* (*weightsIter);
+    //only centers in the neighboring grid cells can be closer than the support radius
+    unsigned int begin, end;
+    for (int z = -1; z <= 1; z++)
+      for (int y = -1; y <= 1; y++)
+        for (int x = -1; x <= 1; x++)
+        {
+          this->GetCentersInCell(this->GetGridCell(p, x, y, z), begin, end);
+          for (unsigned int k = begin; k < end; k++)
+          {
+            unsigned int j = m_GridCenterIds[k];
+            double r = (p - m_Centers[j]).two_norm() / m_UsedSupportRadius;
+            distanceValue += m_LocalWeights[j] * WendlandFunction(r);
+          }
+        }
   }
+
   return distanceValue;
 }
 
+void mitk::CreateDistanceImageFromSurfaceFilter::CalculateDistanceValues(const std::vector<PointType>& points, std::vector<double>& distances)
+{
+  distances.resize(points.size());
+
+  DistanceThreadData threadData;
+  threadData.m_Filter = this;
+  threadData.m_Points = &points;
+  threadData.m_Distances = &distances;
+
+  // starting threads does not pay off for a few points
+  unsigned int numberOfThreads = std::min<unsigned int>(this->GetNumberOfThreads(), points.size() / 64);
+  if (numberOfThreads > 1)
+  {
+    itk::MultiThreader::Pointer threader = itk::MultiThreader::New();
+    threader->SetNumberOfThreads(numberOfThreads);
+    threader->SetSingleMethod(CalculateDistanceValuesThread, &threadData);
+    threader->SingleMethodExecute();
+  }
+  else
+  {
+    for (unsigned int i = 0; i < points.size(); i++)
+    {
+      distances[i] = this->CalculateDistanceValue(points[i]);
+    }
+  }
+}
+
+ITK_THREAD_RETURN_TYPE mitk::CreateDistanceImageFromSurfaceFilter::CalculateDistanceValuesThread(void* pInfoStruct)
+{
+  itk::MultiThreader::ThreadInfoStruct* threadInfo = static_cast<itk::MultiThreader::ThreadInfoStruct*>(pInfoStruct);
+  DistanceThreadData* threadData = static_cast<DistanceThreadData*>(threadInfo->UserData);
+
+  const std::vector<PointType>& points = *threadData->m_Points;
+  std::vector<double>& distances = *threadData->m_Distances;
+
+  unsigned int begin = points.size() * threadInfo->ThreadID / threadInfo->NumberOfThreads;
+  unsigned int end = points.size() * (threadInfo->ThreadID + 1) / threadInfo->NumberOfThreads;
+  for (unsigned int i = begin; i < end; i++)
+  {
+    distances[i] = threadData->m_Filter->CalculateDistanceValue(points[i]);
+  }
+
+  return ITK_THREAD_RETURN_VALUE;
+}
+
 void mitk::CreateDistanceImageFromSurfaceFilter::GenerateOutputInformation()
 {
 }
@@ -37,6 +37,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "itkImageBase.h"
 #include "itkImageRegionIteratorWithIndex.h"
 #include "itkNeighborhoodIterator.h"
+#include "itkMultiThreader.h"
 
 #include <queue>
 
@@ -63,6 +64,12 @@ namespace mitk {
          With this interpolated distance function a distance image will be created. The desired surface can then be extract e.g.
          with the marching cubes algorithm. (Within the  distance image the surface goes exactly where the pixelvalues are zero)
 
+         The interpolation weights of up to MaximumNumberOfDenseCenters centers are obtained by a QR decomposition
+         of the dense equation system. For more centers this is too expensive, so the distance function is built in two
+         levels instead: the dense interpolation of a regular subset of the contour points yields the overall shape, its
+         remaining error at all centers is interpolated by compactly supported radial basis functions. The equation system
+         of the second level is sparse and positive definite and is solved by conjugate gradients.
+
          Note that the obtained distance image has always an isotropig spacing. The size (in this case volume) of the image can be
          adjusted by calling SetDistanceImageVolume(unsigned int volume) which specifies the number ob pixels enclosed by the image.
 
@@ -114,6 +121,20 @@ namespace mitk {
     */
     itkSetMacro(DistanceImageVolume, unsigned int);
 
+    /**
+    \brief Set the maximum number of centers for which the dense equation system is solved directly.
+           Larger inputs are interpolated in two levels, see class description. Default is 1500.
+    */
+    itkSetMacro(MaximumNumberOfDenseCenters, unsigned int);
+    itkGetConstMacro(MaximumNumberOfDenseCenters, unsigned int);
+
+    /**
+    \brief Set the support radius (in mm) of the compactly supported basis functions of the two level interpolation.
+           If 0 (default) the radius is derived from the spacing of the contour points.
+    */
+    itkSetMacro(SupportRadius, double);
+    itkGetConstMacro(SupportRadius, double);
+
     void PrintEquationSystem();
 
     //Resets the filter, i.e. removes all inputs and outputs
@@ -146,7 +167,40 @@ namespace mitk {
   private:
 
     void CreateSolutionMatrixAndFunctionValues();
-    double CalculateDistanceValue(PointType p);
+    double CalculateDistanceValue(const PointType& p) const;
+
+    /// Fills the matrix of the radial basis function Phi(r) = r for the given centers
+    static void CreateSolutionMatrix(const CenterList& centers, SolutionMatrix& matrix);
+
+    /// Uses the weights of the dense interpolation of all centers for CalculateDistanceValue()
+    void SetGlobalInterpolation(const CenterList& centers, const InterpolationWeights& weights);
+
+    /// Frees the equation system and the interpolation weights
+    void ClearInterpolationData();
+
+    /// Throws itk::ProcessAborted if AbortGenerateDataOn() was called, e.g. because the contours changed
+    void AbortIfRequested();
+
+    /// Dense interpolation of a subset of the centers, refined by compactly supported basis functions
+    void SolveTwoLevelSystem();
+
+    /// Sorts the centers into cells of the size of the support radius
+    void CreateCenterGrid();
+    long long GetGridCell(const PointType& p, int offsetX = 0, int offsetY = 0, int offsetZ = 0) const;
+    /// Range of m_GridCenterIds that lies in cell, empty if there are no centers in it
+    void GetCentersInCell(long long cell, unsigned int& begin, unsigned int& end) const;
+
+    /// Calls CalculateDistanceValue() for all points, using several threads
+    void CalculateDistanceValues(const std::vector<PointType>& points, std::vector<double>& distances);
+
+    struct DistanceThreadData
+    {
+      const CreateDistanceImageFromSurfaceFilter* m_Filter;
+      const std::vector<PointType>* m_Points;
+      std::vector<double>* m_Distances;
+    };
+
+    static ITK_THREAD_RETURN_TYPE CalculateDistanceValuesThread(void* pInfoStruct);
 
     void CreateDistanceImage ();
 
@@ -180,6 +234,20 @@ namespace mitk {
     SolutionMatrix m_SolutionMatrix;
     double m_DistanceImageSpacing;
 
+    // centers and weights of Phi(r) = r, stored as x,y,z triples for fast evaluation
+    std::vector<double> m_GlobalCenterCoordinates;
+    std::vector<double> m_GlobalWeights;
+
+    // weights of the compactly supported basis functions at m_Centers, empty for the dense interpolation
+    InterpolationWeights m_LocalWeights;
+    double m_UsedSupportRadius;
+    std::vector<long long> m_GridCells;
+    std::vector<unsigned int> m_GridCellStart;
+    std::vector<unsigned int> m_GridCenterIds;
+
+    unsigned int m_MaximumNumberOfDenseCenters;
+    double m_SupportRadius;
+
     itk::ImageBase<3>::Pointer m_ReferenceImage;
 
     unsigned int m_DistanceImageVolume;
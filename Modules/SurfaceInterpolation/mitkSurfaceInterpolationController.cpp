@@ -22,7 +22,13 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "mitkImageToSurfaceFilter.h"
 
 mitk::SurfaceInterpolationController::SurfaceInterpolationController()
-  :m_SelectedSegmentation(0)
+  : m_MinSpacing(0),
+    m_MaxSpacing(0),
+    m_WorkingImage(0),
+    m_DistImageVolume(50000),
+    m_SelectedSegmentation(0),
+    m_ContourListGeneration(1),
+    m_InterpolatedGeneration(0)
 {
   m_ReduceFilter = ReduceContourSetFilter::New();
   m_NormalsFilter = ComputeContourSetNormalsFilter::New();
@@ -82,9 +88,12 @@ void mitk::SurfaceInterpolationController::AddNewContour (mitk::Surface::Pointer
   mitk::Vector3D direction = op->GetDirectionVector();
   int pos (-1);
 
-  for (unsigned int i = 0; i < m_MapOfContourLists[m_SelectedSegmentation].size(); i++)
+  m_ContourListMutex.Lock();
+  ContourPositionPairList& contourList = m_MapOfContourLists[m_SelectedSegmentation];
+
+  for (unsigned int i = 0; i < contourList.size(); i++)
   {
-      itk::Matrix<float> diffM = transform->GetMatrix()-m_MapOfContourLists[m_SelectedSegmentation].at(i).position->GetTransform()->GetMatrix();
+      itk::Matrix<float> diffM = transform->GetMatrix()-contourList.at(i).position->GetTransform()->GetMatrix();
       bool isSameMatrix(true);
       for (unsigned int j = 0; j < 3; j++)
       {
@@ -94,8 +103,8 @@ void mitk::SurfaceInterpolationController::AddNewContour (mitk::Surface::Pointer
           break;
         }
       }
-      itk::Vector<float> diffV = m_MapOfContourLists[m_SelectedSegmentation].at(i).position->GetTransform()->GetOffset()-transform->GetOffset();
-      if ( isSameMatrix && m_MapOfContourLists[m_SelectedSegmentation].at(i).position->GetPos() == op->GetPos() && (fabs(diffV[0]) < 0.0001 && fabs(diffV[1]) < 0.0001 && fabs(diffV[2]) < 0.0001) )
+      itk::Vector<float> diffV = contourList.at(i).position->GetTransform()->GetOffset()-transform->GetOffset();
+      if ( isSameMatrix && contourList.at(i).position->GetPos() == op->GetPos() && (fabs(diffV[0]) < 0.0001 && fabs(diffV[1]) < 0.0001 && fabs(diffV[2]) < 0.0001) )
       {
         pos = i;
         break;
@@ -112,34 +121,134 @@ void mitk::SurfaceInterpolationController::AddNewContour (mitk::Surface::Pointer
     newData.contour = newContour;
     newData.position = newOp;
 
-    m_ReduceFilter->SetInput(m_MapOfContourLists[m_SelectedSegmentation].size(), newContour);
-    m_MapOfContourLists[m_SelectedSegmentation].push_back(newData);
+    contourList.push_back(newData);
+    this->ContoursChanged();
   }
   //Edit a existing contour. If the contour is empty, edit it anyway so that the interpolation will always be consistent
   else if (pos != -1)
   {
-    m_MapOfContourLists[m_SelectedSegmentation].at(pos).contour = newContour;
-    m_ReduceFilter->SetInput(pos, newContour);
+    contourList.at(pos).contour = newContour;
+    this->ContoursChanged();
   }
+  m_ContourListMutex.Unlock();
 
-  m_ReduceFilter->Update();
-  m_CurrentNumberOfReducedContours = m_ReduceFilter->GetNumberOfOutputs();
+  // contours are reduced by Interpolate(), which usually runs in the background
+  this->Modified();
+}
 
-  for (unsigned int i = 0; i < m_CurrentNumberOfReducedContours; i++)
-  {
-    m_NormalsFilter->SetInput(i, m_ReduceFilter->GetOutput(i));
-    m_InterpolateSurfaceFilter->SetInput(i, m_NormalsFilter->GetOutput(i));
-  }
+void mitk::SurfaceInterpolationController::ContoursChanged()
+{
+  ++m_ContourListGeneration;
 
-  this->Modified();
+  // a running interpolation would be outdated anyway
+  m_InterpolateSurfaceFilter->AbortGenerateDataOn();
+}
+
+bool mitk::SurfaceInterpolationController::IsGenerationOutdated(unsigned long generation)
+{
+  m_ContourListMutex.Lock();
+  bool outdated = generation != m_ContourListGeneration;
+  m_ContourListMutex.Unlock();
+  return outdated;
+}
+
+bool mitk::SurfaceInterpolationController::IsInterpolationOutdated()
+{
+  m_ContourListMutex.Lock();
+  bool outdated = m_InterpolatedGeneration != m_ContourListGeneration;
+  m_ContourListMutex.Unlock();
+  return outdated;
 }
 
 void mitk::SurfaceInterpolationController::Interpolate()
 {
-  if (m_CurrentNumberOfReducedContours< 2)
+  // work on a copy, contours may be added while we are interpolating
+  m_ContourListMutex.Lock();
+  const unsigned long generation = m_ContourListGeneration;
+  if (generation == m_InterpolatedGeneration)
+  {
+    // nothing changed, the last result is still valid
+    m_ContourListMutex.Unlock();
+    return;
+  }
+
+  std::vector<Surface::Pointer> contours;
+  ContourListMap::iterator listIter = m_MapOfContourLists.find(m_SelectedSegmentation);
+  if (m_SelectedSegmentation != 0 && listIter != m_MapOfContourLists.end())
+  {
+    for (unsigned int i = 0; i < listIter->second.size(); i++)
+    {
+      contours.push_back(listIter->second.at(i).contour);
+    }
+  }
+  const double minSpacing = m_MinSpacing;
+  const double maxSpacing = m_MaxSpacing;
+  const unsigned int distImageVolume = m_DistImageVolume;
+  Image* workingImage = m_WorkingImage;
+  itk::ImageBase<3>::Pointer referenceImage = m_ReferenceImage;
+  m_ContourListMutex.Unlock();
+
+  // remove the contours of a previously selected segmentation
+  if (contours.size() < m_ReduceFilter->GetNumberOfIndexedInputs())
+  {
+    m_ReduceFilter->Reset();
+  }
+
+  // filters are only modified if parameters or inputs really changed, so unchanged stages are not executed again
+  if (minSpacing > 0)
+  {
+    m_ReduceFilter->SetMinSpacing(minSpacing);
+  }
+  if (maxSpacing > 0)
+  {
+    m_ReduceFilter->SetMaxSpacing(maxSpacing);
+    m_NormalsFilter->SetMaxSpacing(maxSpacing);
+  }
+  m_NormalsFilter->SetSegmentationBinaryImage(workingImage);
+  m_InterpolateSurfaceFilter->SetDistanceImageVolume(distImageVolume);
+  if (referenceImage.IsNotNull())
+  {
+    m_InterpolateSurfaceFilter->SetReferenceImage(referenceImage);
+  }
+
+  m_CurrentNumberOfReducedContours = 0;
+  if (!contours.empty())
+  {
+    for (unsigned int i = 0; i < contours.size(); i++)
+    {
+      m_ReduceFilter->SetInput(i, contours[i]);
+    }
+    m_ReduceFilter->Update();
+    m_CurrentNumberOfReducedContours = m_ReduceFilter->GetNumberOfOutputs();
+  }
+
+  if (m_CurrentNumberOfReducedContours < 2)
   {
     //If no interpolation is possible reset the interpolation result
-    m_InterpolationResult = 0;
+    m_ContourListMutex.Lock();
+    if (generation == m_ContourListGeneration)
+    {
+      m_InterpolationResult = 0;
+      m_InterpolatedGeneration = generation;
+    }
+    m_ContourListMutex.Unlock();
+    return;
+  }
+
+  if (m_CurrentNumberOfReducedContours < m_InterpolateSurfaceFilter->GetNumberOfIndexedInputs())
+  {
+    m_NormalsFilter->Reset();
+    m_InterpolateSurfaceFilter->Reset();
+  }
+
+  for (unsigned int i = 0; i < m_CurrentNumberOfReducedContours; i++)
+  {
+    m_NormalsFilter->SetInput(i, m_ReduceFilter->GetOutput(i));
+    m_InterpolateSurfaceFilter->SetInput(i, m_NormalsFilter->GetOutput(i));
+  }
+
+  if (this->IsGenerationOutdated(generation))
+  {
     return;
   }
 
@@ -150,7 +259,15 @@ void mitk::SurfaceInterpolationController::Interpolate()
   //mitk::ProgressBar::GetInstance()->AddStepsToDo(8);
 
   // update the filter and get teh resulting distance-image
-  m_InterpolateSurfaceFilter->Update();
+  try
+  {
+    m_InterpolateSurfaceFilter->Update();
+  }
+  catch (itk::ProcessAborted&)
+  {
+    // new contours arrived in the meantime, keep the last result
+    return;
+  }
   Image::Pointer distanceImage = m_InterpolateSurfaceFilter->GetOutput();
 
   // create a surface from the distance-image
@@ -158,8 +275,7 @@ void mitk::SurfaceInterpolationController::Interpolate()
   imageToSurfaceFilter->SetInput( distanceImage );
   imageToSurfaceFilter->SetThreshold( 0 );
   imageToSurfaceFilter->Update();
-  m_InterpolationResult = imageToSurfaceFilter->GetOutput();
-
+  mitk::Surface::Pointer interpolationResult = imageToSurfaceFilter->GetOutput();
 
   vtkSmartPointer<vtkAppendPolyData> polyDataAppender = vtkSmartPointer<vtkAppendPolyData>::New();
   for (unsigned int i = 0; i < m_ReduceFilter->GetNumberOfOutputs(); i++)
@@ -167,7 +283,6 @@ void mitk::SurfaceInterpolationController::Interpolate()
     polyDataAppender->AddInput(m_ReduceFilter->GetOutput(i)->GetVtkPolyData());
   }
   polyDataAppender->Update();
-  m_Contours->SetVtkPolyData(polyDataAppender->GetOutput());
 
   //Last progress step
   /*
@@ -175,12 +290,24 @@ void mitk::SurfaceInterpolationController::Interpolate()
    */
   //mitk::ProgressBar::GetInstance()->Progress(8);
 
-  m_InterpolationResult->DisconnectPipeline();
+  interpolationResult->DisconnectPipeline();
+
+  m_ContourListMutex.Lock();
+  if (generation == m_ContourListGeneration)
+  {
+    m_InterpolationResult = interpolationResult;
+    m_Contours->SetVtkPolyData(polyDataAppender->GetOutput());
+    m_InterpolatedGeneration = generation;
+  }
+  m_ContourListMutex.Unlock();
 }
 
 mitk::Surface::Pointer mitk::SurfaceInterpolationController::GetInterpolationResult()
 {
-    return m_InterpolationResult;
+  m_ContourListMutex.Lock();
+  mitk::Surface::Pointer interpolationResult = m_InterpolationResult;
+  m_ContourListMutex.Unlock();
+  return interpolationResult;
 }
 
 mitk::Surface* mitk::SurfaceInterpolationController::GetContoursAsSurface()
@@ -195,23 +322,46 @@ void mitk::SurfaceInterpolationController::SetDataStorage(DataStorage::Pointer d
 
 void mitk::SurfaceInterpolationController::SetMinSpacing(double minSpacing)
 {
-  m_ReduceFilter->SetMinSpacing(minSpacing);
+  m_ContourListMutex.Lock();
+  if (minSpacing != m_MinSpacing)
+  {
+    m_MinSpacing = minSpacing;
+    this->ContoursChanged();
+  }
+  m_ContourListMutex.Unlock();
 }
 
 void mitk::SurfaceInterpolationController::SetMaxSpacing(double maxSpacing)
 {
-  m_ReduceFilter->SetMaxSpacing(maxSpacing);
-  m_NormalsFilter->SetMaxSpacing(maxSpacing);
+  m_ContourListMutex.Lock();
+  if (maxSpacing != m_MaxSpacing)
+  {
+    m_MaxSpacing = maxSpacing;
+    this->ContoursChanged();
+  }
+  m_ContourListMutex.Unlock();
 }
 
 void mitk::SurfaceInterpolationController::SetDistanceImageVolume(unsigned int distImgVolume)
 {
-  m_InterpolateSurfaceFilter->SetDistanceImageVolume(distImgVolume);
+  m_ContourListMutex.Lock();
+  if (distImgVolume != m_DistImageVolume)
+  {
+    m_DistImageVolume = distImgVolume;
+    this->ContoursChanged();
+  }
+  m_ContourListMutex.Unlock();
 }
 
 void mitk::SurfaceInterpolationController::SetSegmentationImage(Image* workingImage)
 {
-  m_NormalsFilter->SetSegmentationBinaryImage(workingImage);
+  m_ContourListMutex.Lock();
+  if (workingImage != m_WorkingImage)
+  {
+    m_WorkingImage = workingImage;
+    this->ContoursChanged();
+  }
+  m_ContourListMutex.Unlock();
 }
 
 mitk::Image* mitk::SurfaceInterpolationController::GetImage()
@@ -221,8 +371,22 @@ mitk::Image* mitk::SurfaceInterpolationController::GetImage()
 
 double mitk::SurfaceInterpolationController::EstimatePortionOfNeededMemory()
 {
-  double numberOfPointsAfterReduction = m_ReduceFilter->GetNumberOfPointsAfterReduction()*3;
-  double sizeOfPoints = pow(numberOfPointsAfterReduction,2)*sizeof(double);
+  // contours are reduced in Interpolate(), so this is an upper bound
+  double numberOfPoints (0);
+  m_ContourListMutex.Lock();
+  ContourListMap::iterator listIter = m_MapOfContourLists.find(m_SelectedSegmentation);
+  if (listIter != m_MapOfContourLists.end())
+  {
+    for (unsigned int i = 0; i < listIter->second.size(); i++)
+    {
+      numberOfPoints += listIter->second.at(i).contour->GetVtkPolyData()->GetNumberOfPoints();
+    }
+  }
+  m_ContourListMutex.Unlock();
+
+  // larger equation systems are not stored densely, see CreateDistanceImageFromSurfaceFilter
+  double numberOfCenters = std::min<double>(numberOfPoints*3, m_InterpolateSurfaceFilter->GetMaximumNumberOfDenseCenters());
+  double sizeOfPoints = pow(numberOfCenters,2)*sizeof(double);
   double totalMem = mitk::MemoryUtilities::GetTotalSizeOfPhysicalRam();
   double percentage = sizeOfPoints/totalMem;
   return percentage;
@@ -239,24 +403,24 @@ void mitk::SurfaceInterpolationController::SetCurrentSegmentationInterpolationLi
   if (segmentation == m_SelectedSegmentation)
     return;
 
-  m_ReduceFilter->Reset();
-  m_NormalsFilter->Reset();
-  m_InterpolateSurfaceFilter->Reset();
-
   if (segmentation == 0)
   {
+    m_ContourListMutex.Lock();
     m_SelectedSegmentation = 0;
+    this->ContoursChanged();
+    m_ContourListMutex.Unlock();
     return;
   }
-  ContourListMap::iterator it = m_MapOfContourLists.find(segmentation);
-
-  m_SelectedSegmentation = segmentation;
-
 
   itk::ImageBase<3>::Pointer itkImage;
-  AccessFixedDimensionByItk_1( m_SelectedSegmentation, GetImageBase, 3, itkImage );
-  m_InterpolateSurfaceFilter->SetReferenceImage( itkImage.GetPointer() );
+  AccessFixedDimensionByItk_1( segmentation, GetImageBase, 3, itkImage );
+
+  // the filters are set up by Interpolate()
+  m_ContourListMutex.Lock();
+  m_SelectedSegmentation = segmentation;
+  m_ReferenceImage = itkImage;
 
+  ContourListMap::iterator it = m_MapOfContourLists.find(segmentation);
   if (it == m_MapOfContourLists.end())
   {
     ContourPositionPairList newList;
@@ -269,23 +433,9 @@ void mitk::SurfaceInterpolationController::SetCurrentSegmentationInterpolationLi
     m_SegmentationObserverTags.insert( std::pair<mitk::Image*, unsigned long>( segmentation, segmentation->AddObserver( itk::DeleteEvent(), command ) ) );
 
   }
-  else
-  {
-    for (unsigned int i = 0; i < m_MapOfContourLists[m_SelectedSegmentation].size(); i++)
-    {
-      m_ReduceFilter->SetInput(i, m_MapOfContourLists[m_SelectedSegmentation].at(i).contour);
-    }
-
-    m_ReduceFilter->Update();
+  this->ContoursChanged();
+  m_ContourListMutex.Unlock();
 
-    m_CurrentNumberOfReducedContours = m_ReduceFilter->GetNumberOfOutputs();
-
-    for (unsigned int i = 0; i < m_CurrentNumberOfReducedContours; i++)
-    {
-      m_NormalsFilter->SetInput(i, m_ReduceFilter->GetOutput(i));
-      m_InterpolateSurfaceFilter->SetInput(i, m_NormalsFilter->GetOutput(i));
-    }
-  }
   Modified();
 }
 
@@ -293,12 +443,15 @@ void mitk::SurfaceInterpolationController::RemoveSegmentationFromContourList(mit
 {
   if (segmentation != 0)
   {
+    m_ContourListMutex.Lock();
     m_MapOfContourLists.erase(segmentation);
     if (m_SelectedSegmentation == segmentation)
     {
-      SetSegmentationImage(NULL);
+      m_WorkingImage = 0;
       m_SelectedSegmentation = 0;
+      this->ContoursChanged();
     }
+    m_ContourListMutex.Unlock();
   }
 }
 
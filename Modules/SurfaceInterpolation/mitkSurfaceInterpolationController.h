@@ -47,6 +47,8 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 #include "mitkProgressBar.h"
 
+#include "itkSimpleFastMutexLock.h"
+
 namespace mitk
 {
 
@@ -61,15 +63,27 @@ namespace mitk
     static SurfaceInterpolationController* GetInstance();
 
     /**
-     * Adds a new extracted contour to the list
+     * Adds a new extracted contour to the list.
+     * The contour is only stored, all processing is done by Interpolate(). A running interpolation is aborted,
+     * since its result would be outdated.
      */
     void AddNewContour(Surface::Pointer newContour, RestorePlanePositionOperation *op);
 
     /**
      * Interpolates the 3D surface from the given extracted contours
+     *
+     * This method may be called from a worker thread while contours are added and parameters are changed.
+     * It works on a copy of the current contour list. If the contours change while it is running, the
+     * interpolation is aborted and the previous result is kept, so the caller should just interpolate again.
+     * Stages whose input did not change (e.g. the reduced contours if only the spacing changed) are not recomputed.
      */
     void Interpolate ();
 
+    /**
+     * Whether the contours or parameters changed since the last successful Interpolate()
+     */
+    bool IsInterpolationOutdated();
+
     mitk::Surface::Pointer GetInterpolationResult();
 
     /**
@@ -132,6 +146,12 @@ namespace mitk
 
    void OnSegmentationDeleted(const itk::Object *caller, const itk::EventObject &event);
 
+   /// Marks the current interpolation as outdated and aborts a running distance image calculation, m_ContourListMutex must be locked
+   void ContoursChanged();
+
+   /// Whether the contours or parameters changed since Interpolate() took its copy of them
+   bool IsGenerationOutdated(unsigned long generation);
+
    struct ContourPositionPair {
      Surface::Pointer contour;
      RestorePlanePositionOperation* position;
@@ -149,7 +169,8 @@ namespace mitk
     double m_MinSpacing;
     double m_MaxSpacing;
 
-    const Image* m_WorkingImage;
+    Image* m_WorkingImage;
+    itk::ImageBase<3>::Pointer m_ReferenceImage;
 
     Surface::Pointer m_Contours;
 
@@ -168,6 +189,13 @@ namespace mitk
     mitk::Image* m_SelectedSegmentation;
 
     std::map<mitk::Image*, unsigned long> m_SegmentationObserverTags;
+
+    // guards the contour lists, the parameters above and the interpolation result,
+    // the filters are only used by Interpolate()
+    itk::SimpleFastMutexLock m_ContourListMutex;
+    // incremented on each change of contours or parameters
+    unsigned long m_ContourListGeneration;
+    unsigned long m_InterpolatedGeneration;
  };
 }
 #endif
@@ -144,7 +144,9 @@ ZipStreamBuf::ZipStreamBuf(std::ostream& ostr, ZipLocalFileHeader& fileEntry, bo
 		}
 		else if (fileEntry.getCompressionMethod() == ZipCommon::CM_STORE)
 		{
-			_ptrOBuf = &ostr;
+			// _ptrOBuf owns its stream, and close() needs _ptrOHelper to count the written bytes
+			_ptrOHelper = new PartialOutputStream(*_pOstr, 0, 0, false);
+			_ptrOBuf = new PartialOutputStream(*_ptrOHelper, 0, 0, false);
 		}
 		else
 		{
@@ -16,54 +16,124 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 #include <list>
 
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
 #include "mbilog.h"
 
 static std::list<mbilog::BackendBase*> backends;
 
-
 namespace mbilog {
 static const std::string NA_STRING = "n/a";
+
+/** \brief Recursive lock for the list of backends.
+  *
+  * mbilog does not depend on any toolkit, so the platform mutex is used directly. It has to be recursive
+  * because backends may emit messages themselves while processing one.
+  */
+class BackendsLock
+{
+  public:
+
+    BackendsLock()
+    {
+#ifdef _WIN32
+      InitializeCriticalSection(&m_Section);
+#else
+      pthread_mutexattr_t attributes;
+      pthread_mutexattr_init(&attributes);
+      pthread_mutexattr_settype(&attributes, PTHREAD_MUTEX_RECURSIVE);
+      pthread_mutex_init(&m_Mutex, &attributes);
+      pthread_mutexattr_destroy(&attributes);
+#endif
+    }
+
+    void Lock()
+    {
+#ifdef _WIN32
+      EnterCriticalSection(&m_Section);
+#else
+      pthread_mutex_lock(&m_Mutex);
+#endif
+    }
+
+    void Unlock()
+    {
+#ifdef _WIN32
+      LeaveCriticalSection(&m_Section);
+#else
+      pthread_mutex_unlock(&m_Mutex);
+#endif
+    }
+
+  private:
+
+#ifdef _WIN32
+    CRITICAL_SECTION m_Section;
+#else
+    pthread_mutex_t m_Mutex;
+#endif
+};
+
+// never destroyed, messages may be emitted during static destruction
+static BackendsLock& GetBackendsLock()
+{
+  static BackendsLock* lock = new BackendsLock();
+  return *lock;
+}
+
+// created if there is no backend registered (so we have an output anyway)
+static mbilog::BackendCout* dummyBackend = NULL;
 }
 
 void mbilog::RegisterBackend(mbilog::BackendBase* backend)
 {
+  GetBackendsLock().Lock();
   backends.push_back(backend);
+
+  //if there was added another backend remove the dummy backend and delete it
+  if((dummyBackend != NULL) && (backend != dummyBackend))
+  {
+    backends.remove(dummyBackend);
+    delete dummyBackend;
+    dummyBackend = NULL;
+  }
+  GetBackendsLock().Unlock();
 }
 
 void mbilog::UnregisterBackend(mbilog::BackendBase* backend)
 {
+  GetBackendsLock().Lock();
   backends.remove(backend);
+  GetBackendsLock().Unlock();
 }
 
 void mbilog::DistributeToBackends(mbilog::LogMessage &l)
 {
-  //Crop Message
+  //Crop Message (in place, without creating a new string)
   {
     std::string::size_type i = l.message.find_last_not_of(" \t\f\v\n\r");
-    l.message = (i != std::string::npos) ? l.message.substr(0, i+1) : "";
+    l.message.erase( (i != std::string::npos) ? i+1 : 0 );
   }
 
-  //create dummy backend if there is no backend registered (so we have an output anyway)
-  static mbilog::BackendCout* dummyBackend = NULL;
+  // backends only do little work here (the mitk backend just queues the message),
+  // so the lock is held while the message is distributed
+  GetBackendsLock().Lock();
 
   if(backends.empty() && (dummyBackend == NULL))
   {
     dummyBackend = new mbilog::BackendCout();
     dummyBackend->SetFull(false);
-    RegisterBackend(dummyBackend);
-  }
-  else if((backends.size()>1) && (dummyBackend != NULL))
-  {
-    //if there was added another backend remove the dummy backend and delete it
-    UnregisterBackend(dummyBackend);
-    delete dummyBackend;
-    dummyBackend = NULL;
+    backends.push_back(dummyBackend);
   }
 
   //iterate through all registered images and call the ProcessMessage() methods of the backends
   std::list<mbilog::BackendBase*>::iterator i;
   for(i = backends.begin(); i != backends.end(); i++)
     (*i)->ProcessMessage(l);
-}
-
 
+  GetBackendsLock().Unlock();
+}
@@ -71,6 +71,8 @@ namespace mbilog {
                           , msg(LogMessage(level,filePath,lineNumber,functionName))
                           , ss(std::stringstream::out)
       {
+        // messages are always formatted with the "C" locale, set once instead of for every operator<<
+        ss.imbue(std::locale::classic());
       }
 
       /** \brief The message which is stored in the member ss is written to the backend. */
@@ -88,15 +90,7 @@ namespace mbilog {
       template <class T> inline PseudoStream& operator<<(const T& data)
       {
         if(!disabled)
-        {
-          std::locale C("C");
-          std::locale originalLocale = ss.getloc();
-          ss.imbue(C);
-
           ss << data;
-
-          ss.imbue( originalLocale );
-        }
         return *this;
       }
 
@@ -104,15 +98,7 @@ namespace mbilog {
       template <class T> inline PseudoStream& operator<<(T& data)
       {
         if(!disabled)
-        {
-          std::locale C("C");
-          std::locale originalLocale = ss.getloc();
-          ss.imbue(C);
-
           ss << data;
-
-          ss.imbue( originalLocale );
-        }
         return *this;
       }
 
@@ -120,15 +106,7 @@ namespace mbilog {
       inline PseudoStream& operator<<(std::ostream& (*func)(std::ostream&))
       {
         if(!disabled)
-        {
-          std::locale C("C");
-          std::locale originalLocale = ss.getloc();
-          ss.imbue(C);
-
           ss << func;
-
-          ss.imbue( originalLocale );
-        }
         return *this;
       }
 
@@ -225,6 +203,7 @@ namespace mbilog {
 #ifdef MBILOG_ENABLE_DEBUG
 #define MBI_DEBUG mbilog::PseudoStream(mbilog::Debug,__FILE__,__LINE__,__FUNCTION__)
 #else
+// the operands of all operator<< belong to the unevaluated branch, so disabled debug messages cost nothing
 #define MBI_DEBUG true ? mbilog::NullStream() : mbilog::NullStream() //this is magic by markus
 #endif
 